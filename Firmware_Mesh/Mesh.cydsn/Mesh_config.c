@@ -14,7 +14,22 @@
 *******************************************************************************/
 #include "main.h"
 
-volatile bool flag = false;
+#define KEY_JOB_QUEUE_SIZE              (4u)
+
+typedef enum
+{
+    KEY_JOB_NETWORK_KEY,
+    KEY_JOB_APPLICATION_KEY
+} KEY_JOB_TYPE_T;
+
+/* One key derivation, run by the AES-CMAC state machine of the security module */
+typedef struct
+{
+    KEY_JOB_TYPE_T type;
+    uint8 index;                        /* Mesh ID, or application key index */
+    const uint8 * key;
+    CYMESH_SECURITY_CALLBACK callback;  /* Called with the CMAC once done, can be NULL */
+} KEY_JOB_T;
 
 uint8 networkKey[16] = 
 {0x89, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x20, 0x30, 0x40, 0x50, 0x60, 0x70, 0x80, 0x96};
@@ -26,26 +41,176 @@ uint8 deviceKey[16] =
 {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x12};
 
 uint32 ivIndex = 0x00000005;
-/* Security beacon CMAC calculations */
-uint8 beaconCmac[4];
-extern uint8 cyMesh_ConfigurationBeaconCalculatedAuthValue[4];
+
+/* Pending key derivations, the first one is running once isKeyJobRunning is set */
+static KEY_JOB_T keyJobQueue[KEY_JOB_QUEUE_SIZE];
+static uint8 keyJobHead = 0;
+static uint8 keyJobCount = 0;
+static bool isKeyJobRunning = false;
+
+/* Jobs queued by DefineAppInfo() and DefineNetInfo() that are not done yet */
+static uint8 configJobsPending = 0;
+
+/******************************************************************************
+* Function Name: KeyJobDone
+*******************************************************************************
+* 
+*  Security module callback for the running key derivation. Runs in the
+*  context of CyMesh_ProcessEvents().
+* 
+*  \param cmac: Result of the last AES-CMAC of the derivation
+*
+*  \return None
+*  
+******************************************************************************/
+static void KeyJobDone(uint8 * cmac)
+{
+    CYMESH_SECURITY_CALLBACK callback = keyJobQueue[keyJobHead].callback;
+    
+    keyJobHead = (keyJobHead + 1u) % KEY_JOB_QUEUE_SIZE;
+    keyJobCount--;
+    isKeyJobRunning = false;
+    
+    if(callback != NULL)
+    {
+        callback(cmac);
+    }
+}
+
+/******************************************************************************
+* Function Name: KeyJobAdd
+*******************************************************************************
+* 
+*  Queues a key derivation. Jobs run one after the other from KeyJobProcess().
+* 
+*  \param 
+*	type: Which key to derive
+*   index: Mesh ID, or application key index
+*   key: 16 byte key (MSB first). The key must stay valid until the job is
+*        done.
+*   callback: Called once the job is done, can be NULL
+*
+*  \return bool: false if the queue is full
+*  
+******************************************************************************/
+static bool KeyJobAdd(KEY_JOB_TYPE_T type, uint8 index, const uint8 * key, CYMESH_SECURITY_CALLBACK callback)
+{
+    KEY_JOB_T * job;
+    
+    if(keyJobCount >= KEY_JOB_QUEUE_SIZE)
+    {
+        return false;
+    }
+    
+    job = &keyJobQueue[(keyJobHead + keyJobCount) % KEY_JOB_QUEUE_SIZE];
+    job->type = type;
+    job->index = index;
+    job->key = key;
+    job->callback = callback;
+    keyJobCount++;
+    
+    return true;
+}
+
+/******************************************************************************
+* Function Name: KeyJobIsPending
+*******************************************************************************
+* 
+*  Tells if key derivations are queued or running. The AES-CMAC state machine
+*  only advances in CyMesh_ProcessEvents(), so the main loop should not sleep
+*  meanwhile.
+* 
+*  \param None
+*
+*  \return bool: true if a key derivation is queued or running
+*  
+******************************************************************************/
+bool KeyJobIsPending(void)
+{
+    return (keyJobCount != 0u);
+}
 
 /******************************************************************************
-* Function Name: MyCallback
+* Function Name: KeyJobProcess
 *******************************************************************************
 * 
-*  Event handler for storing the CMAC from external security beaocn received
+*  Starts the next queued key derivation once the previous one is done. The
+*  derivation itself runs in CyMesh_ProcessEvents(). Call from the main loop,
+*  after CyMesh_ProcessEvents(), so that the next job starts on the same 
+*  iteration the previous one completed.
 * 
-*  \param cmac: pointer to the location of CMAC in received packet
+*  \param None
 *
 *  \return None
 *  
 ******************************************************************************/
-static void MyCallback(uint8 * cmac)
+void KeyJobProcess(void)
 {
-    memcpy(beaconCmac, &cmac[12], 4);
+    const KEY_JOB_T * job = &keyJobQueue[keyJobHead];
+    CYMESH_API_RETURN_T result = CYMESH_ERROR_OK;
+    
+    if((isKeyJobRunning == true) || (keyJobCount == 0u))
+    {
+        return;
+    }
+    
+    /* Set first: the security module may call back before returning */
+    isKeyJobRunning = true;
+    
+    switch(job->type)
+    {
+        case KEY_JOB_NETWORK_KEY:
+            result = CyMesh_SecuritySetNetworkKey(job->index, job->key, KeyJobDone);
+            break;
+        
+        case KEY_JOB_APPLICATION_KEY:
+            result = CyMesh_SecuritySetApplicationKey(job->index, 0, job->key, KeyJobDone);
+            break;
+        
+        default:
+            break;
+    }
     
-    flag = true;
+    if(result != CYMESH_ERROR_OK)
+    {
+        /* AES-CMAC busy with a derivation of the stack itself: retry on the
+         * next iteration */
+        isKeyJobRunning = false;
+    }
+}
+
+/* Marks the configuration valid once the last boot time derivation is done */
+static void ConfigJobDone(void)
+{
+    configJobsPending--;
+    
+    if(configJobsPending == 0u)
+    {
+        /* Suppots one valid Mesh configuration */
+        cyMesh_ConfigInfoRam.isConfigurationValid = true;
+        DBG_LOG1("Mesh configuration valid after %lu ms\r\n", CyMesh_TimerGetTimestamp());
+    }
+}
+
+static void ApplicationKeyDone(uint8 * cmac)
+{
+    (void)cmac;
+    ConfigJobDone();
+}
+
+static void NetworkKeyDone(uint8 * cmac)
+{
+    (void)cmac;
+    
+    /* Network packets can be decrypted and relayed from now on */
+    DBG_LOG1("Network key ready after %lu ms\r\n", CyMesh_TimerGetTimestamp());
+    
+    CyMesh_SecuritySetIVindex(0, ivIndex);
+    
+    /* The beacon manager calculates the authentication values from the SM
+     * timer, see CyMesh_BeaconUpdate() */
+    CyMesh_BeaconStart();
+    ConfigJobDone();
 }
 
 /******************************************************************************
@@ -92,7 +257,8 @@ void DefineNodeinfo(void)
 *******************************************************************************
 * 
 *  Sets the Application level Information for this device, including setting 
-* of the application keys
+* of the application keys. The key derivation is queued; it runs from the main
+* loop after the network key.
 * 
 *  \param None
 *
@@ -103,13 +269,9 @@ void DefineAppInfo(void)
 {
 	if(cyMesh_ConfigInfoRam.isConfigurationValid != true)
 	{        
-	    flag = false;
-	    CyMesh_SecuritySetApplicationKey(0, 0, applicationKey, MyCallback);
-	    
-	    while(flag != true)
+	    if(KeyJobAdd(KEY_JOB_APPLICATION_KEY, 0, applicationKey, ApplicationKeyDone) == true)
 	    {
-	        CyBle_ProcessEvents();
-	        CyMesh_SecurityAesCmacProcess();
+	        configJobsPending++;
 	    }
 	}
 }
@@ -118,8 +280,9 @@ void DefineAppInfo(void)
 * Function Name: DefineNetInfo
 *******************************************************************************
 * 
-*  Sets the network level Information such as network keys, IV index and Beacon
-* CMACs
+*  Sets the network level Information such as network keys and IV index. The
+* key derivations are queued and run from the main loop, see KeyJobProcess().
+* The configuration becomes valid once all are done.
 * 
 *  \param None
 *
@@ -135,29 +298,12 @@ void DefineNetInfo(void)
 
 		cyMesh_ConfigInfoRam.bearerRole = CYMESH_ROLE_RELAY;
 		
-		flag = false;
-	    
-	    CyMesh_SecuritySetNetworkKey(0, networkKey, MyCallback);
-	    
-	    while(flag != true)
+		/* The IV index is set and the beacon manager started once the network
+		 * key is ready */
+	    if(KeyJobAdd(KEY_JOB_NETWORK_KEY, 0, networkKey, NetworkKeyDone) == true)
 	    {
-	        CyBle_ProcessEvents();
-	        CyMesh_SecurityAesCmacProcess();
+	        configJobsPending++;
 	    }
-
-	    flag = false;
-	    CyMesh_SecuritySetIVindex(0, ivIndex);
-	    CyMesh_SecurityCalculateBeaconAuthValue(0, 0, ivIndex, MyCallback);
-	    
-	    while(flag != true)
-	    {
-	        CyBle_ProcessEvents();
-	        CyMesh_SecurityAesCmacProcess();
-	    }
-	    memcpy(cyMesh_ConfigurationBeaconCalculatedAuthValue, beaconCmac, 4);
-		
-		/* Suppots one valid Mesh configuration */
-	    cyMesh_ConfigInfoRam.isConfigurationValid = true;
 	}
 }
 /* [] END OF FILE */
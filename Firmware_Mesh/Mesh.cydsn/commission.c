@@ -0,0 +1,329 @@
+/***************************************************************************//**
+* \file commission.c
+* \version 1.0
+*
+* \brief
+*  Configuration client of the gateway node for bulk commissioning.
+*
+*  Every request from the host names a target node and one configuration model
+*  operation. The gateway sends it with the CyMesh_ConfigurationModel*() client
+*  API and the device key shared by all nodes (see DefineNetInfo()), and writes
+*  the outcome as a DBG_FRAME_COMMISSION frame. Up to COMMISSION_WINDOW
+*  operations to different nodes are in flight at once, so the mesh round
+*  trips overlap; Tools/commission.py keeps the window full.
+*
+*  The status events of the library do not say which node sent them. The
+*  callback of the configuration model is wrapped to note the source address
+*  of every message it handles, which the event handler then matches with the
+*  operation in flight to that node.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include "main.h"
+#include "CyMesh_ConfigurationModel.h"
+
+#define COMMISSION_SLOT_FREE            (0u)
+
+typedef struct
+{
+    uint32 startTime;
+    uint16 target;
+    uint8 token;
+    uint8 operation;                    /* COMMISSION_OP_T, COMMISSION_SLOT_FREE if unused */
+} COMMISSION_SLOT_T;
+
+static COMMISSION_SLOT_T commissionSlots[COMMISSION_WINDOW];
+
+/* Library callback of the configuration model, and the source of the last
+ * message it was given */
+static CYMESH_CALLBACK_T configModelCallback = NULL;
+static uint16 commissionStatusSource;
+
+
+static CYMESH_MODEL_T * CommissionConfigModel(void)
+{
+    return &cyMesh_ConfigInfoRam.deviceInfo.components[CYMESH_MODEL_CONFIGURATION_COMPONENT_INDEX].
+                model[CYMESH_MODEL_CONFIGURATION_MODEL_INDEX];
+}
+
+
+static CYMESH_API_RETURN_T CommissionModelCallback(uint32 event, void * eventParam)
+{
+    commissionStatusSource = ((const CYMESH_APPLICATION_PKT_T *)eventParam)->srcAddress;
+
+    return configModelCallback(event, eventParam);
+}
+
+
+/* CyMesh_ConfigurationModelStart() sets the callback, so check before every
+ * request */
+static void CommissionWrapModelCallback(void)
+{
+    CYMESH_MODEL_T * model = CommissionConfigModel();
+
+    if(model->callbackPointer != CommissionModelCallback)
+    {
+        configModelCallback = model->callbackPointer;
+        model->callbackPointer = CommissionModelCallback;
+    }
+}
+
+
+static void CommissionReport(uint8 token, uint16 target, COMMISSION_RESULT_T result, uint8 value)
+{
+    uint8 frame[COMMISSION_FRAME_LENGTH];
+
+    frame[0] = token;
+    frame[1] = target & 0x00FF;
+    frame[2] = (target >> 8) & 0x00FF;
+    frame[3] = result;
+    frame[4] = value;
+
+    DebugWriteFrame(DBG_FRAME_COMMISSION, frame, sizeof(frame));
+}
+
+
+/* Report the operation in flight to the target and free its slot. Returns
+ * false if there is none, or if it is another operation. */
+static bool CommissionComplete(uint16 target, uint8 operation, COMMISSION_RESULT_T result, uint8 value)
+{
+    uint8 i;
+
+    for(i = 0; i < COMMISSION_WINDOW; i++)
+    {
+        COMMISSION_SLOT_T * slot = &commissionSlots[i];
+
+        if((slot->operation != COMMISSION_SLOT_FREE) && (slot->target == target) &&
+           ((operation == COMMISSION_SLOT_FREE) || (slot->operation == operation)))
+        {
+            CommissionReport(slot->token, target, result, value);
+            slot->operation = COMMISSION_SLOT_FREE;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+static CYMESH_API_RETURN_T CommissionSend(uint8 operation, const uint8 * parameter, uint8 length)
+{
+    switch(operation)
+    {
+        case COMMISSION_OP_RELAY_SET:
+            if(length == 1u)
+            {
+                return CyMesh_ConfigurationModelSetRelay(parameter[0] != 0u);
+            }
+            break;
+
+        case COMMISSION_OP_DEFAULT_TTL_SET:
+            if(length == 1u)
+            {
+                return CyMesh_ConfigurationModelSetDefaultTtl(parameter[0]);
+            }
+            break;
+
+        case COMMISSION_OP_APPKEY_ADD:
+            if(length == 17u)
+            {
+                return CyMesh_ConfigurationModelAddAppKey(parameter[0], &parameter[1]);
+            }
+            break;
+
+        case COMMISSION_OP_PUBLICATION_SET:
+            if(length == 6u)
+            {
+                return CyMesh_ConfigurationModelSetPublication(parameter[0], parameter[1],
+                                                               (parameter[3] << 8) | parameter[2],
+                                                               parameter[4], parameter[5]);
+            }
+            break;
+
+        case COMMISSION_OP_SUBSCRIPTION_ADD:
+            if(length == 4u)
+            {
+                return CyMesh_ConfigurationModelAddSubscription(parameter[0], parameter[1],
+                                                                (parameter[3] << 8) | parameter[2]);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return CYMESH_ERROR_INVALID_PARAM;
+}
+
+
+/******************************************************************************
+* Function Name: CommissionRequest
+*******************************************************************************
+*
+*  Sends one operation from the host: Token (1) + Target (2) + Operation (1) +
+*  Parameters, see COMMISSION_OP_T. The result is reported with the token,
+*  right away if the operation could not be sent.
+*
+*  \param
+*	request: Request from the UART
+*   length: Request length
+*
+*  \return None
+*
+******************************************************************************/
+void CommissionRequest(const uint8 * request, uint8 length)
+{
+    COMMISSION_SLOT_T * freeSlot = NULL;
+    CYMESH_API_RETURN_T result;
+    uint16 target;
+    uint8 i;
+
+    if(length < COMMISSION_REQUEST_HEADER_LENGTH)
+    {
+        return;
+    }
+
+    target = (request[2] << 8) | request[1];
+
+    for(i = 0; i < COMMISSION_WINDOW; i++)
+    {
+        if(commissionSlots[i].operation == COMMISSION_SLOT_FREE)
+        {
+            freeSlot = (freeSlot == NULL) ? &commissionSlots[i] : freeSlot;
+        }
+        else if(commissionSlots[i].target == target)
+        {
+            /* A status could not be matched to one of two operations */
+            freeSlot = NULL;
+            break;
+        }
+    }
+
+    if(freeSlot == NULL)
+    {
+        CommissionReport(request[0], target, COMMISSION_RESULT_BUSY, 0u);
+        return;
+    }
+
+    CommissionWrapModelCallback();
+    CyMesh_ConfigurationModelSetTargetDevice(target, cyMesh_ConfigInfoRam.deviceInfo.deviceKey);
+
+    result = CommissionSend(request[3], &request[COMMISSION_REQUEST_HEADER_LENGTH],
+                            length - COMMISSION_REQUEST_HEADER_LENGTH);
+    if(result != CYMESH_ERROR_OK)
+    {
+        CommissionReport(request[0], target, COMMISSION_RESULT_REJECTED, (uint8)result);
+        return;
+    }
+
+    freeSlot->token = request[0];
+    freeSlot->target = target;
+    freeSlot->operation = request[3];
+    freeSlot->startTime = CyMesh_TimerGetTimestamp();
+}
+
+
+/******************************************************************************
+* Function Name: CommissionHandleEvent
+*******************************************************************************
+*
+*  Completes the operation in flight to the node that sent a configuration
+*  client status, or whose reliable message timed out.
+*
+*  \param
+*	event: Mesh event
+*   eventParam: Event parameter
+*
+*  \return None
+*
+******************************************************************************/
+void CommissionHandleEvent(uint32 event, const void * eventParam)
+{
+    uint16 source = commissionStatusSource;
+
+    switch(event)
+    {
+        case CYMESH_EVT_CONFIG_RELAY_STATUS:
+            (void)CommissionComplete(source, COMMISSION_OP_RELAY_SET, COMMISSION_RESULT_OK,
+                                     *(const uint8 *)eventParam);
+            break;
+
+        case CYMESH_EVT_CONFIG_DEFAULT_TTL_STATUS:
+            (void)CommissionComplete(source, COMMISSION_OP_DEFAULT_TTL_SET, COMMISSION_RESULT_OK,
+                                     *(const uint8 *)eventParam);
+            break;
+
+        case CYMESH_EVT_APPKEY_STATUS_OK:
+            (void)CommissionComplete(source, COMMISSION_OP_APPKEY_ADD, COMMISSION_RESULT_OK,
+                                     *(const uint8 *)eventParam);
+            break;
+
+        case CYMESH_EVT_APPKEY_STATUS_ERROR:
+            (void)CommissionComplete(source, COMMISSION_OP_APPKEY_ADD, COMMISSION_RESULT_STATUS_ERROR,
+                                     (uint8)*(const CYMESH_STATUS_CODE_T *)eventParam);
+            break;
+
+        case CYMESH_EVT_MODEL_PUBLICATION_STATUS_OK:
+            (void)CommissionComplete(source, COMMISSION_OP_PUBLICATION_SET, COMMISSION_RESULT_OK, 0u);
+            break;
+
+        case CYMESH_EVT_MODEL_PUBLICATION_STATUS_ERROR:
+            (void)CommissionComplete(source, COMMISSION_OP_PUBLICATION_SET, COMMISSION_RESULT_STATUS_ERROR,
+                                     (uint8)*(const CYMESH_STATUS_CODE_T *)eventParam);
+            break;
+
+        case CYMESH_EVT_MODEL_SUBSCRIPTION_STATUS_OK:
+            (void)CommissionComplete(source, COMMISSION_OP_SUBSCRIPTION_ADD, COMMISSION_RESULT_OK, 0u);
+            break;
+
+        case CYMESH_EVT_MODEL_SUBSCRIPTION_STATUS_ERROR:
+            (void)CommissionComplete(source, COMMISSION_OP_SUBSCRIPTION_ADD, COMMISSION_RESULT_STATUS_ERROR,
+                                     (uint8)*(const CYMESH_STATUS_CODE_T *)eventParam);
+            break;
+
+        case CYMESH_EVT_RELIABLE_MESSAGE_TIMEOUT:
+            (void)CommissionComplete(((const CYMESH_APP_RELIABLE_MSG_TIMEOUT_PARAM_T *)eventParam)->dstAddress,
+                                     COMMISSION_SLOT_FREE, COMMISSION_RESULT_TIMEOUT, 0u);
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+/******************************************************************************
+* Function Name: CommissionTick
+*******************************************************************************
+*
+*  Times out operations that got neither a status nor a reliable message
+*  timeout event. Called once per second.
+*
+*  \param None
+*
+*  \return None
+*
+******************************************************************************/
+void CommissionTick(void)
+{
+    uint32 now = CyMesh_TimerGetTimestamp();
+    uint8 i;
+
+    for(i = 0; i < COMMISSION_WINDOW; i++)
+    {
+        COMMISSION_SLOT_T * slot = &commissionSlots[i];
+
+        if((slot->operation != COMMISSION_SLOT_FREE) && ((uint32)(now - slot->startTime) >= COMMISSION_TIMEOUT_MS))
+        {
+            CommissionReport(slot->token, slot->target, COMMISSION_RESULT_TIMEOUT, 0u);
+            slot->operation = COMMISSION_SLOT_FREE;
+        }
+    }
+}
+
+/* [] END OF FILE */
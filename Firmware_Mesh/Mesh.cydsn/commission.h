@@ -0,0 +1,67 @@
+/***************************************************************************//**
+* \file commission.h
+* \version 1.0
+*
+* \brief
+*  Configuration client of the gateway node for bulk commissioning. The host
+*  sends configuration model operations for other nodes over the UART, and
+*  the gateway keeps up to COMMISSION_WINDOW of them in flight at once.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#if !defined(COMMISSION_H)
+#define COMMISSION_H
+
+#include <project.h>
+#include <stdbool.h>
+
+/******************************Pre-processor Directives**********************************************/
+/* Operations in flight, at most one per target node. The library queues up to
+ * CYMESH_TX_MESSAGE_Q_SIZE reliable messages, the rest is left to the models. */
+#define COMMISSION_WINDOW               (4u)
+
+/* The library retries a reliable message CYMESH_TX_MESSAGE_Q_RETRY_COUNT times,
+ * CYMESH_TX_MESSAGE_Q_DEFAULT_TIMEOUT seconds apart. An operation still in
+ * flight after this is reported as timed out. */
+#define COMMISSION_TIMEOUT_MS           (20000u)
+
+/* Request: Token (1) + Target (2) + Operation (1) + Parameters */
+#define COMMISSION_REQUEST_HEADER_LENGTH    (4u)
+#define COMMISSION_REQUEST_MAX_LENGTH   (COMMISSION_REQUEST_HEADER_LENGTH + 17u)
+
+/* Result frame: Token (1) + Target (2) + Result (1) + Value (1) */
+#define COMMISSION_FRAME_LENGTH         (5u)
+
+/**************************************Enums**************************************************/
+/* Operations, with their parameters. Keep Tools/commission.py in sync. */
+typedef enum
+{
+    COMMISSION_OP_RELAY_SET = 1,        /* Relay (1) */
+    COMMISSION_OP_DEFAULT_TTL_SET,      /* TTL (1) */
+    COMMISSION_OP_APPKEY_ADD,           /* NetKey index (1) + AppKey (16, MSB first) */
+    COMMISSION_OP_PUBLICATION_SET,      /* Component (1) + Model (1) + Address (2) + AppKey index (1) + TTL (1) */
+    COMMISSION_OP_SUBSCRIPTION_ADD      /* Component (1) + Model (1) + Address (2) */
+} COMMISSION_OP_T;
+
+/* Result of an operation, one DBG_FRAME_COMMISSION frame each */
+typedef enum
+{
+    COMMISSION_RESULT_OK,               /* Status received. Value: relay state, TTL or AppKey index */
+    COMMISSION_RESULT_STATUS_ERROR,     /* Error status received. Value: CYMESH_STATUS_CODE_T */
+    COMMISSION_RESULT_TIMEOUT,          /* No status */
+    COMMISSION_RESULT_BUSY,             /* Window full, or the target has an operation in flight */
+    COMMISSION_RESULT_REJECTED          /* Bad request, or not sent. Value: CYMESH_API_RETURN_T */
+} COMMISSION_RESULT_T;
+
+/*****************************Function Declarations**************************************/
+void CommissionRequest(const uint8 * request, uint8 length);
+void CommissionHandleEvent(uint32 event, const void * eventParam);
+void CommissionTick(void);
+
+#endif
+/* [] END OF FILE */
@@ -14,6 +14,10 @@
 *******************************************************************************/
 #include "debug.h"
 
+#if defined(CYMESH_DEBUG_ENABLED) || defined(CYMESH_DEBUG_ENABLED_ACK_COUNT)
+static void DebugLogFinishRecord(void);
+#endif
+
 #ifdef CYMESH_DEBUG_ENABLED
 
 #if defined(__ARMCC_VERSION)
@@ -42,6 +46,7 @@ int fputc(int ch, FILE *file)
     switch( file->handle )
     {
         case STDOUT_HANDLE:
+            DebugLogFinishRecord();
             UART_UartPutChar(ch);
             ret = ch ;
             break ;
@@ -74,6 +79,8 @@ size_t __write(int handle, const unsigned char * buffer, size_t size)
         return (0);
     }
 
+    DebugLogFinishRecord();
+
     for (/* Empty */; size != 0; --size)
     {
         UART_UartPutChar(*buffer++);
@@ -90,6 +97,7 @@ int _write(int file, char *ptr, int len)
 {
     int i;
     file = file;
+    DebugLogFinishRecord();
     for (i = 0; i < len; i++)
     {
         UART_UartPutChar(*ptr++);
@@ -148,6 +156,7 @@ void Set32ByPtr(uint8 ptr[], uint32 value)
 	    switch( file->handle )
 	    {
 	        case STDOUT_HANDLE:
+	            DebugLogFinishRecord();
 	            UART_UartPutChar(ch);
 	            ret = ch ;
 	            break ;
@@ -180,6 +189,8 @@ void Set32ByPtr(uint8 ptr[], uint32 value)
 	        return (0);
 	    }
 
+	    DebugLogFinishRecord();
+
 	    for (/* Empty */; size != 0; --size)
 	    {
 	        UART_UartPutChar(*buffer++);
@@ -196,6 +207,7 @@ void Set32ByPtr(uint8 ptr[], uint32 value)
 	{
 	    int i;
 	    file = file;
+	    DebugLogFinishRecord();
 	    for (i = 0; i < len; i++)
 	    {
 	        UART_UartPutChar(*ptr++);
@@ -228,4 +240,182 @@ void Set32ByPtr(uint8 ptr[], uint32 value)
 	#endif
 #endif /* #ifdef CYMESH_DEBUG_ENABLED */
 
+#if defined(CYMESH_DEBUG_ENABLED) || defined(CYMESH_DEBUG_ENABLED_ACK_COUNT)
+
+/* Size of an encoded record: sync, argument count, format address, arguments */
+#define DBG_LOG_FRAME_MAX_SIZE          (6u + (4u * DBG_LOG_MAX_ARGS))
+
+typedef struct
+{
+    const char * format;
+    uint32 args[DBG_LOG_MAX_ARGS];
+    uint8 argCount;
+} DBG_LOG_RECORD_T;
+
+static DBG_LOG_RECORD_T logRing[DBG_LOG_RING_SIZE];
+static volatile uint8 logHead = 0u;     /* Written by producers only */
+static volatile uint8 logTail = 0u;     /* Written by DebugLogFlush() only */
+static volatile uint32 logDropped = 0u;
+
+/* Record currently being pushed into the UART TX FIFO */
+static uint8 logFrame[DBG_LOG_FRAME_MAX_SIZE];
+static uint8 logFrameLength = 0u;
+static uint8 logFramePosition = 0u;
+
+
+/******************************************************************************
+* Function Name: DebugLogWrite
+*******************************************************************************
+* 
+*  Queues one log record. The format string is not touched: only its address
+*  and the raw arguments are stored. The Cortex-M0 has no exclusive access
+*  instructions, so the slot is claimed and filled with interrupts masked for
+*  a handful of cycles. When the ring is full the record is counted as dropped.
+* 
+*  \param 
+*	format: Format string. Must be a string literal (it is decoded from the ELF)
+*   argCount: Number of valid arguments (0 - DBG_LOG_MAX_ARGS)
+*   arg0 - arg3: Raw argument values
+*
+*  \return None
+*  
+******************************************************************************/
+void DebugLogWrite(const char * format, uint8 argCount, uint32 arg0, uint32 arg1, uint32 arg2, uint32 arg3)
+{
+    uint8 interruptState = CyEnterCriticalSection();
+    uint8 head = logHead;
+    
+    if((uint8)(head - logTail) < DBG_LOG_RING_SIZE)
+    {
+        DBG_LOG_RECORD_T * record = &logRing[head & (DBG_LOG_RING_SIZE - 1u)];
+        
+        record->format = format;
+        record->argCount = argCount;
+        record->args[0] = arg0;
+        record->args[1] = arg1;
+        record->args[2] = arg2;
+        record->args[3] = arg3;
+        logHead = head + 1u;
+    }
+    else
+    {
+        logDropped++;
+    }
+    
+    CyExitCriticalSection(interruptState);
+}
+
+
+/* Encode a record as: DBG_LOG_SYNC, argument count, format address, arguments.
+ * All values little endian. A NULL format reports the number of dropped records.
+ */
+static void DebugLogEncode(const char * format, uint8 argCount, const uint32 * args)
+{
+    uint8 counter;
+    
+    logFrame[0] = DBG_LOG_SYNC;
+    logFrame[1] = argCount;
+    Set32ByPtr(&logFrame[2], (uint32)format);
+    
+    for(counter = 0u; counter < argCount; counter++)
+    {
+        Set32ByPtr(&logFrame[6u + (4u * counter)], args[counter]);
+    }
+    
+    logFrameLength = 6u + (4u * argCount);
+    logFramePosition = 0u;
+}
+
+
+/* Blocks until the record in progress is completely sent, so that printf()
+ * output is never interleaved with a binary record.
+ */
+static void DebugLogFinishRecord(void)
+{
+    while(logFramePosition < logFrameLength)
+    {
+        UART_UartPutChar(logFrame[logFramePosition++]);
+    }
+}
+
+
+/******************************************************************************
+* Function Name: DebugLogFlush
+*******************************************************************************
+* 
+*  Moves queued records into the UART TX FIFO without blocking. Only as many 
+*  bytes as the hardware FIFO can take are written, so it is cheap to call on
+*  every pass of the main loop.
+* 
+*  \param None
+*
+*  \return None
+*  
+******************************************************************************/
+void DebugLogFlush(void)
+{
+    while(UART_SpiUartGetTxBufferSize() < UART_FIFO_SIZE)
+    {
+        if(logFramePosition < logFrameLength)
+        {
+            UART_SpiUartWriteTxData(logFrame[logFramePosition++]);
+        }
+        else if(logDropped != 0u)
+        {
+            uint8 interruptState = CyEnterCriticalSection();
+            uint32 dropped = logDropped;
+            
+            logDropped = 0u;
+            CyExitCriticalSection(interruptState);
+            
+            DebugLogEncode(NULL, 1u, &dropped);
+        }
+        else if(logTail != logHead)
+        {
+            DBG_LOG_RECORD_T * record = &logRing[logTail & (DBG_LOG_RING_SIZE - 1u)];
+            
+            DebugLogEncode(record->format, record->argCount, record->args);
+            logTail++;
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
+
+/******************************************************************************
+* Function Name: DebugWriteFrame
+*******************************************************************************
+* 
+*  Sends a binary frame: DBG_LOG_SYNC, frame type, payload length, payload.
+*  Unlike log records the frame is written immediately (blocking), after the 
+*  record in progress, if any, has been completed.
+* 
+*  \param 
+*	type: Frame type (DBG_FRAME_xxx)
+*   data: Payload
+*   length: Payload length
+*
+*  \return None
+*  
+******************************************************************************/
+void DebugWriteFrame(uint8 type, const uint8 * data, uint8 length)
+{
+    uint8 counter;
+    
+    DebugLogFinishRecord();
+    
+    UART_UartPutChar(DBG_LOG_SYNC);
+    UART_UartPutChar(type);
+    UART_UartPutChar(length);
+    
+    for(counter = 0u; counter < length; counter++)
+    {
+        UART_UartPutChar(data[counter]);
+    }
+}
+#endif  /* defined(CYMESH_DEBUG_ENABLED) || defined(CYMESH_DEBUG_ENABLED_ACK_COUNT) */
+
 /* [] END OF FILE */
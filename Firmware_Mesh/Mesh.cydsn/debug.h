@@ -15,6 +15,40 @@
 #include <project.h>
 #include <stdio.h>
 #include <cytypes.h>
+
+/* Deferred binary log. A record holds the address of its format string and up
+ * to four raw 32-bit arguments. DBG_LOGx() is safe to call from ISRs; records
+ * are sent over the UART from the main loop by DebugLogFlush() and turned back
+ * into text on the host by Tools/log_decoder.py using the ELF file. */
+#define DBG_LOG_RING_SIZE               (32u)       /* Number of records, must be a power of two */
+#define DBG_LOG_MAX_ARGS                (4u)
+#define DBG_LOG_SYNC                    (0xA5u)     /* First byte of every binary record on the UART */
+
+/* Binary frames share the sync byte with log records. The byte after it is the
+ * frame type instead of an argument count, followed by the payload length. */
+#define DBG_FRAME_STATS                 (0x80u)     /* Counter dump, see StatsDumpUart() */
+#define DBG_FRAME_TELEMETRY             (0x81u)     /* Merged fleet telemetry, see telemetry.c */
+#define DBG_FRAME_COMMISSION            (0x82u)     /* Configuration operation result, see commission.c */
+
+#if defined(CYMESH_DEBUG_ENABLED) || defined(CYMESH_DEBUG_ENABLED_ACK_COUNT)
+    #define DBG_LOG0(f)                 DebugLogWrite((f), 0u, 0u, 0u, 0u, 0u)
+    #define DBG_LOG1(f, a)              DebugLogWrite((f), 1u, (uint32)(a), 0u, 0u, 0u)
+    #define DBG_LOG2(f, a, b)           DebugLogWrite((f), 2u, (uint32)(a), (uint32)(b), 0u, 0u)
+    #define DBG_LOG3(f, a, b, c)        DebugLogWrite((f), 3u, (uint32)(a), (uint32)(b), (uint32)(c), 0u)
+    #define DBG_LOG4(f, a, b, c, d)     DebugLogWrite((f), 4u, (uint32)(a), (uint32)(b), (uint32)(c), (uint32)(d))
+
+    void DebugLogWrite(const char * format, uint8 argCount, uint32 arg0, uint32 arg1, uint32 arg2, uint32 arg3);
+    void DebugLogFlush(void);
+    void DebugWriteFrame(uint8 type, const uint8 * data, uint8 length);
+#else
+    #define DBG_LOG0(f)
+    #define DBG_LOG1(f, a)
+    #define DBG_LOG2(f, a, b)
+    #define DBG_LOG3(f, a, b, c)
+    #define DBG_LOG4(f, a, b, c, d)
+    #define DebugLogFlush()
+    #define DebugWriteFrame(type, data, length)     ((void)(type), (void)(data), (void)(length))
+#endif
     
 #ifdef CYMESH_DEBUG_ENABLED
     #define DBG_PRINT_TEXT(a)           do\
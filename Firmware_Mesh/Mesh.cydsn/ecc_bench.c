@@ -0,0 +1,126 @@
+/***************************************************************************//**
+* \file ecc_bench.c
+* \version 1.0
+*
+* \brief
+*  Cycle counts of the P-256 operations used by provisioning, measured on the
+*  target with SysTick. Enabled with CYMESHTEST_ECC_BENCHMARK.
+*
+*  Every run logs "ECC,<operation>,<run>,<cycles>" and a summary line with the
+*  average. Rebuild with another uECC configuration in the mesh library and
+*  compare the summaries to pick the fastest one.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include "main.h"
+
+#if (CYMESHTEST_ECC_BENCHMARK)
+
+#include "CyMesh_uECC.h"
+
+#define ECC_BENCH_RUNS                  (4u)
+#define ECC_BENCH_KEY_SIZE              (32u)
+
+/* SysTick reloads, counted by EccBenchSysTickIsr() */
+static volatile uint32 sysTickWraps;
+
+
+static void EccBenchSysTickIsr(void)
+{
+    sysTickWraps++;
+}
+
+
+/* Cycles since EccBenchStart(). SysTick counts down from CY_SYS_SYST_RVR_CNT_MASK. */
+static uint32 EccBenchGetCycles(void)
+{
+    uint32 wraps;
+    uint32 value;
+
+    do
+    {
+        wraps = sysTickWraps;
+        value = CySysTickGetValue();
+    } while(wraps != sysTickWraps);
+
+    return (wraps * (CY_SYS_SYST_RVR_CNT_MASK + 1u)) + (CY_SYS_SYST_RVR_CNT_MASK - value);
+}
+
+
+static void EccBenchLog(const char * operation, uint32 * total, uint32 start, uint8 run)
+{
+    uint32 cycles = EccBenchGetCycles() - start;
+
+    *total += cycles;
+    DBG_LOG3("ECC,%s,%d,%lu\r\n", operation, run, cycles);
+}
+
+
+/******************************************************************************
+* Function Name: EccBenchRun
+*******************************************************************************
+*
+*  Runs uECC_make_key(), uECC_compute_public_key() and uECC_shared_secret() on
+*  secp256r1 ECC_BENCH_RUNS times each and logs the cycle counts. Blocks for
+*  several seconds. Call after CyMesh_Start(), which sets the uECC RNG.
+*
+*  \param None
+*
+*  \return None
+*
+******************************************************************************/
+void EccBenchRun(void)
+{
+    uint8 privateKey[2][ECC_BENCH_KEY_SIZE];
+    uint8 publicKey[2][2u * ECC_BENCH_KEY_SIZE];
+    uint8 secret[ECC_BENCH_KEY_SIZE];
+    uint32 makeKeyTotal = 0;
+    uint32 publicKeyTotal = 0;
+    uint32 sharedSecretTotal = 0;
+    uint32 start;
+    uint8 run;
+    uECC_Curve curve = uECC_secp256r1();
+
+    sysTickWraps = 0;
+    CySysTickStart();
+    CySysTickSetClockSource(CY_SYS_SYST_CSR_CLK_SRC_SYSCLK);
+    CySysTickSetCallback(0u, EccBenchSysTickIsr);
+    CySysTickSetReload(CY_SYS_SYST_RVR_CNT_MASK);
+    CySysTickClear();
+
+    for(run = 0; run < ECC_BENCH_RUNS; run++)
+    {
+        start = EccBenchGetCycles();
+        if(uECC_make_key(publicKey[0], privateKey[0], curve) == 0)
+        {
+            DBG_LOG0("ECC,make_key failed\r\n");
+            break;
+        }
+        EccBenchLog("make_key", &makeKeyTotal, start, run);
+
+        (void)uECC_make_key(publicKey[1], privateKey[1], curve);
+
+        start = EccBenchGetCycles();
+        (void)uECC_compute_public_key(privateKey[1], publicKey[1], curve);
+        EccBenchLog("compute_public_key", &publicKeyTotal, start, run);
+
+        start = EccBenchGetCycles();
+        (void)uECC_shared_secret(publicKey[1], privateKey[0], secret, curve);
+        EccBenchLog("shared_secret", &sharedSecretTotal, start, run);
+    }
+
+    DBG_LOG4("ECC,average,%lu,%lu,%lu,%lu\r\n", makeKeyTotal / ECC_BENCH_RUNS, publicKeyTotal / ECC_BENCH_RUNS,
+             sharedSecretTotal / ECC_BENCH_RUNS, CYDEV_BCLK__SYSCLK__HZ);
+
+    CySysTickStop();
+    (void)CySysTickSetCallback(0u, NULL);
+}
+
+#endif /* CYMESHTEST_ECC_BENCHMARK */
+
+/* [] END OF FILE */
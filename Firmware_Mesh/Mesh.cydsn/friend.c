@@ -0,0 +1,185 @@
+/***************************************************************************//**
+* \file friend.c
+* \version 1.0
+*
+* \brief
+*  Message cache of the polling peripherals.
+*
+*  A peripheral that scans all the time draws about 12 mA. A polling one
+*  sleeps, and every few seconds sends a keep-alive with OPCODE_FRIEND_POLL
+*  and listens for a short window. The node it polls keeps the mesh messages
+*  for it in the meantime, and in reply to the poll sends up to
+*  FRIEND_POLL_BURST of them, then a keep-alive with OPCODE_FRIEND_POLL_REPLY
+*  that ends the window.
+*
+*  The messages of all the peripherals share one slab of FRIEND_CACHE_SIZE
+*  slots, so that a busy peripheral can use the room the others leave. Each
+*  peripheral has a queue of at most FRIEND_TAG_QUOTA messages, oldest first.
+*  A message for a peripheral at its quota replaces the oldest message of that
+*  peripheral; when the slab is full, it replaces the oldest message cached,
+*  whoever it is for. Either way the messages dropped are the most stale.
+*
+*  Tools/network_bench/friend_sim.c simulates the current and the latency of
+*  the peripherals for poll intervals from 1 to 60 s.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <project.h>
+#include <string.h>
+#include "friend.h"
+
+#define FRIEND_NONE                     (0xFFu)
+
+static FRIEND_MESSAGE_T friendSlab[FRIEND_CACHE_SIZE];
+static uint8 friendFree;
+
+/* Queue of each peripheral */
+static uint8 friendHead[FRIEND_TAG_COUNT];
+static uint8 friendTail[FRIEND_TAG_COUNT];
+static uint8 friendCount[FRIEND_TAG_COUNT];
+
+
+/* Unlink the oldest message of a peripheral and put its slot on the free list */
+static void FriendDropHead(uint8 tag)
+{
+    uint8 slot = friendHead[tag];
+
+    friendHead[tag] = friendSlab[slot].next;
+    if(friendHead[tag] == FRIEND_NONE)
+    {
+        friendTail[tag] = FRIEND_NONE;
+    }
+    friendCount[tag]--;
+
+    friendSlab[slot].next = friendFree;
+    friendFree = slot;
+}
+
+
+/* Peripheral with the oldest message; the slab is full, so there is one */
+static uint8 FriendFindOldest(uint32 now)
+{
+    uint8 oldest = FRIEND_NONE;
+    uint8 tag;
+
+    for(tag = 0; tag < FRIEND_TAG_COUNT; tag++)
+    {
+        if((friendHead[tag] != FRIEND_NONE) &&
+           ((oldest == FRIEND_NONE) ||
+            ((uint32)(now - friendSlab[friendHead[tag]].stored) > (uint32)(now - friendSlab[friendHead[oldest]].stored))))
+        {
+            oldest = tag;
+        }
+    }
+
+    return oldest;
+}
+
+
+void FriendInit(void)
+{
+    uint8 slot;
+
+    for(slot = 0; slot < FRIEND_CACHE_SIZE; slot++)
+    {
+        friendSlab[slot].next = ((slot + 1u) < FRIEND_CACHE_SIZE) ? (slot + 1u) : FRIEND_NONE;
+    }
+    friendFree = 0;
+
+    memset(friendHead, FRIEND_NONE, sizeof(friendHead));
+    memset(friendTail, FRIEND_NONE, sizeof(friendTail));
+    memset(friendCount, 0, sizeof(friendCount));
+}
+
+
+/* Cache a message for the peripheral at index tag of the list, received at now (ms) */
+FRIEND_STORE_RESULT_T FriendStore(uint8 tag, uint8 opcode, const uint8 * data, uint8 length, uint32 now)
+{
+    FRIEND_STORE_RESULT_T result = FRIEND_STORED;
+    uint8 slot;
+
+    if((tag >= FRIEND_TAG_COUNT) || (length > FRIEND_MESSAGE_MAX_LENGTH))
+    {
+        return FRIEND_TOO_LONG;
+    }
+
+    if(friendCount[tag] >= FRIEND_TAG_QUOTA)
+    {
+        FriendDropHead(tag);
+        result = FRIEND_STORED_EVICTED;
+    }
+    else if(friendFree == FRIEND_NONE)
+    {
+        FriendDropHead(FriendFindOldest(now));
+        result = FRIEND_STORED_EVICTED;
+    }
+    else
+    {
+        /* Room for it */
+    }
+
+    slot = friendFree;
+    friendFree = friendSlab[slot].next;
+
+    friendSlab[slot].stored = now;
+    friendSlab[slot].opcode = opcode;
+    friendSlab[slot].length = length;
+    memcpy(friendSlab[slot].data, data, length);
+    friendSlab[slot].tag = tag;
+    friendSlab[slot].next = FRIEND_NONE;
+
+    if(friendTail[tag] == FRIEND_NONE)
+    {
+        friendHead[tag] = slot;
+    }
+    else
+    {
+        friendSlab[friendTail[tag]].next = slot;
+    }
+    friendTail[tag] = slot;
+    friendCount[tag]++;
+
+    return result;
+}
+
+
+/* Copy out and remove the oldest message of a peripheral. False if it has none. */
+bool FriendTake(uint8 tag, FRIEND_MESSAGE_T * message)
+{
+    if((tag >= FRIEND_TAG_COUNT) || (friendHead[tag] == FRIEND_NONE))
+    {
+        return false;
+    }
+
+    *message = friendSlab[friendHead[tag]];
+    FriendDropHead(tag);
+
+    return true;
+}
+
+
+uint8 FriendCount(uint8 tag)
+{
+    return (tag < FRIEND_TAG_COUNT) ? friendCount[tag] : 0u;
+}
+
+
+/* Drop the messages of a peripheral out of range. Returns how many were dropped. */
+uint8 FriendRemove(uint8 tag)
+{
+    uint8 count = FriendCount(tag);
+
+    while(FriendCount(tag) != 0u)
+    {
+        FriendDropHead(tag);
+    }
+
+    return count;
+}
+
+/* [] END OF FILE */
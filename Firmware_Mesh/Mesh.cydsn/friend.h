@@ -0,0 +1,84 @@
+/***************************************************************************//**
+* \file friend.h
+* \version 1.0
+*
+* \brief
+*  Message cache of the peripherals that poll. A polling peripheral only
+*  listens for a short window after each poll, so the mesh messages for it
+*  are kept in a cache shared by all the peripherals in range until its next
+*  poll.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#if !defined(FRIEND_H)
+#define FRIEND_H
+
+#include <project.h>
+#include <stdbool.h>
+
+/******************************Pre-processor Directives**********************************************/
+/* Messages cached for all the peripherals, 20 bytes each */
+#if !defined(FRIEND_CACHE_SIZE)
+    #define FRIEND_CACHE_SIZE           (16u)
+#endif
+
+/* Messages cached for one peripheral. Past it, its oldest message is dropped,
+ * so that one busy peripheral cannot take the whole cache. */
+#if !defined(FRIEND_TAG_QUOTA)
+    #define FRIEND_TAG_QUOTA            (8u)
+#endif
+
+/* Messages sent in reply to one poll. The peripheral polls again at once if
+ * more are left. */
+#if !defined(FRIEND_POLL_BURST)
+    #define FRIEND_POLL_BURST           (4u)
+#endif
+
+#define FRIEND_TAG_COUNT                (10u)   /* Peripherals in range, LIST_SIZE in main.c */
+#define FRIEND_MESSAGE_MAX_LENGTH       (10u)   /* Payload of a data beacon */
+#define FRIEND_POLL_INTERVAL_MAX_S      (60u)
+#define FRIEND_POLL_MISSES              (2u)    /* Polls missed before a peripheral is out of range */
+
+#if (FRIEND_CACHE_SIZE < 1u) || (FRIEND_CACHE_SIZE > 254u) || (FRIEND_TAG_QUOTA < 1u) || \
+    (FRIEND_TAG_QUOTA > FRIEND_CACHE_SIZE) || (FRIEND_POLL_BURST < 1u) || (FRIEND_POLL_BURST > 254u)
+    #error "Invalid friend cache configuration"
+#endif
+
+/* Keep-alive opcodes. The poll of a peripheral carries its poll interval in
+ * seconds (1), the reply of the node the messages still cached for it (1).
+ * Peripherals that keep scanning send keep-alives with opcode 0. */
+#define OPCODE_FRIEND_POLL              (0x01)
+#define OPCODE_FRIEND_POLL_REPLY        (0x01)
+
+/**************************************Enums**************************************************/
+typedef enum
+{
+    FRIEND_STORED,                      /* Cached */
+    FRIEND_STORED_EVICTED,              /* Cached in place of an older message */
+    FRIEND_TOO_LONG                     /* Dropped, longer than FRIEND_MESSAGE_MAX_LENGTH */
+} FRIEND_STORE_RESULT_T;
+
+typedef struct
+{
+    uint32 stored;                      /* Timestamp, in ms */
+    uint8 opcode;
+    uint8 length;
+    uint8 data[FRIEND_MESSAGE_MAX_LENGTH];
+    uint8 tag;
+    uint8 next;                         /* Next message of the peripheral, or of the free list */
+} FRIEND_MESSAGE_T;
+
+/*****************************Function Declarations**************************************/
+void FriendInit(void);
+FRIEND_STORE_RESULT_T FriendStore(uint8 tag, uint8 opcode, const uint8 * data, uint8 length, uint32 now);
+bool FriendTake(uint8 tag, FRIEND_MESSAGE_T * message);
+uint8 FriendCount(uint8 tag);
+uint8 FriendRemove(uint8 tag);
+
+#endif
+/* [] END OF FILE */
@@ -35,6 +35,47 @@
 
 #define LIST_SIZE                       (10)
 #define PERIPHERAL_PRESENCE_TIMEOUT_S   (10)
+#define TICK_PERIOD_MS                  (1000u)
+
+#if (LIST_SIZE > FRIEND_TAG_COUNT)
+    #error "The friend cache must have a queue per device in the list"
+#endif
+
+/* Node level opcodes. Opcodes above OPCODE_NODE_MAX belong to the peripheral application. */
+#define OPCODE_STATS_GET                (0x01)  /* Source ID (2) + Destination ID (2, unicast) */
+#define OPCODE_STATS_STATUS             (0x02)  /* Source ID (2) + Counter index (1) + Value (4) */
+/* OPCODE_TELEMETRY_ROUTE (0x03) and OPCODE_TELEMETRY_REPORT (0x04), see telemetry.h */
+#define OPCODE_NODE_MAX                 (0x0F)
+
+/* UART commands, one per SLIP frame (see slip.c) */
+#define UART_CMD_STATS                  ('S')   /* 'S' + Node ID (2): dump the counters of a node */
+#define UART_CMD_STATS_LENGTH           (3)
+#define UART_CMD_TELEMETRY_SINK         ('T')   /* 'T' + Enable (1): make this node the telemetry sink */
+#define UART_CMD_TELEMETRY_SINK_LENGTH  (2)
+#define UART_CMD_COMMISSION             ('C')   /* 'C' + Request: configure another node, see commission.h */
+#define UART_CMD_COMMISSION_HEADER_LENGTH   (1)
+#define UART_CMD_MAX_LENGTH             (UART_CMD_COMMISSION_HEADER_LENGTH + COMMISSION_REQUEST_MAX_LENGTH)
+
+/* Trace stages logged by the node. Keep in sync with Tools/trace_analyser.py */
+#define TRACE_STAGE_BEACON_RX           "A_RX"      /* Data beacon accepted from a peripheral */
+#define TRACE_STAGE_MESH_TX             "A_MTX"     /* Handed to the vendor specific model */
+#define TRACE_STAGE_MESH_RX             "A_MRX"     /* Received from the mesh for a peripheral in range */
+#define TRACE_STAGE_BEACON_TX           "A_BTX"     /* Handed to the bearer as a data beacon */
+
+#if (CYMESHTEST_TRACE_ENABLED)
+    /* The trace ID is always the last byte of the peripheral payload. Node level
+     * messages carry no trace ID. */
+    #define TRACE_STAGE(opcode, payload, length, stage) \
+        do\
+        {\
+            if(((opcode) & MASK_OPCODE) > OPCODE_NODE_MAX)\
+            {\
+                TraceStage((payload)[(length) - 1], (stage));\
+            }\
+        } while (0)
+#else
+    #define TRACE_STAGE(opcode, payload, length, stage)
+#endif
 
 /*************************Global Variables***********************************/
 typedef struct 
@@ -42,18 +83,42 @@ typedef struct
     uint16 sourceId;
     bool isEntryValid;
     uint8 timeCounter;
+    uint8 pollIntervalS;    /* 0 for a peripheral that keeps scanning */
+    uint8 replyLeft;        /* Beacons left in reply to its poll, see SendFriendReply() */
 } DEVICES_T;
 
 static DEVICES_T devicesCloseBy[10];
 static uint8 numberOfDevices = 0;
 
 static uint16 beaconId = 0;
-static volatile bool isBeaconFlagSet = false;
+static bool isBeaconFlagSet = false;
+/* Mesh timer timestamp of the next call to SecondTick() */
+static uint32 nextTickTime = 0;
+
+/* Next counter to send in reply to OPCODE_STATS_GET; STATS_COUNT when idle */
+static uint8 statsReplyIndex = STATS_COUNT;
+/* Set once this node polled others, so that their replies go to the UART */
+static bool isStatsPollActive = false;
+static volatile bool isStatsDumpRequested = false;
+
+#ifdef CYMESH_DEBUG_ENABLED
+/* Command being received on the debug UART, and its CRC */
+static uint8 uartCommand[UART_CMD_MAX_LENGTH + SLIP_CRC_LENGTH];
+static SLIP_DECODER_T uartDecoder;
+#endif
 
 
 /******************************Function Definitions***********************************/
 
-static void AddDeviceToList(uint16 incomingSourceId)
+#if (CYMESHTEST_TRACE_ENABLED)
+/* Log one trace stage as "T,<device>,<trace ID>,<stage>,<timestamp in ms>" */
+static void TraceStage(uint8 traceId, const char * stage)
+{
+    DBG_LOG4("T,%04x,%02x,%s,%lu\r\n", beaconId, traceId, stage, CyMesh_TimerGetTimestamp());
+}
+#endif
+
+static int8 AddDeviceToList(uint16 incomingSourceId)
 {
     uint8 counter;
     
@@ -64,12 +129,15 @@ static void AddDeviceToList(uint16 incomingSourceId)
             devicesCloseBy[counter].isEntryValid = true;
             devicesCloseBy[counter].sourceId = incomingSourceId;
             devicesCloseBy[counter].timeCounter = PERIPHERAL_PRESENCE_TIMEOUT_S;
+            devicesCloseBy[counter].pollIntervalS = 0;
+            devicesCloseBy[counter].replyLeft = 0;
             
-            printf("Adding to list. Index = %d. Device = %04x\r\n", counter, incomingSourceId);
+            DBG_LOG2("Adding to list. Index = %d. Device = %04x\r\n", counter, incomingSourceId);
             
-            break;
+            return counter;
         }
     }
+    return -1;
 }
 
 
@@ -91,18 +159,19 @@ static int8 FindDeviceInList(uint16 incomingSourceId)
 }
 
 
-static void TimerIsr(void)
+/* Called once per second from the main loop. The tick follows the mesh timer,
+ * which keeps running in Deep-Sleep. */
+static void SecondTick(void)
 {
     /* Decrement the counters for all the valid devices nearby.
      * When a device counter expires, erase it from the list.
      */
     uint8 counter;
     
-    TimerInterrupt_ClearPending();
-    Timer_ClearInterrupt(Timer_INTR_MASK_TC);
-    
     /* Every second, trigger a non-connectable beacon */
     isBeaconFlagSet = true;
+    TelemetryTick();
+    CommissionTick();
     
     if(numberOfDevices == 0)
     {
@@ -117,10 +186,12 @@ static void TimerIsr(void)
             
             if(devicesCloseBy[counter].timeCounter == 0)
             {
-                printf("Removing device @ index = %d. Device = %04x\r\n", counter, 
+                DBG_LOG2("Removing device @ index = %d. Device = %04x\r\n", counter, 
                                             devicesCloseBy[counter].sourceId);
                 devicesCloseBy[counter].isEntryValid = false;
                 numberOfDevices--;
+                STATS_INCREMENT(STATS_DEVICE_EXPIRED);
+                statsCounters[STATS_FRIEND_DROPPED] += FriendRemove(counter);
             }
         }
     }
@@ -134,10 +205,18 @@ static void SendMeshPacket(uint8 opcode, const uint8 * data, uint8 length)
 {
     CYMESH_VARIABLE_DATA_T packet;
     
+    TRACE_STAGE(opcode, data, length, TRACE_STAGE_MESH_TX);
+    
     packet.data[0] = opcode & MASK_OPCODE;
     memcpy(&packet.data[1], data, length);
     packet.len = length + 1;
     
+    /* The vendor model API gives no status, so check the bearer up front */
+    if(CyMesh_BearerGetTxBufferStatus() == CYMESH_BEARER_TX_BUFFER_FULL)
+    {
+        STATS_INCREMENT(STATS_BEARER_TX_FULL);
+    }
+    
     CyMesh_VendorSpecificSendDataUnreliable(packet, 
                                             CYMESH_MDL_VENDOR_SPECIFIC_COMP_3, 
                                             CYMESH_MDL_VENDOR_SPECIFIC_COMP_3_MDLIDX);
@@ -149,6 +228,8 @@ static void SendDataBeacon(uint8 opcode, const uint8 * payload, uint8 payloadLen
     uint8 data[20];
     uint8 length = 0;
     
+    TRACE_STAGE(opcode, payload, payloadLength, TRACE_STAGE_BEACON_TX);
+    
     /* Flags */
     data[0] = CYBLE_GAP_ADV_FLAGS_PACKET_LENGTH;
     data[1] = CYBLE_GAP_ADV_FLAGS;
@@ -167,13 +248,18 @@ static void SendDataBeacon(uint8 opcode, const uint8 * payload, uint8 payloadLen
     length = payloadLength + 10;
 
     /* Call the mesh API to send custom beacon */
-    CyMesh_BearerSendData(data, length, CYMESH_BEARER_CUSTOM_ADV, 2, false, true);
+    if(CyMesh_BearerSendData(data, length, CYMESH_BEARER_CUSTOM_ADV, 2, false, true) == CYMESH_ERROR_BEARER_TX_BUFFER_FULL)
+    {
+        STATS_INCREMENT(STATS_BEARER_TX_FULL);
+    }
 }
 
 
-static void SendEmptyBeacon(void)
+/* Keep-alive beacon. The opcode and parameters are those of the polling
+ * peripherals, see friend.h; the regular beacon has none. */
+static void SendEmptyBeacon(uint8 opcode, const uint8 * param, uint8 paramLength)
 {
-    uint8 data[10];
+    uint8 data[11];
     uint8 length = 0;
     
     /* Flags */
@@ -182,26 +268,308 @@ static void SendEmptyBeacon(void)
     data[2] = CYBLE_GAP_ADV_FLAG_LE_GENERAL_DISC_MODE | CYBLE_GAP_ADV_FLAG_BR_EDR_NOT_SUPPORTED;
     
     /* Manufacturer data */
-    data[3] = 6;    /* Length of manufacturer data field */
+    data[3] = paramLength + 6;    /* Length of manufacturer data field */
     data[4] = ADV_TYPE_MANUFACTURER_DATA;
     data[5] = MANUFACTURER_ID_TALENTICA_LSB;
     data[6] = MANUFACTURER_ID_TALENTICA_MSB;
-    data[7] = (SEND_NO_DATA << BIT_POS_IS_DATA) | (DEVICE_MESH << BIT_POS_IS_PERIPHERAL);
+    data[7] = (SEND_NO_DATA << BIT_POS_IS_DATA) | (DEVICE_MESH << BIT_POS_IS_PERIPHERAL) | (opcode & MASK_OPCODE);
     data[8] = beaconId & 0x00FF;
     data[9] = (beaconId >> 8) & 0x00FF;
+    if(paramLength != 0)
+    {
+        memcpy(&data[10], param, paramLength);
+    }
+    
+    length = paramLength + 10;
+    
+    if(CyMesh_BearerSendData(data, length, CYMESH_BEARER_CUSTOM_ADV, 1, false, true) == CYMESH_ERROR_BEARER_TX_BUFFER_FULL)
+    {
+        STATS_INCREMENT(STATS_BEARER_TX_FULL);
+    }
+}
+
+
+/* Send data to the peripheral at index device of the list: right away if it
+ * keeps scanning, at its next poll if it polls */
+static void SendToPeripheral(int8 device, uint8 opcode, const uint8 * payload, uint8 payloadLength)
+{
+    if(devicesCloseBy[device].pollIntervalS == 0)
+    {
+        SendDataBeacon(opcode, payload, payloadLength);
+        return;
+    }
+    
+    switch(FriendStore(device, opcode, payload, payloadLength, CyMesh_TimerGetTimestamp()))
+    {
+        case FRIEND_STORED:
+            STATS_INCREMENT(STATS_FRIEND_CACHED);
+            break;
+        
+        case FRIEND_STORED_EVICTED:
+            STATS_INCREMENT(STATS_FRIEND_CACHED);
+            STATS_INCREMENT(STATS_FRIEND_DROPPED);
+            break;
+        
+        default:
+            STATS_INCREMENT(STATS_FRIEND_DROPPED);
+            break;
+    }
+}
+
+
+/* Keep-alive of a peripheral in the list. A poll sets its interval, extends
+ * its presence to the polls it may miss and starts the reply. */
+static void HandleKeepAlive(int8 device, uint8 opcode, const uint8 * param, uint8 paramLength)
+{
+    DEVICES_T * entry = &devicesCloseBy[device];
+    
+    if((opcode == OPCODE_FRIEND_POLL) && (paramLength >= 1))
+    {
+        entry->pollIntervalS = (param[0] == 0) ? 1 :
+                               (param[0] > FRIEND_POLL_INTERVAL_MAX_S) ? FRIEND_POLL_INTERVAL_MAX_S : param[0];
+        entry->timeCounter = PERIPHERAL_PRESENCE_TIMEOUT_S + (FRIEND_POLL_MISSES * entry->pollIntervalS);
+        entry->replyLeft = FRIEND_POLL_BURST + 1;
+        STATS_INCREMENT(STATS_FRIEND_POLL);
+    }
+    else
+    {
+        entry->pollIntervalS = 0;
+        entry->timeCounter = PERIPHERAL_PRESENCE_TIMEOUT_S;
+        
+        /* It scans again: send what was cached for it */
+        if(FriendCount(device) != 0)
+        {
+            entry->replyLeft = FriendCount(device) + 1;
+        }
+    }
+}
+
+
+/* Send the next beacon of a poll reply, if the bearer has room: the cached
+ * messages, oldest first, then OPCODE_FRIEND_POLL_REPLY with the number of
+ * messages still cached, which ends the receive window of the peripheral. */
+static void SendFriendReply(void)
+{
+    FRIEND_MESSAGE_T message;
+    uint8 counter;
+    uint8 left;
+    
+    /* Don't compete with relayed traffic for the last TX buffers */
+    if(CyMesh_BearerGetTxBufferStatus() >= CYMESH_BEARER_TX_BUFFER_BUSY)
+    {
+        return;
+    }
+    
+    for(counter = 0; counter < LIST_SIZE; counter++)
+    {
+        DEVICES_T * entry = &devicesCloseBy[counter];
+        
+        if((entry->isEntryValid == false) || (entry->replyLeft == 0))
+        {
+            continue;
+        }
+        
+        entry->replyLeft--;
+        if((entry->replyLeft != 0) && (FriendTake(counter, &message) == true))
+        {
+            STATS_INCREMENT(STATS_FRIEND_DELIVERED);
+            SendDataBeacon(message.opcode, message.data, message.length);
+        }
+        else
+        {
+            left = FriendCount(counter);
+            entry->replyLeft = 0;
+            SendEmptyBeacon(OPCODE_FRIEND_POLL_REPLY, &left, sizeof(left));
+        }
+        return;
+    }
+}
+
+
+static bool IsFriendReplyPending(void)
+{
+    uint8 counter;
+    
+    for(counter = 0; counter < LIST_SIZE; counter++)
+    {
+        if((devicesCloseBy[counter].isEntryValid == true) && (devicesCloseBy[counter].replyLeft != 0))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/* Handle node level messages (opcode <= OPCODE_NODE_MAX) received from the mesh */
+static void HandleNodeMessage(const uint8 * data, uint8 length)
+{
+    if(length < 1)
+    {
+        return;
+    }
+    
+    switch(data[0] & MASK_OPCODE)
+    {
+        case OPCODE_STATS_GET:
+        {
+            uint16 incomingDestinationId;
+            
+            if(length < 5)
+            {
+                break;
+            }
+            
+            /* The reply is STATS_COUNT messages, sent one per message from the
+             * main loop. A broadcast request would have every node flood them,
+             * so only a request to this node is answered; telemetry.c gives
+             * the fleet totals. */
+            incomingDestinationId = (data[4] << 8) | data[3];
+            if(incomingDestinationId == beaconId)
+            {
+                statsReplyIndex = 0;
+            }
+            break;
+        }
+        
+        case OPCODE_STATS_STATUS:
+            if((length >= 8) && (isStatsPollActive == true))
+            {
+                uint16 incomingSourceId = (data[2] << 8) | data[1];
+                uint32 value = ((uint32)data[7] << 24) | ((uint32)data[6] << 16) | 
+                               ((uint32)data[5] << 8) | data[4];
+                
+                StatsDumpUart(incomingSourceId, data[3], &value, 1);
+            }
+            break;
+        
+        case OPCODE_TELEMETRY_ROUTE:
+        case OPCODE_TELEMETRY_REPORT:
+            TelemetryHandleMessage(data, length);
+            break;
+        
+        default:
+            break;
+    }
+}
+
+
+/* True if the main loop has work it can do right away. Work that waits for
+ * room in the bearer resumes on the next bearer or mesh timer interrupt. */
+static bool IsWorkPending(void)
+{
+    if(KeyJobIsPending() == true)
+    {
+        return true;
+    }
     
-    length = 10;
+    if(CyMesh_BearerGetTxBufferStatus() >= CYMESH_BEARER_TX_BUFFER_BUSY)
+    {
+        return false;
+    }
     
-    CyMesh_BearerSendData(data, length, CYMESH_BEARER_CUSTOM_ADV, 1, false, true);  
+    return (statsReplyIndex < STATS_COUNT) || TelemetryIsTxPending() || IsFriendReplyPending();
 }
 
 
+/* Send the next counter requested by OPCODE_STATS_GET, if the bearer has room */
+static void SendStatsReply(void)
+{
+    uint8 payload[7];
+    uint32 value;
+    
+    if(statsReplyIndex >= STATS_COUNT)
+    {
+        return;
+    }
+    
+    /* Don't compete with relayed traffic for the last TX buffers */
+    if(CyMesh_BearerGetTxBufferStatus() >= CYMESH_BEARER_TX_BUFFER_BUSY)
+    {
+        return;
+    }
+    
+    value = statsCounters[statsReplyIndex];
+    
+    payload[0] = beaconId & 0x00FF;
+    payload[1] = (beaconId >> 8) & 0x00FF;
+    payload[2] = statsReplyIndex;
+    payload[3] = value & 0x000000FF;
+    payload[4] = (value >> 8) & 0x000000FF;
+    payload[5] = (value >> 16) & 0x000000FF;
+    payload[6] = (value >> 24) & 0x000000FF;
+    
+    SendMeshPacket(OPCODE_STATS_STATUS, payload, sizeof(payload));
+    statsReplyIndex++;
+}
+
+
+#ifdef CYMESH_DEBUG_ENABLED
+/* Read commands from the debug UART, one per SLIP frame. UART_CMD_STATS with
+ * our own ID or broadcast dumps the local counters, any other ID polls that
+ * node over the mesh. UART_CMD_TELEMETRY_SINK turns this node into the
+ * telemetry sink and back. UART_CMD_COMMISSION sends a configuration
+ * operation to another node. */
+static void ProcessUartCommand(void)
+{
+    const uint8 * command = uartCommand;
+    uint8 commandLength;
+    
+    while(UART_SpiUartGetRxBufferSize() != 0u)
+    {
+        commandLength = SlipDecode(&uartDecoder, (uint8)UART_SpiUartReadRxData());
+        
+        if(commandLength == 0u)
+        {
+            /* Frame not complete, or dropped */
+        }
+        else if((command[0] == UART_CMD_COMMISSION) && (commandLength > UART_CMD_COMMISSION_HEADER_LENGTH))
+        {
+            CommissionRequest(&command[UART_CMD_COMMISSION_HEADER_LENGTH],
+                              commandLength - UART_CMD_COMMISSION_HEADER_LENGTH);
+        }
+        else if((command[0] == UART_CMD_TELEMETRY_SINK) && (commandLength == UART_CMD_TELEMETRY_SINK_LENGTH))
+        {
+            TelemetrySetSink(command[1] != 0u);
+        }
+        else if((command[0] == UART_CMD_STATS) && (commandLength == UART_CMD_STATS_LENGTH))
+        {
+            uint16 nodeId = (command[2] << 8) | command[1];
+            
+            if((nodeId == beaconId) || (nodeId == CYMESH_NET_BROADCAST_ADDR))
+            {
+                StatsDumpUart(beaconId, 0, statsCounters, STATS_COUNT);
+            }
+            else
+            {
+                uint8 data[4];
+                
+                data[0] = beaconId & 0x00FF;
+                data[1] = (beaconId >> 8) & 0x00FF;
+                data[2] = nodeId & 0x00FF;
+                data[3] = (nodeId >> 8) & 0x00FF;
+                
+                isStatsPollActive = true;
+                SendMeshPacket(OPCODE_STATS_GET, data, sizeof(data));
+            }
+        }
+        else
+        {
+            /* Unknown command, or wrong length */
+        }
+    }
+}
+#endif
+
+
 /******************************************************************************
 * Function Name: MeshEventHandler
 *******************************************************************************
 * 
-*  Callback function for Mesh Related events. All events are currently handled
-*  by the Smart Mesh Stack. Thus this function is empty.
+*  Callback function for Mesh Related events. Node messages (stats requests and
+*  replies, telemetry routes and reports) go to HandleNodeMessage(), vendor
+*  messages for a nearby device to the peripheral, and the configuration
+*  client results to commission.c. Every event is counted in the stats.
 * 
 *  \param 
 *	event: The type of event raised
@@ -217,6 +585,7 @@ void MeshEventHandler(uint32 event, void * eventParam, uint8 compIndex, uint8 mo
 	{
 		case CYMESH_EVT_STACK_ON:
 			/* Initialize configInfoRam with information that is not present */
+			STATS_INCREMENT(STATS_MESH_STACK_ON);
 			DefineNodeinfo();
 		    break;
 		
@@ -231,22 +600,45 @@ void MeshEventHandler(uint32 event, void * eventParam, uint8 compIndex, uint8 mo
             uint8 * data = vend_data->data;
             uint16 incomingDestinationId = (data[4] << 8) | data[3];
             
-            if(FindDeviceInList(incomingDestinationId) >= 0)
+            if((data[0] & MASK_OPCODE) <= OPCODE_NODE_MAX)
+            {
+                HandleNodeMessage(data, data_len);
+            }
+            else if(FindDeviceInList(incomingDestinationId) >= 0)
             {
                 /* Send the data coming from mesh as a beacon.
                  */
-                printf("Received mesh data. Sending to peripheral...\r\n");
-                SendDataBeacon(data[0], &data[1], data_len - 1);
+                STATS_INCREMENT(STATS_MESH_RX_TO_PERIPHERAL);
+                TRACE_STAGE(data[0], data, data_len, TRACE_STAGE_MESH_RX);
+                DBG_LOG0("Received mesh data. Sending to peripheral...\r\n");
+                SendToPeripheral(FindDeviceInList(incomingDestinationId), data[0], &data[1], data_len - 1);
             }
             else
             {
                 /* Packet dropped */
+                STATS_INCREMENT(STATS_MESH_RX_DROPPED);
             }
 		    break;
 		}
 
         
+        /* Configuration client results of the operations sent by commission.c */
+		case CYMESH_EVT_CONFIG_RELAY_STATUS:
+		case CYMESH_EVT_CONFIG_DEFAULT_TTL_STATUS:
+		case CYMESH_EVT_APPKEY_STATUS_OK:
+		case CYMESH_EVT_APPKEY_STATUS_ERROR:
+		case CYMESH_EVT_MODEL_PUBLICATION_STATUS_OK:
+		case CYMESH_EVT_MODEL_PUBLICATION_STATUS_ERROR:
+		case CYMESH_EVT_MODEL_SUBSCRIPTION_STATUS_OK:
+		case CYMESH_EVT_MODEL_SUBSCRIPTION_STATUS_ERROR:
+		case CYMESH_EVT_RELIABLE_MESSAGE_TIMEOUT:
+		    STATS_INCREMENT(STATS_MESH_OTHER_EVENT);
+		    CommissionHandleEvent(event, eventParam);
+		    break;
+        
+        
 		default:
+		    STATS_INCREMENT(STATS_MESH_OTHER_EVENT);
 		    break;
 	}
 }
@@ -279,6 +671,7 @@ void GenericEventHandler(uint32 event, void * eventParam)
             /* Ensure that only non-connectable ADV is parsed */
             if(advReport->eventType != CYBLE_GAPC_NON_CONN_UNDIRECTED_ADV)
             {
+                STATS_INCREMENT(STATS_ADV_NOT_NON_CONN);
                 break;
             }
             
@@ -302,6 +695,7 @@ void GenericEventHandler(uint32 event, void * eventParam)
                 if(memcmp(field_flags, data, sizeof(field_flags)) != 0)
                 {
                     /* Flags field not present, or invalid */
+                    STATS_INCREMENT(STATS_BEACON_BAD_FLAGS);
                     break;
                 }
 
@@ -309,12 +703,14 @@ void GenericEventHandler(uint32 event, void * eventParam)
                 {
                     /* Manufacturing data not present, or invalid.
                      * Length ignored in check (hence the +1). */
+                    STATS_INCREMENT(STATS_BEACON_BAD_MANUFACTURER);
                     break;
                 }
 
                 if((data[sizeof(field_flags)] + sizeof(field_flags) + 1) != data_len)
                 {
                     /* Length check: Packet length is invalid */
+                    STATS_INCREMENT(STATS_BEACON_BAD_LENGTH);
                     break;
                 }
 
@@ -324,39 +720,55 @@ void GenericEventHandler(uint32 event, void * eventParam)
                 /* Don't confuse mesh devices acting as beacons with actual peripherals */
                 if((data[index] & MASK_IS_PERIPHERAL) == (DEVICE_MESH << BIT_POS_IS_PERIPHERAL))
                 {
+                    STATS_INCREMENT(STATS_BEACON_FROM_MESH_DEVICE);
                     break;
                 }
                 
                 incomingBeaconId = (data[index + 2] << 8) | data[index + 1];
                 incomingSourceId = (data[index + 4] << 8) | data[index + 3];
                 
-                /* If this is not the target beacon, drop packet */
+                /* If this is not the target beacon, drop packet. Answer the poll
+                 * of a peripheral talking to another node with a keep-alive, so
+                 * that it still hears this node in its short receive window. */
                 if(incomingBeaconId != beaconId)
                 {
+                    if((data[index] & (MASK_IS_DATA | MASK_OPCODE)) == OPCODE_FRIEND_POLL)
+                    {
+                        isBeaconFlagSet = true;
+                    }
+                    STATS_INCREMENT(STATS_BEACON_WRONG_BEACON_ID);
                     break;
                 }
                 
                 /* If the beacon is just a keep-alive (no data), extract the source ID. */
                 if((data[index] & MASK_IS_DATA) == SEND_NO_DATA)
                 {
-                    int8 index = FindDeviceInList(incomingSourceId);
+                    int8 device = FindDeviceInList(incomingSourceId);
                     
                     /* Either add to the list of devices closeby, or update timer */
-                    if(index == -1)
+                    if(device == -1)
                     {
                         if(numberOfDevices < LIST_SIZE)
                         {
-                            AddDeviceToList(incomingSourceId);
+                            device = AddDeviceToList(incomingSourceId);
                             numberOfDevices++;
+                            STATS_INCREMENT(STATS_KEEP_ALIVE_ADDED);
                         }
                         else
                         {
                             /* Drop packet */
+                            STATS_INCREMENT(STATS_KEEP_ALIVE_LIST_FULL);
                         }
                     }
                     else
                     {
-                        devicesCloseBy[index].timeCounter = PERIPHERAL_PRESENCE_TIMEOUT_S;
+                        STATS_INCREMENT(STATS_KEEP_ALIVE_REFRESHED);
+                    }
+                    
+                    /* Parameters follow the source ID */
+                    if(device >= 0)
+                    {
+                        HandleKeepAlive(device, data[index] & MASK_OPCODE, &data[index + 5], data_len - index - 5);
                     }
                 }
                 else
@@ -368,18 +780,23 @@ void GenericEventHandler(uint32 event, void * eventParam)
                     /* If the incomingSourceId is not part of the list, drop packet */
                     if(FindDeviceInList(incomingSourceId) == -1)
                     {
+                        STATS_INCREMENT(STATS_DATA_UNKNOWN_SOURCE);
                         break;
                     }
                     
+                    TRACE_STAGE(opcode, data, data_len, TRACE_STAGE_BEACON_RX);
+                    
                     /* If the destination is part of the list, simply beacon */
                     if(FindDeviceInList(incomingDestinationId) >= 0)
                     {
-                        printf("Destination in range. Skipping mesh...\r\n");
-                        SendDataBeacon(opcode, &data[index + 3], length);
+                        STATS_INCREMENT(STATS_DATA_IN_RANGE);
+                        DBG_LOG0("Destination in range. Skipping mesh...\r\n");
+                        SendToPeripheral(FindDeviceInList(incomingDestinationId), opcode, &data[index + 3], length);
                     }
                     else
                     {
-                        printf("Sending mesh data...\r\n");
+                        STATS_INCREMENT(STATS_DATA_TO_MESH);
+                        DBG_LOG0("Sending mesh data...\r\n");
                         
                         /* Send packet to the mesh network */
                         SendMeshPacket(opcode, &data[index + 3], length);
@@ -397,7 +814,8 @@ void GenericEventHandler(uint32 event, void * eventParam)
 
 void MySwitchIsr(void)
 {
-    /* Add custom code here if required */
+    /* Dump the local counters from the main loop */
+    isStatsDumpRequested = true;
     
     /* Clear interrupt */
     SW2_ClearInterrupt();
@@ -425,6 +843,7 @@ void InitializeSystem(void)
     
 	#ifdef CYMESH_DEBUG_ENABLED
 		UART_Start();
+		SlipInit(&uartDecoder, uartCommand, sizeof(uartCommand));
 		printf("******** Mesh device. ");
 	#endif
     
@@ -434,16 +853,20 @@ void InitializeSystem(void)
 	
 	/* Call CyMesh_ProcessEvents once to enable the Mesh Stack*/
 	CyMesh_ProcessEvents();
+    
+    #if (CYMESHTEST_ECC_BENCHMARK)
+        EccBenchRun();
+    #endif
 
-    /* Initialize timer for regular beacon */
-    TimerInterrupt_StartEx(TimerIsr);
-    Timer_Start();
+    /* Regular beacon, see SecondTick() */
+    nextTickTime = CyMesh_TimerGetTimestamp() + TICK_PERIOD_MS;
 	
 	/* Application Level node information setting. These information are must to allow
 	* proper Smart Mesh functionality, if no provisioning can be done */
     #if (CYMESHTEST_START_DIRECTLY_WITH_RELAY)
-        DefineAppInfo();
+        /* Network key first, so that the node relays as soon as possible */
         DefineNetInfo();
+        DefineAppInfo();
     #endif
     
     /* Register an interrupt for the switch */
@@ -454,6 +877,9 @@ void InitializeSystem(void)
                 *(uint32 *)CYREG_SFLASH_DIE_Y;
                 
     printf("ID = %04x ******** \r\n\n", beaconId);
+    
+    TelemetryInit(beaconId);
+    FriendInit();
 }
 
 /******************************************************************************
@@ -479,11 +905,40 @@ int main()
 		* as possible to prevent missing of events */
 		CyMesh_ProcessEvents();
         
+        /* Start the next key derivation as soon as the previous one is done */
+        KeyJobProcess();
+        
+        if((int32)(CyMesh_TimerGetTimestamp() - nextTickTime) >= 0)
+        {
+            nextTickTime += TICK_PERIOD_MS;
+            SecondTick();
+        }
+        
+        /* Send queued log records in the background */
+        DebugLogFlush();
+        
+        #ifdef CYMESH_DEBUG_ENABLED
+            ProcessUartCommand();
+        #endif
+        
+        if(isStatsDumpRequested == true)
+        {
+            isStatsDumpRequested = false;
+            StatsDumpUart(beaconId, 0, statsCounters, STATS_COUNT);
+        }
+        
+        SendStatsReply();
+        SendFriendReply();
+        TelemetryProcess();
+        
         if(isBeaconFlagSet == true)
         {
-            SendEmptyBeacon();
+            SendEmptyBeacon(0, NULL, 0);
             isBeaconFlagSet = false;
         }
+        
+        /* Sleep until the next interrupt, unless there is more to do now */
+        PowerIdle(IsWorkPending() ? CyMesh_TimerGetTimestamp() : nextTickTime);
     }
 }
 
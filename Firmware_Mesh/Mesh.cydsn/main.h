@@ -22,14 +22,27 @@
 #include "CyMesh_Bearer.h"
 #include "CyMesh_Timer.h"
 #include "CyMesh_Configuration.h"	
+#include "CyMesh_Beacon.h"
 #include "CyMesh_Application.h"	
 #include "CyMesh_VendorSpecificModel.h"
 #include "CyMesh_LightLightnessModel.h"
+#include "debug.h"
+#include "stats.h"
+#include "telemetry.h"
+#include "commission.h"
+#include "power.h"
+#include "friend.h"
+#include "slip.h"
 	
     
 /******************************Pre-processor Directives**********************************************/
 #define CYMESHTEST_START_DIRECTLY_WITH_RELAY	(0x01)	/* This allows a device to be automatically configured without the need of Provisioning
 														*	and start directly as relay */
+#define CYMESHTEST_TRACE_ENABLED				(0x00)	/* Peripheral traffic carries a trailing trace ID byte and every forwarding
+														*	stage logs it with a timestamp. Must match MESH_TRACE_ENABLED on the
+														*	peripherals. See Tools/trace_analyser.py */
+#define CYMESHTEST_ECC_BENCHMARK				(0x00)	/* Log the SysTick cycle counts of the P-256 operations at boot, see
+														*	ecc_bench.c. Needs CYMESH_DEBUG_ENABLED for the log. */
 /**************************************Macors**************************************************/
 #define CYMESHTEST_NET_DEVICE_SRC_ADDR			((((uint16)CYBLE_SFLASH_DIE_X_REG & 0x00FF) << 8) | ((uint16)CYBLE_SFLASH_DIE_Y_REG & 0x00FF))//(0xAABB)
 #define CYMESH_NET_BROADCAST_ADDR				(0xFFFF)
@@ -38,6 +51,11 @@
 void DefineNodeinfo(void);
 void DefineAppInfo(void);
 void DefineNetInfo(void);
+void KeyJobProcess(void);
+bool KeyJobIsPending(void);
+#if (CYMESHTEST_ECC_BENCHMARK)
+void EccBenchRun(void);
+#endif
 
 #endif
 /* [] END OF FILE */
@@ -0,0 +1,118 @@
+/***************************************************************************//**
+* \file power.c
+* \version 1.0
+*
+* \brief
+*  Puts the CPU to Sleep or Deep-Sleep between main loop iterations, and counts
+*  the time spent in every power mode.
+*
+*  Every interrupt wakes the CPU: BLE events, the 1 ms mesh timer on the WDT,
+*  the switch and the UART. A relayed packet or a due mesh timer is therefore
+*  processed by the next main loop iteration, as without low power entry.
+*
+*  The residency counters are STATS_POWER_xxx, in ILO ticks. See
+*  Tools/power_estimate.py for the current consumption estimate.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include "main.h"
+
+/* ILO time at the end of the last PowerIdle() */
+static uint32 lastWakeTime = 0;
+
+
+/* Current time in ILO ticks. Call with interrupts disabled. */
+static uint32 PowerGetIloTime(void)
+{
+    return (CyMesh_TimerGetTimestamp() * POWER_ILO_TICKS_PER_MS) + CySysWdtGetCount(CY_SYS_WDT_COUNTER0);
+}
+
+
+/* The WDT counter keeps running until the mesh timer ISR clears it, so the time
+ * read just before that ISR can be slightly ahead of the time read after it. */
+static uint32 PowerGetElapsed(uint32 from, uint32 to)
+{
+    return ((int32)(to - from) > 0) ? (to - from) : 0u;
+}
+
+
+/******************************************************************************
+* Function Name: PowerIdle
+*******************************************************************************
+*
+*  Enters the deepest power mode allowed by the BLE sub-system until the next
+*  interrupt, unless the deadline is already due. Deep-Sleep requires BLESS to
+*  be in Deep-Sleep (or waking up from it) and POWER_DEEPSLEEP_ENABLED, CPU
+*  Sleep requires BLESS not to be closing a radio event. Call at the end of
+*  the main loop.
+*
+*  \param deadline: CyMesh_TimerGetTimestamp() value at which the application
+*                   has work to do. Pass the current time if work is pending.
+*
+*  \return None
+*
+******************************************************************************/
+void PowerIdle(uint32 deadline)
+{
+    CYBLE_LP_MODE_T bleMode;
+    CYBLE_BLESS_STATE_T blessState;
+    uint8 interruptStatus;
+    uint32 sleepStart;
+    uint32 sleepEnd;
+    STATS_COUNTER_T residency = STATS_POWER_ACTIVE;
+    bool isRadioIdle;
+
+    if((int32)(deadline - CyMesh_TimerGetTimestamp()) <= 0)
+    {
+        return;
+    }
+
+    /* Let the link layer sleep until its next scan or advertising event */
+    bleMode = CyBle_EnterLPM(CYBLE_BLESS_DEEPSLEEP);
+
+    interruptStatus = CyEnterCriticalSection();
+
+    blessState = CyBle_GetBleSsState();
+    isRadioIdle = (bleMode == CYBLE_BLESS_DEEPSLEEP) &&
+                  ((blessState == CYBLE_BLESS_STATE_ECO_ON) || (blessState == CYBLE_BLESS_STATE_DEEPSLEEP));
+
+    sleepStart = PowerGetIloTime();
+    statsCounters[STATS_POWER_ACTIVE] += PowerGetElapsed(lastWakeTime, sleepStart);
+
+    if((POWER_DEEPSLEEP_ENABLED != 0u) && (isRadioIdle == true))
+    {
+        residency = STATS_POWER_DEEPSLEEP;
+        CySysPmDeepSleep();
+    }
+    else if(blessState != CYBLE_BLESS_STATE_EVENT_CLOSE)
+    {
+        residency = STATS_POWER_SLEEP;
+        CySysPmSleep();
+    }
+    else
+    {
+        /* Radio event closing: go around the main loop once more */
+    }
+
+    sleepEnd = PowerGetIloTime();
+    statsCounters[residency] += PowerGetElapsed(sleepStart, sleepEnd);
+
+    if(isRadioIdle == true)
+    {
+        statsCounters[STATS_POWER_RADIO_IDLE] += PowerGetElapsed(sleepStart, sleepEnd);
+    }
+
+    if((int32)(sleepEnd - lastWakeTime) > 0)
+    {
+        lastWakeTime = sleepEnd;
+    }
+
+    CyExitCriticalSection(interruptStatus);
+}
+
+/* [] END OF FILE */
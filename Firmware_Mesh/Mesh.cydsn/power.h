@@ -0,0 +1,38 @@
+/***************************************************************************//**
+* \file power.h
+* \version 1.0
+*
+* \brief
+*  Low power entry of the mesh node main loop.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#if !defined(POWER_H)
+#define POWER_H
+
+#include <project.h>
+#include <stdbool.h>
+
+/******************************Pre-processor Directives**********************************************/
+/* The debug UART and the TCPWM blocks stop in Deep-Sleep, so debug builds only
+ * use CPU Sleep. */
+#if defined(CYMESH_DEBUG_ENABLED) || defined(CYMESH_DEBUG_ENABLED_ACK_COUNT)
+    #define POWER_DEEPSLEEP_ENABLED     (0u)
+#else
+    #define POWER_DEEPSLEEP_ENABLED     (1u)
+#endif
+
+/* The mesh timer runs on WDT counter 0 and fires every CyMesh_TimerInit() period,
+ * which is 32 ILO ticks per millisecond. */
+#define POWER_ILO_TICKS_PER_MS          (32u)
+
+/*****************************Function Declarations**************************************/
+void PowerIdle(uint32 deadline);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,134 @@
+/***************************************************************************//**
+* \file slip.c
+* \version 1.0
+*
+* \brief
+*  SLIP (RFC 1055) decoder of the debug UART commands.
+*
+*  A frame is SLIP_END, the escaped command and its CRC-16, and SLIP_END.
+*  SlipDecode() takes one byte at a time and returns the length of the command
+*  once a frame ends with a good CRC. A byte lost or corrupted on the UART
+*  costs the frame it falls in, and decoding starts again at the next
+*  SLIP_END: a command byte inside the data of a frame is never taken for the
+*  start of a command.
+*
+*  The SLIP library of the Nordic SDK in Firmware_Peripheral is not used: it
+*  encodes SLIP_END as SLIP_END + SLIP_ESC_END rather than as RFC 1055 does,
+*  and does not bound the buffer it decodes into.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include <project.h>
+#include "slip.h"
+
+
+void SlipInit(SLIP_DECODER_T * decoder, uint8 * buffer, uint8 size)
+{
+    decoder->buffer = buffer;
+    decoder->size = size;
+    decoder->length = 0u;
+    decoder->isEscaped = false;
+    decoder->isDiscarding = false;
+    decoder->dropped = 0u;
+}
+
+
+uint16 SlipCrc(const uint8 * data, uint8 length)
+{
+    uint16 crc = SLIP_CRC_INIT;
+    uint8 bit;
+
+    while(length-- != 0u)
+    {
+        crc ^= (uint16)(*data++) << 8;
+        for(bit = 0u; bit < 8u; bit++)
+        {
+            crc = ((crc & 0x8000u) != 0u) ? (uint16)((crc << 1) ^ SLIP_CRC_POLYNOMIAL) : (uint16)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+
+/* Returns the length of the command in the buffer when byte ends a good
+ * frame, 0 otherwise */
+uint8 SlipDecode(SLIP_DECODER_T * decoder, uint8 byte)
+{
+    uint8 length = 0u;
+
+    if(byte == SLIP_END)
+    {
+        if(decoder->isDiscarding == true)
+        {
+            decoder->dropped++;
+        }
+        else if(decoder->length == 0u)
+        {
+            /* Start of a frame, or the end of an empty one */
+        }
+        else if((decoder->length > SLIP_CRC_LENGTH) &&
+                (SlipCrc(decoder->buffer, decoder->length - SLIP_CRC_LENGTH) ==
+                 (decoder->buffer[decoder->length - 2u] | ((uint16)decoder->buffer[decoder->length - 1u] << 8))))
+        {
+            length = decoder->length - SLIP_CRC_LENGTH;
+        }
+        else
+        {
+            decoder->dropped++;
+        }
+
+        decoder->length = 0u;
+        decoder->isEscaped = false;
+        decoder->isDiscarding = false;
+        return length;
+    }
+
+    if(decoder->isDiscarding == true)
+    {
+        return 0u;
+    }
+
+    if(decoder->isEscaped == true)
+    {
+        decoder->isEscaped = false;
+        if(byte == SLIP_ESC_END)
+        {
+            byte = SLIP_END;
+        }
+        else if(byte == SLIP_ESC_ESC)
+        {
+            byte = SLIP_ESC;
+        }
+        else
+        {
+            decoder->isDiscarding = true;
+            return 0u;
+        }
+    }
+    else if(byte == SLIP_ESC)
+    {
+        decoder->isEscaped = true;
+        return 0u;
+    }
+    else
+    {
+        /* Data byte */
+    }
+
+    if(decoder->length == decoder->size)
+    {
+        decoder->isDiscarding = true;
+        return 0u;
+    }
+    decoder->buffer[decoder->length++] = byte;
+
+    return 0u;
+}
+
+/* [] END OF FILE */
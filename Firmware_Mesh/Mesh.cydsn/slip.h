@@ -0,0 +1,52 @@
+/***************************************************************************//**
+* \file slip.h
+* \version 1.0
+*
+* \brief
+*  SLIP (RFC 1055) decoder of the commands received on the debug UART. Each
+*  frame ends with a CRC-16 of its contents, so that a frame that lost or
+*  gained a byte on the way is dropped whole instead of being read as
+*  commands.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#if !defined(SLIP_H)
+#define SLIP_H
+
+#include <project.h>
+#include <stdbool.h>
+
+/******************************Pre-processor Directives**********************************************/
+#define SLIP_END                        (0xC0u) /* Ends a frame, and flushes the noise before one */
+#define SLIP_ESC                        (0xDBu)
+#define SLIP_ESC_END                    (0xDCu) /* SLIP_ESC + SLIP_ESC_END: SLIP_END in the data */
+#define SLIP_ESC_ESC                    (0xDDu) /* SLIP_ESC + SLIP_ESC_ESC: SLIP_ESC in the data */
+
+/* CRC-16/CCITT-FALSE of the data, little endian, at the end of each frame */
+#define SLIP_CRC_LENGTH                 (2u)
+#define SLIP_CRC_INIT                   (0xFFFFu)
+#define SLIP_CRC_POLYNOMIAL             (0x1021u)
+
+/**************************************Enums**************************************************/
+typedef struct
+{
+    uint8 * buffer;
+    uint8 size;                         /* Of buffer, CRC included */
+    uint8 length;
+    bool isEscaped;
+    bool isDiscarding;                  /* Bad escape or too long: wait for the next SLIP_END */
+    uint16 dropped;                     /* Frames dropped for their CRC, length or escape */
+} SLIP_DECODER_T;
+
+/*****************************Function Declarations**************************************/
+void SlipInit(SLIP_DECODER_T * decoder, uint8 * buffer, uint8 size);
+uint8 SlipDecode(SLIP_DECODER_T * decoder, uint8 byte);
+uint16 SlipCrc(const uint8 * data, uint8 length);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,66 @@
+/***************************************************************************//**
+* \file stats.c
+* \version 1.0
+* 
+* \brief
+*  Runtime counters of the mesh node application, and their binary UART dump.
+* 
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include "stats.h"
+#include "debug.h"
+
+uint32 statsCounters[STATS_COUNT];
+
+
+/******************************************************************************
+* Function Name: StatsDumpUart
+*******************************************************************************
+* 
+*  Writes a range of counters as one binary frame of type DBG_FRAME_STATS:
+*  node ID (2), index of the first counter (1), number of counters (1), 
+*  followed by the counters (4 each). All values are little endian.
+*  The same frame is used for the local counters and for counters received 
+*  from other nodes over the mesh.
+* 
+*  \param 
+*	nodeId: Node the counters belong to
+*   firstIndex: STATS_COUNTER_T index of counters[0]
+*   counters: Counter values
+*   count: Number of counters
+*
+*  \return None
+*  
+******************************************************************************/
+void StatsDumpUart(uint16 nodeId, uint8 firstIndex, const uint32 * counters, uint8 count)
+{
+    uint8 frame[4u + (4u * STATS_COUNT)];
+    uint8 counter;
+    
+    if(count > STATS_COUNT)
+    {
+        count = STATS_COUNT;
+    }
+    
+    frame[0] = nodeId & 0x00FF;
+    frame[1] = (nodeId >> 8) & 0x00FF;
+    frame[2] = firstIndex;
+    frame[3] = count;
+    
+    for(counter = 0; counter < count; counter++)
+    {
+        frame[4u + (4u * counter)] = (uint8) counters[counter];
+        frame[5u + (4u * counter)] = (uint8) (counters[counter] >> 8u);
+        frame[6u + (4u * counter)] = (uint8) (counters[counter] >> 16u);
+        frame[7u + (4u * counter)] = (uint8) (counters[counter] >> 24u);
+    }
+    
+    DebugWriteFrame(DBG_FRAME_STATS, frame, 4u + (4u * count));
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,77 @@
+/***************************************************************************//**
+* \file stats.h
+* \version 1.0
+* 
+* \brief
+*  Runtime counters of the mesh node application.
+* 
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#if !defined(STATS_H)
+#define STATS_H
+
+#include <project.h>
+#include <stdbool.h>
+
+/**************************************Enums**************************************************/
+/* Counter indices. The index is part of the UART dump and the mesh reply, so only 
+ * append new counters at the end and keep Tools/stats_poll.py in sync. */
+typedef enum
+{
+    /* GenericEventHandler() */
+    STATS_ADV_NOT_NON_CONN,             /* Scan result that is not a non-connectable ADV */
+    STATS_BEACON_BAD_FLAGS,             /* Flags field missing or invalid */
+    STATS_BEACON_BAD_MANUFACTURER,      /* Manufacturer data missing or not ours */
+    STATS_BEACON_BAD_LENGTH,            /* Length field does not match the packet */
+    STATS_BEACON_FROM_MESH_DEVICE,      /* Beacon sent by another mesh node */
+    STATS_BEACON_WRONG_BEACON_ID,       /* Peripheral talking to another node */
+    STATS_KEEP_ALIVE_ADDED,             /* New peripheral added to the list */
+    STATS_KEEP_ALIVE_REFRESHED,         /* Known peripheral timer refreshed */
+    STATS_KEEP_ALIVE_LIST_FULL,         /* New peripheral dropped, list full */
+    STATS_DATA_UNKNOWN_SOURCE,          /* Data from a peripheral not in the list */
+    STATS_DATA_IN_RANGE,                /* "Destination in range", mesh skipped */
+    STATS_DATA_TO_MESH,                 /* Data forwarded to the mesh */
+    
+    /* MeshEventHandler() */
+    STATS_MESH_STACK_ON,                /* CYMESH_EVT_STACK_ON */
+    STATS_MESH_RX_TO_PERIPHERAL,        /* Mesh data sent to a peripheral in range */
+    STATS_MESH_RX_DROPPED,              /* Mesh data for a peripheral not in range */
+    STATS_MESH_OTHER_EVENT,             /* Any other mesh event */
+    
+    /* SecondTick() */
+    STATS_DEVICE_EXPIRED,               /* Peripheral removed after timeout */
+    
+    /* Bearer */
+    STATS_BEARER_TX_FULL,               /* Packet rejected because the bearer TX buffer was full */
+    
+    /* PowerIdle(), residency in ILO ticks */
+    STATS_POWER_ACTIVE,                 /* CPU active */
+    STATS_POWER_SLEEP,                  /* CPU Sleep */
+    STATS_POWER_DEEPSLEEP,              /* Deep-Sleep */
+    STATS_POWER_RADIO_IDLE,             /* BLESS in Deep-Sleep while the CPU slept */
+    
+    /* Friend cache of the polling peripherals, see friend.c */
+    STATS_FRIEND_POLL,                  /* Poll received from a peripheral in the list */
+    STATS_FRIEND_CACHED,                /* Mesh data cached for a polling peripheral */
+    STATS_FRIEND_DELIVERED,             /* Cached data sent in reply to a poll */
+    STATS_FRIEND_DROPPED,               /* Cached data evicted, too long, or of an expired peripheral */
+    
+    STATS_COUNT
+} STATS_COUNTER_T;
+
+/*************************************Macros**************************************************/
+#define STATS_INCREMENT(counter)        (statsCounters[(counter)]++)
+
+/*************************************Globals*************************************************/
+extern uint32 statsCounters[STATS_COUNT];
+
+/*****************************Function Declarations**************************************/
+void StatsDumpUart(uint16 nodeId, uint8 firstIndex, const uint32 * counters, uint8 count);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,468 @@
+/***************************************************************************//**
+* \file telemetry.c
+* \version 1.0
+*
+* \brief
+*  Fleet telemetry with in-network aggregation.
+*
+*  The sink (the node on the host UART) announces depth 0 with
+*  OPCODE_TELEMETRY_ROUTE. Every node adopts the neighbour with the lowest
+*  depth as its parent and announces its own depth, which builds a tree rooted
+*  at the sink. All telemetry messages are sent with TTL 1, so they are never
+*  relayed by the mesh.
+*
+*  Every TELEMETRY_PERIOD_S a node sends one OPCODE_TELEMETRY_REPORT per field
+*  to its parent: the change of its own counters since the last report, merged
+*  with the reports its children sent in the meantime. The sink writes the
+*  merged values to the UART. Each hop adds up to one period of latency, and
+*  the sink receives one report per field from each of its children instead
+*  of one per node.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#include "main.h"
+#include "CyMesh_MessageQueue.h"
+
+#define TELEMETRY_MERGE_SUM             (0u)
+#define TELEMETRY_MERGE_MAX             (1u)
+
+#define TELEMETRY_VALUE_MAX             (0x00FFFFFFu)   /* Values are sent as 3 bytes */
+#define TELEMETRY_NODES_MAX             (0xFFu)
+
+#define TELEMETRY_ROUTE_LENGTH          (5u)
+#define TELEMETRY_REPORT_LENGTH         (7u)
+#define TELEMETRY_FRAME_LENGTH          (8u)
+
+typedef struct
+{
+    STATS_COUNTER_T counter;
+    uint8 merge;
+} TELEMETRY_FIELD_T;
+
+typedef struct
+{
+    uint32 value;
+    uint8 nodes;        /* Number of node reports merged into value */
+} TELEMETRY_VALUE_T;
+
+/* Indexed by TELEMETRY_FIELD_ID_T */
+static const TELEMETRY_FIELD_T telemetryFields[TELEMETRY_FIELD_COUNT] =
+{
+    {STATS_DATA_TO_MESH,            TELEMETRY_MERGE_SUM},
+    {STATS_MESH_RX_TO_PERIPHERAL,   TELEMETRY_MERGE_SUM},
+    {STATS_MESH_RX_DROPPED,         TELEMETRY_MERGE_SUM},
+    {STATS_BEARER_TX_FULL,          TELEMETRY_MERGE_SUM},
+    {STATS_BEARER_TX_FULL,          TELEMETRY_MERGE_MAX},
+};
+
+static uint16 telemetryNodeId;
+static bool isTelemetrySink = false;
+
+/* Route towards the sink */
+static uint8 telemetryDepth = TELEMETRY_DEPTH_NONE;
+static uint16 telemetryParentId;
+static bool isRouteHoldDown = false;
+static bool isRouteAnnouncePending = false;
+
+/* Seconds since start, incremented by TelemetryTick() */
+static uint16 telemetrySeconds = 0;
+static uint16 lastReportTime;
+static uint16 lastRouteTime;
+static uint16 lastParentTime;
+static uint16 holdDownTime;
+
+/* Counter values at the last report, to send deltas only */
+static uint32 telemetryBaseline[TELEMETRY_FIELD_COUNT];
+/* Reports received from the subtree since the last report */
+static TELEMETRY_VALUE_T telemetryPending[TELEMETRY_FIELD_COUNT];
+/* Report being sent, one field per TelemetryProcess() call */
+static TELEMETRY_VALUE_T telemetryOutgoing[TELEMETRY_FIELD_COUNT];
+static uint8 telemetryOutgoingIndex = TELEMETRY_FIELD_COUNT;
+
+
+static void TelemetryMerge(TELEMETRY_VALUE_T * into, uint8 field, uint32 value, uint8 nodes)
+{
+    if(telemetryFields[field].merge == TELEMETRY_MERGE_MAX)
+    {
+        if(value > into->value)
+        {
+            into->value = value;
+        }
+    }
+    else
+    {
+        into->value += value;
+    }
+
+    if(into->value > TELEMETRY_VALUE_MAX)
+    {
+        into->value = TELEMETRY_VALUE_MAX;
+    }
+
+    into->nodes = ((uint16)into->nodes + nodes > TELEMETRY_NODES_MAX) ? TELEMETRY_NODES_MAX : (into->nodes + nodes);
+}
+
+
+/* Merge the local deltas with the pending subtree reports, and start over */
+static void TelemetrySnapshot(TELEMETRY_VALUE_T * snapshot)
+{
+    uint8 field;
+
+    for(field = 0; field < TELEMETRY_FIELD_COUNT; field++)
+    {
+        uint32 current = statsCounters[telemetryFields[field].counter];
+
+        snapshot[field] = telemetryPending[field];
+        TelemetryMerge(&snapshot[field], field, current - telemetryBaseline[field], 1);
+
+        telemetryBaseline[field] = current;
+        telemetryPending[field].value = 0;
+        telemetryPending[field].nodes = 0;
+    }
+}
+
+
+/* Send a node level message to the direct neighbours only */
+static void TelemetrySend(uint8 opcode, const uint8 * data, uint8 length)
+{
+    CYMESH_VARIABLE_DATA_T packet;
+
+    packet.data[0] = opcode;
+    memcpy(&packet.data[1], data, length);
+    packet.len = length + 1;
+
+    /* A TTL of 1 is accepted by the neighbours, but not relayed any further.
+     * The vendor model would send with the TTL of its configuration. */
+    CyMesh_TxMessageQueueSetNextTtl(CYMESH_TTL_MIN);
+    CyMesh_VendorSpecificSendDataUnreliable(packet,
+                                            CYMESH_MDL_VENDOR_SPECIFIC_COMP_3,
+                                            CYMESH_MDL_VENDOR_SPECIFIC_COMP_3_MDLIDX);
+    CyMesh_TxMessageQueueSetNextTtl(CYMESH_TX_MESSAGE_Q_TTL_MODEL);
+}
+
+
+static void TelemetrySendRoute(void)
+{
+    uint8 data[TELEMETRY_ROUTE_LENGTH];
+
+    data[0] = telemetryNodeId & 0x00FF;
+    data[1] = (telemetryNodeId >> 8) & 0x00FF;
+    data[2] = CYMESH_NET_BROADCAST_ADDR & 0x00FF;
+    data[3] = (CYMESH_NET_BROADCAST_ADDR >> 8) & 0x00FF;
+    data[4] = telemetryDepth;
+
+    TelemetrySend(OPCODE_TELEMETRY_ROUTE, data, sizeof(data));
+}
+
+
+static void TelemetrySendReport(uint8 field)
+{
+    uint8 data[TELEMETRY_REPORT_LENGTH];
+    uint32 value = telemetryOutgoing[field].value;
+
+    data[0] = telemetryParentId & 0x00FF;
+    data[1] = (telemetryParentId >> 8) & 0x00FF;
+    data[2] = field;
+    data[3] = telemetryOutgoing[field].nodes;
+    data[4] = value & 0x000000FF;
+    data[5] = (value >> 8) & 0x000000FF;
+    data[6] = (value >> 16) & 0x000000FF;
+
+    TelemetrySend(OPCODE_TELEMETRY_REPORT, data, sizeof(data));
+}
+
+
+/* Write the merged fleet values as DBG_FRAME_TELEMETRY frames: sink ID (2),
+ * field (1), nodes (1), value (4), little endian */
+static void TelemetryDumpUart(const TELEMETRY_VALUE_T * snapshot)
+{
+    uint8 frame[TELEMETRY_FRAME_LENGTH];
+    uint8 field;
+
+    for(field = 0; field < TELEMETRY_FIELD_COUNT; field++)
+    {
+        frame[0] = telemetryNodeId & 0x00FF;
+        frame[1] = (telemetryNodeId >> 8) & 0x00FF;
+        frame[2] = field;
+        frame[3] = snapshot[field].nodes;
+        frame[4] = (uint8) snapshot[field].value;
+        frame[5] = (uint8) (snapshot[field].value >> 8u);
+        frame[6] = (uint8) (snapshot[field].value >> 16u);
+        frame[7] = (uint8) (snapshot[field].value >> 24u);
+
+        DebugWriteFrame(DBG_FRAME_TELEMETRY, frame, sizeof(frame));
+    }
+}
+
+
+/******************************************************************************
+* Function Name: TelemetryInit
+*******************************************************************************
+*
+*  Starts the telemetry with the current counters as the baseline.
+*
+*  \param nodeId: ID of this node, as used in node level messages
+*
+*  \return None
+*
+******************************************************************************/
+void TelemetryInit(uint16 nodeId)
+{
+    uint8 field;
+
+    telemetryNodeId = nodeId;
+
+    for(field = 0; field < TELEMETRY_FIELD_COUNT; field++)
+    {
+        telemetryBaseline[field] = statsCounters[telemetryFields[field].counter];
+    }
+
+    lastReportTime = telemetrySeconds;
+    lastRouteTime = telemetrySeconds;
+}
+
+
+/******************************************************************************
+* Function Name: TelemetrySetSink
+*******************************************************************************
+*
+*  Makes this node the root of the telemetry tree, or a normal node again.
+*
+*  \param isSink: true if the merged values go to the UART of this node
+*
+*  \return None
+*
+******************************************************************************/
+void TelemetrySetSink(bool isSink)
+{
+    isTelemetrySink = isSink;
+    isRouteHoldDown = false;
+    telemetryOutgoingIndex = TELEMETRY_FIELD_COUNT;
+
+    if(isSink == true)
+    {
+        telemetryDepth = 0;
+        isRouteAnnouncePending = true;
+    }
+    else
+    {
+        telemetryDepth = TELEMETRY_DEPTH_NONE;
+        isRouteAnnouncePending = false;
+    }
+}
+
+
+/******************************************************************************
+* Function Name: TelemetryTick
+*******************************************************************************
+*
+*  Advances the telemetry clock. Call once per second from the main loop.
+*
+*  \param None
+*
+*  \return None
+*
+******************************************************************************/
+void TelemetryTick(void)
+{
+    telemetrySeconds++;
+}
+
+
+/******************************************************************************
+* Function Name: TelemetryProcess
+*******************************************************************************
+*
+*  Runs the route and report timers and sends at most one telemetry message,
+*  only if the bearer TX buffer has room. Call from the main loop.
+*
+*  \param None
+*
+*  \return None
+*
+******************************************************************************/
+void TelemetryProcess(void)
+{
+    uint16 now = telemetrySeconds;
+
+    if((isTelemetrySink == false) && (telemetryDepth != TELEMETRY_DEPTH_NONE) &&
+       ((uint16)(now - lastParentTime) >= TELEMETRY_ROUTE_TIMEOUT_S))
+    {
+        /* Stay without a route until our children noticed it too, so that
+         * none of them can become our parent */
+        DBG_LOG1("Telemetry parent %04x lost\r\n", telemetryParentId);
+        telemetryDepth = TELEMETRY_DEPTH_NONE;
+        isRouteHoldDown = true;
+        holdDownTime = now;
+    }
+
+    if((isRouteHoldDown == true) && ((uint16)(now - holdDownTime) >= TELEMETRY_ROUTE_TIMEOUT_S))
+    {
+        isRouteHoldDown = false;
+    }
+
+    if((telemetryDepth != TELEMETRY_DEPTH_NONE) && ((uint16)(now - lastRouteTime) >= TELEMETRY_ROUTE_PERIOD_S))
+    {
+        lastRouteTime = now;
+        isRouteAnnouncePending = true;
+    }
+
+    if((uint16)(now - lastReportTime) >= TELEMETRY_PERIOD_S)
+    {
+        lastReportTime = now;
+
+        if(isTelemetrySink == true)
+        {
+            TELEMETRY_VALUE_T snapshot[TELEMETRY_FIELD_COUNT];
+
+            TelemetrySnapshot(snapshot);
+            TelemetryDumpUart(snapshot);
+        }
+        else if((telemetryDepth != TELEMETRY_DEPTH_NONE) && (telemetryOutgoingIndex >= TELEMETRY_FIELD_COUNT))
+        {
+            TelemetrySnapshot(telemetryOutgoing);
+            telemetryOutgoingIndex = 0;
+        }
+        else
+        {
+            /* No route or previous report still going: the deltas keep
+             * growing until the next period */
+        }
+    }
+
+    /* Don't compete with relayed traffic for the last TX buffers */
+    if(CyMesh_BearerGetTxBufferStatus() >= CYMESH_BEARER_TX_BUFFER_BUSY)
+    {
+        return;
+    }
+
+    if(isRouteAnnouncePending == true)
+    {
+        isRouteAnnouncePending = false;
+        TelemetrySendRoute();
+    }
+    else if((telemetryOutgoingIndex < TELEMETRY_FIELD_COUNT) && (telemetryDepth != TELEMETRY_DEPTH_NONE))
+    {
+        TelemetrySendReport(telemetryOutgoingIndex);
+        telemetryOutgoingIndex++;
+    }
+    else
+    {
+        /* Nothing to send */
+    }
+}
+
+
+/******************************************************************************
+* Function Name: TelemetryIsTxPending
+*******************************************************************************
+*
+*  Tells if TelemetryProcess() has a message to send.
+*
+*  \param None
+*
+*  \return bool: true if a route announcement or a report is waiting
+*
+******************************************************************************/
+bool TelemetryIsTxPending(void)
+{
+    return (isRouteAnnouncePending == true) ||
+           ((telemetryOutgoingIndex < TELEMETRY_FIELD_COUNT) && (telemetryDepth != TELEMETRY_DEPTH_NONE));
+}
+
+
+/******************************************************************************
+* Function Name: TelemetryHandleMessage
+*******************************************************************************
+*
+*  Handles OPCODE_TELEMETRY_ROUTE and OPCODE_TELEMETRY_REPORT received from
+*  the mesh.
+*
+*  \param
+*	data: Vendor model data, starting with the opcode
+*   length: Length of data
+*
+*  \return None
+*
+******************************************************************************/
+void TelemetryHandleMessage(const uint8 * data, uint8 length)
+{
+    switch(data[0])
+    {
+        case OPCODE_TELEMETRY_ROUTE:
+        {
+            uint16 incomingSourceId;
+            uint8 incomingDepth;
+
+            if(length < (TELEMETRY_ROUTE_LENGTH + 1))
+            {
+                break;
+            }
+
+            incomingSourceId = (data[2] << 8) | data[1];
+            incomingDepth = data[5];
+            if((isTelemetrySink == true) || (isRouteHoldDown == true) || (incomingDepth >= TELEMETRY_MAX_DEPTH))
+            {
+                break;
+            }
+
+            if((telemetryDepth != TELEMETRY_DEPTH_NONE) && (incomingSourceId == telemetryParentId))
+            {
+                telemetryDepth = incomingDepth + 1;
+                lastParentTime = telemetrySeconds;
+            }
+            else if((telemetryDepth == TELEMETRY_DEPTH_NONE) || ((incomingDepth + 1) < telemetryDepth))
+            {
+                if(telemetryDepth == TELEMETRY_DEPTH_NONE)
+                {
+                    /* Let the subtree hear about the new route right away */
+                    isRouteAnnouncePending = true;
+                    lastRouteTime = telemetrySeconds;
+                }
+
+                DBG_LOG2("Telemetry parent %04x, depth %d\r\n", incomingSourceId, incomingDepth + 1);
+                telemetryParentId = incomingSourceId;
+                telemetryDepth = incomingDepth + 1;
+                lastParentTime = telemetrySeconds;
+            }
+            else
+            {
+                /* Not a better route */
+            }
+            break;
+        }
+
+        case OPCODE_TELEMETRY_REPORT:
+        {
+            uint16 incomingDestinationId;
+            uint8 field;
+
+            if(length < (TELEMETRY_REPORT_LENGTH + 1))
+            {
+                break;
+            }
+
+            /* Reports to our neighbours are overheard as well */
+            incomingDestinationId = (data[2] << 8) | data[1];
+            field = data[3];
+            if((incomingDestinationId != telemetryNodeId) || (field >= TELEMETRY_FIELD_COUNT))
+            {
+                break;
+            }
+
+            TelemetryMerge(&telemetryPending[field], field,
+                           ((uint32)data[7] << 16) | ((uint32)data[6] << 8) | data[5], data[4]);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+/* [] END OF FILE */
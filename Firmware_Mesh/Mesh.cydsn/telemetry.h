@@ -0,0 +1,58 @@
+/***************************************************************************//**
+* \file telemetry.h
+* \version 1.0
+*
+* \brief
+*  Fleet telemetry over the vendor specific model. Nodes report counter deltas
+*  to a parent one hop closer to the sink, and every parent merges the reports
+*  of its subtree into its own before forwarding them.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+#if !defined(TELEMETRY_H)
+#define TELEMETRY_H
+
+#include <project.h>
+#include <stdbool.h>
+
+/******************************Pre-processor Directives**********************************************/
+#define TELEMETRY_PERIOD_S              (30u)   /* Report period of every node */
+#define TELEMETRY_ROUTE_PERIOD_S        (10u)   /* Route announcement period */
+#define TELEMETRY_ROUTE_TIMEOUT_S       (3u * TELEMETRY_ROUTE_PERIOD_S)    /* Parent lost after this */
+#define TELEMETRY_MAX_DEPTH             (31u)
+#define TELEMETRY_DEPTH_NONE            (0xFFu)
+
+/* Node level opcodes, see OPCODE_NODE_MAX in main.c. Both are sent with TTL 1. */
+#define OPCODE_TELEMETRY_ROUTE          (0x03)  /* Source ID (2) + Destination ID (2, broadcast) + Depth (1) */
+#define OPCODE_TELEMETRY_REPORT         (0x04)  /* Parent ID (2) + Field (1) + Nodes (1) + Value (3) */
+
+/**************************************Enums**************************************************/
+/* Reported fields. The index is part of the report and of the UART frame, so only
+ * append new fields at the end and keep Tools/telemetry_sim.py and
+ * Tools/log_decoder.py in sync. */
+typedef enum
+{
+    TELEMETRY_DATA_TO_MESH,             /* Sum of STATS_DATA_TO_MESH */
+    TELEMETRY_MESH_RX_TO_PERIPHERAL,    /* Sum of STATS_MESH_RX_TO_PERIPHERAL */
+    TELEMETRY_MESH_RX_DROPPED,          /* Sum of STATS_MESH_RX_DROPPED */
+    TELEMETRY_BEARER_TX_FULL,           /* Sum of STATS_BEARER_TX_FULL */
+    TELEMETRY_BEARER_TX_FULL_MAX,       /* Worst single node STATS_BEARER_TX_FULL */
+
+    TELEMETRY_FIELD_COUNT
+} TELEMETRY_FIELD_ID_T;
+
+/*****************************Function Declarations**************************************/
+void TelemetryInit(uint16 nodeId);
+void TelemetrySetSink(bool isSink);
+void TelemetryTick(void);
+void TelemetryProcess(void);
+bool TelemetryIsTxPending(void);
+void TelemetryHandleMessage(const uint8 * data, uint8 length);
+
+#endif
+/* [] END OF FILE */
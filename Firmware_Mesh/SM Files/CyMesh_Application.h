@@ -139,6 +139,22 @@ typedef struct
     /*==========================================*/
 } CYMESH_APP_RELIABLE_MSG_TIMEOUT_PARAM_T;
 
+/* Parameter of CYMESH_EVT_RELIABLE_MESSAGE_COMPLETE */
+typedef struct
+{
+    uint32 opcode;
+    uint16 dstAddress;
+    
+    /* Time from the last transmission to the response, in ms */
+    uint32 rtt;
+    
+    /* Times the message was sent; the RTT is only sampled if once */
+    uint8 transmissions;
+    
+    /* Timeout of the next message to dstAddress, in ms */
+    uint32 rto;
+} CYMESH_APP_RELIABLE_MSG_COMPLETE_PARAM_T;
+
 
 /*******************************************************************************
 * Variable Declarations
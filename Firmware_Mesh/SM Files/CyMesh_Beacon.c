@@ -0,0 +1,623 @@
+/***************************************************************************//**
+* \file CyMesh_Beacon.c
+* \version 1.0
+*
+* \brief
+*  This file contains the secure network beacon manager of the BLE SmartMesh v1
+*  solution.
+*
+*  The authentication value of a secure network beacon is the AES-CMAC, with
+*  the encryption key of the network, of Flags + Network ID + IV index. The
+*  message is a single padded block, so once the CMAC subkey of the key is
+*  known every value costs one AES block; CyMesh_SecurityPVTAesEncrypt() runs
+*  it in place, instead of the AES-CMAC state machine of the security module.
+*
+*  Authenticated (flags, IV index) tuples of mesh 0 are kept with their value
+*  in a small cache. Two of them are the node's own: the beacon it sends in
+*  the current IV update state, and the beacon of the state that follows.
+*  CyMesh_BeaconUpdate() calculates whichever of the two is missing, one per
+*  SM tick, so that moving to the next state never waits for a CMAC. The other
+*  entries hold the beacons last received from neighbours, which repeat the
+*  same tuple every beacon interval: these are checked by comparing the
+*  authentication value with the cached one.
+*
+*  The library calculates the value of the node with a blocking loop around
+*  CyMesh_SecurityCalculateBeaconAuthValue() when its credentials change. With
+*  -Wl,--wrap=CyMesh_SecurityCalculateBeaconAuthValue the value comes from the
+*  cache and the callback runs before the call returns, so the loop does not
+*  spin. Received beacons reach CyMesh_ConfigurationIncomingBeacon(), which is
+*  empty in the library; -Wl,--wrap=CyMesh_ConfigurationIncomingBeacon passes
+*  them to CyMesh_BeaconReceive().
+*
+*  CyMesh_BeaconUpdate() runs in the SM timer interrupt, and the other
+*  functions in the main loop. These change the cache and the IV update state
+*  inside a critical section; a received beacon that is not cached has its
+*  value calculated before, so that the interrupts are not held for the AES.
+*
+*  There is one network key, so the key refresh flag is always 0, and the
+*  library transmits and receives with a single IV index. The IV update state
+*  is not saved: after a reset the node starts in the normal state with the IV
+*  index of cyMesh_ConfigInfoRam.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <string.h>
+#include "CyMesh_Beacon.h"
+#include "CyMesh_Configuration.h"
+#include "CyMesh_Security.h"
+#include "CyMesh_SecurityPVT.h"
+
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+#define CYMESH_BEACON_MESH_ID                   (0u)
+#define CYMESH_BEACON_BLOCK_SIZE                (16u)
+
+/* Flags (1) + Network ID (8) + IV index (4) */
+#define CYMESH_BEACON_MESSAGE_LENGTH            (13u)
+
+/* Offsets in the secure network beacon */
+#define CYMESH_BEACON_OFFSET_FLAGS              (1u)
+#define CYMESH_BEACON_OFFSET_NETWORK_ID         (2u)
+#define CYMESH_BEACON_OFFSET_IV_INDEX           (10u)
+#define CYMESH_BEACON_OFFSET_AUTH_VALUE         (14u)
+
+/* AES-CMAC subkey generation, RFC 4493 */
+#define CYMESH_BEACON_CMAC_RB                   (0x87u)
+
+#define CYMESH_BEACON_BEARER_TX_COUNT           (1u)
+
+
+
+/*******************************************************************************
+* Data Structures
+*******************************************************************************/
+typedef struct
+{
+    uint32 ivIndex;
+    uint32 lastUse;
+    uint8 flags;
+    bool isValid;
+    uint8 authValue[CYMESH_BEACON_AUTH_VALUE_SIZE];
+} CYMESH_BEACON_ENTRY_T;
+
+/* Value of the node, read by the library when it sends a beacon */
+extern uint8 cyMesh_ConfigurationBeaconCalculatedAuthValue[CYMESH_BEACON_AUTH_VALUE_SIZE];
+
+/* The library versions */
+extern CYMESH_API_RETURN_T __real_CyMesh_SecurityCalculateBeaconAuthValue(uint8 meshId, uint8 krBit, uint32 ivIndex,
+                                                                          CYMESH_SECURITY_CALLBACK callback);
+extern void __real_CyMesh_ConfigurationIncomingBeacon(uint32 event, CYMESH_BEARER_RX_BUFFER_T * rxBuffer);
+
+/* Set to save cyMesh_ConfigInfoRam on the next update */
+extern uint8 CyMesh_ConfigInfoFlashUpdateRequired;
+
+CYMESH_BEACON_STATS_T cyMesh_BeaconStats;
+
+static struct
+{
+    CYMESH_BEACON_ENTRY_T cache[CYMESH_BEACON_CACHE_SIZE];
+
+    /* Copies of the network, taken at start */
+    uint8 key[CYMESH_BEACON_BLOCK_SIZE];
+    uint8 subkey[CYMESH_BEACON_BLOCK_SIZE];
+    uint8 networkId[CYMESH_BEACON_NETWORK_ID_SIZE];
+
+    /* IV index in the beacon of the node */
+    uint32 ivIndex;
+
+    /* ms since start, ms in the IV update state, ms to the next beacon */
+    uint32 time;
+    uint32 stateTime;
+    uint32 beaconCountdown;
+
+    CYMESH_BEACON_IV_STATE_T ivState;
+    bool isStarted;
+    bool isUpdateRequested;
+
+    /* Set once the value of the current state is given to the library */
+    bool isPublished;
+} beacon;
+
+
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+static void CyMesh_BeaconShiftLeft(const uint8 * input, uint8 * output)
+{
+    uint8 carry = 0u;
+    int8 i;
+
+    for(i = (int8)CYMESH_BEACON_BLOCK_SIZE - 1; i >= 0; i--)
+    {
+        uint8 msb = input[i] >> 7;
+
+        output[i] = (uint8)(input[i] << 1) | carry;
+        carry = msb;
+    }
+}
+
+
+/* K2 of RFC 4493, for a last block that needs padding */
+static void CyMesh_BeaconGenerateSubkey(void)
+{
+    uint8 block[CYMESH_BEACON_BLOCK_SIZE];
+    uint8 i;
+
+    memset(block, 0, sizeof(block));
+    (void)CyMesh_SecurityPVTAesEncrypt(block, beacon.key, block);
+
+    for(i = 0u; i < 2u; i++)
+    {
+        bool isMsbSet = ((block[0] & 0x80u) != 0u);
+
+        CyMesh_BeaconShiftLeft(block, beacon.subkey);
+        if(isMsbSet == true)
+        {
+            beacon.subkey[CYMESH_BEACON_BLOCK_SIZE - 1u] ^= CYMESH_BEACON_CMAC_RB;
+        }
+        memcpy(block, beacon.subkey, sizeof(block));
+    }
+}
+
+
+static void CyMesh_BeaconCalculate(uint8 flags, uint32 ivIndex, uint8 * authValue)
+{
+    uint8 block[CYMESH_BEACON_BLOCK_SIZE];
+    uint8 i;
+
+    block[0] = flags;
+    memcpy(&block[1], beacon.networkId, CYMESH_BEACON_NETWORK_ID_SIZE);
+    block[9] = (uint8)(ivIndex >> 24);
+    block[10] = (uint8)(ivIndex >> 16);
+    block[11] = (uint8)(ivIndex >> 8);
+    block[12] = (uint8)ivIndex;
+    block[CYMESH_BEACON_MESSAGE_LENGTH] = 0x80u;
+    block[CYMESH_BEACON_MESSAGE_LENGTH + 1u] = 0x00u;
+    block[CYMESH_BEACON_MESSAGE_LENGTH + 2u] = 0x00u;
+
+    for(i = 0u; i < CYMESH_BEACON_BLOCK_SIZE; i++)
+    {
+        block[i] ^= beacon.subkey[i];
+    }
+
+    (void)CyMesh_SecurityPVTAesEncrypt(block, beacon.key, block);
+    memcpy(authValue, block, CYMESH_BEACON_AUTH_VALUE_SIZE);
+    cyMesh_BeaconStats.cmacCount++;
+}
+
+
+static uint8 CyMesh_BeaconCurrentFlags(void)
+{
+    return (beacon.ivState == CYMESH_BEACON_IV_UPDATE_IN_PROGRESS) ? CYMESH_BEACON_FLAG_IV_UPDATE : 0u;
+}
+
+
+/* The state after the current one: IV index + 1 in progress, or back to
+ * normal with the same IV index */
+static uint8 CyMesh_BeaconNextFlags(void)
+{
+    return (beacon.ivState == CYMESH_BEACON_IV_NORMAL) ? CYMESH_BEACON_FLAG_IV_UPDATE : 0u;
+}
+
+
+static uint32 CyMesh_BeaconNextIvIndex(void)
+{
+    return (beacon.ivState == CYMESH_BEACON_IV_NORMAL) ? (beacon.ivIndex + 1u) : beacon.ivIndex;
+}
+
+
+static bool CyMesh_BeaconIsPinned(const CYMESH_BEACON_ENTRY_T * entry)
+{
+    return (((entry->flags == CyMesh_BeaconCurrentFlags()) && (entry->ivIndex == beacon.ivIndex)) ||
+            ((entry->flags == CyMesh_BeaconNextFlags()) && (entry->ivIndex == CyMesh_BeaconNextIvIndex())));
+}
+
+
+static CYMESH_BEACON_ENTRY_T * CyMesh_BeaconFind(uint8 flags, uint32 ivIndex)
+{
+    uint8 i;
+
+    for(i = 0u; i < CYMESH_BEACON_CACHE_SIZE; i++)
+    {
+        CYMESH_BEACON_ENTRY_T * entry = &beacon.cache[i];
+
+        if((entry->isValid == true) && (entry->flags == flags) && (entry->ivIndex == ivIndex))
+        {
+            entry->lastUse = beacon.time;
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+
+/* Takes a free entry, or the least recently used one that is not the node's */
+static void CyMesh_BeaconInsert(uint8 flags, uint32 ivIndex, const uint8 * authValue)
+{
+    CYMESH_BEACON_ENTRY_T * victim = NULL;
+    uint8 i;
+
+    for(i = 0u; i < CYMESH_BEACON_CACHE_SIZE; i++)
+    {
+        CYMESH_BEACON_ENTRY_T * entry = &beacon.cache[i];
+
+        if(entry->isValid == false)
+        {
+            victim = entry;
+            break;
+        }
+
+        if((CyMesh_BeaconIsPinned(entry) == false) &&
+           ((victim == NULL) || ((uint32)(beacon.time - entry->lastUse) > (uint32)(beacon.time - victim->lastUse))))
+        {
+            victim = entry;
+        }
+    }
+
+    /* Not reached: there are at least three entries and two are pinned */
+    if(victim == NULL)
+    {
+        return;
+    }
+
+    victim->flags = flags;
+    victim->ivIndex = ivIndex;
+    victim->lastUse = beacon.time;
+    victim->isValid = true;
+    memcpy(victim->authValue, authValue, CYMESH_BEACON_AUTH_VALUE_SIZE);
+}
+
+
+static const uint8 * CyMesh_BeaconGetAuthValue(uint8 flags, uint32 ivIndex)
+{
+    CYMESH_BEACON_ENTRY_T * entry = CyMesh_BeaconFind(flags, ivIndex);
+    uint8 authValue[CYMESH_BEACON_AUTH_VALUE_SIZE];
+
+    if(entry == NULL)
+    {
+        CyMesh_BeaconCalculate(flags, ivIndex, authValue);
+        CyMesh_BeaconInsert(flags, ivIndex, authValue);
+        entry = CyMesh_BeaconFind(flags, ivIndex);
+    }
+
+    return entry->authValue;
+}
+
+
+static void CyMesh_BeaconPublish(void)
+{
+    const CYMESH_BEACON_ENTRY_T * entry = CyMesh_BeaconFind(CyMesh_BeaconCurrentFlags(), beacon.ivIndex);
+
+    if(entry != NULL)
+    {
+        memcpy(cyMesh_ConfigurationBeaconCalculatedAuthValue, entry->authValue, CYMESH_BEACON_AUTH_VALUE_SIZE);
+        beacon.isPublished = true;
+    }
+}
+
+
+/* The library sends with the IV index of the beacon, except during an update
+ * in progress, when it still sends with the previous one */
+static void CyMesh_BeaconSetIvState(CYMESH_BEACON_IV_STATE_T ivState, uint32 ivIndex)
+{
+    uint32 libraryIvIndex = (ivState == CYMESH_BEACON_IV_UPDATE_IN_PROGRESS) ? (ivIndex - 1u) : ivIndex;
+
+    beacon.ivState = ivState;
+    beacon.ivIndex = ivIndex;
+    beacon.stateTime = 0u;
+
+    if(CyMesh_SecurityGetIVindex(CYMESH_BEACON_MESH_ID) != libraryIvIndex)
+    {
+        CyMesh_SecuritySetIVindex(CYMESH_BEACON_MESH_ID, libraryIvIndex);
+        cyMesh_ConfigInfoRam.netInfo.netKeys[CYMESH_BEACON_MESH_ID].ivIndex = libraryIvIndex;
+        CyMesh_ConfigInfoFlashUpdateRequired = 1u;
+    }
+
+    /* Ready unless the state was not the next one */
+    CyMesh_BeaconPublish();
+}
+
+
+#if (CYMESH_CONFIG_ENABLE_SECURE_NETWORK_BEACON == 1)
+static void CyMesh_BeaconSend(void)
+{
+    uint8 pdu[CYMESH_BEACON_SECURE_LENGTH];
+
+    if(CyMesh_BeaconGetSecureBeacon(pdu) == true)
+    {
+        (void)CyMesh_BearerSendData(pdu, CYMESH_BEACON_SECURE_LENGTH, CYMESH_BEARER_BEACON_SECURE_NETWORK,
+                                    CYMESH_BEACON_BEARER_TX_COUNT, false, false);
+    }
+}
+#endif /* (CYMESH_CONFIG_ENABLE_SECURE_NETWORK_BEACON == 1) */
+
+
+
+/*******************************************************************************
+* Public functions
+*******************************************************************************/
+void CyMesh_BeaconStart(void)
+{
+    const CYMESH_NETWORK_KEYS_T * netKey = &cyMesh_ConfigInfoRam.netInfo.netKeys[CYMESH_BEACON_MESH_ID];
+    uint8 interruptState = CyEnterCriticalSection();
+
+    memset(beacon.cache, 0, sizeof(beacon.cache));
+    memcpy(beacon.key, netKey->encryptionKey, CYMESH_BEACON_BLOCK_SIZE);
+    memcpy(beacon.networkId, netKey->networkId, CYMESH_BEACON_NETWORK_ID_SIZE);
+    CyMesh_BeaconGenerateSubkey();
+
+    beacon.isStarted = true;
+    beacon.isUpdateRequested = false;
+    beacon.beaconCountdown = 0u;
+    CyMesh_BeaconSetIvState(CYMESH_BEACON_IV_NORMAL, CyMesh_SecurityGetIVindex(CYMESH_BEACON_MESH_ID));
+
+    CyExitCriticalSection(interruptState);
+}
+
+
+void CyMesh_BeaconUpdate(void)
+{
+    if(beacon.isStarted == false)
+    {
+        return;
+    }
+
+    beacon.time++;
+    beacon.stateTime++;
+
+    /* One value per tick: the current state first, then the next one */
+    if(CyMesh_BeaconFind(CyMesh_BeaconCurrentFlags(), beacon.ivIndex) == NULL)
+    {
+        (void)CyMesh_BeaconGetAuthValue(CyMesh_BeaconCurrentFlags(), beacon.ivIndex);
+    }
+    else if(CyMesh_BeaconFind(CyMesh_BeaconNextFlags(), CyMesh_BeaconNextIvIndex()) == NULL)
+    {
+        (void)CyMesh_BeaconGetAuthValue(CyMesh_BeaconNextFlags(), CyMesh_BeaconNextIvIndex());
+    }
+    else
+    {
+        /* Both ready */
+    }
+
+    if(beacon.isPublished == false)
+    {
+        CyMesh_BeaconPublish();
+    }
+
+    if(beacon.stateTime >= CYMESH_BEACON_IV_UPDATE_MIN_TIME)
+    {
+        if(beacon.ivState == CYMESH_BEACON_IV_UPDATE_IN_PROGRESS)
+        {
+            CyMesh_BeaconSetIvState(CYMESH_BEACON_IV_NORMAL, beacon.ivIndex);
+        }
+        else if(beacon.isUpdateRequested == true)
+        {
+            beacon.isUpdateRequested = false;
+            CyMesh_BeaconSetIvState(CYMESH_BEACON_IV_UPDATE_IN_PROGRESS, beacon.ivIndex + 1u);
+        }
+        else
+        {
+            /* Stay in the normal state */
+        }
+    }
+
+#if (CYMESH_CONFIG_ENABLE_SECURE_NETWORK_BEACON == 1)
+    if(beacon.beaconCountdown == 0u)
+    {
+        beacon.beaconCountdown = CYMESH_BEACON_INTERVAL;
+        CyMesh_BeaconSend();
+    }
+    beacon.beaconCountdown--;
+#endif /* (CYMESH_CONFIG_ENABLE_SECURE_NETWORK_BEACON == 1) */
+}
+
+
+bool CyMesh_BeaconReceive(const uint8 * pdu, uint8 length)
+{
+    const CYMESH_BEACON_ENTRY_T * entry;
+    uint8 authValue[CYMESH_BEACON_AUTH_VALUE_SIZE];
+    uint8 interruptState;
+    uint32 ivIndex;
+    uint8 flags;
+    bool isCached;
+
+    if((beacon.isStarted == false) || (length != CYMESH_BEACON_SECURE_LENGTH) ||
+       (pdu[0] != CYMESH_BEARER_BEACON_TYPE_SECURE_BEACON))
+    {
+        return false;
+    }
+
+    if(memcmp(&pdu[CYMESH_BEACON_OFFSET_NETWORK_ID], beacon.networkId, CYMESH_BEACON_NETWORK_ID_SIZE) != 0)
+    {
+        cyMesh_BeaconStats.otherNetwork++;
+        return false;
+    }
+
+    flags = pdu[CYMESH_BEACON_OFFSET_FLAGS];
+    ivIndex = ((uint32)pdu[CYMESH_BEACON_OFFSET_IV_INDEX] << 24) |
+              ((uint32)pdu[CYMESH_BEACON_OFFSET_IV_INDEX + 1u] << 16) |
+              ((uint32)pdu[CYMESH_BEACON_OFFSET_IV_INDEX + 2u] << 8) |
+              (uint32)pdu[CYMESH_BEACON_OFFSET_IV_INDEX + 3u];
+
+    interruptState = CyEnterCriticalSection();
+    entry = CyMesh_BeaconFind(flags, ivIndex);
+    isCached = (entry != NULL);
+    if(isCached == true)
+    {
+        cyMesh_BeaconStats.cacheHits++;
+        memcpy(authValue, entry->authValue, CYMESH_BEACON_AUTH_VALUE_SIZE);
+    }
+    CyExitCriticalSection(interruptState);
+
+    if(isCached == false)
+    {
+        CyMesh_BeaconCalculate(flags, ivIndex, authValue);
+    }
+
+    if(memcmp(&pdu[CYMESH_BEACON_OFFSET_AUTH_VALUE], authValue, CYMESH_BEACON_AUTH_VALUE_SIZE) != 0)
+    {
+        cyMesh_BeaconStats.authFailures++;
+        return false;
+    }
+
+    interruptState = CyEnterCriticalSection();
+
+    /* The timer may have cached the tuple in the meantime */
+    if((isCached == false) && (CyMesh_BeaconFind(flags, ivIndex) == NULL))
+    {
+        CyMesh_BeaconInsert(flags, ivIndex, authValue);
+    }
+
+    /* IV update procedure: follow a network that is ahead, never go back */
+    if(ivIndex > beacon.ivIndex)
+    {
+        CyMesh_BeaconSetIvState(((flags & CYMESH_BEACON_FLAG_IV_UPDATE) != 0u) ?
+                                CYMESH_BEACON_IV_UPDATE_IN_PROGRESS : CYMESH_BEACON_IV_NORMAL, ivIndex);
+    }
+    else if((ivIndex == beacon.ivIndex) && ((flags & CYMESH_BEACON_FLAG_IV_UPDATE) == 0u) &&
+            (beacon.ivState == CYMESH_BEACON_IV_UPDATE_IN_PROGRESS))
+    {
+        CyMesh_BeaconSetIvState(CYMESH_BEACON_IV_NORMAL, ivIndex);
+    }
+    else
+    {
+        /* Same state, or a node that is behind */
+    }
+
+    CyExitCriticalSection(interruptState);
+
+    return true;
+}
+
+
+bool CyMesh_BeaconRequestIvUpdate(void)
+{
+    uint8 interruptState = CyEnterCriticalSection();
+    bool result = false;
+
+    if((beacon.isStarted == false) || (beacon.ivState != CYMESH_BEACON_IV_NORMAL))
+    {
+        /* Not started, or an update is in progress */
+    }
+    else if(beacon.stateTime < CYMESH_BEACON_IV_UPDATE_MIN_TIME)
+    {
+        beacon.isUpdateRequested = true;
+    }
+    else
+    {
+        CyMesh_BeaconSetIvState(CYMESH_BEACON_IV_UPDATE_IN_PROGRESS, beacon.ivIndex + 1u);
+        result = true;
+    }
+
+    CyExitCriticalSection(interruptState);
+
+    return result;
+}
+
+
+bool CyMesh_BeaconGetSecureBeacon(uint8 * pdu)
+{
+    const CYMESH_BEACON_ENTRY_T * entry = NULL;
+    uint8 interruptState = CyEnterCriticalSection();
+
+    if(beacon.isStarted == true)
+    {
+        entry = CyMesh_BeaconFind(CyMesh_BeaconCurrentFlags(), beacon.ivIndex);
+    }
+
+    if(entry == NULL)
+    {
+        CyExitCriticalSection(interruptState);
+        return false;
+    }
+
+    pdu[0] = CYMESH_BEARER_BEACON_TYPE_SECURE_BEACON;
+    pdu[CYMESH_BEACON_OFFSET_FLAGS] = entry->flags;
+    memcpy(&pdu[CYMESH_BEACON_OFFSET_NETWORK_ID], beacon.networkId, CYMESH_BEACON_NETWORK_ID_SIZE);
+    pdu[CYMESH_BEACON_OFFSET_IV_INDEX] = (uint8)(entry->ivIndex >> 24);
+    pdu[CYMESH_BEACON_OFFSET_IV_INDEX + 1u] = (uint8)(entry->ivIndex >> 16);
+    pdu[CYMESH_BEACON_OFFSET_IV_INDEX + 2u] = (uint8)(entry->ivIndex >> 8);
+    pdu[CYMESH_BEACON_OFFSET_IV_INDEX + 3u] = (uint8)entry->ivIndex;
+    memcpy(&pdu[CYMESH_BEACON_OFFSET_AUTH_VALUE], entry->authValue, CYMESH_BEACON_AUTH_VALUE_SIZE);
+
+    CyExitCriticalSection(interruptState);
+
+    return true;
+}
+
+
+CYMESH_BEACON_IV_STATE_T CyMesh_BeaconGetIvState(void)
+{
+    return beacon.ivState;
+}
+
+
+void __wrap_CyMesh_ConfigurationIncomingBeacon(uint32 event, CYMESH_BEARER_RX_BUFFER_T * rxBuffer)
+{
+    if((rxBuffer->length == CYMESH_BEACON_SECURE_LENGTH) &&
+       (rxBuffer->data[0] == CYMESH_BEARER_BEACON_TYPE_SECURE_BEACON))
+    {
+        (void)CyMesh_BeaconReceive(rxBuffer->data, rxBuffer->length);
+    }
+    else
+    {
+        __real_CyMesh_ConfigurationIncomingBeacon(event, rxBuffer);
+    }
+}
+
+
+CYMESH_API_RETURN_T __wrap_CyMesh_SecurityCalculateBeaconAuthValue(uint8 meshId, uint8 krBit, uint32 ivIndex,
+                                                                   CYMESH_SECURITY_CALLBACK callback)
+{
+    uint8 cmac[CYMESH_BEACON_BLOCK_SIZE];
+    uint8 interruptState;
+
+    if(meshId != CYMESH_BEACON_MESH_ID)
+    {
+        return __real_CyMesh_SecurityCalculateBeaconAuthValue(meshId, krBit, ivIndex, callback);
+    }
+
+    interruptState = CyEnterCriticalSection();
+
+    /* The library asks after it set the keys and the IV index: at boot from
+     * the saved configuration, and when the SEQ numbers wrap */
+    if((beacon.isStarted == false) ||
+       (memcmp(beacon.key, cyMesh_ConfigInfoRam.netInfo.netKeys[meshId].encryptionKey, CYMESH_BEACON_BLOCK_SIZE) != 0))
+    {
+        CyMesh_BeaconStart();
+    }
+
+    memset(cmac, 0, sizeof(cmac));
+    memcpy(cmac, CyMesh_BeaconGetAuthValue(krBit, ivIndex), CYMESH_BEACON_AUTH_VALUE_SIZE);
+
+    if(callback != NULL)
+    {
+        callback(cmac);
+    }
+
+    /* The library copies the value it asked for over that of the node, which
+     * differs during an update in progress */
+    beacon.isPublished = false;
+
+    CyExitCriticalSection(interruptState);
+
+    return CYMESH_ERROR_OK;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,239 @@
+/***************************************************************************//**
+* \file CyMesh_Beacon.h
+* \version 1.0
+*
+* \brief
+*  This is the header file of the secure network beacon manager, which keeps
+*  the beacon authentication values of the IV index states ahead of time and
+*  runs the IV update procedure.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined (CYMESH_BEACON_H)
+#define CYMESH_BEACON_H
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <stdbool.h>
+#include "CyMesh_Common.h"
+#include "CyMesh_Bearer.h"
+#include "CyMesh_Configuration.h"
+#include "CyMesh_Security.h"
+
+
+/*******************************************************************************
+* Compile Time Options
+*******************************************************************************/
+/* Authenticated (flags, NetID, IV index) tuples kept, including the two of
+ * the node itself */
+#if !defined(CYMESH_BEACON_CACHE_SIZE)
+    #define CYMESH_BEACON_CACHE_SIZE                (8u)
+#endif
+
+/* Time between two secure network beacons of the node, in ms */
+#if !defined(CYMESH_BEACON_INTERVAL)
+    #define CYMESH_BEACON_INTERVAL                  (10000u)
+#endif
+
+/* Minimum time in each IV update state before the node moves on by itself,
+ * in ms (96 hours) */
+#if !defined(CYMESH_BEACON_IV_UPDATE_MIN_TIME)
+    #define CYMESH_BEACON_IV_UPDATE_MIN_TIME        (96u * 3600u * 1000u)
+#endif
+
+#if (CYMESH_BEACON_CACHE_SIZE < 3u)
+    #error "The beacon cache needs room for the two node entries and one more"
+#endif
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+/* Secure network beacon: Beacon type (1) + Flags (1) + Network ID (8) +
+ * IV index (4, MSB first) + Authentication value (8) */
+#define CYMESH_BEACON_SECURE_LENGTH                 (22u)
+#define CYMESH_BEACON_NETWORK_ID_SIZE               (8u)
+#define CYMESH_BEACON_AUTH_VALUE_SIZE               (CYMESH_CONFIG_SECURE_BEACON_AUTH_VAL_LEN)
+
+#define CYMESH_BEACON_FLAG_KEY_REFRESH              (0x01u)
+#define CYMESH_BEACON_FLAG_IV_UPDATE                (0x02u)
+
+
+/*******************************************************************************
+* Structures and Enums
+*******************************************************************************/
+typedef enum
+{
+    /* Packets are sent and received with the IV index */
+    CYMESH_BEACON_IV_NORMAL,
+
+    /* The beacon announces IV index + 1, packets are still sent with the IV
+     * index */
+    CYMESH_BEACON_IV_UPDATE_IN_PROGRESS
+} CYMESH_BEACON_IV_STATE_T;
+
+typedef struct
+{
+    /* Beacons checked against a cached tuple */
+    uint32 cacheHits;
+
+    /* AES-CMAC calculations, for received beacons and ahead of time */
+    uint32 cmacCount;
+
+    /* Received beacons that failed authentication */
+    uint32 authFailures;
+
+    /* Received beacons of another network */
+    uint32 otherNetwork;
+} CYMESH_BEACON_STATS_T;
+
+
+/*******************************************************************************
+* Globals
+*******************************************************************************/
+extern CYMESH_BEACON_STATS_T cyMesh_BeaconStats;
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+/******************************************************************************
+* Function Name: CyMesh_BeaconStart
+*******************************************************************************
+*
+*  This function starts the beacon manager for mesh 0, once its network key is
+* set and the IV index is known. The authentication values of the current and
+* the next IV update state are calculated from CyMesh_BeaconUpdate().
+*
+*  \param none:
+*
+*  \return none:
+*
+******************************************************************************/
+void CyMesh_BeaconStart(void);
+
+/******************************************************************************
+* Function Name: CyMesh_BeaconUpdate
+*******************************************************************************
+*
+*  This function runs on the SM timer (1 ms). It calculates at most one
+* pending authentication value per call, moves between the IV update states
+* and, with CYMESH_CONFIG_ENABLE_SECURE_NETWORK_BEACON, sends the beacon of the
+* node every CYMESH_BEACON_INTERVAL ms.
+*
+*  \param none:
+*
+*  \return none:
+*
+******************************************************************************/
+void CyMesh_BeaconUpdate(void);
+
+/******************************************************************************
+* Function Name: CyMesh_BeaconReceive
+*******************************************************************************
+*
+*  This function authenticates a received secure network beacon, starting at
+* the beacon type. A beacon whose flags, Network ID and IV index match a cached
+* tuple is checked by comparing the authentication value. A beacon of mesh 0
+* that authenticates may move the node to the IV index it announces.
+*
+*  \param pdu: Secure network beacon
+*         length: Length of the beacon
+*
+*  \return bool: true if the beacon is of mesh 0 and authenticated
+*
+******************************************************************************/
+bool CyMesh_BeaconReceive(const uint8 * pdu, uint8 length);
+
+/******************************************************************************
+* Function Name: CyMesh_BeaconRequestIvUpdate
+*******************************************************************************
+*
+*  This function starts an IV update once the node has been
+* CYMESH_BEACON_IV_UPDATE_MIN_TIME in the normal state, for example when its
+* SEQ numbers run low. The authentication value of the new state is ready by
+* then, so the change is not delayed by a CMAC calculation.
+*
+*  \param none:
+*
+*  \return bool: true if the update started now, false if it starts once the
+*                minimum time has passed, or cannot start
+*
+******************************************************************************/
+bool CyMesh_BeaconRequestIvUpdate(void);
+
+/******************************************************************************
+* Function Name: CyMesh_BeaconGetSecureBeacon
+*******************************************************************************
+*
+*  This function writes the secure network beacon of the node.
+*
+*  \param pdu: CYMESH_BEACON_SECURE_LENGTH bytes
+*
+*  \return bool: false if the authentication value is not calculated yet
+*
+******************************************************************************/
+bool CyMesh_BeaconGetSecureBeacon(uint8 * pdu);
+
+/******************************************************************************
+* Function Name: CyMesh_BeaconGetIvState
+*******************************************************************************
+*
+*  This function returns the IV update state of mesh 0.
+*
+*  \param none:
+*
+*  \return CYMESH_BEACON_IV_STATE_T: IV update state
+*
+******************************************************************************/
+CYMESH_BEACON_IV_STATE_T CyMesh_BeaconGetIvState(void);
+
+/******************************************************************************
+* Function Name: __wrap_CyMesh_ConfigurationIncomingBeacon
+*******************************************************************************
+*
+*  The bearer passes received mesh beacons to
+* CyMesh_ConfigurationIncomingBeacon(), which is empty in the library. The
+* linker option --wrap=CyMesh_ConfigurationIncomingBeacon sends them here;
+* secure network beacons go to CyMesh_BeaconReceive(), others to the library.
+*
+*  \param event: Beacon type event (CYMESH_EVENT_T)
+*         rxBuffer: Received beacon
+*
+*  \return none:
+*
+******************************************************************************/
+void __wrap_CyMesh_ConfigurationIncomingBeacon(uint32 event, CYMESH_BEARER_RX_BUFFER_T * rxBuffer);
+
+/******************************************************************************
+* Function Name: __wrap_CyMesh_SecurityCalculateBeaconAuthValue
+*******************************************************************************
+*
+*  The library calculates the authentication value of the node with
+* CyMesh_SecurityCalculateBeaconAuthValue() and waits for the callback in a
+* loop. With --wrap=CyMesh_SecurityCalculateBeaconAuthValue the value of mesh 0
+* comes from the cache, or one AES block, and the callback runs before this
+* function returns. Other meshes go to the library.
+*
+*  \param meshId: Mesh ID
+*         krBit: Flags of the beacon
+*         ivIndex: IV index
+*         callback: Called with the authentication value in the first
+*                   CYMESH_BEACON_AUTH_VALUE_SIZE bytes
+*
+*  \return CYMESH_API_RETURN_T: CYMESH_ERROR_OK, or the result of the library
+*
+******************************************************************************/
+CYMESH_API_RETURN_T __wrap_CyMesh_SecurityCalculateBeaconAuthValue(uint8 meshId, uint8 krBit, uint32 ivIndex,
+                                                                   CYMESH_SECURITY_CALLBACK callback);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,456 @@
+/***************************************************************************//**
+* \file CyMesh_BearerProxy.c
+* \version 1.0
+*
+* \brief
+*  This file contains the GATT proxy bearer of the BLE SmartMesh v1 solution.
+*
+*  The library bearer sends each network PDU to the proxy client in a
+*  notification of its own, the moment it gives the PDU to the advertiser,
+*  and a PDU of more than CYMESH_BEARER_PROXY_SEGMENT_LENGTH bytes in two. It
+*  assumes the default MTU and does not look at the result of
+*  CyBle_GattsNotification(), so the PDUs that find the buffers of the BLE
+*  stack full are lost. The bearer TX scheduler gives it every transmission of
+*  a PDU, and the client gets each copy.
+*
+*  With -Wl,--wrap=CyBle_GattsNotification the network PDUs the library
+*  notifies on the proxy data characteristic are queued here instead, in
+*  CYMESH_BEARER_PROXY_QUEUE_SIZE entries; a copy of one of the last
+*  CYMESH_BEARER_PROXY_RECENT_SIZE PDUs is dropped. CyMesh_BearerProxyUpdate()
+*  runs after each CyBle_ProcessEvents() and sends notifications for as long
+*  as the stack reports a free buffer, so that several go in one connection
+*  event. One the stack refuses for lack of memory is built again on the next
+*  call. PDUs keep coming while the link is busy, so the queue grows with the
+*  load, and each notification takes all that fit.
+*
+*  Once the client has written an aggregate to the proxy data characteristic
+*  (see CYMESH_BEARER_PROXY_TYPE_AGGREGATE), the notifications are aggregates
+*  too: a header, then Length (1) + network PDU for as many queued PDUs as fit
+*  in the MTU less the ATT header, and in CYMESH_BEARER_GATT_MAX_DATA_LENGTH.
+*  At the default MTU of 23 that is a single PDU; at 71 and over, three of the
+*  usual 20 to 29 bytes. A PDU too long for an aggregate goes on its own, in
+*  segments if need be, as the library sends it. Until then, and for clients
+*  that never send an aggregate, the notifications carry one PDU each, as
+*  before, only paced by the buffers of the stack.
+*
+*  The aggregated writes of the client are split by CyMesh_BearerProxyEvent(),
+*  which CyMesh_BearerRx.c calls with each BLE event before the library
+*  bearer, and each PDU goes to the RX ring of CyMesh_BearerRx.c, as the
+*  network PDUs of the library RX buffer do. Other writes go on to the library.
+*
+*  The aggregate is a format of this node: the mesh proxy protocol carries one
+*  PDU per proxy PDU. Tools/network_bench/proxy_bench.c measures the PDUs per
+*  second through the proxy against a model of the GATT link, for the library
+*  bearer, the paced single PDUs and the aggregates.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <string.h>
+#include "CyMesh_BearerProxy.h"
+#include "CyMesh_BearerRx.h"
+
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+#define CYMESH_BEARER_PROXY_HEADER_LENGTH       (1u)
+#define CYMESH_BEARER_PROXY_LENGTH_LENGTH       (1u)
+
+/* FNV-1a, 32 bits */
+#define CYMESH_BEARER_PROXY_HASH_BASIS          (0x811C9DC5u)
+#define CYMESH_BEARER_PROXY_HASH_PRIME          (0x01000193u)
+
+
+
+/*******************************************************************************
+* Data Structures
+*******************************************************************************/
+typedef struct
+{
+    uint8 data[CYMESH_BEARER_ADV_MAX_LENGTH];
+    uint8 length;
+} CYMESH_BEARER_PROXY_ENTRY_T;
+
+/* The BLE stack version */
+extern CYBLE_API_RESULT_T __real_CyBle_GattsNotification(CYBLE_CONN_HANDLE_T connHandle,
+                                                         CYBLE_GATTS_HANDLE_VALUE_NTF_T * ntfParam);
+
+CYMESH_BEARER_PROXY_STATS_T cyMesh_BearerProxyStats;
+
+static struct
+{
+    CYMESH_BEARER_PROXY_ENTRY_T queue[CYMESH_BEARER_PROXY_QUEUE_SIZE];
+    uint8 head;
+    uint8 count;
+
+    /* The first segment of the head PDU is sent */
+    bool isFirstSent;
+
+    /* Notification being sent */
+    uint8 packet[CYMESH_BEARER_GATT_MAX_DATA_LENGTH];
+
+    /* PDU of the library, reassembled from its segments */
+    uint8 segment[CYMESH_BEARER_ADV_MAX_LENGTH];
+    uint8 segmentLength;
+
+#if (CYMESH_BEARER_PROXY_RECENT_SIZE > 0u)
+    /* Hashes of the last PDUs queued */
+    uint32 recent[CYMESH_BEARER_PROXY_RECENT_SIZE];
+    uint8 recentNext;
+#endif
+
+    /* The client sends aggregates, and has yet to get the answer to its
+     * first */
+    bool isAggregating;
+    bool isAnswerPending;
+} bearerProxy;
+
+
+
+/*******************************************************************************
+* Static functions
+*******************************************************************************/
+/* Drops the queued PDUs, the client can no longer get them */
+static void CyMesh_BearerProxyDrop(void)
+{
+    cyMesh_BearerProxyStats.dropped += bearerProxy.count;
+    bearerProxy.count = 0u;
+    bearerProxy.isFirstSent = false;
+    bearerProxy.isAnswerPending = false;
+}
+
+
+/* Whether a PDU was queued lately; if not, it is remembered */
+static bool CyMesh_BearerProxyIsRecent(const uint8 * pdu, uint8 length)
+{
+#if (CYMESH_BEARER_PROXY_RECENT_SIZE > 0u)
+    uint32 hash = CYMESH_BEARER_PROXY_HASH_BASIS;
+    uint8 i;
+
+    for(i = 0u; i < length; i++)
+    {
+        hash = (hash ^ pdu[i]) * CYMESH_BEARER_PROXY_HASH_PRIME;
+    }
+
+    for(i = 0u; i < CYMESH_BEARER_PROXY_RECENT_SIZE; i++)
+    {
+        if(bearerProxy.recent[i] == hash)
+        {
+            return true;
+        }
+    }
+
+    bearerProxy.recent[bearerProxy.recentNext] = hash;
+    bearerProxy.recentNext = (bearerProxy.recentNext + 1u) % CYMESH_BEARER_PROXY_RECENT_SIZE;
+#else
+    (void)pdu;
+    (void)length;
+#endif
+
+    return false;
+}
+
+
+static void CyMesh_BearerProxyQueue(const uint8 * pdu, uint8 length)
+{
+    CYMESH_BEARER_PROXY_ENTRY_T * entry;
+
+    if((length == 0u) || (length > CYMESH_BEARER_ADV_MAX_LENGTH))
+    {
+        return;
+    }
+    if(bearerProxy.count >= CYMESH_BEARER_PROXY_QUEUE_SIZE)
+    {
+        cyMesh_BearerProxyStats.overflow++;
+        return;
+    }
+    if(CyMesh_BearerProxyIsRecent(pdu, length) == true)
+    {
+        cyMesh_BearerProxyStats.duplicate++;
+        return;
+    }
+
+    entry = &bearerProxy.queue[(bearerProxy.head + bearerProxy.count) % CYMESH_BEARER_PROXY_QUEUE_SIZE];
+    memcpy(entry->data, pdu, length);
+    entry->length = length;
+    bearerProxy.count++;
+    cyMesh_BearerProxyStats.queued++;
+}
+
+
+/* Notification payload the link takes */
+static uint8 CyMesh_BearerProxyPayloadLength(void)
+{
+    uint16 mtu = CYBLE_GATT_DEFAULT_MTU;
+
+    if((CyBle_GattGetMtuSize(&mtu) != CYBLE_ERROR_OK) || (mtu < CYBLE_GATT_DEFAULT_MTU))
+    {
+        mtu = CYBLE_GATT_DEFAULT_MTU;
+    }
+    mtu -= CYMESH_BEARER_PROXY_ATT_HEADER_LENGTH;
+
+    return (mtu < CYMESH_BEARER_GATT_MAX_DATA_LENGTH) ? (uint8)mtu : CYMESH_BEARER_GATT_MAX_DATA_LENGTH;
+}
+
+
+/* Builds the next notification in packet, of at most payload bytes. Returns
+ * its length and sets pdus to the queued PDUs it completes. */
+static uint8 CyMesh_BearerProxyPack(uint8 payload, uint8 * pdus)
+{
+    const CYMESH_BEARER_PROXY_ENTRY_T * entry = &bearerProxy.queue[bearerProxy.head];
+    uint8 * packet = bearerProxy.packet;
+    uint8 length = CYMESH_BEARER_PROXY_HEADER_LENGTH;
+    uint8 i;
+
+    *pdus = 0u;
+
+    if((bearerProxy.count == 0u) ||
+       ((bearerProxy.isAggregating == true) && (bearerProxy.isFirstSent == false) &&
+        ((CYMESH_BEARER_PROXY_HEADER_LENGTH + CYMESH_BEARER_PROXY_LENGTH_LENGTH + entry->length) <= payload)))
+    {
+        packet[0] = CYMESH_BEARER_PROXY_SAR_COMPLETE | CYMESH_BEARER_PROXY_TYPE_AGGREGATE;
+        for(i = 0u; i < bearerProxy.count; i++)
+        {
+            entry = &bearerProxy.queue[(bearerProxy.head + i) % CYMESH_BEARER_PROXY_QUEUE_SIZE];
+            if((length + CYMESH_BEARER_PROXY_LENGTH_LENGTH + entry->length) > payload)
+            {
+                break;
+            }
+            packet[length] = entry->length;
+            memcpy(&packet[length + CYMESH_BEARER_PROXY_LENGTH_LENGTH], entry->data, entry->length);
+            length += CYMESH_BEARER_PROXY_LENGTH_LENGTH + entry->length;
+        }
+        *pdus = i;
+
+        return length;
+    }
+
+    if(bearerProxy.isFirstSent == true)
+    {
+        packet[0] = CYMESH_BEARER_PROXY_SAR_LAST | CYMESH_BEARER_PROXY_TYPE_NETWORK;
+        memcpy(&packet[length], &entry->data[CYMESH_BEARER_PROXY_SEGMENT_LENGTH],
+               entry->length - CYMESH_BEARER_PROXY_SEGMENT_LENGTH);
+        *pdus = 1u;
+
+        return length + (entry->length - CYMESH_BEARER_PROXY_SEGMENT_LENGTH);
+    }
+
+    if((length + entry->length) <= payload)
+    {
+        packet[0] = CYMESH_BEARER_PROXY_SAR_COMPLETE | CYMESH_BEARER_PROXY_TYPE_NETWORK;
+        memcpy(&packet[length], entry->data, entry->length);
+        *pdus = 1u;
+
+        return length + entry->length;
+    }
+
+    packet[0] = CYMESH_BEARER_PROXY_SAR_FIRST | CYMESH_BEARER_PROXY_TYPE_NETWORK;
+    memcpy(&packet[length], entry->data, CYMESH_BEARER_PROXY_SEGMENT_LENGTH);
+
+    return length + CYMESH_BEARER_PROXY_SEGMENT_LENGTH;
+}
+
+
+/* Splits an aggregate of the client. False if the write is not one. */
+static bool CyMesh_BearerProxyWrite(const CYBLE_GATTS_WRITE_REQ_PARAM_T * writeParam)
+{
+    const uint8 * data = writeParam->handleValPair.value.val;
+    uint16 length = writeParam->handleValPair.value.len;
+    uint16 offset = CYMESH_BEARER_PROXY_HEADER_LENGTH;
+
+    if((writeParam->handleValPair.attrHandle != CYMESH_BEARER_PROXY_DATA_HANDLE) || (data == NULL) ||
+       (length < CYMESH_BEARER_PROXY_HEADER_LENGTH) ||
+       (data[0] != (CYMESH_BEARER_PROXY_SAR_COMPLETE | CYMESH_BEARER_PROXY_TYPE_AGGREGATE)))
+    {
+        return false;
+    }
+
+    cyMesh_BearerProxyStats.writes++;
+    if(bearerProxy.isAggregating == false)
+    {
+        bearerProxy.isAggregating = true;
+        bearerProxy.isAnswerPending = true;
+    }
+
+    while(offset < length)
+    {
+        uint8 pduLength = data[offset];
+
+        offset += CYMESH_BEARER_PROXY_LENGTH_LENGTH;
+        if((pduLength == 0u) || (pduLength > CYMESH_BEARER_ADV_MAX_LENGTH) || ((offset + pduLength) > length))
+        {
+            cyMesh_BearerProxyStats.malformed++;
+            break;
+        }
+
+        if(CyMesh_BearerRxInsert(&data[offset], pduLength) == true)
+        {
+            cyMesh_BearerProxyStats.received++;
+        }
+        else
+        {
+            cyMesh_BearerProxyStats.rxOverflow++;
+        }
+        offset += pduLength;
+    }
+
+    return true;
+}
+
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+bool CyMesh_BearerProxyEvent(uint32 event, void * eventParam)
+{
+    uint8 interruptState;
+
+    switch(event)
+    {
+        case CYBLE_EVT_GATTS_WRITE_CMD_REQ:
+            return CyMesh_BearerProxyWrite((const CYBLE_GATTS_WRITE_REQ_PARAM_T *)eventParam);
+
+        case CYBLE_EVT_GATTS_WRITE_REQ:
+            if(CyMesh_BearerProxyWrite((const CYBLE_GATTS_WRITE_REQ_PARAM_T *)eventParam) == true)
+            {
+                (void)CyBle_GattsWriteRsp(((const CYBLE_GATTS_WRITE_REQ_PARAM_T *)eventParam)->connHandle);
+                return true;
+            }
+            return false;
+
+        case CYBLE_EVT_GATT_CONNECT_IND:
+        case CYBLE_EVT_GATT_DISCONNECT_IND:
+            interruptState = CyEnterCriticalSection();
+            CyMesh_BearerProxyDrop();
+            memset(&bearerProxy, 0, sizeof(bearerProxy));
+            CyExitCriticalSection(interruptState);
+            return false;
+
+        default:
+            return false;
+    }
+}
+
+
+void CyMesh_BearerProxyUpdate(void)
+{
+    uint8 interruptState;
+    uint8 payload;
+
+    if((bearerProxy.count == 0u) && (bearerProxy.isAnswerPending == false))
+    {
+        return;
+    }
+
+    payload = CyMesh_BearerProxyPayloadLength();
+    interruptState = CyEnterCriticalSection();
+    while(((bearerProxy.count != 0u) || (bearerProxy.isAnswerPending == true)) &&
+          (CyBle_GattGetBusyStatus() == CYBLE_STACK_STATE_FREE))
+    {
+        CYBLE_GATTS_HANDLE_VALUE_NTF_T notification;
+        CYBLE_API_RESULT_T result;
+        uint8 pdus;
+
+        notification.attrHandle = CYMESH_BEARER_PROXY_DATA_HANDLE;
+        notification.value.val = bearerProxy.packet;
+        notification.value.len = CyMesh_BearerProxyPack(payload, &pdus);
+
+        result = __real_CyBle_GattsNotification(cyBle_connHandle, &notification);
+        if(result == CYBLE_ERROR_MEMORY_ALLOCATION_FAILED)
+        {
+            cyMesh_BearerProxyStats.busy++;
+            break;
+        }
+        if(result != CYBLE_ERROR_OK)
+        {
+            /* Disconnected or notifications off */
+            CyMesh_BearerProxyDrop();
+            break;
+        }
+
+        cyMesh_BearerProxyStats.notifications++;
+        cyMesh_BearerProxyStats.sent += pdus;
+        if(bearerProxy.packet[0] == (CYMESH_BEARER_PROXY_SAR_COMPLETE | CYMESH_BEARER_PROXY_TYPE_AGGREGATE))
+        {
+            bearerProxy.isAnswerPending = false;
+        }
+
+        bearerProxy.isFirstSent = (pdus == 0u) && (bearerProxy.count != 0u);
+        bearerProxy.head = (bearerProxy.head + pdus) % CYMESH_BEARER_PROXY_QUEUE_SIZE;
+        bearerProxy.count -= pdus;
+    }
+
+    CyExitCriticalSection(interruptState);
+}
+
+
+CYBLE_API_RESULT_T __wrap_CyBle_GattsNotification(CYBLE_CONN_HANDLE_T connHandle,
+                                                  CYBLE_GATTS_HANDLE_VALUE_NTF_T * ntfParam)
+{
+#if (CYMESH_ENABLE_PROXY_AGGREGATION == 1)
+    const uint8 * data = ntfParam->value.val;
+    uint16 length = ntfParam->value.len;
+    uint8 interruptState;
+
+    if((ntfParam->attrHandle != CYMESH_BEARER_PROXY_DATA_HANDLE) || (length <= CYMESH_BEARER_PROXY_HEADER_LENGTH) ||
+       ((data[0] & CYMESH_BEARER_PROXY_TYPE_MASK) != CYMESH_BEARER_PROXY_TYPE_NETWORK))
+    {
+        return __real_CyBle_GattsNotification(connHandle, ntfParam);
+    }
+
+    data += CYMESH_BEARER_PROXY_HEADER_LENGTH;
+    length -= CYMESH_BEARER_PROXY_HEADER_LENGTH;
+
+    interruptState = CyEnterCriticalSection();
+    switch(ntfParam->value.val[0] & CYMESH_BEARER_PROXY_SAR_MASK)
+    {
+        case CYMESH_BEARER_PROXY_SAR_COMPLETE:
+            CyMesh_BearerProxyQueue(data, (uint8)length);
+            break;
+
+        case CYMESH_BEARER_PROXY_SAR_FIRST:
+            bearerProxy.segmentLength = 0u;
+            if(length <= CYMESH_BEARER_ADV_MAX_LENGTH)
+            {
+                memcpy(bearerProxy.segment, data, length);
+                bearerProxy.segmentLength = (uint8)length;
+            }
+            break;
+
+        case CYMESH_BEARER_PROXY_SAR_LAST:
+            if((bearerProxy.segmentLength != 0u) &&
+               ((bearerProxy.segmentLength + length) <= CYMESH_BEARER_ADV_MAX_LENGTH))
+            {
+                memcpy(&bearerProxy.segment[bearerProxy.segmentLength], data, length);
+                CyMesh_BearerProxyQueue(bearerProxy.segment, bearerProxy.segmentLength + (uint8)length);
+            }
+            bearerProxy.segmentLength = 0u;
+            break;
+
+        default:
+            /* The library sends no continuation */
+            break;
+    }
+    CyExitCriticalSection(interruptState);
+
+    return CYBLE_ERROR_OK;
+#else
+    /* CyMesh_BearerProxyUpdate() is not called, so nothing may be queued */
+    return __real_CyBle_GattsNotification(connHandle, ntfParam);
+#endif
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,179 @@
+/***************************************************************************//**
+* \file CyMesh_BearerProxy.h
+* \version 1.0
+*
+* \brief
+*  This is the header file of the GATT proxy bearer, which queues the network
+*  PDUs for the proxy client, sends them as the BLE stack has buffers, several
+*  to a notification once the client asks for it, and splits the aggregated
+*  writes of the client.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined (CYMESH_BEARER_PROXY_H)
+#define CYMESH_BEARER_PROXY_H
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <stdbool.h>
+#include "CyMesh_Common.h"
+#include "CyMesh_Bearer.h"
+
+
+/*******************************************************************************
+* Compile Time Options
+*******************************************************************************/
+/* Network PDUs waiting for the proxy client */
+#if !defined(CYMESH_BEARER_PROXY_QUEUE_SIZE)
+    #define CYMESH_BEARER_PROXY_QUEUE_SIZE          (16u)
+#endif
+
+/* PDUs handed to the client that a copy is checked against. The bearer TX
+ * scheduler gives each transmission of a PDU to the library bearer, which
+ * notifies the client each time; 0 sends every copy. */
+#if !defined(CYMESH_BEARER_PROXY_RECENT_SIZE)
+    #define CYMESH_BEARER_PROXY_RECENT_SIZE         (8u)
+#endif
+
+#if (CYMESH_BEARER_PROXY_QUEUE_SIZE < 2u) || (CYMESH_BEARER_PROXY_QUEUE_SIZE > 64u)
+    #error "The proxy queue size must be from 2 to 64"
+#endif
+#if (CYMESH_BEARER_PROXY_RECENT_SIZE > 32u)
+    #error "At most 32 recent proxy PDUs can be checked"
+#endif
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+/* Proxy data characteristic in the GATT database of the project. The library
+ * bearer writes and notifies its value at the handle. */
+#define CYMESH_BEARER_PROXY_DATA_HANDLE             (13u)
+
+/* Header of a proxy PDU: SAR (2 bits) | type. The library reads 4 bits of
+ * type. A network PDU that does not fit in a notification is sent as a first
+ * and a last segment, CYMESH_BEARER_PROXY_SEGMENT_LENGTH bytes in the first,
+ * as the library bearer does. */
+#define CYMESH_BEARER_PROXY_SAR_MASK                (0xC0u)
+#define CYMESH_BEARER_PROXY_SAR_COMPLETE            (0x00u)
+#define CYMESH_BEARER_PROXY_SAR_FIRST               (0x40u)
+#define CYMESH_BEARER_PROXY_SAR_LAST                (0xC0u)
+#define CYMESH_BEARER_PROXY_TYPE_MASK               (0x0Fu)
+#define CYMESH_BEARER_PROXY_TYPE_NETWORK            (0x01u)
+#define CYMESH_BEARER_PROXY_SEGMENT_LENGTH          (18u)
+
+/* Aggregate: complete PDU of this type, followed by Length (1) + network PDU,
+ * as many as fit. The node answers the first aggregate of the client, which
+ * may be empty, with an empty one; the library ignores it, so a client that
+ * gets no answer keeps to one PDU per write. */
+#define CYMESH_BEARER_PROXY_TYPE_AGGREGATE          (0x0Fu)
+
+/* ATT header of a notification: opcode (1) + handle (2) */
+#define CYMESH_BEARER_PROXY_ATT_HEADER_LENGTH       (3u)
+
+
+/*******************************************************************************
+* Structures and Enums
+*******************************************************************************/
+typedef struct
+{
+    /* Network PDUs queued for the client, and those lost to a full queue */
+    uint32 queued;
+    uint32 overflow;
+
+    /* Copies of a recent PDU, not sent again */
+    uint32 duplicate;
+
+    /* Notifications sent, and the PDUs they carried */
+    uint32 notifications;
+    uint32 sent;
+
+    /* Notifications the BLE stack had no buffer for, sent again later */
+    uint32 busy;
+
+    /* PDUs dropped because the client went away or turned notifications off */
+    uint32 dropped;
+
+    /* Aggregated writes of the client, the PDUs they carried, and those that
+     * were malformed or found the RX ring full */
+    uint32 writes;
+    uint32 received;
+    uint32 malformed;
+    uint32 rxOverflow;
+} CYMESH_BEARER_PROXY_STATS_T;
+
+
+/*******************************************************************************
+* Globals
+*******************************************************************************/
+extern CYMESH_BEARER_PROXY_STATS_T cyMesh_BearerProxyStats;
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+/******************************************************************************
+* Function Name: CyMesh_BearerProxyEvent
+*******************************************************************************
+*
+*  This function takes the BLE events before the library bearer. It splits the
+* aggregated writes of the proxy data characteristic, which turn on
+* aggregation for the connection, and empties the queue when the client
+* disconnects.
+*
+*  \param event: BLE event
+*         eventParam: Its parameter
+*
+*  \return bool: true if the event was an aggregated write, which the library
+*          bearer must not see
+*
+******************************************************************************/
+bool CyMesh_BearerProxyEvent(uint32 event, void * eventParam);
+
+/******************************************************************************
+* Function Name: CyMesh_BearerProxyUpdate
+*******************************************************************************
+*
+*  This function runs after each CyBle_ProcessEvents(). While the BLE stack has
+* buffers, it sends the queued PDUs, as many to a notification as the MTU and
+* CYMESH_BEARER_GATT_MAX_DATA_LENGTH allow if the client aggregates, one
+* otherwise. A notification the stack has no buffer for is sent again on the
+* next call.
+*
+*  \param none:
+*
+*  \return none:
+*
+******************************************************************************/
+void CyMesh_BearerProxyUpdate(void);
+
+/******************************************************************************
+* Function Name: __wrap_CyBle_GattsNotification
+*******************************************************************************
+*
+*  With -Wl,--wrap=CyBle_GattsNotification the network PDUs the library
+* bearer notifies on the proxy data characteristic are queued for
+* CyMesh_BearerProxyUpdate(); a segmented one once its last segment comes.
+* Other notifications go to the BLE stack, as all of them do with
+* CYMESH_ENABLE_PROXY_AGGREGATION at 0.
+*
+*  \param connHandle: As CyBle_GattsNotification()
+*         ntfParam: As CyBle_GattsNotification()
+*
+*  \return CYBLE_API_RESULT_T: CYBLE_ERROR_OK for a proxy PDU, as
+*          CyBle_GattsNotification() otherwise
+*
+******************************************************************************/
+CYBLE_API_RESULT_T __wrap_CyBle_GattsNotification(CYBLE_CONN_HANDLE_T connHandle,
+                                                  CYBLE_GATTS_HANDLE_VALUE_NTF_T * ntfParam);
+
+#endif
+/* [] END OF FILE */
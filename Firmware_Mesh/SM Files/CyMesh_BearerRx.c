@@ -0,0 +1,298 @@
+/***************************************************************************//**
+* \file CyMesh_BearerRx.c
+* \version 1.0
+*
+* \brief
+*  This file contains the bearer RX path of the BLE SmartMesh v1 solution.
+*
+*  The library bearer copies every received mesh advertisement, whatever its
+*  network, into CYMESH_BEARER_ADV_RX_BUFFER_SIZE entries that are emptied
+*  once per CyMesh_BearerProcessEvents(). The BLE stack hands over all the
+*  reports it holds in one CyBle_ProcessEvents(), so a burst from several
+*  neighbours overflows the buffer and the packets are lost without a trace.
+*
+*  With -Wl,--wrap=CyBle_Start the advertising reports come here first. A
+*  report that is not a non-connectable advertisement with the mesh AD type
+*  goes on to the library bearer and the application as before. A mesh packet
+*  is checked against the keys of the node before it is copied: it is kept if
+*  it is a secure network beacon with a known Network ID, or if its NID is
+*  known, and discarded otherwise. Kept packets go to a ring of
+*  CYMESH_BEARER_RX_RING_SIZE entries; a packet that finds the ring full is
+*  counted per packet type in cyMesh_BearerRxStats.
+*
+*  -Wl,--wrap=CyMesh_BearerProcessEvents empties the ring after the library
+*  bearer has run, network PDUs to the callback of the network layer (kept by
+*  -Wl,--wrap=CyMesh_BearerStart) and secure network beacons to
+*  CyMesh_ConfigurationIncomingBeacon(). Unprovisioned beacons cannot be told
+*  apart from network PDUs by their format and are passed as network PDUs, as
+*  the library does. Until the node is provisioned it has no keys, so nothing
+*  is discarded.
+*
+*  Data from the GATT proxy still goes through the RX buffer of the library,
+*  but for the aggregated writes of CyMesh_BearerProxy.c, whose PDUs are
+*  queued in the ring by CyMesh_BearerRxInsert(). Remove this file and its
+*  --wrap options from the project to use the RX buffer of the library for all
+*  packets again.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <string.h>
+#include "CyMesh_BearerRx.h"
+#include "CyMesh_BearerProxy.h"
+#include "CyMesh_Configuration.h"
+#include "CyMesh_Security.h"
+
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+#define CYMESH_BEARER_RX_RING_MASK              (CYMESH_BEARER_RX_RING_SIZE - 1u)
+
+/* AD length + AD type in front of the mesh packet */
+#define CYMESH_BEARER_RX_AD_HEADER_LENGTH       (2u)
+
+/* Secure network beacon: Beacon type (1) + Flags (1) + Network ID (8) +
+ * IV index (4) + Authentication value (8) */
+#define CYMESH_BEARER_RX_SECURE_BEACON_LENGTH   (22u)
+#define CYMESH_BEARER_RX_NETWORK_ID_OFFSET      (2u)
+
+/* Bits compared by CyMesh_SecurityFindMeshId() */
+#define CYMESH_BEARER_RX_NID_BITS               (7u)
+#define CYMESH_BEARER_RX_NETWORK_ID_BITS        (64u)
+
+
+
+/*******************************************************************************
+* Data Structures
+*******************************************************************************/
+/* The library versions */
+extern CYBLE_API_RESULT_T __real_CyBle_Start(CYBLE_CALLBACK_T callbackFunc);
+extern CYMESH_API_RETURN_T __real_CyMesh_BearerStart(CYMESH_CALLBACK_T meshEventCallback);
+extern void __real_CyMesh_BearerProcessEvents(void);
+
+CYMESH_BEARER_RX_STATS_T cyMesh_BearerRxStats;
+
+static struct
+{
+    CYMESH_BEARER_RX_BUFFER_T ring[CYMESH_BEARER_RX_RING_SIZE];
+
+    /* Free running, the entry is the index masked */
+    uint8 in;
+    uint8 out;
+
+    /* Event handler of the library bearer, callback of the network layer */
+    CYBLE_CALLBACK_T bearerEventHandler;
+    CYMESH_CALLBACK_T networkCallback;
+} bearerRx;
+
+
+
+/*******************************************************************************
+* Static functions
+*******************************************************************************/
+/* Packet type of a mesh packet of the node's networks, or
+ * CYMESH_BEARER_BEACON_UNDEFINED */
+static CYMESH_BEARER_PACKET_TYPE_T CyMesh_BearerRxClassify(const uint8 * pdu, uint8 length)
+{
+    uint8 meshIds[CYMESH_MAX_NETWORK_KEYS];
+
+    if(cyMesh_ConfigInfoRam.bearerRole == CYMESH_ROLE_UNPROVISIONED)
+    {
+        return CYMESH_BEARER_ADV;
+    }
+
+    if((length == CYMESH_BEARER_RX_SECURE_BEACON_LENGTH) &&
+       (pdu[0] == CYMESH_BEARER_BEACON_TYPE_SECURE_BEACON) &&
+       (CyMesh_SecurityFindMeshId(&pdu[CYMESH_BEARER_RX_NETWORK_ID_OFFSET], CYMESH_BEARER_RX_NETWORK_ID_BITS,
+                                  meshIds) != 0u))
+    {
+        return CYMESH_BEARER_BEACON_SECURE_NETWORK;
+    }
+
+    if(CyMesh_SecurityFindMeshId(pdu, CYMESH_BEARER_RX_NID_BITS, meshIds) != 0u)
+    {
+        return CYMESH_BEARER_ADV;
+    }
+
+    return CYMESH_BEARER_BEACON_UNDEFINED;
+}
+
+
+static void CyMesh_BearerRxEventHandler(uint32 event, void * eventParam)
+{
+    if((event == CYBLE_EVT_GAPC_SCAN_PROGRESS_RESULT) &&
+       (CyMesh_BearerRxReport((const CYBLE_GAPC_ADV_REPORT_T *)eventParam) == true))
+    {
+        return;
+    }
+
+#if (CYMESH_ENABLE_PROXY_AGGREGATION == 1)
+    if(CyMesh_BearerProxyEvent(event, eventParam) == true)
+    {
+        return;
+    }
+#endif
+
+    bearerRx.bearerEventHandler(event, eventParam);
+}
+
+
+/* Next free entry of the ring, NULL if it is full */
+static CYMESH_BEARER_RX_BUFFER_T * CyMesh_BearerRxTake(CYMESH_BEARER_PACKET_TYPE_T packetType)
+{
+    uint8 depth = (uint8)(bearerRx.in - bearerRx.out);
+
+    if(depth >= CYMESH_BEARER_RX_RING_SIZE)
+    {
+        cyMesh_BearerRxStats.overflow[packetType]++;
+        return NULL;
+    }
+
+    cyMesh_BearerRxStats.received[packetType]++;
+    if(depth >= cyMesh_BearerRxStats.maxDepth)
+    {
+        cyMesh_BearerRxStats.maxDepth = depth + 1u;
+    }
+
+    return &bearerRx.ring[bearerRx.in & CYMESH_BEARER_RX_RING_MASK];
+}
+
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+bool CyMesh_BearerRxReport(const CYBLE_GAPC_ADV_REPORT_T * advReport)
+{
+    const uint8 * data = advReport->data;
+    CYMESH_BEARER_RX_BUFFER_T * entry;
+    CYMESH_BEARER_PACKET_TYPE_T packetType;
+    uint8 length;
+
+    /* The checks of the library bearer */
+    if((advReport->eventType != CYBLE_GAPC_NON_CONN_UNDIRECTED_ADV) ||
+       (advReport->dataLen <= CYMESH_BEARER_RX_AD_HEADER_LENGTH) ||
+       (data[1] != CYMESH_BEARER_RX_AD_TYPE_MESH) || (data[0] >= CYMESH_BEARER_ADV_MAX_LENGTH))
+    {
+        cyMesh_BearerRxStats.notMesh++;
+        return false;
+    }
+
+    length = advReport->dataLen - CYMESH_BEARER_RX_AD_HEADER_LENGTH;
+    packetType = CyMesh_BearerRxClassify(&data[CYMESH_BEARER_RX_AD_HEADER_LENGTH], length);
+    if(packetType == CYMESH_BEARER_BEACON_UNDEFINED)
+    {
+        cyMesh_BearerRxStats.otherNetwork++;
+        return true;
+    }
+
+    entry = CyMesh_BearerRxTake(packetType);
+    if(entry == NULL)
+    {
+        return true;
+    }
+
+    memcpy(entry->data, &data[CYMESH_BEARER_RX_AD_HEADER_LENGTH], length);
+    entry->length = length;
+    entry->packetType = packetType;
+    entry->rssi = advReport->rssi;
+#if (CYMESH_BEARER_GATT_BEARER_ENABLED == 1)
+    memcpy(entry->device_addr.bdAddr, advReport->peerBdAddr, CYMESH_BEARER_BD_ADDRESS_LENGTH);
+    entry->device_addr.type = advReport->peerAddrType;
+#endif
+    bearerRx.in++;
+
+    return true;
+}
+
+
+bool CyMesh_BearerRxInsert(const uint8 * pdu, uint8 length)
+{
+    CYMESH_BEARER_RX_BUFFER_T * entry;
+
+    if(length > CYMESH_BEARER_ADV_MAX_LENGTH)
+    {
+        return false;
+    }
+
+    entry = CyMesh_BearerRxTake(CYMESH_BEARER_ADV);
+    if(entry == NULL)
+    {
+        return false;
+    }
+
+    /* As CyMesh_InsertProxyDataInBearerRx() of the library */
+    memcpy(entry->data, pdu, length);
+    entry->length = length;
+    entry->packetType = CYMESH_BEARER_ADV;
+    entry->rssi = 0;
+#if (CYMESH_BEARER_GATT_BEARER_ENABLED == 1)
+    memset(&entry->device_addr, 0, sizeof(entry->device_addr));
+#endif
+    bearerRx.in++;
+
+    return true;
+}
+
+
+void CyMesh_BearerRxProcess(void)
+{
+    while(bearerRx.out != bearerRx.in)
+    {
+        CYMESH_BEARER_RX_BUFFER_T * entry = &bearerRx.ring[bearerRx.out & CYMESH_BEARER_RX_RING_MASK];
+
+        if(entry->packetType == CYMESH_BEARER_BEACON_SECURE_NETWORK)
+        {
+            CyMesh_ConfigurationIncomingBeacon(CYMESH_EVT_MESH_BEACON_SECURE_NETWORK, entry);
+        }
+        else if((bearerRx.networkCallback != NULL) &&
+                (bearerRx.networkCallback(CYMESH_EVT_MESH_ADV, entry) == CYMESH_ERROR_THREAD_BUSY))
+        {
+            return;
+        }
+
+        bearerRx.out++;
+    }
+}
+
+
+CYBLE_API_RESULT_T __wrap_CyBle_Start(CYBLE_CALLBACK_T callbackFunc)
+{
+    bearerRx.bearerEventHandler = callbackFunc;
+
+    return __real_CyBle_Start(CyMesh_BearerRxEventHandler);
+}
+
+
+CYMESH_API_RETURN_T __wrap_CyMesh_BearerStart(CYMESH_CALLBACK_T meshEventCallback)
+{
+    bearerRx.networkCallback = meshEventCallback;
+    bearerRx.in = 0u;
+    bearerRx.out = 0u;
+
+    return __real_CyMesh_BearerStart(meshEventCallback);
+}
+
+
+void __wrap_CyMesh_BearerProcessEvents(void)
+{
+    __real_CyMesh_BearerProcessEvents();
+    CyMesh_BearerRxProcess();
+#if (CYMESH_ENABLE_PROXY_AGGREGATION == 1)
+    CyMesh_BearerProxyUpdate();
+#endif
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,176 @@
+/***************************************************************************//**
+* \file CyMesh_BearerRx.h
+* \version 1.0
+*
+* \brief
+*  This is the header file of the bearer RX path, which filters the received
+*  mesh advertisements and queues them in a ring for the network layer and the
+*  beacon handler.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined (CYMESH_BEARER_RX_H)
+#define CYMESH_BEARER_RX_H
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <stdbool.h>
+#include "CyMesh_Common.h"
+#include "CyMesh_Bearer.h"
+
+
+/*******************************************************************************
+* Compile Time Options
+*******************************************************************************/
+/* Received packets waiting for the network layer, a power of two */
+#if !defined(CYMESH_BEARER_RX_RING_SIZE)
+    #define CYMESH_BEARER_RX_RING_SIZE              (16u)
+#endif
+
+#if ((CYMESH_BEARER_RX_RING_SIZE & (CYMESH_BEARER_RX_RING_SIZE - 1u)) != 0u) || \
+    (CYMESH_BEARER_RX_RING_SIZE < 2u) || (CYMESH_BEARER_RX_RING_SIZE > 128u)
+    #error "The bearer RX ring size must be a power of two from 2 to 128"
+#endif
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+/* AD type of the mesh packets of the library bearer */
+#define CYMESH_BEARER_RX_AD_TYPE_MESH               (0xF0u)
+
+/* Packet types counted: ADV, unprovisioned and secure network beacons */
+#define CYMESH_BEARER_RX_TYPE_COUNT                 (CYMESH_BEARER_BEACON_SECURE_NETWORK + 1u)
+
+
+/*******************************************************************************
+* Structures and Enums
+*******************************************************************************/
+typedef struct
+{
+    /* Packets queued and packets lost to a full ring, per packet type */
+    uint32 received[CYMESH_BEARER_RX_TYPE_COUNT];
+    uint32 overflow[CYMESH_BEARER_RX_TYPE_COUNT];
+
+    /* Advertisements that are not mesh packets, passed to the application */
+    uint32 notMesh;
+
+    /* Mesh packets of another network, discarded */
+    uint32 otherNetwork;
+
+    /* Most packets in the ring at once */
+    uint8 maxDepth;
+} CYMESH_BEARER_RX_STATS_T;
+
+
+/*******************************************************************************
+* Globals
+*******************************************************************************/
+extern CYMESH_BEARER_RX_STATS_T cyMesh_BearerRxStats;
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+/******************************************************************************
+* Function Name: CyMesh_BearerRxReport
+*******************************************************************************
+*
+*  This function takes an advertising report of the BLE stack. A mesh packet
+* is queued in the ring, unless it belongs to another network. Other reports
+* go to the library bearer, which passes them to the application.
+*
+*  \param advReport: Advertising report
+*
+*  \return bool: true if the report was a mesh packet
+*
+******************************************************************************/
+bool CyMesh_BearerRxReport(const CYBLE_GAPC_ADV_REPORT_T * advReport);
+
+/******************************************************************************
+* Function Name: CyMesh_BearerRxInsert
+*******************************************************************************
+*
+*  This function queues a network PDU written by the GATT proxy client in the
+* ring, as CyMesh_InsertProxyDataInBearerRx() does in the RX buffer of the
+* library.
+*
+*  \param pdu: Network PDU
+*         length: Its length
+*
+*  \return bool: false if the ring is full
+*
+******************************************************************************/
+bool CyMesh_BearerRxInsert(const uint8 * pdu, uint8 length);
+
+/******************************************************************************
+* Function Name: CyMesh_BearerRxProcess
+*******************************************************************************
+*
+*  This function passes the queued packets on: network PDUs to the callback of
+* CyMesh_BearerStart(), beacons to CyMesh_ConfigurationIncomingBeacon(). It
+* stops at a packet the network layer is too busy to take, which is passed
+* again on the next call.
+*
+*  \param none:
+*
+*  \return none:
+*
+******************************************************************************/
+void CyMesh_BearerRxProcess(void);
+
+/******************************************************************************
+* Function Name: __wrap_CyBle_Start
+*******************************************************************************
+*
+*  With -Wl,--wrap=CyBle_Start the library bearer starts the BLE stack with
+* the event handler of the RX path, which takes the advertising reports and
+* the aggregated writes of the GATT proxy client, and passes the other events
+* to the bearer.
+*
+*  \param callbackFunc: Event handler of the library bearer
+*
+*  \return CYBLE_API_RESULT_T: As CyBle_Start()
+*
+******************************************************************************/
+CYBLE_API_RESULT_T __wrap_CyBle_Start(CYBLE_CALLBACK_T callbackFunc);
+
+/******************************************************************************
+* Function Name: __wrap_CyMesh_BearerStart
+*******************************************************************************
+*
+*  With -Wl,--wrap=CyMesh_BearerStart the callback of the network layer is
+* kept for the RX path, and the ring is emptied.
+*
+*  \param meshEventCallback: As CyMesh_BearerStart()
+*
+*  \return CYMESH_API_RETURN_T: As CyMesh_BearerStart()
+*
+******************************************************************************/
+CYMESH_API_RETURN_T __wrap_CyMesh_BearerStart(CYMESH_CALLBACK_T meshEventCallback);
+
+/******************************************************************************
+* Function Name: __wrap_CyMesh_BearerProcessEvents
+*******************************************************************************
+*
+*  With -Wl,--wrap=CyMesh_BearerProcessEvents the packets received while the
+* library bearer processed the BLE events are passed on by
+* CyMesh_BearerRxProcess(), and the GATT proxy sends what it has queued.
+*
+*  \param none:
+*
+*  \return none:
+*
+******************************************************************************/
+void __wrap_CyMesh_BearerProcessEvents(void);
+
+#endif
+/* [] END OF FILE */
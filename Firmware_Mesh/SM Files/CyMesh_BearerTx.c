@@ -0,0 +1,437 @@
+/***************************************************************************//**
+* \file CyMesh_BearerTx.c
+* \version 1.0
+*
+* \brief
+*  This file contains the bearer TX scheduler of the BLE SmartMesh v1
+*  solution.
+*
+*  The library bearer keeps the packets to advertise in CYMESH_BEARER_ADV_TX_
+*  BUFFER_SIZE entries with a priority bit, and takes them round-robin, each
+*  entry at most once per CYMESH_BEARER_NON_CONN_ADV_INTERVAL_MS. A relayed
+*  PDU then waits for every beacon queued before it, and the repeats of a
+*  packet go back to back when nothing else is queued.
+*
+*  With -Wl,--wrap=CyMesh_BearerSendData the non-connectable advertisements
+*  are queued here instead, in one of CYMESH_BEARER_TX_CLASS_COUNT traffic
+*  classes. Each class may hold its quota of the queue. A packet is due once
+*  it is queued, and again CYMESH_BEARER_TX_INTERVAL_<class> ms after each
+*  transmission; its deadline is the time it is due plus the latency of its
+*  class. CyMesh_BearerTxUpdate() gives the bearer the due packet with the
+*  earliest deadline, as a single transmission, whenever the TX buffer of the
+*  library is empty, so the repeats of one packet are interleaved with the
+*  other packets and the order is decided here.
+*
+*  The bearer cannot scan while it advertises, and each transmission keeps it
+*  advertising for CYMESH_BEARER_TX_ADV_SLOT_MS. The transmissions are given in
+*  bursts: a burst starts at a random offset of up to
+*  CYMESH_BEARER_TX_BURST_OFFSET_MS, so that neighbours relaying the same flood
+*  do not advertise in step, and goes on back to back, without a scan in
+*  between, until no packet is due or CYMESH_BEARER_TX_BURST_MAX packets are
+*  sent. The last one is followed by a scan that takes at least
+*  CYMESH_BEARER_TX_MIN_SCAN_PERCENT of the burst and scan together; due
+*  packets wait for its end.
+*
+*  Connectable advertisements and GATT packets are not queued, they go to the
+*  library bearer as before.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <string.h>
+#include "CyMesh_BearerTx.h"
+#include "CyMesh_Timer.h"
+
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+#define CYMESH_BEARER_TX_SINGLE                 (1u)
+#define CYMESH_BEARER_TX_PERCENT                (100u)
+
+
+
+/*******************************************************************************
+* Data Structures
+*******************************************************************************/
+typedef struct
+{
+    /* Time the packet was queued, is due and must go by, in ms */
+    uint32 queuedAt;
+    uint32 release;
+    uint32 deadline;
+
+    uint8 data[CYMESH_BEARER_ADV_MAX_LENGTH];
+    uint8 length;
+    uint8 packetType;
+    uint8 txClass;
+
+    /* Transmissions left */
+    uint8 count;
+
+    bool isScanFollowed;
+    bool isSent;
+    bool isValid;
+} CYMESH_BEARER_TX_ENTRY_T;
+
+/* The library versions */
+extern CYMESH_API_RETURN_T __real_CyMesh_BearerSendData(const uint8 * data, uint8 length,
+                                                        CYMESH_BEARER_PACKET_TYPE_T packetType, uint8 txCount,
+                                                        bool priority, bool isScanFollowed);
+extern CYMESH_BEARER_TX_BUFFER_STATE_T __real_CyMesh_BearerGetTxBufferStatus(void);
+
+CYMESH_BEARER_TX_STATS_T cyMesh_BearerTxStats[CYMESH_BEARER_TX_CLASS_COUNT];
+CYMESH_BEARER_TX_SLOT_STATS_T cyMesh_BearerTxSlotStats;
+
+static const uint8 bearerTxQuota[CYMESH_BEARER_TX_CLASS_COUNT] =
+{
+    CYMESH_BEARER_TX_QUOTA_PROVISIONING,
+    CYMESH_BEARER_TX_QUOTA_RELAY,
+    CYMESH_BEARER_TX_QUOTA_NETWORK,
+    CYMESH_BEARER_TX_QUOTA_BEACON
+};
+
+static const uint16 bearerTxLatency[CYMESH_BEARER_TX_CLASS_COUNT] =
+{
+    CYMESH_BEARER_TX_LATENCY_PROVISIONING,
+    CYMESH_BEARER_TX_LATENCY_RELAY,
+    CYMESH_BEARER_TX_LATENCY_NETWORK,
+    CYMESH_BEARER_TX_LATENCY_BEACON
+};
+
+static const uint16 bearerTxInterval[CYMESH_BEARER_TX_CLASS_COUNT] =
+{
+    CYMESH_BEARER_TX_INTERVAL_PROVISIONING,
+    CYMESH_BEARER_TX_INTERVAL_RELAY,
+    CYMESH_BEARER_TX_INTERVAL_NETWORK,
+    CYMESH_BEARER_TX_INTERVAL_BEACON
+};
+
+static struct
+{
+    CYMESH_BEARER_TX_ENTRY_T queue[CYMESH_BEARER_TX_QUEUE_SIZE];
+
+    /* Packets queued, in all and per class */
+    uint8 count;
+    uint8 classCount[CYMESH_BEARER_TX_CLASS_COUNT];
+
+    /* Burst on the air: start time and transmissions given, and whether the
+     * bearer has yet to take the last one. Otherwise, the end of the scan and
+     * the start of the next burst, once a packet is due. */
+    uint32 burstStart;
+    uint8 burstCount;
+    bool isBurst;
+    bool isBurstEnding;
+    uint32 scanEnd;
+    uint32 burstAt;
+    bool isBurstPending;
+
+    /* State of the random offsets, seeded on first use */
+    uint32 random;
+} bearerTx;
+
+
+
+/*******************************************************************************
+* Static functions
+*******************************************************************************/
+/* Times are compared across the wrap of the timestamp */
+static bool CyMesh_BearerTxIsBefore(uint32 time, uint32 reference)
+{
+    return ((int32)(time - reference) < 0);
+}
+
+
+/* Xorshift, seeded from the die coordinates so that the nodes differ */
+static uint32 CyMesh_BearerTxRandom(void)
+{
+    uint32 x = bearerTx.random;
+
+    if(x == 0u)
+    {
+        x = ((uint32)CY_GET_REG8(CYREG_SFLASH_DIE_X) << 8) | CY_GET_REG8(CYREG_SFLASH_DIE_Y);
+        x = (x << 16) ^ CyMesh_TimerGetTimestamp() ^ 0x5A5A5A5Au;
+    }
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    bearerTx.random = x;
+
+    return x;
+}
+
+
+/* Due packet with the earliest deadline other than skip, NULL if none is
+ * due */
+static CYMESH_BEARER_TX_ENTRY_T * CyMesh_BearerTxNext(uint32 now, const CYMESH_BEARER_TX_ENTRY_T * skip)
+{
+    CYMESH_BEARER_TX_ENTRY_T * next = NULL;
+    uint8 i;
+
+    for(i = 0u; i < CYMESH_BEARER_TX_QUEUE_SIZE; i++)
+    {
+        CYMESH_BEARER_TX_ENTRY_T * entry = &bearerTx.queue[i];
+
+        if((entry->isValid == true) && (entry != skip) && (CyMesh_BearerTxIsBefore(now, entry->release) == false) &&
+           ((next == NULL) || CyMesh_BearerTxIsBefore(entry->deadline, next->deadline)))
+        {
+            next = entry;
+        }
+    }
+
+    return next;
+}
+
+
+static void CyMesh_BearerTxSent(CYMESH_BEARER_TX_ENTRY_T * entry, uint32 now)
+{
+    CYMESH_BEARER_TX_STATS_T * stats = &cyMesh_BearerTxStats[entry->txClass];
+
+    stats->sent++;
+    if(CyMesh_BearerTxIsBefore(entry->deadline, now) == true)
+    {
+        stats->late++;
+    }
+    if((entry->isSent == false) && ((now - entry->queuedAt) > stats->maxLatency))
+    {
+        stats->maxLatency = now - entry->queuedAt;
+    }
+
+    entry->isSent = true;
+    entry->count--;
+    if(entry->count == 0u)
+    {
+        entry->isValid = false;
+        bearerTx.classCount[entry->txClass]--;
+        bearerTx.count--;
+        return;
+    }
+
+    entry->release = now + bearerTxInterval[entry->txClass];
+    entry->deadline = entry->release + bearerTxLatency[entry->txClass];
+}
+
+
+/* Whether a transmission may be given now, starting a burst if it is time.
+ * next is the due packet with the earliest deadline. */
+static bool CyMesh_BearerTxIsSlot(const CYMESH_BEARER_TX_ENTRY_T * next, uint32 now)
+{
+    if(bearerTx.isBurst == true)
+    {
+        return true;
+    }
+
+    if(CyMesh_BearerTxIsBefore(now, bearerTx.scanEnd) == true)
+    {
+        cyMesh_BearerTxSlotStats.scanHold++;
+        return false;
+    }
+
+    if(bearerTx.isBurstPending == false)
+    {
+        bearerTx.burstAt = now + (CyMesh_BearerTxRandom() % (CYMESH_BEARER_TX_BURST_OFFSET_MS + 1u));
+        if((CyMesh_BearerTxIsBefore(next->deadline, bearerTx.burstAt) == true) &&
+           (CyMesh_BearerTxIsBefore(next->deadline, now) == false))
+        {
+            bearerTx.burstAt = next->deadline;
+        }
+        bearerTx.isBurstPending = true;
+    }
+
+    if(CyMesh_BearerTxIsBefore(now, bearerTx.burstAt) == true)
+    {
+        return false;
+    }
+
+    bearerTx.isBurstPending = false;
+    bearerTx.isBurst = true;
+    bearerTx.burstStart = now;
+    bearerTx.burstCount = 0u;
+    cyMesh_BearerTxSlotStats.bursts++;
+
+    return true;
+}
+
+
+/* The bearer has started the last transmission of the burst: the scan is
+ * held for its share of the radio time */
+static void CyMesh_BearerTxBurstEnd(uint32 now)
+{
+    uint32 advTime = (now - bearerTx.burstStart) + CYMESH_BEARER_TX_ADV_SLOT_MS;
+
+    cyMesh_BearerTxSlotStats.advTime += advTime;
+    bearerTx.scanEnd = now + CYMESH_BEARER_TX_ADV_SLOT_MS +
+                       ((advTime * CYMESH_BEARER_TX_MIN_SCAN_PERCENT) /
+                        (CYMESH_BEARER_TX_PERCENT - CYMESH_BEARER_TX_MIN_SCAN_PERCENT));
+    bearerTx.isBurstEnding = false;
+}
+
+
+static CYMESH_BEARER_TX_CLASS_T CyMesh_BearerTxClassOf(CYMESH_BEARER_PACKET_TYPE_T packetType, bool priority)
+{
+    if((priority == true) || (packetType == CYMESH_BEARER_PB_ADV))
+    {
+        return CYMESH_BEARER_TX_CLASS_PROVISIONING;
+    }
+
+    return (packetType == CYMESH_BEARER_ADV) ? CYMESH_BEARER_TX_CLASS_NETWORK : CYMESH_BEARER_TX_CLASS_BEACON;
+}
+
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+CYMESH_API_RETURN_T CyMesh_BearerTxSend(const uint8 * data, uint8 length, CYMESH_BEARER_PACKET_TYPE_T packetType,
+                                        CYMESH_BEARER_TX_CLASS_T txClass, uint8 txCount, bool isScanFollowed)
+{
+    CYMESH_BEARER_TX_ENTRY_T * entry = NULL;
+    uint8 interruptState;
+    uint32 now;
+    uint8 i;
+
+    if((data == NULL) || (length > CYMESH_BEARER_ADV_MAX_LENGTH) || (txClass >= CYMESH_BEARER_TX_CLASS_COUNT))
+    {
+        return CYMESH_ERROR_INVALID_PARAM;
+    }
+
+    now = CyMesh_TimerGetTimestamp();
+    interruptState = CyEnterCriticalSection();
+
+    if((bearerTx.classCount[txClass] < bearerTxQuota[txClass]) && (bearerTx.count < CYMESH_BEARER_TX_QUEUE_SIZE))
+    {
+        for(i = 0u; (i < CYMESH_BEARER_TX_QUEUE_SIZE) && (entry == NULL); i++)
+        {
+            entry = (bearerTx.queue[i].isValid == false) ? &bearerTx.queue[i] : NULL;
+        }
+    }
+
+    if(entry == NULL)
+    {
+        cyMesh_BearerTxStats[txClass].dropped++;
+        CyExitCriticalSection(interruptState);
+        return CYMESH_ERROR_BEARER_TX_BUFFER_FULL;
+    }
+
+    memcpy(entry->data, data, length);
+    entry->length = length;
+    entry->packetType = packetType;
+    entry->txClass = txClass;
+    entry->count = (txCount == 0u) ? CYMESH_BEARER_TX_SINGLE : txCount;
+    entry->isScanFollowed = isScanFollowed;
+    entry->isSent = false;
+    entry->queuedAt = now;
+    entry->release = now;
+    entry->deadline = now + bearerTxLatency[txClass];
+    entry->isValid = true;
+
+    bearerTx.classCount[txClass]++;
+    bearerTx.count++;
+    cyMesh_BearerTxStats[txClass].queued++;
+
+    CyExitCriticalSection(interruptState);
+
+    return CYMESH_ERROR_OK;
+}
+
+
+void CyMesh_BearerTxUpdate(void)
+{
+    CYMESH_BEARER_TX_ENTRY_T * entry;
+    uint8 interruptState;
+    bool isLast;
+    uint32 now;
+
+    if(((bearerTx.count == 0u) && (bearerTx.isBurstEnding == false)) ||
+       (__real_CyMesh_BearerGetTxBufferStatus() != CYMESH_BEARER_TX_BUFFER_EMPTY))
+    {
+        return;
+    }
+
+    now = CyMesh_TimerGetTimestamp();
+    interruptState = CyEnterCriticalSection();
+
+    if(bearerTx.isBurstEnding == true)
+    {
+        CyMesh_BearerTxBurstEnd(now);
+    }
+
+    entry = CyMesh_BearerTxNext(now, NULL);
+    if((entry != NULL) && (CyMesh_BearerTxIsSlot(entry, now) == true))
+    {
+        /* Back to back with the next due packet, or the end of the burst */
+        isLast = ((bearerTx.burstCount + 1u) >= CYMESH_BEARER_TX_BURST_MAX) ||
+                 (CyMesh_BearerTxNext(now, entry) == NULL);
+
+        if(__real_CyMesh_BearerSendData(entry->data, entry->length, (CYMESH_BEARER_PACKET_TYPE_T)entry->packetType,
+                                        CYMESH_BEARER_TX_SINGLE, false,
+                                        (isLast == true) ? entry->isScanFollowed : false) == CYMESH_ERROR_OK)
+        {
+            CyMesh_BearerTxSent(entry, now);
+            bearerTx.burstCount++;
+            bearerTx.isBurst = !isLast;
+            bearerTx.isBurstEnding = isLast;
+        }
+    }
+
+    CyExitCriticalSection(interruptState);
+}
+
+
+CYMESH_API_RETURN_T __wrap_CyMesh_BearerSendData(const uint8 * data, uint8 length,
+                                                 CYMESH_BEARER_PACKET_TYPE_T packetType, uint8 txCount,
+                                                 bool priority, bool isScanFollowed)
+{
+#if (CYMESH_ENABLE_BEARER_TX_SCHEDULER == 1)
+    switch(packetType)
+    {
+        case CYMESH_BEARER_ADV:
+        case CYMESH_BEARER_BEACON_UNPROVISIONED_NODE:
+        case CYMESH_BEARER_BEACON_SECURE_NETWORK:
+        case CYMESH_BEARER_PB_ADV:
+        case CYMESH_BEARER_CUSTOM_ADV:
+            return CyMesh_BearerTxSend(data, length, packetType, CyMesh_BearerTxClassOf(packetType, priority),
+                                       txCount, isScanFollowed);
+
+        default:
+            return __real_CyMesh_BearerSendData(data, length, packetType, txCount, priority, isScanFollowed);
+    }
+#else
+    /* CyMesh_BearerTxUpdate() is not called, so nothing may be queued */
+    return __real_CyMesh_BearerSendData(data, length, packetType, txCount, priority, isScanFollowed);
+#endif
+}
+
+
+CYMESH_BEARER_TX_BUFFER_STATE_T __wrap_CyMesh_BearerGetTxBufferStatus(void)
+{
+#if (CYMESH_ENABLE_BEARER_TX_SCHEDULER == 1)
+    if(bearerTx.count == 0u)
+    {
+        return __real_CyMesh_BearerGetTxBufferStatus();
+    }
+    if(bearerTx.count >= CYMESH_BEARER_TX_QUEUE_SIZE)
+    {
+        return CYMESH_BEARER_TX_BUFFER_FULL;
+    }
+
+    return (bearerTx.count > (CYMESH_BEARER_TX_QUEUE_SIZE / 2u)) ? CYMESH_BEARER_TX_BUFFER_BUSY
+                                                                  : CYMESH_BEARER_TX_BUFFER_FREE;
+#else
+    return __real_CyMesh_BearerGetTxBufferStatus();
+#endif
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,258 @@
+/***************************************************************************//**
+* \file CyMesh_BearerTx.h
+* \version 1.0
+*
+* \brief
+*  This is the header file of the bearer TX scheduler, which queues the
+*  non-connectable advertisements of the node by traffic class and hands them
+*  to the bearer one transmission at a time, earliest deadline first, in
+*  bursts separated by scans.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined (CYMESH_BEARER_TX_H)
+#define CYMESH_BEARER_TX_H
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <stdbool.h>
+#include "CyMesh_Common.h"
+#include "CyMesh_Bearer.h"
+
+
+/*******************************************************************************
+* Compile Time Options
+*******************************************************************************/
+/* Packets queued over all classes */
+#if !defined(CYMESH_BEARER_TX_QUEUE_SIZE)
+    #define CYMESH_BEARER_TX_QUEUE_SIZE             (16u)
+#endif
+
+/* Packets each class may queue. The sum should not exceed the queue size, so
+ * that no class can take the room of another. */
+#if !defined(CYMESH_BEARER_TX_QUOTA_PROVISIONING)
+    #define CYMESH_BEARER_TX_QUOTA_PROVISIONING     (3u)
+#endif
+#if !defined(CYMESH_BEARER_TX_QUOTA_RELAY)
+    #define CYMESH_BEARER_TX_QUOTA_RELAY            (5u)
+#endif
+#if !defined(CYMESH_BEARER_TX_QUOTA_NETWORK)
+    #define CYMESH_BEARER_TX_QUOTA_NETWORK          (3u)
+#endif
+#if !defined(CYMESH_BEARER_TX_QUOTA_BEACON)
+    #define CYMESH_BEARER_TX_QUOTA_BEACON           (5u)
+#endif
+
+/* Time a packet of each class may wait for a transmission once it is due,
+ * in ms. It sets the deadline, so a smaller value goes first. */
+#if !defined(CYMESH_BEARER_TX_LATENCY_PROVISIONING)
+    #define CYMESH_BEARER_TX_LATENCY_PROVISIONING   (20u)
+#endif
+#if !defined(CYMESH_BEARER_TX_LATENCY_RELAY)
+    #define CYMESH_BEARER_TX_LATENCY_RELAY          (10u)
+#endif
+#if !defined(CYMESH_BEARER_TX_LATENCY_NETWORK)
+    #define CYMESH_BEARER_TX_LATENCY_NETWORK        (30u)
+#endif
+#if !defined(CYMESH_BEARER_TX_LATENCY_BEACON)
+    #define CYMESH_BEARER_TX_LATENCY_BEACON         (200u)
+#endif
+
+/* Time between two transmissions of the same packet, in ms. Other packets
+ * are sent in between. */
+#if !defined(CYMESH_BEARER_TX_INTERVAL_PROVISIONING)
+    #define CYMESH_BEARER_TX_INTERVAL_PROVISIONING  (20u)
+#endif
+#if !defined(CYMESH_BEARER_TX_INTERVAL_RELAY)
+    #define CYMESH_BEARER_TX_INTERVAL_RELAY         (20u)
+#endif
+#if !defined(CYMESH_BEARER_TX_INTERVAL_NETWORK)
+    #define CYMESH_BEARER_TX_INTERVAL_NETWORK       (20u)
+#endif
+#if !defined(CYMESH_BEARER_TX_INTERVAL_BEACON)
+    #define CYMESH_BEARER_TX_INTERVAL_BEACON        (50u)
+#endif
+
+/* Radio time slots. The bearer does not scan while it advertises, so the due
+ * packets are sent in bursts of at most this many transmissions, back to
+ * back, with a scan between bursts. The library bearer waits its random delay
+ * of up to 8 ms before each advertisement, scanning after a scan-followed
+ * packet but advertising within a burst, so with it a burst of one keeps the
+ * radio scanning longest. */
+#if !defined(CYMESH_BEARER_TX_BURST_MAX)
+    #define CYMESH_BEARER_TX_BURST_MAX              (1u)
+#endif
+
+/* A burst starts at a random offset of up to this many ms, so that nodes
+ * relaying the same PDU do not advertise in step. The offset never takes the
+ * first packet past its deadline. */
+#if !defined(CYMESH_BEARER_TX_BURST_OFFSET_MS)
+    #define CYMESH_BEARER_TX_BURST_OFFSET_MS        (4u)
+#endif
+
+/* Share of the radio time kept for scanning, in percent. After a burst the
+ * bearer scans for at least this share of the burst and the scan together.
+ * 0 sends the next burst at once. */
+#if !defined(CYMESH_BEARER_TX_MIN_SCAN_PERCENT)
+    #define CYMESH_BEARER_TX_MIN_SCAN_PERCENT       (50u)
+#endif
+
+/* Time the library bearer advertises one packet before it looks for the
+ * next, see CyMesh_BearerIsItTime(), in ms */
+#define CYMESH_BEARER_TX_ADV_SLOT_MS                (5u)
+
+#if (CYMESH_BEARER_TX_BURST_MAX == 0u) || (CYMESH_BEARER_TX_MIN_SCAN_PERCENT >= 100u)
+    #error "The bearer TX burst must hold a packet and leave time to advertise"
+#endif
+
+#if ((CYMESH_BEARER_TX_QUOTA_PROVISIONING + CYMESH_BEARER_TX_QUOTA_RELAY + CYMESH_BEARER_TX_QUOTA_NETWORK + \
+      CYMESH_BEARER_TX_QUOTA_BEACON) > CYMESH_BEARER_TX_QUEUE_SIZE)
+    #warning "The bearer TX quotas exceed the queue size, one class may fill it"
+#endif
+
+
+/*******************************************************************************
+* Structures and Enums
+*******************************************************************************/
+typedef enum
+{
+    /* PB-ADV, and packets sent with priority set */
+    CYMESH_BEARER_TX_CLASS_PROVISIONING,
+
+    /* Network PDUs relayed for other nodes */
+    CYMESH_BEARER_TX_CLASS_RELAY,
+
+    /* Network PDUs of the node */
+    CYMESH_BEARER_TX_CLASS_NETWORK,
+
+    /* Mesh beacons and custom ADVs */
+    CYMESH_BEARER_TX_CLASS_BEACON,
+
+    CYMESH_BEARER_TX_CLASS_COUNT
+} CYMESH_BEARER_TX_CLASS_T;
+
+typedef struct
+{
+    /* Packets accepted */
+    uint32 queued;
+
+    /* Packets refused because the quota of the class or the queue was full */
+    uint32 dropped;
+
+    /* Transmissions handed to the bearer, and those that went after their
+     * deadline */
+    uint32 sent;
+    uint32 late;
+
+    /* Longest wait of a first transmission since the packet was queued, in
+     * ms */
+    uint32 maxLatency;
+} CYMESH_BEARER_TX_STATS_T;
+
+typedef struct
+{
+    /* Bursts sent, and the radio time they took in ms */
+    uint32 bursts;
+    uint32 advTime;
+
+    /* Time due packets waited for the scan after a burst, in ms */
+    uint32 scanHold;
+} CYMESH_BEARER_TX_SLOT_STATS_T;
+
+
+/*******************************************************************************
+* Globals
+*******************************************************************************/
+extern CYMESH_BEARER_TX_STATS_T cyMesh_BearerTxStats[CYMESH_BEARER_TX_CLASS_COUNT];
+extern CYMESH_BEARER_TX_SLOT_STATS_T cyMesh_BearerTxSlotStats;
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+/******************************************************************************
+* Function Name: CyMesh_BearerTxSend
+*******************************************************************************
+*
+*  This function queues a non-connectable advertisement in a traffic class.
+* The first transmission is due at once, and each further one
+* CYMESH_BEARER_TX_INTERVAL_<class> ms after the previous.
+*
+*  \param data: Payload, as for CyMesh_BearerSendData()
+*         length: Length of the payload
+*         packetType: CYMESH_BEARER_ADV, CYMESH_BEARER_BEACON_UNPROVISIONED_NODE,
+*                     CYMESH_BEARER_BEACON_SECURE_NETWORK, CYMESH_BEARER_PB_ADV
+*                     or CYMESH_BEARER_CUSTOM_ADV
+*         txClass: Traffic class
+*         txCount: Number of transmissions, at least one
+*         isScanFollowed: Scan after the transmissions. The scan follows the
+*                         burst the transmission is sent in.
+*
+*  \return CYMESH_API_RETURN_T: CYMESH_ERROR_OK,
+*          CYMESH_ERROR_BEARER_TX_BUFFER_FULL if the class has used its quota
+*          or the queue is full, CYMESH_ERROR_INVALID_PARAM otherwise
+*
+******************************************************************************/
+CYMESH_API_RETURN_T CyMesh_BearerTxSend(const uint8 * data, uint8 length, CYMESH_BEARER_PACKET_TYPE_T packetType,
+                                        CYMESH_BEARER_TX_CLASS_T txClass, uint8 txCount, bool isScanFollowed);
+
+/******************************************************************************
+* Function Name: CyMesh_BearerTxUpdate
+*******************************************************************************
+*
+*  This function runs on the SM timer (1 ms). Once the bearer has started the
+* previous transmission, it gives it the due packet with the earliest
+* deadline, unless the bearer is to scan. A burst starts at a random offset
+* after the scan and ends when no packet is due or
+* CYMESH_BEARER_TX_BURST_MAX packets have been sent.
+*
+*  \param none:
+*
+*  \return none:
+*
+******************************************************************************/
+void CyMesh_BearerTxUpdate(void);
+
+/******************************************************************************
+* Function Name: __wrap_CyMesh_BearerSendData
+*******************************************************************************
+*
+*  With -Wl,--wrap=CyMesh_BearerSendData the non-connectable advertisements
+* of the library and the application are queued by CyMesh_BearerTxSend(), in
+* the class of their packet type. Connectable advertisements and GATT packets
+* go to the library, as everything does with CYMESH_ENABLE_BEARER_TX_SCHEDULER
+* at 0.
+*
+*  \param As CyMesh_BearerSendData()
+*
+*  \return CYMESH_API_RETURN_T: As CyMesh_BearerSendData()
+*
+******************************************************************************/
+CYMESH_API_RETURN_T __wrap_CyMesh_BearerSendData(const uint8 * data, uint8 length,
+                                                 CYMESH_BEARER_PACKET_TYPE_T packetType, uint8 txCount,
+                                                 bool priority, bool isScanFollowed);
+
+/******************************************************************************
+* Function Name: __wrap_CyMesh_BearerGetTxBufferStatus
+*******************************************************************************
+*
+*  With -Wl,--wrap=CyMesh_BearerGetTxBufferStatus the layers that wait for
+* room in the bearer see the state of the queue.
+*
+*  \param none:
+*
+*  \return CYMESH_BEARER_TX_BUFFER_STATE_T: State of the queue
+*
+******************************************************************************/
+CYMESH_BEARER_TX_BUFFER_STATE_T __wrap_CyMesh_BearerGetTxBufferStatus(void);
+
+#endif
+/* [] END OF FILE */
@@ -71,6 +71,12 @@ CYMESH_FRIENDLIST_T cyMesh_FriendListRam;
 extern void CyMesh_NetworkManagementTimer(void);
 extern void CyMesh_ConfigSendUnprovisionedBeacon(void);
 extern void CyMesh_BearerSendGATTProxyADV(void);
+extern void CyMesh_NetworkReplayUpdate(void);
+extern void CyMesh_ConfigLogUpdate(void);
+extern void CyMesh_BeaconUpdate(void);
+extern void CyMesh_NetworkFloodUpdate(void);
+extern void CyMesh_BearerTxUpdate(void);
+extern void CyMesh_TransportSarUpdate(void);
 
 /* RAM copy for the entire information */
 CYMESH_DEVICE_CONFIG_T cyMesh_ConfigInfoRam;
@@ -322,8 +328,29 @@ void CyMesh_SMHandleTimer(void)
 	#endif
 	
 	#if (CYMESH_ENABLE_CONFIGINFO_PERIODIC_UPDATE == 1)
+	#if (CYMESH_ENABLE_CONFIGINFO_LOG == 1)
+		CyMesh_ConfigLogUpdate();
+	#else
 		CyMesh_ConfigInfoUpdate();
 	#endif
+		CyMesh_NetworkReplayUpdate();
+	#endif
+	
+	#if (CYMESH_ENABLE_BEACON_MANAGER == 1)
+		CyMesh_BeaconUpdate();
+	#endif
+	
+	#if (CYMESH_ENABLE_MANAGED_FLOODING == 1)
+		CyMesh_NetworkFloodUpdate();
+	#endif
+	
+	#if (CYMESH_ENABLE_SEGMENTATION == 1)
+		CyMesh_TransportSarUpdate();
+	#endif
+	
+	#if (CYMESH_ENABLE_BEARER_TX_SCHEDULER == 1)
+		CyMesh_BearerTxUpdate();
+	#endif
 }
 
 /******************************************************************************
@@ -98,6 +98,14 @@
 #define CYMESH_CONFIG_PB_GATT_SUPPORTED			(1)		/* to enable provisioning over GATT  */
 	
 #define CYMESH_ENABLE_CONFIGINFO_PERIODIC_UPDATE (1)
+#define CYMESH_ENABLE_CONFIGINFO_LOG			(1)		/* log config changes, needs -Wl,--wrap=CyMesh_ConfigurationSave */
+#define CYMESH_ENABLE_BEACON_MANAGER			(1)		/* secure beacons, needs the --wrap options in CyMesh_Beacon.c */
+#define CYMESH_ENABLE_BEARER_TX_SCHEDULER		(1)		/* classed TX queue, needs the --wrap options in CyMesh_BearerTx.c */
+#define CYMESH_ENABLE_MANAGED_FLOODING			(1)		/* relay back-off and suppression, see CyMesh_NetworkFlood.c */
+#define CYMESH_ENABLE_TTL_LEARNING				(1)		/* TTL from the learned hop distance, see CyMesh_NetworkHops.c */
+#define CYMESH_ENABLE_SEGMENTATION				(1)		/* segmented messages with block ACKs, see CyMesh_TransportSar.c */
+#define CYMESH_ENABLE_ADAPTIVE_RTO				(1)		/* reliable message timeouts from the round trip time, see CyMesh_MessageQueueRto.c */
+#define CYMESH_ENABLE_PROXY_AGGREGATION			(1)		/* paced and aggregated GATT proxy PDUs, needs the --wrap options in CyMesh_BearerProxy.c */
 /*******************************************************************************
 * Macros
 *******************************************************************************/
@@ -309,7 +317,13 @@ typedef enum
 	
     CYMESH_EVT_MESSAGE_VENDOR_SPECIFIC_REL_SET,
     
-    CYMESH_EVT_MESSAGE_VENDOR_SPECIFIC_STATUS
+    CYMESH_EVT_MESSAGE_VENDOR_SPECIFIC_STATUS,
+    
+    /* A reliable message sent by this device received its response. Raised
+     * with CYMESH_ENABLE_ADAPTIVE_RTO; the parameter is a pointer to
+     * CYMESH_APP_RELIABLE_MSG_COMPLETE_PARAM_T.
+     */
+    CYMESH_EVT_RELIABLE_MESSAGE_COMPLETE
 } CYMESH_EVENT_T;
 
 
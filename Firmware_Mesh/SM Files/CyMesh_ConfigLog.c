@@ -0,0 +1,409 @@
+/***************************************************************************//**
+* \file CyMesh_ConfigLog.c
+* \version 1.0
+*
+* \brief
+*  This file contains the configuration log of the BLE SmartMesh v1 solution.
+*
+*  cyMesh_ConfigInfoFlash stays the base image. The words of
+*  cyMesh_ConfigInfoRam that changed since the base was written are kept in a
+*  bitmap, and every log write puts all of them, as records, in the next row
+*  of a ring of CYMESH_CONFIG_LOG_ROWS flash rows. PSoC 4 flash is erased and
+*  programmed a row at a time, so appending to a row would cost a row write
+*  anyway; writing the next row instead spreads the wear over the ring, and a
+*  reset during a write loses only that write, as the previous row is intact.
+*  The base is rewritten only when the changed words no longer fit in a row.
+*
+*  The seq_num reservations of the transport layer are the frequent writer:
+*  one every CYMESH_TRAN_SEQNO_FLASH_INCREMENT_VALUE packets, each a full
+*  720 byte save (6 rows) without the log. The log reserves
+*  CYMESH_CONFIG_LOG_SEQ_RESERVE more SEQ numbers per write, so it writes one
+*  row every 1200 packets. Tools/config_log_bench counts the flash writes.
+*
+*  A write of the whole configuration by the library (provisioning, a new IV
+*  index) changes the hash of the base and so discards the log.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <stddef.h>
+#include <string.h>
+#include "CyMesh_ConfigLog.h"
+#include "CyMesh_Configuration.h"
+
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+#define CYMESH_CONFIG_LOG_SEQ_WORD              (offsetof(CYMESH_DEVICE_CONFIG_T, seq_num) / sizeof(uint32))
+#define CYMESH_CONFIG_LOG_CHECKSUM_WORD         (offsetof(CYMESH_DEVICE_CONFIG_T, checksum) / sizeof(uint32))
+#define CYMESH_CONFIG_LOG_BITMAP_WORDS          ((CYMESH_CONFIG_LOG_WORDS + 31u) / 32u)
+
+#define CYMESH_CONFIG_LOG_RECORD(first, count)  (((uint32)(first) << 16) | (count))
+#define CYMESH_CONFIG_LOG_RECORD_FIRST(record)  ((record) >> 16)
+#define CYMESH_CONFIG_LOG_RECORD_COUNT(record)  ((record) & 0xFFFFu)
+
+/* Checksum of an empty row, so that erased or zeroed flash does not pass */
+#define CYMESH_CONFIG_LOG_CHECKSUM_SEED         (0x434C4F47u)
+
+/* FNV-1a, a word at a time */
+#define CYMESH_CONFIG_LOG_HASH_SEED             (0x811C9DC5u)
+#define CYMESH_CONFIG_LOG_HASH_PRIME            (0x01000193u)
+
+
+
+/*******************************************************************************
+* Data Structures
+*******************************************************************************/
+
+/* Set by the configuration model when cyMesh_ConfigInfoRam changed */
+extern uint8 CyMesh_ConfigInfoFlashUpdateRequired;
+
+/* The library version, for a write of the whole configuration */
+extern bool __real_CyMesh_ConfigurationSave(void);
+
+/* Flash ring - flash row aligned and excluded from the Bootloadable checksum,
+ * as cyMesh_ConfigInfoFlash */
+#if defined(__ARMCC_VERSION)
+    CY_ALIGN(CYDEV_FLS_ROW_SIZE) const CYMESH_CONFIG_LOG_ROW_T cyMesh_ConfigLogFlash[CYMESH_CONFIG_LOG_ROWS] CY_SECTION(".cy_checksum_exclude") =
+#elif defined (__GNUC__)
+    const CYMESH_CONFIG_LOG_ROW_T cyMesh_ConfigLogFlash[CYMESH_CONFIG_LOG_ROWS] CY_SECTION(".cy_checksum_exclude")
+        CY_ALIGN(CYDEV_FLS_ROW_SIZE) =
+#elif defined (__ICCARM__)
+    #pragma data_alignment=CY_FLASH_SIZEOF_ROW
+    #pragma location=".cy_checksum_exclude"
+    const CYMESH_CONFIG_LOG_ROW_T cyMesh_ConfigLogFlash[CYMESH_CONFIG_LOG_ROWS] =
+#endif  /* (__ARMCC_VERSION) */
+{
+    /* All rows never written */
+    {0}
+};
+
+static struct
+{
+    /* Words of cyMesh_ConfigInfoRam that differ from the base image */
+    uint32 changed[CYMESH_CONFIG_LOG_BITMAP_WORDS];
+
+    /* Hash of the base image */
+    uint32 baseHash;
+
+    /* seq_num in flash, in the newest log row or the base */
+    uint32 reservedSeq;
+
+    /* seq_num at the last save of the transport layer; it only goes down
+     * when the SEQ wraps */
+    uint32 seqNum;
+
+    uint32 epoch;
+    uint32 updateCountdown;
+    uint8 row;
+
+    /* Set while the transport layer saves, which the SM timer interrupts */
+    bool isBusy;
+} configLog;
+
+
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+static uint32 CyMesh_ConfigLogChecksum(const CYMESH_CONFIG_LOG_ROW_T * row)
+{
+    uint32 checksum = CYMESH_CONFIG_LOG_CHECKSUM_SEED + row->epoch + row->baseHash + row->length;
+    uint32 i;
+
+    for(i = 0; (i < row->length) && (i < CYMESH_CONFIG_LOG_DATA_WORDS); i++)
+    {
+        checksum += row->data[i];
+    }
+
+    return checksum;
+}
+
+
+static uint32 CyMesh_ConfigLogBaseHash(void)
+{
+    const uint32 * base = (const uint32 *)&cyMesh_ConfigInfoFlash;
+    uint32 hash = CYMESH_CONFIG_LOG_HASH_SEED;
+    uint32 i;
+
+    for(i = 0; i < CYMESH_CONFIG_LOG_WORDS; i++)
+    {
+        hash = (hash ^ base[i]) * CYMESH_CONFIG_LOG_HASH_PRIME;
+    }
+
+    return hash;
+}
+
+
+static bool CyMesh_ConfigLogIsChanged(uint32 word)
+{
+    return ((configLog.changed[word / 32u] >> (word % 32u)) & 1u) != 0u;
+}
+
+
+static void CyMesh_ConfigLogSetChanged(uint32 word, bool isChanged)
+{
+    if(isChanged == true)
+    {
+        configLog.changed[word / 32u] |= (uint32)1u << (word % 32u);
+    }
+    else
+    {
+        configLog.changed[word / 32u] &= ~((uint32)1u << (word % 32u));
+    }
+}
+
+
+/* Starts an empty log on the current cyMesh_ConfigInfoFlash */
+static void CyMesh_ConfigLogRebase(void)
+{
+    memset(configLog.changed, 0, sizeof(configLog.changed));
+    configLog.baseHash = CyMesh_ConfigLogBaseHash();
+    configLog.reservedSeq = cyMesh_ConfigInfoFlash.seq_num;
+    configLog.seqNum = cyMesh_ConfigInfoRam.seq_num;
+}
+
+
+/* Writes the whole configuration, with seq_num at least the reservation */
+static bool CyMesh_ConfigLogCompact(void)
+{
+    bool result;
+
+    if(cyMesh_ConfigInfoRam.seq_num < configLog.reservedSeq)
+    {
+        cyMesh_ConfigInfoRam.seq_num = configLog.reservedSeq;
+    }
+    result = __real_CyMesh_ConfigurationSave();
+    CyMesh_ConfigLogRebase();
+
+    return result;
+}
+
+
+/* Writes the changed words to the next row, or compacts if they do not fit */
+static bool CyMesh_ConfigLogWrite(void)
+{
+    const uint32 * config = (const uint32 *)&cyMesh_ConfigInfoRam;
+    CYMESH_CONFIG_LOG_ROW_T row;
+    uint32 length = 0u;
+    uint32 word = 0u;
+
+    while(word < CYMESH_CONFIG_LOG_WORDS)
+    {
+        uint32 first;
+
+        if(configLog.changed[word / 32u] == 0u)
+        {
+            word = (word + 32u) & ~31u;
+            continue;
+        }
+        if(CyMesh_ConfigLogIsChanged(word) == false)
+        {
+            word++;
+            continue;
+        }
+
+        first = word;
+        while((word < CYMESH_CONFIG_LOG_WORDS) && (CyMesh_ConfigLogIsChanged(word) == true))
+        {
+            word++;
+        }
+
+        if((length + 1u + (word - first)) > CYMESH_CONFIG_LOG_DATA_WORDS)
+        {
+            return CyMesh_ConfigLogCompact();
+        }
+
+        row.data[length++] = CYMESH_CONFIG_LOG_RECORD(first, word - first);
+        for(; first < word; first++)
+        {
+            row.data[length++] = (first == CYMESH_CONFIG_LOG_SEQ_WORD) ? configLog.reservedSeq : config[first];
+        }
+    }
+
+    configLog.epoch++;
+    row.epoch = configLog.epoch;
+    row.baseHash = configLog.baseHash;
+    row.length = length;
+    memset(&row.data[length], 0, (CYMESH_CONFIG_LOG_DATA_WORDS - length) * sizeof(uint32));
+    row.checksum = CyMesh_ConfigLogChecksum(&row);
+
+    if(CyBLE_Nvram_Write((const uint8 *)&row, (const uint8 *)&cyMesh_ConfigLogFlash[configLog.row],
+                         sizeof(row)) != CYRET_SUCCESS)
+    {
+        return false;
+    }
+    configLog.row = (uint8)((configLog.row + 1u) % CYMESH_CONFIG_LOG_ROWS);
+
+    return true;
+}
+
+
+/* The library wrote the whole configuration since the last log write */
+static void CyMesh_ConfigLogCheckBase(void)
+{
+    if(CyMesh_ConfigLogBaseHash() != configLog.baseHash)
+    {
+        CyMesh_ConfigLogRebase();
+    }
+}
+
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+bool CyMesh_ConfigLogRestore(void)
+{
+    const CYMESH_CONFIG_LOG_ROW_T * newest = NULL;
+    uint32 * config = (uint32 *)&cyMesh_ConfigInfoRam;
+    uint32 i;
+
+    memset(&configLog, 0, sizeof(configLog));
+    CyMesh_ConfigLogRebase();
+
+    for(i = 0; i < CYMESH_CONFIG_LOG_ROWS; i++)
+    {
+        const CYMESH_CONFIG_LOG_ROW_T * row = &cyMesh_ConfigLogFlash[i];
+
+        if((row->epoch == 0u) || (row->length > CYMESH_CONFIG_LOG_DATA_WORDS) ||
+           (row->checksum != CyMesh_ConfigLogChecksum(row)))
+        {
+            continue;
+        }
+
+        /* Epochs continue across bases */
+        if(row->epoch > configLog.epoch)
+        {
+            configLog.epoch = row->epoch;
+            configLog.row = (uint8)((i + 1u) % CYMESH_CONFIG_LOG_ROWS);
+        }
+        if((row->baseHash == configLog.baseHash) && ((newest == NULL) || (row->epoch > newest->epoch)))
+        {
+            newest = row;
+        }
+    }
+
+    if((newest == NULL) || (cyMesh_ConfigInfoRam.isConfigurationValid == false))
+    {
+        return false;
+    }
+
+    i = 0u;
+    while(i < newest->length)
+    {
+        uint32 first = CYMESH_CONFIG_LOG_RECORD_FIRST(newest->data[i]);
+        uint32 count = CYMESH_CONFIG_LOG_RECORD_COUNT(newest->data[i]);
+
+        i++;
+        if(((first + count) > CYMESH_CONFIG_LOG_WORDS) || ((i + count) > newest->length))
+        {
+            break;
+        }
+        for(; count > 0u; count--)
+        {
+            if(first != CYMESH_CONFIG_LOG_CHECKSUM_WORD)
+            {
+                config[first] = newest->data[i];
+                CyMesh_ConfigLogSetChanged(first, true);
+            }
+            first++;
+            i++;
+        }
+    }
+
+    configLog.reservedSeq = cyMesh_ConfigInfoRam.seq_num;
+    configLog.seqNum = cyMesh_ConfigInfoRam.seq_num;
+
+    return true;
+}
+
+
+void CyMesh_ConfigLogUpdate(void)
+{
+    const uint32 * config = (const uint32 *)&cyMesh_ConfigInfoRam;
+    const uint32 * base = (const uint32 *)&cyMesh_ConfigInfoFlash;
+    uint32 i;
+
+    if((CyMesh_ConfigInfoFlashUpdateRequired == 0u) || (cyMesh_ConfigInfoRam.isConfigurationValid == false) ||
+       (configLog.isBusy == true))
+    {
+        return;
+    }
+
+    if(configLog.updateCountdown == 0u)
+    {
+        configLog.updateCountdown = CYMESH_CONFIG_LOG_UPDATE_DELAY;
+        return;
+    }
+    configLog.updateCountdown--;
+    if(configLog.updateCountdown != 0u)
+    {
+        return;
+    }
+
+    CyMesh_ConfigInfoFlashUpdateRequired = 0u;
+    CyMesh_ConfigLogCheckBase();
+
+    /* The configuration model does not say what changed */
+    for(i = 0; i < CYMESH_CONFIG_LOG_WORDS; i++)
+    {
+        if((i != CYMESH_CONFIG_LOG_SEQ_WORD) && (i != CYMESH_CONFIG_LOG_CHECKSUM_WORD))
+        {
+            CyMesh_ConfigLogSetChanged(i, config[i] != base[i]);
+        }
+    }
+
+    (void)CyMesh_ConfigLogWrite();
+}
+
+
+bool __wrap_CyMesh_ConfigurationSave(void)
+{
+    bool result = true;
+
+#if (CYMESH_ENABLE_CONFIGINFO_LOG == 1)
+    uint32 seqNum = cyMesh_ConfigInfoRam.seq_num;
+
+    configLog.isBusy = true;
+    CyMesh_ConfigLogCheckBase();
+
+    if(seqNum < configLog.seqNum)
+    {
+        /* The SEQ wrapped and the credentials changed */
+        result = __real_CyMesh_ConfigurationSave();
+        CyMesh_ConfigLogRebase();
+    }
+    else if(seqNum > configLog.reservedSeq)
+    {
+        configLog.reservedSeq = seqNum + CYMESH_CONFIG_LOG_SEQ_RESERVE;
+        CyMesh_ConfigLogSetChanged(CYMESH_CONFIG_LOG_SEQ_WORD, true);
+        result = CyMesh_ConfigLogWrite();
+    }
+    else
+    {
+        /* Covered by the last reservation */
+    }
+    configLog.seqNum = seqNum;
+
+    configLog.isBusy = false;
+#else
+    result = __real_CyMesh_ConfigurationSave();
+#endif
+
+    return result;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,150 @@
+/***************************************************************************//**
+* \file CyMesh_ConfigLog.h
+* \version 1.0
+*
+* \brief
+*  This is the header file of the configuration log, which keeps changes to
+*  cyMesh_ConfigInfoRam in a ring of flash rows instead of rewriting
+*  cyMesh_ConfigInfoFlash for every change.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined (CYMESH_CONFIG_LOG_H)
+#define CYMESH_CONFIG_LOG_H
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <stdbool.h>
+#include "CyMesh_Common.h"
+
+
+/*******************************************************************************
+* Compile Time Options
+*******************************************************************************/
+/* Flash rows in the ring. Each write goes to the next row, so every row wears
+ * at 1/CYMESH_CONFIG_LOG_ROWS of the write rate. */
+#if !defined(CYMESH_CONFIG_LOG_ROWS)
+    #define CYMESH_CONFIG_LOG_ROWS                  (4u)
+#endif
+
+/* SEQ numbers reserved by a log write on top of the
+ * CYMESH_TRAN_SEQNO_FLASH_INCREMENT_VALUE of the transport layer. Up to this
+ * many more are skipped after a reset. */
+#if !defined(CYMESH_CONFIG_LOG_SEQ_RESERVE)
+    #define CYMESH_CONFIG_LOG_SEQ_RESERVE           (1000u)
+#endif
+
+/* SM timer ticks (1 ms) from a configuration change to its log write, so that
+ * a burst of configuration messages is written once */
+#if !defined(CYMESH_CONFIG_LOG_UPDATE_DELAY)
+    #define CYMESH_CONFIG_LOG_UPDATE_DELAY          (10000u)
+#endif
+
+#if (CYMESH_CONFIG_LOG_ROWS < 2u)
+    #error "The configuration log needs at least two rows"
+#endif
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+#define CYMESH_CONFIG_LOG_WORDS                 (sizeof(CYMESH_DEVICE_CONFIG_T) / sizeof(uint32))
+#define CYMESH_CONFIG_LOG_HEADER_SIZE           (16u)
+#define CYMESH_CONFIG_LOG_DATA_WORDS            ((CYDEV_FLS_ROW_SIZE - CYMESH_CONFIG_LOG_HEADER_SIZE) / sizeof(uint32))
+
+
+/*******************************************************************************
+* Structures and Enums
+*******************************************************************************/
+
+/* One flash row. data holds records of a header word, the index of the first
+ * cyMesh_ConfigInfoRam word in bits 16-31 and the number of words in bits
+ * 0-15, followed by the words. */
+typedef struct
+{
+    /* Rows are written in increasing epoch; 0 is a row never written */
+    uint32 epoch;
+
+    /* Hash of the cyMesh_ConfigInfoFlash image the records apply to. The
+     * checksum of the image is a plain sum, which a change and its reversal
+     * leave as it was. */
+    uint32 baseHash;
+
+    /* Words used in data */
+    uint32 length;
+
+    /* Checksum of the row */
+    uint32 checksum;
+
+    uint32 data[CYMESH_CONFIG_LOG_DATA_WORDS];
+} CYMESH_CONFIG_LOG_ROW_T;
+
+
+/*******************************************************************************
+* Globals
+*******************************************************************************/
+extern const CYMESH_CONFIG_LOG_ROW_T cyMesh_ConfigLogFlash[CYMESH_CONFIG_LOG_ROWS];
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+/******************************************************************************
+* Function Name: CyMesh_ConfigLogRestore
+*******************************************************************************
+*
+*  This function applies the newest log row to cyMesh_ConfigInfoRam. It is
+* called after CyMesh_ConfigurationLoad() and before the transport layer reads
+* seq_num, from CyMesh_NetworkStart().
+*
+*  \param none:
+*
+*  \return bool: true if a log row was applied
+*
+******************************************************************************/
+bool CyMesh_ConfigLogRestore(void);
+
+/******************************************************************************
+* Function Name: CyMesh_ConfigLogUpdate
+*******************************************************************************
+*
+*  This function replaces CyMesh_ConfigInfoUpdate() on the SM timer. When the
+* configuration model flags a change, it logs the words of
+* cyMesh_ConfigInfoRam that differ from cyMesh_ConfigInfoFlash
+* CYMESH_CONFIG_LOG_UPDATE_DELAY ticks later. Other ticks only test the flag.
+*
+*  \param none:
+*
+*  \return none:
+*
+******************************************************************************/
+void CyMesh_ConfigLogUpdate(void);
+
+/******************************************************************************
+* Function Name: __wrap_CyMesh_ConfigurationSave
+*******************************************************************************
+*
+*  The transport layer calls CyMesh_ConfigurationSave() each time seq_num
+* passes the value in flash. The linker option
+* --wrap=CyMesh_ConfigurationSave sends those calls here; a log write then
+* reserves seq_num + CYMESH_CONFIG_LOG_SEQ_RESERVE, and calls covered by the
+* reservation write nothing. Calls from inside the configuration layer are not
+* wrapped and still save the whole configuration.
+*
+*  \param none:
+*
+*  \return bool: true if the log or flash save was successful
+*
+******************************************************************************/
+bool __wrap_CyMesh_ConfigurationSave(void);
+
+#endif
+/* [] END OF FILE */
@@ -230,7 +230,11 @@ void ProvConfirmRandCMACcallback(uint8 * );
 *
 *  \return CYMESH_API_RETURN_T: CYMESH_ERROR_OK if provisioning started
 *								CYMESH_ERROR_INVALID_PARAM if parameter is incorrect
-* 
+*
+*  Note: the provisioner role is not part of SM_LIB_256K.a. This function
+* returns CYMESH_ERROR_OK without starting a link, so nodes are configured with
+* the keys in Mesh_config.c and CYMESHTEST_START_DIRECTLY_WITH_RELAY instead.
+*
 ******************************************************************************/
 CYMESH_API_RETURN_T CyMesh_ProvisionerProvisionNewDevice(CYMESH_CONFIG_UNPROV_BEACON_CONTENT_T* , CYMESH_CONFIG_PROV_DATA_T*, uint8 );
 
@@ -0,0 +1,797 @@
+/***************************************************************************//**
+* \file CyMesh_MessageQueue.c
+* \version 1.0
+*
+* \brief
+*  This file contains the queues of the application layer of the BLE
+*  SmartMesh v1 solution. It replaces the CyMesh_MessageQueue object of
+*  SM_LIB_256K.a and keeps its interface to the application layer and the
+*  models: the ACK queue holds the status messages to send, the TX message
+*  queue the messages of the models, which it sends and, for the reliable
+*  ones, sends again until CyMesh_TxMessageQueueFreeUp() is called for their
+*  status, and the multi message queue reassembles the multi packet messages.
+*
+*  The entry of a received TID and a free entry are found through the TID
+*  index of each queue (see CyMesh_MessageQueueIndex.c) rather than by walking
+*  the queue, so that the queue sizes can be raised in the build options.
+*
+*  The library waits cyMesh_AppReliableMsgTimeout seconds for every status.
+*  With CYMESH_ENABLE_ADAPTIVE_RTO, the wait is the retransmission timeout of
+*  the destination instead (see CyMesh_MessageQueueRto.c), which is learned
+*  from the time its statuses take, and a status raises
+*  CYMESH_EVT_RELIABLE_MESSAGE_COMPLETE with that time.
+*
+*  The models take the TTL of a message from their configuration.
+*  CyMesh_TxMessageQueueSetNextTtl(), which the library object does not have,
+*  gives the next message another one without changing the configuration.
+*
+*  Tools/network_bench/interop_check.c checks the access PDUs against the
+*  library object. Remove this file from the project to link the library
+*  version again.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <string.h>
+#include "CyMesh_MessageQueue.h"
+#include "CyMesh_Bearer.h"
+#include "CyMesh_Timer.h"
+#include "CyMesh_MessageQueueIndex.h"
+#if (CYMESH_ENABLE_ADAPTIVE_RTO == 1)
+#include "CyMesh_MessageQueueRto.h"
+#endif
+
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+#define CYMESH_MESSAGE_Q_PKT_SIZE               (CYMESH_APPLICATION_TRIPLE_BYTE_OPCODE_SIZE + 1u + 10u)
+#define CYMESH_MESSAGE_Q_TX_COUNT               (1u)
+#define CYMESH_MESSAGE_Q_MODEL_TTL_DEFAULT      (0xFFu) /* Model uses the device default TTL */
+#define CYMESH_MESSAGE_Q_NO_COMPONENT           (0xFFu)
+#define CYMESH_MESSAGE_Q_MS_PER_SECOND          (1000u)
+
+#if (CYMESH_MESSAGE_Q_INDEX_TID_MASK != CYMESH_APPLICATION_TID_MASK)
+    #error "The TID index does not match the TID of the application layer"
+#endif
+
+
+
+/*******************************************************************************
+* Data Structures
+*******************************************************************************/
+
+/* Application layer event callback, from CyMesh_Application */
+extern CYBLE_MODEL_CALLBACK_T cyMesh_GenericEventCallback;
+
+/* Retries of the reliable messages of the models */
+uint8 cyMesh_retryCount = CYMESH_TX_MESSAGE_Q_RETRY_COUNT;
+
+/* Time the reliable messages wait for their status, in seconds */
+uint8 cyMesh_AppReliableMsgTimeout = CYMESH_TX_MESSAGE_Q_DEFAULT_TIMEOUT;
+
+/* TID of the last new message */
+static uint8 transactionID;
+
+/* TTL of the next message inserted, or CYMESH_TX_MESSAGE_Q_TTL_MODEL */
+static uint8 txNextTtl = CYMESH_TX_MESSAGE_Q_TTL_MODEL;
+
+static CYMESH_ACK_QUEUE_T ackQueue;
+static CYMESH_TX_MESSAGE_QUEUE_T txMessageQueue;
+static CYMESH_MULTI_MESSAGE_QUEUE_T multiMessageQueue[CYMESH_MULTI_MESSAGE_Q_NUMBER_OF_BUFFERS];
+
+/* TID indexes of the queues, which tell the entries in use */
+static uint8 ackNext[CYMESH_ACK_Q_SIZE];
+static uint8 ackReleased[CYMESH_ACK_Q_SIZE];
+static CYMESH_MESSAGE_Q_INDEX_STRUCT ackIndex =
+    CYMESH_MESSAGE_Q_INDEX_INIT(ackNext, ackReleased, CYMESH_ACK_Q_SIZE);
+
+static uint8 txNext[CYMESH_TX_MESSAGE_Q_SIZE];
+static uint8 txReleased[CYMESH_TX_MESSAGE_Q_SIZE];
+static CYMESH_MESSAGE_Q_INDEX_STRUCT txIndex =
+    CYMESH_MESSAGE_Q_INDEX_INIT(txNext, txReleased, CYMESH_TX_MESSAGE_Q_SIZE);
+
+static uint8 multiNext[CYMESH_MULTI_MESSAGE_Q_NUMBER_OF_BUFFERS];
+static uint8 multiReleased[CYMESH_MULTI_MESSAGE_Q_NUMBER_OF_BUFFERS];
+static CYMESH_MESSAGE_Q_INDEX_STRUCT multiIndex =
+    CYMESH_MESSAGE_Q_INDEX_INIT(multiNext, multiReleased, CYMESH_MULTI_MESSAGE_Q_NUMBER_OF_BUFFERS);
+
+#if (CYMESH_ENABLE_ADAPTIVE_RTO == 1)
+/* Retransmission timeouts of the destinations */
+static CYMESH_TX_RTO_STRUCT txRto;
+#endif
+
+
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+
+static uint8 CyMesh_GetNewTransactionID(void)
+{
+    transactionID++;
+    if(transactionID > CYMESH_DEVICE_MAX_TRANSACTION_ID)
+    {
+        transactionID = CYMESH_DEVICE_MIN_TRANSACTION_ID;
+    }
+
+    return transactionID;
+}
+
+
+/* Takes profilesMutex.profilesSendLock. Returns false if it is already taken. */
+static bool CyMesh_MessageQueueLock(void)
+{
+    uint8 interruptState = CyEnterCriticalSection();
+    bool isLocked = false;
+
+    if(profilesMutex.profilesSendLock == CYMESH_PROFILES_MUTEX_FREE)
+    {
+        profilesMutex.profilesSendLock = CYMESH_PROFILES_MUTEX_LOCKED;
+        isLocked = true;
+    }
+
+    CyExitCriticalSection(interruptState);
+
+    return isLocked;
+}
+
+
+/* Component the reliable message events of opcode go to. The library only
+ * raises the timeout for the vendor specific reliable messages. */
+static bool CyMesh_TxMessageQueueEventComponent(uint32 opcode, uint8 * componentIndex)
+{
+    switch(opcode)
+    {
+        case CYMESH_MESSAGE_VENDOR_SPECIFIC_REL_SET_1:
+        case CYMESH_MESSAGE_VENDOR_SPECIFIC_REL_SET_2:
+            *componentIndex = CYMESH_MESSAGE_Q_NO_COMPONENT;
+            return true;
+
+        case CYMESH_MESSAGE_VENDOR_SPECIFIC_REL_SET_3:
+            *componentIndex = 3u;
+            return true;
+
+        default:
+            *componentIndex = CYMESH_MESSAGE_Q_NO_COMPONENT;
+            return false;
+    }
+}
+
+
+/* Builds the access payload of a queued message: opcode, TID and parameters.
+ * Returns its length. */
+static uint8 CyMesh_TxMessageQueueBuild(const CYMESH_TX_MESSAGE_NODE_T * node, uint8 * pkt)
+{
+    uint8 length;
+
+    if(node->opcode < CYMESH_APPLICATION_SINGLE_BYTE_OPCODE_MAX_VALUE)
+    {
+        pkt[0] = (uint8)node->opcode;
+        length = CYMESH_APPLICATION_SINGLE_BYTE_OPCODE_SIZE;
+    }
+    else if((node->opcode & CYMESH_APPLICATION_DOUBLE_BYTE_OPCODE_MASK) == CYMESH_APPLICATION_DOUBLE_BYTE_OPCODE_VALUE)
+    {
+        pkt[0] = (uint8)(node->opcode >> 8);
+        pkt[1] = (uint8)node->opcode;
+        length = CYMESH_APPLICATION_DOUBLE_BYTE_OPCODE_SIZE;
+    }
+    else if((node->opcode & CYMESH_APPLICATION_TRIPLE_BYTE_OPCODE_MASK) == CYMESH_APPLICATION_TRIPLE_BYTE_OPCODE_VALUE)
+    {
+        pkt[0] = (uint8)(node->opcode >> 16);
+        pkt[1] = (uint8)(node->opcode >> 8);
+        pkt[2] = (uint8)node->opcode;
+        length = CYMESH_APPLICATION_TRIPLE_BYTE_OPCODE_SIZE;
+    }
+    else
+    {
+        length = 0u;
+    }
+
+    pkt[length] = (uint8)(node->identifier | (node->isReliable << 7) | (node->isEndBitSet << 6));
+    length++;
+    memcpy(&pkt[length], node->payload, node->payloadLength);
+
+    return length + node->payloadLength;
+}
+
+
+static CYMESH_API_RETURN_T CyMesh_TxMessageQueueSend(const CYMESH_TX_MESSAGE_NODE_T * node)
+{
+    uint8 pkt[CYMESH_MESSAGE_Q_PKT_SIZE];
+    uint8 length = CyMesh_TxMessageQueueBuild(node, pkt);
+
+    return CyMesh_TransportSendData(pkt, length, CYMESH_MESSAGE_Q_TX_COUNT, node->isAppKeyUsed,
+                                    node->isOwnOrPeerDevKey, node->fut, node->ttl, node->srcAddress,
+                                    node->dstAddress, node->netKeyIndex, node->appKeyIndex);
+}
+
+
+static void CyMesh_TxMessageQueueRelease(uint8 queueIndex)
+{
+    CYMESH_TX_MESSAGE_NODE_T * node;
+
+    if(queueIndex >= CYMESH_TX_MESSAGE_Q_SIZE)
+    {
+        return;
+    }
+
+    node = &txMessageQueue.messageNode[queueIndex];
+    if(CyMesh_MessageQueueIndexRelease(&txIndex, queueIndex, node->identifier) == false)
+    {
+        return;
+    }
+    node->isAvailable = true;
+    node->isWaiting = false;
+    node->payloadLength = 0u;
+    node->retryCount = 0u;
+
+    if(txMessageQueue.count > 0u)
+    {
+        txMessageQueue.count--;
+    }
+}
+
+
+/* The status of a reliable message came */
+#if (CYMESH_ENABLE_ADAPTIVE_RTO == 1)
+static void CyMesh_TxMessageQueueComplete(const CYMESH_TX_MESSAGE_NODE_T * node)
+{
+    static CYMESH_APP_RELIABLE_MSG_COMPLETE_PARAM_T completeParam;
+    uint32 now = CyMesh_TimerGetTimestamp();
+    uint8 componentIndex;
+
+    completeParam.opcode = node->opcode;
+    completeParam.dstAddress = node->dstAddress;
+    completeParam.rtt = now - node->timeStamp;
+    completeParam.transmissions = node->transmissions;
+    if(node->transmissions == 1u)
+    {
+        (void)CyMesh_TxRtoSample(&txRto, node->dstAddress, completeParam.rtt);
+    }
+    completeParam.rto = CyMesh_TxRtoGet(&txRto, node->dstAddress,
+                                        (uint32)cyMesh_AppReliableMsgTimeout * CYMESH_MESSAGE_Q_MS_PER_SECOND, now);
+
+    (void)CyMesh_TxMessageQueueEventComponent(node->opcode, &componentIndex);
+    if(cyMesh_GenericEventCallback != NULL)
+    {
+        cyMesh_GenericEventCallback(CYMESH_EVT_RELIABLE_MESSAGE_COMPLETE, &completeParam, componentIndex, 0u);
+    }
+}
+#endif
+
+
+/* No status came for a reliable message and it has no retry left */
+static void CyMesh_TxMessageQueueTimeout(CYMESH_TX_MESSAGE_NODE_T * node)
+{
+    static CYMESH_APP_RELIABLE_MSG_TIMEOUT_PARAM_T timeoutParam;
+    uint8 componentIndex;
+
+    timeoutParam.opcode = node->opcode;
+    timeoutParam.dstAddress = node->dstAddress;
+    timeoutParam.datapointer = node->payload;
+    timeoutParam.payloadLength = node->payloadLength;
+
+    if((cyMesh_GenericEventCallback != NULL) &&
+       (CyMesh_TxMessageQueueEventComponent(node->opcode, &componentIndex) == true))
+    {
+        cyMesh_GenericEventCallback(CYMESH_EVT_RELIABLE_MESSAGE_TIMEOUT, &timeoutParam, componentIndex, 0u);
+    }
+}
+
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+void CyMesh_ResetTransactionID(void)
+{
+    transactionID = 0u;
+}
+
+
+/************************** Ack queue *****************************/
+
+uint8 CyMesh_IsAckQueueFree(void)
+{
+    return CyMesh_MessageQueueIndexGetFree(&ackIndex);
+}
+
+
+uint8 CyMesh_GetAckQueueMatch(uint8 matchTid)
+{
+    uint8 i;
+
+    for(i = CyMesh_MessageQueueIndexFirst(&ackIndex, matchTid); i != CYMESH_MESSAGE_Q_INDEX_NONE;
+        i = CyMesh_MessageQueueIndexNext(&ackIndex, i))
+    {
+        if(ackQueue.ackNode[i].identifier == matchTid)
+        {
+            return i;
+        }
+    }
+
+    return CYMESH_ACK_Q_MATCH_FAILED;
+}
+
+
+void CyMesh_AckQueueInsert(uint8 queueIndex, CYMESH_ACK_NODE_T * applicationPacket)
+{
+    CYMESH_ACK_NODE_T * node;
+
+    if(CyMesh_MessageQueueIndexTake(&ackIndex, queueIndex, applicationPacket->identifier) == false)
+    {
+        return;
+    }
+
+    node = &ackQueue.ackNode[queueIndex];
+    memcpy(node->data, applicationPacket->data, applicationPacket->length);
+    node->length = applicationPacket->length;
+    node->netKeyIndex = applicationPacket->netKeyIndex;
+    node->appKeyIndex = applicationPacket->appKeyIndex;
+    node->isAppKeyUsed = applicationPacket->isAppKeyUsed;
+    node->modelIndex = applicationPacket->modelIndex;
+    node->componentIndex = applicationPacket->componentIndex;
+    node->identifier = applicationPacket->identifier;
+    node->fut = applicationPacket->fut;
+    node->srcAddress = applicationPacket->srcAddress;
+    node->dstAddress = applicationPacket->dstAddress;
+    node->isAvailable = false;
+
+    ackQueue.count++;
+}
+
+
+void CyMesh_AckQueueFreeUp(uint8 queueIndex)
+{
+    /* CyMesh_ApplicationStart() frees the first 10 entries, whether taken or
+     * not and whatever the size of the queue */
+    if((queueIndex >= CYMESH_ACK_Q_SIZE) ||
+       (CyMesh_MessageQueueIndexRelease(&ackIndex, queueIndex, ackQueue.ackNode[queueIndex].identifier) == false))
+    {
+        return;
+    }
+
+    ackQueue.ackNode[queueIndex].isAvailable = true;
+    ackQueue.ackNode[queueIndex].length = 0u;
+
+    if(ackQueue.count > 0u)
+    {
+        ackQueue.count--;
+    }
+}
+
+
+void CyMesh_ResetAckQueueCount(void)
+{
+    uint8 i;
+
+    for(i = 0u; i < CyMesh_MessageQueueIndexGetLimit(&ackIndex); i++)
+    {
+        ackQueue.ackNode[i].isAvailable = true;
+        ackQueue.ackNode[i].length = 0u;
+    }
+    CyMesh_MessageQueueIndexReset(&ackIndex);
+    ackQueue.count = 0u;
+}
+
+
+bool IsAckQueueFull(void)
+{
+    return (ackQueue.count == CYMESH_ACK_Q_SIZE);
+}
+
+
+CYMESH_API_RETURN_T CyMesh_SchedulePendingAckPackets(void)
+{
+    CYMESH_BEARER_TX_BUFFER_STATE_T bufferState;
+    CYMESH_API_RETURN_T result = CYMESH_ERROR_OK;
+    uint8 i;
+
+    if(CyMesh_MessageQueueLock() == false)
+    {
+        return CYMESH_ERROR_THREAD_BUSY;
+    }
+
+    bufferState = CyMesh_BearerGetTxBufferStatus();
+    if((bufferState != CYMESH_BEARER_TX_BUFFER_EMPTY) && (bufferState != CYMESH_BEARER_TX_BUFFER_FREE))
+    {
+        profilesMutex.profilesSendLock = CYMESH_PROFILES_MUTEX_FREE;
+        return CYMESH_ERROR_BEARER_TX_BUFFER_FULL;
+    }
+
+    for(i = 0u; (i < CyMesh_MessageQueueIndexGetLimit(&ackIndex)) && (ackQueue.count != 0u); i++)
+    {
+        CYMESH_ACK_NODE_T * node = &ackQueue.ackNode[i];
+        uint8 ttl;
+
+        if(CyMesh_MessageQueueIndexIsTaken(&ackIndex, i) == false)
+        {
+            continue;
+        }
+
+        /* Statuses go with the default TTL of the model that answers */
+        ttl = cyMesh_ConfigInfoRam.deviceInfo.components[node->componentIndex].model[node->modelIndex].modelDefaultTtl;
+        if(ttl == CYMESH_MESSAGE_Q_MODEL_TTL_DEFAULT)
+        {
+            ttl = cyMesh_ConfigInfoRam.deviceInfo.deviceDefaultTtl;
+        }
+
+        result = CyMesh_TransportSendData(node->data, node->length, CYMESH_MESSAGE_Q_TX_COUNT, node->isAppKeyUsed,
+                                          false, node->fut, ttl, node->srcAddress, node->dstAddress,
+                                          node->netKeyIndex, node->appKeyIndex);
+        if((result == CYMESH_ERROR_BEARER_TX_BUFFER_FULL) || (result == CYMESH_ERROR_THREAD_BUSY))
+        {
+            break;
+        }
+        CyMesh_AckQueueFreeUp(i);
+    }
+
+    profilesMutex.profilesSendLock = CYMESH_PROFILES_MUTEX_FREE;
+
+    return result;
+}
+
+
+/************************** Tx message queue *****************************/
+
+uint8 CyMesh_GetTxMessageFreeDepth(void)
+{
+    return CYMESH_TX_MESSAGE_Q_SIZE - txMessageQueue.count;
+}
+
+
+uint8 CyMesh_IsTxMessageQueueFree(void)
+{
+    return CyMesh_MessageQueueIndexGetFree(&txIndex);
+}
+
+
+uint8 CyMesh_GetTxQueueMatch(uint8 matchTid)
+{
+    uint8 i;
+
+    for(i = CyMesh_MessageQueueIndexFirst(&txIndex, matchTid); i != CYMESH_MESSAGE_Q_INDEX_NONE;
+        i = CyMesh_MessageQueueIndexNext(&txIndex, i))
+    {
+        if(txMessageQueue.messageNode[i].identifier == matchTid)
+        {
+            return i;
+        }
+    }
+
+    return CYMESH_TX_MESSAGE_Q_MATCH_FAILED;
+}
+
+
+CYMESH_API_RETURN_T CyMesh_TxMessageQueueInsert(uint8 queueIndex, CYMESH_TX_MESSAGE_NODE_T * packet, bool isNewPacket)
+{
+    CYMESH_TX_MESSAGE_NODE_T * node;
+    uint8 identifier;
+
+    if(txMessageQueue.count >= CYMESH_TX_MESSAGE_Q_SIZE)
+    {
+        return CYMESH_ERROR_APPLICATION_BUFFER_FULL;
+    }
+
+    if((queueIndex >= CYMESH_TX_MESSAGE_Q_SIZE) || (CyMesh_MessageQueueIndexIsTaken(&txIndex, queueIndex) == true))
+    {
+        return CYMESH_ERROR_INVALID_PARAM;
+    }
+
+    /* A message sent again keeps the TID of its first copy */
+    identifier = (isNewPacket == true) ? CyMesh_GetNewTransactionID() : transactionID;
+    (void)CyMesh_MessageQueueIndexTake(&txIndex, queueIndex, identifier);
+
+    node = &txMessageQueue.messageNode[queueIndex];
+    node->identifier = identifier;
+    node->opcode = packet->opcode;
+    memcpy(node->payload, packet->payload, packet->payloadLength);
+    node->payloadLength = packet->payloadLength;
+    node->isReliable = packet->isReliable;
+    node->isEndBitSet = packet->isEndBitSet;
+    node->netKeyIndex = packet->netKeyIndex;
+    node->appKeyIndex = packet->appKeyIndex;
+    node->isAppKeyUsed = packet->isAppKeyUsed;
+    node->isOwnOrPeerDevKey = packet->isOwnOrPeerDevKey;
+    node->srcAddress = packet->srcAddress;
+    node->dstAddress = packet->dstAddress;
+    node->fut = packet->fut;
+    node->ttl = (txNextTtl != CYMESH_TX_MESSAGE_Q_TTL_MODEL) ? txNextTtl : packet->ttl;
+    txNextTtl = CYMESH_TX_MESSAGE_Q_TTL_MODEL;
+    node->timeStamp = CyMesh_TimerGetTimestamp();
+    node->retryCount = packet->retryCount;
+    node->isWaiting = false;
+    node->isAvailable = false;
+#if (CYMESH_ENABLE_ADAPTIVE_RTO == 1)
+    node->transmissions = 0u;
+    node->timeout = 0u;
+#endif
+    txMessageQueue.count++;
+
+    return CYMESH_ERROR_OK;
+}
+
+
+void CyMesh_TxMessageQueueFreeUp(uint8 queueIndex)
+{
+#if (CYMESH_ENABLE_ADAPTIVE_RTO == 1)
+    /* Called by the application layer when the status of the message came */
+    if((CyMesh_MessageQueueIndexIsTaken(&txIndex, queueIndex) == true) &&
+       (txMessageQueue.messageNode[queueIndex].isWaiting == true))
+    {
+        CyMesh_TxMessageQueueComplete(&txMessageQueue.messageNode[queueIndex]);
+    }
+#endif
+
+    CyMesh_TxMessageQueueRelease(queueIndex);
+}
+
+
+/* The models send through CyMesh_TxMessageQueueInsert(), so a message sent
+ * right after this call has ttl. CYMESH_TX_MESSAGE_Q_TTL_MODEL cancels it, in
+ * case the model did not send the message. */
+void CyMesh_TxMessageQueueSetNextTtl(uint8 ttl)
+{
+    txNextTtl = ttl;
+}
+
+
+void CyMesh_ResetTxMessageQueueCount(void)
+{
+    uint8 i;
+
+    for(i = 0u; i < CyMesh_MessageQueueIndexGetLimit(&txIndex); i++)
+    {
+        CyMesh_TxMessageQueueRelease(i);
+    }
+    CyMesh_MessageQueueIndexReset(&txIndex);
+    txMessageQueue.count = 0u;
+
+#if (CYMESH_ENABLE_ADAPTIVE_RTO == 1)
+    CyMesh_TxRtoInit(&txRto, ((((uint32)CY_GET_REG8(CYREG_SFLASH_DIE_X) << 8) |
+                               CY_GET_REG8(CYREG_SFLASH_DIE_Y)) << 16) ^ CyMesh_TimerGetTimestamp());
+#endif
+}
+
+
+CYMESH_API_RETURN_T CyMesh_SchedulePendingTxMessagePackets(void)
+{
+    CYMESH_BEARER_TX_BUFFER_STATE_T bufferState;
+    CYMESH_API_RETURN_T result = CYMESH_ERROR_OK;
+    uint8 i;
+
+    if(CyMesh_MessageQueueLock() == false)
+    {
+        return CYMESH_ERROR_THREAD_BUSY;
+    }
+
+    bufferState = CyMesh_BearerGetTxBufferStatus();
+    if((bufferState != CYMESH_BEARER_TX_BUFFER_EMPTY) && (bufferState != CYMESH_BEARER_TX_BUFFER_FREE))
+    {
+        profilesMutex.profilesSendLock = CYMESH_PROFILES_MUTEX_FREE;
+        return CYMESH_ERROR_BEARER_TX_BUFFER_FULL;
+    }
+
+    for(i = 0u; i < CyMesh_MessageQueueIndexGetLimit(&txIndex); i++)
+    {
+        CYMESH_TX_MESSAGE_NODE_T * node = &txMessageQueue.messageNode[i];
+        uint32 timeout;
+
+        if(CyMesh_MessageQueueIndexIsTaken(&txIndex, i) == false)
+        {
+            continue;
+        }
+
+        if(node->isReliable == false)
+        {
+            result = CyMesh_TxMessageQueueSend(node);
+            if((result == CYMESH_ERROR_BEARER_TX_BUFFER_FULL) || (result == CYMESH_ERROR_THREAD_BUSY))
+            {
+                break;
+            }
+            CyMesh_TxMessageQueueRelease(i);
+            continue;
+        }
+
+        if(node->isWaiting == false)
+        {
+            result = CyMesh_TxMessageQueueSend(node);
+            if((result == CYMESH_ERROR_BEARER_TX_BUFFER_FULL) || (result == CYMESH_ERROR_THREAD_BUSY))
+            {
+                break;
+            }
+            if(node->retryCount > 0u)
+            {
+                node->retryCount--;
+            }
+            node->isWaiting = true;
+#if (CYMESH_ENABLE_ADAPTIVE_RTO == 1)
+            node->timeStamp = CyMesh_TimerGetTimestamp();
+            node->transmissions = 1u;
+            node->timeout = CyMesh_TxRtoGet(&txRto, node->dstAddress,
+                                            (uint32)cyMesh_AppReliableMsgTimeout * CYMESH_MESSAGE_Q_MS_PER_SECOND,
+                                            node->timeStamp);
+#endif
+            continue;
+        }
+
+#if (CYMESH_ENABLE_ADAPTIVE_RTO == 1)
+        timeout = node->timeout;
+#else
+        timeout = (uint32)cyMesh_AppReliableMsgTimeout * CYMESH_MESSAGE_Q_MS_PER_SECOND;
+#endif
+        if((uint32)(CyMesh_TimerGetTimestamp() - node->timeStamp) < timeout)
+        {
+            continue;
+        }
+
+        if(node->retryCount > 0u)
+        {
+            result = CyMesh_TxMessageQueueSend(node);
+            if((result == CYMESH_ERROR_BEARER_TX_BUFFER_FULL) || (result == CYMESH_ERROR_THREAD_BUSY))
+            {
+                break;
+            }
+            node->retryCount--;
+            node->timeStamp = CyMesh_TimerGetTimestamp();
+#if (CYMESH_ENABLE_ADAPTIVE_RTO == 1)
+            node->transmissions++;
+            node->timeout = CyMesh_TxRtoBackoff(&txRto, node->dstAddress, timeout);
+#endif
+        }
+        else
+        {
+            CyMesh_TxMessageQueueTimeout(node);
+            CyMesh_TxMessageQueueRelease(i);
+        }
+    }
+
+    profilesMutex.profilesSendLock = CYMESH_PROFILES_MUTEX_FREE;
+
+    return result;
+}
+
+
+/************************** Multi message queue ********************************/
+
+uint8 CyMesh_GetMultiMessageQueueSlot(void)
+{
+    return CyMesh_MessageQueueIndexGetFree(&multiIndex);
+}
+
+
+uint8 CyMesh_GetMultiMessageQueueMatch(uint8 matchTid)
+{
+    uint8 i;
+
+    for(i = CyMesh_MessageQueueIndexFirst(&multiIndex, matchTid); i != CYMESH_MESSAGE_Q_INDEX_NONE;
+        i = CyMesh_MessageQueueIndexNext(&multiIndex, i))
+    {
+        if(multiMessageQueue[i].identifier == matchTid)
+        {
+            return i;
+        }
+    }
+
+    return CYMESH_MULTI_MESSAGE_Q_MATCH_FAILED;
+}
+
+
+uint8 CyMesh_GetMultiMessageQueueNumberOfPackets(uint8 queueIndex)
+{
+    if(CyMesh_MessageQueueIndexIsTaken(&multiIndex, queueIndex) == false)
+    {
+        return CYMESH_MULTI_MESSAGE_Q_MATCH_FAILED;
+    }
+
+    return multiMessageQueue[queueIndex].numberOfPacketsStored;
+}
+
+
+/* As the library version, this only returns the length of the data; data is
+ * not written. */
+uint8 CyMesh_GetMultiMessageQueueData(uint8 queueIndex, uint8 * data)
+{
+    (void)data;
+
+    if(CyMesh_MessageQueueIndexIsTaken(&multiIndex, queueIndex) == false)
+    {
+        return 0u;
+    }
+
+    return multiMessageQueue[queueIndex].paramLength;
+}
+
+
+CYMESH_API_RETURN_T CyMesh_MultiMessageQueueInit(uint8 queueIndex, CYMESH_APPLICATION_PKT_T * applicationPacket)
+{
+    CYMESH_MULTI_MESSAGE_QUEUE_T * entry;
+
+    if((applicationPacket->parameterLength > CYMESH_MULTI_MESSAGE_Q_MAX_BUFFER_SIZE) ||
+       (CyMesh_MessageQueueIndexTake(&multiIndex, queueIndex, applicationPacket->identifier) == false))
+    {
+        return CYMESH_ERROR_INVALID_PARAM;
+    }
+
+    entry = &multiMessageQueue[queueIndex];
+    entry->isAvailable = false;
+    entry->timeStamp = CyMesh_TimerGetTimestamp();
+    entry->identifier = applicationPacket->identifier;
+    entry->paramLength = applicationPacket->parameterLength;
+    entry->numberOfPacketsStored = 1u;
+    memcpy(entry->dataBuffer, applicationPacket->parameter, applicationPacket->parameterLength);
+
+    return CYMESH_ERROR_OK;
+}
+
+
+CYMESH_API_RETURN_T CyMesh_MultiMessageQueueInsert(uint8 queueIndex, CYMESH_APPLICATION_PKT_T * applicationPacket)
+{
+    CYMESH_MULTI_MESSAGE_QUEUE_T * entry;
+
+    if(queueIndex >= CYMESH_MULTI_MESSAGE_Q_NUMBER_OF_BUFFERS)
+    {
+        return CYMESH_ERROR_INVALID_PARAM;
+    }
+
+    entry = &multiMessageQueue[queueIndex];
+    if((applicationPacket->parameterLength + entry->paramLength) > CYMESH_MULTI_MESSAGE_Q_MAX_BUFFER_SIZE)
+    {
+        return CYMESH_ERROR_APPLICATION_BUFFER_FULL;
+    }
+
+    memcpy(&entry->dataBuffer[entry->paramLength], applicationPacket->parameter, applicationPacket->parameterLength);
+    entry->paramLength += applicationPacket->parameterLength;
+    entry->timeStamp = CyMesh_TimerGetTimestamp();
+    entry->numberOfPacketsStored++;
+
+    return CYMESH_ERROR_OK;
+}
+
+
+void CyMesh_MultiMessageQueueFreeUp(uint8 queueIndex)
+{
+    CYMESH_MULTI_MESSAGE_QUEUE_T * entry;
+
+    if(queueIndex >= CYMESH_MULTI_MESSAGE_Q_NUMBER_OF_BUFFERS)
+    {
+        return;
+    }
+
+    entry = &multiMessageQueue[queueIndex];
+    (void)CyMesh_MessageQueueIndexRelease(&multiIndex, queueIndex, entry->identifier);
+    entry->isAvailable = true;
+    entry->paramLength = 0u;
+    entry->identifier = 0u;
+    entry->timeStamp = 0u;
+    entry->numberOfPacketsStored = 0u;
+}
+
+
+void CyMesh_HandleMultiMessageTimeout(void)
+{
+    uint8 i;
+
+    for(i = 0u; i < CyMesh_MessageQueueIndexGetLimit(&multiIndex); i++)
+    {
+        if((CyMesh_MessageQueueIndexIsTaken(&multiIndex, i) == true) &&
+           ((uint32)(CyMesh_TimerGetTimestamp() - multiMessageQueue[i].timeStamp) > CYMESH_MULTI_MESSAGE_Q_TIMEOUT))
+        {
+            CyMesh_MultiMessageQueueFreeUp(i);
+        }
+    }
+}
+
+/* [] END OF FILE */
@@ -30,8 +30,15 @@
 * Macros
 *******************************************************************************/
 
+/* The queue sizes may be raised in the build options: the entry of a TID and
+ * a free entry are found through CyMesh_MessageQueueIndex.c, whatever the
+ * size. CyMesh_Stop() of the library only frees the first 3 multi message
+ * entries; the others are freed by their timeout. */
+
 /************** ACK Queue ****************/    
-#define CYMESH_ACK_Q_SIZE                               (10)
+#if !defined(CYMESH_ACK_Q_SIZE)
+    #define CYMESH_ACK_Q_SIZE                           (10)
+#endif
 #define CYMESH_ACK_Q_FULL                               (0xFF)
 #define CYMESH_ACK_Q_MATCH_FAILED                       (0xFF)
 
@@ -43,21 +50,33 @@
  */
 #define CYMESH_MULTI_MESSAGE_Q_MAX_BUFFER_SIZE          (40)
 
-#define CYMESH_MULTI_MESSAGE_Q_NUMBER_OF_BUFFERS        (3)
+#if !defined(CYMESH_MULTI_MESSAGE_Q_NUMBER_OF_BUFFERS)
+    #define CYMESH_MULTI_MESSAGE_Q_NUMBER_OF_BUFFERS    (3)
+#endif
 #define CYMESH_MULTI_MESSAGE_Q_FULL                     (0xFF)
 #define CYMESH_MULTI_MESSAGE_Q_MATCH_FAILED             (0xFF)
 #define CYMESH_MULTI_MESSAGE_Q_TIMEOUT                  (60000) /*60 seconds */
 
 
 /************* Tx Message Queue *****************/
-#define CYMESH_TX_MESSAGE_Q_SIZE                        (10)
+#if !defined(CYMESH_TX_MESSAGE_Q_SIZE)
+    #define CYMESH_TX_MESSAGE_Q_SIZE                    (10)
+#endif
 #define CYMESH_TX_MESSAGE_Q_FULL                        (0xFF)
 #define CYMESH_TX_MESSAGE_Q_MATCH_FAILED                (0xFF)
 #define CYMESH_TX_MESSAGE_Q_RETRY_COUNT                 (3)
 #define CYMESH_TX_MESSAGE_Q_DEFAULT_TIMEOUT             (5) /* 5 seconds */
+#define CYMESH_TX_MESSAGE_Q_TTL_MODEL                   (0xFF) /* Messages take the TTL of their model */
 
 #define CYMESH_APPLICATION_TIMER_MAX_VALUE              (0xFFFFFFFF)
 
+/* Entries are numbered in a byte, with 0xFF for FULL and MATCH_FAILED */
+#if (CYMESH_ACK_Q_SIZE < 1) || (CYMESH_ACK_Q_SIZE > 254) || (CYMESH_TX_MESSAGE_Q_SIZE < 1) || \
+    (CYMESH_TX_MESSAGE_Q_SIZE > 254) || (CYMESH_MULTI_MESSAGE_Q_NUMBER_OF_BUFFERS < 1) || \
+    (CYMESH_MULTI_MESSAGE_Q_NUMBER_OF_BUFFERS > 254)
+    #error "Invalid message queue size"
+#endif
+
 
 /*******************************************************************************
 * Structure and enums
@@ -122,6 +141,12 @@ typedef struct
     uint32 timeStamp;
     bool isWaiting;
     bool isAvailable;
+    
+#if (CYMESH_ENABLE_ADAPTIVE_RTO == 1)
+    /* Transmissions so far, and the time the last one waits, in ms */
+    uint8 transmissions;
+    uint32 timeout;
+#endif
 } CYMESH_TX_MESSAGE_NODE_T;
 
 
@@ -179,6 +204,7 @@ uint8 CyMesh_IsTxMessageQueueFree(void);
 uint8 CyMesh_GetTxQueueMatch(uint8 matchTid);
 CYMESH_API_RETURN_T CyMesh_TxMessageQueueInsert(uint8 queueIndex, CYMESH_TX_MESSAGE_NODE_T * packet, bool isNewPacket);
 void CyMesh_TxMessageQueueFreeUp(uint8 queueIndex);
+void CyMesh_TxMessageQueueSetNextTtl(uint8 ttl);
 void CyMesh_ResetTxMessageQueueCount(void);
 CYMESH_API_RETURN_T CyMesh_SchedulePendingTxMessagePackets(void);
 
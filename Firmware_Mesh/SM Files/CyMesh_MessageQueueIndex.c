@@ -0,0 +1,185 @@
+/***************************************************************************//**
+* \file CyMesh_MessageQueueIndex.c
+* \version 1.0
+*
+* \brief
+*  This file contains the TID index of the queues of the application layer of
+*  the BLE SmartMesh v1 solution.
+*
+*  The library finds the ACK, TX message and multi message queue entry of a
+*  received TID, and a free entry, by walking the queue, on every message.
+*  The index maps the 6 bits of the TID directly to the first entry taken
+*  with it; the rare entries that share a TID are chained behind it, in the
+*  order they were taken. The released entries are kept on a stack. The
+*  entries never taken since the reset are not on it: they are free as long
+*  as they are past the high water mark, so that an index of zeros, as the
+*  queues are at power up, is empty, and a walk of a queue can stop at the
+*  mark. Finding, taking and releasing an entry do not depend on the size of
+*  the queue.
+*
+*  Tools/network_bench/queue_bench.c measures the match of a TID with the
+*  index and with the walk of the library.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <string.h>
+#include "CyMesh_MessageQueueIndex.h"
+
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+#define CYMESH_MESSAGE_Q_INDEX_END              (0u)    /* Last entry of a TID chain */
+
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+void CyMesh_MessageQueueIndexReset(CYMESH_MESSAGE_Q_INDEX_STRUCT * index)
+{
+    memset(index->tidHead, 0, sizeof(index->tidHead));
+    index->releasedCount = 0u;
+    index->unused = 0u;
+}
+
+
+uint8 CyMesh_MessageQueueIndexGetFree(const CYMESH_MESSAGE_Q_INDEX_STRUCT * index)
+{
+    if(index->releasedCount != 0u)
+    {
+        return index->released[index->releasedCount - 1u];
+    }
+    if(index->unused < index->size)
+    {
+        return index->unused;
+    }
+
+    return CYMESH_MESSAGE_Q_INDEX_NONE;
+}
+
+
+bool CyMesh_MessageQueueIndexTake(CYMESH_MESSAGE_Q_INDEX_STRUCT * index, uint8 entry, uint8 tid)
+{
+    uint8 * link;
+    uint8 i;
+
+    if(entry >= index->size)
+    {
+        return false;
+    }
+
+    if(entry >= index->unused)
+    {
+        /* The entries skipped over are released */
+        for(i = index->unused; i < entry; i++)
+        {
+            index->next[i] = CYMESH_MESSAGE_Q_INDEX_NONE;
+            index->released[index->releasedCount] = i;
+            index->releasedCount++;
+        }
+        index->unused = entry + 1u;
+    }
+    else if(index->next[entry] != CYMESH_MESSAGE_Q_INDEX_NONE)
+    {
+        return false;
+    }
+    else
+    {
+        /* A released entry is on the stack, on top unless the caller did not
+         * take the one CyMesh_MessageQueueIndexGetFree() returned */
+        i = index->releasedCount - 1u;
+        while(index->released[i] != entry)
+        {
+            i--;
+        }
+        index->releasedCount--;
+        index->released[i] = index->released[index->releasedCount];
+    }
+
+    link = &index->tidHead[tid & CYMESH_MESSAGE_Q_INDEX_TID_MASK];
+    while(*link != CYMESH_MESSAGE_Q_INDEX_END)
+    {
+        link = &index->next[*link - 1u];
+    }
+    *link = entry + 1u;
+    index->next[entry] = CYMESH_MESSAGE_Q_INDEX_END;
+
+    return true;
+}
+
+
+bool CyMesh_MessageQueueIndexRelease(CYMESH_MESSAGE_Q_INDEX_STRUCT * index, uint8 entry, uint8 tid)
+{
+    uint8 * link;
+
+    if(CyMesh_MessageQueueIndexIsTaken(index, entry) == false)
+    {
+        return false;
+    }
+
+    link = &index->tidHead[tid & CYMESH_MESSAGE_Q_INDEX_TID_MASK];
+    while((*link != CYMESH_MESSAGE_Q_INDEX_END) && (*link != (entry + 1u)))
+    {
+        link = &index->next[*link - 1u];
+    }
+    if(*link != CYMESH_MESSAGE_Q_INDEX_END)
+    {
+        *link = index->next[entry];
+    }
+
+    index->next[entry] = CYMESH_MESSAGE_Q_INDEX_NONE;
+    index->released[index->releasedCount] = entry;
+    index->releasedCount++;
+
+    return true;
+}
+
+
+bool CyMesh_MessageQueueIndexIsTaken(const CYMESH_MESSAGE_Q_INDEX_STRUCT * index, uint8 entry)
+{
+    return (entry < index->unused) && (index->next[entry] != CYMESH_MESSAGE_Q_INDEX_NONE);
+}
+
+
+uint8 CyMesh_MessageQueueIndexGetLimit(const CYMESH_MESSAGE_Q_INDEX_STRUCT * index)
+{
+    return index->unused;
+}
+
+
+uint8 CyMesh_MessageQueueIndexFirst(const CYMESH_MESSAGE_Q_INDEX_STRUCT * index, uint8 tid)
+{
+    uint8 head = index->tidHead[tid & CYMESH_MESSAGE_Q_INDEX_TID_MASK];
+
+    return (head != CYMESH_MESSAGE_Q_INDEX_END) ? (head - 1u) : CYMESH_MESSAGE_Q_INDEX_NONE;
+}
+
+
+uint8 CyMesh_MessageQueueIndexNext(const CYMESH_MESSAGE_Q_INDEX_STRUCT * index, uint8 entry)
+{
+    uint8 next;
+
+    if(CyMesh_MessageQueueIndexIsTaken(index, entry) == false)
+    {
+        return CYMESH_MESSAGE_Q_INDEX_NONE;
+    }
+
+    next = index->next[entry];
+
+    return (next != CYMESH_MESSAGE_Q_INDEX_END) ? (next - 1u) : CYMESH_MESSAGE_Q_INDEX_NONE;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,200 @@
+/***************************************************************************//**
+* \file CyMesh_MessageQueueIndex.h
+* \version 1.0
+*
+* \brief
+*  This is the header file of the TID index of the application layer queues.
+*  It finds the entry of a queue with a given TID and a free entry in constant
+*  time, whatever the size of the queue.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined (CYMESH_MESSAGE_QUEUE_INDEX_H)
+#define CYMESH_MESSAGE_QUEUE_INDEX_H
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <stdbool.h>
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+/* Bits of the TID octet that are the TID, CYMESH_APPLICATION_TID_MASK */
+#define CYMESH_MESSAGE_Q_INDEX_TID_MASK         (0x3Fu)
+#define CYMESH_MESSAGE_Q_INDEX_TID_COUNT        (CYMESH_MESSAGE_Q_INDEX_TID_MASK + 1u)
+
+/* Largest queue; entry numbers plus one and CYMESH_MESSAGE_Q_INDEX_NONE must
+ * fit in a byte */
+#define CYMESH_MESSAGE_Q_INDEX_MAX_SIZE         (254u)
+
+/* No entry, which is also the FULL and MATCH_FAILED value of the queues */
+#define CYMESH_MESSAGE_Q_INDEX_NONE             (0xFFu)
+
+/* Static initializer of an index of size entries. next and released are
+ * arrays of size bytes. */
+#define CYMESH_MESSAGE_Q_INDEX_INIT(next, released, size)   { { 0u }, (next), (released), 0u, 0u, (size) }
+
+
+/*******************************************************************************
+* Structures and Enums
+*******************************************************************************/
+typedef struct
+{
+    /* Per TID, the first entry with that TID plus one, 0 for none */
+    uint8 tidHead[CYMESH_MESSAGE_Q_INDEX_TID_COUNT];
+
+    /* Per entry in use, the next entry with the same TID plus one, 0 for the
+     * last one; CYMESH_MESSAGE_Q_INDEX_NONE for a released entry */
+    uint8 * next;
+
+    /* Stack of the released entries */
+    uint8 * released;
+    uint8 releasedCount;
+
+    /* Entries from this one on were not taken since the reset. They are free
+     * without being on the stack, so that an index of zeros is empty. */
+    uint8 unused;
+
+    uint8 size;
+} CYMESH_MESSAGE_Q_INDEX_STRUCT;
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+/******************************************************************************
+* Function Name: CyMesh_MessageQueueIndexReset
+*******************************************************************************
+*
+*  This function releases all the entries. An index set up with
+* CYMESH_MESSAGE_Q_INDEX_INIT() is empty without it.
+*
+*  \param CYMESH_MESSAGE_Q_INDEX_STRUCT*: index
+*
+*  \return None
+*
+******************************************************************************/
+void CyMesh_MessageQueueIndexReset(CYMESH_MESSAGE_Q_INDEX_STRUCT * index);
+
+/******************************************************************************
+* Function Name: CyMesh_MessageQueueIndexGetFree
+*******************************************************************************
+*
+*  This function returns a free entry, without taking it: the one released
+* last, or else the first one that was never taken.
+*
+*  \param CYMESH_MESSAGE_Q_INDEX_STRUCT*: index
+*
+*  \return uint8: entry, or CYMESH_MESSAGE_Q_INDEX_NONE if all are taken
+*
+******************************************************************************/
+uint8 CyMesh_MessageQueueIndexGetFree(const CYMESH_MESSAGE_Q_INDEX_STRUCT * index);
+
+/******************************************************************************
+* Function Name: CyMesh_MessageQueueIndexTake
+*******************************************************************************
+*
+*  This function takes a free entry for a message with the given TID. The
+* entries with the same TID are matched in the order they were taken.
+*
+*  \param CYMESH_MESSAGE_Q_INDEX_STRUCT*: index
+*
+*  \param uint8: entry
+*
+*  \param uint8: TID octet of the message; the bits out of
+*                CYMESH_MESSAGE_Q_INDEX_TID_MASK are ignored
+*
+*  \return bool: false if the entry is out of the queue or already taken
+*
+******************************************************************************/
+bool CyMesh_MessageQueueIndexTake(CYMESH_MESSAGE_Q_INDEX_STRUCT * index, uint8 entry, uint8 tid);
+
+/******************************************************************************
+* Function Name: CyMesh_MessageQueueIndexRelease
+*******************************************************************************
+*
+*  This function releases an entry, which was taken with the given TID.
+*
+*  \param CYMESH_MESSAGE_Q_INDEX_STRUCT*: index
+*
+*  \param uint8: entry
+*
+*  \param uint8: TID octet the entry was taken with
+*
+*  \return bool: false if the entry was not taken
+*
+******************************************************************************/
+bool CyMesh_MessageQueueIndexRelease(CYMESH_MESSAGE_Q_INDEX_STRUCT * index, uint8 entry, uint8 tid);
+
+/******************************************************************************
+* Function Name: CyMesh_MessageQueueIndexIsTaken
+*******************************************************************************
+*
+*  This function tells whether an entry is taken.
+*
+*  \param CYMESH_MESSAGE_Q_INDEX_STRUCT*: index
+*
+*  \param uint8: entry
+*
+*  \return bool: true if the entry is taken
+*
+******************************************************************************/
+bool CyMesh_MessageQueueIndexIsTaken(const CYMESH_MESSAGE_Q_INDEX_STRUCT * index, uint8 entry);
+
+/******************************************************************************
+* Function Name: CyMesh_MessageQueueIndexGetLimit
+*******************************************************************************
+*
+*  This function returns the number of entries that may be taken: the entries
+* from it on were not taken since the reset, so that a walk of the queue can
+* stop there.
+*
+*  \param CYMESH_MESSAGE_Q_INDEX_STRUCT*: index
+*
+*  \return uint8: entries that may be taken
+*
+******************************************************************************/
+uint8 CyMesh_MessageQueueIndexGetLimit(const CYMESH_MESSAGE_Q_INDEX_STRUCT * index);
+
+/******************************************************************************
+* Function Name: CyMesh_MessageQueueIndexFirst
+*******************************************************************************
+*
+*  This function returns the first entry taken with a TID. The TID octet of
+* the entry should still be compared, as the other bits are not indexed.
+*
+*  \param CYMESH_MESSAGE_Q_INDEX_STRUCT*: index
+*
+*  \param uint8: TID octet
+*
+*  \return uint8: entry, or CYMESH_MESSAGE_Q_INDEX_NONE
+*
+******************************************************************************/
+uint8 CyMesh_MessageQueueIndexFirst(const CYMESH_MESSAGE_Q_INDEX_STRUCT * index, uint8 tid);
+
+/******************************************************************************
+* Function Name: CyMesh_MessageQueueIndexNext
+*******************************************************************************
+*
+*  This function returns the entry taken with the same TID after an entry.
+*
+*  \param CYMESH_MESSAGE_Q_INDEX_STRUCT*: index
+*
+*  \param uint8: entry that is taken
+*
+*  \return uint8: entry, or CYMESH_MESSAGE_Q_INDEX_NONE
+*
+******************************************************************************/
+uint8 CyMesh_MessageQueueIndexNext(const CYMESH_MESSAGE_Q_INDEX_STRUCT * index, uint8 entry);
+
+#endif
+/* [] END OF FILE */
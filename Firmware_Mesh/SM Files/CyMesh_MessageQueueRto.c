@@ -0,0 +1,221 @@
+/***************************************************************************//**
+* \file CyMesh_MessageQueueRto.c
+* \version 1.0
+*
+* \brief
+*  This file contains the retransmission timeout table of the reliable
+*  message queue of the BLE SmartMesh v1 application layer.
+*
+*  The library waits cyMesh_AppReliableMsgTimeout seconds for the response to
+*  a reliable message, whatever its destination: a neighbour answers in tens
+*  of ms, so a lost message or response costs seconds, while a destination
+*  many hops away on a busy mesh may take longer than the timeout and be sent
+*  everything twice. The round trip time to each destination is estimated
+*  from its responses as TCP does (RFC 6298): a smoothed time and its mean
+*  variation, with the timeout at SRTT + 4 * RTTVAR. A response is only
+*  sampled if its message was sent once (Karn's rule). After a timeout the
+*  wait of the message doubles, with a random jitter. The timeout of the
+*  destination doubles too and stays so until a sample is taken again, so
+*  that a path that got slower than its timeout is given the time to answer
+*  a first copy. Unlike TCP, it backs off to at most
+*  CYMESH_TX_RTO_BACKOFF_LIMIT times the sampled timeout: a timeout on a mesh
+*  path is mostly a lost message rather than congestion, and a longer first
+*  wait for the next messages only delays their retransmission. A
+*  destination without a sample starts at the fixed timeout.
+*
+*  Tools/network_bench/rto_sim.c simulates the completion time of reliable
+*  messages with these options against the fixed timeout.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <stddef.h>
+#include <string.h>
+#include "CyMesh_MessageQueueRto.h"
+
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+#define CYMESH_TX_RTO_FREE                      (0x0000u)
+#define CYMESH_TX_RTO_RANDOM_SEED               (0x52544F30u)
+#define CYMESH_TX_RTO_SRTT_SHIFT                (3u)    /* SRTT is kept times 8 */
+#define CYMESH_TX_RTO_RTTVAR_SHIFT              (2u)    /* RTTVAR is kept times 4 */
+
+
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+
+/* Xorshift */
+static uint32 CyMesh_TxRtoRandom(CYMESH_TX_RTO_STRUCT * rto)
+{
+    uint32 x = rto->random;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rto->random = x;
+
+    return x;
+}
+
+
+static uint32 CyMesh_TxRtoClamp(uint32 timeout)
+{
+    if(timeout < CYMESH_TX_RTO_MIN_MS)
+    {
+        return CYMESH_TX_RTO_MIN_MS;
+    }
+    if(timeout > CYMESH_TX_RTO_MAX_MS)
+    {
+        return CYMESH_TX_RTO_MAX_MS;
+    }
+
+    return timeout;
+}
+
+
+/* SRTT + 4 * RTTVAR; RTTVAR is kept times 4, which is its weight */
+static uint32 CyMesh_TxRtoSampled(const CYMESH_TX_RTO_ENTRY_T * entry)
+{
+    return CyMesh_TxRtoClamp((entry->srtt >> CYMESH_TX_RTO_SRTT_SHIFT) + entry->rttvar);
+}
+
+
+/* Entry of dst, NULL if dst is not in the table */
+static CYMESH_TX_RTO_ENTRY_T * CyMesh_TxRtoFind(CYMESH_TX_RTO_STRUCT * rto, uint16 dst)
+{
+    uint8 i;
+
+    for(i = 0u; i < CYMESH_TX_RTO_SIZE; i++)
+    {
+        if(rto->entry[i].dst == dst)
+        {
+            return &rto->entry[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+void CyMesh_TxRtoInit(CYMESH_TX_RTO_STRUCT * rto, uint32 seed)
+{
+    memset(rto, 0, sizeof(*rto));
+
+    /* Xorshift is stuck at 0 */
+    rto->random = (seed != 0u) ? seed : CYMESH_TX_RTO_RANDOM_SEED;
+}
+
+
+uint32 CyMesh_TxRtoGet(CYMESH_TX_RTO_STRUCT * rto, uint16 dst, uint32 initial, uint32 now)
+{
+    CYMESH_TX_RTO_ENTRY_T * entry;
+    uint8 i;
+
+    if(dst == CYMESH_TX_RTO_FREE)
+    {
+        return CyMesh_TxRtoClamp(initial);
+    }
+
+    entry = CyMesh_TxRtoFind(rto, dst);
+    if(entry == NULL)
+    {
+        /* A free entry, or the one used least recently */
+        entry = &rto->entry[0];
+        for(i = 1u; (i < CYMESH_TX_RTO_SIZE) && (entry->dst != CYMESH_TX_RTO_FREE); i++)
+        {
+            if((rto->entry[i].dst == CYMESH_TX_RTO_FREE) ||
+               ((uint32)(now - rto->entry[i].used) > (uint32)(now - entry->used)))
+            {
+                entry = &rto->entry[i];
+            }
+        }
+        entry->dst = dst;
+        entry->srtt = 0u;
+        entry->rttvar = 0u;
+        entry->rto = CyMesh_TxRtoClamp(initial);
+    }
+    entry->used = now;
+
+    return entry->rto;
+}
+
+
+uint32 CyMesh_TxRtoBackoff(CYMESH_TX_RTO_STRUCT * rto, uint16 dst, uint32 timeout)
+{
+    CYMESH_TX_RTO_ENTRY_T * entry = CyMesh_TxRtoFind(rto, dst);
+    uint32 next = CyMesh_TxRtoClamp(2u * timeout);
+
+    if((entry != NULL) && (dst != CYMESH_TX_RTO_FREE))
+    {
+        entry->rto = CyMesh_TxRtoClamp(2u * entry->rto);
+        if((entry->srtt != 0u) && (entry->rto > (CYMESH_TX_RTO_BACKOFF_LIMIT * CyMesh_TxRtoSampled(entry))))
+        {
+            entry->rto = CYMESH_TX_RTO_BACKOFF_LIMIT * CyMesh_TxRtoSampled(entry);
+        }
+    }
+
+    return next + (CyMesh_TxRtoRandom(rto) % (((next * CYMESH_TX_RTO_JITTER_PERCENT) / 100u) + 1u));
+}
+
+
+uint32 CyMesh_TxRtoSample(CYMESH_TX_RTO_STRUCT * rto, uint16 dst, uint32 rtt)
+{
+    CYMESH_TX_RTO_ENTRY_T * entry = CyMesh_TxRtoFind(rto, dst);
+    uint32 delta;
+
+    if((entry == NULL) || (dst == CYMESH_TX_RTO_FREE))
+    {
+        return 0u;
+    }
+
+    /* Keeps srtt above 0, which marks an entry without a sample */
+    if(rtt == 0u)
+    {
+        rtt = 1u;
+    }
+    if(rtt > CYMESH_TX_RTO_MAX_MS)
+    {
+        rtt = CYMESH_TX_RTO_MAX_MS;
+    }
+
+    if(entry->srtt == 0u)
+    {
+        /* SRTT = R, RTTVAR = R / 2 */
+        entry->srtt = rtt << CYMESH_TX_RTO_SRTT_SHIFT;
+        entry->rttvar = (rtt << CYMESH_TX_RTO_RTTVAR_SHIFT) / 2u;
+    }
+    else
+    {
+        /* RTTVAR += (|SRTT - R| - RTTVAR) / 4, SRTT += (R - SRTT) / 8 */
+        uint32 srtt = entry->srtt >> CYMESH_TX_RTO_SRTT_SHIFT;
+
+        delta = (rtt > srtt) ? (rtt - srtt) : (srtt - rtt);
+        entry->rttvar = (entry->rttvar - (entry->rttvar >> CYMESH_TX_RTO_RTTVAR_SHIFT)) + delta;
+        entry->srtt = (entry->srtt - srtt) + rtt;
+    }
+
+    entry->rto = CyMesh_TxRtoSampled(entry);
+
+    return entry->rto;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,182 @@
+/***************************************************************************//**
+* \file CyMesh_MessageQueueRto.h
+* \version 1.0
+*
+* \brief
+*  This is the header file of the retransmission timeout table of the reliable
+*  message queue. It estimates the round trip time to each destination from
+*  its responses and gives the time a reliable message waits before it is
+*  sent again.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined (CYMESH_MESSAGE_QUEUE_RTO_H)
+#define CYMESH_MESSAGE_QUEUE_RTO_H
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <stdbool.h>
+
+
+/*******************************************************************************
+* Compile Time Options
+*******************************************************************************/
+/* Number of destinations tracked, 20 bytes of RAM each. A new destination
+ * replaces the one sent to least recently. */
+#if !defined(CYMESH_TX_RTO_SIZE)
+    #define CYMESH_TX_RTO_SIZE                      (8u)
+#endif
+
+/* Lowest timeout, in ms. A response is at least one relay and one bearer
+ * interval away on each hop, so a lower RTO only adds retransmissions */
+#if !defined(CYMESH_TX_RTO_MIN_MS)
+    #define CYMESH_TX_RTO_MIN_MS                    (250u)
+#endif
+
+/* Highest timeout, in ms, before the jitter */
+#if !defined(CYMESH_TX_RTO_MAX_MS)
+    #define CYMESH_TX_RTO_MAX_MS                    (20000u)
+#endif
+
+/* The timeout of a destination backs off to at most this many times the
+ * timeout of its round trip samples */
+#if !defined(CYMESH_TX_RTO_BACKOFF_LIMIT)
+    #define CYMESH_TX_RTO_BACKOFF_LIMIT             (2u)
+#endif
+
+/* A backed-off timeout is lengthened by a random 0 to this percentage, so
+ * that the senders that lost their messages to the same collision do not
+ * send them again together */
+#if !defined(CYMESH_TX_RTO_JITTER_PERCENT)
+    #define CYMESH_TX_RTO_JITTER_PERCENT            (25u)
+#endif
+
+#if (CYMESH_TX_RTO_SIZE < 1u) || (CYMESH_TX_RTO_SIZE > 255u) || (CYMESH_TX_RTO_MIN_MS < 1u) || \
+    (CYMESH_TX_RTO_MAX_MS < CYMESH_TX_RTO_MIN_MS) || (CYMESH_TX_RTO_MAX_MS > 0x00FFFFFFu) || \
+    (CYMESH_TX_RTO_BACKOFF_LIMIT < 1u) || (CYMESH_TX_RTO_BACKOFF_LIMIT > 64u) || (CYMESH_TX_RTO_JITTER_PERCENT > 100u)
+    #error "Invalid retransmission timeout configuration"
+#endif
+
+
+/*******************************************************************************
+* Structures and Enums
+*******************************************************************************/
+typedef struct
+{
+    /* Destination address, 0 for a free entry */
+    uint16 dst;
+
+    /* Smoothed round trip time in ms, times 8; 0 until the first sample */
+    uint32 srtt;
+
+    /* Round trip time variation in ms, times 4 */
+    uint32 rttvar;
+
+    /* Timeout of the next message to dst, in ms */
+    uint32 rto;
+
+    /* Timestamp of the last message sent to dst, in ms */
+    uint32 used;
+} CYMESH_TX_RTO_ENTRY_T;
+
+typedef struct
+{
+    CYMESH_TX_RTO_ENTRY_T entry[CYMESH_TX_RTO_SIZE];
+
+    /* State of the jitter */
+    uint32 random;
+} CYMESH_TX_RTO_STRUCT;
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+/******************************************************************************
+* Function Name: CyMesh_TxRtoInit
+*******************************************************************************
+*
+*  This function empties the table.
+*
+*  \param CYMESH_TX_RTO_STRUCT*: table
+*
+*  \param uint32: seed of the jitter, which should differ between the nodes
+*
+*  \return None
+*
+******************************************************************************/
+void CyMesh_TxRtoInit(CYMESH_TX_RTO_STRUCT * rto, uint32 seed);
+
+/******************************************************************************
+* Function Name: CyMesh_TxRtoGet
+*******************************************************************************
+*
+*  This function returns the timeout of a message sent to dst for the first
+* time. A destination that is not tracked yet is added with the initial
+* timeout, which it keeps until its first response.
+*
+*  \param CYMESH_TX_RTO_STRUCT*: table
+*
+*  \param uint16: DST of the message
+*
+*  \param uint32: timeout of a destination without a round trip sample, in ms
+*
+*  \param uint32: timestamp, in ms
+*
+*  \return uint32: timeout, in ms
+*
+******************************************************************************/
+uint32 CyMesh_TxRtoGet(CYMESH_TX_RTO_STRUCT * rto, uint16 dst, uint32 initial, uint32 now);
+
+/******************************************************************************
+* Function Name: CyMesh_TxRtoBackoff
+*******************************************************************************
+*
+*  This function is called when a message to dst timed out after waiting
+* timeout ms. It returns the timeout of the next transmission: twice the
+* last one, up to CYMESH_TX_RTO_MAX_MS, plus the jitter. The timeout of dst
+* doubles too, up to CYMESH_TX_RTO_BACKOFF_LIMIT times the timeout of its
+* samples, and stays backed off until a sample is taken.
+*
+*  \param CYMESH_TX_RTO_STRUCT*: table
+*
+*  \param uint16: DST of the message
+*
+*  \param uint32: timeout the message waited, in ms
+*
+*  \return uint32: timeout of the next transmission, in ms
+*
+******************************************************************************/
+uint32 CyMesh_TxRtoBackoff(CYMESH_TX_RTO_STRUCT * rto, uint16 dst, uint32 timeout);
+
+/******************************************************************************
+* Function Name: CyMesh_TxRtoSample
+*******************************************************************************
+*
+*  This function takes the round trip time of a message to dst that was
+* answered. Following Karn's rule, the caller only passes messages that were
+* sent once: the response to a retransmitted message may be the response to
+* any of its copies. The smoothed time and its variation are updated as in
+* RFC 6298, and the timeout of dst is SRTT + 4 * RTTVAR, within
+* CYMESH_TX_RTO_MIN_MS and CYMESH_TX_RTO_MAX_MS.
+*
+*  \param CYMESH_TX_RTO_STRUCT*: table
+*
+*  \param uint16: DST of the message
+*
+*  \param uint32: time from the transmission to the response, in ms
+*
+*  \return uint32: new timeout of dst, in ms, or 0 if dst is not tracked
+*
+******************************************************************************/
+uint32 CyMesh_TxRtoSample(CYMESH_TX_RTO_STRUCT * rto, uint16 dst, uint32 rtt);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,714 @@
+/***************************************************************************//**
+* \file CyMesh_Network.c
+* \version 1.0
+*
+* \brief
+*  This file contains the network layer of the BLE SmartMesh v1 solution. It
+*  replaces the CyMesh_Network object of SM_LIB_256K.a and keeps its interface
+*  to the transport layer and the bearer.
+*
+*  Relayed packets are encrypted again straight from the buffer they were
+*  decrypted in, without the second copy and header rebuild of
+*  CyMesh_NetworkSendData(). A packet only enters the message cache (see
+*  CyMesh_NetworkCache.c) after its network MIC was checked, so a forged packet
+*  cannot make the cache drop the real one. Authenticated packets for this node
+*  are then checked against the replay protection list (see
+*  CyMesh_NetworkReplay.c), which is written to flash from the SM timer when
+*  it changed; relaying only depends on the message cache. See
+*  Tools/network_bench for the host benchmark, and
+*  Tools/network_bench/interop_check.c for the PDUs checked against the
+*  library object.
+*
+*  With CYMESH_ENABLE_MANAGED_FLOODING, a relay is encrypted at once but held
+*  in the relay policy table (see CyMesh_NetworkFlood.c) for a back-off set by
+*  its RSSI. Copies of the PDU that hit the message cache in the meantime are
+*  counted there, and the relay is cancelled once enough were heard. The SM
+*  timer hands the relays whose back-off ran out to the bearer.
+*
+*  With CYMESH_ENABLE_TTL_LEARNING, authenticated packets teach the hop table
+*  (see CyMesh_NetworkHops.c) the distance to their source, and messages to a
+*  source in the table are sent with a TTL that just reaches it.
+*
+*  Remove this file from the project to link the library version again.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <string.h>
+#include "CyMesh_Network.h"
+#include "CyMesh_Bearer.h"
+#include "CyMesh_BearerTx.h"
+#include "CyMesh_Security.h"
+#include "CyMesh_ConfigLog.h"
+#include "CyMesh_Timer.h"
+
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+#define CYMESH_NET_HEADER_IVI_NID               (0u)    /* IVI (1 bit), NID (7 bits) */
+#define CYMESH_NET_HEADER_CTL_TTL               (1u)    /* AKF (1 bit), FUT (1 bit), TTL (6 bits) */
+#define CYMESH_NET_HEADER_SEQ                   (2u)
+#define CYMESH_NET_HEADER_SRC                   (5u)
+#define CYMESH_NET_HEADER_DST                   (7u)    /* First encrypted byte */
+
+#define CYMESH_NET_OBFUSCATED_OFFSET            (CYMESH_NET_HEADER_CTL_TTL)
+#define CYMESH_NET_ENCRYPTED_OFFSET             (CYMESH_NET_HEADER_DST)
+#define CYMESH_NET_MIC_SIZE                     (4u)
+#define CYMESH_NET_NID_BITS                     (7u)
+
+#define CYMESH_NET_AKF_MASK                     (0x80u)
+#define CYMESH_NET_FUT_MASK                     (0x40u)
+#define CYMESH_NET_TTL_MASK                     (0x3Fu)
+#define CYMESH_NET_RELAY_MIN_TTL                (2u)
+
+#define CYMESH_NET_SEQ_HIGH_MASK                (0x1Fu) /* SEQ bits covered by the message cache */
+
+#define CYMESH_NET_ADDR_UNASSIGNED              (0x0000u)
+#define CYMESH_NET_ADDR_BROADCAST               (0xFFFFu)
+#define CYMESH_NET_ADDR_UNICAST_MASK            (0x8000u)
+#define CYMESH_NET_ADDR_GROUP_MASK              (0xC000u)
+#define CYMESH_NET_INDEX_ALL                    (0xFFu)
+
+#define CYMESH_NET_GET_UINT16(p)                ((uint16)(((uint16)(p)[0] << 8) | (p)[1]))
+#define CYMESH_NET_GET_SEQ(p)                   ((((uint32)(p)[0] & CYMESH_NET_SEQ_HIGH_MASK) << 16) | \
+                                                 ((uint32)(p)[1] << 8) | (p)[2])
+
+
+
+/*******************************************************************************
+* Data Structures
+*******************************************************************************/
+
+/* Network messages seen recently */
+CYMESH_NET_MSG_CACHE_STRUCT net_msg_cache;
+
+/* Highest SEQ accepted per source; RAM and Flash copies */
+CYMESH_NET_REPLAY_STRUCT net_replay_list;
+
+#if defined(__ARMCC_VERSION)
+    CY_ALIGN(CYDEV_FLS_ROW_SIZE) const CYMESH_NET_REPLAY_LIST_T cyMesh_NetworkReplayFlash CY_SECTION(".cy_checksum_exclude") =
+#elif defined (__GNUC__)
+    const CYMESH_NET_REPLAY_LIST_T cyMesh_NetworkReplayFlash CY_SECTION(".cy_checksum_exclude")
+        CY_ALIGN(CYDEV_FLS_ROW_SIZE) =
+#elif defined (__ICCARM__)
+    #pragma data_alignment=CY_FLASH_SIZEOF_ROW
+    #pragma location=".cy_checksum_exclude"
+    const CYMESH_NET_REPLAY_LIST_T cyMesh_NetworkReplayFlash =
+#endif  /* (__ARMCC_VERSION) */
+{
+    /* seq */
+    {0},
+
+    /* src */
+    {0},
+
+    /* count */
+    0,
+
+    /* tag */
+    0,
+
+    /* checksum, invalid */
+    0
+};
+
+#if (CYMESH_ENABLE_MANAGED_FLOODING == 1)
+/* Relays waiting for their back-off */
+CYMESH_NET_FLOOD_STRUCT net_flood;
+#endif
+
+#if (CYMESH_ENABLE_TTL_LEARNING == 1)
+/* Hop distance to the sources heard */
+CYMESH_NET_HOPS_STRUCT net_hops;
+#endif
+
+/* SM timer ticks to the next check for a changed replay list */
+static uint32 networkReplaySaveCountdown;
+
+/* Transport layer callback, set in CyMesh_NetworkStart() */
+CYMESH_CALLBACK_T cyMesh_NetworkCallbackToTransport;
+
+/* Bit 0 is set on every bearer event */
+uint8 cyMesh_NetworkEventHandlerFlag;
+
+/* Reentrancy guards of CyMesh_ProcessNetworkPacket() and of the encryption path */
+static struct
+{
+    uint8 process;
+    uint8 send;
+} networkMutex;
+
+
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+
+/* Takes one of the networkMutex flags. Returns false if it is already taken. */
+static bool CyMesh_NetworkLock(uint8 * mutex)
+{
+    uint8 interruptState = CyEnterCriticalSection();
+    bool isLocked = false;
+
+    if(*mutex == 0u)
+    {
+        *mutex = 1u;
+        isLocked = true;
+    }
+
+    CyExitCriticalSection(interruptState);
+
+    return isLocked;
+}
+
+
+/******************************************************************************
+* Function Name: CyMesh_NetworkEncrypt
+*******************************************************************************
+*
+*  Encrypts and obfuscates a network PDU in place. The caller holds
+*  networkMutex.send.
+*
+*  \param uint8*: network PDU with a clear header, CYMESH_NET_MIC_SIZE bytes
+*                 longer than length for the MIC.
+*
+*  \param uint8: length of the PDU without the MIC
+*
+*  \return CYMESH_API_RETURN_T: CYMESH_ERROR_AES_CCM_ENCRYPTION_FAILED or
+*          CYMESH_NET_ERROR_OBFUSCATE_FAILED if the security layer failed,
+*          CYMESH_ERROR_OK otherwise.
+*
+******************************************************************************/
+static CYMESH_API_RETURN_T CyMesh_NetworkEncrypt(uint8 * packet, uint8 length, uint8 meshId)
+{
+    if(CyMesh_SecurityEncryptNetworkData(meshId, &packet[CYMESH_NET_OBFUSCATED_OFFSET],
+                                         length - CYMESH_NET_ENCRYPTED_OFFSET) != CYMESH_ERROR_OK)
+    {
+        return CYMESH_ERROR_AES_CCM_ENCRYPTION_FAILED;
+    }
+
+    if(CyMesh_SecurityObfuscateNetHeader(meshId, &packet[CYMESH_NET_OBFUSCATED_OFFSET]) != CYMESH_ERROR_OK)
+    {
+        return CYMESH_NET_ERROR_OBFUSCATE_FAILED;
+    }
+
+    return CYMESH_ERROR_OK;
+}
+
+
+/* Queues an encrypted PDU of length bytes and its MIC in the bearer */
+static void CyMesh_NetworkSend(const uint8 * packet, uint8 length, uint8 txCount, CYMESH_BEARER_TX_CLASS_T txClass)
+{
+#if (CYMESH_ENABLE_BEARER_TX_SCHEDULER == 1)
+    (void)CyMesh_BearerTxSend(packet, length + CYMESH_NET_MIC_SIZE, CYMESH_BEARER_ADV, txClass, txCount, true);
+#else
+    (void)txClass;
+    (void)CyMesh_BearerSendData(packet, length + CYMESH_NET_MIC_SIZE, CYMESH_BEARER_ADV, txCount, false, true);
+#endif
+}
+
+
+/* Encrypts a network PDU and queues it in the bearer, see
+ * CyMesh_NetworkEncrypt() */
+static CYMESH_API_RETURN_T CyMesh_NetworkEncryptAndSend(uint8 * packet, uint8 length, uint8 txCount, uint8 meshId,
+                                                        CYMESH_BEARER_TX_CLASS_T txClass)
+{
+    CYMESH_API_RETURN_T result = CyMesh_NetworkEncrypt(packet, length, meshId);
+
+    if(result == CYMESH_ERROR_OK)
+    {
+        CyMesh_NetworkSend(packet, length, txCount, txClass);
+    }
+
+    return result;
+}
+
+
+/******************************************************************************
+* Function Name: CyMesh_NetworkRelay
+*******************************************************************************
+*
+*  Relays a received packet with its TTL decremented. The packet is encrypted
+*  again in the buffer it was decrypted in. The TTL is part of the network
+*  nonce and the obfuscation depends on the ciphertext, so neither step can be
+*  reused from the received packet. With CYMESH_ENABLE_MANAGED_FLOODING the
+*  encrypted packet waits in the relay policy table, unless the table is full.
+*
+*  \param uint8*: clarified and decrypted packet, overwritten
+*
+*  \param uint8: length of the packet including the MIC
+*
+*  \param int8: RSSI of the packet, or CYMESH_NET_FLOOD_RSSI_UNKNOWN
+*
+*  \return None
+*
+******************************************************************************/
+static void CyMesh_NetworkRelay(uint8 * packet, uint8 length, uint8 meshId, int8 rssi)
+{
+    uint8 ttl = packet[CYMESH_NET_HEADER_CTL_TTL] & CYMESH_NET_TTL_MASK;
+#if (CYMESH_ENABLE_MANAGED_FLOODING == 1)
+    uint16 src = CYMESH_NET_GET_UINT16(&packet[CYMESH_NET_HEADER_SRC]);
+    uint32 seq = CYMESH_NET_GET_SEQ(&packet[CYMESH_NET_HEADER_SEQ]);
+    uint8 interruptState;
+    bool isQueued;
+#endif
+
+    if((ttl < CYMESH_NET_RELAY_MIN_TTL) || (CyMesh_NetworkLock(&networkMutex.send) == false))
+    {
+        return;
+    }
+
+    packet[CYMESH_NET_HEADER_CTL_TTL] = (packet[CYMESH_NET_HEADER_CTL_TTL] & (uint8)~CYMESH_NET_TTL_MASK) | (ttl - 1u);
+#if (CYMESH_ENABLE_MANAGED_FLOODING == 1)
+    if(CyMesh_NetworkEncrypt(packet, length - CYMESH_NET_MIC_SIZE, meshId) == CYMESH_ERROR_OK)
+    {
+        /* CyMesh_NetworkFloodUpdate() runs from the SM timer interrupt */
+        interruptState = CyEnterCriticalSection();
+        isQueued = CyMesh_NetworkFloodAdd(&net_flood, src, seq, packet, length, rssi, CyMesh_TimerGetTimestamp());
+        CyExitCriticalSection(interruptState);
+
+        if(isQueued == false)
+        {
+            CyMesh_NetworkSend(packet, length - CYMESH_NET_MIC_SIZE, 1u, CYMESH_BEARER_TX_CLASS_RELAY);
+        }
+    }
+#else
+    (void)rssi;
+    (void)CyMesh_NetworkEncryptAndSend(packet, length - CYMESH_NET_MIC_SIZE, 1u, meshId,
+                                       CYMESH_BEARER_TX_CLASS_RELAY);
+#endif
+
+    networkMutex.send = 0u;
+}
+
+
+#if (CYMESH_ENABLE_TTL_LEARNING == 1)
+/* TTL a received packet is taken to be sent with: the highest default TTL of
+ * the node, as the nodes share the default TTLs of their configuration (see
+ * DefineNodeinfo() and DefineNetInfo()). A packet sent with a lower TTL then
+ * only looks farther away; 0 if the TTL is above all of them. */
+static uint8 CyMesh_NetworkInitialTtl(uint8 ttl)
+{
+    uint8 initialTtl = cyMesh_ConfigInfoRam.deviceInfo.deviceDefaultTtl;
+    uint8 i;
+    uint8 j;
+
+    for(i = 0; i < CYMESH_NUMBER_OF_COMPONENTS; i++)
+    {
+        for(j = 0; j < CYMESH_MAX_MODELS_PER_COMPONENT; j++)
+        {
+            if(cyMesh_ConfigInfoRam.deviceInfo.components[i].model[j].modelDefaultTtl > initialTtl)
+            {
+                initialTtl = cyMesh_ConfigInfoRam.deviceInfo.components[i].model[j].modelDefaultTtl;
+            }
+        }
+    }
+
+    return (initialTtl >= ttl) ? initialTtl : 0u;
+}
+#endif
+
+
+/* Stored replay lists of another network or IV index are not loaded */
+static uint32 CyMesh_NetworkReplayTag(void)
+{
+    const CYMESH_NETWORK_KEYS_T * netKey = &cyMesh_ConfigInfoRam.netInfo.netKeys[0];
+
+    return netKey->ivIndex ^ (((uint32)netKey->networkId[12] << 24) | ((uint32)netKey->networkId[13] << 16) |
+                              ((uint32)netKey->networkId[14] << 8) | netKey->networkId[15]);
+}
+
+
+static CYMESH_API_RETURN_T CyMesh_NetworkProcess(uint8 * pkt, uint8 len, int8 rssi);
+
+
+/* Bearer callback */
+static CYMESH_API_RETURN_T CyMesh_NetworkEventHandler(uint32 event, void * eventParam)
+{
+    CYMESH_BEARER_RX_BUFFER_T rxBuffer;
+
+    cyMesh_NetworkEventHandlerFlag |= 0x01u;
+
+    if(event != CYMESH_EVT_MESH_ADV)
+    {
+        return CYMESH_ERROR_OK;
+    }
+
+    memcpy(&rxBuffer, eventParam, sizeof(rxBuffer));
+
+    return CyMesh_NetworkProcess(rxBuffer.data, rxBuffer.length, rxBuffer.rssi);
+}
+
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+CYMESH_API_RETURN_T CyMesh_NetworkStart(CYMESH_CALLBACK_T callback)
+{
+    if(callback == NULL)
+    {
+        return CYMESH_ERROR_INVALID_CALLBACK;
+    }
+
+    cyMesh_NetworkCallbackToTransport = callback;
+#if (CYMESH_ENABLE_CONFIGINFO_LOG == 1)
+    /* Before the transport layer reads seq_num */
+    (void)CyMesh_ConfigLogRestore();
+#endif
+    CyMesh_NetworkCacheInit(&net_msg_cache);
+    (void)CyMesh_NetworkReplayLoad(&net_replay_list, &cyMesh_NetworkReplayFlash, CyMesh_NetworkReplayTag());
+    networkReplaySaveCountdown = CYMESH_NET_REPLAY_SAVE_PERIOD;
+    networkMutex.send = 0u;
+    networkMutex.process = 0u;
+#if (CYMESH_ENABLE_TTL_LEARNING == 1)
+    CyMesh_NetworkHopsInit(&net_hops);
+#endif
+#if (CYMESH_ENABLE_MANAGED_FLOODING == 1)
+    /* The nodes that hear a PDU at once must not draw the same back-off */
+    CyMesh_NetworkFloodInit(&net_flood, ((((uint32)CY_GET_REG8(CYREG_SFLASH_DIE_X) << 8) |
+                                          CY_GET_REG8(CYREG_SFLASH_DIE_Y)) << 16) ^ CyMesh_TimerGetTimestamp());
+#endif
+
+    return (CyMesh_BearerStart(CyMesh_NetworkEventHandler) == CYMESH_ERROR_OK) ? CYMESH_ERROR_OK : CYMESH_ERROR_OTHER;
+}
+
+
+CYMESH_API_RETURN_T CyMesh_NetworkSendData(uint8 * msg,
+											uint8 len,
+											uint8 txCount,
+											bool akf,
+											bool fut,
+											uint8 ttl,
+											uint8 meshId,
+											uint8 attachIvinid)
+{
+    uint8 packet[CYMESH_NET_MAX_DATA_LEN + CYMESH_NET_MIC_SIZE];
+    uint8 networkId[16];
+    CYMESH_API_RETURN_T result;
+
+    if(CyMesh_NetworkLock(&networkMutex.send) == false)
+    {
+        return CYMESH_ERROR_THREAD_BUSY;
+    }
+
+    if(((uint8)(len - CYMESH_TRANS_MIN_DATA_LEN) > (CYMESH_NET_MAX_DATA_LEN - CYMESH_TRANS_MIN_DATA_LEN)) ||
+       (msg == NULL) || (txCount == 0u) || (meshId == CYMESH_NET_INDEX_ALL))
+    {
+        networkMutex.send = 0u;
+        return CYMESH_ERROR_INVALID_PARAM;
+    }
+
+    memcpy(packet, msg, len);
+
+    if(attachIvinid != 0u)
+    {
+        uint8 ivi = (uint8)(CyMesh_SecurityGetIVindex(meshId) & 0x01u);
+
+        if(CyMesh_SecurityGetNetworkId(meshId, networkId) != CYMESH_ERROR_OK)
+        {
+            networkMutex.send = 0u;
+            return CYMESH_ERROR_INVALID_MESH_ID;
+        }
+        packet[CYMESH_NET_HEADER_IVI_NID] = (uint8)(ivi << 7) | (networkId[15] & 0x7Fu);
+    }
+
+#if (CYMESH_ENABLE_TTL_LEARNING == 1)
+    ttl = CyMesh_NetworkHopsTtl(&net_hops, CYMESH_NET_GET_UINT16(&packet[CYMESH_NET_HEADER_DST]),
+                                ttl & CYMESH_NET_TTL_MASK, CyMesh_TimerGetTimestamp());
+#endif
+    packet[CYMESH_NET_HEADER_CTL_TTL] = (uint8)((uint8)akf << 7) | ((uint8)((uint8)fut << 6) & CYMESH_NET_FUT_MASK) |
+                                        (ttl & CYMESH_NET_TTL_MASK);
+
+    result = CyMesh_NetworkEncryptAndSend(packet, len, txCount, meshId, CYMESH_BEARER_TX_CLASS_NETWORK);
+
+    networkMutex.send = 0u;
+
+    return result;
+}
+
+
+CYMESH_API_RETURN_T CyMesh_NetworkCheckMsgCache(const uint8 * packet, uint8 length)
+{
+    uint16 src;
+    uint32 seq;
+
+    if(length <= CYMESH_TRANS_MIN_DATA_LEN)
+    {
+        return CYMESH_ERROR_INVALID_PARAM;
+    }
+
+    src = CYMESH_NET_GET_UINT16(&packet[CYMESH_NET_HEADER_SRC]);
+    seq = CYMESH_NET_GET_SEQ(&packet[CYMESH_NET_HEADER_SEQ]);
+    if(CyMesh_NetworkCacheFind(&net_msg_cache, src, seq) == true)
+    {
+        return CYMESH_NET_ERROR_MSG_IN_CACHE;
+    }
+
+    CyMesh_NetworkCacheAdd(&net_msg_cache, src, seq);
+
+    return CYMESH_NET_MSG_ADDED_IN_CACHE;
+}
+
+
+/******************************************************************************
+* Function Name: CyMesh_NetworkProcess
+*******************************************************************************
+*
+*  CyMesh_ProcessNetworkPacket() with the RSSI of the packet, for the relay
+*  policy.
+*
+******************************************************************************/
+static CYMESH_API_RETURN_T CyMesh_NetworkProcess(uint8 * pkt, uint8 len, int8 rssi)
+{
+    uint8 packet[CYMESH_NET_MAX_DATA_LEN + CYMESH_NET_MIC_SIZE];
+    uint8 upperPacket[CYMESH_NET_MAX_DATA_LEN + CYMESH_NET_MIC_SIZE];
+    uint8 meshIds[CYMESH_MAX_NETWORK_KEYS];
+    CYMESH_NETWORK_PKT_T networkPacket;
+    uint8 numberOfMeshIds;
+    uint8 meshId = 0u;
+    uint8 candidate;
+    uint16 src = CYMESH_NET_ADDR_UNASSIGNED;
+    uint32 seq = 0u;
+    uint16 dst;
+    bool isForUpperLayer = false;
+    bool isToBeRelayed = false;
+    CYMESH_API_RETURN_T result = CYMESH_ERROR_OK;
+    uint8 i;
+    uint8 j;
+    uint8 k;
+#if (CYMESH_ENABLE_MANAGED_FLOODING == 1)
+    uint8 interruptState;
+#endif
+#if (CYMESH_ENABLE_TTL_LEARNING == 1)
+    uint8 ttl;
+#endif
+
+    if(cyMesh_ConfigInfoRam.bearerRole == CYMESH_ROLE_UNPROVISIONED)
+    {
+        return CYMESH_ERROR_OK;
+    }
+
+    if(CyMesh_NetworkLock(&networkMutex.process) == false)
+    {
+        return CYMESH_ERROR_THREAD_BUSY;
+    }
+
+    if((uint8)(len - (CYMESH_TRANS_MIN_DATA_LEN + 1u)) > (CYMESH_NET_MAX_DATA_LEN - (CYMESH_TRANS_MIN_DATA_LEN + 1u)))
+    {
+        networkMutex.process = 0u;
+        return CYMESH_ERROR_OK;
+    }
+
+    numberOfMeshIds = CyMesh_SecurityFindMeshId(pkt, CYMESH_NET_NID_BITS, meshIds);
+
+    for(candidate = 0; candidate < numberOfMeshIds; candidate++)
+    {
+        memcpy(packet, pkt, len);
+        if(CyMesh_SecurityClarifyNetHeader(meshIds[candidate], &packet[CYMESH_NET_OBFUSCATED_OFFSET]) != CYMESH_ERROR_OK)
+        {
+            continue;
+        }
+
+        /* SRC must be unicast; own packets come back from relays */
+        src = CYMESH_NET_GET_UINT16(&packet[CYMESH_NET_HEADER_SRC]);
+        if((src == CYMESH_NET_ADDR_UNASSIGNED) || ((src & CYMESH_NET_ADDR_UNICAST_MASK) != 0u))
+        {
+            networkMutex.process = 0u;
+            return CYMESH_ERROR_OK;
+        }
+        for(i = 0; i < CYMESH_NUMBER_OF_COMPONENTS; i++)
+        {
+            if(cyMesh_ConfigInfoRam.deviceInfo.components[i].componentAddress == src)
+            {
+                networkMutex.process = 0u;
+                return CYMESH_ERROR_OK;
+            }
+        }
+
+        /* Duplicates cost one AES block, the clarification. The message is added
+         * once the MIC is checked. */
+        seq = CYMESH_NET_GET_SEQ(&packet[CYMESH_NET_HEADER_SEQ]);
+        if(CyMesh_NetworkCacheFind(&net_msg_cache, src, seq) == true)
+        {
+        #if (CYMESH_ENABLE_MANAGED_FLOODING == 1)
+            /* Counted before the MIC check, like the lookup: a forged copy
+             * can only cancel a relay, which jamming does as well */
+            interruptState = CyEnterCriticalSection();
+            CyMesh_NetworkFloodHeard(&net_flood, src, seq);
+            CyExitCriticalSection(interruptState);
+        #endif
+            networkMutex.process = 0u;
+            return CYMESH_ERROR_OK;
+        }
+
+        if(CyMesh_SecurityDecryptNetworkData(meshIds[candidate], &packet[CYMESH_NET_OBFUSCATED_OFFSET],
+                                             len - CYMESH_NET_ENCRYPTED_OFFSET) == CYMESH_ERROR_OK)
+        {
+            meshId = meshIds[candidate];
+            break;
+        }
+    }
+
+    if(candidate == numberOfMeshIds)
+    {
+        networkMutex.process = 0u;
+        return CYMESH_ERROR_OK;
+    }
+
+    CyMesh_NetworkCacheAdd(&net_msg_cache, src, seq);
+
+#if (CYMESH_ENABLE_TTL_LEARNING == 1)
+    ttl = packet[CYMESH_NET_HEADER_CTL_TTL] & CYMESH_NET_TTL_MASK;
+    CyMesh_NetworkHopsLearn(&net_hops, src, ttl, CyMesh_NetworkInitialTtl(ttl), CyMesh_TimerGetTimestamp());
+#endif
+
+    dst = CYMESH_NET_GET_UINT16(&packet[CYMESH_NET_HEADER_DST]);
+    networkPacket.mesh_id = meshId;
+    networkPacket.componentIndex = CYMESH_NET_INDEX_ALL;
+    networkPacket.modelIndex = CYMESH_NET_INDEX_ALL;
+
+    if(dst == CYMESH_NET_ADDR_UNASSIGNED)
+    {
+        /* Neither delivered nor relayed */
+    }
+    else if((dst & CYMESH_NET_ADDR_UNICAST_MASK) == 0u)
+    {
+        isToBeRelayed = true;
+        for(i = 0; i < CYMESH_NUMBER_OF_COMPONENTS; i++)
+        {
+            if(cyMesh_ConfigInfoRam.deviceInfo.components[i].componentAddress == dst)
+            {
+                networkPacket.componentIndex = i;
+                isForUpperLayer = true;
+                isToBeRelayed = false;
+                break;
+            }
+        }
+    }
+    else if(dst == CYMESH_NET_ADDR_BROADCAST)
+    {
+        isForUpperLayer = true;
+        isToBeRelayed = true;
+    }
+    else if((dst & CYMESH_NET_ADDR_GROUP_MASK) == CYMESH_NET_ADDR_GROUP_MASK)
+    {
+        isToBeRelayed = true;
+        for(i = 0; i < CYMESH_NUMBER_OF_COMPONENTS; i++)
+        {
+            for(j = 0; j < CYMESH_MAX_MODELS_PER_COMPONENT; j++)
+            {
+                const CYMESH_MODEL_T * model = &cyMesh_ConfigInfoRam.deviceInfo.components[i].model[j];
+
+                for(k = 0; k < model->numberOfSubscribedAddresses; k++)
+                {
+                    if(model->subscriptionAddress[k] == dst)
+                    {
+                        networkPacket.componentIndex = i;
+                        networkPacket.modelIndex = j;
+                        isForUpperLayer = true;
+                    #if defined(CYMESH_DEBUG_ENABLED_N)
+                        printf("\t  SRC ADDR Match %4.4x   %d  %d", dst, i, j);
+                    #endif
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    else
+    {
+        /* Virtual address */
+        isToBeRelayed = true;
+    }
+
+    /* Relaying is left to the message cache: a relay ahead may have reordered
+     * the PDUs of the source, and the nodes behind it check them again */
+    if((isForUpperLayer == true) && (CyMesh_NetworkReplayAccept(&net_replay_list, src, seq) == false))
+    {
+        isForUpperLayer = false;
+        result = CYMESH_NET_ERROR_MSG_REPLAY_PROT;
+    }
+
+    if(isForUpperLayer == true)
+    {
+        memcpy(upperPacket, packet, len);
+        upperPacket[CYMESH_NET_HEADER_CTL_TTL] &= CYMESH_NET_AKF_MASK;
+        networkPacket.data = upperPacket;
+        networkPacket.length = len - CYMESH_NET_MIC_SIZE;
+        (void)cyMesh_NetworkCallbackToTransport(CYMESH_TRANSPORT_PKT, &networkPacket);
+    }
+
+    if((isToBeRelayed == true) && (cyMesh_ConfigInfoRam.bearerRole == CYMESH_ROLE_RELAY))
+    {
+        CyMesh_NetworkRelay(packet, len, meshId, rssi);
+    }
+
+    networkMutex.process = 0u;
+
+    return result;
+}
+
+
+CYMESH_API_RETURN_T CyMesh_ProcessNetworkPacket(uint8 * pkt, uint8 len)
+{
+    return CyMesh_NetworkProcess(pkt, len, CYMESH_NET_FLOOD_RSSI_UNKNOWN);
+}
+
+
+void CyMesh_NetworkReplayUpdate(void)
+{
+    if(networkReplaySaveCountdown != 0u)
+    {
+        networkReplaySaveCountdown--;
+        return;
+    }
+
+    /* The SM timer interrupts the main loop; try again on the next tick if a
+     * packet is being processed */
+    if((net_replay_list.isDirty == false) || (cyMesh_ConfigInfoRam.bearerRole == CYMESH_ROLE_UNPROVISIONED) ||
+       (CyMesh_NetworkLock(&networkMutex.process) == false))
+    {
+        return;
+    }
+
+    CyMesh_NetworkReplaySeal(&net_replay_list, CyMesh_NetworkReplayTag());
+    if(CyBLE_Nvram_Write((const uint8 *)&net_replay_list.list, (const uint8 *)&cyMesh_NetworkReplayFlash,
+                         sizeof(cyMesh_NetworkReplayFlash)) != CYRET_SUCCESS)
+    {
+        net_replay_list.isDirty = true;
+    }
+    networkReplaySaveCountdown = CYMESH_NET_REPLAY_SAVE_PERIOD;
+
+    networkMutex.process = 0u;
+}
+
+
+#if (CYMESH_ENABLE_MANAGED_FLOODING == 1)
+void CyMesh_NetworkFloodUpdate(void)
+{
+    uint8 packet[CYMESH_NET_FLOOD_PDU_SIZE];
+    uint32 now = CyMesh_TimerGetTimestamp();
+    uint8 length = CyMesh_NetworkFloodTake(&net_flood, now, packet);
+
+    while(length != 0u)
+    {
+        CyMesh_NetworkSend(packet, length - CYMESH_NET_MIC_SIZE, 1u, CYMESH_BEARER_TX_CLASS_RELAY);
+        length = CyMesh_NetworkFloodTake(&net_flood, now, packet);
+    }
+}
+#endif
+
+/* [] END OF FILE */
@@ -17,13 +17,14 @@
 *******************************************************************************/
 #include <project.h>
 #include "CyMesh_Common.h"
+#include "CyMesh_NetworkCache.h"
+#include "CyMesh_NetworkReplay.h"
+#include "CyMesh_NetworkFlood.h"
+#include "CyMesh_NetworkHops.h"
 
 /******************************************************************/
 
 /***********************Macros************************************/
-#define CYMESH_NET_MSG_CACHE_SIZE					(0x0A)	/* Supporting caching of 10 messages */
-#define CYMESH_NET_MSG_CACHE_CONTENT_SIZE			(0x05)
-	
 #define CYMESH_TRANS_MIN_DATA_LEN					(0x0D)	/*PFT+SEQ+SRC+DST+1 OPCODE+4 MICapp */
 #define CYMESH_TRANS_MAX_DATA_LEN					(0x1D)//(0x18)	/* Max 31 bytes ADV - 2 bytes (Len+Mesh tag) - MICnet - IVNID */
 
@@ -31,20 +32,17 @@
 #define CYMESH_NET_FRIEND_CACHE_SIZE				0x05
 	
 #define CYMESH_NET_MAX_DATA_LEN						(0x1D)	/* Max 31 bytes ADV - 2 bytes (Len+Mesh tag) */
+
+/* SM timer ticks (1 ms) between flash writes of a changed replay protection
+ * list. Messages accepted after the last write can be replayed once after a
+ * reset. */
+#define CYMESH_NET_REPLAY_SAVE_PERIOD				(600000u)
    
 /*VAVC*/
 //#define CYMESH_DEBUG_ENABLED_N    
 /*******************************************************************************
 * Structures and Enums
 *******************************************************************************/	
-typedef struct
-{
-	uint8 msg[CYMESH_NET_MSG_CACHE_SIZE][CYMESH_NET_MSG_CACHE_CONTENT_SIZE];
-	uint8 access_count[CYMESH_NET_MSG_CACHE_SIZE];
-	uint8 cache_filled;
-
-} CYMESH_NET_MSG_CACHE_STRUCT;
-
 typedef struct
 {
     uint8 * data; 
@@ -95,13 +93,15 @@ CYMESH_API_RETURN_T CyMesh_NetworkStart(CYMESH_CALLBACK_T);
 * 
 *  This function processes packet sent to the network layer from bottom layer.
 * This function performs network layer clarification, decryption, address 
-* resolution, message caching and relaying.
+* resolution, message caching, replay protection and relaying.
 * 
 *  \param uint8*: pointer to the mesh packet that will be processed
 *
 *  \param uint8: length of the mesh packet
 *
-*  \return CYMESH_API_RETURN_T: CYMESH_ERROR_OK if network layer started correctly
+*  \return CYMESH_API_RETURN_T: CYMESH_NET_ERROR_MSG_REPLAY_PROT if the packet
+*								for this node was a replay; it is still relayed,
+*								CYMESH_ERROR_OK if network layer started correctly
 *								other values in case of failures
 * 
 ******************************************************************************/
@@ -146,6 +146,53 @@ CYMESH_API_RETURN_T CyMesh_NetworkSendData(uint8 *,
 											uint8,
 											uint8);
 
+/******************************************************************************
+* Function Name: CyMesh_NetworkCheckMsgCache
+*******************************************************************************
+*
+*  This function checks the SEQ and SRC of a clarified packet against the
+* network message cache and adds them when the message is new.
+*
+*  \param const uint8*: pointer to the clarified mesh packet
+*
+*  \param uint8: length of the mesh packet
+*
+*  \return CYMESH_API_RETURN_T: CYMESH_NET_MSG_ADDED_IN_CACHE for a new message,
+*								CYMESH_NET_ERROR_MSG_IN_CACHE otherwise
+*
+******************************************************************************/
+CYMESH_API_RETURN_T CyMesh_NetworkCheckMsgCache(const uint8 *, uint8 );
+
+/******************************************************************************
+* Function Name: CyMesh_NetworkReplayUpdate
+*******************************************************************************
+*
+*  This function is called on every SM timer tick. Every
+* CYMESH_NET_REPLAY_SAVE_PERIOD ticks, it writes the replay protection list to
+* flash if it changed.
+*
+*  \param none:
+*
+*  
+eturn none:
+*
+******************************************************************************/
+void CyMesh_NetworkReplayUpdate(void);
+
+/******************************************************************************
+* Function Name: CyMesh_NetworkFloodUpdate
+*******************************************************************************
+*
+*  This function is called on every SM timer tick. It hands the relays whose
+* back-off has run out to the bearer.
+*
+*  \param none:
+*
+*  \return none:
+*
+******************************************************************************/
+void CyMesh_NetworkFloodUpdate(void);
+
 #if (CYMESH_ENABLE_FRIENDSHIP == 1)
 uint8 CyMesh_NetworkIsFriendshipCacheAvailable(void);
 CYMESH_API_RETURN_T CyMesh_NetworkAddFriend(uint16 );
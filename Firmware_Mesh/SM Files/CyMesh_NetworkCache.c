@@ -0,0 +1,148 @@
+/***************************************************************************//**
+* \file CyMesh_NetworkCache.c
+* \version 1.0
+*
+* \brief
+*  This file contains the network message cache of the BLE SmartMesh v1
+*  network layer.
+*
+*  Messages are kept in an open-addressed table hashed on SRC and SEQ. A
+*  lookup reads CYMESH_NET_MSG_CACHE_PROBES slots from the hashed position,
+*  whatever the number of cached messages. Every entry carries the generation
+*  it was last seen in; the generation advances after a fixed number of
+*  insertions, so expiry needs no timer and no scan. One slot is swept per
+*  insertion to free expired entries before the 8-bit generation wraps.
+*
+*  Tools/network_bench/flood_sim.c simulates relay amplification against the
+*  cache size.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <string.h>
+#include "CyMesh_NetworkCache.h"
+
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+#define CYMESH_NET_MSG_CACHE_MASK               (CYMESH_NET_MSG_CACHE_SIZE - 1u)
+#define CYMESH_NET_MSG_CACHE_SEQ_MASK           (0x00FFFFFFu)
+#define CYMESH_NET_MSG_CACHE_GENERATION_SHIFT   (24u)
+#define CYMESH_NET_MSG_CACHE_GENERATION_LENGTH  (CYMESH_NET_MSG_CACHE_SIZE / CYMESH_NET_MSG_CACHE_GENERATIONS)
+#define CYMESH_NET_MSG_CACHE_FREE               (0x0000u)
+
+
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+
+/* First slot of the probe window of a message */
+static uint16 CyMesh_NetworkCacheHash(uint16 src, uint32 seq)
+{
+    uint32 hash = ((uint32)src * 0x9E3779B1u) ^ (seq * 0x85EBCA6Bu);
+
+    hash ^= hash >> 15;
+
+    return (uint16)(hash & CYMESH_NET_MSG_CACHE_MASK);
+}
+
+
+/* Generations since the entry in the slot was last seen */
+static uint8 CyMesh_NetworkCacheAge(const CYMESH_NET_MSG_CACHE_STRUCT * cache, uint16 slot)
+{
+    return (uint8)(cache->generation - (uint8)(cache->seq[slot] >> CYMESH_NET_MSG_CACHE_GENERATION_SHIFT));
+}
+
+
+static bool CyMesh_NetworkCacheIsLive(const CYMESH_NET_MSG_CACHE_STRUCT * cache, uint16 slot)
+{
+    return (cache->src[slot] != CYMESH_NET_MSG_CACHE_FREE) &&
+           (CyMesh_NetworkCacheAge(cache, slot) < CYMESH_NET_MSG_CACHE_GENERATIONS);
+}
+
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+void CyMesh_NetworkCacheInit(CYMESH_NET_MSG_CACHE_STRUCT * cache)
+{
+    memset(cache, 0, sizeof(*cache));
+}
+
+
+bool CyMesh_NetworkCacheFind(CYMESH_NET_MSG_CACHE_STRUCT * cache, uint16 src, uint32 seq)
+{
+    uint16 slot = CyMesh_NetworkCacheHash(src, seq);
+    uint8 i;
+
+    seq &= CYMESH_NET_MSG_CACHE_SEQ_MASK;
+
+    for(i = 0; i < CYMESH_NET_MSG_CACHE_PROBES; i++)
+    {
+        if((cache->src[slot] == src) && ((cache->seq[slot] & CYMESH_NET_MSG_CACHE_SEQ_MASK) == seq) &&
+           (CyMesh_NetworkCacheIsLive(cache, slot) == true))
+        {
+            cache->seq[slot] = seq | ((uint32)cache->generation << CYMESH_NET_MSG_CACHE_GENERATION_SHIFT);
+            return true;
+        }
+        slot = (slot + 1u) & CYMESH_NET_MSG_CACHE_MASK;
+    }
+
+    return false;
+}
+
+
+void CyMesh_NetworkCacheAdd(CYMESH_NET_MSG_CACHE_STRUCT * cache, uint16 src, uint32 seq)
+{
+    uint16 slot = CyMesh_NetworkCacheHash(src, seq);
+    uint16 oldest = slot;
+    uint8 i;
+
+    for(i = 0; i < CYMESH_NET_MSG_CACHE_PROBES; i++)
+    {
+        if(CyMesh_NetworkCacheIsLive(cache, slot) == false)
+        {
+            oldest = slot;
+            break;
+        }
+
+        if(CyMesh_NetworkCacheAge(cache, slot) > CyMesh_NetworkCacheAge(cache, oldest))
+        {
+            oldest = slot;
+        }
+        slot = (slot + 1u) & CYMESH_NET_MSG_CACHE_MASK;
+    }
+
+    cache->src[oldest] = src;
+    cache->seq[oldest] = (seq & CYMESH_NET_MSG_CACHE_SEQ_MASK) |
+                         ((uint32)cache->generation << CYMESH_NET_MSG_CACHE_GENERATION_SHIFT);
+
+    cache->insertions++;
+    if(cache->insertions >= CYMESH_NET_MSG_CACHE_GENERATION_LENGTH)
+    {
+        cache->insertions = 0u;
+        cache->generation++;
+    }
+
+    if(CyMesh_NetworkCacheIsLive(cache, cache->sweep) == false)
+    {
+        cache->src[cache->sweep] = CYMESH_NET_MSG_CACHE_FREE;
+    }
+    cache->sweep = (cache->sweep + 1u) & CYMESH_NET_MSG_CACHE_MASK;
+}
+
+/* [] END OF FILE */
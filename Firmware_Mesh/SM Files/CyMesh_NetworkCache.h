@@ -0,0 +1,130 @@
+/***************************************************************************//**
+* \file CyMesh_NetworkCache.h
+* \version 1.0
+*
+* \brief
+*  This is the header file of the network message cache, which detects network
+*  PDUs that were received or relayed before.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined (CYMESH_NETWORK_CACHE_H)
+#define CYMESH_NETWORK_CACHE_H
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <stdbool.h>
+
+
+/*******************************************************************************
+* Compile Time Options
+*******************************************************************************/
+/* Number of cached messages, 6 bytes each. Must be a power of two. */
+#if !defined(CYMESH_NET_MSG_CACHE_SIZE)
+    #define CYMESH_NET_MSG_CACHE_SIZE               (64u)
+#endif
+
+/* Slots searched from the hashed position of a message */
+#if !defined(CYMESH_NET_MSG_CACHE_PROBES)
+    #define CYMESH_NET_MSG_CACHE_PROBES             (8u)
+#endif
+
+/* A message expires once this many generations, of
+ * CYMESH_NET_MSG_CACHE_SIZE / CYMESH_NET_MSG_CACHE_GENERATIONS insertions
+ * each, have started after it was last seen */
+#if !defined(CYMESH_NET_MSG_CACHE_GENERATIONS)
+    #define CYMESH_NET_MSG_CACHE_GENERATIONS        (4u)
+#endif
+
+#if ((CYMESH_NET_MSG_CACHE_SIZE & (CYMESH_NET_MSG_CACHE_SIZE - 1u)) != 0u) || \
+    (CYMESH_NET_MSG_CACHE_SIZE < CYMESH_NET_MSG_CACHE_PROBES) || \
+    (CYMESH_NET_MSG_CACHE_SIZE < CYMESH_NET_MSG_CACHE_GENERATIONS) || \
+    (CYMESH_NET_MSG_CACHE_GENERATIONS > 64u)
+    #error "Invalid network message cache configuration"
+#endif
+
+
+/*******************************************************************************
+* Structures and Enums
+*******************************************************************************/
+typedef struct
+{
+    /* SEQ in bits 0-23 and the generation it was last seen in in bits 24-31 */
+    uint32 seq[CYMESH_NET_MSG_CACHE_SIZE];
+
+    /* SRC of the message; 0 (unassigned address) marks a free slot */
+    uint16 src[CYMESH_NET_MSG_CACHE_SIZE];
+
+    /* Next slot checked for expiry */
+    uint16 sweep;
+
+    /* Insertions in the current generation */
+    uint16 insertions;
+
+    uint8 generation;
+} CYMESH_NET_MSG_CACHE_STRUCT;
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+/******************************************************************************
+* Function Name: CyMesh_NetworkCacheInit
+*******************************************************************************
+*
+*  This function empties the cache.
+*
+*  \param CYMESH_NET_MSG_CACHE_STRUCT*: cache
+*
+*  \return None
+*
+******************************************************************************/
+void CyMesh_NetworkCacheInit(CYMESH_NET_MSG_CACHE_STRUCT * cache);
+
+/******************************************************************************
+* Function Name: CyMesh_NetworkCacheFind
+*******************************************************************************
+*
+*  This function looks a message up. A message that is found is marked as seen
+* in the current generation.
+*
+*  \param CYMESH_NET_MSG_CACHE_STRUCT*: cache
+*
+*  \param uint16: SRC of the message, a unicast address
+*
+*  \param uint32: SEQ of the message, 24 bits
+*
+*  \return bool: true if the message is in the cache
+*
+******************************************************************************/
+bool CyMesh_NetworkCacheFind(CYMESH_NET_MSG_CACHE_STRUCT * cache, uint16 src, uint32 seq);
+
+/******************************************************************************
+* Function Name: CyMesh_NetworkCacheAdd
+*******************************************************************************
+*
+*  This function adds a message that CyMesh_NetworkCacheFind() did not find.
+* It takes a free or expired slot near the hashed position of the message, or
+* the slot there that was seen least recently.
+*
+*  \param CYMESH_NET_MSG_CACHE_STRUCT*: cache
+*
+*  \param uint16: SRC of the message, a unicast address
+*
+*  \param uint32: SEQ of the message, 24 bits
+*
+*  \return None
+*
+******************************************************************************/
+void CyMesh_NetworkCacheAdd(CYMESH_NET_MSG_CACHE_STRUCT * cache, uint16 src, uint32 seq);
+
+#endif
+/* [] END OF FILE */
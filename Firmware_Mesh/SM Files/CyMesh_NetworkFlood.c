@@ -0,0 +1,199 @@
+/***************************************************************************//**
+* \file CyMesh_NetworkFlood.c
+* \version 1.0
+*
+* \brief
+*  This file contains the relay policy of the BLE SmartMesh v1 network layer.
+*
+*  Every relay of a flooded PDU reaches mostly nodes that already heard it, so
+*  in a dense network most relays add collisions and no coverage. A relay is
+*  held in a small table for a random back-off. Each copy of the PDU heard in
+*  the meantime, which the message cache already drops, is counted here; at
+*  CYMESH_NET_FLOOD_SUPPRESS_COUNT copies the neighbourhood is taken as covered
+*  and the relay is cancelled. The back-off grows with the RSSI of the PDU, so
+*  a node at the edge of the range of the sender, which reaches the most new
+*  nodes, tends to relay first and the nodes close to the sender stay quiet.
+*
+*  Tools/network_bench/relay_sim.c simulates the delivered ratio and the
+*  transmissions of a flood against these options.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <stddef.h>
+#include <string.h>
+#include "CyMesh_NetworkFlood.h"
+
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+#define CYMESH_NET_FLOOD_FREE                   (0x0000u)
+#define CYMESH_NET_FLOOD_RANDOM_SEED            (0x464C4F44u)
+
+
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+
+/* Xorshift */
+static uint32 CyMesh_NetworkFloodRandom(CYMESH_NET_FLOOD_STRUCT * flood)
+{
+    uint32 x = flood->random;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    flood->random = x;
+
+    return x;
+}
+
+
+/* Back-off of a relay received at rssi, in ms */
+static uint32 CyMesh_NetworkFloodBackoff(CYMESH_NET_FLOOD_STRUCT * flood, int8 rssi)
+{
+    uint32 backoff = CyMesh_NetworkFloodRandom(flood) % (CYMESH_NET_FLOOD_BACKOFF_MS + 1u);
+    int32 level;
+
+    if(rssi == CYMESH_NET_FLOOD_RSSI_UNKNOWN)
+    {
+        level = (CYMESH_NET_FLOOD_RSSI_NEAR + CYMESH_NET_FLOOD_RSSI_FAR) / 2;
+    }
+    else if(rssi > CYMESH_NET_FLOOD_RSSI_NEAR)
+    {
+        level = CYMESH_NET_FLOOD_RSSI_NEAR;
+    }
+    else if(rssi < CYMESH_NET_FLOOD_RSSI_FAR)
+    {
+        level = CYMESH_NET_FLOOD_RSSI_FAR;
+    }
+    else
+    {
+        level = rssi;
+    }
+
+    return backoff + (uint32)(((level - CYMESH_NET_FLOOD_RSSI_FAR) * (int32)CYMESH_NET_FLOOD_RSSI_MS) /
+                              (CYMESH_NET_FLOOD_RSSI_NEAR - CYMESH_NET_FLOOD_RSSI_FAR));
+}
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+void CyMesh_NetworkFloodInit(CYMESH_NET_FLOOD_STRUCT * flood, uint32 seed)
+{
+    memset(flood, 0, sizeof(*flood));
+
+    /* Xorshift is stuck at 0 */
+    flood->random = (seed != 0u) ? seed : CYMESH_NET_FLOOD_RANDOM_SEED;
+}
+
+
+bool CyMesh_NetworkFloodAdd(CYMESH_NET_FLOOD_STRUCT * flood, uint16 src, uint32 seq, const uint8 * pdu,
+                            uint8 length, int8 rssi, uint32 now)
+{
+    CYMESH_NET_FLOOD_ENTRY_T * entry = NULL;
+    uint8 i;
+
+    if((src == CYMESH_NET_FLOOD_FREE) || (length > CYMESH_NET_FLOOD_PDU_SIZE))
+    {
+        return false;
+    }
+
+    for(i = 0u; (entry == NULL) && (i < CYMESH_NET_FLOOD_SIZE); i++)
+    {
+        if(flood->entry[i].src == CYMESH_NET_FLOOD_FREE)
+        {
+            entry = &flood->entry[i];
+        }
+    }
+
+    if(entry == NULL)
+    {
+        flood->stats.overflow++;
+        return false;
+    }
+
+    memcpy(entry->data, pdu, length);
+    entry->length = length;
+    entry->heard = 0u;
+    entry->src = src;
+    entry->seq = seq;
+    entry->due = now + CyMesh_NetworkFloodBackoff(flood, rssi);
+    flood->stats.added++;
+
+    return true;
+}
+
+
+void CyMesh_NetworkFloodHeard(CYMESH_NET_FLOOD_STRUCT * flood, uint16 src, uint32 seq)
+{
+#if (CYMESH_NET_FLOOD_SUPPRESS_COUNT == 0u)
+    (void)flood;
+    (void)src;
+    (void)seq;
+#else
+    uint8 i;
+
+    for(i = 0u; (src != CYMESH_NET_FLOOD_FREE) && (i < CYMESH_NET_FLOOD_SIZE); i++)
+    {
+        CYMESH_NET_FLOOD_ENTRY_T * entry = &flood->entry[i];
+
+        if((entry->src == src) && (entry->seq == seq))
+        {
+            entry->heard++;
+            if(entry->heard >= CYMESH_NET_FLOOD_SUPPRESS_COUNT)
+            {
+                entry->src = CYMESH_NET_FLOOD_FREE;
+                flood->stats.suppressed++;
+            }
+            return;
+        }
+    }
+#endif
+}
+
+
+uint8 CyMesh_NetworkFloodTake(CYMESH_NET_FLOOD_STRUCT * flood, uint32 now, uint8 * pdu)
+{
+    CYMESH_NET_FLOOD_ENTRY_T * next = NULL;
+    uint8 i;
+
+    /* The relay that has waited longest past its back-off goes first */
+    for(i = 0u; i < CYMESH_NET_FLOOD_SIZE; i++)
+    {
+        CYMESH_NET_FLOOD_ENTRY_T * entry = &flood->entry[i];
+
+        if((entry->src != CYMESH_NET_FLOOD_FREE) && ((int32)(now - entry->due) >= 0) &&
+           ((next == NULL) || ((int32)(entry->due - next->due) < 0)))
+        {
+            next = entry;
+        }
+    }
+
+    if(next == NULL)
+    {
+        return 0u;
+    }
+
+    memcpy(pdu, next->data, next->length);
+    next->src = CYMESH_NET_FLOOD_FREE;
+    flood->stats.relayed++;
+
+    return next->length;
+}
+
+/* [] END OF FILE */
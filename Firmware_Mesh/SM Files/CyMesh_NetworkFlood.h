@@ -0,0 +1,206 @@
+/***************************************************************************//**
+* \file CyMesh_NetworkFlood.h
+* \version 1.0
+*
+* \brief
+*  This is the header file of the relay policy of the network layer, which
+*  holds relayed PDUs for a random back-off and cancels those heard often
+*  enough from other relays in the meantime.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined (CYMESH_NETWORK_FLOOD_H)
+#define CYMESH_NETWORK_FLOOD_H
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <stdbool.h>
+
+
+/*******************************************************************************
+* Compile Time Options
+*******************************************************************************/
+/* Relays waiting for their back-off, 44 bytes of RAM each. A relay that finds
+ * the table full is sent at once. */
+#if !defined(CYMESH_NET_FLOOD_SIZE)
+    #define CYMESH_NET_FLOOD_SIZE                   (8u)
+#endif
+
+/* The back-off is drawn from 0 to this many ms */
+#if !defined(CYMESH_NET_FLOOD_BACKOFF_MS)
+    #define CYMESH_NET_FLOOD_BACKOFF_MS             (20u)
+#endif
+
+/* A relay is cancelled once the PDU has been heard this many times during its
+ * back-off. 0 never cancels. */
+#if !defined(CYMESH_NET_FLOOD_SUPPRESS_COUNT)
+    #define CYMESH_NET_FLOOD_SUPPRESS_COUNT         (3u)
+#endif
+
+/* Back-off added for a strong signal, in ms. It grows from 0 at
+ * CYMESH_NET_FLOOD_RSSI_FAR to this value at CYMESH_NET_FLOOD_RSSI_NEAR, so
+ * the nodes far from the sender, which reach the most new nodes, relay first
+ * and suppress the near ones. 0 ignores the RSSI. */
+#if !defined(CYMESH_NET_FLOOD_RSSI_MS)
+    #define CYMESH_NET_FLOOD_RSSI_MS                (20u)
+#endif
+
+/* RSSI range mapped on the back-off, in dBm */
+#if !defined(CYMESH_NET_FLOOD_RSSI_NEAR)
+    #define CYMESH_NET_FLOOD_RSSI_NEAR              (-60)
+#endif
+#if !defined(CYMESH_NET_FLOOD_RSSI_FAR)
+    #define CYMESH_NET_FLOOD_RSSI_FAR               (-90)
+#endif
+
+#if (CYMESH_NET_FLOOD_SIZE < 1u) || (CYMESH_NET_FLOOD_SIZE > 64u) || \
+    (CYMESH_NET_FLOOD_RSSI_NEAR <= CYMESH_NET_FLOOD_RSSI_FAR)
+    #error "Invalid relay policy configuration"
+#endif
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+/* Longest network PDU: an ADV of 31 bytes less the AD length and type */
+#define CYMESH_NET_FLOOD_PDU_SIZE                   (29u)
+
+/* RSSI of a PDU that did not come over the air, the middle of the range is
+ * used */
+#define CYMESH_NET_FLOOD_RSSI_UNKNOWN               (127)
+
+/* Longest back-off, in ms */
+#define CYMESH_NET_FLOOD_MAX_DELAY_MS               (CYMESH_NET_FLOOD_BACKOFF_MS + CYMESH_NET_FLOOD_RSSI_MS)
+
+
+/*******************************************************************************
+* Structures and Enums
+*******************************************************************************/
+typedef struct
+{
+    /* Encrypted PDU, ready for the bearer */
+    uint8 data[CYMESH_NET_FLOOD_PDU_SIZE];
+    uint8 length;
+
+    /* Copies heard since the relay was added */
+    uint8 heard;
+
+    /* SRC of the PDU, 0 for a free entry */
+    uint16 src;
+    uint32 seq;
+
+    /* Timestamp the relay is sent at, in ms */
+    uint32 due;
+} CYMESH_NET_FLOOD_ENTRY_T;
+
+typedef struct
+{
+    /* Relays added, sent, cancelled by copies heard, and sent without a
+     * back-off because the table was full */
+    uint32 added;
+    uint32 relayed;
+    uint32 suppressed;
+    uint32 overflow;
+} CYMESH_NET_FLOOD_STATS_T;
+
+typedef struct
+{
+    CYMESH_NET_FLOOD_ENTRY_T entry[CYMESH_NET_FLOOD_SIZE];
+
+    /* Xorshift state of the back-off */
+    uint32 random;
+
+    CYMESH_NET_FLOOD_STATS_T stats;
+} CYMESH_NET_FLOOD_STRUCT;
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+/******************************************************************************
+* Function Name: CyMesh_NetworkFloodInit
+*******************************************************************************
+*
+*  This function empties the table and seeds the back-off.
+*
+*  \param CYMESH_NET_FLOOD_STRUCT*: table
+*
+*  \param uint32: seed, which should differ between nodes
+*
+*  \return None
+*
+******************************************************************************/
+void CyMesh_NetworkFloodInit(CYMESH_NET_FLOOD_STRUCT * flood, uint32 seed);
+
+/******************************************************************************
+* Function Name: CyMesh_NetworkFloodAdd
+*******************************************************************************
+*
+*  This function copies a relay into the table, due after a random back-off
+* that grows with the RSSI the PDU was received at.
+*
+*  \param CYMESH_NET_FLOOD_STRUCT*: table
+*
+*  \param uint16: SRC of the PDU, a unicast address
+*
+*  \param uint32: SEQ of the PDU
+*
+*  \param const uint8*: encrypted PDU
+*
+*  \param uint8: length of the PDU, at most CYMESH_NET_FLOOD_PDU_SIZE
+*
+*  \param int8: RSSI of the PDU in dBm, or CYMESH_NET_FLOOD_RSSI_UNKNOWN
+*
+*  \param uint32: timestamp, in ms
+*
+*  \return bool: false if the table is full, the caller sends the PDU
+*
+******************************************************************************/
+bool CyMesh_NetworkFloodAdd(CYMESH_NET_FLOOD_STRUCT * flood, uint16 src, uint32 seq, const uint8 * pdu,
+                            uint8 length, int8 rssi, uint32 now);
+
+/******************************************************************************
+* Function Name: CyMesh_NetworkFloodHeard
+*******************************************************************************
+*
+*  This function counts a copy of a PDU received again. A waiting relay of the
+* PDU is cancelled on the CYMESH_NET_FLOOD_SUPPRESS_COUNT th copy.
+*
+*  \param CYMESH_NET_FLOOD_STRUCT*: table
+*
+*  \param uint16: SRC of the PDU
+*
+*  \param uint32: SEQ of the PDU
+*
+*  \return None
+*
+******************************************************************************/
+void CyMesh_NetworkFloodHeard(CYMESH_NET_FLOOD_STRUCT * flood, uint16 src, uint32 seq);
+
+/******************************************************************************
+* Function Name: CyMesh_NetworkFloodTake
+*******************************************************************************
+*
+*  This function removes a relay whose back-off has run out from the table.
+*
+*  \param CYMESH_NET_FLOOD_STRUCT*: table
+*
+*  \param uint32: timestamp, in ms
+*
+*  \param uint8*: buffer of CYMESH_NET_FLOOD_PDU_SIZE bytes for the PDU
+*
+*  \return uint8: length of the PDU, 0 if no relay is due
+*
+******************************************************************************/
+uint8 CyMesh_NetworkFloodTake(CYMESH_NET_FLOOD_STRUCT * flood, uint32 now, uint8 * pdu);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,167 @@
+/***************************************************************************//**
+* \file CyMesh_NetworkHops.c
+* \version 1.0
+*
+* \brief
+*  This file contains the hop table of the BLE SmartMesh v1 network layer.
+*
+*  A message flooded with the default TTL is relayed up to TTL hops away from
+*  its source, whatever the distance to its destination, so the nodes at the
+*  far edges of the mesh relay traffic that was delivered long before. Every
+*  authenticated packet tells the distance to its source: the TTL it was sent
+*  with, less the TTL it arrived with, plus one. The network layer passes the
+*  highest default TTL of the network as the TTL it was sent with (see
+*  CyMesh_Network.c), so that a packet sent with a lower TTL, such as one
+*  shortened here, only looks farther away than it is. A message to a
+*  destination that was sent to before then goes out with the shortest
+*  distance heard plus CYMESH_NET_HOPS_TTL_MARGIN.
+*
+*  Only the destinations of this node are tracked: every node hears packets
+*  from most of the network, which would push them out of a small table. The
+*  table keeps the shortest distance heard within CYMESH_NET_HOPS_LIFETIME_MS,
+*  so that a path that got longer is learned again.
+*
+*  Tools/network_bench/ttl_sim.c simulates the transmissions per delivered
+*  message against these options.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <stddef.h>
+#include <string.h>
+#include "CyMesh_NetworkHops.h"
+
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+#define CYMESH_NET_HOPS_FREE                    (0x0000u)
+#define CYMESH_NET_HOPS_UNKNOWN                 (0u)    /* Distance not heard yet */
+#define CYMESH_NET_HOPS_MIN_TTL                 (2u)    /* Lowest TTL that is relayed */
+
+
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+
+static bool CyMesh_NetworkHopsIsValid(const CYMESH_NET_HOPS_ENTRY_T * entry, uint32 now)
+{
+    return (entry->hops != CYMESH_NET_HOPS_UNKNOWN) && ((uint32)(now - entry->learned) < CYMESH_NET_HOPS_LIFETIME_MS);
+}
+
+
+/* Entry of src, NULL if src is not in the table */
+static CYMESH_NET_HOPS_ENTRY_T * CyMesh_NetworkHopsFind(CYMESH_NET_HOPS_STRUCT * hops, uint16 src)
+{
+    uint8 i;
+
+    for(i = 0u; i < CYMESH_NET_HOPS_SIZE; i++)
+    {
+        if(hops->entry[i].src == src)
+        {
+            return &hops->entry[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+void CyMesh_NetworkHopsInit(CYMESH_NET_HOPS_STRUCT * hops)
+{
+    memset(hops, 0, sizeof(*hops));
+}
+
+
+void CyMesh_NetworkHopsLearn(CYMESH_NET_HOPS_STRUCT * hops, uint16 src, uint8 ttl, uint8 initialTtl, uint32 now)
+{
+    CYMESH_NET_HOPS_ENTRY_T * entry;
+    uint8 distance;
+
+    if(ttl == 0u)
+    {
+        distance = 1u;
+    }
+    else if((ttl >= CYMESH_NET_HOPS_MIN_TTL) && (initialTtl >= ttl))
+    {
+        distance = (initialTtl - ttl) + 1u;
+    }
+    else
+    {
+        return;
+    }
+
+    /* Only the destinations messages were sent to are tracked */
+    entry = CyMesh_NetworkHopsFind(hops, src);
+    if((entry == NULL) || (src == CYMESH_NET_HOPS_FREE))
+    {
+        return;
+    }
+
+    if((CyMesh_NetworkHopsIsValid(entry, now) == true) && (distance > entry->hops))
+    {
+        /* A copy that came the long way */
+        return;
+    }
+
+    entry->hops = distance;
+    entry->learned = now;
+}
+
+
+uint8 CyMesh_NetworkHopsTtl(CYMESH_NET_HOPS_STRUCT * hops, uint16 dst, uint8 ttl, uint32 now)
+{
+    CYMESH_NET_HOPS_ENTRY_T * entry;
+    uint8 i;
+
+    if((ttl < CYMESH_NET_HOPS_MIN_TTL) || (dst == CYMESH_NET_HOPS_FREE))
+    {
+        return ttl;
+    }
+
+    entry = CyMesh_NetworkHopsFind(hops, dst);
+    if(entry == NULL)
+    {
+        /* A free entry, or the one used least recently, waits for the
+         * distance to dst */
+        entry = &hops->entry[0];
+        for(i = 1u; (i < CYMESH_NET_HOPS_SIZE) && (entry->src != CYMESH_NET_HOPS_FREE); i++)
+        {
+            if((hops->entry[i].src == CYMESH_NET_HOPS_FREE) ||
+               ((uint32)(now - hops->entry[i].used) > (uint32)(now - entry->used)))
+            {
+                entry = &hops->entry[i];
+            }
+        }
+        entry->src = dst;
+        entry->hops = CYMESH_NET_HOPS_UNKNOWN;
+    }
+    entry->used = now;
+
+    if((CyMesh_NetworkHopsIsValid(entry, now) == false) || ((entry->hops + CYMESH_NET_HOPS_TTL_MARGIN) >= ttl))
+    {
+        return ttl;
+    }
+
+    hops->shortened++;
+
+    return entry->hops + CYMESH_NET_HOPS_TTL_MARGIN;
+}
+
+/* [] END OF FILE */
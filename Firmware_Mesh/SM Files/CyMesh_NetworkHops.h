@@ -0,0 +1,147 @@
+/***************************************************************************//**
+* \file CyMesh_NetworkHops.h
+* \version 1.0
+*
+* \brief
+*  This is the header file of the hop table, which learns the hop distance to
+*  the sources heard from the TTL of their packets and lowers the TTL of the
+*  messages sent to them.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined (CYMESH_NETWORK_HOPS_H)
+#define CYMESH_NETWORK_HOPS_H
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <stdbool.h>
+
+
+/*******************************************************************************
+* Compile Time Options
+*******************************************************************************/
+/* Number of destinations tracked, 12 bytes of RAM each. A new destination
+ * replaces the one sent to least recently. */
+#if !defined(CYMESH_NET_HOPS_SIZE)
+    #define CYMESH_NET_HOPS_SIZE                    (32u)
+#endif
+
+/* Hops added to the learned distance for the TTL of a message, so that a
+ * path a few hops longer than the one learned still delivers */
+#if !defined(CYMESH_NET_HOPS_TTL_MARGIN)
+    #define CYMESH_NET_HOPS_TTL_MARGIN              (3u)
+#endif
+
+/* Time a distance stays valid, in ms. Within it, only a shorter or equal
+ * distance is taken; after it, the next packet of the source sets the
+ * distance again, and until then messages keep their TTL. */
+#if !defined(CYMESH_NET_HOPS_LIFETIME_MS)
+    #define CYMESH_NET_HOPS_LIFETIME_MS             (60000u)
+#endif
+
+#if (CYMESH_NET_HOPS_SIZE < 1u) || (CYMESH_NET_HOPS_SIZE > 255u) || (CYMESH_NET_HOPS_TTL_MARGIN > 62u)
+    #error "Invalid hop table configuration"
+#endif
+
+
+/*******************************************************************************
+* Structures and Enums
+*******************************************************************************/
+typedef struct
+{
+    /* Unicast address, 0 for a free entry */
+    uint16 src;
+
+    /* Shortest distance heard within the lifetime, 1 for a neighbour, 0 if
+     * none was heard yet */
+    uint8 hops;
+
+    /* Timestamp the distance was last confirmed, in ms */
+    uint32 learned;
+
+    /* Timestamp of the last message sent to src, in ms */
+    uint32 used;
+} CYMESH_NET_HOPS_ENTRY_T;
+
+typedef struct
+{
+    CYMESH_NET_HOPS_ENTRY_T entry[CYMESH_NET_HOPS_SIZE];
+
+    /* Messages sent with a lower TTL */
+    uint32 shortened;
+} CYMESH_NET_HOPS_STRUCT;
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+/******************************************************************************
+* Function Name: CyMesh_NetworkHopsInit
+*******************************************************************************
+*
+*  This function empties the table.
+*
+*  \param CYMESH_NET_HOPS_STRUCT*: table
+*
+*  \return None
+*
+******************************************************************************/
+void CyMesh_NetworkHopsInit(CYMESH_NET_HOPS_STRUCT * hops);
+
+/******************************************************************************
+* Function Name: CyMesh_NetworkHopsLearn
+*******************************************************************************
+*
+*  This function takes the distance to the source of an authenticated packet,
+* if the source is tracked. A packet with TTL 0 is never relayed, so it comes from a neighbour. Other
+* packets have come initialTtl - ttl + 1 hops. A TTL of 1 is also how a
+* message is kept to the neighbours, so it is not used.
+*
+*  \param CYMESH_NET_HOPS_STRUCT*: table
+*
+*  \param uint16: SRC of the packet, a unicast address
+*
+*  \param uint8: TTL of the packet as received
+*
+*  \param uint8: TTL the packet was sent with, 0 if not known
+*
+*  \param uint32: timestamp, in ms
+*
+*  \return None
+*
+******************************************************************************/
+void CyMesh_NetworkHopsLearn(CYMESH_NET_HOPS_STRUCT * hops, uint16 src, uint8 ttl, uint8 initialTtl, uint32 now);
+
+/******************************************************************************
+* Function Name: CyMesh_NetworkHopsTtl
+*******************************************************************************
+*
+*  This function returns the TTL for a message: the learned distance to the
+* destination plus CYMESH_NET_HOPS_TTL_MARGIN, if that is lower than ttl.
+* TTLs of 0 and 1, and destinations without a valid distance, are kept. A
+* destination that is not tracked yet is added, so that the next packets from
+* it, such as its response, teach the distance.
+*
+*  \param CYMESH_NET_HOPS_STRUCT*: table
+*
+*  \param uint16: DST of the message
+*
+*  \param uint8: TTL asked for by the upper layer
+*
+*  \param uint32: timestamp, in ms
+*
+*  \return uint8: TTL to send with
+*
+******************************************************************************/
+uint8 CyMesh_NetworkHopsTtl(CYMESH_NET_HOPS_STRUCT * hops, uint16 dst, uint8 ttl, uint32 now);
+
+#endif
+/* [] END OF FILE */
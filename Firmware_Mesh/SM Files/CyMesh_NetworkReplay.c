@@ -0,0 +1,218 @@
+/***************************************************************************//**
+* \file CyMesh_NetworkReplay.c
+* \version 1.0
+*
+* \brief
+*  This file contains the replay protection list of the BLE SmartMesh v1
+*  network layer.
+*
+*  The list keeps the highest SEQ accepted from each unicast source, sorted on
+*  the source address, so a lookup is a binary search: 7 steps at 100 sources,
+*  10 at 1000. A window of the 32 SEQs below the highest one lets a PDU that
+*  a relay delayed behind a later one through once. When the list is full, the
+*  source accepted least recently is dropped for a new one; messages from a
+*  dropped source are accepted again, so the list should hold every source
+*  that talks to the node. A SEQ near 0 while the stored one is near the end
+*  of the 21-bit SEQ space is taken as the source having wrapped its SEQ, and
+*  is accepted; any other SEQ that is not higher is a replay.
+*
+*  Tools/network_bench/replay_bench.c measures the lookup cost.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <stddef.h>
+#include <string.h>
+#include "CyMesh_NetworkReplay.h"
+
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+/* Checksum of an empty list, so that erased or zeroed flash does not pass */
+#define CYMESH_NET_REPLAY_CHECKSUM_SEED         (0x52504C31u)
+
+/* A source wraps its 21-bit SEQ to 0 after CYMESH_TRAN_SEQ_MAX. A SEQ in the
+ * first CYMESH_NET_REPLAY_SEQ_WRAP_MARGIN while the stored one is in the last
+ * CYMESH_NET_REPLAY_SEQ_WRAP_MARGIN is taken as the source having wrapped, and
+ * starts its entry again. The margin covers the SEQs a source skips when it
+ * resets, and the PDUs lost around the wrap. Any other SEQ below the stored
+ * one is a replay. */
+#define CYMESH_NET_REPLAY_SEQ_MAX               (0x001FFFFFu)
+#define CYMESH_NET_REPLAY_SEQ_WRAP_MARGIN       (0x00001000u)
+
+/* SEQs below the highest one that may still be accepted once */
+#define CYMESH_NET_REPLAY_WINDOW_SIZE           (32u)
+
+
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+static uint32 CyMesh_NetworkReplayChecksum(const CYMESH_NET_REPLAY_LIST_T * list)
+{
+    const uint32 * word = (const uint32 *)list;
+    uint32 checksum = CYMESH_NET_REPLAY_CHECKSUM_SEED;
+    uint32 i;
+
+    for(i = 0; i < (offsetof(CYMESH_NET_REPLAY_LIST_T, checksum) / sizeof(uint32)); i++)
+    {
+        checksum += word[i];
+    }
+
+    return checksum;
+}
+
+
+/* Removes the entry accepted least recently and returns its index */
+static uint16 CyMesh_NetworkReplayEvict(CYMESH_NET_REPLAY_STRUCT * replay)
+{
+    uint16 count = replay->list.count;
+    uint16 oldest = 0u;
+    uint16 i;
+
+    for(i = 1u; i < count; i++)
+    {
+        if((uint32)(replay->clock - replay->lastUsed[i]) > (uint32)(replay->clock - replay->lastUsed[oldest]))
+        {
+            oldest = i;
+        }
+    }
+
+    count--;
+    memmove(&replay->list.seq[oldest], &replay->list.seq[oldest + 1u], (count - oldest) * sizeof(uint32));
+    memmove(&replay->list.src[oldest], &replay->list.src[oldest + 1u], (count - oldest) * sizeof(uint16));
+    memmove(&replay->lastUsed[oldest], &replay->lastUsed[oldest + 1u], (count - oldest) * sizeof(uint32));
+    memmove(&replay->window[oldest], &replay->window[oldest + 1u], (count - oldest) * sizeof(uint32));
+    replay->list.count = count;
+
+    return oldest;
+}
+
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+void CyMesh_NetworkReplayInit(CYMESH_NET_REPLAY_STRUCT * replay)
+{
+    memset(replay, 0, sizeof(*replay));
+}
+
+
+bool CyMesh_NetworkReplayLoad(CYMESH_NET_REPLAY_STRUCT * replay, const CYMESH_NET_REPLAY_LIST_T * stored,
+                              uint32 tag)
+{
+    CyMesh_NetworkReplayInit(replay);
+
+    if((stored->tag != tag) || (stored->count > CYMESH_NET_REPLAY_LIST_SIZE) ||
+       (stored->checksum != CyMesh_NetworkReplayChecksum(stored)))
+    {
+        return false;
+    }
+
+    memcpy(&replay->list, stored, sizeof(replay->list));
+
+    return true;
+}
+
+
+void CyMesh_NetworkReplaySeal(CYMESH_NET_REPLAY_STRUCT * replay, uint32 tag)
+{
+    replay->list.tag = tag;
+    replay->list.checksum = CyMesh_NetworkReplayChecksum(&replay->list);
+    replay->isDirty = false;
+}
+
+
+bool CyMesh_NetworkReplayAccept(CYMESH_NET_REPLAY_STRUCT * replay, uint16 src, uint32 seq)
+{
+    uint16 low = 0u;
+    uint16 high = replay->list.count;
+
+    while(low < high)
+    {
+        uint16 middle = (uint16)(low + high) >> 1;
+
+        if(replay->list.src[middle] < src)
+        {
+            low = middle + 1u;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    if((low < replay->list.count) && (replay->list.src[low] == src))
+    {
+        uint32 behind = replay->list.seq[low] - seq;
+
+        if(seq > replay->list.seq[low])
+        {
+            uint32 ahead = seq - replay->list.seq[low];
+
+            /* The old highest SEQ moves into the window */
+            replay->window[low] = (ahead < CYMESH_NET_REPLAY_WINDOW_SIZE) ?
+                                  ((replay->window[low] << ahead) | (1u << (ahead - 1u))) :
+                                  ((ahead == CYMESH_NET_REPLAY_WINDOW_SIZE) ? (1u << (ahead - 1u)) : 0u);
+        }
+        else if((replay->list.seq[low] > (CYMESH_NET_REPLAY_SEQ_MAX - CYMESH_NET_REPLAY_SEQ_WRAP_MARGIN)) &&
+                (seq < CYMESH_NET_REPLAY_SEQ_WRAP_MARGIN))
+        {
+            replay->window[low] = 0u;
+        }
+        else if((behind == 0u) || (behind > CYMESH_NET_REPLAY_WINDOW_SIZE) ||
+                ((replay->window[low] & (1u << (behind - 1u))) != 0u))
+        {
+            return false;
+        }
+        else
+        {
+            /* Out of order: the highest SEQ stays */
+            replay->window[low] |= 1u << (behind - 1u);
+            replay->clock++;
+            replay->lastUsed[low] = replay->clock;
+
+            return true;
+        }
+    }
+    else
+    {
+        uint16 count;
+
+        if((replay->list.count == CYMESH_NET_REPLAY_LIST_SIZE) && (CyMesh_NetworkReplayEvict(replay) < low))
+        {
+            low--;
+        }
+
+        count = replay->list.count;
+        memmove(&replay->list.seq[low + 1u], &replay->list.seq[low], (count - low) * sizeof(uint32));
+        memmove(&replay->list.src[low + 1u], &replay->list.src[low], (count - low) * sizeof(uint16));
+        memmove(&replay->lastUsed[low + 1u], &replay->lastUsed[low], (count - low) * sizeof(uint32));
+        memmove(&replay->window[low + 1u], &replay->window[low], (count - low) * sizeof(uint32));
+        replay->list.src[low] = src;
+        replay->window[low] = 0u;
+        replay->list.count = count + 1u;
+    }
+
+    replay->clock++;
+    replay->list.seq[low] = seq;
+    replay->lastUsed[low] = replay->clock;
+    replay->isDirty = true;
+
+    return true;
+}
+
+/* [] END OF FILE */
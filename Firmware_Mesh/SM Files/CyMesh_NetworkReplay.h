@@ -0,0 +1,159 @@
+/***************************************************************************//**
+* \file CyMesh_NetworkReplay.h
+* \version 1.0
+*
+* \brief
+*  This is the header file of the replay protection list, which keeps the
+*  highest SEQ accepted from each unicast source and the SEQs accepted just
+*  below it.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined (CYMESH_NETWORK_REPLAY_H)
+#define CYMESH_NETWORK_REPLAY_H
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <stdbool.h>
+
+
+/*******************************************************************************
+* Compile Time Options
+*******************************************************************************/
+/* Number of sources tracked, 14 bytes of RAM and 6 bytes of flash each. The
+ * source accepted least recently is dropped to make room for a new one. */
+#if !defined(CYMESH_NET_REPLAY_LIST_SIZE)
+    #define CYMESH_NET_REPLAY_LIST_SIZE             (32u)
+#endif
+
+#if (CYMESH_NET_REPLAY_LIST_SIZE < 1u) || (CYMESH_NET_REPLAY_LIST_SIZE > 0x7FFFu)
+    #error "Invalid replay protection list configuration"
+#endif
+
+
+/*******************************************************************************
+* Structures and Enums
+*******************************************************************************/
+
+/* The part of the list that is kept in flash */
+typedef struct
+{
+    /* Highest SEQ accepted from src[i] */
+    uint32 seq[CYMESH_NET_REPLAY_LIST_SIZE];
+
+    /* Sources, in ascending order */
+    uint16 src[CYMESH_NET_REPLAY_LIST_SIZE];
+
+    uint16 count;
+
+    /* Set by the owner of the list; a stored list with another tag is not
+     * loaded */
+    uint32 tag;
+
+    /* Checksum to ensure data accuracy in flash storage */
+    uint32 checksum;
+} CYMESH_NET_REPLAY_LIST_T;
+
+typedef struct
+{
+    CYMESH_NET_REPLAY_LIST_T list;
+
+    /* Value of clock when src[i] was last accepted */
+    uint32 lastUsed[CYMESH_NET_REPLAY_LIST_SIZE];
+
+    /* Bit n set when SEQ seq[i] - 1 - n of src[i] was accepted. Relays hold
+     * PDUs for a random back-off, so the PDUs of a source can arrive out of
+     * order. Kept in RAM only; after a reset only SEQs above seq[i] pass. */
+    uint32 window[CYMESH_NET_REPLAY_LIST_SIZE];
+
+    /* Advances on every accepted message */
+    uint32 clock;
+
+    /* Set when the list changed after CyMesh_NetworkReplaySeal() */
+    bool isDirty;
+} CYMESH_NET_REPLAY_STRUCT;
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+/******************************************************************************
+* Function Name: CyMesh_NetworkReplayInit
+*******************************************************************************
+*
+*  This function empties the list.
+*
+*  \param CYMESH_NET_REPLAY_STRUCT*: list
+*
+*  \return None
+*
+******************************************************************************/
+void CyMesh_NetworkReplayInit(CYMESH_NET_REPLAY_STRUCT * replay);
+
+/******************************************************************************
+* Function Name: CyMesh_NetworkReplayLoad
+*******************************************************************************
+*
+*  This function restores a list sealed by CyMesh_NetworkReplaySeal(). The list
+* is emptied if the stored copy is corrupt or has another tag.
+*
+*  \param CYMESH_NET_REPLAY_STRUCT*: list
+*
+*  \param const CYMESH_NET_REPLAY_LIST_T*: stored copy
+*
+*  \param uint32: tag the stored copy must have
+*
+*  \return bool: true if the stored copy was loaded
+*
+******************************************************************************/
+bool CyMesh_NetworkReplayLoad(CYMESH_NET_REPLAY_STRUCT * replay, const CYMESH_NET_REPLAY_LIST_T * stored,
+                              uint32 tag);
+
+/******************************************************************************
+* Function Name: CyMesh_NetworkReplaySeal
+*******************************************************************************
+*
+*  This function sets the tag and checksum of the list before it is written
+* to flash, and clears isDirty.
+*
+*  \param CYMESH_NET_REPLAY_STRUCT*: list
+*
+*  \param uint32: tag
+*
+*  \return None
+*
+******************************************************************************/
+void CyMesh_NetworkReplaySeal(CYMESH_NET_REPLAY_STRUCT * replay, uint32 tag);
+
+/******************************************************************************
+* Function Name: CyMesh_NetworkReplayAccept
+*******************************************************************************
+*
+*  This function checks the SEQ of an authenticated message against the
+* highest SEQ accepted from its source, and records it if it is higher, if it
+* is one of the 32 SEQs below it not accepted yet, or if the source wrapped
+* its SEQ: the stored SEQ is near the end of the SEQ space and this one near
+* its start. The lookup is a binary search;
+* adding a source moves the entries after it.
+*
+*  \param CYMESH_NET_REPLAY_STRUCT*: list
+*
+*  \param uint16: SRC of the message, a unicast address
+*
+*  \param uint32: SEQ of the message
+*
+*  \return bool: false if the message is a replay
+*
+******************************************************************************/
+bool CyMesh_NetworkReplayAccept(CYMESH_NET_REPLAY_STRUCT * replay, uint16 src, uint32 seq);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,520 @@
+/***************************************************************************//**
+* \file CyMesh_SecurityPVT.c
+* \version 1.0
+*
+* \brief
+*  This file contains the AES-128 and AES-CCM implementation of the BLE
+*  SmartMesh v1 Security module. It replaces the CyMesh_SecurityPVT object of
+*  SM_LIB_256K.a, which ran every block on the BLE hardware AES with the raw key.
+*
+*  The expanded keys of the most recently used keys are cached, so the network
+*  and application keys are expanded once instead of on every block. AES-CCM
+*  computes the CBC-MAC and the CTR keystream in the same pass over the data.
+*
+*  Remove this file from the project to link the library version again. See
+*  Tools/aes_ccm_bench for the test vectors and the host benchmark, and
+*  Tools/network_bench/interop_check.c for the check against the library
+*  object.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <string.h>
+#include "CyMesh_SecurityPVT.h"
+
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+#define CYMESH_SECURITY_AES_KEY_SIZE            (16u)
+#define CYMESH_SECURITY_AES_ROUNDS              (10u)
+#define CYMESH_SECURITY_AES_ROUND_KEY_WORDS     (4u * (CYMESH_SECURITY_AES_ROUNDS + 1u))
+
+#define CYMESH_SECURITY_CCM_NONCE_SIZE          (13u)
+#define CYMESH_SECURITY_CCM_FLAGS_ADATA         (0x40u)
+#define CYMESH_SECURITY_CCM_FLAGS_L             (0x01u)     /* 2 byte length field */
+
+#define CYMESH_SECURITY_GET_WORD(p)             (((uint32)(p)[0] << 24) | ((uint32)(p)[1] << 16) | \
+                                                 ((uint32)(p)[2] << 8) | (uint32)(p)[3])
+#define CYMESH_SECURITY_PUT_WORD(p, w)          do { (p)[0] = (uint8)((w) >> 24); (p)[1] = (uint8)((w) >> 16); \
+                                                     (p)[2] = (uint8)((w) >> 8); (p)[3] = (uint8)(w); } while(0)
+#define CYMESH_SECURITY_ROR(w, n)               (((w) >> (n)) | ((w) << (32u - (n))))
+#define CYMESH_SECURITY_XTIME(b)                ((uint8)(((b) << 1) ^ ((((b) >> 7) & 1u) * 0x1Bu)))
+
+
+
+/*******************************************************************************
+* Data Structures
+*******************************************************************************/
+
+/* One expanded key. The round key words are big-endian, as in FIPS-197. */
+typedef struct
+{
+    uint8 key[CYMESH_SECURITY_AES_KEY_SIZE];
+    uint32 roundKey[CYMESH_SECURITY_AES_ROUND_KEY_WORDS];
+    uint32 lastUse;
+} CYMESH_SECURITY_AES_KEY_T;
+
+#if (CYMESH_SECURITY_AES_KEY_CACHE_SIZE > 0)
+    static CYMESH_SECURITY_AES_KEY_T cyMesh_SecurityAesKeyCache[CYMESH_SECURITY_AES_KEY_CACHE_SIZE];
+    static uint32 cyMesh_SecurityAesKeyUseCount;
+#else
+    static CYMESH_SECURITY_AES_KEY_T cyMesh_SecurityAesKey;
+#endif  /* (CYMESH_SECURITY_AES_KEY_CACHE_SIZE > 0) */
+
+static const uint8 cyMesh_SecurityAesSbox[256] =
+{
+    0x63u, 0x7Cu, 0x77u, 0x7Bu, 0xF2u, 0x6Bu, 0x6Fu, 0xC5u, 0x30u, 0x01u, 0x67u, 0x2Bu, 0xFEu, 0xD7u, 0xABu, 0x76u,
+    0xCAu, 0x82u, 0xC9u, 0x7Du, 0xFAu, 0x59u, 0x47u, 0xF0u, 0xADu, 0xD4u, 0xA2u, 0xAFu, 0x9Cu, 0xA4u, 0x72u, 0xC0u,
+    0xB7u, 0xFDu, 0x93u, 0x26u, 0x36u, 0x3Fu, 0xF7u, 0xCCu, 0x34u, 0xA5u, 0xE5u, 0xF1u, 0x71u, 0xD8u, 0x31u, 0x15u,
+    0x04u, 0xC7u, 0x23u, 0xC3u, 0x18u, 0x96u, 0x05u, 0x9Au, 0x07u, 0x12u, 0x80u, 0xE2u, 0xEBu, 0x27u, 0xB2u, 0x75u,
+    0x09u, 0x83u, 0x2Cu, 0x1Au, 0x1Bu, 0x6Eu, 0x5Au, 0xA0u, 0x52u, 0x3Bu, 0xD6u, 0xB3u, 0x29u, 0xE3u, 0x2Fu, 0x84u,
+    0x53u, 0xD1u, 0x00u, 0xEDu, 0x20u, 0xFCu, 0xB1u, 0x5Bu, 0x6Au, 0xCBu, 0xBEu, 0x39u, 0x4Au, 0x4Cu, 0x58u, 0xCFu,
+    0xD0u, 0xEFu, 0xAAu, 0xFBu, 0x43u, 0x4Du, 0x33u, 0x85u, 0x45u, 0xF9u, 0x02u, 0x7Fu, 0x50u, 0x3Cu, 0x9Fu, 0xA8u,
+    0x51u, 0xA3u, 0x40u, 0x8Fu, 0x92u, 0x9Du, 0x38u, 0xF5u, 0xBCu, 0xB6u, 0xDAu, 0x21u, 0x10u, 0xFFu, 0xF3u, 0xD2u,
+    0xCDu, 0x0Cu, 0x13u, 0xECu, 0x5Fu, 0x97u, 0x44u, 0x17u, 0xC4u, 0xA7u, 0x7Eu, 0x3Du, 0x64u, 0x5Du, 0x19u, 0x73u,
+    0x60u, 0x81u, 0x4Fu, 0xDCu, 0x22u, 0x2Au, 0x90u, 0x88u, 0x46u, 0xEEu, 0xB8u, 0x14u, 0xDEu, 0x5Eu, 0x0Bu, 0xDBu,
+    0xE0u, 0x32u, 0x3Au, 0x0Au, 0x49u, 0x06u, 0x24u, 0x5Cu, 0xC2u, 0xD3u, 0xACu, 0x62u, 0x91u, 0x95u, 0xE4u, 0x79u,
+    0xE7u, 0xC8u, 0x37u, 0x6Du, 0x8Du, 0xD5u, 0x4Eu, 0xA9u, 0x6Cu, 0x56u, 0xF4u, 0xEAu, 0x65u, 0x7Au, 0xAEu, 0x08u,
+    0xBAu, 0x78u, 0x25u, 0x2Eu, 0x1Cu, 0xA6u, 0xB4u, 0xC6u, 0xE8u, 0xDDu, 0x74u, 0x1Fu, 0x4Bu, 0xBDu, 0x8Bu, 0x8Au,
+    0x70u, 0x3Eu, 0xB5u, 0x66u, 0x48u, 0x03u, 0xF6u, 0x0Eu, 0x61u, 0x35u, 0x57u, 0xB9u, 0x86u, 0xC1u, 0x1Du, 0x9Eu,
+    0xE1u, 0xF8u, 0x98u, 0x11u, 0x69u, 0xD9u, 0x8Eu, 0x94u, 0x9Bu, 0x1Eu, 0x87u, 0xE9u, 0xCEu, 0x55u, 0x28u, 0xDFu,
+    0x8Cu, 0xA1u, 0x89u, 0x0Du, 0xBFu, 0xE6u, 0x42u, 0x68u, 0x41u, 0x99u, 0x2Du, 0x0Fu, 0xB0u, 0x54u, 0xBBu, 0x16u
+};
+
+#if (CYMESH_SECURITY_AES_CORE == CYMESH_SECURITY_AES_CORE_TTABLE)
+/* SubBytes and MixColumns of one byte: {02}.S[x], S[x], S[x], {03}.S[x]. The
+ * three other tables of the usual T-table implementation are rotations of it. */
+static const uint32 cyMesh_SecurityAesTe0[256] =
+{
+    0xC66363A5u, 0xF87C7C84u, 0xEE777799u, 0xF67B7B8Du, 0xFFF2F20Du, 0xD66B6BBDu,
+    0xDE6F6FB1u, 0x91C5C554u, 0x60303050u, 0x02010103u, 0xCE6767A9u, 0x562B2B7Du,
+    0xE7FEFE19u, 0xB5D7D762u, 0x4DABABE6u, 0xEC76769Au, 0x8FCACA45u, 0x1F82829Du,
+    0x89C9C940u, 0xFA7D7D87u, 0xEFFAFA15u, 0xB25959EBu, 0x8E4747C9u, 0xFBF0F00Bu,
+    0x41ADADECu, 0xB3D4D467u, 0x5FA2A2FDu, 0x45AFAFEAu, 0x239C9CBFu, 0x53A4A4F7u,
+    0xE4727296u, 0x9BC0C05Bu, 0x75B7B7C2u, 0xE1FDFD1Cu, 0x3D9393AEu, 0x4C26266Au,
+    0x6C36365Au, 0x7E3F3F41u, 0xF5F7F702u, 0x83CCCC4Fu, 0x6834345Cu, 0x51A5A5F4u,
+    0xD1E5E534u, 0xF9F1F108u, 0xE2717193u, 0xABD8D873u, 0x62313153u, 0x2A15153Fu,
+    0x0804040Cu, 0x95C7C752u, 0x46232365u, 0x9DC3C35Eu, 0x30181828u, 0x379696A1u,
+    0x0A05050Fu, 0x2F9A9AB5u, 0x0E070709u, 0x24121236u, 0x1B80809Bu, 0xDFE2E23Du,
+    0xCDEBEB26u, 0x4E272769u, 0x7FB2B2CDu, 0xEA75759Fu, 0x1209091Bu, 0x1D83839Eu,
+    0x582C2C74u, 0x341A1A2Eu, 0x361B1B2Du, 0xDC6E6EB2u, 0xB45A5AEEu, 0x5BA0A0FBu,
+    0xA45252F6u, 0x763B3B4Du, 0xB7D6D661u, 0x7DB3B3CEu, 0x5229297Bu, 0xDDE3E33Eu,
+    0x5E2F2F71u, 0x13848497u, 0xA65353F5u, 0xB9D1D168u, 0x00000000u, 0xC1EDED2Cu,
+    0x40202060u, 0xE3FCFC1Fu, 0x79B1B1C8u, 0xB65B5BEDu, 0xD46A6ABEu, 0x8DCBCB46u,
+    0x67BEBED9u, 0x7239394Bu, 0x944A4ADEu, 0x984C4CD4u, 0xB05858E8u, 0x85CFCF4Au,
+    0xBBD0D06Bu, 0xC5EFEF2Au, 0x4FAAAAE5u, 0xEDFBFB16u, 0x864343C5u, 0x9A4D4DD7u,
+    0x66333355u, 0x11858594u, 0x8A4545CFu, 0xE9F9F910u, 0x04020206u, 0xFE7F7F81u,
+    0xA05050F0u, 0x783C3C44u, 0x259F9FBAu, 0x4BA8A8E3u, 0xA25151F3u, 0x5DA3A3FEu,
+    0x804040C0u, 0x058F8F8Au, 0x3F9292ADu, 0x219D9DBCu, 0x70383848u, 0xF1F5F504u,
+    0x63BCBCDFu, 0x77B6B6C1u, 0xAFDADA75u, 0x42212163u, 0x20101030u, 0xE5FFFF1Au,
+    0xFDF3F30Eu, 0xBFD2D26Du, 0x81CDCD4Cu, 0x180C0C14u, 0x26131335u, 0xC3ECEC2Fu,
+    0xBE5F5FE1u, 0x359797A2u, 0x884444CCu, 0x2E171739u, 0x93C4C457u, 0x55A7A7F2u,
+    0xFC7E7E82u, 0x7A3D3D47u, 0xC86464ACu, 0xBA5D5DE7u, 0x3219192Bu, 0xE6737395u,
+    0xC06060A0u, 0x19818198u, 0x9E4F4FD1u, 0xA3DCDC7Fu, 0x44222266u, 0x542A2A7Eu,
+    0x3B9090ABu, 0x0B888883u, 0x8C4646CAu, 0xC7EEEE29u, 0x6BB8B8D3u, 0x2814143Cu,
+    0xA7DEDE79u, 0xBC5E5EE2u, 0x160B0B1Du, 0xADDBDB76u, 0xDBE0E03Bu, 0x64323256u,
+    0x743A3A4Eu, 0x140A0A1Eu, 0x924949DBu, 0x0C06060Au, 0x4824246Cu, 0xB85C5CE4u,
+    0x9FC2C25Du, 0xBDD3D36Eu, 0x43ACACEFu, 0xC46262A6u, 0x399191A8u, 0x319595A4u,
+    0xD3E4E437u, 0xF279798Bu, 0xD5E7E732u, 0x8BC8C843u, 0x6E373759u, 0xDA6D6DB7u,
+    0x018D8D8Cu, 0xB1D5D564u, 0x9C4E4ED2u, 0x49A9A9E0u, 0xD86C6CB4u, 0xAC5656FAu,
+    0xF3F4F407u, 0xCFEAEA25u, 0xCA6565AFu, 0xF47A7A8Eu, 0x47AEAEE9u, 0x10080818u,
+    0x6FBABAD5u, 0xF0787888u, 0x4A25256Fu, 0x5C2E2E72u, 0x381C1C24u, 0x57A6A6F1u,
+    0x73B4B4C7u, 0x97C6C651u, 0xCBE8E823u, 0xA1DDDD7Cu, 0xE874749Cu, 0x3E1F1F21u,
+    0x964B4BDDu, 0x61BDBDDCu, 0x0D8B8B86u, 0x0F8A8A85u, 0xE0707090u, 0x7C3E3E42u,
+    0x71B5B5C4u, 0xCC6666AAu, 0x904848D8u, 0x06030305u, 0xF7F6F601u, 0x1C0E0E12u,
+    0xC26161A3u, 0x6A35355Fu, 0xAE5757F9u, 0x69B9B9D0u, 0x17868691u, 0x99C1C158u,
+    0x3A1D1D27u, 0x279E9EB9u, 0xD9E1E138u, 0xEBF8F813u, 0x2B9898B3u, 0x22111133u,
+    0xD26969BBu, 0xA9D9D970u, 0x078E8E89u, 0x339494A7u, 0x2D9B9BB6u, 0x3C1E1E22u,
+    0x15878792u, 0xC9E9E920u, 0x87CECE49u, 0xAA5555FFu, 0x50282878u, 0xA5DFDF7Au,
+    0x038C8C8Fu, 0x59A1A1F8u, 0x09898980u, 0x1A0D0D17u, 0x65BFBFDAu, 0xD7E6E631u,
+    0x844242C6u, 0xD06868B8u, 0x824141C3u, 0x299999B0u, 0x5A2D2D77u, 0x1E0F0F11u,
+    0x7BB0B0CBu, 0xA85454FCu, 0x6DBBBBD6u, 0x2C16163Au
+};
+#endif  /* (CYMESH_SECURITY_AES_CORE == CYMESH_SECURITY_AES_CORE_TTABLE) */
+
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+
+/* FIPS-197 key expansion */
+static void CyMesh_SecurityPVTAesExpandKey(const uint8 * key, uint32 * roundKey)
+{
+    uint32 temp;
+    uint8 rcon = 0x01u;
+    uint8 i;
+
+    for(i = 0; i < 4u; i++)
+    {
+        roundKey[i] = CYMESH_SECURITY_GET_WORD(&key[4u * i]);
+    }
+
+    for(i = 4u; i < CYMESH_SECURITY_AES_ROUND_KEY_WORDS; i++)
+    {
+        temp = roundKey[i - 1u];
+        if((i & 0x03u) == 0u)
+        {
+            temp = (((uint32)cyMesh_SecurityAesSbox[(temp >> 16) & 0xFFu] << 24) |
+                    ((uint32)cyMesh_SecurityAesSbox[(temp >> 8) & 0xFFu] << 16) |
+                    ((uint32)cyMesh_SecurityAesSbox[temp & 0xFFu] << 8) |
+                    (uint32)cyMesh_SecurityAesSbox[temp >> 24]) ^ ((uint32)rcon << 24);
+            rcon = CYMESH_SECURITY_XTIME(rcon);
+        }
+        roundKey[i] = roundKey[i - 4u] ^ temp;
+    }
+}
+
+
+/* Returns the expanded key, from the cache or replacing its least recently used entry */
+static const uint32 * CyMesh_SecurityPVTAesGetRoundKey(const uint8 * key)
+{
+#if (CYMESH_SECURITY_AES_KEY_CACHE_SIZE > 0)
+    CYMESH_SECURITY_AES_KEY_T * entry = &cyMesh_SecurityAesKeyCache[0];
+    uint8 i;
+
+    cyMesh_SecurityAesKeyUseCount++;
+
+    for(i = 0; i < CYMESH_SECURITY_AES_KEY_CACHE_SIZE; i++)
+    {
+        if((cyMesh_SecurityAesKeyCache[i].lastUse != 0u) &&
+           (memcmp(cyMesh_SecurityAesKeyCache[i].key, key, CYMESH_SECURITY_AES_KEY_SIZE) == 0))
+        {
+            cyMesh_SecurityAesKeyCache[i].lastUse = cyMesh_SecurityAesKeyUseCount;
+            return cyMesh_SecurityAesKeyCache[i].roundKey;
+        }
+
+        if((cyMesh_SecurityAesKeyUseCount - cyMesh_SecurityAesKeyCache[i].lastUse) >
+           (cyMesh_SecurityAesKeyUseCount - entry->lastUse))
+        {
+            entry = &cyMesh_SecurityAesKeyCache[i];
+        }
+    }
+#else
+    CYMESH_SECURITY_AES_KEY_T * entry = &cyMesh_SecurityAesKey;
+#endif  /* (CYMESH_SECURITY_AES_KEY_CACHE_SIZE > 0) */
+
+    memcpy(entry->key, key, CYMESH_SECURITY_AES_KEY_SIZE);
+    CyMesh_SecurityPVTAesExpandKey(key, entry->roundKey);
+
+#if (CYMESH_SECURITY_AES_KEY_CACHE_SIZE > 0)
+    entry->lastUse = cyMesh_SecurityAesKeyUseCount;
+#endif  /* (CYMESH_SECURITY_AES_KEY_CACHE_SIZE > 0) */
+
+    return entry->roundKey;
+}
+
+
+#if (CYMESH_SECURITY_AES_CORE == CYMESH_SECURITY_AES_CORE_TTABLE)
+
+/* One AES-128 block, 32-bit table lookups */
+static void CyMesh_SecurityPVTAesBlock(const uint32 * roundKey, const uint8 * input, uint8 * output)
+{
+    uint32 s0 = CYMESH_SECURITY_GET_WORD(&input[0]) ^ roundKey[0];
+    uint32 s1 = CYMESH_SECURITY_GET_WORD(&input[4]) ^ roundKey[1];
+    uint32 s2 = CYMESH_SECURITY_GET_WORD(&input[8]) ^ roundKey[2];
+    uint32 s3 = CYMESH_SECURITY_GET_WORD(&input[12]) ^ roundKey[3];
+    uint32 t0;
+    uint32 t1;
+    uint32 t2;
+    uint32 t3;
+    uint8 round;
+
+    for(round = 1u; round < CYMESH_SECURITY_AES_ROUNDS; round++)
+    {
+        roundKey += 4;
+        t0 = cyMesh_SecurityAesTe0[s0 >> 24] ^ CYMESH_SECURITY_ROR(cyMesh_SecurityAesTe0[(s1 >> 16) & 0xFFu], 8u) ^
+             CYMESH_SECURITY_ROR(cyMesh_SecurityAesTe0[(s2 >> 8) & 0xFFu], 16u) ^
+             CYMESH_SECURITY_ROR(cyMesh_SecurityAesTe0[s3 & 0xFFu], 24u) ^ roundKey[0];
+        t1 = cyMesh_SecurityAesTe0[s1 >> 24] ^ CYMESH_SECURITY_ROR(cyMesh_SecurityAesTe0[(s2 >> 16) & 0xFFu], 8u) ^
+             CYMESH_SECURITY_ROR(cyMesh_SecurityAesTe0[(s3 >> 8) & 0xFFu], 16u) ^
+             CYMESH_SECURITY_ROR(cyMesh_SecurityAesTe0[s0 & 0xFFu], 24u) ^ roundKey[1];
+        t2 = cyMesh_SecurityAesTe0[s2 >> 24] ^ CYMESH_SECURITY_ROR(cyMesh_SecurityAesTe0[(s3 >> 16) & 0xFFu], 8u) ^
+             CYMESH_SECURITY_ROR(cyMesh_SecurityAesTe0[(s0 >> 8) & 0xFFu], 16u) ^
+             CYMESH_SECURITY_ROR(cyMesh_SecurityAesTe0[s1 & 0xFFu], 24u) ^ roundKey[2];
+        t3 = cyMesh_SecurityAesTe0[s3 >> 24] ^ CYMESH_SECURITY_ROR(cyMesh_SecurityAesTe0[(s0 >> 16) & 0xFFu], 8u) ^
+             CYMESH_SECURITY_ROR(cyMesh_SecurityAesTe0[(s1 >> 8) & 0xFFu], 16u) ^
+             CYMESH_SECURITY_ROR(cyMesh_SecurityAesTe0[s2 & 0xFFu], 24u) ^ roundKey[3];
+        s0 = t0;
+        s1 = t1;
+        s2 = t2;
+        s3 = t3;
+    }
+
+    /* Last round: SubBytes, ShiftRows and AddRoundKey */
+    roundKey += 4;
+    t0 = (((uint32)cyMesh_SecurityAesSbox[s0 >> 24] << 24) | ((uint32)cyMesh_SecurityAesSbox[(s1 >> 16) & 0xFFu] << 16) |
+          ((uint32)cyMesh_SecurityAesSbox[(s2 >> 8) & 0xFFu] << 8) | (uint32)cyMesh_SecurityAesSbox[s3 & 0xFFu]) ^ roundKey[0];
+    t1 = (((uint32)cyMesh_SecurityAesSbox[s1 >> 24] << 24) | ((uint32)cyMesh_SecurityAesSbox[(s2 >> 16) & 0xFFu] << 16) |
+          ((uint32)cyMesh_SecurityAesSbox[(s3 >> 8) & 0xFFu] << 8) | (uint32)cyMesh_SecurityAesSbox[s0 & 0xFFu]) ^ roundKey[1];
+    t2 = (((uint32)cyMesh_SecurityAesSbox[s2 >> 24] << 24) | ((uint32)cyMesh_SecurityAesSbox[(s3 >> 16) & 0xFFu] << 16) |
+          ((uint32)cyMesh_SecurityAesSbox[(s0 >> 8) & 0xFFu] << 8) | (uint32)cyMesh_SecurityAesSbox[s1 & 0xFFu]) ^ roundKey[2];
+    t3 = (((uint32)cyMesh_SecurityAesSbox[s3 >> 24] << 24) | ((uint32)cyMesh_SecurityAesSbox[(s0 >> 16) & 0xFFu] << 16) |
+          ((uint32)cyMesh_SecurityAesSbox[(s1 >> 8) & 0xFFu] << 8) | (uint32)cyMesh_SecurityAesSbox[s2 & 0xFFu]) ^ roundKey[3];
+
+    CYMESH_SECURITY_PUT_WORD(&output[0], t0);
+    CYMESH_SECURITY_PUT_WORD(&output[4], t1);
+    CYMESH_SECURITY_PUT_WORD(&output[8], t2);
+    CYMESH_SECURITY_PUT_WORD(&output[12], t3);
+}
+
+#else
+
+/* One AES-128 block, byte oriented with the S-box as the only table */
+static void CyMesh_SecurityPVTAesBlock(const uint32 * roundKey, const uint8 * input, uint8 * output)
+{
+    uint8 state[CYMESH_SECURITY_CCM_BLOCK_SIZE];
+    uint8 shifted[CYMESH_SECURITY_CCM_BLOCK_SIZE];
+    uint8 round;
+    uint8 column;
+    uint8 row;
+    uint8 all;
+    uint8 a0;
+
+    for(column = 0; column < 4u; column++)
+    {
+        for(row = 0; row < 4u; row++)
+        {
+            state[(4u * column) + row] = input[(4u * column) + row] ^ (uint8)(roundKey[column] >> (24u - (8u * row)));
+        }
+    }
+
+    for(round = 1u; round <= CYMESH_SECURITY_AES_ROUNDS; round++)
+    {
+        roundKey += 4;
+
+        /* SubBytes and ShiftRows: row r of column c comes from column c + r */
+        for(column = 0; column < 4u; column++)
+        {
+            for(row = 0; row < 4u; row++)
+            {
+                shifted[(4u * column) + row] = cyMesh_SecurityAesSbox[state[(4u * ((column + row) & 0x03u)) + row]];
+            }
+        }
+
+        for(column = 0; column < 4u; column++)
+        {
+            uint8 * col = &shifted[4u * column];
+
+            if(round != CYMESH_SECURITY_AES_ROUNDS)
+            {
+                all = col[0] ^ col[1] ^ col[2] ^ col[3];
+                a0 = col[0];
+                col[0] ^= all ^ CYMESH_SECURITY_XTIME(col[0] ^ col[1]);
+                col[1] ^= all ^ CYMESH_SECURITY_XTIME(col[1] ^ col[2]);
+                col[2] ^= all ^ CYMESH_SECURITY_XTIME(col[2] ^ col[3]);
+                col[3] ^= all ^ CYMESH_SECURITY_XTIME(col[3] ^ a0);
+            }
+
+            for(row = 0; row < 4u; row++)
+            {
+                state[(4u * column) + row] = col[row] ^ (uint8)(roundKey[column] >> (24u - (8u * row)));
+            }
+        }
+    }
+
+    memcpy(output, state, CYMESH_SECURITY_CCM_BLOCK_SIZE);
+}
+
+#endif  /* (CYMESH_SECURITY_AES_CORE == CYMESH_SECURITY_AES_CORE_TTABLE) */
+
+
+/******************************************************************************
+* Function Name: CyMesh_SecurityPVTAesCcm
+*******************************************************************************
+*
+*  AES-CCM (RFC 3610) with a 13 byte nonce and a 2 byte length field. Every
+*  16 byte block of the payload is encrypted or decrypted with the CTR
+*  keystream and added to the CBC-MAC in the same iteration. The output may be
+*  the input buffer.
+*
+*  \param bool: true to decrypt, false to encrypt. The CBC-MAC always covers
+*               the plaintext.
+*
+*  \param uint8*: the encrypted MIC, micLen bytes.
+*
+*  \return none
+*
+******************************************************************************/
+static void CyMesh_SecurityPVTAesCcm(
+    const uint8 * key,
+    const uint8 * nonce,
+    const uint8 * input,
+    uint8 length,
+    const uint8 * additionalData,
+    uint8 additionalDataLength,
+    uint8 * output,
+    uint8 * mic,
+    uint8 micLen,
+    bool isDecryption)
+{
+    const uint32 * roundKey = CyMesh_SecurityPVTAesGetRoundKey(key);
+    uint8 cbcMac[CYMESH_SECURITY_CCM_BLOCK_SIZE];
+    uint8 counter[CYMESH_SECURITY_CCM_BLOCK_SIZE];
+    uint8 keyStream[CYMESH_SECURITY_CCM_BLOCK_SIZE];
+    uint8 position;
+    uint8 plain;
+    uint8 i;
+
+    /* B0: flags, nonce and payload length */
+    cbcMac[0] = (uint8)(((additionalDataLength != 0u) ? CYMESH_SECURITY_CCM_FLAGS_ADATA : 0u) |
+                        ((uint8)((micLen - 2u) >> 1) << 3) | CYMESH_SECURITY_CCM_FLAGS_L);
+    memcpy(&cbcMac[1], nonce, CYMESH_SECURITY_CCM_NONCE_SIZE);
+    cbcMac[14] = 0u;
+    cbcMac[15] = length;
+    CyMesh_SecurityPVTAesBlock(roundKey, cbcMac, cbcMac);
+
+    /* B1..: additional data with its 2 byte length, zero padded */
+    if(additionalDataLength != 0u)
+    {
+        cbcMac[1] ^= additionalDataLength;
+        position = 2u;
+        for(i = 0; i < additionalDataLength; i++)
+        {
+            cbcMac[position] ^= additionalData[i];
+            position++;
+            if(position == CYMESH_SECURITY_CCM_BLOCK_SIZE)
+            {
+                CyMesh_SecurityPVTAesBlock(roundKey, cbcMac, cbcMac);
+                position = 0u;
+            }
+        }
+        if(position != 0u)
+        {
+            CyMesh_SecurityPVTAesBlock(roundKey, cbcMac, cbcMac);
+        }
+    }
+
+    /* A1..: payload, zero padded in the CBC-MAC */
+    counter[0] = CYMESH_SECURITY_CCM_FLAGS_L;
+    memcpy(&counter[1], nonce, CYMESH_SECURITY_CCM_NONCE_SIZE);
+    counter[14] = 0u;
+    counter[15] = 0u;
+
+    position = CYMESH_SECURITY_CCM_BLOCK_SIZE;
+    for(i = 0; i < length; i++)
+    {
+        if(position == CYMESH_SECURITY_CCM_BLOCK_SIZE)
+        {
+            counter[15]++;
+            CyMesh_SecurityPVTAesBlock(roundKey, counter, keyStream);
+            position = 0u;
+        }
+
+        plain = (isDecryption == true) ? (input[i] ^ keyStream[position]) : input[i];
+        output[i] = input[i] ^ keyStream[position];
+        cbcMac[position] ^= plain;
+        position++;
+
+        if(position == CYMESH_SECURITY_CCM_BLOCK_SIZE)
+        {
+            CyMesh_SecurityPVTAesBlock(roundKey, cbcMac, cbcMac);
+        }
+    }
+    if(position != CYMESH_SECURITY_CCM_BLOCK_SIZE)
+    {
+        CyMesh_SecurityPVTAesBlock(roundKey, cbcMac, cbcMac);
+    }
+
+    /* A0 encrypts the MIC */
+    counter[15] = 0u;
+    CyMesh_SecurityPVTAesBlock(roundKey, counter, keyStream);
+    for(i = 0; i < micLen; i++)
+    {
+        mic[i] = cbcMac[i] ^ keyStream[i];
+    }
+}
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+void CyMesh_SecurityPVTSwapMsbLsb(uint8 *bytes, uint8 len)
+{
+    uint8 temp;
+    uint8 i;
+
+    for(i = 0; i < (len >> 1); i++)
+    {
+        temp = bytes[i];
+        bytes[i] = bytes[len - 1u - i];
+        bytes[len - 1u - i] = temp;
+    }
+}
+
+
+CYMESH_API_RETURN_T CyMesh_SecurityPVTAesEncrypt(const uint8 * input, const uint8 * key, uint8 * output)
+{
+    CyMesh_SecurityPVTAesBlock(CyMesh_SecurityPVTAesGetRoundKey(key), input, output);
+
+    return CYMESH_ERROR_OK;
+}
+
+
+CYMESH_API_RETURN_T CyMesh_SecurityAesCcmEncryption(
+    const uint8 * key,
+    const uint8 * nonce,
+    const uint8 * payload,
+    uint8 payloadLength,
+    const uint8 * additionalData,
+    uint8 additionalDataLength,
+    uint8 * outputData,
+    uint8 * mic,
+	uint8 micLen)
+{
+    if(micLen > CYMESH_SECURITY_CCM_BLOCK_M_8)
+    {
+        return CYMESH_ERROR_AES_CCM_ENCRYPTION_FAILED;
+    }
+
+    CyMesh_SecurityPVTAesCcm(key, nonce, payload, payloadLength, additionalData, additionalDataLength,
+                             outputData, mic, micLen, false);
+
+    return CYMESH_ERROR_OK;
+}
+
+
+CYMESH_API_RETURN_T CyMesh_SecurityAesCcmDecryption(
+    const uint8 * key,
+    const uint8 * nonce,
+    const uint8 * encPayload,
+    uint8 encPayloadLength,
+    const uint8 * additionalData,
+    uint8 additionalDataLength,
+    uint8 *outputData,
+    const uint8 * encMic,
+	uint8 micLen)
+{
+    uint8 mic[CYMESH_SECURITY_CCM_BLOCK_M_8];
+    uint8 difference = 0u;
+    uint8 i;
+
+    if(micLen > CYMESH_SECURITY_CCM_BLOCK_M_8)
+    {
+        return CYMESH_ERROR_AES_CCM_DECRYPTION_FAILED;
+    }
+
+    CyMesh_SecurityPVTAesCcm(key, nonce, encPayload, encPayloadLength, additionalData, additionalDataLength,
+                             outputData, mic, micLen, true);
+
+    /* Compare every byte, so the time taken does not depend on the MIC */
+    for(i = 0; i < micLen; i++)
+    {
+        difference |= (uint8)(mic[i] ^ encMic[i]);
+    }
+
+    return (difference == 0u) ? CYMESH_ERROR_OK : CYMESH_ERROR_AES_CCM_DECRYPTION_FAILED;
+}
+
+/* [] END OF FILE */
@@ -27,6 +27,27 @@
 #define CYMESH_SECURITY_CCM_BLOCK_SIZE          (16)
 #define CYMESH_SECURITY_CCM_BLOCK_M_4            (4)
 #define CYMESH_SECURITY_CCM_BLOCK_M_8            (8)
+
+/*******************************************************************************
+* Compile Time Options
+*******************************************************************************/
+/* AES-128 core of CyMesh_SecurityPVT.c. The T-table core needs 1 KB more flash
+ * than the compact core, which only uses the 256 byte S-box, and is several
+ * times faster. */
+#define CYMESH_SECURITY_AES_CORE_COMPACT         (0)
+#define CYMESH_SECURITY_AES_CORE_TTABLE          (1)
+
+#if !defined(CYMESH_SECURITY_AES_CORE)
+    #define CYMESH_SECURITY_AES_CORE             (CYMESH_SECURITY_AES_CORE_TTABLE)
+#endif
+
+/* Number of expanded keys kept in RAM, 192 bytes each: the encryption and
+ * privacy keys of every network key, and the application keys. With 0, every
+ * call expands its key once. */
+#if !defined(CYMESH_SECURITY_AES_KEY_CACHE_SIZE)
+    #define CYMESH_SECURITY_AES_KEY_CACHE_SIZE   ((2 * CYMESH_MAX_NETWORK_KEYS) + CYMESH_MAX_APPLICATION_KEYS)
+#endif
+
 /*******************************************************************************
 * Externed functions 
 *******************************************************************************/
@@ -49,8 +70,9 @@ extern void CyMesh_SecurityPVTSwapMsbLsb(uint8 *bytes, uint8 len);
 * Function Name: CyMesh_SecurityPVTAesEncrypt
 *******************************************************************************
 * 
-*  This function triggers the hardware AES ECB block.
-* 
+*  This function runs one AES-128 ECB block in software, with the expanded key
+*  taken from the key cache.
+*
 *  \param const uint8*: Input array to the AES block. The size is assumed to be 
 *						16 bytes
 *
@@ -0,0 +1,569 @@
+/***************************************************************************//**
+* \file CyMesh_Transport.c
+* \version 1.0
+*
+* \brief
+*  This file contains the transport layer of the BLE SmartMesh v1 solution. It
+*  replaces the CyMesh_Transport object of SM_LIB_256K.a and keeps its
+*  interface to the application and network layers: an application payload of
+*  up to CYMESH_APP_MAX_DATA_LEN bytes is encrypted with an application or
+*  device key and handed to the network layer with the next sequence number.
+*
+*  With CYMESH_ENABLE_SEGMENTATION, CyMesh_TransportSendSegmented() sends a
+*  message of up to CYMESH_TRANSPORT_SAR_MAX_LEN bytes in segments with block
+*  acknowledgements (see CyMesh_TransportSar.c). Each segment is an
+*  application payload of its own, with its own SEQ and MICapp: the library
+*  security layer encrypts at most one network PDU of payload, and the
+*  transport header has no spare bits, so segments are told from the
+*  application messages by their first byte, the reserved opcode 0x7F. The SM
+*  timer sends the segments and the acknowledgements that are due, and
+*  reassembled messages go to the callback of
+*  CyMesh_TransportSetSegmentedCallback(), as the application layer only takes
+*  single PDU messages.
+*
+*  Tools/network_bench/interop_check.c checks the PDUs sent and delivered
+*  against the library object. Remove this file from the project to link the
+*  library version again.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <string.h>
+#include "CyMesh_Transport.h"
+#include "CyMesh_Network.h"
+#include "CyMesh_Bearer.h"
+#include "CyMesh_Security.h"
+#include "CyMesh_Configuration.h"
+#include "CyMesh_Timer.h"
+
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+#define CYMESH_TRAN_HEADER_AKF                  (1u)    /* AKF (1 bit) */
+#define CYMESH_TRAN_HEADER_AID_SEQ              (2u)    /* AID (3 bits), SEQ (5 bits) */
+#define CYMESH_TRAN_HEADER_SRC                  (5u)
+#define CYMESH_TRAN_HEADER_DST                  (7u)
+#define CYMESH_TRAN_PAYLOAD                     (9u)
+
+#define CYMESH_TRAN_MIC_APP_SIZE                (4u)
+#define CYMESH_TRAN_OVERHEAD                    (CYMESH_TRAN_PAYLOAD + CYMESH_TRAN_MIC_APP_SIZE)
+#define CYMESH_TRAN_PDU_SIZE                    (32u)
+
+#define CYMESH_TRAN_AKF_SHIFT                   (7u)
+#define CYMESH_TRAN_AID_SHIFT                   (5u)
+#define CYMESH_TRAN_AID_MASK                    (0x07u)
+#define CYMESH_TRAN_SEQ_HIGH_MASK               (0x1Fu)
+#define CYMESH_TRAN_SEQ_MAX                     (0x001FFFFFu)
+#define CYMESH_TRAN_MAX_NETWORK_KEY_INDEX       (1u)
+
+#define CYMESH_TRAN_ADDR_GROUP_MASK             (0x8000u)
+
+#define CYMESH_TRAN_GET_UINT16(p)               ((uint16)(((uint16)(p)[0] << 8) | (p)[1]))
+
+
+
+/*******************************************************************************
+* Data Structures
+*******************************************************************************/
+
+/* Peer device key of the configuration client, from CyMesh_ConfigurationModel */
+extern bool isPeerDeviceKeyValid;
+extern uint8 peerDeviceKey[];
+
+/* Application layer callback, set in CyMesh_TransportStart() */
+static CYMESH_CALLBACK_T cyMesh_appCallback;
+
+/* SEQ of the last PDU sent */
+static uint32 CyMesh_sequenceNumber;
+
+/* Reentrancy guards of CyMesh_TransportCallback() and of the send path */
+static struct
+{
+    uint8 process;
+    uint8 send;
+} transportMutex;
+
+#if (CYMESH_ENABLE_SEGMENTATION == 1)
+/* Message being sent in segments, and messages being reassembled */
+CYMESH_TRANSPORT_SAR_STRUCT transport_sar;
+
+/* Parameters of CyMesh_TransportSendSegmented(), for every segment */
+static struct
+{
+    uint8 txCount;
+    bool akf;
+    bool isOwnOrPeerDevKey;
+    bool fut;
+    uint8 ttl;
+    uint16 src;
+    uint16 dst;
+    uint8 netKeyIndex;
+    uint8 appKeyIndex;
+} transportSarTx;
+
+/* Callback of the reassembled messages */
+static CYMESH_CALLBACK_T cyMesh_segmentedCallback;
+#endif
+
+
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+
+/* Takes one of the transportMutex flags. Returns false if it is already taken. */
+static bool CyMesh_TransportLock(uint8 * mutex)
+{
+    uint8 interruptState = CyEnterCriticalSection();
+    bool isLocked = false;
+
+    if(*mutex == 0u)
+    {
+        *mutex = 1u;
+        isLocked = true;
+    }
+
+    CyExitCriticalSection(interruptState);
+
+    return isLocked;
+}
+
+
+/* Moves to the next SEQ. seq_num in flash stays ahead of it by
+ * CYMESH_TRAN_SEQNO_FLASH_INCREMENT_VALUE, so that a reset never reuses one. */
+static void CyMesh_UpdateSequenceNumber(void)
+{
+    CyMesh_sequenceNumber++;
+    if(CyMesh_sequenceNumber > CYMESH_TRAN_SEQ_MAX)
+    {
+        CyMesh_sequenceNumber = 0u;
+        cyMesh_ConfigInfoRam.seq_num = 0u;
+    }
+
+    if(cyMesh_ConfigInfoRam.seq_num <= CyMesh_sequenceNumber)
+    {
+        cyMesh_ConfigInfoRam.seq_num = CyMesh_sequenceNumber + CYMESH_TRAN_SEQNO_FLASH_INCREMENT_VALUE;
+        if(cyMesh_ConfigInfoRam.seq_num > CYMESH_TRAN_SEQ_MAX)
+        {
+            cyMesh_ConfigInfoRam.seq_num = CYMESH_TRAN_SEQNO_FLASH_INCREMENT_VALUE;
+            (void)CyMesh_SecurityUpdateCredentials();
+        }
+        (void)CyMesh_ConfigurationSave();
+    }
+}
+
+
+/******************************************************************************
+* Function Name: CyMesh_TransportSend
+*******************************************************************************
+*
+*  Builds, encrypts and sends a transport PDU. The caller holds
+*  transportMutex.send and has checked the parameters and the bearer buffer.
+*  See CyMesh_TransportSendData() for the parameters.
+*
+******************************************************************************/
+static CYMESH_API_RETURN_T CyMesh_TransportSend(const uint8 * data, uint8 length, uint8 txCount, bool akf,
+                                                bool isOwnOrPeerDevKey, bool fut, uint8 ttl, uint16 src,
+                                                uint16 dst, uint8 netKeyIndex, uint8 appKeyIndex)
+{
+    uint8 packet[CYMESH_TRAN_PDU_SIZE];
+    uint8 aid = 0u;
+    CYMESH_API_RETURN_T result;
+
+    packet[0] = 0u;
+    packet[CYMESH_TRAN_HEADER_AKF] = (uint8)(akf << CYMESH_TRAN_AKF_SHIFT);
+    if(akf == true)
+    {
+        aid = cyMesh_ConfigInfoRam.appInfo.appKeys[appKeyIndex].applicationId[15] & CYMESH_TRAN_AID_MASK;
+    }
+
+    CyMesh_UpdateSequenceNumber();
+    packet[CYMESH_TRAN_HEADER_AID_SEQ] = (uint8)(((CyMesh_sequenceNumber >> 16) & CYMESH_TRAN_SEQ_HIGH_MASK) |
+                                                 (aid << CYMESH_TRAN_AID_SHIFT));
+    packet[CYMESH_TRAN_HEADER_AID_SEQ + 1u] = (uint8)(CyMesh_sequenceNumber >> 8);
+    packet[CYMESH_TRAN_HEADER_AID_SEQ + 2u] = (uint8)CyMesh_sequenceNumber;
+    packet[CYMESH_TRAN_HEADER_SRC] = (uint8)(src >> 8);
+    packet[CYMESH_TRAN_HEADER_SRC + 1u] = (uint8)src;
+    packet[CYMESH_TRAN_HEADER_DST] = (uint8)(dst >> 8);
+    packet[CYMESH_TRAN_HEADER_DST + 1u] = (uint8)dst;
+    memcpy(&packet[CYMESH_TRAN_PAYLOAD], data, length);
+
+    result = CyMesh_SecurityEncryptAppData(netKeyIndex, appKeyIndex, akf, isOwnOrPeerDevKey, peerDeviceKey,
+                                           &packet[CYMESH_TRAN_HEADER_AKF], length);
+    if(result != CYMESH_ERROR_OK)
+    {
+        return result;
+    }
+
+    return CyMesh_NetworkSendData(packet, length + CYMESH_TRAN_OVERHEAD, txCount, akf, fut, ttl, netKeyIndex, 1u);
+}
+
+
+#if (CYMESH_ENABLE_SEGMENTATION == 1)
+/* Takes a decrypted segment or block acknowledgement. The caller holds
+ * transportMutex.process. */
+static void CyMesh_TransportSarReceive(const CYMESH_TRANSPORT_PKT_T * pkt, uint16 dst, bool isPeerDevKey)
+{
+    CYMESH_TRANSPORT_SAR_RX_T * rx;
+    CYMESH_TRANSPORT_PKT_T message;
+    uint32 now = CyMesh_TimerGetTimestamp();
+    bool isComplete;
+
+    if((pkt->length > 1u) && ((pkt->data[1] & CYMESH_TRANSPORT_SAR_ACK_FLAG) != 0u))
+    {
+        if(pkt->srcAddress == transportSarTx.dst)
+        {
+            CyMesh_TransportSarTxAck(&transport_sar, pkt->data, pkt->length, now);
+        }
+        return;
+    }
+
+    rx = CyMesh_TransportSarRxSegment(&transport_sar, pkt->srcAddress, pkt->data, pkt->length, now, &isComplete);
+    if(rx == NULL)
+    {
+        return;
+    }
+
+    /* The acknowledgement goes back under the key of the message, to the
+     * source of a message sent to this node only */
+    rx->isAckWanted = ((dst & CYMESH_TRAN_ADDR_GROUP_MASK) == 0u);
+    rx->isAppKeyUsed = pkt->isAppKeyUsed;
+    rx->isPeerDevKey = isPeerDevKey;
+    rx->netKeyIndex = pkt->netKeyIndex;
+    rx->appKeyIndex = pkt->appKeyIndex;
+    rx->dst = dst;
+
+    if((isComplete == true) && (cyMesh_segmentedCallback != NULL))
+    {
+        message = *pkt;
+        message.data = rx->data;
+        message.length = rx->length;
+        (void)cyMesh_segmentedCallback(CYMESH_TRANSPORT_SEGMENTED_PKT, &message);
+    }
+}
+#endif
+
+
+/******************************************************************************
+* Function Name: CyMesh_TransportCallback
+*******************************************************************************
+*
+*  Network layer callback: decrypts a transport PDU with the device keys or
+*  with each application key its AID matches, and passes the payload up.
+*
+*  \param uint32: CYMESH_NETWORK_CALLBACK_T event
+*
+*  \param void*: CYMESH_NETWORK_PKT_T of the PDU
+*
+*  \return CYMESH_API_RETURN_T: CYMESH_ERROR_THREAD_BUSY while a PDU is being
+*          processed, CYMESH_ERROR_TRANSPORT_INVALID_PACKET_LENGTH,
+*          CYMESH_ERROR_AES_CCM_DECRYPTION_FAILED if no key fits,
+*          CYMESH_ERROR_OK otherwise.
+*
+******************************************************************************/
+static CYMESH_API_RETURN_T CyMesh_TransportCallback(uint32 event, void * eventParam)
+{
+    CYMESH_NETWORK_PKT_T * networkPkt = (CYMESH_NETWORK_PKT_T *)eventParam;
+    CYMESH_TRANSPORT_PKT_T transportPkt;
+    uint8 appKeyIndexes[CYMESH_MAX_APPLICATION_KEYS];
+    CYMESH_API_RETURN_T result = CYMESH_ERROR_OK;
+    uint8 * data;
+    uint8 length;
+    bool akf;
+    bool isPeerDevKey = false;
+    uint8 keyCount;
+    uint8 i = 0u;
+
+    if(CyMesh_TransportLock(&transportMutex.process) == false)
+    {
+        return CYMESH_ERROR_THREAD_BUSY;
+    }
+
+    if(event != CYMESH_TRANSPORT_PKT)
+    {
+        transportMutex.process = 0u;
+        return CYMESH_ERROR_OK;
+    }
+
+    data = networkPkt->data;
+    length = networkPkt->length;
+    if((uint8)(length - CYMESH_TRAN_OVERHEAD) > (CYMESH_APP_MAX_DATA_LEN + CYMESH_TRAN_MIC_APP_SIZE))
+    {
+        transportMutex.process = 0u;
+        return CYMESH_ERROR_TRANSPORT_INVALID_PACKET_LENGTH;
+    }
+
+    akf = ((data[CYMESH_TRAN_HEADER_AKF] >> CYMESH_TRAN_AKF_SHIFT) != 0u);
+    if(akf == false)
+    {
+        /* The peer device key first, then the own one */
+        result = CYMESH_ERROR_AES_CCM_DECRYPTION_FAILED;
+        if(isPeerDeviceKeyValid == true)
+        {
+            result = CyMesh_SecurityDecryptAppData(networkPkt->mesh_id, 0u, true, true, peerDeviceKey,
+                                                   &data[CYMESH_TRAN_HEADER_AKF], length - CYMESH_TRAN_PAYLOAD);
+            isPeerDevKey = (result == CYMESH_ERROR_OK);
+        }
+        if(result != CYMESH_ERROR_OK)
+        {
+            result = CyMesh_SecurityDecryptAppData(networkPkt->mesh_id, 0u, true, false, NULL,
+                                                   &data[CYMESH_TRAN_HEADER_AKF], length - CYMESH_TRAN_PAYLOAD);
+        }
+    }
+    else
+    {
+        keyCount = CyMesh_SecurityFindAppKeyIndex(data[CYMESH_TRAN_HEADER_AID_SEQ] >> CYMESH_TRAN_AID_SHIFT,
+                                                  appKeyIndexes);
+        result = CYMESH_ERROR_AES_CCM_DECRYPTION_FAILED;
+        for(i = 0u; i < keyCount; i++)
+        {
+            result = CyMesh_SecurityDecryptAppData(networkPkt->mesh_id, appKeyIndexes[i], true, false, NULL,
+                                                   &data[CYMESH_TRAN_HEADER_AKF], length - CYMESH_TRAN_PAYLOAD);
+            if(result == CYMESH_ERROR_OK)
+            {
+                break;
+            }
+        }
+        if(keyCount == 0u)
+        {
+            i = 0u;
+        }
+    }
+
+    if(result == CYMESH_ERROR_OK)
+    {
+        transportPkt.data = &data[CYMESH_TRAN_PAYLOAD];
+        transportPkt.length = length - CYMESH_TRAN_OVERHEAD;
+        transportPkt.netKeyIndex = networkPkt->mesh_id;
+        transportPkt.appKeyIndex = i;
+        transportPkt.isAppKeyUsed = akf;
+        transportPkt.modelIndex = networkPkt->modelIndex;
+        transportPkt.componentIndex = networkPkt->componentIndex;
+        transportPkt.srcAddress = CYMESH_TRAN_GET_UINT16(&data[CYMESH_TRAN_HEADER_SRC]);
+
+    #if (CYMESH_ENABLE_SEGMENTATION == 1)
+        if(transportPkt.data[0] == CYMESH_TRANSPORT_SAR_MARKER)
+        {
+            CyMesh_TransportSarReceive(&transportPkt, CYMESH_TRAN_GET_UINT16(&data[CYMESH_TRAN_HEADER_DST]),
+                                       isPeerDevKey);
+        }
+        else
+    #else
+        (void)isPeerDevKey;
+    #endif
+        {
+            (void)cyMesh_appCallback(CYMESH_APPLICATION_PKT, &transportPkt);
+        }
+    }
+
+    transportMutex.process = 0u;
+
+    return result;
+}
+
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+CYMESH_API_RETURN_T CyMesh_TransportStart(CYMESH_CALLBACK_T appCallback)
+{
+    CYMESH_API_RETURN_T result = CYMESH_ERROR_INVALID_CALLBACK;
+
+    if(appCallback != NULL)
+    {
+        cyMesh_appCallback = appCallback;
+        result = CyMesh_NetworkStart(CyMesh_TransportCallback);
+    }
+
+    transportMutex.process = 0u;
+    transportMutex.send = 0u;
+    CyMesh_sequenceNumber = cyMesh_ConfigInfoRam.seq_num;
+#if (CYMESH_ENABLE_SEGMENTATION == 1)
+    CyMesh_TransportSarInit(&transport_sar);
+#endif
+
+    return result;
+}
+
+
+uint32 CyMesh_ReadSequenceNumber(void)
+{
+    return CyMesh_sequenceNumber;
+}
+
+
+CYMESH_API_RETURN_T CyMesh_TransportSendData(uint8 * data,
+                                             uint8 length,
+                                             uint8 txCount,
+                                             bool akf,
+                                             bool isOwnOrPeerDevKey,
+                                             bool fut,
+                                             uint8 ttl,
+                                             uint16 src,
+                                             uint16 dst,
+                                             uint8 netKeyIndex,
+                                             uint8 appKeyIndex)
+{
+    CYMESH_BEARER_TX_BUFFER_STATE_T bufferState;
+    CYMESH_API_RETURN_T result;
+
+    if(CyMesh_TransportLock(&transportMutex.send) == false)
+    {
+        return CYMESH_ERROR_THREAD_BUSY;
+    }
+
+    bufferState = CyMesh_BearerGetTxBufferStatus();
+    if((bufferState != CYMESH_BEARER_TX_BUFFER_EMPTY) && (bufferState != CYMESH_BEARER_TX_BUFFER_FREE))
+    {
+        result = CYMESH_ERROR_BEARER_TX_BUFFER_FULL;
+    }
+    else if(((uint8)(length - CYMESH_APP_MIN_DATA_LEN) > (CYMESH_APP_MAX_DATA_LEN - CYMESH_APP_MIN_DATA_LEN)) ||
+            (data == NULL) || (txCount == 0u) || (netKeyIndex > CYMESH_TRAN_MAX_NETWORK_KEY_INDEX))
+    {
+        result = CYMESH_ERROR_TRANSPORT_INVALID_PARAM;
+    }
+    else
+    {
+        result = CyMesh_TransportSend(data, length, txCount, akf, isOwnOrPeerDevKey, fut, ttl, src, dst,
+                                      netKeyIndex, appKeyIndex);
+    }
+
+    transportMutex.send = 0u;
+
+    return result;
+}
+
+
+#if (CYMESH_ENABLE_SEGMENTATION == 1)
+CYMESH_API_RETURN_T CyMesh_TransportSendSegmented(const uint8 * data,
+                                                  uint8 length,
+                                                  uint8 txCount,
+                                                  bool akf,
+                                                  bool isOwnOrPeerDevKey,
+                                                  bool fut,
+                                                  uint8 ttl,
+                                                  uint16 src,
+                                                  uint16 dst,
+                                                  uint8 netKeyIndex,
+                                                  uint8 appKeyIndex)
+{
+    CYMESH_API_RETURN_T result = CYMESH_ERROR_OK;
+    uint16 ackTimeout = 0u;
+
+    if((data == NULL) || (length == 0u) || (length > CYMESH_TRANSPORT_SAR_MAX_LEN) || (txCount == 0u) ||
+       (netKeyIndex > CYMESH_TRAN_MAX_NETWORK_KEY_INDEX))
+    {
+        return CYMESH_ERROR_TRANSPORT_INVALID_PARAM;
+    }
+
+    /* The SM timer sends the segments under the same guard */
+    if(CyMesh_TransportLock(&transportMutex.send) == false)
+    {
+        return CYMESH_ERROR_THREAD_BUSY;
+    }
+
+    if((dst & CYMESH_TRAN_ADDR_GROUP_MASK) == 0u)
+    {
+        ackTimeout = CYMESH_TRANSPORT_SAR_ACK_TIMEOUT_MS + ((uint16)ttl * CYMESH_TRANSPORT_SAR_ACK_TIMEOUT_TTL_MS);
+    }
+
+    if(CyMesh_TransportSarTxStart(&transport_sar, data, length, CYMESH_TRANSPORT_SAR_SEGMENT_INTERVAL_MS,
+                                  ackTimeout, CyMesh_TimerGetTimestamp()) == false)
+    {
+        result = CYMESH_ERROR_THREAD_BUSY;
+    }
+    else
+    {
+        transportSarTx.txCount = txCount;
+        transportSarTx.akf = akf;
+        transportSarTx.isOwnOrPeerDevKey = isOwnOrPeerDevKey;
+        transportSarTx.fut = fut;
+        transportSarTx.ttl = ttl;
+        transportSarTx.src = src;
+        transportSarTx.dst = dst;
+        transportSarTx.netKeyIndex = netKeyIndex;
+        transportSarTx.appKeyIndex = appKeyIndex;
+    }
+
+    transportMutex.send = 0u;
+
+    return result;
+}
+
+
+void CyMesh_TransportSetSegmentedCallback(CYMESH_CALLBACK_T callback)
+{
+    cyMesh_segmentedCallback = callback;
+}
+
+
+CYMESH_TRANSPORT_SAR_TX_STATE_T CyMesh_TransportSegmentedStatus(void)
+{
+    return (CYMESH_TRANSPORT_SAR_TX_STATE_T)transport_sar.tx.state;
+}
+
+
+/* SM timer tick, see CyMesh_SMHandleTimer(). A PDU the network layer does
+ * not take is lost as if on air; the acknowledgements recover it. */
+void CyMesh_TransportSarUpdate(void)
+{
+    uint8 pdu[CYMESH_TRANSPORT_SAR_PDU_LEN];
+    CYMESH_TRANSPORT_SAR_RX_T * rx;
+    CYMESH_BEARER_TX_BUFFER_STATE_T bufferState;
+    uint32 now;
+    uint8 length;
+
+    /* Not while a PDU is received or sent from the main loop */
+    if(transportMutex.process != 0u)
+    {
+        return;
+    }
+    if(CyMesh_TransportLock(&transportMutex.send) == false)
+    {
+        return;
+    }
+
+    bufferState = CyMesh_BearerGetTxBufferStatus();
+    if((bufferState == CYMESH_BEARER_TX_BUFFER_EMPTY) || (bufferState == CYMESH_BEARER_TX_BUFFER_FREE))
+    {
+        now = CyMesh_TimerGetTimestamp();
+
+        /* One PDU per tick, the acknowledgements first */
+        length = CyMesh_TransportSarRxAck(&transport_sar, now, pdu, &rx);
+        if(length != 0u)
+        {
+            (void)CyMesh_TransportSend(pdu, length, 1u, rx->isAppKeyUsed, rx->isPeerDevKey, false,
+                                       cyMesh_ConfigInfoRam.deviceInfo.deviceDefaultTtl, rx->dst, rx->src,
+                                       rx->netKeyIndex, rx->appKeyIndex);
+        }
+        else
+        {
+            length = CyMesh_TransportSarTxNext(&transport_sar, now, pdu);
+            if(length != 0u)
+            {
+                (void)CyMesh_TransportSend(pdu, length, transportSarTx.txCount, transportSarTx.akf,
+                                           transportSarTx.isOwnOrPeerDevKey, transportSarTx.fut,
+                                           transportSarTx.ttl, transportSarTx.src, transportSarTx.dst,
+                                           transportSarTx.netKeyIndex, transportSarTx.appKeyIndex);
+            }
+        }
+    }
+
+    transportMutex.send = 0u;
+}
+#endif
+
+/* [] END OF FILE */
@@ -24,6 +24,7 @@
 *******************************************************************************/
 #include "project.h"
 #include <CyMesh_Common.h>    
+#include "CyMesh_TransportSar.h"
 
     
 /*******************************************************************************
@@ -54,7 +55,10 @@ typedef struct
 
 typedef enum
 {
-	CYMESH_APPLICATION_PKT = 0x01
+	CYMESH_APPLICATION_PKT = 0x01,
+
+    /* A message reassembled from segments, see CyMesh_TransportSetSegmentedCallback() */
+    CYMESH_TRANSPORT_SEGMENTED_PKT = 0x02
 } CYMESH_TRANSPORT_CALLBACK_T;
 
 
@@ -140,6 +144,67 @@ CYMESH_API_RETURN_T CyMesh_TransportSendData(uint8 * data,
 ******************************************************************************/
 uint32 CyMesh_ReadSequenceNumber(void);
 
+#if (CYMESH_ENABLE_SEGMENTATION == 1)
+/******************************************************************************
+* Function Name: CyMesh_TransportSendSegmented
+*******************************************************************************
+* 
+*  This function takes a message of up to CYMESH_TRANSPORT_SAR_MAX_LEN bytes,
+* which the SM timer sends in segments. A message to a unicast address is
+* acknowledged by its destination, and the segments it misses are sent again;
+* a message to a group is sent CYMESH_TRANSPORT_SAR_UNACKED_PASSES times.
+* CyMesh_TransportSegmentedStatus() tells when the message is done.
+* 
+*  \param: the parameters of CyMesh_TransportSendData(), for every segment
+*
+*  \return CYMESH_API_RETURN_T: CYMESH_ERROR_OK if the message was taken,
+*								CYMESH_ERROR_THREAD_BUSY while another one is
+*								sent, CYMESH_ERROR_TRANSPORT_INVALID_PARAM
+* 
+******************************************************************************/
+CYMESH_API_RETURN_T CyMesh_TransportSendSegmented(const uint8 * data, 
+													uint8 length, 
+													uint8 txCount, 
+													bool akf,
+                                                    bool isOwnOrPeerDevKey,
+													bool fut,
+													uint8 ttl,
+													uint16 src,
+													uint16 dst,
+													uint8 netKeyIndex, 
+													uint8 appKeyIndex);
+
+/******************************************************************************
+* Function Name: CyMesh_TransportSetSegmentedCallback
+*******************************************************************************
+* 
+*  This function sets the function called with CYMESH_TRANSPORT_SEGMENTED_PKT
+* and a CYMESH_TRANSPORT_PKT_T for each message reassembled. The data is only
+* valid during the call.
+* 
+*  \param CYMESH_CALLBACK_T: callback, NULL to drop the messages
+*
+*  \return None
+* 
+******************************************************************************/
+void CyMesh_TransportSetSegmentedCallback(CYMESH_CALLBACK_T callback);
+
+/******************************************************************************
+* Function Name: CyMesh_TransportSegmentedStatus
+*******************************************************************************
+* 
+*  This function returns the state of the last message of
+* CyMesh_TransportSendSegmented().
+* 
+*  \return CYMESH_TRANSPORT_SAR_TX_STATE_T: CYMESH_TRANSPORT_SAR_TX_DONE once
+*								every segment was acknowledged, or every pass
+*								to a group sent, CYMESH_TRANSPORT_SAR_TX_FAILED
+*								after the last retry
+* 
+******************************************************************************/
+CYMESH_TRANSPORT_SAR_TX_STATE_T CyMesh_TransportSegmentedStatus(void);
+#endif
+
 #endif /* End of #if !defined (CYMESH_TRANSPORT_H) */
 
 /* [] END OF FILE */
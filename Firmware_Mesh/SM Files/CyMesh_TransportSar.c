@@ -0,0 +1,407 @@
+/***************************************************************************//**
+* \file CyMesh_TransportSar.c
+* \version 1.0
+*
+* \brief
+*  This file contains the segmentation and reassembly of the BLE SmartMesh v1
+*  transport layer.
+*
+*  A transport PDU carries CYMESH_APP_MAX_DATA_LEN bytes, so a longer message
+*  is cut into segments of CYMESH_TRANSPORT_SAR_SEGMENT_LEN bytes, each sent as
+*  an application payload of its own, CYMESH_TRANSPORT_SAR_SEGMENT_INTERVAL_MS
+*  apart. The receiver keeps one bit per segment and answers a message to its
+*  unicast address with a block acknowledgement carrying the bitmap: at once
+*  when the message is complete, or CYMESH_TRANSPORT_SAR_ACK_DELAY_MS after
+*  the last segment heard when it is not. The sender then only sends again
+*  the segments the bitmap does not have, so a lost segment costs one
+*  segment and not the whole message. A message to a group is not
+*  acknowledged and goes out CYMESH_TRANSPORT_SAR_UNACKED_PASSES times.
+*
+*  A complete message stays in its reassembly buffer for
+*  CYMESH_TRANSPORT_SAR_RX_TIMEOUT_MS, so that a copy of a segment sent again
+*  because the acknowledgement was lost is acknowledged again and not taken
+*  for a new message.
+*
+*  Tools/network_bench/sar_sim.c simulates the goodput and the airtime of
+*  segmented messages against these options.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <stddef.h>
+#include <string.h>
+#include "CyMesh_TransportSar.h"
+
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+#define CYMESH_TRANSPORT_SAR_SEG_O_SHIFT        (4u)
+#define CYMESH_TRANSPORT_SAR_SEG_N_MASK         (0x0Fu)
+
+/* Bits of the segments 0 to lastSegment */
+#define CYMESH_TRANSPORT_SAR_ALL(lastSegment)   ((uint16)((2uL << (lastSegment)) - 1u))
+
+
+
+/*******************************************************************************
+* Private functions
+*******************************************************************************/
+
+static bool CyMesh_TransportSarIsDue(uint32 now, uint32 due)
+{
+    return ((int32)(now - due) >= 0);
+}
+
+
+/* Starts a pass over the segments not acknowledged, or ends the message if
+ * no pass is left */
+static void CyMesh_TransportSarTxRetry(CYMESH_TRANSPORT_SAR_STRUCT * sar, uint32 now)
+{
+    CYMESH_TRANSPORT_SAR_TX_T * tx = &sar->tx;
+
+    if(tx->passes == 0u)
+    {
+        tx->state = CYMESH_TRANSPORT_SAR_TX_FAILED;
+        sar->stats.failed++;
+        return;
+    }
+
+    tx->passes--;
+    tx->toSend = tx->pending;
+    tx->state = CYMESH_TRANSPORT_SAR_TX_SENDING;
+    tx->due = now;
+}
+
+
+/* Buffer of the message msgId from src, NULL if there is none */
+static CYMESH_TRANSPORT_SAR_RX_T * CyMesh_TransportSarRxFind(CYMESH_TRANSPORT_SAR_STRUCT * sar, uint16 src,
+                                                             uint8 msgId)
+{
+    uint8 i;
+
+    for(i = 0u; i < CYMESH_TRANSPORT_SAR_RX_POOL_SIZE; i++)
+    {
+        if((sar->rx[i].state != CYMESH_TRANSPORT_SAR_RX_FREE) && (sar->rx[i].src == src) &&
+           (sar->rx[i].msgId == msgId))
+        {
+            return &sar->rx[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+/* Buffer for a new message from src: the one of a message src gave up on, a
+ * free one, or the oldest complete one. NULL if every buffer is assembling a
+ * message from another source. */
+static CYMESH_TRANSPORT_SAR_RX_T * CyMesh_TransportSarRxTake(CYMESH_TRANSPORT_SAR_STRUCT * sar, uint16 src)
+{
+    CYMESH_TRANSPORT_SAR_RX_T * taken = NULL;
+    uint8 i;
+
+    for(i = 0u; i < CYMESH_TRANSPORT_SAR_RX_POOL_SIZE; i++)
+    {
+        CYMESH_TRANSPORT_SAR_RX_T * rx = &sar->rx[i];
+
+        if((rx->state == CYMESH_TRANSPORT_SAR_RX_ASSEMBLING) && (rx->src == src))
+        {
+            /* A sender has one message at a time */
+            return rx;
+        }
+        if(rx->state == CYMESH_TRANSPORT_SAR_RX_FREE)
+        {
+            taken = rx;
+        }
+        else if((rx->state == CYMESH_TRANSPORT_SAR_RX_COMPLETE) &&
+                ((taken == NULL) ||
+                 ((taken->state == CYMESH_TRANSPORT_SAR_RX_COMPLETE) && ((int32)(rx->heard - taken->heard) < 0))))
+        {
+            taken = rx;
+        }
+    }
+
+    return taken;
+}
+
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+void CyMesh_TransportSarInit(CYMESH_TRANSPORT_SAR_STRUCT * sar)
+{
+    memset(sar, 0, sizeof(*sar));
+}
+
+
+bool CyMesh_TransportSarTxStart(CYMESH_TRANSPORT_SAR_STRUCT * sar, const uint8 * data, uint8 length,
+                                uint16 interval, uint16 ackTimeout, uint32 now)
+{
+    CYMESH_TRANSPORT_SAR_TX_T * tx = &sar->tx;
+
+    if((tx->state == CYMESH_TRANSPORT_SAR_TX_SENDING) || (tx->state == CYMESH_TRANSPORT_SAR_TX_WAITING) ||
+       (length == 0u) || (length > CYMESH_TRANSPORT_SAR_MAX_LEN))
+    {
+        return false;
+    }
+
+    memcpy(tx->data, data, length);
+    tx->length = length;
+    tx->lastSegment = (length - 1u) / CYMESH_TRANSPORT_SAR_SEGMENT_LEN;
+    tx->msgId = sar->nextMsgId & CYMESH_TRANSPORT_SAR_MSG_ID_MASK;
+    sar->nextMsgId++;
+    tx->passes = (ackTimeout == 0u) ? (CYMESH_TRANSPORT_SAR_UNACKED_PASSES - 1u) : CYMESH_TRANSPORT_SAR_RETRIES;
+    tx->pending = CYMESH_TRANSPORT_SAR_ALL(tx->lastSegment);
+    tx->toSend = tx->pending;
+    tx->interval = interval;
+    tx->ackTimeout = ackTimeout;
+    tx->due = now;
+    tx->state = CYMESH_TRANSPORT_SAR_TX_SENDING;
+    sar->stats.sent++;
+
+    return true;
+}
+
+
+uint8 CyMesh_TransportSarTxNext(CYMESH_TRANSPORT_SAR_STRUCT * sar, uint32 now, uint8 * pdu)
+{
+    CYMESH_TRANSPORT_SAR_TX_T * tx = &sar->tx;
+    uint8 segment;
+    uint8 offset;
+    uint8 length;
+
+    if((tx->state == CYMESH_TRANSPORT_SAR_TX_WAITING) && (CyMesh_TransportSarIsDue(now, tx->due) == true))
+    {
+        /* No acknowledgement, or a lost one: the segments not acknowledged
+         * go again */
+        CyMesh_TransportSarTxRetry(sar, now);
+    }
+
+    if((tx->state != CYMESH_TRANSPORT_SAR_TX_SENDING) || (CyMesh_TransportSarIsDue(now, tx->due) == false))
+    {
+        return 0u;
+    }
+
+    for(segment = 0u; (tx->toSend & (1u << segment)) == 0u; segment++)
+    {
+    }
+
+    offset = segment * CYMESH_TRANSPORT_SAR_SEGMENT_LEN;
+    length = tx->length - offset;
+    if(length > CYMESH_TRANSPORT_SAR_SEGMENT_LEN)
+    {
+        length = CYMESH_TRANSPORT_SAR_SEGMENT_LEN;
+    }
+
+    pdu[0] = CYMESH_TRANSPORT_SAR_MARKER;
+    pdu[1] = tx->msgId;
+    pdu[2] = (uint8)((segment << CYMESH_TRANSPORT_SAR_SEG_O_SHIFT) | tx->lastSegment);
+    memcpy(&pdu[CYMESH_TRANSPORT_SAR_HEADER_LEN], &tx->data[offset], length);
+
+    sar->stats.segments++;
+    if(tx->passes != ((tx->ackTimeout == 0u) ? (CYMESH_TRANSPORT_SAR_UNACKED_PASSES - 1u) :
+                      CYMESH_TRANSPORT_SAR_RETRIES))
+    {
+        sar->stats.retransmitted++;
+    }
+
+    tx->toSend &= (uint16)~(1u << segment);
+    tx->due = now + tx->interval;
+    if(tx->toSend == 0u)
+    {
+        if(tx->ackTimeout != 0u)
+        {
+            tx->state = CYMESH_TRANSPORT_SAR_TX_WAITING;
+            tx->due = now + tx->ackTimeout;
+        }
+        else if(tx->passes == 0u)
+        {
+            tx->state = CYMESH_TRANSPORT_SAR_TX_DONE;
+        }
+        else
+        {
+            tx->passes--;
+            tx->toSend = tx->pending;
+        }
+    }
+
+    return CYMESH_TRANSPORT_SAR_HEADER_LEN + length;
+}
+
+
+void CyMesh_TransportSarTxAck(CYMESH_TRANSPORT_SAR_STRUCT * sar, const uint8 * pdu, uint8 length, uint32 now)
+{
+    CYMESH_TRANSPORT_SAR_TX_T * tx = &sar->tx;
+    uint16 bitmap;
+
+    if((length < CYMESH_TRANSPORT_SAR_ACK_LEN) || (pdu[0] != CYMESH_TRANSPORT_SAR_MARKER) ||
+       (pdu[1] != (CYMESH_TRANSPORT_SAR_ACK_FLAG | tx->msgId)) || (tx->ackTimeout == 0u) ||
+       ((tx->state != CYMESH_TRANSPORT_SAR_TX_SENDING) && (tx->state != CYMESH_TRANSPORT_SAR_TX_WAITING)))
+    {
+        return;
+    }
+
+    bitmap = (uint16)(((uint16)pdu[2] << 8) | pdu[3]);
+    tx->pending &= (uint16)~bitmap;
+    tx->toSend &= (uint16)~bitmap;
+
+    if(tx->pending == 0u)
+    {
+        tx->state = CYMESH_TRANSPORT_SAR_TX_DONE;
+        sar->stats.acked++;
+    }
+    else if(tx->state == CYMESH_TRANSPORT_SAR_TX_WAITING)
+    {
+        /* The receiver told what it misses, no need to wait for the timeout */
+        CyMesh_TransportSarTxRetry(sar, now);
+    }
+    else if(tx->toSend == 0u)
+    {
+        /* The rest of the pass was acknowledged meanwhile */
+        tx->state = CYMESH_TRANSPORT_SAR_TX_WAITING;
+        tx->due = now + tx->ackTimeout;
+    }
+}
+
+
+CYMESH_TRANSPORT_SAR_RX_T * CyMesh_TransportSarRxSegment(CYMESH_TRANSPORT_SAR_STRUCT * sar, uint16 src,
+                                                         const uint8 * pdu, uint8 length, uint32 now,
+                                                         bool * isComplete)
+{
+    CYMESH_TRANSPORT_SAR_RX_T * rx;
+    uint8 segment;
+    uint8 lastSegment;
+    uint8 dataLength;
+    uint8 offset;
+    uint16 bit;
+
+    *isComplete = false;
+
+    if((length <= CYMESH_TRANSPORT_SAR_HEADER_LEN) || (length > CYMESH_TRANSPORT_SAR_PDU_LEN) ||
+       (pdu[0] != CYMESH_TRANSPORT_SAR_MARKER) || ((pdu[1] & CYMESH_TRANSPORT_SAR_ACK_FLAG) != 0u))
+    {
+        return NULL;
+    }
+
+    segment = pdu[2] >> CYMESH_TRANSPORT_SAR_SEG_O_SHIFT;
+    lastSegment = pdu[2] & CYMESH_TRANSPORT_SAR_SEG_N_MASK;
+    dataLength = length - CYMESH_TRANSPORT_SAR_HEADER_LEN;
+    offset = segment * CYMESH_TRANSPORT_SAR_SEGMENT_LEN;
+
+    /* Every segment but the last is full, and the message fits the buffer */
+    if((segment > lastSegment) || ((segment < lastSegment) && (dataLength != CYMESH_TRANSPORT_SAR_SEGMENT_LEN)) ||
+       ((offset + dataLength) > CYMESH_TRANSPORT_SAR_MAX_LEN))
+    {
+        return NULL;
+    }
+
+    rx = CyMesh_TransportSarRxFind(sar, src, pdu[1]);
+    if(rx == NULL)
+    {
+        rx = CyMesh_TransportSarRxTake(sar, src);
+        if(rx == NULL)
+        {
+            sar->stats.dropped++;
+            return NULL;
+        }
+        memset(rx, 0, sizeof(*rx));
+        rx->src = src;
+        rx->msgId = pdu[1];
+        rx->lastSegment = lastSegment;
+        rx->state = CYMESH_TRANSPORT_SAR_RX_ASSEMBLING;
+    }
+    else if(rx->lastSegment != lastSegment)
+    {
+        return NULL;
+    }
+
+    rx->heard = now;
+
+    if(rx->state == CYMESH_TRANSPORT_SAR_RX_COMPLETE)
+    {
+        /* The sender did not get the acknowledgement */
+        rx->isAckPending = true;
+        rx->ackDue = now;
+        return rx;
+    }
+
+    bit = (uint16)(1u << segment);
+    if((rx->received & bit) == 0u)
+    {
+        memcpy(&rx->data[offset], &pdu[CYMESH_TRANSPORT_SAR_HEADER_LEN], dataLength);
+        rx->received |= bit;
+        if(segment == lastSegment)
+        {
+            rx->length = offset + dataLength;
+        }
+    }
+
+    rx->isAckPending = true;
+    if(rx->received == CYMESH_TRANSPORT_SAR_ALL(lastSegment))
+    {
+        rx->state = CYMESH_TRANSPORT_SAR_RX_COMPLETE;
+        rx->ackDue = now;
+        sar->stats.reassembled++;
+        *isComplete = true;
+    }
+    else
+    {
+        rx->ackDue = now + CYMESH_TRANSPORT_SAR_ACK_DELAY_MS;
+    }
+
+    return rx;
+}
+
+
+uint8 CyMesh_TransportSarRxAck(CYMESH_TRANSPORT_SAR_STRUCT * sar, uint32 now, uint8 * pdu,
+                               CYMESH_TRANSPORT_SAR_RX_T ** rx)
+{
+    uint8 i;
+
+    for(i = 0u; i < CYMESH_TRANSPORT_SAR_RX_POOL_SIZE; i++)
+    {
+        CYMESH_TRANSPORT_SAR_RX_T * entry = &sar->rx[i];
+
+        if(entry->state == CYMESH_TRANSPORT_SAR_RX_FREE)
+        {
+            continue;
+        }
+        if((uint32)(now - entry->heard) >= CYMESH_TRANSPORT_SAR_RX_TIMEOUT_MS)
+        {
+            entry->state = CYMESH_TRANSPORT_SAR_RX_FREE;
+            continue;
+        }
+        if((entry->isAckPending == false) || (CyMesh_TransportSarIsDue(now, entry->ackDue) == false))
+        {
+            continue;
+        }
+
+        entry->isAckPending = false;
+        if(entry->isAckWanted == true)
+        {
+            pdu[0] = CYMESH_TRANSPORT_SAR_MARKER;
+            pdu[1] = CYMESH_TRANSPORT_SAR_ACK_FLAG | entry->msgId;
+            pdu[2] = (uint8)(entry->received >> 8);
+            pdu[3] = (uint8)entry->received;
+            *rx = entry;
+            return CYMESH_TRANSPORT_SAR_ACK_LEN;
+        }
+    }
+
+    return 0u;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,340 @@
+/***************************************************************************//**
+* \file CyMesh_TransportSar.h
+* \version 1.0
+*
+* \brief
+*  This is the header file of the segmentation and reassembly of the transport
+*  layer, which carries messages longer than one transport PDU in
+*  segments acknowledged by a bitmap.
+*
+********************************************************************************
+* \copyright
+* Copyright 2014-2015, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined (CYMESH_TRANSPORT_SAR_H)
+#define CYMESH_TRANSPORT_SAR_H
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+#include <project.h>
+#include <stdbool.h>
+
+
+/*******************************************************************************
+* Compile Time Options
+*******************************************************************************/
+/* Longest message, in bytes. Every reassembly buffer and the send buffer take
+ * this much RAM. */
+#if !defined(CYMESH_TRANSPORT_SAR_MAX_LEN)
+    #define CYMESH_TRANSPORT_SAR_MAX_LEN            (128u)
+#endif
+
+/* Messages reassembled at the same time, from any sources. A message that
+ * finds no free buffer is dropped; its sender retries it. */
+#if !defined(CYMESH_TRANSPORT_SAR_RX_POOL_SIZE)
+    #define CYMESH_TRANSPORT_SAR_RX_POOL_SIZE       (2u)
+#endif
+
+/* Time between two segments of a message, in ms. The TX scheduler sends
+ * network PDUs CYMESH_BEARER_TX_INTERVAL_NETWORK apart, so a shorter one only
+ * fills its queue. */
+#if !defined(CYMESH_TRANSPORT_SAR_SEGMENT_INTERVAL_MS)
+    #define CYMESH_TRANSPORT_SAR_SEGMENT_INTERVAL_MS    (20u)
+#endif
+
+/* Time the sender waits for the block acknowledgement after the last segment
+ * of a pass, in ms, plus CYMESH_TRANSPORT_SAR_ACK_TIMEOUT_TTL_MS per hop of
+ * the TTL */
+#if !defined(CYMESH_TRANSPORT_SAR_ACK_TIMEOUT_MS)
+    #define CYMESH_TRANSPORT_SAR_ACK_TIMEOUT_MS     (300u)
+#endif
+
+#if !defined(CYMESH_TRANSPORT_SAR_ACK_TIMEOUT_TTL_MS)
+    #define CYMESH_TRANSPORT_SAR_ACK_TIMEOUT_TTL_MS (20u)
+#endif
+
+/* Time the receiver of an incomplete message waits for more segments before
+ * it acknowledges the ones it has, in ms. A complete message is acknowledged
+ * at once. */
+#if !defined(CYMESH_TRANSPORT_SAR_ACK_DELAY_MS)
+    #define CYMESH_TRANSPORT_SAR_ACK_DELAY_MS       (100u)
+#endif
+
+/* Passes that only send the segments not acknowledged yet, after the first */
+#if !defined(CYMESH_TRANSPORT_SAR_RETRIES)
+    #define CYMESH_TRANSPORT_SAR_RETRIES            (8u)
+#endif
+
+/* Passes over all segments of a message to a group, which is not
+ * acknowledged */
+#if !defined(CYMESH_TRANSPORT_SAR_UNACKED_PASSES)
+    #define CYMESH_TRANSPORT_SAR_UNACKED_PASSES     (2u)
+#endif
+
+/* Time a reassembly buffer is kept after the last segment heard, in ms. A
+ * complete message is kept as long, to acknowledge late copies again. */
+#if !defined(CYMESH_TRANSPORT_SAR_RX_TIMEOUT_MS)
+    #define CYMESH_TRANSPORT_SAR_RX_TIMEOUT_MS      (10000u)
+#endif
+
+
+/*******************************************************************************
+* Macros
+*******************************************************************************/
+/* A segment is an application payload of its own, encrypted with the key of
+ * the message: the marker, which is the single byte opcode 0x7F that the mesh
+ * specification reserves, the message ID and the segment numbers, then the
+ * data. A block acknowledgement has the ACK flag in the message ID byte and
+ * the bitmap of the segments received in place of the segment numbers. */
+#define CYMESH_TRANSPORT_SAR_PDU_LEN                (12u)   /* CYMESH_APP_MAX_DATA_LEN */
+#define CYMESH_TRANSPORT_SAR_MARKER                 (0x7Fu)
+#define CYMESH_TRANSPORT_SAR_ACK_FLAG               (0x80u)
+#define CYMESH_TRANSPORT_SAR_MSG_ID_MASK            (0x7Fu)
+#define CYMESH_TRANSPORT_SAR_HEADER_LEN             (3u)    /* Marker, ACK flag and ID, SegO and SegN */
+#define CYMESH_TRANSPORT_SAR_ACK_LEN                (4u)    /* Marker, ACK flag and ID, bitmap */
+#define CYMESH_TRANSPORT_SAR_SEGMENT_LEN            (CYMESH_TRANSPORT_SAR_PDU_LEN - CYMESH_TRANSPORT_SAR_HEADER_LEN)
+#define CYMESH_TRANSPORT_SAR_MAX_SEGMENTS           (16u)   /* 4 bit SegO and SegN */
+
+#if (CYMESH_TRANSPORT_SAR_MAX_LEN <= CYMESH_TRANSPORT_SAR_PDU_LEN) || \
+    (CYMESH_TRANSPORT_SAR_MAX_LEN > (CYMESH_TRANSPORT_SAR_MAX_SEGMENTS * CYMESH_TRANSPORT_SAR_SEGMENT_LEN)) || \
+    (CYMESH_TRANSPORT_SAR_RX_POOL_SIZE < 1u) || (CYMESH_TRANSPORT_SAR_SEGMENT_INTERVAL_MS < 1u) || \
+    (CYMESH_TRANSPORT_SAR_UNACKED_PASSES < 1u)
+    #error "Invalid transport segmentation configuration"
+#endif
+
+
+/*******************************************************************************
+* Structures and Enums
+*******************************************************************************/
+typedef enum
+{
+    /* No message, or the last one was taken by CyMesh_TransportSarTxStart() */
+    CYMESH_TRANSPORT_SAR_TX_IDLE,
+
+    /* Segments of a pass are being sent */
+    CYMESH_TRANSPORT_SAR_TX_SENDING,
+
+    /* All segments of a pass sent, waiting for the block acknowledgement */
+    CYMESH_TRANSPORT_SAR_TX_WAITING,
+
+    /* Every segment acknowledged, or every pass to a group sent */
+    CYMESH_TRANSPORT_SAR_TX_DONE,
+
+    /* Segments still missing after the last retry */
+    CYMESH_TRANSPORT_SAR_TX_FAILED
+} CYMESH_TRANSPORT_SAR_TX_STATE_T;
+
+typedef enum
+{
+    CYMESH_TRANSPORT_SAR_RX_FREE,
+    CYMESH_TRANSPORT_SAR_RX_ASSEMBLING,
+    CYMESH_TRANSPORT_SAR_RX_COMPLETE
+} CYMESH_TRANSPORT_SAR_RX_STATE_T;
+
+typedef struct
+{
+    uint8 data[CYMESH_TRANSPORT_SAR_MAX_LEN];
+    uint8 length;
+    uint8 lastSegment;          /* SegN */
+    uint8 msgId;
+    uint8 passes;               /* Passes left after the current one */
+    uint8 state;                /* CYMESH_TRANSPORT_SAR_TX_STATE_T */
+
+    /* Segments not acknowledged, and those of the current pass not sent yet;
+     * bit n for segment n */
+    uint16 pending;
+    uint16 toSend;
+
+    uint16 interval;            /* ms between segments */
+    uint16 ackTimeout;          /* ms, 0 for a message to a group */
+
+    /* Time of the next segment, or the end of the wait for an ACK, in ms */
+    uint32 due;
+} CYMESH_TRANSPORT_SAR_TX_T;
+
+typedef struct
+{
+    uint8 data[CYMESH_TRANSPORT_SAR_MAX_LEN];
+    uint8 length;               /* Known once the last segment arrived */
+    uint8 lastSegment;          /* SegN */
+    uint8 msgId;
+    uint8 state;                /* CYMESH_TRANSPORT_SAR_RX_STATE_T */
+    uint16 src;
+    uint16 received;            /* Bit n for segment n */
+    uint32 heard;               /* Time of the last segment, in ms */
+
+    /* An acknowledgement is sent at ackDue if isAckPending */
+    bool isAckPending;
+    uint32 ackDue;
+
+    /* Set by the caller: the key and addresses the acknowledgement is sent
+     * with, and whether the message asks for one */
+    bool isAckWanted;
+    bool isAppKeyUsed;
+    bool isPeerDevKey;
+    uint8 netKeyIndex;
+    uint8 appKeyIndex;
+    uint16 dst;
+} CYMESH_TRANSPORT_SAR_RX_T;
+
+typedef struct
+{
+    uint32 sent;                /* Messages started */
+    uint32 acked;
+    uint32 failed;
+    uint32 segments;            /* Segments sent, first passes and retries */
+    uint32 retransmitted;
+    uint32 reassembled;
+    uint32 dropped;             /* Segments without a free reassembly buffer */
+} CYMESH_TRANSPORT_SAR_STATS_T;
+
+typedef struct
+{
+    CYMESH_TRANSPORT_SAR_TX_T tx;
+    CYMESH_TRANSPORT_SAR_RX_T rx[CYMESH_TRANSPORT_SAR_RX_POOL_SIZE];
+    uint8 nextMsgId;
+    CYMESH_TRANSPORT_SAR_STATS_T stats;
+} CYMESH_TRANSPORT_SAR_STRUCT;
+
+
+/*******************************************************************************
+* Externed functions
+*******************************************************************************/
+/******************************************************************************
+* Function Name: CyMesh_TransportSarInit
+*******************************************************************************
+*
+*  This function drops the message being sent and every reassembly.
+*
+*  \param CYMESH_TRANSPORT_SAR_STRUCT*: segmentation state
+*
+*  \return None
+*
+******************************************************************************/
+void CyMesh_TransportSarInit(CYMESH_TRANSPORT_SAR_STRUCT * sar);
+
+/******************************************************************************
+* Function Name: CyMesh_TransportSarTxStart
+*******************************************************************************
+*
+*  This function takes a message to send in segments. The first segment is
+* due at once.
+*
+*  \param CYMESH_TRANSPORT_SAR_STRUCT*: segmentation state
+*
+*  \param const uint8*: message
+*
+*  \param uint8: length of the message, up to CYMESH_TRANSPORT_SAR_MAX_LEN
+*
+*  \param uint16: time between segments, in ms
+*
+*  \param uint16: time to wait for the block acknowledgement after a pass, in
+*                 ms; 0 for a message to a group, which is sent
+*                 CYMESH_TRANSPORT_SAR_UNACKED_PASSES times instead
+*
+*  \param uint32: timestamp, in ms
+*
+*  \return bool: false if a message is still being sent or the length is
+*                not valid
+*
+******************************************************************************/
+bool CyMesh_TransportSarTxStart(CYMESH_TRANSPORT_SAR_STRUCT * sar, const uint8 * data, uint8 length,
+                                uint16 interval, uint16 ackTimeout, uint32 now);
+
+/******************************************************************************
+* Function Name: CyMesh_TransportSarTxNext
+*******************************************************************************
+*
+*  This function returns the segment due at now, if any, and moves the message
+* on: to the wait for the acknowledgement after the last segment of a pass,
+* to a pass over the segments still missing when the wait runs out, and to
+* CYMESH_TRANSPORT_SAR_TX_FAILED after the last retry.
+*
+*  \param CYMESH_TRANSPORT_SAR_STRUCT*: segmentation state
+*
+*  \param uint32: timestamp, in ms
+*
+*  \param uint8*: segment, CYMESH_TRANSPORT_SAR_PDU_LEN bytes
+*
+*  \return uint8: length of the segment, 0 if none is due
+*
+******************************************************************************/
+uint8 CyMesh_TransportSarTxNext(CYMESH_TRANSPORT_SAR_STRUCT * sar, uint32 now, uint8 * pdu);
+
+/******************************************************************************
+* Function Name: CyMesh_TransportSarTxAck
+*******************************************************************************
+*
+*  This function takes a block acknowledgement of the message being sent.
+* Segments it has are not sent again; once the pass is over, the missing ones
+* are sent at once.
+*
+*  \param CYMESH_TRANSPORT_SAR_STRUCT*: segmentation state
+*
+*  \param const uint8*: acknowledgement, from the marker
+*
+*  \param uint8: its length
+*
+*  \param uint32: timestamp, in ms
+*
+*  \return None
+*
+******************************************************************************/
+void CyMesh_TransportSarTxAck(CYMESH_TRANSPORT_SAR_STRUCT * sar, const uint8 * pdu, uint8 length, uint32 now);
+
+/******************************************************************************
+* Function Name: CyMesh_TransportSarRxSegment
+*******************************************************************************
+*
+*  This function stores a segment in the reassembly buffer of its message,
+* taking a free one, or the oldest complete one, for a new message. The
+* caller sets the acknowledgement fields of the buffer returned.
+*
+*  \param CYMESH_TRANSPORT_SAR_STRUCT*: segmentation state
+*
+*  \param uint16: SRC of the segment
+*
+*  \param const uint8*: segment, from the marker
+*
+*  \param uint8: its length
+*
+*  \param uint32: timestamp, in ms
+*
+*  \param bool*: set to true if this segment completed the message
+*
+*  \return CYMESH_TRANSPORT_SAR_RX_T*: buffer of the message, NULL if the
+*                                      segment was not valid or dropped
+*
+******************************************************************************/
+CYMESH_TRANSPORT_SAR_RX_T * CyMesh_TransportSarRxSegment(CYMESH_TRANSPORT_SAR_STRUCT * sar, uint16 src,
+                                                         const uint8 * pdu, uint8 length, uint32 now,
+                                                         bool * isComplete);
+
+/******************************************************************************
+* Function Name: CyMesh_TransportSarRxAck
+*******************************************************************************
+*
+*  This function frees the reassembly buffers that timed out and returns a
+* block acknowledgement that is due, if any.
+*
+*  \param CYMESH_TRANSPORT_SAR_STRUCT*: segmentation state
+*
+*  \param uint32: timestamp, in ms
+*
+*  \param uint8*: acknowledgement, CYMESH_TRANSPORT_SAR_ACK_LEN bytes
+*
+*  \param CYMESH_TRANSPORT_SAR_RX_T**: set to the buffer acknowledged
+*
+*  \return uint8: length of the acknowledgement, 0 if none is due
+*
+******************************************************************************/
+uint8 CyMesh_TransportSarRxAck(CYMESH_TRANSPORT_SAR_STRUCT * sar, uint32 now, uint8 * pdu,
+                               CYMESH_TRANSPORT_SAR_RX_T ** rx);
+
+#endif
+/* [] END OF FILE */
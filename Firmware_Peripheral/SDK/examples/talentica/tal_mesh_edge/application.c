@@ -36,6 +36,10 @@ static void mesh_get_peer_location(uint16_t destination_id)
 
     APPL_LOG("Asking for peer location...\r\n");
 
+#if MESH_TRACE_ENABLED
+    mesh_trace_new();
+#endif
+
     advertising_change_data(opcode, data, sizeof(data));
 }
 
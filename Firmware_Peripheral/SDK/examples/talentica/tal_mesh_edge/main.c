@@ -34,14 +34,10 @@
 #define CENTRAL_LINK_COUNT         1                                  /**< Number of central links used by the application. When changing this number remember to adjust the RAM settings*/
 #define PERIPHERAL_LINK_COUNT      0                                  /**< Number of peripheral links used by the application. When changing this number remember to adjust the RAM settings*/
 
-#define APP_TIMER_OP_QUEUE_SIZE    2                                  /**< Size of timer operation queues. */
-
-#define SCAN_INTERVAL              0x00A0                             /**< Determines scan interval in units of 0.625 millisecond. */
-#define SCAN_WINDOW                0x0090                             /**< Determines scan window in units of 0.625 millisecond. */
+#define APP_TIMER_OP_QUEUE_SIZE    4                                  /**< Size of timer operation queues. */
 
 
 const uint8_t leds_list[LEDS_NUMBER] = LEDS_LIST;
-static ble_gap_scan_params_t        m_scan_param;                        /**< Scan parameters requested for scanning and connection. */
 
 
 /**@brief Function for handling the Application's system events.
@@ -94,25 +90,6 @@ static void ble_stack_init(void)
 }
 
 
-/**@brief Function to start scanning.
- */
-static void scan_start(void)
-{
-    uint32_t              err_code;
-
-    /* No devices in whitelist, hence non selective performed. */
-    m_scan_param.active       = 0;            // Passive scanning set.
-    m_scan_param.selective    = 0;            // Selective scanning not set.
-    m_scan_param.interval     = SCAN_INTERVAL;// Scan interval.
-    m_scan_param.window       = SCAN_WINDOW;  // Scan window.
-    m_scan_param.p_whitelist  = NULL;         // No whitelist provided.
-    m_scan_param.timeout      = 0;            // No timeout.
-
-    err_code = sd_ble_gap_scan_start(&m_scan_param);
-    APP_ERROR_CHECK(err_code);
-}
-
-
 /** @brief Function for the Power manager.
  */
 static void power_manage(void)
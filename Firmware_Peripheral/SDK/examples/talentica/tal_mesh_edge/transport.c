@@ -33,7 +33,24 @@
 #define MASK_IS_PERIPHERAL              (0x40)
 #define MASK_OPCODE                     (0x3F)
 
+#define SCAN_INTERVAL                   (0x00A0)  /* Scan interval in units of 0.625 millisecond */
+#define SCAN_WINDOW                     (0x0090)  /* Scan window in units of 0.625 millisecond */
+
+/* Keep-alive opcodes of the polls, OPCODE_FRIEND_POLL and OPCODE_FRIEND_POLL_REPLY
+ * in friend.h of the mesh nodes */
+#define OPCODE_POLL                     (0x01)    /* Poll interval in seconds (1) */
+#define OPCODE_POLL_REPLY               (0x01)    /* Packets still kept by the beacon (1) */
+
+#if MESH_POLL_INTERVAL_S
+/* Beacons are only heard after the polls, so keep them for a few of them */
+#define BEACON_PRESENCE_TIMEOUT_S       (5 + 3 * MESH_POLL_INTERVAL_S)
+#else
 #define BEACON_PRESENCE_TIMEOUT_S       (5)       /* Timeout in seconds for beacon to be in list */
+#endif
+
+/* Trace stages logged by the peripheral. Keep in sync with Tools/trace_analyser.py */
+#define TRACE_STAGE_TX                  "P_TX"    /* Data packet handed to the advertiser */
+#define TRACE_STAGE_RX                  "P_RX"    /* Data packet for us received from a beacon */
 
 BEACON_RSSI_ADDR_T beacons[3];
 static volatile uint8_t time_counter[3];
@@ -47,11 +64,56 @@ volatile uint8_t numberOfElements = 0;
 static ble_advdata_t        advdata = {0};
 ble_adv_modes_config_t      options = {0};
 ble_advdata_manuf_data_t    manuf_data;
-static uint8_t              payload[15];
+static uint8_t              payload[15 + MESH_TRACE_ENABLED];
 
 uint16_t source_id = DEVICE_1_SOURCE_ID;
 APP_TIMER_DEF(beacon_refresh_id);
 
+typedef enum
+{
+    SCAN_OFF,
+    SCAN_CONTINUOUS,                /* Looking for beacons, or MESH_POLL_INTERVAL_S is 0 */
+    SCAN_RECEIVE_WINDOW             /* Listening after a poll */
+} scan_mode_t;
+
+static ble_gap_scan_params_t m_scan_param;
+static volatile scan_mode_t  m_scan_mode = SCAN_OFF;
+
+#if MESH_POLL_INTERVAL_S
+APP_TIMER_DEF(poll_timer_id);
+APP_TIMER_DEF(receive_window_timer_id);
+
+static bool             m_is_poll_advertising = false;
+static volatile bool    m_is_poll_due = false;
+static volatile bool    m_is_window_over = false;
+static volatile bool    m_is_window_extended = false;
+static volatile uint8_t m_packets_left = 0;
+#endif
+
+#if MESH_TRACE_ENABLED
+static uint8_t m_trace_id = 0;
+
+
+/** @brief Function to log a trace stage as "T,<device>,<trace ID>,<stage>,<RTC1 ticks>".
+ */
+static void mesh_trace_stage(const char * stage)
+{
+    uint32_t ticks;
+
+    (void)app_timer_cnt_get(&ticks);
+    APPL_LOG("T,%04x,%02x,%s,%lu\r\n", source_id, m_trace_id, stage, ticks);
+}
+
+
+/** @brief Function to start a new trace. Replies to a received packet keep
+ *  the trace ID of the request so that the whole round trip shares one ID.
+ */
+void mesh_trace_new(void)
+{
+    m_trace_id++;
+}
+#endif
+
 
 /**@brief Function for handling advertising events.
  *
@@ -69,10 +131,60 @@ static void on_adv_evt(ble_adv_evt_t ble_adv_evt)
 }
 
 
+/**@brief Function to scan all the time, during a receive window, or not at all.
+ */
+static void scan_set(scan_mode_t mode)
+{
+    uint32_t err_code;
+
+    if(m_scan_mode == mode)
+    {
+        return;
+    }
+
+    if(m_scan_mode != SCAN_OFF)
+    {
+        err_code = sd_ble_gap_scan_stop();
+        APP_ERROR_CHECK(err_code);
+    }
+    m_scan_mode = mode;
+
+    if(mode == SCAN_OFF)
+    {
+        return;
+    }
+
+    /* No devices in whitelist, hence non selective performed. The receive
+     * window is short, so it is scanned without gaps. */
+    m_scan_param.active       = 0;            // Passive scanning set.
+    m_scan_param.selective    = 0;            // Selective scanning not set.
+    m_scan_param.interval     = SCAN_INTERVAL;// Scan interval.
+    m_scan_param.window       = (mode == SCAN_RECEIVE_WINDOW) ? SCAN_INTERVAL : SCAN_WINDOW;
+    m_scan_param.p_whitelist  = NULL;         // No whitelist provided.
+    m_scan_param.timeout      = 0;            // No timeout.
+
+    err_code = sd_ble_gap_scan_start(&m_scan_param);
+    APP_ERROR_CHECK(err_code);
+}
+
+
+/**@brief Function to start scanning for beacons.
+ */
+void scan_start(void)
+{
+    scan_set(SCAN_CONTINUOUS);
+}
+
+
 void advertising_stop(void)
 {
     uint32_t err_code;
 
+    if(m_adv_mode_current == BLE_ADV_MODE_IDLE)
+    {
+        return;
+    }
+
     err_code = sd_ble_gap_adv_stop();
     APP_ERROR_CHECK(err_code);
     m_adv_mode_current = BLE_ADV_MODE_IDLE;
@@ -90,9 +202,19 @@ void advertising_change_data(uint8_t opcode, uint8_t * param, uint8_t param_leng
     payload[4] = (source_id >> 8) & 0x00FF;
     memcpy(&payload[5], param, param_length);
 
+#if MESH_TRACE_ENABLED
+    payload[5 + param_length] = m_trace_id;
+    param_length++;
+    mesh_trace_stage(TRACE_STAGE_TX);
+#endif
+
     /* Send the information out once */
     options.ble_adv_fast_timeout = BLE_ADV_FAST_TIMEOUT;
 
+#if MESH_POLL_INTERVAL_S
+    m_is_poll_advertising = false;
+#endif
+
     manuf_data.data.size = param_length + 5;
 
     advertising_stop();
@@ -122,10 +244,10 @@ void advertising_change_beacon(void)
 }
 
 
-void advertising_start_beacon(void)
+/** @brief Function to set up the keep-alive advertising data.
+ */
+static void advertising_init_keep_alive(uint8_t opcode)
 {
-    uint32_t err_code;
-
     manuf_data.company_identifier = (MANUFACTURER_ID_TALENTICA_MSB << 8) | MANUFACTURER_ID_TALENTICA_LSB;
     manuf_data.data.p_data = payload;
     manuf_data.data.size = 5;
@@ -140,11 +262,19 @@ void advertising_start_beacon(void)
     options.ble_adv_fast_interval     = BLE_ADV_FAST_INTERVAL;
     options.ble_adv_fast_timeout      = 0;
 
-    payload[0] = (SEND_NO_DATA << BIT_POS_IS_DATA) | (DEVICE_PERIPHERAL << BIT_POS_IS_PERIPHERAL);
+    payload[0] = (SEND_NO_DATA << BIT_POS_IS_DATA) | (DEVICE_PERIPHERAL << BIT_POS_IS_PERIPHERAL) | (opcode & MASK_OPCODE);
     payload[1] = beacons[min_index].beacon_id & 0x00FF;
     payload[2] = (beacons[min_index].beacon_id >> 8) & 0x00FF;
     payload[3] = source_id & 0x00FF;
     payload[4] = (source_id >> 8) & 0x00FF;
+}
+
+
+void advertising_start_beacon(void)
+{
+    uint32_t err_code;
+
+    advertising_init_keep_alive(0);
 
     err_code = ble_advertising_init(&advdata, NULL, &options, on_adv_evt, NULL);
     APP_ERROR_CHECK(err_code);
@@ -156,6 +286,33 @@ void advertising_start_beacon(void)
 }
 
 
+#if MESH_POLL_INTERVAL_S
+/** @brief Function to poll the closest beacon: a keep-alive carrying the poll
+ *  interval, sent once. The beacon replies with the data it kept for us.
+ */
+static void advertising_start_poll(void)
+{
+    uint32_t err_code;
+
+    advertising_stop();
+
+    advertising_init_keep_alive(OPCODE_POLL);
+    payload[5] = MESH_POLL_INTERVAL_S;
+    manuf_data.data.size = 6;
+    options.ble_adv_fast_timeout = BLE_ADV_FAST_TIMEOUT;
+
+    err_code = ble_advertising_init(&advdata, NULL, &options, on_adv_evt, NULL);
+    APP_ERROR_CHECK(err_code);
+
+    m_advdata.p_manuf_specific_data = &manuf_data;
+
+    err_code = ble_advertising_start(BLE_ADV_MODE_FAST);
+    APP_ERROR_CHECK(err_code);
+    m_is_poll_advertising = true;
+}
+#endif
+
+
 
 /** @brief Function to see if a device saw in scanning
  *  is already in our list of closest 3 beacons.
@@ -312,6 +469,17 @@ void on_ble_evt(ble_evt_t * p_ble_evt)
                 if((data[index] & MASK_IS_DATA) == (SEND_NO_DATA << BIT_POS_IS_DATA))
                 {
                     beacon_id = (data[index + 2] << 8) | data[index + 1];
+
+#if MESH_POLL_INTERVAL_S
+                    /* The reply to our poll ends the receive window */
+                    if((m_scan_mode == SCAN_RECEIVE_WINDOW) && (numberOfElements > 0) &&
+                       (beacon_id == beacons[min_index].beacon_id) &&
+                       ((data[index] & MASK_OPCODE) == OPCODE_POLL_REPLY) && (data_len > index + 3))
+                    {
+                        m_packets_left = data[index + 3];
+                        m_is_window_over = true;
+                    }
+#endif
                 }
                 else
                 {
@@ -333,6 +501,24 @@ void on_ble_evt(ble_evt_t * p_ble_evt)
                         break;
                     }
 
+#if MESH_TRACE_ENABLED
+                    if(length < 1)
+                    {
+                        /* No trace ID: the packet was cut short */
+                        break;
+                    }
+
+                    /* Strip the trace ID so the application sees the original parameters */
+                    m_trace_id = data[data_len - 1];
+                    length--;
+                    mesh_trace_stage(TRACE_STAGE_RX);
+#endif
+
+#if MESH_POLL_INTERVAL_S
+                    /* More may follow */
+                    m_is_window_extended = true;
+#endif
+
                     /* Send packet to the application */
                     application_event_handler(opcode, msg_source_id, &data[index + 7], length);
 
@@ -405,7 +591,13 @@ void on_ble_evt(ble_evt_t * p_ble_evt)
         {
             if(p_gap_evt->params.timeout.src == BLE_GAP_TIMEOUT_SRC_ADVERTISING)
             {
+#if MESH_POLL_INTERVAL_S
+                /* Polls take the place of the keep-alive beacon */
+                m_adv_mode_current = BLE_ADV_MODE_IDLE;
+                m_is_poll_advertising = false;
+#else
                 advertising_start_beacon();
+#endif
             }
             break;
         }
@@ -444,13 +636,44 @@ static void beacon_timer_handler(void * p_context)
 }
 
 
-/** @brief Function to create timer for beacon last-seen and expiry.
+#if MESH_POLL_INTERVAL_S
+static void poll_timer_handler(void * p_context)
+{
+    m_is_poll_due = true;
+}
+
+
+static void receive_window_timer_handler(void * p_context)
+{
+    m_is_window_over = true;
+}
+#endif
+
+
+/** @brief Function to create timer for beacon last-seen and expiry,
+ *  and the timers of the polls.
  *
  */
 void create_beacon_timer(void)
 {
     uint32_t err_code;
 
+#if MESH_POLL_INTERVAL_S
+    err_code = app_timer_create(&poll_timer_id,
+                                APP_TIMER_MODE_REPEATED,
+                                poll_timer_handler);
+    APP_ERROR_CHECK(err_code);
+    err_code = app_timer_start(poll_timer_id,
+                               APP_TIMER_TICKS(MESH_POLL_INTERVAL_S * 1000, APP_TIMER_PRESCALER),
+                               NULL);
+    APP_ERROR_CHECK(err_code);
+
+    err_code = app_timer_create(&receive_window_timer_id,
+                                APP_TIMER_MODE_SINGLE_SHOT,
+                                receive_window_timer_handler);
+    APP_ERROR_CHECK(err_code);
+#endif
+
     /* Create a timer to trigger every second */
     err_code = app_timer_create(&beacon_refresh_id,
                                 APP_TIMER_MODE_REPEATED,
@@ -463,12 +686,112 @@ void create_beacon_timer(void)
 }
 
 
+#if MESH_POLL_INTERVAL_S
+/** @brief Function to (re)start the receive window timer.
+ */
+static void receive_window_start(void)
+{
+    uint32_t err_code;
+
+    err_code = app_timer_stop(receive_window_timer_id);
+    APP_ERROR_CHECK(err_code);
+    err_code = app_timer_start(receive_window_timer_id,
+                               APP_TIMER_TICKS(MESH_RECEIVE_WINDOW_MS, APP_TIMER_PRESCALER),
+                               NULL);
+    APP_ERROR_CHECK(err_code);
+}
+
+
+/** @brief Function to end the receive window: the radio sleeps until the
+ *  next poll, or polls again at once if the beacon kept more packets.
+ */
+static void receive_window_stop(void)
+{
+    uint32_t err_code;
+
+    err_code = app_timer_stop(receive_window_timer_id);
+    APP_ERROR_CHECK(err_code);
+
+    scan_set(SCAN_OFF);
+    if(m_is_poll_advertising)
+    {
+        advertising_stop();
+        m_is_poll_advertising = false;
+    }
+
+    m_is_window_over = false;
+    m_is_window_extended = false;
+    if(m_packets_left > 0)
+    {
+        m_is_poll_due = true;
+    }
+}
+#endif
+
+
 /** @brief Main function for mesh transport. Ensures that the device
  *  stays in touch with the closest beacon.
  *
+ *  With MESH_POLL_INTERVAL_S, the device scans all the time only while no
+ *  beacon is known. Then it polls the closest beacon every
+ *  MESH_POLL_INTERVAL_S and scans for MESH_RECEIVE_WINDOW_MS after each poll.
  */
 void mesh_transport_run(void)
 {
+#if MESH_POLL_INTERVAL_S
+    if(numberOfElements == 0)
+    {
+        /* We lost all beacons close by. Scan until one is found, then poll it. */
+        if(m_scan_mode != SCAN_CONTINUOUS)
+        {
+            receive_window_stop();
+            advertising_stop();
+            scan_set(SCAN_CONTINUOUS);
+        }
+        m_packets_left = 0;
+        m_is_poll_due = true;
+        return;
+    }
+
+    if(m_scan_mode == SCAN_CONTINUOUS)
+    {
+        scan_set(SCAN_OFF);
+
+        APPL_LOG("ID = %04x ********\r\n\n", source_id);
+        APPL_LOG("Input menu:\r\n");
+        APPL_LOG("Press '1' to find a peer device. \r\n");
+    }
+
+    /* Every poll goes to the closest beacon at the time */
+    isMinChanged = false;
+
+    if(m_scan_mode == SCAN_RECEIVE_WINDOW)
+    {
+        if(m_is_window_over)
+        {
+            receive_window_stop();
+        }
+        else if(m_is_window_extended)
+        {
+            m_is_window_extended = false;
+            receive_window_start();
+        }
+    }
+
+    /* A data packet being sent goes first */
+    if(m_is_poll_due && (m_scan_mode == SCAN_OFF) && (m_adv_mode_current == BLE_ADV_MODE_IDLE))
+    {
+        m_is_poll_due = false;
+        m_packets_left = 0;
+        m_is_window_over = false;
+        advertising_start_poll();
+        scan_set(SCAN_RECEIVE_WINDOW);
+        receive_window_start();
+    }
+
+    /* Check user input and act */
+    mesh_application_run();
+#else
     /* Once we have atleast one beacon closeby, advertise to it. */
     if(m_adv_mode_current == BLE_ADV_MODE_IDLE)
     {
@@ -503,6 +826,7 @@ void mesh_transport_run(void)
             mesh_application_run();
         }
     }
+#endif
 }
 
 /* End of file */
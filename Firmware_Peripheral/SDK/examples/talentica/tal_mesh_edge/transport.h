@@ -15,6 +15,10 @@
 #define DEVICE_1_SOURCE_ID         (0xFFAA)
 #define DEVICE_2_SOURCE_ID         (0xFFBB)
 
+#define MESH_TRACE_ENABLED         0                                  /**< Set to 1 to append a trace ID byte to every data packet and log each send/receive with the RTC1 tick count. Must match CYMESHTEST_TRACE_ENABLED on the mesh nodes. */
+#define MESH_POLL_INTERVAL_S       0                                  /**< 0 to scan all the time, as mesh nodes without friend.c expect. Otherwise the seconds between the polls of the closest beacon, 1 to 60: the radio sleeps in between and only scans for a short window after each poll, and the beacon keeps the data for this device until then (friend.c). Only set it when every mesh node runs friend.c; data for the device, such as a LOCATION_GET reply, then waits up to this long. See Tools/network_bench/friend_sim.c. */
+#define MESH_RECEIVE_WINDOW_MS     400                                /**< Scan window after a poll, extended by every data packet received. The reply of the beacon ends it earlier. */
+
 
 
 typedef struct
@@ -31,11 +35,20 @@ extern volatile uint8_t numberOfElements;
 extern uint16_t source_id;
 
 
+#if (MESH_POLL_INTERVAL_S > 60)
+#error "MESH_POLL_INTERVAL_S must be 60 or less, FRIEND_POLL_INTERVAL_MAX_S on the mesh nodes"
+#endif
+
+
 extern void on_ble_evt(ble_evt_t * p_ble_evt);
+extern void scan_start(void);
 extern void create_beacon_timer(void);
 extern void advertising_start_beacon(void);
 extern void advertising_change_data(uint8_t opcode, uint8_t * param, uint8_t param_length);
 extern void mesh_transport_run(void);
+#if MESH_TRACE_ENABLED
+extern void mesh_trace_new(void);
+#endif
 
 
 /* End of file */
@@ -0,0 +1,270 @@
+/*******************************************************************************
+* Host test and benchmark of Firmware_Mesh/SM Files/CyMesh_SecurityPVT.c.
+*
+* Checks the AES-128 core against FIPS-197 / SP 800-38A and AES-CCM against
+* the RFC 3610 packet vectors, then measures a network PDU sized AES-CCM
+* encryption and decryption. From the repository root:
+*
+*   gcc -O2 -I Tools/aes_ccm_bench -I "Firmware_Mesh/SM Files" -o aes_ccm_bench \
+*       Tools/aes_ccm_bench/aes_ccm_bench.c "Firmware_Mesh/SM Files/CyMesh_SecurityPVT.c"
+*
+* Add -DCYMESH_SECURITY_AES_CORE=0 for the compact core and
+* -DCYMESH_SECURITY_AES_KEY_CACHE_SIZE=0 to expand the key on every call.
+* Cycles are only reported on x86 (TSC); the numbers
+* compare the build options with each other, not with the Cortex-M0.
+*
+* Exits with 1 if a vector fails.
+*******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <project.h>
+#include "CyMesh_SecurityPVT.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define BENCH_CYCLES()      (__rdtsc())
+#else
+    #define BENCH_CYCLES()      (0ull)
+#endif
+
+#define BENCH_PACKETS           (100000u)
+#define BENCH_REPEAT            (5u)    /* The fastest of these runs is reported */
+#define BENCH_PAYLOAD_LENGTH    (16u)   /* Encrypted DST and transport PDU of a full network PDU */
+#define BENCH_MIC_LENGTH        (CYMESH_SECURITY_CCM_BLOCK_M_4)
+
+typedef struct
+{
+    const char * name;
+    uint8 key[16];
+    uint8 input[16];
+    uint8 output[16];
+} AES_VECTOR_T;
+
+typedef struct
+{
+    const char * name;
+    uint8 key[16];
+    uint8 nonce[13];
+    uint8 additionalDataLength;
+    uint8 payloadLength;
+    uint8 micLength;
+    uint8 packet[64];           /* Additional data, payload */
+    uint8 result[64];           /* Encrypted payload, MIC */
+} CCM_VECTOR_T;
+
+static const AES_VECTOR_T aesVectors[] =
+{
+    {
+        "FIPS-197 C.1",
+        { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F },
+        { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF },
+        { 0x69, 0xC4, 0xE0, 0xD8, 0x6A, 0x7B, 0x04, 0x30, 0xD8, 0xCD, 0xB7, 0x80, 0x70, 0xB4, 0xC5, 0x5A }
+    },
+    {
+        "SP 800-38A F.1.1 block 1",
+        { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C },
+        { 0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96, 0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A },
+        { 0x3A, 0xD7, 0x7B, 0xB4, 0x0D, 0x7A, 0x36, 0x60, 0xA8, 0x9E, 0xCA, 0xF3, 0x24, 0x66, 0xEF, 0x97 }
+    }
+};
+
+#define RFC3610_KEY     { 0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF }
+
+static const CCM_VECTOR_T ccmVectors[] =
+{
+    {
+        "RFC 3610 packet vector #1", RFC3610_KEY,
+        { 0x00, 0x00, 0x00, 0x03, 0x02, 0x01, 0x00, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 },
+        8, 23, 8,
+        { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+          0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E },
+        { 0x58, 0x8C, 0x97, 0x9A, 0x61, 0xC6, 0x63, 0xD2, 0xF0, 0x66, 0xD0, 0xC2, 0xC0, 0xF9, 0x89, 0x80,
+          0x6D, 0x5F, 0x6B, 0x61, 0xDA, 0xC3, 0x84, 0x17, 0xE8, 0xD1, 0x2C, 0xFD, 0xF9, 0x26, 0xE0 }
+    },
+    {
+        "RFC 3610 packet vector #2", RFC3610_KEY,
+        { 0x00, 0x00, 0x00, 0x04, 0x03, 0x02, 0x01, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 },
+        8, 24, 8,
+        { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+          0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F },
+        { 0x72, 0xC9, 0x1A, 0x36, 0xE1, 0x35, 0xF8, 0xCF, 0x29, 0x1C, 0xA8, 0x94, 0x08, 0x5C, 0x87, 0xE3,
+          0xCC, 0x15, 0xC4, 0x39, 0xC9, 0xE4, 0x3A, 0x3B, 0xA0, 0x91, 0xD5, 0x6E, 0x10, 0x40, 0x09, 0x16 }
+    },
+    {
+        "RFC 3610 packet vector #3", RFC3610_KEY,
+        { 0x00, 0x00, 0x00, 0x05, 0x04, 0x03, 0x02, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 },
+        8, 25, 8,
+        { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+          0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F,
+          0x20 },
+        { 0x51, 0xB1, 0xE5, 0xF4, 0x4A, 0x19, 0x7D, 0x1D, 0xA4, 0x6B, 0x0F, 0x8E, 0x2D, 0x28, 0x2A, 0xE8,
+          0x71, 0xE8, 0x38, 0xBB, 0x64, 0xDA, 0x85, 0x96, 0x57, 0x4A, 0xDA, 0xA7, 0x6F, 0xBD, 0x9F, 0xB0,
+          0xC5 }
+    },
+    {
+        "RFC 3610 packet vector #4", RFC3610_KEY,
+        { 0x00, 0x00, 0x00, 0x06, 0x05, 0x04, 0x03, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 },
+        12, 19, 8,
+        { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+          0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E },
+        { 0xA2, 0x8C, 0x68, 0x65, 0x93, 0x9A, 0x9A, 0x79, 0xFA, 0xAA, 0x5C, 0x4C, 0x2A, 0x9D, 0x4A, 0x91,
+          0xCD, 0xAC, 0x8C, 0x96, 0xC8, 0x61, 0xB9, 0xC9, 0xE6, 0x1E, 0xF1 }
+    }
+};
+
+
+static int CheckAes(void)
+{
+    uint8 output[16];
+    int failures = 0;
+    unsigned i;
+
+    for(i = 0; i < sizeof(aesVectors) / sizeof(aesVectors[0]); i++)
+    {
+        const AES_VECTOR_T * vector = &aesVectors[i];
+        int ok = (CyMesh_SecurityPVTAesEncrypt(vector->input, vector->key, output) == CYMESH_ERROR_OK) &&
+                 (memcmp(output, vector->output, sizeof(output)) == 0);
+
+        printf("%-32s %s\n", vector->name, ok ? "ok" : "FAIL");
+        failures += !ok;
+    }
+
+    return failures;
+}
+
+
+static int CheckCcm(void)
+{
+    uint8 output[64];
+    uint8 mic[CYMESH_SECURITY_CCM_BLOCK_M_8];
+    int failures = 0;
+    unsigned i;
+
+    for(i = 0; i < sizeof(ccmVectors) / sizeof(ccmVectors[0]); i++)
+    {
+        const CCM_VECTOR_T * vector = &ccmVectors[i];
+        const uint8 * payload = &vector->packet[vector->additionalDataLength];
+        const uint8 * encMic = &vector->result[vector->payloadLength];
+        int ok;
+
+        ok = (CyMesh_SecurityAesCcmEncryption(vector->key, vector->nonce, payload, vector->payloadLength,
+                                              vector->packet, vector->additionalDataLength,
+                                              output, mic, vector->micLength) == CYMESH_ERROR_OK) &&
+             (memcmp(output, vector->result, vector->payloadLength) == 0) &&
+             (memcmp(mic, encMic, vector->micLength) == 0);
+
+        ok = ok && (CyMesh_SecurityAesCcmDecryption(vector->key, vector->nonce, vector->result, vector->payloadLength,
+                                                    vector->packet, vector->additionalDataLength,
+                                                    output, encMic, vector->micLength) == CYMESH_ERROR_OK) &&
+             (memcmp(output, payload, vector->payloadLength) == 0);
+
+        /* Any change to the MIC must be detected */
+        memcpy(mic, encMic, vector->micLength);
+        mic[vector->micLength - 1u] ^= 0x01u;
+        ok = ok && (CyMesh_SecurityAesCcmDecryption(vector->key, vector->nonce, vector->result, vector->payloadLength,
+                                                    vector->packet, vector->additionalDataLength,
+                                                    output, mic, vector->micLength) ==
+                    CYMESH_ERROR_AES_CCM_DECRYPTION_FAILED);
+
+        printf("%-32s %s\n", vector->name, ok ? "ok" : "FAIL");
+        failures += !ok;
+    }
+
+    return failures;
+}
+
+
+static double Seconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec * 1e-9);
+}
+
+
+/* Two keys in turn, as the network and the application layer of a relay */
+static void Benchmark(void)
+{
+    static const uint8 keys[2][16] =
+    {
+        { 0x09, 0x53, 0xFA, 0x93, 0xE7, 0xCA, 0xAC, 0x96, 0x38, 0xF5, 0x88, 0x20, 0x22, 0x0A, 0x39, 0x8E },
+        { 0x63, 0x96, 0x47, 0x71, 0x73, 0x4F, 0xBD, 0x76, 0xE3, 0xB4, 0x05, 0x19, 0xD1, 0xD9, 0x4A, 0x48 }
+    };
+    uint8 nonce[13] = { 0x00, 0x80, 0x00, 0x00, 0x01, 0x12, 0x01, 0x00, 0x00, 0x12, 0x34, 0x56, 0x78 };
+    uint8 payload[BENCH_PAYLOAD_LENGTH] = { 0 };
+    uint8 output[BENCH_PAYLOAD_LENGTH];
+    uint8 mic[BENCH_MIC_LENGTH];
+    unsigned long long cycles[2];
+    double seconds[2];
+    uint32 failures = 0;
+    uint32 i;
+
+    for(i = 0; i < (2u * BENCH_REPEAT); i++)
+    {
+        uint32 packet;
+        uint32 operation = i % 2u;
+        double start = Seconds();
+        unsigned long long startCycles = BENCH_CYCLES();
+
+        for(packet = 0; packet < BENCH_PACKETS; packet++)
+        {
+            nonce[5] = (uint8)packet;
+            if(operation == 0u)
+            {
+                (void)CyMesh_SecurityAesCcmEncryption(keys[packet & 1u], nonce, payload, sizeof(payload),
+                                                      NULL, 0, output, mic, sizeof(mic));
+                payload[0] = output[0];
+            }
+            else
+            {
+                /* Wrong MIC: the full decryption runs and fails, as for a packet of another network */
+                failures += (CyMesh_SecurityAesCcmDecryption(keys[packet & 1u], nonce, payload, sizeof(payload),
+                                                             NULL, 0, output, mic, sizeof(mic)) != CYMESH_ERROR_OK);
+                payload[0] = output[0];
+            }
+        }
+
+        startCycles = BENCH_CYCLES() - startCycles;
+        start = Seconds() - start;
+        if((i < 2u) || (start < seconds[operation]))
+        {
+            cycles[operation] = startCycles;
+            seconds[operation] = start;
+        }
+    }
+
+    printf("\ncore %s, key cache %d, %u byte payload, %u byte MIC\n",
+           (CYMESH_SECURITY_AES_CORE == CYMESH_SECURITY_AES_CORE_TTABLE) ? "T-table" : "compact",
+           (int)CYMESH_SECURITY_AES_KEY_CACHE_SIZE, BENCH_PAYLOAD_LENGTH, BENCH_MIC_LENGTH);
+    printf("%-10s %14s %14s %14s\n", "operation", "packets/s", "bytes/s", "cycles/packet");
+    for(i = 0; i < 2u; i++)
+    {
+        printf("%-10s %14.0f %14.0f %14.0f\n", (i == 0u) ? "encrypt" : "decrypt",
+               BENCH_PACKETS / seconds[i], (BENCH_PACKETS * BENCH_PAYLOAD_LENGTH) / seconds[i],
+               (double)cycles[i] / BENCH_PACKETS);
+    }
+
+    if(failures != (BENCH_PACKETS * BENCH_REPEAT))
+    {
+        printf("unexpected MIC match\n");
+    }
+}
+
+
+int main(void)
+{
+    int failures = CheckAes() + CheckCcm();
+
+    if(failures != 0)
+    {
+        printf("%d vector(s) failed\n", failures);
+        return 1;
+    }
+
+    Benchmark();
+    return 0;
+}
+
+/* [] END OF FILE */
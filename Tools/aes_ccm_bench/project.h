@@ -0,0 +1,18 @@
+/*******************************************************************************
+* Host replacement of the PSoC Creator generated project.h, with the types
+* CyMesh_SecurityPVT.c and the SmartMesh headers need to build on a PC.
+*******************************************************************************/
+#if !defined(PROJECT_H)
+#define PROJECT_H
+
+#include <stdint.h>
+
+typedef uint8_t  uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef int8_t   int8;
+typedef int16_t  int16;
+typedef int32_t  int32;
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,372 @@
+#!/usr/bin/env python3
+"""Configure many mesh nodes through a gateway node.
+
+The gateway is any mesh node built with CYMESH_DEBUG_ENABLED and connected to
+the host UART. The tool sends it one UART_CMD_COMMISSION request per
+configuration operation and reads the results back as COMMISSION frames (see
+Firmware_Mesh/Mesh.cydsn/commission.c). Up to --window operations, each to a
+different node, are in flight at once; the operations of one node are sent in
+the order of the job file. Operations answered with BUSY are sent again,
+TIMEOUT up to --retries times:
+
+    stty -F /dev/ttyACM0 115200 raw
+    commission.py Mesh.elf /dev/ttyACM0 job.txt --nodes 0102 0103 0104
+
+The job file has one operation per line, "*" standing for every node given
+with --nodes, addresses and keys in hex:
+
+    * relay 1
+    * ttl 20
+    * appkey 0 000102030405060708090a0b0c0d0e0f
+    * publication 0 1 c001 0 20
+    0102 subscription 0 1 c002
+
+--simulate runs the same scheduler against a model of the gateway and the
+mesh instead of a serial device, and compares the commissioning time of
+every window given:
+
+    commission.py --simulate --nodes 50 --window 1 4
+"""
+
+import argparse
+import heapq
+import io
+import os
+import random
+import struct
+import sys
+import threading
+import time
+from collections import deque
+
+import log_decoder
+
+UART_CMD_COMMISSION = b'C'
+
+# Keep in sync with commission.h
+COMMISSION_WINDOW = 4
+COMMISSION_TIMEOUT_MS = 20000
+OPERATIONS = {
+    'relay': 1,             # Relay (1)
+    'ttl': 2,               # TTL (1)
+    'appkey': 3,            # NetKey index (1) + AppKey (16)
+    'publication': 4,       # Component (1) + Model (1) + Address (2) + AppKey index (1) + TTL (1)
+    'subscription': 5,      # Component (1) + Model (1) + Address (2)
+}
+RESULT_OK = 0
+RESULT_STATUS_ERROR = 1
+RESULT_TIMEOUT = 2
+RESULT_BUSY = 3
+RESULT_REJECTED = 4
+RESULT_NAMES = ['ok', 'status_error', 'timeout', 'busy', 'rejected']
+
+# Time the host waits for a result before it gives up on the gateway
+HOST_TIMEOUT_S = COMMISSION_TIMEOUT_MS / 1000.0 + 5.0
+BUSY_BACKOFF_S = 0.5
+
+
+def encode_parameters(name, args):
+    if name in ('relay', 'ttl'):
+        return bytes([int(args[0])])
+    if name == 'appkey':
+        key = bytes.fromhex(args[1])
+        if len(key) != 16:
+            raise ValueError('AppKey must be 16 bytes')
+        return bytes([int(args[0])]) + key
+    if name == 'publication':
+        return struct.pack('<BBHBB', int(args[0]), int(args[1]), int(args[2], 16),
+                           int(args[3]), int(args[4]))
+    if name == 'subscription':
+        return struct.pack('<BBH', int(args[0]), int(args[1]), int(args[2], 16))
+    raise ValueError('unknown operation %s' % name)
+
+
+def read_job(path, nodes):
+    """Returns {node: [(name, parameters), ...]} in file order."""
+    job = {}
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            fields = line.split('#', 1)[0].split()
+            if not fields:
+                continue
+            try:
+                operation = (fields[1], encode_parameters(fields[1], fields[2:]))
+            except (IndexError, ValueError) as error:
+                raise SystemExit('%s:%d: %s' % (path, number, error))
+            targets = nodes if fields[0] == '*' else [int(fields[0], 16)]
+            for node in targets:
+                job.setdefault(node, []).append(operation)
+    return job
+
+
+class Commissioner(object):
+    """Keeps up to window operations in flight, at most one per node.
+
+    send(frame) writes one framed request to the gateway, clock() returns seconds.
+    result() is called with every COMMISSION frame and tick() periodically.
+    """
+
+    def __init__(self, job, window, retries, send, clock):
+        self.pending = deque((node, deque(ops)) for node, ops in job.items())
+        self.window = window
+        self.retries = retries
+        self.send = send
+        self.clock = clock
+        self.in_flight = {}             # token -> [node, operation, ops, attempts, deadline]
+        self.delayed = []               # (time, node, ops, attempts) waiting after BUSY
+        self.next_token = 0
+        self.report = {}                # node -> (done, failed result or None)
+        self.sent = 0
+        self.retried = 0
+
+    def done(self):
+        return not self.pending and not self.in_flight and not self.delayed
+
+    def _start(self, node, ops, attempts):
+        name, parameters = ops[0]
+        token = self.next_token
+        self.next_token = (self.next_token + 1) & 0xFF
+        self.in_flight[token] = [node, name, ops, attempts, self.clock() + HOST_TIMEOUT_S]
+        request = struct.pack('<BHB', token, node, OPERATIONS[name]) + parameters
+        self.sent += 1
+        self.send(log_decoder.encode_command(UART_CMD_COMMISSION + request))
+
+    def _fill(self):
+        # A node is either pending, in flight or delayed, never two at once
+        now = self.clock()
+        for entry in sorted(self.delayed):
+            if len(self.in_flight) >= self.window or entry[0] > now:
+                break
+            self.delayed.remove(entry)
+            self._start(entry[1], entry[2], entry[3])
+        while self.pending and len(self.in_flight) < self.window:
+            node, ops = self.pending.popleft()
+            self._start(node, ops, 0)
+
+    def _finish(self, token, result, value):
+        node, name, ops, attempts, _ = self.in_flight.pop(token)
+        done = self.report.get(node, (0, None))[0]
+        if result == RESULT_OK:
+            ops.popleft()
+            self.report[node] = (done + 1, None)
+            if ops:
+                self.pending.append((node, ops))
+        elif result == RESULT_BUSY or (result == RESULT_TIMEOUT and attempts < self.retries):
+            self.retried += 1
+            attempts += 1 if result == RESULT_TIMEOUT else 0
+            self.delayed.append((self.clock() + BUSY_BACKOFF_S, node, ops, attempts))
+        else:
+            # Leave the remaining operations of the node, they may depend on this one
+            self.report[node] = (done, '%s %s (%d)' % (name, RESULT_NAMES[result], value))
+
+    def result(self, token, node, result, value):
+        entry = self.in_flight.get(token)
+        if entry is not None and entry[0] == node and result < len(RESULT_NAMES):
+            self._finish(token, result, value)
+        self._fill()
+
+    def tick(self):
+        now = self.clock()
+        for token in [t for t, entry in self.in_flight.items() if entry[4] <= now]:
+            self._finish(token, RESULT_TIMEOUT, 0)
+        self._fill()
+
+
+class CommissionSink(io.TextIOBase):
+    """Text sink for log_decoder.decode() that keeps the COMMISSION lines."""
+
+    def __init__(self, on_result):
+        self.buffer = ''
+        self.on_result = on_result
+
+    def write(self, text):
+        self.buffer += text
+        while '\n' in self.buffer:
+            line, self.buffer = self.buffer.split('\n', 1)
+            line = line.strip()
+            if line.startswith('COMMISSION,'):
+                fields = line.split(',')
+                self.on_result(int(fields[1]), int(fields[2], 16), int(fields[3]), int(fields[4]))
+        return len(text)
+
+
+class SimulatedMesh(object):
+    """Event driven model of the gateway (commission.c and the reliable message
+    queue of the library) and of the mesh between it and the nodes.
+
+    Every node is 1 to max_hops hops away. A message takes hop_ms plus a random
+    advertising delay per hop and is lost on every hop with probability loss.
+    The gateway radio sends one message per tx_slot_ms. A reliable message is
+    sent again every 5 s and times out after COMMISSION_TIMEOUT_MS.
+    """
+
+    RETRY_MS = 5000
+    UART_MS = 2
+
+    def __init__(self, nodes, rng, max_hops=4, hop_ms=30, jitter_ms=40, loss=0.02, tx_slot_ms=20):
+        self.rng = rng
+        self.hops = dict((node, rng.randint(1, max_hops)) for node in nodes)
+        self.hop_ms = hop_ms
+        self.jitter_ms = jitter_ms
+        self.loss = loss
+        self.tx_slot_ms = tx_slot_ms
+        self.now = 0
+        self.events = []
+        self.sequence = 0
+        self.radio_free = 0
+        self.slots = {}                 # node -> token, as commissionSlots
+        self.on_result = None
+
+    def clock(self):
+        return self.now / 1000.0
+
+    def _at(self, time_ms, action, *args):
+        self.sequence += 1
+        heapq.heappush(self.events, (time_ms, self.sequence, action, args))
+
+    def _path_ms(self, node):
+        """Latency one way, None if lost."""
+        total = 0
+        for _ in range(self.hops[node]):
+            if self.rng.random() < self.loss:
+                return None
+            total += self.hop_ms + self.rng.uniform(0, self.jitter_ms)
+        return total
+
+    def send(self, frame):
+        request = log_decoder.decode_command(frame)[1:]
+        self._at(self.now + self.UART_MS, self._request, request)
+
+    def _report(self, token, node, result, value=0):
+        self._at(self.now + self.UART_MS, self.on_result, token, node, result, value)
+
+    def _request(self, request):
+        token, node, _ = struct.unpack_from('<BHB', request, 0)
+        if len(self.slots) >= COMMISSION_WINDOW or node in self.slots:
+            self._report(token, node, RESULT_BUSY)
+            return
+        self.slots[node] = token
+        self._transmit(node, token, self.now)
+
+    def _transmit(self, node, token, start):
+        if self.slots.get(node) != token:
+            return
+        if self.now - start >= COMMISSION_TIMEOUT_MS:
+            del self.slots[node]
+            self._report(token, node, RESULT_TIMEOUT)
+            return
+        sent = max(self.now, self.radio_free)
+        self.radio_free = sent + self.tx_slot_ms
+        there = self._path_ms(node)
+        back = self._path_ms(node) if there is not None else None
+        if back is not None:
+            self._at(sent + there + back, self._status, node, token)
+        self._at(self.now + self.RETRY_MS, self._transmit, node, token, start)
+
+    def _status(self, node, token):
+        if self.slots.get(node) == token:
+            del self.slots[node]
+            self._report(token, node, RESULT_OK)
+
+    def run(self, commissioner):
+        def tick():
+            commissioner.tick()
+            self._at(self.now + 1000, tick)
+
+        tick()
+        while not commissioner.done():
+            self.now, _, action, args = heapq.heappop(self.events)
+            action(*args)
+        return self.clock()
+
+
+def simulate(args):
+    nodes = [0x0100 + i for i in range(args.nodes)]
+    job = {}
+    for node in nodes:
+        job[node] = [(name, encode_parameters(name, params)) for name, params in (
+            ('relay', ['1']),
+            ('ttl', ['20']),
+            ('appkey', ['0', '00' * 16]),
+            ('publication', ['0', '1', 'c001', '0', '20']),
+            ('subscription', ['0', '1', 'c002']),
+        )]
+
+    print('%d nodes, %d operations each, %.0f%% loss per hop'
+          % (len(nodes), len(job[nodes[0]]), 100.0 * args.loss))
+    print('%-8s %12s %10s %10s %10s' % ('window', 'seconds', 'sent', 'retried', 'failed'))
+    for window in args.window:
+        mesh = SimulatedMesh(nodes, random.Random(args.seed), loss=args.loss)
+        commissioner = Commissioner(dict((n, list(ops)) for n, ops in job.items()),
+                                    window, args.retries, mesh.send, mesh.clock)
+        mesh.on_result = commissioner.result
+        seconds = mesh.run(commissioner)
+        failed = sum(1 for _, failure in commissioner.report.values() if failure)
+        print('%-8d %12.1f %10d %10d %10d' % (window, seconds, commissioner.sent,
+                                              commissioner.retried, failed))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('elf', nargs='?', help='ELF file of the gateway firmware')
+    parser.add_argument('device', nargs='?', help='serial device of the gateway')
+    parser.add_argument('job', nargs='?', help='job file')
+    parser.add_argument('--nodes', nargs='+', default=[],
+                        help='node IDs (hex) for "*", or the node count with --simulate')
+    parser.add_argument('--window', type=int, nargs='+', default=[COMMISSION_WINDOW],
+                        help='operations in flight (at most %d)' % COMMISSION_WINDOW)
+    parser.add_argument('--retries', type=int, default=2, help='retries of a timed out operation')
+    parser.add_argument('--simulate', action='store_true', help='use a simulated gateway and mesh')
+    parser.add_argument('--loss', type=float, default=0.02, help='simulated loss per hop')
+    parser.add_argument('--seed', type=int, default=1)
+    args = parser.parse_args()
+
+    if [w for w in args.window if not 1 <= w <= COMMISSION_WINDOW]:
+        parser.error('--window must be 1 to %d' % COMMISSION_WINDOW)
+
+    if args.simulate:
+        args.nodes = int(args.nodes[0]) if args.nodes else 50
+        simulate(args)
+        return
+
+    if args.job is None:
+        parser.error('elf, device and job are required without --simulate')
+
+    job = read_job(args.job, [int(node, 16) for node in args.nodes])
+    elf = log_decoder.Elf32(args.elf)
+    fd = os.open(args.device, os.O_RDWR | os.O_NOCTTY)
+    lock = threading.Lock()
+    commissioner = Commissioner(job, args.window[0], args.retries,
+                                lambda command: os.write(fd, command), time.time)
+
+    def on_result(token, node, result, value):
+        with lock:
+            commissioner.result(token, node, result, value)
+
+    reader = threading.Thread(target=log_decoder.decode,
+                              args=(elf, os.fdopen(os.dup(fd), 'rb', buffering=0),
+                                    CommissionSink(on_result)))
+    reader.daemon = True
+    reader.start()
+
+    start = time.time()
+    while True:
+        with lock:
+            commissioner.tick()
+            if commissioner.done():
+                break
+        time.sleep(0.1)
+
+    failed = 0
+    print('node,done,total,failure')
+    for node in sorted(job):
+        done, failure = commissioner.report.get(node, (0, None))
+        failed += 1 if failure else 0
+        print('%04x,%d,%d,%s' % (node, done, len(job[node]), failure or ''))
+    sys.stderr.write('%d nodes in %.1f s, %d failed, %d retries\n'
+                     % (len(job), time.time() - start, failed, commissioner.retried))
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
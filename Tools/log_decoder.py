@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+"""Decode the deferred binary log of the mesh node back into text.
+
+DBG_LOGx() records are sent on the UART as
+
+    0xA5, <argument count>, <format string address>, <arguments...>
+
+with all values 32 bit little endian, mixed with plain printf() text. The
+format strings are looked up in the ELF file of the same build:
+
+    stty -F /dev/ttyACM0 115200 raw
+    log_decoder.py Mesh.cydsn/CortexM0/ARM_GCC_493/Debug/Mesh.elf /dev/ttyACM0
+
+A record with a NULL format address reports records dropped on a full ring.
+Binary frames (frame type >= 0x80 in place of the argument count, then a
+length byte and the payload) are printed as one text line each, e.g.
+"STATS,<node>,<first index>,<value>,..." for counter dumps,
+"TELEMETRY,<sink>,<field>,<nodes>,<value>" for merged fleet telemetry and
+"COMMISSION,<token>,<node>,<result>,<value>" for configuration results.
+
+Commands go the other way in SLIP (RFC 1055) frames, the command followed by
+its CRC-16/CCITT-FALSE, little endian; encode_command() builds them (see
+Firmware_Mesh/Mesh.cydsn/slip.c).
+"""
+
+import argparse
+import binascii
+import re
+import struct
+import sys
+
+SYNC = 0xA5
+MAX_ARGS = 4
+FRAME_TYPE_BASE = 0x80
+FRAME_STATS = 0x80
+FRAME_TELEMETRY = 0x81
+FRAME_COMMISSION = 0x82
+
+SLIP_END = 0xC0
+SLIP_ESC = 0xDB
+SLIP_ESC_END = 0xDC
+SLIP_ESC_ESC = 0xDD
+
+SHF_ALLOC = 0x2
+SHT_PROGBITS = 1
+
+FORMAT_RE = re.compile(r'%([-+ #0]*)(\d*|\*)(?:\.(\d+))?(hh|h|ll|l|z)?([diouxXcsp%])')
+
+
+class Elf32(object):
+    """Just enough of an ELF32 reader to fetch strings by address."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.image = f.read()
+        if self.image[:4] != b'\x7fELF' or self.image[4] != 1:
+            raise ValueError('%s is not an ELF32 file' % path)
+        endian = '<' if self.image[5] == 1 else '>'
+        (shoff,) = struct.unpack_from(endian + 'I', self.image, 0x20)
+        shentsize, shnum = struct.unpack_from(endian + 'HH', self.image, 0x2E)
+        self.sections = []
+        for index in range(shnum):
+            fields = struct.unpack_from(endian + 'IIIIIIIIII', self.image,
+                                        shoff + index * shentsize)
+            sh_type, sh_flags, sh_addr, sh_offset, sh_size = fields[1:6]
+            if sh_type == SHT_PROGBITS and sh_flags & SHF_ALLOC:
+                self.sections.append((sh_addr, sh_offset, sh_size))
+
+    def string_at(self, address):
+        for sh_addr, sh_offset, sh_size in self.sections:
+            if sh_addr <= address < sh_addr + sh_size:
+                start = sh_offset + address - sh_addr
+                end = self.image.index(b'\0', start, sh_offset + sh_size)
+                return self.image[start:end].decode('latin-1')
+        return None
+
+
+def render(elf, fmt, args):
+    args = list(args)
+
+    def substitute(match):
+        flags, width, precision, _, conv = match.groups()
+        if conv == '%':
+            return '%'
+        value = args.pop(0) if args else 0
+        spec = '%' + flags + width + ('.' + precision if precision else '')
+        if conv in 'di':
+            if value & 0x80000000:
+                value -= 1 << 32
+            return (spec + 'd') % value
+        if conv in 'ouxX':
+            return (spec + conv) % value
+        if conv == 'p':
+            return (spec + 's') % ('0x%08x' % value)
+        if conv == 'c':
+            return (spec + 'c') % chr(value & 0xFF)
+        text = elf.string_at(value)
+        return (spec + 's') % (text if text is not None else '<0x%08x>' % value)
+
+    return FORMAT_RE.sub(substitute, fmt)
+
+
+def format_frame(frame_type, payload):
+    if frame_type == FRAME_STATS and len(payload) >= 4:
+        node, first, count = struct.unpack_from('<HBB', payload, 0)
+        count = min(count, (len(payload) - 4) // 4)
+        values = struct.unpack_from('<%dI' % count, payload, 4)
+        return 'STATS,%04x,%d,%s\r\n' % (node, first, ','.join(str(v) for v in values))
+    if frame_type == FRAME_TELEMETRY and len(payload) >= 8:
+        sink, field, nodes, value = struct.unpack_from('<HBBI', payload, 0)
+        return 'TELEMETRY,%04x,%d,%d,%d\r\n' % (sink, field, nodes, value)
+    if frame_type == FRAME_COMMISSION and len(payload) >= 5:
+        token, node, result, value = struct.unpack_from('<BHBB', payload, 0)
+        return 'COMMISSION,%d,%04x,%d,%d\r\n' % (token, node, result, value)
+    return 'FRAME,%02x,%s\r\n' % (frame_type, payload.hex())
+
+
+def encode_command(command):
+    """One UART command as a SLIP frame, with its CRC."""
+    data = command + struct.pack('<H', binascii.crc_hqx(command, 0xFFFF))
+    frame = bytearray([SLIP_END])
+    for byte in data:
+        if byte == SLIP_END:
+            frame += bytes([SLIP_ESC, SLIP_ESC_END])
+        elif byte == SLIP_ESC:
+            frame += bytes([SLIP_ESC, SLIP_ESC_ESC])
+        else:
+            frame.append(byte)
+    frame.append(SLIP_END)
+    return bytes(frame)
+
+
+def decode_command(frame):
+    """The command in a frame of encode_command(), None if it is corrupt."""
+    data = bytearray()
+    escaped = False
+    for byte in frame.strip(bytes([SLIP_END])):
+        if escaped:
+            if byte not in (SLIP_ESC_END, SLIP_ESC_ESC):
+                return None
+            data.append(SLIP_END if byte == SLIP_ESC_END else SLIP_ESC)
+            escaped = False
+        elif byte == SLIP_ESC:
+            escaped = True
+        elif byte == SLIP_END:
+            return None
+        else:
+            data.append(byte)
+    if escaped or len(data) <= 2:
+        return None
+    command, (crc,) = bytes(data[:-2]), struct.unpack('<H', data[-2:])
+    return command if binascii.crc_hqx(command, 0xFFFF) == crc else None
+
+
+def decode(elf, stream, out):
+    pending = bytearray()
+    while True:
+        chunk = stream.read(1)
+        if not chunk:
+            break
+        pending += chunk
+        while pending:
+            if pending[0] != SYNC:
+                out.write(chr(pending.pop(0)))
+                continue
+            if len(pending) < 2:
+                break
+            count = pending[1]
+            if count >= FRAME_TYPE_BASE:
+                if len(pending) < 3 or len(pending) < 3 + pending[2]:
+                    break
+                payload = bytes(pending[3:3 + pending[2]])
+                out.write(format_frame(count, payload))
+                del pending[:3 + len(payload)]
+                continue
+            if count > MAX_ARGS:
+                # Not a record header, treat the byte as text
+                out.write(chr(pending.pop(0)))
+                continue
+            length = 6 + 4 * count
+            if len(pending) < length:
+                break
+            address, = struct.unpack_from('<I', pending, 2)
+            args = struct.unpack_from('<%dI' % count, pending, 6)
+            del pending[:length]
+            if address == 0:
+                out.write('<%d log records dropped>\r\n' % (args[0] if args else 0))
+                continue
+            fmt = elf.string_at(address)
+            if fmt is None:
+                out.write('<unknown format 0x%08x %s>\r\n' %
+                          (address, ' '.join('%08x' % a for a in args)))
+            else:
+                out.write(render(elf, fmt, args))
+        out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('elf', help='ELF file of the running firmware')
+    parser.add_argument('input', nargs='?', default='-',
+                        help='captured UART bytes or serial device (default: stdin)')
+    args = parser.parse_args()
+
+    elf = Elf32(args.elf)
+    if args.input == '-':
+        decode(elf, sys.stdin.buffer, sys.stdout)
+    else:
+        with open(args.input, 'rb', buffering=0) as stream:
+            decode(elf, stream, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()
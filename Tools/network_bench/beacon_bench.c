@@ -0,0 +1,539 @@
+/*******************************************************************************
+* Benchmark of Firmware_Mesh/SM Files/CyMesh_Beacon.c.
+*
+* Simulates one hour of a node with BENCH_NEIGHBOURS neighbours, each sending a
+* secure network beacon every CYMESH_BEACON_INTERVAL ms with some jitter, and
+* one SM timer tick (1 ms) at a time. The neighbours follow the IV update
+* state of the network some seconds late, so old and new beacons are heard
+* side by side around every change:
+*
+*   - the node asks for an IV update at 5 min, which starts once it has been
+*     CYMESH_BEACON_IV_UPDATE_MIN_TIME in the normal state, and it returns to
+*     the normal state by itself after the same time;
+*   - at 40 min a neighbour starts the next IV update, and the node follows.
+*
+* Some beacons carry a corrupted authentication value, and one neighbour is of
+* another network. Every authentication value is checked against a separate
+* RFC 4493 AES-CMAC, itself checked with the test vector of the RFC.
+*
+* The CMACs are counted with the manager, and as the library would need them
+* without it: one per received beacon of the network, and one per IV update
+* state of the node. The cycles of CyMesh_BeaconReceive() are reported for a
+* beacon found in the cache and, from beacons of older IV indexes received
+* after the hour, for one that needs a CMAC. The bench fails if
+* a change of IV update state calculates a CMAC, or if a corrupted beacon is
+* accepted. The minimum time in a state is shortened to 10 min so that the
+* hour sees both updates. From the repository root:
+*
+*   gcc -O2 -DCYMESH_BEACON_IV_UPDATE_MIN_TIME=600000u -I Tools/network_bench \
+*       -I "Firmware_Mesh/SM Files" -o beacon_bench Tools/network_bench/beacon_bench.c \
+*       "Firmware_Mesh/SM Files/CyMesh_Beacon.c" "Firmware_Mesh/SM Files/CyMesh_SecurityPVT.c" &&
+*   ./beacon_bench
+*
+* Cycles are only reported on x86 (TSC).
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <project.h>
+#include "CyMesh_Beacon.h"
+#include "CyMesh_SecurityPVT.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define BENCH_CYCLES()      (__rdtsc())
+#else
+    #define BENCH_CYCLES()      (0ull)
+#endif
+
+#define BENCH_DURATION          (3600000u)  /* ms */
+#define BENCH_NEIGHBOURS        (20u)
+#define BENCH_JITTER            (500u)      /* ms, on every beacon interval */
+#define BENCH_MAX_LAG           (30000u)    /* ms a neighbour follows the network late */
+#define BENCH_FORGED_PERCENT    (2u)
+#define BENCH_SEED              (1u)
+
+#define BENCH_REQUEST_TIME      (300000u)   /* The node asks for an IV update */
+#define BENCH_NEIGHBOUR_UPDATE  (2400000u)  /* A neighbour starts one */
+#define BENCH_INITIAL_IV_INDEX  (0x100u)
+#define BENCH_MISSES            (200u)      /* Beacons of older IV indexes, none cached */
+
+#define BENCH_MAX_CHANGES       (8u)
+
+/* Library state the manager uses */
+CYMESH_DEVICE_CONFIG_T cyMesh_ConfigInfoRam;
+uint8 CyMesh_ConfigInfoFlashUpdateRequired;
+uint8 cyMesh_ConfigurationBeaconCalculatedAuthValue[CYMESH_BEACON_AUTH_VALUE_SIZE];
+
+static uint32 libraryIvIndex;
+
+static const uint8 encryptionKey[16] =
+    {0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C};
+static const uint8 networkId[8] = {0x3E, 0xCA, 0xFF, 0x67, 0x2F, 0x67, 0x33, 0x70};
+static const uint8 otherNetworkId[8] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88};
+
+/* IV update state of the network over time: (time, flags, IV index) */
+static struct
+{
+    uint32 time;
+    uint8 flags;
+    uint32 ivIndex;
+} changes[BENCH_MAX_CHANGES];
+static uint32 changeCount;
+
+static struct
+{
+    uint32 nextBeacon;
+    uint32 lag;
+} neighbours[BENCH_NEIGHBOURS];
+
+
+uint8 CyEnterCriticalSection(void)
+{
+    return 0u;
+}
+
+
+void CyExitCriticalSection(uint8 savedIntrStatus)
+{
+    (void)savedIntrStatus;
+}
+
+
+cystatus CyBLE_Nvram_Write(const uint8 buffer[], const uint8 varFlash[], uint16 length)
+{
+    memcpy((uint8 *)varFlash, buffer, length);
+    return CYRET_SUCCESS;
+}
+
+
+void CyMesh_SecuritySetIVindex(uint8 meshId, uint32 newIVIndex)
+{
+    (void)meshId;
+    libraryIvIndex = newIVIndex;
+}
+
+
+uint32 CyMesh_SecurityGetIVindex(uint8 meshId)
+{
+    (void)meshId;
+    return libraryIvIndex;
+}
+
+
+CYMESH_API_RETURN_T __real_CyMesh_SecurityCalculateBeaconAuthValue(uint8 meshId, uint8 krBit, uint32 ivIndex,
+                                                                   CYMESH_SECURITY_CALLBACK callback)
+{
+    (void)meshId;
+    (void)krBit;
+    (void)ivIndex;
+    (void)callback;
+    return CYMESH_ERROR_INVALID_MESH_ID;
+}
+
+
+void __real_CyMesh_ConfigurationIncomingBeacon(uint32 event, CYMESH_BEARER_RX_BUFFER_T * rxBuffer)
+{
+    (void)event;
+    (void)rxBuffer;
+}
+
+
+/* AES-CMAC of RFC 4493, for any message length */
+static void ReferenceCmac(const uint8 * key, const uint8 * message, uint32 length, uint8 * mac)
+{
+    uint8 subkey[16];
+    uint8 block[16];
+    uint8 last[16];
+    uint32 blocks = (length + 15u) / 16u;
+    bool isComplete;
+    uint32 i;
+    uint32 n;
+
+    memset(block, 0, sizeof(block));
+    (void)CyMesh_SecurityPVTAesEncrypt(block, key, subkey);
+
+    isComplete = (blocks != 0u) && ((length % 16u) == 0u);
+    blocks = (blocks == 0u) ? 1u : blocks;
+
+    /* K1, then K2 for an incomplete last block */
+    for(n = 0; n < (isComplete ? 1u : 2u); n++)
+    {
+        uint8 msb = subkey[0] & 0x80u;
+
+        for(i = 0; i < 15u; i++)
+        {
+            subkey[i] = (uint8)(subkey[i] << 1) | (subkey[i + 1u] >> 7);
+        }
+        subkey[15] = (uint8)(subkey[15] << 1) ^ ((msb != 0u) ? 0x87u : 0x00u);
+    }
+
+    memset(last, 0, sizeof(last));
+    for(i = 0; i < (length - ((blocks - 1u) * 16u)); i++)
+    {
+        last[i] = message[((blocks - 1u) * 16u) + i];
+    }
+    if(isComplete == false)
+    {
+        last[length - ((blocks - 1u) * 16u)] = 0x80u;
+    }
+
+    memset(mac, 0, 16u);
+    for(n = 0; n < blocks; n++)
+    {
+        for(i = 0; i < 16u; i++)
+        {
+            mac[i] ^= (n == (blocks - 1u)) ? (last[i] ^ subkey[i]) : message[(n * 16u) + i];
+        }
+        (void)CyMesh_SecurityPVTAesEncrypt(mac, key, mac);
+    }
+}
+
+
+static bool CheckReferenceCmac(void)
+{
+    static const uint8 emptyMac[16] =
+        {0xBB, 0x1D, 0x69, 0x29, 0xE9, 0x59, 0x37, 0x28, 0x7F, 0xA3, 0x7D, 0x12, 0x9B, 0x75, 0x67, 0x46};
+    static const uint8 block[16] =
+        {0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96, 0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A};
+    static const uint8 blockMac[16] =
+        {0x07, 0x0A, 0x16, 0xB4, 0x6B, 0x4D, 0x41, 0x44, 0xF7, 0x9B, 0xDD, 0x9D, 0xD0, 0x4A, 0x28, 0x7C};
+    uint8 mac[16];
+    bool isOk;
+
+    ReferenceCmac(encryptionKey, NULL, 0u, mac);
+    isOk = (memcmp(mac, emptyMac, sizeof(mac)) == 0);
+    ReferenceCmac(encryptionKey, block, sizeof(block), mac);
+    isOk = isOk && (memcmp(mac, blockMac, sizeof(mac)) == 0);
+
+    if(isOk == false)
+    {
+        printf("reference AES-CMAC does not match RFC 4493\n");
+    }
+    return isOk;
+}
+
+
+static void MakeBeacon(const uint8 * netId, uint8 flags, uint32 ivIndex, uint8 * pdu)
+{
+    uint8 mac[16];
+
+    pdu[0] = CYMESH_BEARER_BEACON_TYPE_SECURE_BEACON;
+    pdu[1] = flags;
+    memcpy(&pdu[2], netId, CYMESH_BEACON_NETWORK_ID_SIZE);
+    pdu[10] = (uint8)(ivIndex >> 24);
+    pdu[11] = (uint8)(ivIndex >> 16);
+    pdu[12] = (uint8)(ivIndex >> 8);
+    pdu[13] = (uint8)ivIndex;
+    ReferenceCmac(encryptionKey, &pdu[1], 13u, mac);
+    memcpy(&pdu[14], mac, CYMESH_BEACON_AUTH_VALUE_SIZE);
+}
+
+
+static void AddChange(uint32 time, uint8 flags, uint32 ivIndex)
+{
+    if(changeCount < BENCH_MAX_CHANGES)
+    {
+        changes[changeCount].time = time;
+        changes[changeCount].flags = flags;
+        changes[changeCount].ivIndex = ivIndex;
+        changeCount++;
+    }
+}
+
+
+/* Beacon of the node, as the network sees it */
+static void NodeState(uint8 * flags, uint32 * ivIndex)
+{
+    uint8 pdu[CYMESH_BEACON_SECURE_LENGTH];
+
+    if(CyMesh_BeaconGetSecureBeacon(pdu) == true)
+    {
+        *flags = pdu[1];
+        *ivIndex = ((uint32)pdu[10] << 24) | ((uint32)pdu[11] << 16) | ((uint32)pdu[12] << 8) | pdu[13];
+    }
+}
+
+
+/* The state of the network a neighbour lagging behind still announces */
+static uint32 StateAt(uint32 time)
+{
+    uint32 i = changeCount - 1u;
+
+    while((i > 0u) && (changes[i].time > time))
+    {
+        i--;
+    }
+    return i;
+}
+
+
+static void Start(void)
+{
+    CYMESH_NETWORK_KEYS_T * netKey = &cyMesh_ConfigInfoRam.netInfo.netKeys[0];
+
+    memset(&cyMesh_ConfigInfoRam, 0, sizeof(cyMesh_ConfigInfoRam));
+    memcpy(netKey->encryptionKey, encryptionKey, sizeof(encryptionKey));
+    memcpy(netKey->networkId, networkId, sizeof(networkId));
+    netKey->ivIndex = BENCH_INITIAL_IV_INDEX;
+    libraryIvIndex = BENCH_INITIAL_IV_INDEX;
+
+    CyMesh_BeaconStart();
+}
+
+
+static bool CheckOwnBeacon(void)
+{
+    uint8 pdu[CYMESH_BEACON_SECURE_LENGTH];
+    uint8 expected[CYMESH_BEACON_SECURE_LENGTH];
+
+    if(CyMesh_BeaconGetSecureBeacon(pdu) == false)
+    {
+        printf("no beacon of the node\n");
+        return false;
+    }
+
+    MakeBeacon(networkId, pdu[1], ((uint32)pdu[10] << 24) | ((uint32)pdu[11] << 16) | ((uint32)pdu[12] << 8) | pdu[13],
+               expected);
+    if(memcmp(pdu, expected, sizeof(pdu)) != 0)
+    {
+        printf("beacon of the node does not authenticate\n");
+        return false;
+    }
+    if(memcmp(cyMesh_ConfigurationBeaconCalculatedAuthValue, &pdu[14], CYMESH_BEACON_AUTH_VALUE_SIZE) != 0)
+    {
+        printf("authentication value of the library not updated\n");
+        return false;
+    }
+    return true;
+}
+
+
+static uint8 nodeFlags;
+static uint32 nodeIvIndex = BENCH_INITIAL_IV_INDEX;
+static uint32 transitions;
+static uint32 transitionCmacs;
+static uint32 failures;
+
+/* After a call that may change the IV update state of the node. The value of
+ * the new state must have been ready, and the network follows the node. */
+static void Observe(uint32 now, uint32 cmacCount)
+{
+    uint8 flags = nodeFlags;
+    uint32 ivIndex = nodeIvIndex;
+
+    NodeState(&nodeFlags, &nodeIvIndex);
+    if((nodeFlags == flags) && (nodeIvIndex == ivIndex))
+    {
+        return;
+    }
+
+    transitions++;
+    transitionCmacs += cyMesh_BeaconStats.cmacCount - cmacCount;
+    if((changes[changeCount - 1u].flags != nodeFlags) || (changes[changeCount - 1u].ivIndex != nodeIvIndex))
+    {
+        AddChange(now, nodeFlags, nodeIvIndex);
+    }
+    printf("%7.1f s  node %s, IV index %u, library IV index %u\n", now / 1000.0,
+           (nodeFlags != 0u) ? "update in progress" : "normal", nodeIvIndex, libraryIvIndex);
+
+    if(CheckOwnBeacon() == false)
+    {
+        failures++;
+    }
+}
+
+
+static uint8 libraryCmac[16];
+static uint32 libraryCallbacks;
+
+static void LibraryCallback(uint8 * cmac)
+{
+    memcpy(libraryCmac, cmac, sizeof(libraryCmac));
+    libraryCallbacks++;
+}
+
+
+/* The library asks for the value of the node when its credentials change,
+ * and waits for the callback */
+static bool CheckLibraryCall(void)
+{
+    uint8 pdu[CYMESH_BEACON_SECURE_LENGTH];
+    uint32 cmacCount = cyMesh_BeaconStats.cmacCount;
+
+    (void)CyMesh_BeaconGetSecureBeacon(pdu);
+    if((__wrap_CyMesh_SecurityCalculateBeaconAuthValue(0u, 0u, libraryIvIndex, LibraryCallback) != CYMESH_ERROR_OK) ||
+       (libraryCallbacks != 1u) || (memcmp(libraryCmac, &pdu[14], CYMESH_BEACON_AUTH_VALUE_SIZE) != 0) ||
+       (cyMesh_BeaconStats.cmacCount != cmacCount))
+    {
+        printf("library request not answered from the cache before returning\n");
+        return false;
+    }
+    return true;
+}
+
+
+int main(void)
+{
+    unsigned long long hitCycles = 0ull;
+    unsigned long long missCycles = 0ull;
+    uint32 hits = 0u;
+    uint32 misses = 0u;
+    uint32 received = 0u;
+    uint32 ownNetwork = 0u;
+    uint32 forged = 0u;
+    uint32 forgedOwn = 0u;
+    uint32 forgedAccepted = 0u;
+    uint32 libraryCmacs;
+    uint32 managerCmacs;
+    uint32 now;
+    uint32 i;
+
+    srand(BENCH_SEED);
+
+    if(CheckReferenceCmac() == false)
+    {
+        return 1;
+    }
+
+    Start();
+    AddChange(0u, 0u, BENCH_INITIAL_IV_INDEX);
+    for(i = 0; i < BENCH_NEIGHBOURS; i++)
+    {
+        neighbours[i].nextBeacon = (uint32)rand() % CYMESH_BEACON_INTERVAL;
+        neighbours[i].lag = (i == 0u) ? 0u : ((uint32)rand() % BENCH_MAX_LAG);
+    }
+
+    for(now = 1u; now <= BENCH_DURATION; now++)
+    {
+        uint32 cmacCount = cyMesh_BeaconStats.cmacCount;
+
+        CyMesh_BeaconUpdate();
+        Observe(now, cmacCount);
+
+        if(now == BENCH_REQUEST_TIME)
+        {
+            (void)CyMesh_BeaconRequestIvUpdate();
+        }
+
+        if((now == BENCH_NEIGHBOUR_UPDATE) && (changes[changeCount - 1u].flags == 0u))
+        {
+            AddChange(now, CYMESH_BEACON_FLAG_IV_UPDATE, changes[changeCount - 1u].ivIndex + 1u);
+        }
+
+        for(i = 0; i < BENCH_NEIGHBOURS; i++)
+        {
+            uint8 pdu[CYMESH_BEACON_SECURE_LENGTH];
+            uint32 state;
+            unsigned long long cycles;
+            uint32 before;
+            bool isForged;
+            bool isAccepted;
+
+            if(neighbours[i].nextBeacon != now)
+            {
+                continue;
+            }
+            neighbours[i].nextBeacon = now + CYMESH_BEACON_INTERVAL - (BENCH_JITTER / 2u) +
+                                       ((uint32)rand() % BENCH_JITTER);
+
+            state = StateAt((now > neighbours[i].lag) ? (now - neighbours[i].lag) : 0u);
+            MakeBeacon((i == (BENCH_NEIGHBOURS - 1u)) ? otherNetworkId : networkId,
+                       changes[state].flags, changes[state].ivIndex, pdu);
+
+            isForged = (((uint32)rand() % 100u) < BENCH_FORGED_PERCENT);
+            if(isForged == true)
+            {
+                pdu[14 + ((uint32)rand() % CYMESH_BEACON_AUTH_VALUE_SIZE)] ^= (uint8)(1u << ((uint32)rand() % 8u));
+                forged++;
+                forgedOwn += (i == (BENCH_NEIGHBOURS - 1u)) ? 0u : 1u;
+            }
+
+            received++;
+            ownNetwork += (i == (BENCH_NEIGHBOURS - 1u)) ? 0u : 1u;
+            before = cyMesh_BeaconStats.cmacCount;
+            cycles = BENCH_CYCLES();
+            isAccepted = CyMesh_BeaconReceive(pdu, sizeof(pdu));
+            cycles = BENCH_CYCLES() - cycles;
+            Observe(now, before);
+
+            if((isForged == true) && (isAccepted == true))
+            {
+                forgedAccepted++;
+            }
+            if((i != (BENCH_NEIGHBOURS - 1u)) && (cyMesh_BeaconStats.cmacCount == before))
+            {
+                hitCycles += cycles;
+                hits++;
+            }
+        }
+    }
+
+    /* Accepted and cached, but a node behind does not move the IV index. The
+     * last two IV indexes may still be cached. */
+    managerCmacs = cyMesh_BeaconStats.cmacCount;
+    for(i = 3u; i < (BENCH_MISSES + 3u); i++)
+    {
+        uint8 pdu[CYMESH_BEACON_SECURE_LENGTH];
+        uint32 before = cyMesh_BeaconStats.cmacCount;
+        unsigned long long cycles;
+
+        MakeBeacon(networkId, 0u, nodeIvIndex - i, pdu);
+        cycles = BENCH_CYCLES();
+        (void)CyMesh_BeaconReceive(pdu, sizeof(pdu));
+        missCycles += BENCH_CYCLES() - cycles;
+        misses += cyMesh_BeaconStats.cmacCount - before;
+    }
+    if(misses != BENCH_MISSES)
+    {
+        printf("%u of %u beacons of older IV indexes found in the cache\n", BENCH_MISSES - misses, BENCH_MISSES);
+        failures++;
+    }
+
+    if(CheckOwnBeacon() == false)
+    {
+        failures++;
+    }
+    if(CheckLibraryCall() == false)
+    {
+        failures++;
+    }
+    if(forgedAccepted != 0u)
+    {
+        printf("%u corrupted beacons accepted\n", forgedAccepted);
+        failures++;
+    }
+    if(cyMesh_BeaconStats.authFailures != forgedOwn)
+    {
+        printf("%u beacons rejected, %u corrupted\n", cyMesh_BeaconStats.authFailures, forgedOwn);
+        failures++;
+    }
+    if(transitionCmacs != 0u)
+    {
+        printf("%u CMACs calculated on a change of IV update state\n", transitionCmacs);
+        failures++;
+    }
+    if((nodeFlags != 0u) || (nodeIvIndex != (BENCH_INITIAL_IV_INDEX + 2u)) || (libraryIvIndex != nodeIvIndex))
+    {
+        printf("node did not complete both IV updates\n");
+        failures++;
+    }
+
+    /* One per received beacon of the network, one per state of the node */
+    libraryCmacs = ownNetwork + 1u + transitions;
+
+    printf("\n%u neighbours, %u beacons received (%u of the network, %u corrupted), %u IV update state changes\n",
+           BENCH_NEIGHBOURS, received, ownNetwork, forged, transitions);
+    printf("%-10s %14s\n", "", "CMACs / hour");
+    printf("%-10s %14u\n", "library", libraryCmacs);
+    printf("%-10s %14u\n", "manager", managerCmacs);
+    printf("%-10s %14u\n", "avoided", libraryCmacs - managerCmacs);
+    printf("cache hits %u, auth failures %u, other network %u\n", cyMesh_BeaconStats.cacheHits,
+           cyMesh_BeaconStats.authFailures, cyMesh_BeaconStats.otherNetwork);
+    printf("receive: %.1f cycles from the cache, %.1f cycles with a CMAC\n",
+           (hits == 0u) ? 0.0 : (double)hitCycles / hits, (misses == 0u) ? 0.0 : (double)missCycles / misses);
+
+    return (failures == 0u) ? 0 : 1;
+}
+
+/* [] END OF FILE */
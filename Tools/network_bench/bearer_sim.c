@@ -0,0 +1,964 @@
+/*******************************************************************************
+* Bearer simulation of Firmware_Mesh/SM Files/CyMesh_BearerTx.c and
+* CyMesh_BearerRx.c.
+*
+* TX: one relay node is run 1 ms at a time for SIM_DURATION_MS at several
+* rates of data beacons (custom ADVs sent SIM_BEACON_TX_COUNT times, as the
+* application of main.c does), with a secure network beacon every 10 s,
+* network PDUs of the node and PDUs to relay arriving at random.
+*
+* The TX buffer of the library bearer is modelled from CyMesh_Bearer.o: its
+* CYMESH_BEARER_ADV_TX_BUFFER_SIZE entries are taken round-robin, each at most
+* once per CYMESH_BEARER_NON_CONN_ADV_INTERVAL_MS, an advertisement starts
+* after a random delay of up to 8 ms and the next one is looked for 5 ms after
+* it. The radio does not scan from the start of an advertisement until the
+* bearer returns to scanning, after a packet that asks for it or when none is
+* left, plus SIM_SWITCH_US; the delay before a packet sent back to back is
+* spent advertising. Every rate is run with the packets sent to this model
+* directly, as the library does, and through the TX scheduler, which feeds the
+* model from the SM tick.
+*
+* Relay latency is the time from the packet reaching the bearer to its first
+* transmission. PDUs of the node are done once sent their number of times. A
+* packet refused by a full buffer or quota is dropped.
+*
+* Slots: the relay node hears each flood from SIM_SLOT_NEIGHBOURS neighbours
+* that relay it after the delay of their bearer, with the burst offset when
+* they run the scheduler, and sends its data beacons. A copy is received if
+* the node scans when it arrives and no other copy is within SIM_AIR_US. The
+* node relays a flood the first time it receives it. Reported per offered
+* load: scan duty, copies and floods received, relay latency and drops.
+*
+* RX: bursts of mesh ADVs, as when several neighbours relay the same flood,
+* arrive at random, SIM_RX_FOREIGN_PERCENT of them from another network. The
+* main loop gives the BLE stack SIM_RX_LOOP_US, and each network PDU it passes
+* on keeps it busy for SIM_RX_PROCESS_US, during which the next reports wait
+* in the stack. Every burst size is run with the
+* CYMESH_BEARER_ADV_RX_BUFFER_SIZE entries of the library bearer, which take
+* every mesh packet, and with the filter and ring of the RX path.
+*
+* The simulation fails if the scheduler loses or repeats a transmission, if
+* it does not lower the longest relay latency under beacon load, if it scans
+* less than CYMESH_BEARER_TX_MIN_SCAN_PERCENT or receives fewer floods than the
+* library at the highest load, if the RX path loses track of a packet, or if
+* it drops more than the library. The slot and RX ring options of the
+* scheduler are build options. From the repository root:
+*
+*   gcc -O2 -I Tools/network_bench -I "Firmware_Mesh/SM Files" -o bearer_sim \
+*       Tools/network_bench/bearer_sim.c "Firmware_Mesh/SM Files/CyMesh_BearerTx.c" \
+*       "Firmware_Mesh/SM Files/CyMesh_BearerRx.c" &&
+*   ./bearer_sim
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <project.h>
+#include "CyMesh_BearerTx.h"
+#include "CyMesh_BearerRx.h"
+#include "CyMesh_Configuration.h"
+
+#define SIM_DURATION_MS         (600000u)
+#define SIM_DRAIN_MS            (10000u)    /* After the run, to empty the queues */
+#define SIM_SEED                (1u)
+
+#define SIM_RELAY_PER_S         (5u)
+#define SIM_RELAY_TX_COUNT      (1u)
+#define SIM_OWN_PER_S           (1u)
+#define SIM_OWN_TX_COUNT        (3u)
+#define SIM_BEACON_TX_COUNT     (3u)
+#define SIM_SECURE_BEACON_MS    (10000u)
+
+/* Library bearer, see CyMesh_BearerIsItTime() and CyMesh_BearerScheduleAdv() */
+#define SIM_ADV_GAP_MS          (4u)
+#define SIM_ADV_DELAY_STEP_US   (250u)
+#define SIM_ADV_DELAY_MASK      (31u)
+#define SIM_SWITCH_US           (1000u)     /* Stack event from advertising to scanning */
+
+#define SIM_MAX_PACKETS         (65536u)
+
+#define SIM_RX_DURATION_MS      (600000u)
+#define SIM_RX_BURSTS_PER_S     (2u)
+#define SIM_RX_BURST_SPREAD_US  (10000u)    /* Relays of a flood, within the bearer delay */
+#define SIM_RX_FOREIGN_PERCENT  (25u)
+#define SIM_RX_LOOP_US          (1000u)
+#define SIM_RX_PROCESS_US       (1500u)     /* Network PDU, decryption and relay */
+#define SIM_RX_REJECT_US        (50u)       /* Network PDU of an unknown NID */
+#define SIM_RX_MAX_PENDING      (1024u)
+
+#define SIM_SLOT_DURATION_MS    (60000u)
+#define SIM_SLOT_NEIGHBOURS     (3u)        /* Copies of each flood heard */
+#define SIM_SLOT_BEACONS_PER_S  (5u)        /* Data beacons of the node, SIM_BEACON_TX_COUNT times */
+#define SIM_AIR_US              (400u)      /* Copies closer than this collide */
+
+#define SIM_NID                 (0x35u)
+#define SIM_FOREIGN_NID         (0x4Au)
+
+typedef enum
+{
+    SIM_RELAY,
+    SIM_OWN,
+    SIM_BEACON
+} SIM_SOURCE_T;
+
+typedef struct
+{
+    uint32 queuedUs;
+    uint32 firstUs;
+    uint32 lastUs;
+    uint8 source;
+    uint8 txCount;
+    uint8 sent;
+} SIM_PACKET_T;
+
+static SIM_PACKET_T packets[SIM_MAX_PACKETS];
+static uint32 packetCount;
+
+/* Model of the library TX buffer and radio */
+static struct
+{
+    CYMESH_BEARER_TX_BUFFER_T entry[CYMESH_BEARER_ADV_TX_BUFFER_SIZE];
+    uint8 total;
+    uint8 outPointer;
+    uint32 lastAdv;
+    uint32 busyUntilUs;
+
+    /* Advertising since deafUs, to scan after the current advertisement */
+    bool isAdvertising;
+    bool isScanFollowed;
+    uint32 deafUs;
+} library;
+
+/* Times the radio did not scan, in order */
+static uint32 deafStartUs[SIM_MAX_PACKETS];
+static uint32 deafEndUs[SIM_MAX_PACKETS];
+static uint32 deafCount;
+
+static uint32 nowUs;
+static uint32 timeBaseMs;
+static uint32 transmissions;
+
+uint8 cySimSflashDie[2] = {0x17u, 0x2Cu};
+
+/* RX: reports held by the BLE stack, arrival times */
+CYMESH_DEVICE_CONFIG_T cyMesh_ConfigInfoRam;
+
+static uint32 pendingUs[SIM_RX_MAX_PENDING];
+static uint8 pendingNid[SIM_RX_MAX_PENDING];
+static uint32 pendingCount;
+static CYBLE_CALLBACK_T stackCallback;
+static uint32 rxProcessed;
+
+
+uint8 CyEnterCriticalSection(void)
+{
+    return 0u;
+}
+
+
+void CyExitCriticalSection(uint8 savedIntrStatus)
+{
+    (void)savedIntrStatus;
+}
+
+
+cystatus CyBLE_Nvram_Write(const uint8 buffer[], const uint8 varFlash[], uint16 length)
+{
+    memcpy((uint8 *)varFlash, buffer, length);
+    return CYRET_SUCCESS;
+}
+
+
+/* The scheduler keeps its time across the runs, which restart nowUs */
+uint32 CyMesh_TimerGetTimestamp(void)
+{
+    return timeBaseMs + (nowUs / 1000u);
+}
+
+
+CYMESH_API_RETURN_T __real_CyMesh_BearerSendData(const uint8 * data, uint8 length,
+                                                 CYMESH_BEARER_PACKET_TYPE_T packetType, uint8 txCount,
+                                                 bool priority, bool isScanFollowed)
+{
+    uint8 i;
+
+    for(i = 0u; i < CYMESH_BEARER_ADV_TX_BUFFER_SIZE; i++)
+    {
+        CYMESH_BEARER_TX_BUFFER_T * entry = &library.entry[i];
+
+        if((entry->info & 0x01u) == 0u)
+        {
+            entry->info = 0x01u | (priority ? 0x02u : 0u) | (isScanFollowed ? 0x04u : 0u);
+            memcpy(entry->data, data, length);
+            entry->length = length;
+            entry->count = txCount;
+            entry->timestamp = 0u;
+            entry->packetType = packetType;
+            library.total++;
+            return CYMESH_ERROR_OK;
+        }
+    }
+
+    return CYMESH_ERROR_BEARER_TX_BUFFER_FULL;
+}
+
+
+CYMESH_BEARER_TX_BUFFER_STATE_T __real_CyMesh_BearerGetTxBufferStatus(void)
+{
+    if(library.total == 0u)
+    {
+        return CYMESH_BEARER_TX_BUFFER_EMPTY;
+    }
+    if(library.total == CYMESH_BEARER_ADV_TX_BUFFER_SIZE)
+    {
+        return CYMESH_BEARER_TX_BUFFER_FULL;
+    }
+    return (library.total <= 5u) ? CYMESH_BEARER_TX_BUFFER_FREE : CYMESH_BEARER_TX_BUFFER_BUSY;
+}
+
+
+uint8 CyMesh_SecurityFindMeshId(const uint8 * nID, uint8 numberOfBits, uint8 * meshId)
+{
+    static const uint8 networkId[8] = {0x3E, 0xCA, 0xFF, 0x67, 0x2F, 0x67, 0x33, 0x70};
+
+    meshId[0] = 0u;
+    if(numberOfBits == 7u)
+    {
+        return ((nID[0] & 0x7Fu) == SIM_NID) ? 1u : 0u;
+    }
+    return (memcmp(nID, networkId, sizeof(networkId)) == 0) ? 1u : 0u;
+}
+
+
+void CyMesh_ConfigurationIncomingBeacon(uint32 event, CYMESH_BEARER_RX_BUFFER_T * rxBuffer)
+{
+    (void)event;
+    (void)rxBuffer;
+}
+
+
+CYBLE_API_RESULT_T __real_CyBle_Start(CYBLE_CALLBACK_T callbackFunc)
+{
+    stackCallback = callbackFunc;
+    return 0u;
+}
+
+
+/* The GATT proxy of CyMesh_BearerProxy.c is not connected here, see
+ * proxy_bench.c */
+bool CyMesh_BearerProxyEvent(uint32 event, void * eventParam)
+{
+    (void)event;
+    (void)eventParam;
+    return false;
+}
+
+
+void CyMesh_BearerProxyUpdate(void)
+{
+}
+
+
+/* Library event handler, gets the reports that are not mesh packets */
+static void SimLibraryEventHandler(uint32 event, void * eventParam)
+{
+    (void)event;
+    (void)eventParam;
+}
+
+
+CYMESH_API_RETURN_T __real_CyMesh_BearerStart(CYMESH_CALLBACK_T meshEventCallback)
+{
+    (void)meshEventCallback;
+    (void)__wrap_CyBle_Start(SimLibraryEventHandler);
+    return CYMESH_ERROR_OK;
+}
+
+
+/* CyBle_ProcessEvents(): the reports received so far */
+void __real_CyMesh_BearerProcessEvents(void)
+{
+    uint8 data[CYMESH_BEARER_ADV_MAX_LENGTH] = {29u, CYMESH_BEARER_RX_AD_TYPE_MESH};
+    uint8 address[CYMESH_BEARER_BD_ADDRESS_LENGTH] = {0u};
+    CYBLE_GAPC_ADV_REPORT_T report;
+    uint32 kept = 0u;
+    uint32 i;
+
+    report.eventType = CYBLE_GAPC_NON_CONN_UNDIRECTED_ADV;
+    report.peerAddrType = 0u;
+    report.peerBdAddr = address;
+    report.dataLen = sizeof(data);
+    report.data = data;
+    report.rssi = -60;
+
+    for(i = 0u; i < pendingCount; i++)
+    {
+        if(pendingUs[i] <= nowUs)
+        {
+            data[2] = pendingNid[i];
+            stackCallback(CYBLE_EVT_GAPC_SCAN_PROGRESS_RESULT, &report);
+        }
+        else
+        {
+            pendingUs[kept] = pendingUs[i];
+            pendingNid[kept] = pendingNid[i];
+            kept++;
+        }
+    }
+    pendingCount = kept;
+}
+
+
+static CYMESH_API_RETURN_T SimNetworkCallback(uint32 event, void * eventParam)
+{
+    (void)event;
+    (void)eventParam;
+    nowUs += SIM_RX_PROCESS_US;
+    rxProcessed++;
+    return CYMESH_ERROR_OK;
+}
+
+
+static void SimOnAir(const CYMESH_BEARER_TX_BUFFER_T * entry, uint32 timeUs)
+{
+    uint32 id;
+    SIM_PACKET_T * packet;
+
+    memcpy(&id, entry->data, sizeof(id));
+    packet = &packets[id];
+    if(packet->sent == 0u)
+    {
+        packet->firstUs = timeUs;
+    }
+    packet->lastUs = timeUs;
+    packet->sent++;
+    transmissions++;
+}
+
+
+static void SimDeaf(uint32 startUs, uint32 endUs)
+{
+    if((deafCount < SIM_MAX_PACKETS) && (endUs > startUs))
+    {
+        deafStartUs[deafCount] = startUs;
+        deafEndUs[deafCount] = endUs;
+        deafCount++;
+    }
+}
+
+
+/* FindNewAdvertisement() and ScheduleAdv(): the next entry round-robin that
+ * has not been sent for CYMESH_BEARER_NON_CONN_ADV_INTERVAL_MS goes on the air
+ * after the random delay, which the main loop waits for */
+static bool SimLibrarySchedule(uint32 now)
+{
+    uint8 i;
+
+    for(i = 1u; i <= CYMESH_BEARER_ADV_TX_BUFFER_SIZE; i++)
+    {
+        uint8 index = (library.outPointer + i) % CYMESH_BEARER_ADV_TX_BUFFER_SIZE;
+        CYMESH_BEARER_TX_BUFFER_T * entry = &library.entry[index];
+
+        if(((entry->info & 0x01u) != 0u) && ((now - entry->timestamp) > CYMESH_BEARER_NON_CONN_ADV_INTERVAL_MS))
+        {
+            uint32 onAirUs = nowUs + ((uint32)(rand() & SIM_ADV_DELAY_MASK) * SIM_ADV_DELAY_STEP_US);
+
+            library.outPointer = index;
+            library.isScanFollowed = ((entry->info & 0x04u) != 0u);
+            SimOnAir(entry, onAirUs);
+            library.busyUntilUs = onAirUs;
+            entry->count--;
+            entry->timestamp = onAirUs / 1000u;
+            library.lastAdv = entry->timestamp;
+            if(entry->count == 0u)
+            {
+                entry->info = 0u;
+                library.total--;
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/* CyMesh_BearerProcessEvents(). While scanning a packet is scheduled at once,
+ * and the scan stops when it goes on the air. While advertising, once
+ * IsItTime(), the bearer scans if the last packet asked for it or none is
+ * left, and schedules the next one otherwise. */
+static void SimLibraryProcess(void)
+{
+    uint32 now = nowUs / 1000u;
+
+    if(nowUs < library.busyUntilUs)
+    {
+        return;
+    }
+
+    if(library.isAdvertising == false)
+    {
+        if((library.total != 0u) && (SimLibrarySchedule(now) == true))
+        {
+            library.isAdvertising = true;
+            library.deafUs = library.busyUntilUs;
+        }
+        return;
+    }
+
+    if((now - library.lastAdv) <= SIM_ADV_GAP_MS)
+    {
+        return;
+    }
+    if((library.isScanFollowed == false) && (library.total != 0u) && (SimLibrarySchedule(now) == true))
+    {
+        return;
+    }
+
+    /* The scan starts once the stack reports the end of the advertisement */
+    library.isAdvertising = false;
+    library.isScanFollowed = false;
+    library.busyUntilUs = nowUs + SIM_SWITCH_US;
+    SimDeaf(library.deafUs, library.busyUntilUs);
+}
+
+
+/* Whether the radio scans at timeUs, for times in order before nowUs */
+static bool SimIsScanning(uint32 timeUs, uint32 * deafIndex)
+{
+    while((*deafIndex < deafCount) && (deafEndUs[*deafIndex] <= timeUs))
+    {
+        (*deafIndex)++;
+    }
+
+    if((*deafIndex < deafCount) && (deafStartUs[*deafIndex] <= timeUs))
+    {
+        return false;
+    }
+
+    return (library.isAdvertising == false) || (timeUs < library.deafUs);
+}
+
+
+static void SimSend(bool useScheduler, SIM_SOURCE_T source, uint32 * dropped)
+{
+    static const uint8 txCount[] = {SIM_RELAY_TX_COUNT, SIM_OWN_TX_COUNT, SIM_BEACON_TX_COUNT};
+    uint8 data[CYMESH_BEARER_ADV_MAX_LENGTH] = {0u};
+    uint32 id = packetCount;
+    CYMESH_BEARER_PACKET_TYPE_T type = (source == SIM_BEACON) ? CYMESH_BEARER_CUSTOM_ADV : CYMESH_BEARER_ADV;
+    CYMESH_API_RETURN_T result;
+
+    memcpy(data, &id, sizeof(id));
+
+    if(useScheduler == false)
+    {
+        result = __real_CyMesh_BearerSendData(data, sizeof(data), type, txCount[source], false, true);
+    }
+    else if(source == SIM_BEACON)
+    {
+        result = __wrap_CyMesh_BearerSendData(data, sizeof(data), type, txCount[source], false, true);
+    }
+    else
+    {
+        result = CyMesh_BearerTxSend(data, sizeof(data), type,
+                                     (source == SIM_RELAY) ? CYMESH_BEARER_TX_CLASS_RELAY
+                                                           : CYMESH_BEARER_TX_CLASS_NETWORK,
+                                     txCount[source], true);
+    }
+
+    if(result != CYMESH_ERROR_OK)
+    {
+        dropped[source]++;
+        return;
+    }
+
+    packets[id].queuedUs = nowUs;
+    packets[id].source = source;
+    packets[id].txCount = txCount[source];
+    packets[id].sent = 0u;
+    packetCount++;
+}
+
+
+static void SimReset(void)
+{
+    memset(&library, 0, sizeof(library));
+    library.outPointer = CYMESH_BEARER_ADV_TX_BUFFER_SIZE - 1u;
+    packetCount = 0u;
+    transmissions = 0u;
+    deafCount = 0u;
+    srand(SIM_SEED);
+}
+
+
+static int SimCompareUint32(const void * a, const void * b)
+{
+    uint32 x = *(const uint32 *)a;
+    uint32 y = *(const uint32 *)b;
+
+    return (x > y) - (x < y);
+}
+
+
+static uint32 latencies[SIM_MAX_PACKETS];
+
+/* Returns the longest relay latency in us, and false if a transmission is
+ * lost */
+static bool SimRun(bool useScheduler, uint32 beaconsPerS, uint32 * relayMax)
+{
+    uint32 dropped[3] = {0u, 0u, 0u};
+    uint32 expected = 0u;
+    uint32 relays = 0u;
+    uint32 owns = 0u;
+    uint64_t relaySum = 0u;
+    uint64_t ownSum = 0u;
+    uint32 i;
+
+    SimReset();
+
+    /* Start after the first interval, as a node that has been running */
+    for(nowUs = 1000000u; nowUs < (1000000u + (SIM_DURATION_MS + SIM_DRAIN_MS) * 1000u); nowUs += 1000u)
+    {
+        bool isRunning = (nowUs < (1000000u + SIM_DURATION_MS * 1000u));
+
+        if(isRunning && ((uint32)(rand() % 1000) < SIM_RELAY_PER_S))
+        {
+            SimSend(useScheduler, SIM_RELAY, dropped);
+        }
+        if(isRunning && ((uint32)(rand() % 1000) < SIM_OWN_PER_S))
+        {
+            SimSend(useScheduler, SIM_OWN, dropped);
+        }
+        if(isRunning && ((uint32)(rand() % 1000) < beaconsPerS))
+        {
+            SimSend(useScheduler, SIM_BEACON, dropped);
+        }
+        if(isRunning && (((nowUs / 1000u) % SIM_SECURE_BEACON_MS) == 0u))
+        {
+            SimSend(useScheduler, SIM_BEACON, dropped);
+        }
+
+        if(useScheduler)
+        {
+            CyMesh_BearerTxUpdate();
+        }
+        SimLibraryProcess();
+    }
+    timeBaseMs += nowUs / 1000u;
+
+    for(i = 0u; i < packetCount; i++)
+    {
+        const SIM_PACKET_T * packet = &packets[i];
+
+        expected += packet->txCount;
+        if(packet->sent != packet->txCount)
+        {
+            printf("packet %u sent %u of %u times\n", i, packet->sent, packet->txCount);
+            return false;
+        }
+        if(packet->source == SIM_RELAY)
+        {
+            latencies[relays++] = packet->firstUs - packet->queuedUs;
+            relaySum += packet->firstUs - packet->queuedUs;
+        }
+        else if(packet->source == SIM_OWN)
+        {
+            ownSum += packet->lastUs - packet->queuedUs;
+            owns++;
+        }
+    }
+    if(transmissions != expected)
+    {
+        printf("%u transmissions for %u expected\n", transmissions, expected);
+        return false;
+    }
+
+    qsort(latencies, relays, sizeof(latencies[0]), SimCompareUint32);
+    *relayMax = (relays != 0u) ? latencies[relays - 1u] : 0u;
+
+    printf("%9u  %-9s  %10.1f %9.1f %9.1f %8u  %10.1f %8u\n", beaconsPerS,
+           useScheduler ? "scheduler" : "library",
+           (relays != 0u) ? (double)relaySum / relays / 1000.0 : 0.0,
+           (relays != 0u) ? latencies[(relays * 95u) / 100u] / 1000.0 : 0.0,
+           *relayMax / 1000.0,
+           dropped[SIM_RELAY],
+           (owns != 0u) ? (double)ownSum / owns / 1000.0 : 0.0,
+           dropped[SIM_BEACON]);
+
+    return true;
+}
+
+
+static uint32 copyUs[SIM_MAX_PACKETS];
+static uint32 copyFlood[SIM_MAX_PACKETS];
+static bool copyCollides[SIM_MAX_PACKETS];
+static bool floodHeard[SIM_MAX_PACKETS];
+
+/* The copies of the floods the neighbours relay, in order. A neighbour relays
+ * after processing the PDU and the random delay of the library bearer; with
+ * the scheduler the burst offset is added. Returns the number of floods. */
+static uint32 SimSlotFloods(bool useScheduler, uint32 floodsPerS, uint32 * copies)
+{
+    uint32 floods = 0u;
+    uint32 count = 0u;
+    uint32 ms;
+    uint32 i;
+
+    for(ms = 1000u; ms < (1000u + SIM_SLOT_DURATION_MS); ms++)
+    {
+        if((uint32)(rand() % 1000) >= floodsPerS)
+        {
+            continue;
+        }
+        for(i = 0u; (i < SIM_SLOT_NEIGHBOURS) && (count < SIM_MAX_PACKETS); i++)
+        {
+            uint32 timeUs = (ms * 1000u) + ((uint32)rand() % 1000u) + SIM_RX_PROCESS_US +
+                            ((uint32)(rand() & SIM_ADV_DELAY_MASK) * SIM_ADV_DELAY_STEP_US);
+            uint32 j = count;
+
+            if(useScheduler)
+            {
+                timeUs += ((uint32)rand() % (CYMESH_BEARER_TX_BURST_OFFSET_MS + 1u)) * 1000u;
+            }
+            while((j > 0u) && (copyUs[j - 1u] > timeUs))
+            {
+                copyUs[j] = copyUs[j - 1u];
+                copyFlood[j] = copyFlood[j - 1u];
+                j--;
+            }
+            copyUs[j] = timeUs;
+            copyFlood[j] = floods;
+            count++;
+        }
+        floods++;
+    }
+
+    for(i = 0u; i < count; i++)
+    {
+        copyCollides[i] = ((i > 0u) && ((copyUs[i] - copyUs[i - 1u]) < SIM_AIR_US)) ||
+                          (((i + 1u) < count) && ((copyUs[i + 1u] - copyUs[i]) < SIM_AIR_US));
+    }
+
+    *copies = count;
+    return floods;
+}
+
+
+/* One relay node hearing floodsPerS floods from its neighbours. It relays
+ * each flood the first time it hears a copy, and sends its data beacons.
+ * A copy is heard if the node scans and it does not collide. */
+static void SimSlotRun(bool useScheduler, uint32 floodsPerS, double * scanDuty, double * floodsHeard)
+{
+    uint32 dropped[3] = {0u, 0u, 0u};
+    uint32 copies;
+    uint32 floods;
+    uint32 heardCopies = 0u;
+    uint32 heardFloods = 0u;
+    uint32 deafIndex = 0u;
+    uint32 next = 0u;
+    uint64_t deafSum = 0u;
+    uint64_t relaySum = 0u;
+    uint32 relays = 0u;
+    uint32 i;
+
+    SimReset();
+    memset(floodHeard, 0, sizeof(floodHeard));
+    floods = SimSlotFloods(useScheduler, floodsPerS, &copies);
+
+    for(nowUs = 1000000u; nowUs < (1000000u + (SIM_SLOT_DURATION_MS + SIM_DRAIN_MS) * 1000u); nowUs += 1000u)
+    {
+        for(; (next < copies) && (copyUs[next] < nowUs); next++)
+        {
+            if((copyCollides[next] == true) || (SimIsScanning(copyUs[next], &deafIndex) == false))
+            {
+                continue;
+            }
+            heardCopies++;
+            if(floodHeard[copyFlood[next]] == false)
+            {
+                floodHeard[copyFlood[next]] = true;
+                heardFloods++;
+                SimSend(useScheduler, SIM_RELAY, dropped);
+            }
+        }
+        if((nowUs < (1000000u + SIM_SLOT_DURATION_MS * 1000u)) &&
+           ((uint32)(rand() % 1000) < SIM_SLOT_BEACONS_PER_S))
+        {
+            SimSend(useScheduler, SIM_BEACON, dropped);
+        }
+
+        if(useScheduler)
+        {
+            CyMesh_BearerTxUpdate();
+        }
+        SimLibraryProcess();
+    }
+    timeBaseMs += nowUs / 1000u;
+
+    for(i = 0u; i < deafCount; i++)
+    {
+        if(deafStartUs[i] < (1000000u + SIM_SLOT_DURATION_MS * 1000u))
+        {
+            deafSum += deafEndUs[i] - deafStartUs[i];
+        }
+    }
+    for(i = 0u; i < packetCount; i++)
+    {
+        if((packets[i].source == SIM_RELAY) && (packets[i].sent != 0u))
+        {
+            relaySum += packets[i].firstUs - packets[i].queuedUs;
+            relays++;
+        }
+    }
+
+    *scanDuty = 100.0 - (100.0 * deafSum) / (SIM_SLOT_DURATION_MS * 1000.0);
+    *floodsHeard = (floods != 0u) ? (100.0 * heardFloods) / floods : 0.0;
+
+    printf("%8u  %-9s  %6.1f%%  %7.1f%%  %7.1f%%  %9.1f %8u\n", floodsPerS,
+           useScheduler ? "scheduler" : "library", *scanDuty,
+           (copies != 0u) ? (100.0 * heardCopies) / copies : 0.0, *floodsHeard,
+           (relays != 0u) ? (double)relaySum / relays / 1000.0 : 0.0,
+           dropped[SIM_RELAY]);
+}
+
+
+/* Returns false if the scheduler does not keep the scan duty, or hears fewer
+ * floods than the library at the highest load */
+static bool SimSlots(void)
+{
+    static const uint32 loads[] = {5u, 10u, 20u, 40u, 60u, 80u, 100u};
+    double libraryDuty;
+    double libraryHeard = 0.0;
+    double schedulerDuty;
+    double schedulerHeard = 0.0;
+    bool isOk = true;
+    uint32 i;
+
+    printf("\nslots, %u s, floods heard from %u neighbours, %u data beacons/s x%u\n",
+           SIM_SLOT_DURATION_MS / 1000u, SIM_SLOT_NEIGHBOURS, SIM_SLOT_BEACONS_PER_S, SIM_BEACON_TX_COUNT);
+    printf("burst of %u, offset up to %u ms, scan kept %u%%\n", CYMESH_BEARER_TX_BURST_MAX,
+           CYMESH_BEARER_TX_BURST_OFFSET_MS, CYMESH_BEARER_TX_MIN_SCAN_PERCENT);
+    printf("floods/s  TX path       scan   copies    floods  relay ms  relays\n");
+    printf("                        duty    heard     heard    mean    dropped\n");
+
+    for(i = 0u; i < (sizeof(loads) / sizeof(loads[0])); i++)
+    {
+        SimSlotRun(false, loads[i], &libraryDuty, &libraryHeard);
+        memset(cyMesh_BearerTxStats, 0, sizeof(cyMesh_BearerTxStats));
+        SimSlotRun(true, loads[i], &schedulerDuty, &schedulerHeard);
+
+        if(schedulerDuty < CYMESH_BEARER_TX_MIN_SCAN_PERCENT)
+        {
+            printf("scheduler scans less than %u%% at %u floods/s\n", CYMESH_BEARER_TX_MIN_SCAN_PERCENT, loads[i]);
+            isOk = false;
+        }
+    }
+
+    if(schedulerHeard <= libraryHeard)
+    {
+        printf("scheduler does not hear more floods than the library at %u floods/s\n", loads[i - 1u]);
+        isOk = false;
+    }
+
+    return isOk;
+}
+
+
+/* Schedules the bursts of the run, returns the number of packets */
+static uint32 SimRxBursts(uint32 burstSize, uint32 * arrivals, uint8 * nids)
+{
+    uint32 count = 0u;
+    uint32 ms;
+    uint32 i;
+
+    srand(SIM_SEED);
+    for(ms = 0u; ms < SIM_RX_DURATION_MS; ms++)
+    {
+        if((uint32)(rand() % 1000) < SIM_RX_BURSTS_PER_S)
+        {
+            for(i = 0u; (i < burstSize) && (count < SIM_MAX_PACKETS); i++)
+            {
+                arrivals[count] = (ms * 1000u) + ((uint32)rand() % SIM_RX_BURST_SPREAD_US);
+                nids[count] = ((uint32)(rand() % 100) < SIM_RX_FOREIGN_PERCENT) ? SIM_FOREIGN_NID : SIM_NID;
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+
+static uint32 rxArrivals[SIM_MAX_PACKETS];
+static uint8 rxNids[SIM_MAX_PACKETS];
+
+/* Order of arrival */
+static void SimRxSort(uint32 count)
+{
+    uint32 i;
+
+    for(i = 1u; i < count; i++)
+    {
+        uint32 arrival = rxArrivals[i];
+        uint8 nid = rxNids[i];
+        uint32 j = i;
+
+        while((j > 0u) && (rxArrivals[j - 1u] > arrival))
+        {
+            rxArrivals[j] = rxArrivals[j - 1u];
+            rxNids[j] = rxNids[j - 1u];
+            j--;
+        }
+        rxArrivals[j] = arrival;
+        rxNids[j] = nid;
+    }
+}
+
+
+/* The main loop with the RX buffer of the library: every mesh packet takes an
+ * entry until the buffer is emptied. Returns the packets of the network
+ * dropped. */
+static uint32 SimRxLibrary(uint32 count)
+{
+    uint32 dropped = 0u;
+    uint32 next = 0u;
+
+    for(nowUs = 0u; next < count; nowUs += SIM_RX_LOOP_US)
+    {
+        uint8 buffer[CYMESH_BEARER_ADV_RX_BUFFER_SIZE];
+        uint32 held = 0u;
+        uint32 i;
+
+        for(; (next < count) && (rxArrivals[next] <= nowUs); next++)
+        {
+            if(held < CYMESH_BEARER_ADV_RX_BUFFER_SIZE)
+            {
+                buffer[held++] = rxNids[next];
+            }
+            else if(rxNids[next] == SIM_NID)
+            {
+                dropped++;
+            }
+        }
+        for(i = 0u; i < held; i++)
+        {
+            nowUs += (buffer[i] == SIM_NID) ? SIM_RX_PROCESS_US : SIM_RX_REJECT_US;
+        }
+    }
+
+    return dropped;
+}
+
+
+/* The same with the RX path. Returns the packets of the network dropped, or
+ * the number of packets if one is not accounted for. */
+static uint32 SimRxRing(uint32 count)
+{
+    CYMESH_BEARER_RX_STATS_T * stats = &cyMesh_BearerRxStats;
+    uint32 next = 0u;
+
+    memset(stats, 0, sizeof(*stats));
+    rxProcessed = 0u;
+    pendingCount = 0u;
+    (void)__wrap_CyMesh_BearerStart(SimNetworkCallback);
+
+    for(nowUs = 0u; (next < count) || (pendingCount != 0u); nowUs += SIM_RX_LOOP_US)
+    {
+        for(; (next < count) && (rxArrivals[next] <= nowUs) && (pendingCount < SIM_RX_MAX_PENDING); next++)
+        {
+            pendingUs[pendingCount] = rxArrivals[next];
+            pendingNid[pendingCount] = rxNids[next];
+            pendingCount++;
+        }
+        __wrap_CyMesh_BearerProcessEvents();
+    }
+
+    if((stats->received[CYMESH_BEARER_ADV] != rxProcessed) ||
+       ((stats->received[CYMESH_BEARER_ADV] + stats->overflow[CYMESH_BEARER_ADV] + stats->otherNetwork) != count))
+    {
+        printf("RX path: %u processed, %u queued, %u overflowed, %u filtered of %u\n", rxProcessed,
+               stats->received[CYMESH_BEARER_ADV], stats->overflow[CYMESH_BEARER_ADV], stats->otherNetwork, count);
+        return count;
+    }
+
+    return stats->overflow[CYMESH_BEARER_ADV];
+}
+
+
+static bool SimRx(void)
+{
+    static const uint32 burstSizes[] = {1u, 2u, 4u, 6u, 8u, 12u, 16u, 24u, 32u};
+    bool isOk = true;
+    uint32 i;
+
+    cyMesh_ConfigInfoRam.bearerRole = CYMESH_ROLE_RELAY;
+
+    printf("\nRX, %u s, %u bursts/s over %u ms, %u%% of another network, ring of %u\n",
+           SIM_RX_DURATION_MS / 1000u, SIM_RX_BURSTS_PER_S, SIM_RX_BURST_SPREAD_US / 1000u,
+           SIM_RX_FOREIGN_PERCENT, CYMESH_BEARER_RX_RING_SIZE);
+    printf("burst   packets of   library dropped    RX ring dropped   ring max\n");
+    printf("        the network                                         depth\n");
+
+    for(i = 0u; i < (sizeof(burstSizes) / sizeof(burstSizes[0])); i++)
+    {
+        uint32 count = SimRxBursts(burstSizes[i], rxArrivals, rxNids);
+        uint32 own = 0u;
+        uint32 libraryDropped;
+        uint32 ringDropped;
+        uint32 j;
+
+        SimRxSort(count);
+        for(j = 0u; j < count; j++)
+        {
+            own += (rxNids[j] == SIM_NID) ? 1u : 0u;
+        }
+
+        libraryDropped = SimRxLibrary(count);
+        ringDropped = SimRxRing(count);
+        if((ringDropped == count) || (ringDropped > libraryDropped))
+        {
+            isOk = false;
+        }
+
+        printf("%5u  %11u  %8u %6.2f%%  %8u %6.2f%%  %8u\n", burstSizes[i], own,
+               libraryDropped, (100.0 * libraryDropped) / own, ringDropped, (100.0 * ringDropped) / own,
+               cyMesh_BearerRxStats.maxDepth);
+    }
+
+    return isOk;
+}
+
+
+int main(void)
+{
+    static const uint32 beaconRates[] = {0u, 5u, 10u, 20u, 30u};
+    bool isOk = true;
+    uint32 i;
+
+    printf("relay node, %u s, %u relays/s, %u own PDUs/s x%u, data beacons x%u\n", SIM_DURATION_MS / 1000u,
+           SIM_RELAY_PER_S, SIM_OWN_PER_S, SIM_OWN_TX_COUNT, SIM_BEACON_TX_COUNT);
+    printf("beacons/s  TX path    relay mean  p95 (ms)  max (ms)  dropped  own done ms  beacons\n");
+    printf("                                                              relays               dropped\n");
+
+    for(i = 0u; i < (sizeof(beaconRates) / sizeof(beaconRates[0])); i++)
+    {
+        uint32 libraryMax;
+        uint32 schedulerMax;
+
+        isOk = SimRun(false, beaconRates[i], &libraryMax) && isOk;
+        memset(cyMesh_BearerTxStats, 0, sizeof(cyMesh_BearerTxStats));
+        isOk = SimRun(true, beaconRates[i], &schedulerMax) && isOk;
+
+        if((beaconRates[i] != 0u) && (schedulerMax >= libraryMax))
+        {
+            printf("scheduler does not lower the longest relay latency at %u beacons/s\n", beaconRates[i]);
+            isOk = false;
+        }
+    }
+
+    isOk = SimSlots() && isOk;
+    isOk = SimRx() && isOk;
+
+    return isOk ? 0 : 1;
+}
+
+/* [] END OF FILE */
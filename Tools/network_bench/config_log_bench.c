@@ -0,0 +1,313 @@
+/*******************************************************************************
+* Benchmark of Firmware_Mesh/SM Files/CyMesh_ConfigLog.c.
+*
+* Sends 1000000 packets through a copy of CyMesh_UpdateSequenceNumber() of the
+* library, with a configuration change every 100000 packets, once with every
+* save going to CyMesh_ConfigurationSave() as in the library and once through
+* the configuration log, and counts the flash rows written. One SM timer tick
+* (1 ms) is run per packet. The cycles of CyMesh_ConfigLogUpdate() are reported
+* for a tick without a change and for the tick that writes one.
+*
+* A second run resets the node at random points, some of them in the middle
+* of a log write, and checks that no SEQ is used twice and that every logged
+* configuration change survives. A SEQ reservation also writes the changes
+* not logged yet, so a newer value may survive too. From the repository root:
+*
+*   gcc -O2 -I Tools/network_bench -I "Firmware_Mesh/SM Files" -o config_log_bench \
+*       Tools/network_bench/config_log_bench.c "Firmware_Mesh/SM Files/CyMesh_ConfigLog.c" &&
+*   ./config_log_bench
+*
+* Cycles are only reported on x86 (TSC).
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <project.h>
+#include "CyMesh_ConfigLog.h"
+#include "CyMesh_Configuration.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define BENCH_CYCLES()      (__rdtsc())
+#else
+    #define BENCH_CYCLES()      (0ull)
+#endif
+
+#define BENCH_PACKETS           (1000000u)
+#define BENCH_CHANGE_PERIOD     (100000u)
+#define BENCH_RESETS            (2000u)
+#define BENCH_TEAR_PERCENT      (25u)   /* Resets that hit a log write */
+#define BENCH_SEED              (1u)
+#define BENCH_SEQ_MAX           (0x1FFFFFu)
+
+/* A word of the configuration the configuration model changes */
+#define BENCH_CONFIG_WORD       (20u)
+
+/* Library state the log uses */
+CYMESH_DEVICE_CONFIG_T cyMesh_ConfigInfoRam;
+const CYMESH_DEVICE_CONFIG_T cyMesh_ConfigInfoFlash CY_SECTION(".cy_checksum_exclude") = { 0 };
+uint8 CyMesh_ConfigInfoFlashUpdateRequired;
+
+static uint32 transportSeq;
+static bool (* saveFunction)(void);
+
+static uint32 rowWrites;
+static uint32 rowWear[(sizeof(CYMESH_DEVICE_CONFIG_T) / CYDEV_FLS_ROW_SIZE) + 1u + CYMESH_CONFIG_LOG_ROWS];
+
+/* Set to tear the next log row write, as a reset in the middle of it would */
+static bool tearNextWrite;
+static bool isTorn;
+
+
+static uint32 RowIndex(const uint8 varFlash[])
+{
+    const uint8 * base = (const uint8 *)&cyMesh_ConfigInfoFlash;
+    const uint8 * log = (const uint8 *)cyMesh_ConfigLogFlash;
+
+    if((varFlash >= log) && (varFlash < (log + sizeof(cyMesh_ConfigLogFlash))))
+    {
+        return ((sizeof(CYMESH_DEVICE_CONFIG_T) / CYDEV_FLS_ROW_SIZE) + 1u) +
+               (uint32)(varFlash - log) / CYDEV_FLS_ROW_SIZE;
+    }
+    return (uint32)(varFlash - base) / CYDEV_FLS_ROW_SIZE;
+}
+
+
+cystatus CyBLE_Nvram_Write(const uint8 buffer[], const uint8 varFlash[], uint16 length)
+{
+    uint16 offset;
+
+    if((tearNextWrite == true) && (length == sizeof(CYMESH_CONFIG_LOG_ROW_T)))
+    {
+        tearNextWrite = false;
+        isTorn = true;
+        length /= 2u;
+    }
+
+    memcpy((uint8 *)varFlash, buffer, length);
+    for(offset = 0; offset < length; offset += CYDEV_FLS_ROW_SIZE)
+    {
+        rowWrites++;
+        rowWear[RowIndex(&varFlash[offset])]++;
+    }
+
+    return (isTorn == true) ? 1u : CYRET_SUCCESS;
+}
+
+
+/* CyMesh_ConfigurationSave() of the library */
+bool __real_CyMesh_ConfigurationSave(void)
+{
+    const uint32 * word = (const uint32 *)&cyMesh_ConfigInfoRam;
+    uint32 checksum = 0u;
+    uint32 i;
+
+    for(i = 0; i < (offsetof(CYMESH_DEVICE_CONFIG_T, checksum) / sizeof(uint32)); i++)
+    {
+        checksum += word[i];
+    }
+    cyMesh_ConfigInfoRam.checksum = checksum;
+
+    return CyBLE_Nvram_Write((const uint8 *)&cyMesh_ConfigInfoRam, (const uint8 *)&cyMesh_ConfigInfoFlash,
+                             sizeof(cyMesh_ConfigInfoRam)) == CYRET_SUCCESS;
+}
+
+
+/* CyMesh_UpdateSequenceNumber() of the library, which calls
+ * CyMesh_ConfigurationSave() */
+static void UpdateSequenceNumber(void)
+{
+    transportSeq++;
+    if(transportSeq > BENCH_SEQ_MAX)
+    {
+        transportSeq = 0u;
+        cyMesh_ConfigInfoRam.seq_num = 0u;
+    }
+    if(cyMesh_ConfigInfoRam.seq_num <= transportSeq)
+    {
+        cyMesh_ConfigInfoRam.seq_num = transportSeq + CYMESH_TRAN_SEQNO_FLASH_INCREMENT_VALUE;
+        if(cyMesh_ConfigInfoRam.seq_num > BENCH_SEQ_MAX)
+        {
+            cyMesh_ConfigInfoRam.seq_num = CYMESH_TRAN_SEQNO_FLASH_INCREMENT_VALUE;
+        }
+        (void)saveFunction();
+    }
+}
+
+
+/* Power on: CyMesh_ConfigurationLoad(), then CyMesh_TransportStart() */
+static void Start(bool isLog)
+{
+    memcpy(&cyMesh_ConfigInfoRam, &cyMesh_ConfigInfoFlash, sizeof(cyMesh_ConfigInfoRam));
+    CyMesh_ConfigInfoFlashUpdateRequired = 0u;
+    if(isLog == true)
+    {
+        (void)CyMesh_ConfigLogRestore();
+    }
+    transportSeq = cyMesh_ConfigInfoRam.seq_num;
+}
+
+
+/* A provisioned node with nothing logged */
+static void Provision(void)
+{
+    memset((void *)cyMesh_ConfigLogFlash, 0, sizeof(cyMesh_ConfigLogFlash));
+    memset(&cyMesh_ConfigInfoRam, 0, sizeof(cyMesh_ConfigInfoRam));
+    cyMesh_ConfigInfoRam.isConfigurationValid = true;
+    (void)__real_CyMesh_ConfigurationSave();
+    memset(rowWear, 0, sizeof(rowWear));
+    rowWrites = 0u;
+}
+
+
+static void ChangeConfig(void)
+{
+    ((uint32 *)&cyMesh_ConfigInfoRam)[BENCH_CONFIG_WORD]++;
+    CyMesh_ConfigInfoFlashUpdateRequired = 1u;
+}
+
+
+static void Throughput(bool isLog)
+{
+    unsigned long long idleCycles = 0ull;
+    unsigned long long writeCycles = 0ull;
+    uint32 maxWear = 0u;
+    uint32 writes = 0u;
+    uint32 i;
+
+    Provision();
+    saveFunction = (isLog == true) ? __wrap_CyMesh_ConfigurationSave : __real_CyMesh_ConfigurationSave;
+    Start(isLog);
+
+    for(i = 0; i < BENCH_PACKETS; i++)
+    {
+        if((i % BENCH_CHANGE_PERIOD) == 0u)
+        {
+            ChangeConfig();
+        }
+        UpdateSequenceNumber();
+
+        if(isLog == true)
+        {
+            bool isWrite = (CyMesh_ConfigInfoFlashUpdateRequired != 0u);
+            unsigned long long cycles = BENCH_CYCLES();
+
+            CyMesh_ConfigLogUpdate();
+            cycles = BENCH_CYCLES() - cycles;
+
+            if((isWrite == true) && (CyMesh_ConfigInfoFlashUpdateRequired == 0u))
+            {
+                writeCycles += cycles;
+                writes++;
+            }
+            else
+            {
+                idleCycles += cycles;
+            }
+        }
+        else
+        {
+            /* CyMesh_ConfigInfoUpdate() saves the whole configuration */
+            if((CyMesh_ConfigInfoFlashUpdateRequired != 0u) && ((i % BENCH_CHANGE_PERIOD) == 10000u))
+            {
+                CyMesh_ConfigInfoFlashUpdateRequired = 0u;
+                (void)__real_CyMesh_ConfigurationSave();
+            }
+        }
+    }
+
+    for(i = 0; i < (sizeof(rowWear) / sizeof(rowWear[0])); i++)
+    {
+        maxWear = (rowWear[i] > maxWear) ? rowWear[i] : maxWear;
+    }
+
+    printf("%-10s %14u %18u", (isLog == true) ? "log" : "library", rowWrites, maxWear);
+    if(isLog == true)
+    {
+        printf(" %12.1f %12.1f", (double)idleCycles / (BENCH_PACKETS - writes),
+               (writes == 0u) ? 0.0 : (double)writeCycles / writes);
+    }
+    printf("\n");
+}
+
+
+static bool Resets(void)
+{
+    uint32 loggedValue = 0u;
+    uint32 failures = 0u;
+    uint32 reset;
+
+    Provision();
+    saveFunction = __wrap_CyMesh_ConfigurationSave;
+    Start(true);
+
+    for(reset = 0; reset < BENCH_RESETS; reset++)
+    {
+        uint32 packets = 1u + ((uint32)rand() % 50000u);
+        uint32 usedSeq;
+        uint32 value;
+        uint32 i;
+
+        if(((uint32)rand() % 100u) < BENCH_TEAR_PERCENT)
+        {
+            tearNextWrite = true;
+        }
+
+        for(i = 0; (i < packets) && (isTorn == false); i++)
+        {
+            if(((uint32)rand() % 20000u) == 0u)
+            {
+                ChangeConfig();
+            }
+            UpdateSequenceNumber();
+            if(isTorn == false)
+            {
+                CyMesh_ConfigLogUpdate();
+            }
+            if((CyMesh_ConfigInfoFlashUpdateRequired == 0u) && (isTorn == false))
+            {
+                loggedValue = ((const uint32 *)&cyMesh_ConfigInfoRam)[BENCH_CONFIG_WORD];
+            }
+        }
+
+        usedSeq = transportSeq;
+        value = ((const uint32 *)&cyMesh_ConfigInfoRam)[BENCH_CONFIG_WORD];
+        tearNextWrite = false;
+        isTorn = false;
+        Start(true);
+
+        /* CyMesh_UpdateSequenceNumber() is called before a SEQ is used, so the
+         * restored one may be the last one used */
+        if(transportSeq < usedSeq)
+        {
+            printf("reset %u: SEQ %u restored after %u was used\n", reset, transportSeq, usedSeq);
+            failures++;
+        }
+        /* A SEQ reservation also writes changes not logged yet */
+        if((((const uint32 *)&cyMesh_ConfigInfoRam)[BENCH_CONFIG_WORD] < loggedValue) ||
+           (((const uint32 *)&cyMesh_ConfigInfoRam)[BENCH_CONFIG_WORD] > value))
+        {
+            printf("reset %u: logged configuration lost\n", reset);
+            failures++;
+        }
+    }
+
+    printf("%u resets, %u failures, %u row writes\n", BENCH_RESETS, failures, rowWrites);
+
+    return failures == 0u;
+}
+
+
+int main(void)
+{
+    srand(BENCH_SEED);
+
+    printf("%u packets, a configuration change every %u\n", BENCH_PACKETS, BENCH_CHANGE_PERIOD);
+    printf("%-10s %14s %18s %12s %12s\n", "save", "rows written", "writes, worst row", "idle tick", "write tick");
+    Throughput(false);
+    Throughput(true);
+
+    return (Resets() == true) ? 0 : 1;
+}
+
+/* [] END OF FILE */
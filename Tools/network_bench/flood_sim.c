@@ -0,0 +1,268 @@
+/*******************************************************************************
+* Flood simulation of Firmware_Mesh/SM Files/CyMesh_NetworkCache.c.
+*
+* Nodes are placed at random in a square and every node relays, as
+* CyMesh_ProcessNetworkPacket() does: a message that is not in the node's
+* cache is added and sent again after a random bearer delay with its TTL
+* decremented. Once a cache turns over faster than the copies of a message
+* arrive, the node relays the same message again. Messages are originated at
+* random nodes at a fixed network wide rate.
+*
+* Amplification is the number of relays divided by the number of distinct
+* (node, message) pairs relayed; 1.00 means no node relayed a message twice. The
+* cache size is a build option, so build once per size. From the repository
+* root:
+*
+*   for size in 8 16 32 64 128; do
+*       gcc -O2 -DCYMESH_NET_MSG_CACHE_SIZE=$size -I Tools/network_bench -I "Firmware_Mesh/SM Files" \
+*           -o flood_sim Tools/network_bench/flood_sim.c "Firmware_Mesh/SM Files/CyMesh_NetworkCache.c" -lm &&
+*       ./flood_sim $size
+*   done
+*
+* Any argument suppresses the table header.
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <project.h>
+#include "CyMesh_NetworkCache.h"
+
+#define SIM_NODES               (100u)
+#define SIM_AREA                (100.0)     /* Side of the square */
+#define SIM_RANGE               (18.0)      /* Radio range, about 9 neighbours */
+#define SIM_TTL                 (7u)
+#define SIM_RELAY_DELAY_MIN_MS  (10u)       /* Bearer delay before a relay */
+#define SIM_RELAY_DELAY_MAX_MS  (60u)
+#define SIM_DURATION_MS         (10000u)
+#define SIM_MAX_EVENTS          (4000000u)  /* Runaway floods stop here */
+#define SIM_SEED                (1u)
+#define SIM_MAX_MESSAGES        (SIM_DURATION_MS)
+
+static const uint32 simRates[] = { 5u, 20u, 50u, 100u };  /* Originated messages per second */
+
+#define SIM_RATE_COUNT          (sizeof(simRates) / sizeof(simRates[0]))
+
+typedef struct
+{
+    uint32 time;
+    uint16 node;
+    uint16 src;
+    uint32 seq;
+    uint16 message;
+    uint8 ttl;
+} SIM_EVENT_T;
+
+static double nodeX[SIM_NODES];
+static double nodeY[SIM_NODES];
+static uint16 neighbours[SIM_NODES][SIM_NODES];
+static uint16 neighbourCount[SIM_NODES];
+static CYMESH_NET_MSG_CACHE_STRUCT caches[SIM_NODES];
+static uint8 isRelayed[SIM_MAX_MESSAGES][(SIM_NODES + 7u) / 8u];
+
+/* Transmissions waiting for their time, a binary min-heap */
+static SIM_EVENT_T events[SIM_MAX_EVENTS];
+static uint32 eventCount;
+
+
+static uint32 Random(uint32 limit)
+{
+    return (uint32)rand() % limit;
+}
+
+
+static void Push(const SIM_EVENT_T * event)
+{
+    uint32 i = eventCount++;
+
+    while((i > 0u) && (events[(i - 1u) / 2u].time > event->time))
+    {
+        events[i] = events[(i - 1u) / 2u];
+        i = (i - 1u) / 2u;
+    }
+    events[i] = *event;
+}
+
+
+static SIM_EVENT_T Pop(void)
+{
+    SIM_EVENT_T top = events[0];
+    SIM_EVENT_T last = events[--eventCount];
+    uint32 i = 0u;
+
+    for(;;)
+    {
+        uint32 child = (2u * i) + 1u;
+
+        if(child >= eventCount)
+        {
+            break;
+        }
+        if(((child + 1u) < eventCount) && (events[child + 1u].time < events[child].time))
+        {
+            child++;
+        }
+        if(events[child].time >= last.time)
+        {
+            break;
+        }
+        events[i] = events[child];
+        i = child;
+    }
+    events[i] = last;
+    return top;
+}
+
+
+static void PlaceNodes(void)
+{
+    uint16 i;
+    uint16 j;
+
+    srand(SIM_SEED);
+    for(i = 0; i < SIM_NODES; i++)
+    {
+        nodeX[i] = SIM_AREA * Random(10000u) / 10000.0;
+        nodeY[i] = SIM_AREA * Random(10000u) / 10000.0;
+    }
+
+    for(i = 0; i < SIM_NODES; i++)
+    {
+        neighbourCount[i] = 0u;
+        for(j = 0; j < SIM_NODES; j++)
+        {
+            if((i != j) && (hypot(nodeX[i] - nodeX[j], nodeY[i] - nodeY[j]) <= SIM_RANGE))
+            {
+                neighbours[i][neighbourCount[i]++] = j;
+            }
+        }
+    }
+}
+
+
+/* Returns the amplification, or a negative value if the flood ran away */
+static double Simulate(uint32 rate)
+{
+    uint32 seq[SIM_NODES] = { 0 };
+    uint32 messages = 0u;
+    uint32 relays = 0u;
+    uint32 distinctRelays = 0u;
+    uint32 nextMessage = 0u;
+    uint16 i;
+
+    srand(SIM_SEED + rate);
+    for(i = 0; i < SIM_NODES; i++)
+    {
+        CyMesh_NetworkCacheInit(&caches[i]);
+    }
+    eventCount = 0u;
+    memset(isRelayed, 0, sizeof(isRelayed));
+
+    while((nextMessage < SIM_DURATION_MS) || (eventCount > 0u))
+    {
+        SIM_EVENT_T event;
+
+        if((nextMessage < SIM_DURATION_MS) && ((eventCount == 0u) || (nextMessage <= events[0].time)))
+        {
+            /* Originated message; the source caches it, as the network layer
+             * drops its own packets */
+            event.time = nextMessage;
+            event.node = (uint16)Random(SIM_NODES);
+            event.src = event.node + 1u;
+            event.seq = ++seq[event.node];
+            event.message = (uint16)messages;
+            event.ttl = SIM_TTL;
+            nextMessage += 1u + Random((2000u / rate) - 1u);
+            messages++;
+        }
+        else
+        {
+            event = Pop();
+            relays++;
+            if((isRelayed[event.message][event.node / 8u] & (1u << (event.node % 8u))) == 0u)
+            {
+                isRelayed[event.message][event.node / 8u] |= (uint8)(1u << (event.node % 8u));
+                distinctRelays++;
+            }
+        }
+
+        for(i = 0; i < neighbourCount[event.node]; i++)
+        {
+            uint16 node = neighbours[event.node][i];
+            SIM_EVENT_T relay = event;
+
+            if(((node + 1u) == event.src) || (CyMesh_NetworkCacheFind(&caches[node], event.src, event.seq) == true))
+            {
+                continue;
+            }
+            CyMesh_NetworkCacheAdd(&caches[node], event.src, event.seq);
+
+            if(event.ttl < 2u)
+            {
+                continue;
+            }
+            if(eventCount == SIM_MAX_EVENTS)
+            {
+                return -1.0;
+            }
+            relay.node = node;
+            relay.ttl = event.ttl - 1u;
+            relay.time = event.time + SIM_RELAY_DELAY_MIN_MS +
+                         Random(SIM_RELAY_DELAY_MAX_MS - SIM_RELAY_DELAY_MIN_MS + 1u);
+            Push(&relay);
+        }
+    }
+
+    return (distinctRelays == 0u) ? 1.0 : ((double)relays / distinctRelays);
+}
+
+
+int main(int argc, char * argv[])
+{
+    uint32 rate;
+
+    (void)argv;
+
+    PlaceNodes();
+
+    if(argc < 2)
+    {
+        uint32 links = 0u;
+        uint16 i;
+
+        for(i = 0; i < SIM_NODES; i++)
+        {
+            links += neighbourCount[i];
+        }
+        printf("%u nodes, %.1f neighbours on average, TTL %u, relay delay %u-%u ms, %u probes, %u generations\n",
+               SIM_NODES, (double)links / SIM_NODES, SIM_TTL, SIM_RELAY_DELAY_MIN_MS, SIM_RELAY_DELAY_MAX_MS,
+               CYMESH_NET_MSG_CACHE_PROBES, CYMESH_NET_MSG_CACHE_GENERATIONS);
+        printf("%-12s", "cache size");
+        for(rate = 0; rate < SIM_RATE_COUNT; rate++)
+        {
+            printf(" %7u/s", simRates[rate]);
+        }
+        printf("\n");
+    }
+
+    printf("%-12u", CYMESH_NET_MSG_CACHE_SIZE);
+    for(rate = 0; rate < SIM_RATE_COUNT; rate++)
+    {
+        double amplification = Simulate(simRates[rate]);
+
+        if(amplification < 0.0)
+        {
+            printf(" %9s", "runaway");
+        }
+        else
+        {
+            printf(" %9.2f", amplification);
+        }
+        fflush(stdout);
+    }
+    printf("\n");
+
+    return 0;
+}
+
+/* [] END OF FILE */
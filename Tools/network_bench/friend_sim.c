@@ -0,0 +1,331 @@
+/*******************************************************************************
+* Polling peripheral simulation of Firmware_Mesh/Mesh.cydsn/friend.c.
+*
+* A node has a number of peripherals in range, each receiving mesh messages
+* at random, a given period apart on average. A polling peripheral sends a
+* poll every interval, at a random phase, and scans until the node's reply.
+* The node answers at once: it takes up to FRIEND_POLL_BURST messages out of
+* the cache and sends each as a data beacon, twice, one bearer interval
+* apart, then the reply, once. The bearer starts within one interval. A poll,
+* a copy of a beacon and the reply are each lost with the given ratio; a lost
+* reply lets the window run MESH_RECEIVE_WINDOW_MS past the last packet, and
+* the next poll is the scheduled one. When the reply says messages are left,
+* the peripheral polls again at once. A message is delivered when a copy of
+* its beacon is received; it is lost when both are, or when the cache evicts
+* it. Polls of several peripherals do not delay each other.
+*
+* The current of a peripheral is the radio receiving during the windows, an
+* advertising event per poll and the idle current, with typical nRF51822
+* values at 3 V. The scan row is the peripheral that scans 90% of the time
+* and sends a keep-alive every 0.9 s, and gets each beacon at once. The
+* latency runs from the arrival at the node to the reception. From the
+* repository root:
+*
+*   gcc -O2 -I Tools/network_bench -I Firmware_Mesh/Mesh.cydsn -o friend_sim \
+*       Tools/network_bench/friend_sim.c Firmware_Mesh/Mesh.cydsn/friend.c -lm && ./friend_sim
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <project.h>
+#include "friend.h"
+
+#define SIM_DURATION_MS         (24u * 3600u * 1000u)
+#define SIM_BEARER_INTERVAL_MS  (105u)      /* CYMESH_BEARER_NON_CONN_ADV_INTERVAL_MS */
+#define SIM_WINDOW_MS           (400u)      /* MESH_RECEIVE_WINDOW_MS */
+#define SIM_SCAN_PERCENT        (90u)       /* SCAN_WINDOW / SCAN_INTERVAL of a scanning peripheral */
+#define SIM_KEEP_ALIVE_MS       (900u)      /* BLE_ADV_FAST_INTERVAL of a scanning peripheral */
+#define SIM_MESSAGE_LENGTH      (6u)        /* LOCATION_STATUS: source, destination, beacon */
+#define SIM_MAX_MESSAGES        (200000u)
+#define SIM_SEED                (1u)
+
+/* nRF51822 at 3 V, DC/DC off */
+#define SIM_RX_UA               (13000.0)   /* Radio receiving and the CPU handling the reports */
+#define SIM_ADV_UC              (15.0)      /* Advertising event on 3 channels, 0 dBm */
+#define SIM_IDLE_UA             (4.0)       /* System ON, RTC running, RAM retained */
+#define SIM_BATTERY_MAH         (220.0)     /* CR2032 */
+
+typedef struct
+{
+    uint8 tags;
+    uint8 messagePeriodS;
+    uint8 lossPercent;
+} SIM_LOAD_T;
+
+static const SIM_LOAD_T simLoads[] =
+{
+    {  4u, 30u,  5u },
+    { 10u, 10u,  5u },
+    { 10u, 10u, 20u },
+};
+
+#define SIM_LOAD_COUNT          (sizeof(simLoads) / sizeof(simLoads[0]))
+
+/* Poll intervals in s, 0 for the scanning peripheral */
+static const uint8 simIntervals[] = { 0u, 1u, 2u, 5u, 10u, 30u, 60u };
+
+#define SIM_INTERVAL_COUNT      (sizeof(simIntervals) / sizeof(simIntervals[0]))
+
+static uint32 latency[SIM_MAX_MESSAGES];
+static uint32 delivered;
+static uint32 stored;
+static uint32 evicted;
+static uint32 lost;
+
+
+static uint32 Random(uint32 limit)
+{
+    return (uint32)rand() % limit;
+}
+
+
+/* Time to the next message, exponentially distributed */
+static uint32 NextMessage(const SIM_LOAD_T * load)
+{
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+    return 1u + (uint32)(-log(u) * load->messagePeriodS * 1000.0);
+}
+
+
+static bool IsReceived(const SIM_LOAD_T * load)
+{
+    return Random(100u) >= load->lossPercent;
+}
+
+
+/* A beacon sent twice at sent; its reception time, or 0 if both copies are lost */
+static uint32 ReceiveBeacon(const SIM_LOAD_T * load, uint32 sent)
+{
+    if(IsReceived(load) == true)
+    {
+        return sent;
+    }
+    if(IsReceived(load) == true)
+    {
+        return sent + SIM_BEARER_INTERVAL_MS;
+    }
+
+    return 0u;
+}
+
+
+static void Deliver(uint32 received, uint32 arrival)
+{
+    if(received == 0u)
+    {
+        lost++;
+    }
+    else if(delivered < SIM_MAX_MESSAGES)
+    {
+        latency[delivered++] = received - arrival;
+    }
+    else
+    {
+        /* Not counted */
+    }
+}
+
+
+/* Poll of a peripheral at now. Returns the end of its receive window, and
+ * sets isPollAgain if the node has more messages for it. */
+static uint32 Poll(const SIM_LOAD_T * load, uint8 tag, uint32 now, bool * isPollAgain)
+{
+    FRIEND_MESSAGE_T message;
+    uint32 sent = now + Random(SIM_BEARER_INTERVAL_MS + 1u);
+    uint32 windowEnd = now + SIM_WINDOW_MS;
+    uint8 burst;
+
+    *isPollAgain = false;
+    if(IsReceived(load) == false)
+    {
+        return windowEnd;
+    }
+
+    for(burst = 0u; (burst < FRIEND_POLL_BURST) && (FriendTake(tag, &message) == true); burst++)
+    {
+        uint32 received = ReceiveBeacon(load, sent);
+
+        Deliver(received, message.stored);
+        if(received != 0u)
+        {
+            windowEnd = received + SIM_WINDOW_MS;
+        }
+        sent += 2u * SIM_BEARER_INTERVAL_MS;
+    }
+
+    if(IsReceived(load) == true)
+    {
+        *isPollAgain = (FriendCount(tag) != 0u);
+        return sent;
+    }
+
+    return windowEnd;
+}
+
+
+static int CompareTime(const void * a, const void * b)
+{
+    uint32 x = *(const uint32 *)a;
+    uint32 y = *(const uint32 *)b;
+
+    return (x > y) - (x < y);
+}
+
+
+static void Simulate(const SIM_LOAD_T * load, uint8 intervalS)
+{
+    static const uint8 data[SIM_MESSAGE_LENGTH] = { 0u };
+    uint32 nextMessage[FRIEND_TAG_COUNT];
+    uint32 nextPoll[FRIEND_TAG_COUNT];
+    uint32 scheduledPoll[FRIEND_TAG_COUNT];
+    uint32 windowMs = 0u;
+    uint32 polls = 0u;
+    double current;
+    uint8 tag;
+
+    FriendInit();
+    srand(SIM_SEED + load->tags + load->messagePeriodS + intervalS);
+    delivered = 0u;
+    stored = 0u;
+    evicted = 0u;
+    lost = 0u;
+
+    for(tag = 0u; tag < load->tags; tag++)
+    {
+        nextMessage[tag] = NextMessage(load);
+        scheduledPoll[tag] = (intervalS != 0u) ? Random(intervalS * 1000u) : SIM_DURATION_MS;
+        nextPoll[tag] = scheduledPoll[tag];
+    }
+
+    for(;;)
+    {
+        uint32 now = SIM_DURATION_MS;
+        uint8 next = 0u;
+        bool isPoll = false;
+
+        for(tag = 0u; tag < load->tags; tag++)
+        {
+            if(nextMessage[tag] < now)
+            {
+                now = nextMessage[tag];
+                next = tag;
+                isPoll = false;
+            }
+            if(nextPoll[tag] < now)
+            {
+                now = nextPoll[tag];
+                next = tag;
+                isPoll = true;
+            }
+        }
+        if(now >= SIM_DURATION_MS)
+        {
+            break;
+        }
+
+        if(isPoll == true)
+        {
+            bool isPollAgain;
+            uint32 windowEnd = Poll(load, next, now, &isPollAgain);
+
+            polls++;
+            windowMs += windowEnd - now;
+            while(scheduledPoll[next] <= windowEnd)
+            {
+                scheduledPoll[next] += intervalS * 1000u;
+            }
+            nextPoll[next] = isPollAgain ? windowEnd : scheduledPoll[next];
+        }
+        else
+        {
+            nextMessage[next] = now + NextMessage(load);
+            stored++;
+            if(intervalS == 0u)
+            {
+                /* Beaconed at once, heard when the scan is on */
+                uint32 sent = now + Random(SIM_BEARER_INTERVAL_MS + 1u);
+                uint32 received = 0u;
+
+                if((IsReceived(load) == true) && (Random(100u) < SIM_SCAN_PERCENT))
+                {
+                    received = sent;
+                }
+                else if((IsReceived(load) == true) && (Random(100u) < SIM_SCAN_PERCENT))
+                {
+                    received = sent + SIM_BEARER_INTERVAL_MS;
+                }
+                else
+                {
+                    /* Both copies missed */
+                }
+                Deliver(received, now);
+            }
+            else if(FriendStore(next, 0x3Bu, data, sizeof(data), now) == FRIEND_STORED_EVICTED)
+            {
+                evicted++;
+            }
+            else
+            {
+                /* Cached */
+            }
+        }
+    }
+
+    /* Average of one peripheral */
+    if(intervalS == 0u)
+    {
+        current = (SIM_SCAN_PERCENT / 100.0) * SIM_RX_UA + (SIM_ADV_UC * 1000.0 / SIM_KEEP_ALIVE_MS) + SIM_IDLE_UA;
+        printf("%-5s %7s %7s", "scan", "-", "-");
+    }
+    else
+    {
+        current = (((double)windowMs * SIM_RX_UA) + (polls * SIM_ADV_UC * 1000.0)) /
+                  ((double)SIM_DURATION_MS * load->tags) + SIM_IDLE_UA;
+        printf("%-5u %7.1f %7.0f", intervalS, polls * 3600000.0 / ((double)SIM_DURATION_MS * load->tags),
+               (double)windowMs / polls);
+    }
+    printf(" %9.1f %7.1f", current, SIM_BATTERY_MAH * 1000.0 / current / 24.0);
+
+    qsort(latency, delivered, sizeof(latency[0]), CompareTime);
+    if(delivered == 0u)
+    {
+        printf(" %7s %7s", "-", "-");
+    }
+    else
+    {
+        printf(" %7.2f %7.2f", latency[delivered / 2u] / 1000.0, latency[(delivered * 99u) / 100u] / 1000.0);
+    }
+    printf(" %7.2f%% %6.2f%%\n", (stored != 0u) ? (100.0 * evicted / stored) : 0.0,
+           (stored != 0u) ? (100.0 * lost / stored) : 0.0);
+}
+
+
+int main(void)
+{
+    uint32 i;
+    uint32 j;
+
+    printf("%u h per row, cache of %u messages, quota %u, burst %u, window %u ms\n", SIM_DURATION_MS / 3600000u,
+           FRIEND_CACHE_SIZE, FRIEND_TAG_QUOTA, FRIEND_POLL_BURST, SIM_WINDOW_MS);
+    printf("RX %.0f uA, advertising event %.0f uC, idle %.0f uA, battery %.0f mAh\n", SIM_RX_UA, SIM_ADV_UC,
+           SIM_IDLE_UA, SIM_BATTERY_MAH);
+
+    for(i = 0u; i < SIM_LOAD_COUNT; i++)
+    {
+        printf("\n%u peripherals, a message every %u s each, %u%% loss\n", simLoads[i].tags,
+               simLoads[i].messagePeriodS, simLoads[i].lossPercent);
+        printf("%-5s %7s %7s %9s %7s %7s %7s %8s %7s\n", "poll", "polls/h", "win ms", "uA", "days", "p50 s",
+               "p99 s", "evicted", "lost");
+        for(j = 0u; j < SIM_INTERVAL_COUNT; j++)
+        {
+            Simulate(&simLoads[i], simIntervals[j]);
+        }
+    }
+
+    return 0;
+}
+
+/* [] END OF FILE */
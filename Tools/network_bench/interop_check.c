@@ -0,0 +1,2547 @@
+/*******************************************************************************
+* Interop check of the in-tree replacements of SM_LIB_256K.a members against
+* the library objects they replace: CyMesh_Network.c, CyMesh_Transport.c,
+* CyMesh_MessageQueue.c and CyMesh_SecurityPVT.c.
+*
+* The stock CyMesh_Network, CyMesh_Transport, CyMesh_MessageQueue,
+* CyMesh_Security and CyMesh_SecurityPVT objects are loaded from the archive
+* and run on a small ARMv6-M (Thumb) interpreter, as a node of their own. The
+* replacements are built for the host, with the stock CyMesh_Security object,
+* which stays in the build, running on a second interpreter. Both nodes get
+* the same configuration, so every PDU one of them sends is the PDU the other
+* has to send, and every PDU they receive must reach the upper layer and the
+* relay alike. Checked byte for byte:
+*
+*  - AES-CCM of the stock CyMesh_SecurityPVT and of CyMesh_SecurityPVT.c,
+*  - network PDUs of CyMesh_NetworkSendData(),
+*  - network PDUs delivered to the transport layer and relayed, including
+*    duplicates, own and forged PDUs (the replacement relays after its
+*    managed flooding back-off),
+*  - transport PDUs of CyMesh_TransportSendData() with the application and
+*    device keys, and their delivery to the application layer,
+*  - access PDUs of CyMesh_TxMessageQueueInsert() and
+*    CyMesh_SchedulePendingTxMessagePackets().
+*
+* The stock CyMesh_SecurityPVT runs every block on CyBle_AesEncrypt() of the
+* BLE component, which is modelled here as AES-128 on byte reversed (LSB
+* first) key, input and output. That is the order CyMesh_SecurityPVTAesEncrypt
+* swaps the MSB first arrays of the stack into; the AES-CCM check fails if the
+* model is wrong. From the repository root:
+*
+*   gcc -O2 -I Tools/network_bench -I "Firmware_Mesh/SM Files" -o interop_check \
+*       Tools/network_bench/interop_check.c "Firmware_Mesh/SM Files/CyMesh_Network.c" \
+*       "Firmware_Mesh/SM Files/CyMesh_NetworkCache.c" "Firmware_Mesh/SM Files/CyMesh_NetworkReplay.c" \
+*       "Firmware_Mesh/SM Files/CyMesh_NetworkFlood.c" "Firmware_Mesh/SM Files/CyMesh_NetworkHops.c" \
+*       "Firmware_Mesh/SM Files/CyMesh_SecurityPVT.c" "Firmware_Mesh/SM Files/CyMesh_Transport.c" \
+*       "Firmware_Mesh/SM Files/CyMesh_TransportSar.c" "Firmware_Mesh/SM Files/CyMesh_MessageQueue.c" \
+*       "Firmware_Mesh/SM Files/CyMesh_MessageQueueIndex.c" "Firmware_Mesh/SM Files/CyMesh_MessageQueueRto.c"
+*
+* Run it from the repository root, it reads "Firmware_Mesh/SM Files/SM_LIB_256K.a"
+* (or the archive given as its argument).
+*
+* Exits with 1 if a check fails, with 2 if the library cannot be run.
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <elf.h>
+#include <project.h>
+#include "CyMesh_Network.h"
+#include "CyMesh_NetworkFlood.h"
+#include "CyMesh_Transport.h"
+#include "CyMesh_MessageQueue.h"
+#include "CyMesh_Application.h"
+#include "CyMesh_Bearer.h"
+#include "CyMesh_BearerTx.h"
+#include "CyMesh_Configuration.h"
+#include "CyMesh_Security.h"
+#include "CyMesh_SecurityPVT.h"
+
+#define INTEROP_LIBRARY             "Firmware_Mesh/SM Files/SM_LIB_256K.a"
+#define INTEROP_PDU_SIZE            (40u)
+#define INTEROP_IV_INDEX            (0x12345678u)
+#define INTEROP_SEQ_NUM             (0x001000u)     /* seq_num of both nodes at the start */
+#define INTEROP_OWN_ADDRESS         (0x0010u)       /* Component 0 of both nodes */
+#define INTEROP_SOURCE_ADDRESS      (0x0002u)       /* Node the received PDUs come from */
+#define INTEROP_PEER_ADDRESS        (0x0003u)       /* Node the sent PDUs go to */
+#define INTEROP_RELAY_ADDRESS       (0x0020u)       /* Unicast address of neither node */
+#define INTEROP_GROUP_ADDRESS       (0xC001u)       /* Subscribed by model 1 of component 2 */
+#define INTEROP_OTHER_GROUP_ADDRESS (0xC002u)
+#define INTEROP_VIRTUAL_ADDRESS     (0x8123u)
+#define INTEROP_BROADCAST_ADDRESS   (0xFFFFu)
+#define INTEROP_TTL                 (5u)
+
+/* The emulated nodes */
+#define EMU_BASE                    (0x20000000u)
+#define EMU_SIZE                    (0x40000u)      /* Code, data and stack */
+#define EMU_STACK_SIZE              (0x2000u)
+#define EMU_MAX_SYMBOLS             (512u)
+#define EMU_MAX_STUBS               (128u)
+#define EMU_MAX_SECTIONS            (512u)
+#define EMU_SCRATCH_BUFFERS         (4u)
+#define EMU_SCRATCH_SIZE            (64u)
+#define EMU_PLACEHOLDER_SIZE        (64u)           /* Library variables the checks do not reach */
+#define EMU_MAX_STEPS               (20000000u)     /* Per call from the host */
+#define EMU_UDF                     (0xDE00u)       /* UDF #n in the stub area: host function n */
+#define EMU_RETURN_STUB             (0u)            /* Ends a call from the host */
+
+/* Layouts of the library (arm-none-eabi), from the DWARF of SM_LIB_256K.a */
+#define ARM_CONFIG_SIZE             (720u)
+#define ARM_CONFIG_COMPONENTS       (4u)
+#define ARM_COMPONENT_SIZE          (128u)
+#define ARM_COMPONENT_MODEL         (8u)
+#define ARM_MODEL_SIZE              (52u)
+#define ARM_CONFIG_DEFAULT_TTL      (516u)
+#define ARM_CONFIG_DEVICE_KEY       (517u)
+#define ARM_CONFIG_APP_INFO         (540u)
+#define ARM_CONFIG_APP_INFO_SIZE    (72u)
+#define ARM_CONFIG_NET_INFO         (612u)
+#define ARM_CONFIG_NET_INFO_SIZE    (80u)
+#define ARM_CONFIG_BEARER_ROLE      (692u)
+#define ARM_CONFIG_SEQ_NUM          (712u)
+
+#define ARM_TX_NODE_SIZE            (40u)           /* CYMESH_TX_MESSAGE_NODE_T */
+
+#ifndef R_ARM_THM_CALL
+    #define R_ARM_THM_CALL          R_ARM_THM_PC22  /* Older name in <elf.h> */
+#endif
+
+#if (CYMESH_NUMBER_OF_COMPONENTS != 4) || (CYMESH_MAX_MODELS_PER_COMPONENT != 2) || \
+    (CYMESH_MAX_SUBSCRIPTION_ADDRESSES != 11) || (CYMESH_MAX_NETWORK_KEYS != 1) || (CYMESH_MAX_APPLICATION_KEYS != 2)
+    #error "The configuration no longer matches the one SM_LIB_256K.a was built with"
+#endif
+
+typedef struct EMU_S EMU_T;
+
+/* Host function called by the library; returns r0 */
+typedef uint32 (* EMU_HOOK_T)(EMU_T * emu);
+
+typedef struct
+{
+    const char * name;
+    EMU_HOOK_T hook;
+} EMU_HOOK_ENTRY_T;
+
+typedef struct
+{
+    const char * name;
+    uint32 address;
+} EMU_SYMBOL_T;
+
+struct EMU_S
+{
+    const char * name;
+    uint32 r[16];
+    bool n;
+    bool z;
+    bool c;
+    bool v;
+    uint8 * memory;
+    uint32 top;                 /* Next free address */
+    uint32 codeStart;
+    uint32 codeEnd;
+    uint32 stubBase;
+    EMU_SYMBOL_T symbol[EMU_MAX_SYMBOLS];
+    uint32 symbolCount;
+    EMU_HOOK_T stub[EMU_MAX_STUBS];
+    const char * stubName[EMU_MAX_STUBS];
+    uint32 stubCount;
+    uint32 stubCalled;          /* Stub of the hook running */
+    const EMU_HOOK_ENTRY_T * hooks;
+    uint32 config;              /* cyMesh_ConfigInfoRam */
+    uint32 scratch[EMU_SCRATCH_BUFFERS];
+};
+
+/* What a node put on air */
+typedef struct
+{
+    uint8 data[INTEROP_PDU_SIZE];
+    uint8 length;
+    uint32 count;
+} INTEROP_PDU_T;
+
+/* What a node passed to its upper layer; the fields of CYMESH_NETWORK_PKT_T
+ * or CYMESH_TRANSPORT_PKT_T */
+typedef struct
+{
+    uint32 event;
+    uint8 data[INTEROP_PDU_SIZE];
+    uint8 length;
+    uint8 netKeyIndex;
+    uint8 appKeyIndex;
+    uint8 isAppKeyUsed;
+    uint8 componentIndex;
+    uint8 modelIndex;
+    uint16 srcAddress;
+    uint32 count;
+} INTEROP_DELIVERY_T;
+
+typedef struct
+{
+    INTEROP_PDU_T air;
+    INTEROP_DELIVERY_T delivered;
+} INTEROP_NODE_T;
+
+/* Library symbols the replacements use */
+CYMESH_DEVICE_CONFIG_T cyMesh_ConfigInfoRam;
+CYMESH_PROFILES_MUTEX_T profilesMutex;
+CYBLE_MODEL_CALLBACK_T cyMesh_GenericEventCallback;
+bool isPeerDeviceKeyValid;
+uint8 peerDeviceKey[16];
+
+uint8 cySimSflashDie[2] = { 0x17u, 0x2Cu };
+
+static EMU_T stockEmu;          /* The stock node */
+static EMU_T securityEmu;       /* CyMesh_Security of the replacement node */
+static INTEROP_NODE_T stock;
+static INTEROP_NODE_T replacement;
+static CYMESH_CALLBACK_T bearerCallback;
+static uint32 interopTime;
+static uint8 aesSbox[256];
+static uint32 failures;
+
+
+/*******************************************************************************
+* AES-128, for CyBle_AesEncrypt() of the stock node
+*******************************************************************************/
+static uint8 AesXtime(uint8 x)
+{
+    return (uint8)((x << 1) ^ (((x >> 7) & 1u) * 0x1Bu));
+}
+
+
+static uint8 AesRotate(uint8 x, uint8 shift)
+{
+    return (uint8)((x << shift) | (x >> (8u - shift)));
+}
+
+
+/* S-box from the multiplicative inverse in GF(2^8), walked through the
+ * powers of 3 */
+static void AesInit(void)
+{
+    uint8 p = 1u;
+    uint8 q = 1u;
+
+    do
+    {
+        p = (uint8)(p ^ AesXtime(p));
+        q ^= (uint8)(q << 1);
+        q ^= (uint8)(q << 2);
+        q ^= (uint8)(q << 4);
+        if((q & 0x80u) != 0u)
+        {
+            q ^= 0x09u;
+        }
+        aesSbox[p] = (uint8)(q ^ AesRotate(q, 1u) ^ AesRotate(q, 2u) ^ AesRotate(q, 3u) ^ AesRotate(q, 4u) ^ 0x63u);
+    }
+    while(p != 1u);
+    aesSbox[0] = 0x63u;
+}
+
+
+static void AesEncrypt(const uint8 * key, const uint8 * input, uint8 * output)
+{
+    uint8 roundKey[176];
+    uint8 state[16];
+    uint8 block[16];
+    uint8 word[4];
+    uint8 rcon = 1u;
+    uint8 round;
+    uint8 i;
+    uint8 j;
+
+    memcpy(roundKey, key, 16u);
+    for(i = 16u; i < 176u; i += 4u)
+    {
+        memcpy(word, &roundKey[i - 4u], 4u);
+        if((i % 16u) == 0u)
+        {
+            uint8 first = word[0];
+
+            word[0] = aesSbox[word[1]] ^ rcon;
+            word[1] = aesSbox[word[2]];
+            word[2] = aesSbox[word[3]];
+            word[3] = aesSbox[first];
+            rcon = AesXtime(rcon);
+        }
+        for(j = 0u; j < 4u; j++)
+        {
+            roundKey[i + j] = roundKey[i - 16u + j] ^ word[j];
+        }
+    }
+
+    for(i = 0u; i < 16u; i++)
+    {
+        state[i] = input[i] ^ roundKey[i];
+    }
+
+    for(round = 1u; round <= 10u; round++)
+    {
+        /* SubBytes and ShiftRows */
+        for(i = 0u; i < 4u; i++)
+        {
+            for(j = 0u; j < 4u; j++)
+            {
+                block[j + (4u * i)] = aesSbox[state[j + (4u * ((i + j) & 3u))]];
+            }
+        }
+
+        if(round != 10u)
+        {
+            for(i = 0u; i < 16u; i += 4u)
+            {
+                uint8 a0 = block[i];
+                uint8 a1 = block[i + 1u];
+                uint8 a2 = block[i + 2u];
+                uint8 a3 = block[i + 3u];
+                uint8 all = a0 ^ a1 ^ a2 ^ a3;
+
+                block[i] = a0 ^ all ^ AesXtime(a0 ^ a1);
+                block[i + 1u] = a1 ^ all ^ AesXtime(a1 ^ a2);
+                block[i + 2u] = a2 ^ all ^ AesXtime(a2 ^ a3);
+                block[i + 3u] = a3 ^ all ^ AesXtime(a3 ^ a0);
+            }
+        }
+
+        for(i = 0u; i < 16u; i++)
+        {
+            state[i] = block[i] ^ roundKey[(16u * round) + i];
+        }
+    }
+
+    memcpy(output, state, 16u);
+}
+
+
+/* FIPS-197 appendix C.1 */
+static bool AesSelfTest(void)
+{
+    static const uint8 expected[16] =
+        { 0x69, 0xC4, 0xE0, 0xD8, 0x6A, 0x7B, 0x04, 0x30, 0xD8, 0xCD, 0xB7, 0x80, 0x70, 0xB4, 0xC5, 0x5A };
+    uint8 key[16];
+    uint8 input[16];
+    uint8 output[16];
+    uint8 i;
+
+    for(i = 0u; i < 16u; i++)
+    {
+        key[i] = i;
+        input[i] = (uint8)(i * 0x11u);
+    }
+    AesEncrypt(key, input, output);
+    return (memcmp(output, expected, 16u) == 0);
+}
+
+
+static void Reverse(uint8 * output, const uint8 * input, uint8 length)
+{
+    uint8 i;
+
+    for(i = 0u; i < length; i++)
+    {
+        output[i] = input[length - 1u - i];
+    }
+}
+
+
+
+/*******************************************************************************
+* ARMv6-M emulator
+*******************************************************************************/
+static const char * EmuNearestSymbol(const EMU_T * emu, uint32 address, uint32 * offset)
+{
+    const char * name = "?";
+    uint32 best = 0u;
+    uint32 i;
+
+    *offset = address;
+    for(i = 0u; i < emu->symbolCount; i++)
+    {
+        uint32 start = emu->symbol[i].address & ~1u;
+
+        if((start <= address) && (start >= best))
+        {
+            best = start;
+            name = emu->symbol[i].name;
+            *offset = address - start;
+        }
+    }
+    return name;
+}
+
+
+static void EmuFault(const EMU_T * emu, const char * what, uint32 value)
+{
+    uint32 offset;
+    const char * name = EmuNearestSymbol(emu, emu->r[15], &offset);
+
+    printf("%s: %s 0x%08X at pc 0x%08X (%s+0x%X)\n", emu->name, what, value, emu->r[15], name, offset);
+    exit(2);
+}
+
+
+static uint8 * EmuPtr(EMU_T * emu, uint32 address, uint32 length)
+{
+    if((address < EMU_BASE) || (((address - EMU_BASE) + length) > EMU_SIZE))
+    {
+        EmuFault(emu, "access to", address);
+    }
+    return &emu->memory[address - EMU_BASE];
+}
+
+
+/* Library pointer argument; NULL stays NULL */
+static uint8 * EmuPtrOrNull(EMU_T * emu, uint32 address, uint32 length)
+{
+    return (address == 0u) ? NULL : EmuPtr(emu, address, length);
+}
+
+
+static uint32 EmuRead(EMU_T * emu, uint32 address, uint8 size)
+{
+    const uint8 * p = EmuPtr(emu, address, size);
+    uint32 value = 0u;
+    uint8 i;
+
+    for(i = size; i > 0u; i--)
+    {
+        value = (value << 8) | p[i - 1u];
+    }
+    return value;
+}
+
+
+static void EmuWrite(EMU_T * emu, uint32 address, uint32 value, uint8 size)
+{
+    uint8 * p = EmuPtr(emu, address, size);
+    uint8 i;
+
+    for(i = 0u; i < size; i++)
+    {
+        p[i] = (uint8)value;
+        value >>= 8;
+    }
+}
+
+
+static void EmuPut(EMU_T * emu, uint32 address, const uint8 * data, uint32 length)
+{
+    memcpy(EmuPtr(emu, address, length), data, length);
+}
+
+
+static void EmuGet(EMU_T * emu, uint32 address, uint8 * data, uint32 length)
+{
+    memcpy(data, EmuPtr(emu, address, length), length);
+}
+
+
+static uint32 EmuAlloc(EMU_T * emu, uint32 size, uint32 align)
+{
+    uint32 address;
+
+    if(align == 0u)
+    {
+        align = 1u;
+    }
+    address = (emu->top + align - 1u) & ~(align - 1u);
+    if(((address - EMU_BASE) + size) > (EMU_SIZE - EMU_STACK_SIZE))
+    {
+        EmuFault(emu, "out of memory for", size);
+    }
+    emu->top = address + size;
+    return address;
+}
+
+
+static uint32 EmuFind(const EMU_T * emu, const char * name)
+{
+    uint32 i;
+
+    for(i = 0u; i < emu->symbolCount; i++)
+    {
+        if(strcmp(emu->symbol[i].name, name) == 0)
+        {
+            return emu->symbol[i].address;
+        }
+    }
+    return 0u;
+}
+
+
+static void EmuDefine(EMU_T * emu, const char * name, uint32 address)
+{
+    if(emu->symbolCount == EMU_MAX_SYMBOLS)
+    {
+        EmuFault(emu, "too many symbols", emu->symbolCount);
+    }
+    emu->symbol[emu->symbolCount].name = name;
+    emu->symbol[emu->symbolCount].address = address;
+    emu->symbolCount++;
+}
+
+
+/* Thumb address the library can call hook at */
+static uint32 EmuStub(EMU_T * emu, EMU_HOOK_T hook, const char * name)
+{
+    uint32 index = emu->stubCount;
+
+    if(index == EMU_MAX_STUBS)
+    {
+        EmuFault(emu, "too many stubs", index);
+    }
+    emu->stub[index] = hook;
+    emu->stubName[index] = name;
+    emu->stubCount++;
+    return (emu->stubBase + (2u * index)) | 1u;
+}
+
+
+static uint32 EmuTrap(EMU_T * emu)
+{
+    printf("%s: the library called %s, which the check does not provide\n", emu->name,
+           emu->stubName[emu->stubCalled]);
+    exit(2);
+}
+
+
+/* Argument index of the hook running: r0 to r3, then the stack */
+static uint32 EmuArg(EMU_T * emu, uint8 index)
+{
+    return (index < 4u) ? emu->r[index] : EmuRead(emu, emu->r[13] + (4u * (index - 4u)), 4u);
+}
+
+
+static void EmuNz(EMU_T * emu, uint32 value)
+{
+    emu->n = ((value >> 31) != 0u);
+    emu->z = (value == 0u);
+}
+
+
+static uint32 EmuAdd(EMU_T * emu, uint32 x, uint32 y, uint32 carry)
+{
+    uint64_t unsignedSum = (uint64_t)x + y + carry;
+    int64_t signedSum = (int64_t)(int32_t)x + (int32_t)y + (int64_t)carry;
+    uint32 result = (uint32)unsignedSum;
+
+    EmuNz(emu, result);
+    emu->c = ((unsignedSum >> 32) != 0u);
+    emu->v = ((int64_t)(int32_t)result != signedSum);
+    return result;
+}
+
+
+static bool EmuCondition(const EMU_T * emu, uint8 condition)
+{
+    switch(condition)
+    {
+        case 0u:  return emu->z;
+        case 1u:  return !emu->z;
+        case 2u:  return emu->c;
+        case 3u:  return !emu->c;
+        case 4u:  return emu->n;
+        case 5u:  return !emu->n;
+        case 6u:  return emu->v;
+        case 7u:  return !emu->v;
+        case 8u:  return emu->c && !emu->z;
+        case 9u:  return !emu->c || emu->z;
+        case 10u: return emu->n == emu->v;
+        case 11u: return emu->n != emu->v;
+        case 12u: return !emu->z && (emu->n == emu->v);
+        case 13u: return emu->z || (emu->n != emu->v);
+        default:  return true;
+    }
+}
+
+
+static uint32 EmuSignExtend(uint32 value, uint8 bits)
+{
+    uint32 sign = 1u << (bits - 1u);
+
+    return (value ^ sign) - sign;
+}
+
+
+/* Register operand; the PC reads 4 bytes ahead of the instruction */
+static uint32 EmuReg(const EMU_T * emu, uint8 index, uint32 pc)
+{
+    return (index == 15u) ? (pc + 4u) : emu->r[index];
+}
+
+
+static void EmuBranch(EMU_T * emu, uint32 target)
+{
+    if((target & 1u) == 0u)
+    {
+        EmuFault(emu, "switch to ARM state at", target);
+    }
+    emu->r[15] = target & ~1u;
+}
+
+
+/* Shifts of the data processing group; amount from a register */
+static uint32 EmuShift(EMU_T * emu, uint8 type, uint32 value, uint32 amount)
+{
+    amount &= 0xFFu;
+    if(amount == 0u)
+    {
+        return value;
+    }
+
+    switch(type)
+    {
+        case 0u:    /* LSL */
+            emu->c = (amount <= 32u) ? (((value >> (32u - amount)) & 1u) != 0u) : false;
+            return (amount < 32u) ? (value << amount) : 0u;
+
+        case 1u:    /* LSR */
+            emu->c = (amount <= 32u) ? (((value >> (amount - 1u)) & 1u) != 0u) : false;
+            return (amount < 32u) ? (value >> amount) : 0u;
+
+        case 2u:    /* ASR */
+            if(amount >= 32u)
+            {
+                emu->c = ((value >> 31) != 0u);
+                return emu->c ? 0xFFFFFFFFu : 0u;
+            }
+            emu->c = (((value >> (amount - 1u)) & 1u) != 0u);
+            return (uint32)((int32_t)value >> amount);
+
+        default:    /* ROR */
+            amount &= 31u;
+            if(amount != 0u)
+            {
+                value = (value >> amount) | (value << (32u - amount));
+            }
+            emu->c = ((value >> 31) != 0u);
+            return value;
+    }
+}
+
+
+static void EmuDataProcessing(EMU_T * emu, uint16 h)
+{
+    uint8 rd = h & 7u;
+    uint32 x = emu->r[rd];
+    uint32 y = emu->r[(h >> 3) & 7u];
+    uint32 result;
+
+    switch((h >> 6) & 0xFu)
+    {
+        case 0x0u: result = x & y; EmuNz(emu, result); break;
+        case 0x1u: result = x ^ y; EmuNz(emu, result); break;
+        case 0x2u: result = EmuShift(emu, 0u, x, y); EmuNz(emu, result); break;
+        case 0x3u: result = EmuShift(emu, 1u, x, y); EmuNz(emu, result); break;
+        case 0x4u: result = EmuShift(emu, 2u, x, y); EmuNz(emu, result); break;
+        case 0x5u: result = EmuAdd(emu, x, y, emu->c ? 1u : 0u); break;
+        case 0x6u: result = EmuAdd(emu, x, ~y, emu->c ? 1u : 0u); break;
+        case 0x7u: result = EmuShift(emu, 3u, x, y); EmuNz(emu, result); break;
+        case 0x8u: EmuNz(emu, x & y); return;
+        case 0x9u: result = EmuAdd(emu, 0u, ~y, 1u); break;
+        case 0xAu: (void)EmuAdd(emu, x, ~y, 1u); return;
+        case 0xBu: (void)EmuAdd(emu, x, y, 0u); return;
+        case 0xCu: result = x | y; EmuNz(emu, result); break;
+        case 0xDu: result = x * y; EmuNz(emu, result); break;
+        case 0xEu: result = x & ~y; EmuNz(emu, result); break;
+        default:   result = ~y; EmuNz(emu, result); break;
+    }
+    emu->r[rd] = result;
+}
+
+
+static void EmuExecute(EMU_T * emu, uint16 h, uint32 pc)
+{
+    uint8 rd = h & 7u;
+    uint8 rn = (h >> 3) & 7u;
+    uint8 rm = (h >> 6) & 7u;
+    uint32 imm5 = (h >> 6) & 0x1Fu;
+    uint32 address;
+    uint32 value;
+    uint8 i;
+
+    switch(h >> 11)
+    {
+        case 0x00u:     /* LSLS #imm, MOVS */
+            value = emu->r[rn];
+            if(imm5 != 0u)
+            {
+                emu->c = (((value >> (32u - imm5)) & 1u) != 0u);
+                value <<= imm5;
+            }
+            emu->r[rd] = value;
+            EmuNz(emu, value);
+            return;
+
+        case 0x01u:     /* LSRS #imm */
+            value = emu->r[rn];
+            imm5 = (imm5 == 0u) ? 32u : imm5;
+            emu->c = (((value >> (imm5 - 1u)) & 1u) != 0u);
+            value = (imm5 == 32u) ? 0u : (value >> imm5);
+            emu->r[rd] = value;
+            EmuNz(emu, value);
+            return;
+
+        case 0x02u:     /* ASRS #imm */
+            value = emu->r[rn];
+            imm5 = (imm5 == 0u) ? 32u : imm5;
+            emu->c = (((value >> (imm5 - 1u)) & 1u) != 0u);
+            value = (imm5 == 32u) ? (((value >> 31) != 0u) ? 0xFFFFFFFFu : 0u) : (uint32)((int32_t)value >> imm5);
+            emu->r[rd] = value;
+            EmuNz(emu, value);
+            return;
+
+        case 0x03u:     /* ADDS/SUBS register or #imm3 */
+            value = ((h & 0x0400u) != 0u) ? rm : emu->r[rm];
+            emu->r[rd] = ((h & 0x0200u) != 0u) ? EmuAdd(emu, emu->r[rn], ~value, 1u) : EmuAdd(emu, emu->r[rn], value, 0u);
+            return;
+
+        case 0x04u:     /* MOVS #imm8 */
+            emu->r[(h >> 8) & 7u] = h & 0xFFu;
+            EmuNz(emu, h & 0xFFu);
+            return;
+
+        case 0x05u:     /* CMP #imm8 */
+            (void)EmuAdd(emu, emu->r[(h >> 8) & 7u], ~(uint32)(h & 0xFFu), 1u);
+            return;
+
+        case 0x06u:     /* ADDS #imm8 */
+            emu->r[(h >> 8) & 7u] = EmuAdd(emu, emu->r[(h >> 8) & 7u], h & 0xFFu, 0u);
+            return;
+
+        case 0x07u:     /* SUBS #imm8 */
+            emu->r[(h >> 8) & 7u] = EmuAdd(emu, emu->r[(h >> 8) & 7u], ~(uint32)(h & 0xFFu), 1u);
+            return;
+
+        case 0x08u:
+            if((h & 0x0400u) == 0u)
+            {
+                EmuDataProcessing(emu, h);
+                return;
+            }
+            rd = (uint8)((h & 7u) | ((h >> 4) & 8u));
+            rn = (h >> 3) & 0xFu;
+            switch((h >> 8) & 3u)
+            {
+                case 0u:    /* ADD high registers */
+                    value = EmuReg(emu, rd, pc) + EmuReg(emu, rn, pc);
+                    if(rd == 15u)
+                    {
+                        emu->r[15] = value & ~1u;
+                    }
+                    else
+                    {
+                        emu->r[rd] = value;
+                    }
+                    return;
+
+                case 1u:    /* CMP high registers */
+                    (void)EmuAdd(emu, EmuReg(emu, rd, pc), ~EmuReg(emu, rn, pc), 1u);
+                    return;
+
+                case 2u:    /* MOV high registers */
+                    value = EmuReg(emu, rn, pc);
+                    if(rd == 15u)
+                    {
+                        emu->r[15] = value & ~1u;
+                    }
+                    else
+                    {
+                        emu->r[rd] = value;
+                    }
+                    return;
+
+                default:    /* BX, BLX */
+                    value = EmuReg(emu, rn, pc);
+                    if((h & 0x0080u) != 0u)
+                    {
+                        emu->r[14] = (pc + 2u) | 1u;
+                    }
+                    EmuBranch(emu, value);
+                    return;
+            }
+
+        case 0x09u:     /* LDR literal */
+            emu->r[(h >> 8) & 7u] = EmuRead(emu, ((pc + 4u) & ~3u) + (4u * (h & 0xFFu)), 4u);
+            return;
+
+        case 0x0Au:
+        case 0x0Bu:     /* Load/store register offset */
+            address = emu->r[rn] + emu->r[rm];
+            switch((h >> 9) & 7u)
+            {
+                case 0u: EmuWrite(emu, address, emu->r[rd], 4u); return;
+                case 1u: EmuWrite(emu, address, emu->r[rd], 2u); return;
+                case 2u: EmuWrite(emu, address, emu->r[rd], 1u); return;
+                case 3u: emu->r[rd] = EmuSignExtend(EmuRead(emu, address, 1u), 8u); return;
+                case 4u: emu->r[rd] = EmuRead(emu, address, 4u); return;
+                case 5u: emu->r[rd] = EmuRead(emu, address, 2u); return;
+                case 6u: emu->r[rd] = EmuRead(emu, address, 1u); return;
+                default: emu->r[rd] = EmuSignExtend(EmuRead(emu, address, 2u), 16u); return;
+            }
+
+        case 0x0Cu:     /* STR #imm */
+            EmuWrite(emu, emu->r[rn] + (4u * imm5), emu->r[rd], 4u);
+            return;
+
+        case 0x0Du:     /* LDR #imm */
+            emu->r[rd] = EmuRead(emu, emu->r[rn] + (4u * imm5), 4u);
+            return;
+
+        case 0x0Eu:     /* STRB #imm */
+            EmuWrite(emu, emu->r[rn] + imm5, emu->r[rd], 1u);
+            return;
+
+        case 0x0Fu:     /* LDRB #imm */
+            emu->r[rd] = EmuRead(emu, emu->r[rn] + imm5, 1u);
+            return;
+
+        case 0x10u:     /* STRH #imm */
+            EmuWrite(emu, emu->r[rn] + (2u * imm5), emu->r[rd], 2u);
+            return;
+
+        case 0x11u:     /* LDRH #imm */
+            emu->r[rd] = EmuRead(emu, emu->r[rn] + (2u * imm5), 2u);
+            return;
+
+        case 0x12u:     /* STR SP relative */
+            EmuWrite(emu, emu->r[13] + (4u * (h & 0xFFu)), emu->r[(h >> 8) & 7u], 4u);
+            return;
+
+        case 0x13u:     /* LDR SP relative */
+            emu->r[(h >> 8) & 7u] = EmuRead(emu, emu->r[13] + (4u * (h & 0xFFu)), 4u);
+            return;
+
+        case 0x14u:     /* ADR */
+            emu->r[(h >> 8) & 7u] = ((pc + 4u) & ~3u) + (4u * (h & 0xFFu));
+            return;
+
+        case 0x15u:     /* ADD Rd, SP, #imm8 */
+            emu->r[(h >> 8) & 7u] = emu->r[13] + (4u * (h & 0xFFu));
+            return;
+
+        case 0x16u:
+        case 0x17u:     /* Miscellaneous */
+            if((h & 0xFF00u) == 0xB000u)
+            {
+                value = 4u * (h & 0x7Fu);
+                emu->r[13] = ((h & 0x0080u) != 0u) ? (emu->r[13] - value) : (emu->r[13] + value);
+            }
+            else if((h & 0xFF00u) == 0xB200u)
+            {
+                value = emu->r[rn];
+                switch((h >> 6) & 3u)
+                {
+                    case 0u: emu->r[rd] = EmuSignExtend(value & 0xFFFFu, 16u); break;
+                    case 1u: emu->r[rd] = EmuSignExtend(value & 0xFFu, 8u); break;
+                    case 2u: emu->r[rd] = value & 0xFFFFu; break;
+                    default: emu->r[rd] = value & 0xFFu; break;
+                }
+            }
+            else if((h & 0xFE00u) == 0xB400u)
+            {
+                /* PUSH, lowest register at the lowest address */
+                uint8 count = (uint8)(((h >> 8) & 1u) + __builtin_popcount(h & 0xFFu));
+
+                address = emu->r[13] - (4u * count);
+                emu->r[13] = address;
+                for(i = 0u; i < 8u; i++)
+                {
+                    if(((h >> i) & 1u) != 0u)
+                    {
+                        EmuWrite(emu, address, emu->r[i], 4u);
+                        address += 4u;
+                    }
+                }
+                if((h & 0x0100u) != 0u)
+                {
+                    EmuWrite(emu, address, emu->r[14], 4u);
+                }
+            }
+            else if((h & 0xFE00u) == 0xBC00u)
+            {
+                address = emu->r[13];
+                for(i = 0u; i < 8u; i++)
+                {
+                    if(((h >> i) & 1u) != 0u)
+                    {
+                        emu->r[i] = EmuRead(emu, address, 4u);
+                        address += 4u;
+                    }
+                }
+                emu->r[13] = address + (((h & 0x0100u) != 0u) ? 4u : 0u);
+                if((h & 0x0100u) != 0u)
+                {
+                    EmuBranch(emu, EmuRead(emu, address, 4u));
+                }
+            }
+            else if((h & 0xFFC0u) == 0xBA00u)
+            {
+                value = emu->r[rn];
+                emu->r[rd] = (value >> 24) | ((value >> 8) & 0xFF00u) | ((value << 8) & 0xFF0000u) | (value << 24);
+            }
+            else if((h & 0xFFC0u) == 0xBA40u)
+            {
+                value = emu->r[rn];
+                emu->r[rd] = ((value >> 8) & 0x00FF00FFu) | ((value << 8) & 0xFF00FF00u);
+            }
+            else if((h & 0xFFC0u) == 0xBAC0u)
+            {
+                value = emu->r[rn];
+                emu->r[rd] = EmuSignExtend(((value >> 8) & 0xFFu) | ((value << 8) & 0xFF00u), 16u);
+            }
+            else if(((h & 0xFFE8u) != 0xB660u) && ((h & 0xFF00u) != 0xBF00u))
+            {
+                /* Only CPS and the hints are left as no-ops */
+                EmuFault(emu, "unknown instruction", h);
+            }
+            return;
+
+        case 0x18u:     /* STMIA */
+            address = emu->r[(h >> 8) & 7u];
+            for(i = 0u; i < 8u; i++)
+            {
+                if(((h >> i) & 1u) != 0u)
+                {
+                    EmuWrite(emu, address, emu->r[i], 4u);
+                    address += 4u;
+                }
+            }
+            emu->r[(h >> 8) & 7u] = address;
+            return;
+
+        case 0x19u:     /* LDMIA, written back unless the base is loaded */
+            rn = (h >> 8) & 7u;
+            address = emu->r[rn];
+            for(i = 0u; i < 8u; i++)
+            {
+                if(((h >> i) & 1u) != 0u)
+                {
+                    emu->r[i] = EmuRead(emu, address, 4u);
+                    address += 4u;
+                }
+            }
+            if(((h >> rn) & 1u) == 0u)
+            {
+                emu->r[rn] = address;
+            }
+            return;
+
+        case 0x1Au:
+        case 0x1Bu:     /* Conditional branch; UDF and SVC outside the stubs */
+            if(((h >> 8) & 0xFu) >= 14u)
+            {
+                EmuFault(emu, "UDF or SVC", h);
+            }
+            if(EmuCondition(emu, (h >> 8) & 0xFu) == true)
+            {
+                emu->r[15] = pc + 4u + EmuSignExtend(2u * (h & 0xFFu), 9u);
+            }
+            return;
+
+        case 0x1Cu:     /* B */
+            emu->r[15] = pc + 4u + EmuSignExtend(2u * (h & 0x7FFu), 12u);
+            return;
+
+        case 0x1Eu:     /* 32-bit: BL, barriers, MSR, MRS */
+        {
+            uint16 h2 = (uint16)EmuRead(emu, pc + 2u, 2u);
+
+            emu->r[15] = pc + 4u;
+            if((h2 & 0xD000u) == 0xD000u)
+            {
+                uint32 s = (h >> 10) & 1u;
+                uint32 i1 = ((~((h2 >> 13) ^ s)) & 1u);
+                uint32 i2 = ((~((h2 >> 11) ^ s)) & 1u);
+                uint32 offset = (s << 24) | (i1 << 23) | (i2 << 22) | ((uint32)(h & 0x3FFu) << 12) |
+                                ((uint32)(h2 & 0x7FFu) << 1);
+
+                emu->r[14] = (pc + 4u) | 1u;
+                emu->r[15] = pc + 4u + EmuSignExtend(offset, 25u);
+            }
+            else if((h == 0xF3EFu) && ((h2 & 0xF000u) == 0x8000u))
+            {
+                emu->r[(h2 >> 8) & 0xFu] = 0u;      /* MRS: PRIMASK and friends read 0 */
+            }
+            else if((h != 0xF3BFu) && ((h & 0xFFF0u) != 0xF380u))
+            {
+                EmuFault(emu, "unknown instruction", ((uint32)h << 16) | h2);
+            }
+            return;
+        }
+
+        default:
+            EmuFault(emu, "unknown instruction", h);
+            return;
+    }
+}
+
+
+/* Runs until the return stub */
+static void EmuRun(EMU_T * emu)
+{
+    uint32 steps = 0u;
+
+    for(;;)
+    {
+        uint32 pc = emu->r[15];
+        uint16 h;
+
+        if((pc < emu->codeStart) || (pc >= emu->codeEnd))
+        {
+            EmuFault(emu, "pc outside the code", pc);
+        }
+        h = (uint16)EmuRead(emu, pc, 2u);
+
+        if((pc >= emu->stubBase) && ((h & 0xFF00u) == EMU_UDF))
+        {
+            emu->stubCalled = h & 0xFFu;
+            if(emu->stubCalled == EMU_RETURN_STUB)
+            {
+                return;
+            }
+            emu->r[0] = emu->stub[emu->stubCalled](emu);
+            EmuBranch(emu, emu->r[14]);
+            continue;
+        }
+
+        emu->r[15] = pc + 2u;
+        EmuExecute(emu, h, pc);
+        if(++steps > EMU_MAX_STEPS)
+        {
+            EmuFault(emu, "no return after steps", steps);
+        }
+    }
+}
+
+
+/* Calls a library function with count arguments. Hooks may call again. */
+static uint32 EmuCall(EMU_T * emu, uint32 function, uint8 count, const uint32 * args)
+{
+    uint32 saved[16];
+    uint32 sp;
+    uint32 result;
+    uint8 i;
+
+    memcpy(saved, emu->r, sizeof(saved));
+
+    sp = (emu->r[13] - (4u * ((count > 4u) ? (count - 4u) : 0u))) & ~7u;
+    for(i = 0u; i < count; i++)
+    {
+        if(i < 4u)
+        {
+            emu->r[i] = args[i];
+        }
+        else
+        {
+            EmuWrite(emu, sp + (4u * (i - 4u)), args[i], 4u);
+        }
+    }
+    emu->r[13] = sp;
+    emu->r[14] = (emu->stubBase + (2u * EMU_RETURN_STUB)) | 1u;
+    EmuBranch(emu, function);
+    EmuRun(emu);
+
+    result = emu->r[0];
+    memcpy(emu->r, saved, sizeof(saved));
+    return result;
+}
+
+
+static uint32 EmuCallName(EMU_T * emu, const char * name, uint8 count, ...)
+{
+    uint32 args[12];
+    uint32 function = EmuFind(emu, name);
+    va_list list;
+    uint8 i;
+
+    if(function == 0u)
+    {
+        printf("%s: no %s in the library\n", emu->name, name);
+        exit(2);
+    }
+
+    va_start(list, count);
+    for(i = 0u; i < count; i++)
+    {
+        args[i] = va_arg(list, uint32);
+    }
+    va_end(list);
+
+    return EmuCall(emu, function, count, args);
+}
+
+
+
+/*******************************************************************************
+* Loader of the library objects
+*******************************************************************************/
+static uint8 * LoadFile(const char * path, uint32 * size)
+{
+    FILE * file = fopen(path, "rb");
+    uint8 * data;
+    long length;
+
+    if(file == NULL)
+    {
+        printf("Cannot open %s; run from the repository root\n", path);
+        exit(2);
+    }
+    (void)fseek(file, 0, SEEK_END);
+    length = ftell(file);
+    (void)fseek(file, 0, SEEK_SET);
+    data = malloc((size_t)length);
+    if((data == NULL) || (fread(data, 1u, (size_t)length, file) != (size_t)length))
+    {
+        printf("Cannot read %s\n", path);
+        exit(2);
+    }
+    (void)fclose(file);
+    *size = (uint32)length;
+    return data;
+}
+
+
+/* ELF image of member name in a GNU ar archive */
+static const uint8 * FindMember(const uint8 * archive, uint32 size, const char * name)
+{
+    const char * longNames = NULL;
+    uint32 offset = 8u;
+    size_t nameLength = strlen(name);
+
+    if((size < 8u) || (memcmp(archive, "!<arch>\n", 8u) != 0))
+    {
+        return NULL;
+    }
+
+    while((offset + 60u) <= size)
+    {
+        const char * header = (const char *)&archive[offset];
+        uint32 memberSize = (uint32)strtoul(&header[48], NULL, 10);
+        const char * memberName = header;
+
+        if((header[0] == '/') && (header[1] == '/'))
+        {
+            longNames = &header[60];
+        }
+        else if((header[0] == '/') && (header[1] >= '0') && (header[1] <= '9') && (longNames != NULL))
+        {
+            memberName = &longNames[strtoul(&header[1], NULL, 10)];
+        }
+
+        if((memcmp(memberName, name, nameLength) == 0) && (memberName[nameLength] == '/'))
+        {
+            return &archive[offset + 60u];
+        }
+        offset += 60u + memberSize + (memberSize & 1u);
+    }
+    return NULL;
+}
+
+
+static Elf32_Ehdr ElfHeader(const uint8 * image)
+{
+    Elf32_Ehdr header;
+
+    memcpy(&header, image, sizeof(header));
+    return header;
+}
+
+
+static Elf32_Shdr ElfSection(const uint8 * image, uint32 index)
+{
+    Elf32_Ehdr header = ElfHeader(image);
+    Elf32_Shdr section;
+
+    memcpy(&section, &image[header.e_shoff + (index * header.e_shentsize)], sizeof(section));
+    return section;
+}
+
+
+static Elf32_Sym ElfSymbol(const uint8 * image, const Elf32_Shdr * symbols, uint32 index)
+{
+    Elf32_Sym symbol;
+
+    memcpy(&symbol, &image[symbols->sh_offset + (index * sizeof(symbol))], sizeof(symbol));
+    return symbol;
+}
+
+
+static const char * ElfName(const uint8 * image, const Elf32_Shdr * symbols, const Elf32_Sym * symbol)
+{
+    Elf32_Shdr strings = ElfSection(image, symbols->sh_link);
+
+    return (const char *)&image[strings.sh_offset + symbol->st_name];
+}
+
+
+/* Address of an undefined symbol: a hook, a trap for other functions or
+ * zeroed storage for other variables */
+static uint32 EmuResolve(EMU_T * emu, const char * name, bool isCall)
+{
+    uint32 address = EmuFind(emu, name);
+    const EMU_HOOK_ENTRY_T * hook;
+
+    if(address != 0u)
+    {
+        return address;
+    }
+
+    for(hook = emu->hooks; hook->name != NULL; hook++)
+    {
+        if(strcmp(hook->name, name) == 0)
+        {
+            address = EmuStub(emu, hook->hook, name);
+            break;
+        }
+    }
+    if(address == 0u)
+    {
+        address = (isCall == true) ? EmuStub(emu, EmuTrap, name) : EmuAlloc(emu, EMU_PLACEHOLDER_SIZE, 8u);
+    }
+    EmuDefine(emu, name, address);
+    return address;
+}
+
+
+static void EmuRelocate(EMU_T * emu, const uint8 * image, const uint32 * sectionBase)
+{
+    Elf32_Ehdr header = ElfHeader(image);
+    uint32 i;
+    uint32 j;
+
+    for(i = 1u; i < header.e_shnum; i++)
+    {
+        Elf32_Shdr relocations = ElfSection(image, i);
+        Elf32_Shdr symbols;
+
+        if((relocations.sh_type != SHT_REL) || (sectionBase[relocations.sh_info] == 0u))
+        {
+            continue;
+        }
+        symbols = ElfSection(image, relocations.sh_link);
+
+        for(j = 0u; j < (relocations.sh_size / sizeof(Elf32_Rel)); j++)
+        {
+            Elf32_Rel relocation;
+            Elf32_Sym symbol;
+            uint32 place;
+            uint32 target;
+            uint8 type;
+
+            memcpy(&relocation, &image[relocations.sh_offset + (j * sizeof(relocation))], sizeof(relocation));
+            symbol = ElfSymbol(image, &symbols, ELF32_R_SYM(relocation.r_info));
+            type = (uint8)ELF32_R_TYPE(relocation.r_info);
+            place = sectionBase[relocations.sh_info] + relocation.r_offset;
+
+            if(symbol.st_shndx == SHN_UNDEF)
+            {
+                target = EmuResolve(emu, ElfName(image, &symbols, &symbol), type == R_ARM_THM_CALL);
+            }
+            else if((symbol.st_shndx == SHN_COMMON) || (ELF32_ST_BIND(symbol.st_info) != STB_LOCAL))
+            {
+                target = EmuFind(emu, ElfName(image, &symbols, &symbol));
+            }
+            else
+            {
+                target = sectionBase[symbol.st_shndx] + symbol.st_value;
+            }
+
+            if(type == R_ARM_ABS32)
+            {
+                EmuWrite(emu, place, EmuRead(emu, place, 4u) + target, 4u);
+            }
+            else if(type == R_ARM_THM_CALL)
+            {
+                uint16 h1 = (uint16)EmuRead(emu, place, 2u);
+                uint16 h2 = (uint16)EmuRead(emu, place + 2u, 2u);
+                uint32 s = (h1 >> 10) & 1u;
+                uint32 addend = EmuSignExtend((s << 24) | (((~((h2 >> 13) ^ s)) & 1u) << 23) |
+                                              (((~((h2 >> 11) ^ s)) & 1u) << 22) | ((uint32)(h1 & 0x3FFu) << 12) |
+                                              ((uint32)(h2 & 0x7FFu) << 1), 25u);
+                uint32 offset = (target & ~1u) + addend - place;
+
+                s = offset >> 31;
+                h1 = (uint16)(0xF000u | (s << 10) | ((offset >> 12) & 0x3FFu));
+                h2 = (uint16)(0xD000u | ((((~(offset >> 23)) ^ s) & 1u) << 13) |
+                              ((((~(offset >> 22)) ^ s) & 1u) << 11) | ((offset >> 1) & 0x7FFu));
+                EmuWrite(emu, place, h1, 2u);
+                EmuWrite(emu, place + 2u, h2, 2u);
+            }
+            else if(type != R_ARM_NONE)
+            {
+                EmuFault(emu, "unsupported relocation type", type);
+            }
+        }
+    }
+}
+
+
+/* Places the sections of the members, code first, defines their symbols and
+ * relocates them */
+static void EmuLoad(EMU_T * emu, const uint8 * archive, uint32 archiveSize, const char * const * members,
+                    const EMU_HOOK_ENTRY_T * hooks)
+{
+    static uint32 sectionBase[8][EMU_MAX_SECTIONS];
+    const uint8 * image[8];
+    uint8 count;
+    uint8 pass;
+    uint32 i;
+    uint32 j;
+
+    emu->hooks = hooks;
+    for(count = 0u; members[count] != NULL; count++)
+    {
+        image[count] = FindMember(archive, archiveSize, members[count]);
+        if((image[count] == NULL) || (memcmp(image[count], ELFMAG, SELFMAG) != 0) ||
+           (ElfHeader(image[count]).e_machine != EM_ARM) || (ElfHeader(image[count]).e_shnum > EMU_MAX_SECTIONS))
+        {
+            printf("%s: no ARM object %s in the library\n", emu->name, members[count]);
+            exit(2);
+        }
+        memset(sectionBase[count], 0, sizeof(sectionBase[count]));
+    }
+
+    emu->codeStart = emu->top;
+    for(pass = 0u; pass < 2u; pass++)
+    {
+        for(i = 0u; i < count; i++)
+        {
+            for(j = 1u; j < ElfHeader(image[i]).e_shnum; j++)
+            {
+                Elf32_Shdr section = ElfSection(image[i], j);
+
+                if(((section.sh_flags & SHF_ALLOC) == 0u) ||
+                   ((section.sh_type != SHT_PROGBITS) && (section.sh_type != SHT_NOBITS)) ||
+                   (((section.sh_flags & SHF_EXECINSTR) != 0u) != (pass == 0u)))
+                {
+                    continue;
+                }
+                sectionBase[i][j] = EmuAlloc(emu, section.sh_size, section.sh_addralign);
+                if(section.sh_type == SHT_PROGBITS)
+                {
+                    EmuPut(emu, sectionBase[i][j], &image[i][section.sh_offset], section.sh_size);
+                }
+            }
+        }
+
+        if(pass == 0u)
+        {
+            emu->stubBase = EmuAlloc(emu, 2u * EMU_MAX_STUBS, 4u);
+            for(j = 0u; j < EMU_MAX_STUBS; j++)
+            {
+                EmuWrite(emu, emu->stubBase + (2u * j), EMU_UDF | j, 2u);
+            }
+            emu->codeEnd = emu->top;
+            (void)EmuStub(emu, NULL, "return");
+        }
+    }
+
+    for(i = 0u; i < count; i++)
+    {
+        for(j = 1u; j < ElfHeader(image[i]).e_shnum; j++)
+        {
+            Elf32_Shdr symbols = ElfSection(image[i], j);
+            uint32 k;
+
+            if(symbols.sh_type != SHT_SYMTAB)
+            {
+                continue;
+            }
+            for(k = 1u; k < (symbols.sh_size / sizeof(Elf32_Sym)); k++)
+            {
+                Elf32_Sym symbol = ElfSymbol(image[i], &symbols, k);
+                const char * name = ElfName(image[i], &symbols, &symbol);
+
+                if((ELF32_ST_BIND(symbol.st_info) == STB_LOCAL) || (symbol.st_shndx == SHN_UNDEF) ||
+                   (EmuFind(emu, name) != 0u))
+                {
+                    continue;
+                }
+                if(symbol.st_shndx == SHN_COMMON)
+                {
+                    EmuDefine(emu, name, EmuAlloc(emu, symbol.st_size, symbol.st_value));
+                }
+                else if(sectionBase[i][symbol.st_shndx] != 0u)
+                {
+                    EmuDefine(emu, name, sectionBase[i][symbol.st_shndx] + symbol.st_value);
+                }
+            }
+        }
+    }
+
+    for(i = 0u; i < count; i++)
+    {
+        EmuRelocate(emu, image[i], sectionBase[i]);
+    }
+
+    for(i = 0u; i < EMU_SCRATCH_BUFFERS; i++)
+    {
+        emu->scratch[i] = EmuAlloc(emu, EMU_SCRATCH_SIZE, 8u);
+    }
+}
+
+
+static void EmuInit(EMU_T * emu, const char * name)
+{
+    memset(emu, 0, sizeof(*emu));
+    emu->name = name;
+    emu->memory = calloc(EMU_SIZE, 1u);
+    if(emu->memory == NULL)
+    {
+        printf("Out of memory\n");
+        exit(2);
+    }
+    emu->top = EMU_BASE;
+    emu->r[13] = EMU_BASE + EMU_SIZE;
+
+    /* Defined by CyMesh_Configuration, which is not loaded */
+    emu->config = EmuAlloc(emu, ARM_CONFIG_SIZE, 8u);
+    EmuDefine(emu, "cyMesh_ConfigInfoRam", emu->config);
+}
+
+
+/* cyMesh_ConfigInfoRam of the host in the layout of the library */
+static void EmuSetConfig(EMU_T * emu, const CYMESH_DEVICE_CONFIG_T * config)
+{
+    uint32 i;
+    uint32 j;
+    uint32 k;
+
+    memset(EmuPtr(emu, emu->config, ARM_CONFIG_SIZE), 0, ARM_CONFIG_SIZE);
+    EmuWrite(emu, emu->config, config->isConfigurationValid, 1u);
+    for(i = 0u; i < ARM_CONFIG_COMPONENTS; i++)
+    {
+        const CYMESH_COMPONENT_T * component = &config->deviceInfo.components[i];
+        uint32 base = emu->config + 4u + (ARM_COMPONENT_SIZE * i);
+
+        EmuWrite(emu, base, component->componentAddress, 2u);
+        EmuWrite(emu, base + 2u, component->loc, 2u);
+        EmuWrite(emu, base + 4u, component->numberOfSigAdoptedModels, 1u);
+        EmuWrite(emu, base + 5u, component->numberOfVendorSpecificModels, 1u);
+        for(j = 0u; j < CYMESH_MAX_MODELS_PER_COMPONENT; j++)
+        {
+            const CYMESH_MODEL_T * model = &component->model[j];
+            uint32 modelBase = base + ARM_COMPONENT_MODEL + (ARM_MODEL_SIZE * j);
+
+            EmuWrite(emu, modelBase, (uint32)model->modelId, 2u);
+            EmuWrite(emu, modelBase + 2u, model->isVendorSpecificModel, 1u);
+            EmuWrite(emu, modelBase + 4u, model->publishAddress, 2u);
+            EmuWrite(emu, modelBase + 6u, model->publishAppKeyIndex, 1u);
+            for(k = 0u; k < CYMESH_MAX_SUBSCRIPTION_ADDRESSES; k++)
+            {
+                EmuWrite(emu, modelBase + 8u + (2u * k), model->subscriptionAddress[k], 2u);
+            }
+            EmuWrite(emu, modelBase + 30u, model->numberOfSubscribedAddresses, 1u);
+            EmuWrite(emu, modelBase + 32u, model->boundAppKeyMapping, 4u);
+            EmuWrite(emu, modelBase + 36u, model->numberOfBoundAppKeys, 1u);
+            EmuWrite(emu, modelBase + 37u, model->modelDefaultTtl, 1u);
+        }
+    }
+    EmuWrite(emu, emu->config + ARM_CONFIG_DEFAULT_TTL, config->deviceInfo.deviceDefaultTtl, 1u);
+    EmuPut(emu, emu->config + ARM_CONFIG_DEVICE_KEY, config->deviceInfo.deviceKey, 16u);
+    EmuPut(emu, emu->config + ARM_CONFIG_APP_INFO, (const uint8 *)&config->appInfo, ARM_CONFIG_APP_INFO_SIZE);
+    EmuPut(emu, emu->config + ARM_CONFIG_NET_INFO, (const uint8 *)&config->netInfo, ARM_CONFIG_NET_INFO_SIZE);
+    EmuWrite(emu, emu->config + ARM_CONFIG_BEARER_ROLE, (uint32)config->bearerRole, 1u);
+    EmuWrite(emu, emu->config + ARM_CONFIG_SEQ_NUM, config->seq_num, 4u);
+}
+
+
+
+/*******************************************************************************
+* Hooks of the library
+*******************************************************************************/
+static uint32 HookMemcpy(EMU_T * emu)
+{
+    uint32 length = EmuArg(emu, 2u);
+
+    if(length != 0u)
+    {
+        memmove(EmuPtr(emu, EmuArg(emu, 0u), length), EmuPtr(emu, EmuArg(emu, 1u), length), length);
+    }
+    return EmuArg(emu, 0u);
+}
+
+
+static uint32 HookMemset(EMU_T * emu)
+{
+    uint32 length = EmuArg(emu, 2u);
+
+    if(length != 0u)
+    {
+        memset(EmuPtr(emu, EmuArg(emu, 0u), length), (int)EmuArg(emu, 1u), length);
+    }
+    return EmuArg(emu, 0u);
+}
+
+
+static uint32 HookMemcmp(EMU_T * emu)
+{
+    uint32 length = EmuArg(emu, 2u);
+
+    if(length == 0u)
+    {
+        return 0u;
+    }
+    return (uint32)memcmp(EmuPtr(emu, EmuArg(emu, 0u), length), EmuPtr(emu, EmuArg(emu, 1u), length), length);
+}
+
+
+static uint32 HookNothing(EMU_T * emu)
+{
+    (void)emu;
+    return 0u;
+}
+
+
+static uint32 HookTrue(EMU_T * emu)
+{
+    (void)emu;
+    return 1u;
+}
+
+
+/* CyBle_AesEncrypt(plain, key, encrypted): the BLE hardware AES takes and
+ * gives LSB first arrays */
+static uint32 HookCyBleAesEncrypt(EMU_T * emu)
+{
+    uint8 key[16];
+    uint8 block[16];
+
+    Reverse(block, EmuPtr(emu, EmuArg(emu, 0u), 16u), 16u);
+    Reverse(key, EmuPtr(emu, EmuArg(emu, 1u), 16u), 16u);
+    AesEncrypt(key, block, block);
+    Reverse(EmuPtr(emu, EmuArg(emu, 2u), 16u), block, 16u);
+    return 0u;      /* CYBLE_ERROR_OK */
+}
+
+
+static uint32 HookTimerGetTimestamp(EMU_T * emu)
+{
+    (void)emu;
+    return interopTime;
+}
+
+
+static uint32 HookTxBufferStatus(EMU_T * emu)
+{
+    (void)emu;
+    return CYMESH_BEARER_TX_BUFFER_EMPTY;
+}
+
+
+static uint32 HookBearerSendData(EMU_T * emu)
+{
+    uint8 length = (uint8)EmuArg(emu, 1u);
+
+    if(length <= INTEROP_PDU_SIZE)
+    {
+        EmuGet(emu, EmuArg(emu, 0u), stock.air.data, length);
+        stock.air.length = length;
+    }
+    stock.air.count++;
+    return CYMESH_ERROR_OK;
+}
+
+
+/* Network layer callback given to the stock CyMesh_NetworkStart() */
+static uint32 HookNetworkCallback(EMU_T * emu)
+{
+    INTEROP_DELIVERY_T * delivered = &stock.delivered;
+    uint32 packet = EmuArg(emu, 1u);
+
+    delivered->event = EmuArg(emu, 0u);
+    delivered->length = (uint8)EmuRead(emu, packet + 4u, 1u);
+    if(delivered->length <= INTEROP_PDU_SIZE)
+    {
+        EmuGet(emu, EmuRead(emu, packet, 4u), delivered->data, delivered->length);
+    }
+    delivered->netKeyIndex = (uint8)EmuRead(emu, packet + 5u, 1u);
+    delivered->componentIndex = (uint8)EmuRead(emu, packet + 6u, 1u);
+    delivered->modelIndex = (uint8)EmuRead(emu, packet + 7u, 1u);
+    delivered->count++;
+    return CYMESH_ERROR_OK;
+}
+
+
+/* Application layer callback given to the stock CyMesh_TransportStart() */
+static uint32 HookApplicationCallback(EMU_T * emu)
+{
+    INTEROP_DELIVERY_T * delivered = &stock.delivered;
+    uint32 packet = EmuArg(emu, 1u);
+
+    delivered->event = EmuArg(emu, 0u);
+    delivered->length = (uint8)EmuRead(emu, packet + 4u, 1u);
+    if(delivered->length <= INTEROP_PDU_SIZE)
+    {
+        EmuGet(emu, EmuRead(emu, packet, 4u), delivered->data, delivered->length);
+    }
+    delivered->netKeyIndex = (uint8)EmuRead(emu, packet + 5u, 1u);
+    delivered->appKeyIndex = (uint8)EmuRead(emu, packet + 6u, 1u);
+    delivered->isAppKeyUsed = (uint8)EmuRead(emu, packet + 7u, 1u);
+    delivered->modelIndex = (uint8)EmuRead(emu, packet + 8u, 1u);
+    delivered->componentIndex = (uint8)EmuRead(emu, packet + 9u, 1u);
+    delivered->srcAddress = (uint16)EmuRead(emu, packet + 10u, 2u);
+    delivered->count++;
+    return CYMESH_ERROR_OK;
+}
+
+
+/* CyMesh_SecurityPVT of the replacement node, for its stock CyMesh_Security */
+static uint32 HookAesCcmEncryption(EMU_T * emu)
+{
+    uint8 payloadLength = (uint8)EmuArg(emu, 3u);
+    uint8 additionalLength = (uint8)EmuArg(emu, 5u);
+    uint8 micLength = (uint8)EmuArg(emu, 8u);
+
+    return CyMesh_SecurityAesCcmEncryption(EmuPtr(emu, EmuArg(emu, 0u), 16u), EmuPtr(emu, EmuArg(emu, 1u), 13u),
+                                           EmuPtrOrNull(emu, EmuArg(emu, 2u), payloadLength), payloadLength,
+                                           EmuPtrOrNull(emu, EmuArg(emu, 4u), additionalLength), additionalLength,
+                                           EmuPtrOrNull(emu, EmuArg(emu, 6u), payloadLength),
+                                           EmuPtr(emu, EmuArg(emu, 7u), micLength), micLength);
+}
+
+
+static uint32 HookAesCcmDecryption(EMU_T * emu)
+{
+    uint8 payloadLength = (uint8)EmuArg(emu, 3u);
+    uint8 additionalLength = (uint8)EmuArg(emu, 5u);
+    uint8 micLength = (uint8)EmuArg(emu, 8u);
+
+    return CyMesh_SecurityAesCcmDecryption(EmuPtr(emu, EmuArg(emu, 0u), 16u), EmuPtr(emu, EmuArg(emu, 1u), 13u),
+                                           EmuPtrOrNull(emu, EmuArg(emu, 2u), payloadLength), payloadLength,
+                                           EmuPtrOrNull(emu, EmuArg(emu, 4u), additionalLength), additionalLength,
+                                           EmuPtrOrNull(emu, EmuArg(emu, 6u), payloadLength),
+                                           EmuPtr(emu, EmuArg(emu, 7u), micLength), micLength);
+}
+
+
+static uint32 HookPVTAesEncrypt(EMU_T * emu)
+{
+    return CyMesh_SecurityPVTAesEncrypt(EmuPtr(emu, EmuArg(emu, 0u), 16u), EmuPtr(emu, EmuArg(emu, 1u), 16u),
+                                        EmuPtr(emu, EmuArg(emu, 2u), 16u));
+}
+
+
+static uint32 HookPVTSwapMsbLsb(EMU_T * emu)
+{
+    uint8 length = (uint8)EmuArg(emu, 1u);
+
+    CyMesh_SecurityPVTSwapMsbLsb(EmuPtr(emu, EmuArg(emu, 0u), length), length);
+    return 0u;
+}
+
+
+static const EMU_HOOK_ENTRY_T stockHooks[] =
+{
+    { "memcpy", HookMemcpy },
+    { "memset", HookMemset },
+    { "memcmp", HookMemcmp },
+    { "printf", HookNothing },
+    { "CyEnterCriticalSection", HookNothing },
+    { "CyExitCriticalSection", HookNothing },
+    { "CyBle_AesEncrypt", HookCyBleAesEncrypt },
+    { "CyMesh_BearerStart", HookNothing },
+    { "CyMesh_BearerSendData", HookBearerSendData },
+    { "CyMesh_BearerGetTxBufferStatus", HookTxBufferStatus },
+    { "CyMesh_ConfigurationSave", HookTrue },
+    { "CyMesh_SecurityUpdateCredentials", HookNothing },
+    { "CyMesh_TimerGetTimestamp", HookTimerGetTimestamp },
+    { NULL, NULL }
+};
+
+static const char * const stockMembers[] =
+{
+    "CyMesh_Network.o", "CyMesh_Transport.o", "CyMesh_MessageQueue.o", "CyMesh_Security.o", "CyMesh_SecurityPVT.o",
+    NULL
+};
+
+static const EMU_HOOK_ENTRY_T securityHooks[] =
+{
+    { "memcpy", HookMemcpy },
+    { "memset", HookMemset },
+    { "memcmp", HookMemcmp },
+    { "printf", HookNothing },
+    { "CyMesh_SecurityAesCcmEncryption", HookAesCcmEncryption },
+    { "CyMesh_SecurityAesCcmDecryption", HookAesCcmDecryption },
+    { "CyMesh_SecurityPVTAesEncrypt", HookPVTAesEncrypt },
+    { "CyMesh_SecurityPVTSwapMsbLsb", HookPVTSwapMsbLsb },
+    { NULL, NULL }
+};
+
+static const char * const securityMembers[] =
+{
+    "CyMesh_Security.o",
+    NULL
+};
+
+
+
+/*******************************************************************************
+* Host model of the rest of the library, for the replacement node. Its
+* CyMesh_Security calls run the stock object.
+*******************************************************************************/
+uint8 CyEnterCriticalSection(void)
+{
+    return 0u;
+}
+
+
+void CyExitCriticalSection(uint8 savedIntrStatus)
+{
+    (void)savedIntrStatus;
+}
+
+
+cystatus CyBLE_Nvram_Write(const uint8 buffer[], const uint8 varFlash[], uint16 length)
+{
+    memcpy((uint8 *)varFlash, buffer, length);
+    return CYRET_SUCCESS;
+}
+
+
+uint32 CyMesh_TimerGetTimestamp(void)
+{
+    return interopTime;
+}
+
+
+bool CyMesh_ConfigLogRestore(void)
+{
+    return false;
+}
+
+
+bool CyMesh_ConfigurationSave(void)
+{
+    return true;
+}
+
+
+CYMESH_API_RETURN_T CyMesh_SecurityUpdateCredentials(void)
+{
+    return CYMESH_ERROR_OK;
+}
+
+
+CYMESH_BEARER_TX_BUFFER_STATE_T CyMesh_BearerGetTxBufferStatus(void)
+{
+    return CYMESH_BEARER_TX_BUFFER_EMPTY;
+}
+
+
+CYMESH_API_RETURN_T CyMesh_BearerStart(CYMESH_CALLBACK_T meshEventCallback)
+{
+    bearerCallback = meshEventCallback;
+    return CYMESH_ERROR_OK;
+}
+
+
+CYMESH_API_RETURN_T CyMesh_BearerTxSend(const uint8 * data, uint8 length, CYMESH_BEARER_PACKET_TYPE_T packetType,
+                                        CYMESH_BEARER_TX_CLASS_T txClass, uint8 txCount, bool isScanFollowed)
+{
+    (void)packetType;
+    (void)txClass;
+    (void)txCount;
+    (void)isScanFollowed;
+
+    if(length <= INTEROP_PDU_SIZE)
+    {
+        memcpy(replacement.air.data, data, length);
+        replacement.air.length = length;
+    }
+    replacement.air.count++;
+    return CYMESH_ERROR_OK;
+}
+
+
+/* Calls the stock CyMesh_Security with the configuration of the node */
+static uint32 SecurityCall(const char * name, uint8 count, uint32 a0, uint32 a1, uint32 a2, uint32 a3, uint32 a4,
+                           uint32 a5, uint32 a6)
+{
+    uint32 args[7];
+    uint32 function = EmuFind(&securityEmu, name);
+
+    if(function == 0u)
+    {
+        printf("%s: no %s in the library\n", securityEmu.name, name);
+        exit(2);
+    }
+    args[0] = a0;
+    args[1] = a1;
+    args[2] = a2;
+    args[3] = a3;
+    args[4] = a4;
+    args[5] = a5;
+    args[6] = a6;
+    EmuSetConfig(&securityEmu, &cyMesh_ConfigInfoRam);
+    return EmuCall(&securityEmu, function, count, args);
+}
+
+
+uint32 CyMesh_SecurityGetIVindex(uint8 meshId)
+{
+    return SecurityCall("CyMesh_SecurityGetIVindex", 1u, meshId, 0u, 0u, 0u, 0u, 0u, 0u);
+}
+
+
+CYMESH_API_RETURN_T CyMesh_SecurityGetNetworkId(uint8 meshId, uint8 * netId)
+{
+    uint32 buffer = securityEmu.scratch[0];
+    CYMESH_API_RETURN_T result;
+
+    result = (CYMESH_API_RETURN_T)SecurityCall("CyMesh_SecurityGetNetworkId", 2u, meshId, buffer, 0u, 0u, 0u, 0u, 0u);
+    EmuGet(&securityEmu, buffer, netId, 16u);
+    return result;
+}
+
+
+uint8 CyMesh_SecurityFindMeshId(const uint8 * nID, uint8 numberOfBits, uint8 * meshId)
+{
+    uint32 id = securityEmu.scratch[0];
+    uint32 buffer = securityEmu.scratch[1];
+    uint8 count;
+
+    EmuPut(&securityEmu, id, nID, (numberOfBits + 7u) / 8u);
+    count = (uint8)SecurityCall("CyMesh_SecurityFindMeshId", 3u, id, numberOfBits, buffer, 0u, 0u, 0u, 0u);
+    EmuGet(&securityEmu, buffer, meshId, CYMESH_MAX_NETWORK_KEYS);
+    return count;
+}
+
+
+uint8 CyMesh_SecurityFindAppKeyIndex(uint8 aid, uint8 * appKeyIndexes)
+{
+    uint32 buffer = securityEmu.scratch[0];
+    uint8 count;
+
+    count = (uint8)SecurityCall("CyMesh_SecurityFindAppKeyIndex", 2u, aid, buffer, 0u, 0u, 0u, 0u, 0u);
+    EmuGet(&securityEmu, buffer, appKeyIndexes, CYMESH_MAX_APPLICATION_KEYS);
+    return count;
+}
+
+
+/* Security functions that work on size bytes of packet in place */
+static CYMESH_API_RETURN_T SecurityCallInPlace(const char * name, uint8 meshId, uint8 * packet, uint8 size,
+                                               uint8 length, uint8 count)
+{
+    uint32 buffer = securityEmu.scratch[0];
+    CYMESH_API_RETURN_T result;
+
+    EmuPut(&securityEmu, buffer, packet, size);
+    result = (CYMESH_API_RETURN_T)SecurityCall(name, count, meshId, buffer, length, 0u, 0u, 0u, 0u);
+    EmuGet(&securityEmu, buffer, packet, size);
+    return result;
+}
+
+
+/* Encrypts length bytes after the 6 header bytes and appends the MIC */
+CYMESH_API_RETURN_T CyMesh_SecurityEncryptNetworkData(uint8 meshId, uint8 * netPacket, uint8 length)
+{
+    return SecurityCallInPlace("CyMesh_SecurityEncryptNetworkData", meshId, netPacket, length + 10u, length, 3u);
+}
+
+
+/* length includes the MIC */
+CYMESH_API_RETURN_T CyMesh_SecurityDecryptNetworkData(uint8 meshId, uint8 * inputPacket, uint8 length)
+{
+    return SecurityCallInPlace("CyMesh_SecurityDecryptNetworkData", meshId, inputPacket, length + 6u, length, 3u);
+}
+
+
+/* Reads 7 bytes of ciphertext after the 6 bytes it changes */
+CYMESH_API_RETURN_T CyMesh_SecurityObfuscateNetHeader(uint8 meshId, uint8 * netPacket)
+{
+    return SecurityCallInPlace("CyMesh_SecurityObfuscateNetHeader", meshId, netPacket, 13u, 0u, 2u);
+}
+
+
+CYMESH_API_RETURN_T CyMesh_SecurityClarifyNetHeader(uint8 meshId, uint8 * netPacket)
+{
+    return SecurityCallInPlace("CyMesh_SecurityClarifyNetHeader", meshId, netPacket, 13u, 0u, 2u);
+}
+
+
+/* Application data: 8 header bytes, then length bytes and the MIC for the
+ * encryption, length bytes including the MIC for the decryption */
+static CYMESH_API_RETURN_T SecurityAppData(const char * name, uint8 netKeyIndex, uint8 appKeyIndex, bool isAppKeyUsed,
+                                           bool isOwnOrPeerDevKey, const uint8 * peerDevKey, uint8 * packet,
+                                           uint8 size, uint8 length)
+{
+    uint32 key = 0u;
+    uint32 buffer = securityEmu.scratch[0];
+    CYMESH_API_RETURN_T result;
+
+    if(peerDevKey != NULL)
+    {
+        key = securityEmu.scratch[1];
+        EmuPut(&securityEmu, key, peerDevKey, 16u);
+    }
+    EmuPut(&securityEmu, buffer, packet, size);
+    result = (CYMESH_API_RETURN_T)SecurityCall(name, 7u, netKeyIndex, appKeyIndex, isAppKeyUsed, isOwnOrPeerDevKey,
+                                               key, buffer, length);
+    EmuGet(&securityEmu, buffer, packet, size);
+    return result;
+}
+
+
+CYMESH_API_RETURN_T CyMesh_SecurityEncryptAppData(uint8 netKeyIndex, uint8 appKeyIndex, bool isAppKeyUsed,
+                                                  bool isOwnOrPeerDevKey, const uint8 * peerDevKey,
+                                                  uint8 * appPacket, uint8 length)
+{
+    return SecurityAppData("CyMesh_SecurityEncryptAppData", netKeyIndex, appKeyIndex, isAppKeyUsed,
+                           isOwnOrPeerDevKey, peerDevKey, appPacket, length + 12u, length);
+}
+
+
+CYMESH_API_RETURN_T CyMesh_SecurityDecryptAppData(uint8 netKeyIndex, uint8 appKeyIndex, bool isAppKeyUsed,
+                                                  bool isOwnOrPeerDevKey, const uint8 * peerDevKey,
+                                                  uint8 * inputPacket, uint8 length)
+{
+    return SecurityAppData("CyMesh_SecurityDecryptAppData", netKeyIndex, appKeyIndex, isAppKeyUsed,
+                           isOwnOrPeerDevKey, peerDevKey, inputPacket, length + 8u, length);
+}
+
+
+static CYMESH_API_RETURN_T ReplacementNetworkCallback(uint32 event, void * eventParam)
+{
+    const CYMESH_NETWORK_PKT_T * packet = (const CYMESH_NETWORK_PKT_T *)eventParam;
+    INTEROP_DELIVERY_T * delivered = &replacement.delivered;
+
+    delivered->event = event;
+    delivered->length = packet->length;
+    if(packet->length <= INTEROP_PDU_SIZE)
+    {
+        memcpy(delivered->data, packet->data, packet->length);
+    }
+    delivered->netKeyIndex = packet->mesh_id;
+    delivered->componentIndex = packet->componentIndex;
+    delivered->modelIndex = packet->modelIndex;
+    delivered->count++;
+    return CYMESH_ERROR_OK;
+}
+
+
+static CYMESH_API_RETURN_T ReplacementApplicationCallback(uint32 event, void * eventParam)
+{
+    const CYMESH_TRANSPORT_PKT_T * packet = (const CYMESH_TRANSPORT_PKT_T *)eventParam;
+    INTEROP_DELIVERY_T * delivered = &replacement.delivered;
+
+    delivered->event = event;
+    delivered->length = packet->length;
+    if(packet->length <= INTEROP_PDU_SIZE)
+    {
+        memcpy(delivered->data, packet->data, packet->length);
+    }
+    delivered->netKeyIndex = packet->netKeyIndex;
+    delivered->appKeyIndex = packet->appKeyIndex;
+    delivered->isAppKeyUsed = packet->isAppKeyUsed;
+    delivered->modelIndex = packet->modelIndex;
+    delivered->componentIndex = packet->componentIndex;
+    delivered->srcAddress = packet->srcAddress;
+    delivered->count++;
+    return CYMESH_ERROR_OK;
+}
+
+
+
+/*******************************************************************************
+* Checks
+*******************************************************************************/
+static void Check(const char * name, bool pass)
+{
+    printf("%-60s %s\n", name, pass ? "pass" : "FAIL");
+    if(pass == false)
+    {
+        failures++;
+    }
+}
+
+
+static void PrintPdu(const char * name, const uint8 * data, uint8 length)
+{
+    uint8 i;
+
+    printf("    %-12s", name);
+    for(i = 0u; i < length; i++)
+    {
+        printf("%02X", data[i]);
+    }
+    printf("\n");
+}
+
+
+static void Clear(void)
+{
+    memset(&stock, 0, sizeof(stock));
+    memset(&replacement, 0, sizeof(replacement));
+}
+
+
+static bool SameAir(void)
+{
+    bool isSame = (stock.air.count == replacement.air.count) && (stock.air.length == replacement.air.length) &&
+                  (memcmp(stock.air.data, replacement.air.data, stock.air.length) == 0);
+
+    if(isSame == false)
+    {
+        printf("  sent %u and %u PDUs:\n", stock.air.count, replacement.air.count);
+        PrintPdu("stock", stock.air.data, stock.air.length);
+        PrintPdu("replacement", replacement.air.data, replacement.air.length);
+    }
+    return isSame;
+}
+
+
+static bool SameDelivery(void)
+{
+    const INTEROP_DELIVERY_T * a = &stock.delivered;
+    const INTEROP_DELIVERY_T * b = &replacement.delivered;
+    bool isSame = (a->count == b->count) && (a->event == b->event) && (a->length == b->length) &&
+                  (memcmp(a->data, b->data, a->length) == 0) && (a->netKeyIndex == b->netKeyIndex) &&
+                  (a->appKeyIndex == b->appKeyIndex) && (a->isAppKeyUsed == b->isAppKeyUsed) &&
+                  (a->componentIndex == b->componentIndex) && (a->modelIndex == b->modelIndex) &&
+                  (a->srcAddress == b->srcAddress);
+
+    if(isSame == false)
+    {
+        printf("  delivered %u and %u times (component %u/%u, model %u/%u, key %u/%u, src %04X/%04X):\n",
+               a->count, b->count, a->componentIndex, b->componentIndex, a->modelIndex, b->modelIndex,
+               a->appKeyIndex, b->appKeyIndex, a->srcAddress, b->srcAddress);
+        PrintPdu("stock", a->data, a->length);
+        PrintPdu("replacement", b->data, b->length);
+    }
+    return isSame;
+}
+
+
+static void SetUp(void)
+{
+    static const uint8 encryptionKey[16] =
+        { 0x09, 0x53, 0xFA, 0x93, 0xE7, 0xCA, 0xAC, 0x96, 0x38, 0xF5, 0x88, 0x20, 0x22, 0x0A, 0x39, 0x8E };
+    static const uint8 privacyKey[16] =
+        { 0x8B, 0x84, 0xEE, 0xDE, 0xC1, 0x00, 0x06, 0x7D, 0x67, 0x09, 0x71, 0xDD, 0x2A, 0xA7, 0x00, 0xCF };
+    CYMESH_NETWORK_KEYS_T * netKey = &cyMesh_ConfigInfoRam.netInfo.netKeys[0];
+    uint32 address;
+    uint8 i;
+
+    memset(&cyMesh_ConfigInfoRam, 0, sizeof(cyMesh_ConfigInfoRam));
+    cyMesh_ConfigInfoRam.isConfigurationValid = true;
+    cyMesh_ConfigInfoRam.netInfo.numberOfNetworkKeys = 1u;
+    cyMesh_ConfigInfoRam.netInfo.isNetKeyValid = 1u;
+    memcpy(netKey->encryptionKey, encryptionKey, 16u);
+    memcpy(netKey->privacyKey, privacyKey, 16u);
+    netKey->networkId[15] = 0x68u;
+    netKey->ivIndex = INTEROP_IV_INDEX;
+    netKey->netKeyAppKeyMapping = 3u;
+
+    cyMesh_ConfigInfoRam.appInfo.numberOfApplicationKeys = CYMESH_MAX_APPLICATION_KEYS;
+    cyMesh_ConfigInfoRam.appInfo.isApplicationValid = 3u;
+    for(i = 0u; i < CYMESH_MAX_APPLICATION_KEYS; i++)
+    {
+        CYMESH_APPLICATION_KEYS_T * appKey = &cyMesh_ConfigInfoRam.appInfo.appKeys[i];
+        uint8 j;
+
+        for(j = 0u; j < 16u; j++)
+        {
+            appKey->applicationKey[j] = (uint8)((0x31u * (i + 1u)) ^ (j * 7u));
+        }
+        appKey->applicationId[15] = (uint8)(0x25u + i);     /* AID 0x25 and 0x26 */
+    }
+
+    for(i = 0u; i < 16u; i++)
+    {
+        cyMesh_ConfigInfoRam.deviceInfo.deviceKey[i] = (uint8)(0xA0u + i);
+        peerDeviceKey[i] = (uint8)(0x5Au ^ (i * 13u));
+    }
+    isPeerDeviceKeyValid = true;
+
+    cyMesh_ConfigInfoRam.deviceInfo.deviceDefaultTtl = INTEROP_TTL;
+    for(i = 0u; i < CYMESH_NUMBER_OF_COMPONENTS; i++)
+    {
+        cyMesh_ConfigInfoRam.deviceInfo.components[i].componentAddress = INTEROP_OWN_ADDRESS + i;
+        cyMesh_ConfigInfoRam.deviceInfo.components[i].numberOfSigAdoptedModels = CYMESH_MAX_MODELS_PER_COMPONENT;
+    }
+    cyMesh_ConfigInfoRam.deviceInfo.components[2].model[1].subscriptionAddress[0] = INTEROP_GROUP_ADDRESS;
+    cyMesh_ConfigInfoRam.deviceInfo.components[2].model[1].numberOfSubscribedAddresses = 1u;
+    cyMesh_ConfigInfoRam.bearerRole = CYMESH_ROLE_RELAY;
+    cyMesh_ConfigInfoRam.seq_num = INTEROP_SEQ_NUM;
+
+    EmuSetConfig(&stockEmu, &cyMesh_ConfigInfoRam);
+    address = EmuFind(&stockEmu, "peerDeviceKey");
+    if(address != 0u)
+    {
+        EmuPut(&stockEmu, address, peerDeviceKey, 16u);
+    }
+    address = EmuFind(&stockEmu, "isPeerDeviceKeyValid");
+    if(address != 0u)
+    {
+        EmuWrite(&stockEmu, address, isPeerDeviceKeyValid, 1u);
+    }
+
+    (void)EmuCallName(&stockEmu, "CyMesh_NetworkStart", 1u,
+                      EmuStub(&stockEmu, HookNetworkCallback, "network callback"));
+    (void)CyMesh_NetworkStart(ReplacementNetworkCallback);
+}
+
+
+/* The stock and the replacement AES-CCM over the payload and AAD lengths of
+ * the stack and beyond, both ways */
+static void CheckAesCcm(void)
+{
+    uint32 key = stockEmu.scratch[0];
+    uint32 nonce = stockEmu.scratch[1];
+    uint32 data = stockEmu.scratch[2];
+    uint32 output = stockEmu.scratch[3];
+    uint32 additional = EmuAlloc(&stockEmu, 32u, 8u);
+    uint32 mic = EmuAlloc(&stockEmu, 16u, 8u);
+    bool isSame = true;
+    bool isAccepted = true;
+    uint8 block[16];
+    uint8 i;
+
+    for(i = 0u; i < 16u; i++)
+    {
+        uint8 input[16];
+        uint8 stockBlock[16];
+
+        memset(input, i, 16u);
+        input[i] = 0xC3u;
+        memcpy(block, cyMesh_ConfigInfoRam.netInfo.netKeys[0].privacyKey, 16u);
+        block[15u - i] ^= 0x5Au;
+        EmuPut(&stockEmu, key, block, 16u);
+        EmuPut(&stockEmu, data, input, 16u);
+        (void)EmuCallName(&stockEmu, "CyMesh_SecurityPVTAesEncrypt", 3u, data, key, output);
+        EmuGet(&stockEmu, output, stockBlock, 16u);
+        (void)CyMesh_SecurityPVTAesEncrypt(input, block, input);
+        isSame = isSame && (memcmp(input, stockBlock, 16u) == 0);
+    }
+    Check("AES-128 block of the stock and replacement PVT", isSame);
+
+    for(i = 0u; i < 13u; i++)
+    {
+        block[i] = (uint8)(0x10u + (3u * i));
+    }
+    EmuPut(&stockEmu, nonce, block, 13u);
+    EmuPut(&stockEmu, key, cyMesh_ConfigInfoRam.netInfo.netKeys[0].encryptionKey, 16u);
+
+    for(i = 0u; i < 48u; i++)
+    {
+        uint8 length = (uint8)(1u + (i % 24u));
+        uint8 additionalLength = (i < 24u) ? 0u : (uint8)(i % 19u);
+        uint8 micLength = ((i & 1u) == 0u) ? 4u : 8u;
+        uint8 payload[32];
+        uint8 aad[32];
+        uint8 stockOutput[32];
+        uint8 stockMic[16];
+        uint8 replacementOutput[32];
+        uint8 replacementMic[16];
+        uint8 j;
+
+        for(j = 0u; j < 32u; j++)
+        {
+            payload[j] = (uint8)((i * 17u) + j);
+            aad[j] = (uint8)(0xF0u - j);
+        }
+        EmuPut(&stockEmu, data, payload, length);
+        EmuPut(&stockEmu, additional, aad, 32u);
+        (void)EmuCallName(&stockEmu, "CyMesh_SecurityAesCcmEncryption", 9u, key, nonce, data, length,
+                          (additionalLength != 0u) ? additional : 0u, additionalLength, output, mic, micLength);
+        EmuGet(&stockEmu, output, stockOutput, length);
+        EmuGet(&stockEmu, mic, stockMic, micLength);
+
+        (void)CyMesh_SecurityAesCcmEncryption(cyMesh_ConfigInfoRam.netInfo.netKeys[0].encryptionKey, block, payload,
+                                              length, (additionalLength != 0u) ? aad : NULL, additionalLength,
+                                              replacementOutput, replacementMic, micLength);
+        if((memcmp(stockOutput, replacementOutput, length) != 0) || (memcmp(stockMic, replacementMic, micLength) != 0))
+        {
+            if(isSame == true)
+            {
+                printf("  payload %u, AAD %u, MIC %u:\n", length, additionalLength, micLength);
+                PrintPdu("stock", stockOutput, length);
+                PrintPdu("replacement", replacementOutput, length);
+            }
+            isSame = false;
+        }
+
+        /* Each decrypts what the other encrypted */
+        EmuPut(&stockEmu, data, replacementOutput, length);
+        EmuPut(&stockEmu, mic, replacementMic, micLength);
+        isAccepted = isAccepted &&
+                     (EmuCallName(&stockEmu, "CyMesh_SecurityAesCcmDecryption", 9u, key, nonce, data, length,
+                                  (additionalLength != 0u) ? additional : 0u, additionalLength, output, mic,
+                                  micLength) == CYMESH_ERROR_OK) &&
+                     (memcmp(EmuPtr(&stockEmu, output, length), payload, length) == 0);
+        isAccepted = isAccepted &&
+                     (CyMesh_SecurityAesCcmDecryption(cyMesh_ConfigInfoRam.netInfo.netKeys[0].encryptionKey, block,
+                                                      stockOutput, length, (additionalLength != 0u) ? aad : NULL,
+                                                      additionalLength, replacementOutput, stockMic,
+                                                      micLength) == CYMESH_ERROR_OK) &&
+                     (memcmp(replacementOutput, payload, length) == 0);
+    }
+    Check("AES-CCM of the stock and replacement PVT", isSame);
+    Check("AES-CCM of each decrypted by the other", isAccepted);
+}
+
+
+/* Network PDU of the transport layer: header placeholders, SEQ, SRC, DST
+ * and a payload */
+static void NetworkMessage(uint8 * message, uint8 length, uint32 seq, uint16 src, uint16 dst)
+{
+    uint8 i;
+
+    memset(message, 0, INTEROP_PDU_SIZE);
+    message[2] = (uint8)(seq >> 16);
+    message[3] = (uint8)(seq >> 8);
+    message[4] = (uint8)seq;
+    message[5] = (uint8)(src >> 8);
+    message[6] = (uint8)src;
+    message[7] = (uint8)(dst >> 8);
+    message[8] = (uint8)dst;
+    for(i = 9u; i < length; i++)
+    {
+        message[i] = (uint8)(seq + i);
+    }
+}
+
+
+/* CyMesh_NetworkSendData() of both nodes; true if both sent the same PDU or
+ * both refused */
+static bool NetworkSend(uint8 length, uint32 seq, uint16 src, uint16 dst, uint8 ttl, bool akf, bool fut)
+{
+    uint32 buffer = stockEmu.scratch[0];
+    uint8 message[INTEROP_PDU_SIZE];
+
+    Clear();
+    NetworkMessage(message, length, seq, src, dst);
+    EmuPut(&stockEmu, buffer, message, INTEROP_PDU_SIZE);
+    (void)EmuCallName(&stockEmu, "CyMesh_NetworkSendData", 8u, buffer, length, 1u, akf, fut, ttl, 0u, 1u);
+    (void)CyMesh_NetworkSendData(message, length, 1u, akf, fut, ttl, 0u, 1u);
+    return SameAir();
+}
+
+
+/* A PDU from another node to both nodes. The replacement relays after its
+ * back-off, so both have sent their relay when this returns. */
+static void NetworkReceive(const uint8 * pdu, uint8 length)
+{
+    uint32 buffer = stockEmu.scratch[0];
+    uint8 packet[INTEROP_PDU_SIZE];
+    uint32 ms;
+
+    Clear();
+    EmuPut(&stockEmu, buffer, pdu, length);
+    (void)EmuCallName(&stockEmu, "CyMesh_ProcessNetworkPacket", 2u, buffer, length);
+
+    memcpy(packet, pdu, length);
+    (void)CyMesh_ProcessNetworkPacket(packet, length);
+    for(ms = 0u; ms <= CYMESH_NET_FLOOD_MAX_DELAY_MS; ms++)
+    {
+        interopTime++;
+        CyMesh_NetworkFloodUpdate();
+    }
+}
+
+
+/* PDU the stock node sends, for the receive checks */
+static uint8 StockPdu(uint8 * pdu, uint8 length, uint32 seq, uint16 src, uint16 dst, uint8 ttl)
+{
+    (void)NetworkSend(length, seq, src, dst, ttl, false, false);
+    memcpy(pdu, stock.air.data, stock.air.length);
+    return stock.air.length;
+}
+
+
+static void CheckNetwork(void)
+{
+    static const struct
+    {
+        const char * name;
+        uint16 dst;
+        uint8 ttl;
+    } receive[] =
+    {
+        { "network PDU to a component delivered alike",              INTEROP_OWN_ADDRESS + 1u,    INTEROP_TTL },
+        { "network PDU to another node relayed alike",               INTEROP_RELAY_ADDRESS,       INTEROP_TTL },
+        { "network PDU with TTL 2 relayed alike",                    INTEROP_RELAY_ADDRESS,       2u },
+        { "network PDU with TTL 1 not relayed by either",            INTEROP_RELAY_ADDRESS,       1u },
+        { "network PDU to a subscribed group delivered alike",       INTEROP_GROUP_ADDRESS,       INTEROP_TTL },
+        { "network PDU to another group relayed alike",              INTEROP_OTHER_GROUP_ADDRESS, INTEROP_TTL },
+        { "network PDU to a virtual address relayed alike",          INTEROP_VIRTUAL_ADDRESS,     INTEROP_TTL },
+        { "network PDU to all nodes delivered and relayed alike",    INTEROP_BROADCAST_ADDRESS,   INTEROP_TTL },
+    };
+    uint8 pdu[INTEROP_PDU_SIZE];
+    uint8 length;
+    uint32 seq = 0x000100u;
+    bool isSame = true;
+    uint8 i;
+
+    /* Sent before anything is received, so the replacement has no distance
+     * to take the TTL from */
+    for(i = CYMESH_TRANS_MIN_DATA_LEN; i <= CYMESH_NET_MAX_DATA_LEN; i++)
+    {
+        isSame = NetworkSend(i, seq++, INTEROP_OWN_ADDRESS, INTEROP_PEER_ADDRESS, INTEROP_TTL, false, false) &&
+                 isSame;
+        isSame = NetworkSend(i, seq++, INTEROP_OWN_ADDRESS + 3u, INTEROP_GROUP_ADDRESS, i & 0x7Fu, true, true) &&
+                 isSame;
+    }
+    Check("network PDUs of CyMesh_NetworkSendData() identical", isSame && (stock.air.count == 1u));
+    Check("network PDU that is too short refused by both",
+          NetworkSend(CYMESH_TRANS_MIN_DATA_LEN - 1u, seq++, INTEROP_OWN_ADDRESS, INTEROP_PEER_ADDRESS, INTEROP_TTL,
+                      false, false) && (stock.air.count == 0u));
+    Check("network PDU that is too long refused by both",
+          NetworkSend(CYMESH_NET_MAX_DATA_LEN + 1u, seq++, INTEROP_OWN_ADDRESS, INTEROP_PEER_ADDRESS, INTEROP_TTL,
+                      false, false) && (stock.air.count == 0u));
+
+    for(i = 0u; i < (sizeof(receive) / sizeof(receive[0])); i++)
+    {
+        length = StockPdu(pdu, 25u, seq++, INTEROP_SOURCE_ADDRESS, receive[i].dst, receive[i].ttl);
+        NetworkReceive(pdu, length);
+        Check(receive[i].name, SameDelivery() && SameAir() && ((stock.delivered.count + stock.air.count) != 0u) ==
+              (receive[i].ttl != 1u));
+    }
+
+    length = StockPdu(pdu, 20u, seq++, INTEROP_SOURCE_ADDRESS, INTEROP_OWN_ADDRESS, INTEROP_TTL);
+    NetworkReceive(pdu, length);
+    isSame = SameDelivery() && SameAir() && (stock.delivered.count == 1u);
+    NetworkReceive(pdu, length);
+    Check("duplicate network PDU dropped by both", isSame && SameDelivery() && SameAir() &&
+          (stock.delivered.count == 0u));
+
+    length = StockPdu(pdu, 20u, seq++, INTEROP_OWN_ADDRESS + 2u, INTEROP_RELAY_ADDRESS, INTEROP_TTL);
+    NetworkReceive(pdu, length);
+    Check("own network PDU dropped by both", SameDelivery() && SameAir() && (stock.air.count == 0u));
+
+    length = StockPdu(pdu, 20u, seq++, INTEROP_SOURCE_ADDRESS, INTEROP_OWN_ADDRESS, INTEROP_TTL);
+    pdu[length - 1u] ^= 0x01u;
+    NetworkReceive(pdu, length);
+    Check("network PDU with a wrong MIC dropped by both", SameDelivery() && SameAir() &&
+          (stock.delivered.count == 0u));
+
+    length = StockPdu(pdu, 25u, seq++, INTEROP_SOURCE_ADDRESS, INTEROP_OWN_ADDRESS, INTEROP_TTL);
+    pdu[0] ^= 0x01u;
+    NetworkReceive(pdu, length);
+    Check("network PDU of another network dropped by both", SameDelivery() && SameAir() &&
+          (stock.delivered.count == 0u));
+
+    /* The same PDU from the replacement node */
+    length = StockPdu(pdu, 25u, seq, INTEROP_SOURCE_ADDRESS, INTEROP_OWN_ADDRESS + 3u, INTEROP_TTL);
+    memcpy(pdu, replacement.air.data, replacement.air.length);
+    NetworkReceive(pdu, replacement.air.length);
+    Check("network PDU of the replacement delivered by the stock node", SameDelivery() &&
+          (stock.delivered.count == 1u));
+}
+
+
+/* CyMesh_TransportSendData() of both nodes */
+static bool TransportSend(uint8 length, uint16 dst, bool akf, bool isOwnOrPeerDevKey, uint8 appKeyIndex)
+{
+    uint32 buffer = stockEmu.scratch[0];
+    uint8 data[INTEROP_PDU_SIZE];
+    uint8 i;
+
+    Clear();
+    for(i = 0u; i < INTEROP_PDU_SIZE; i++)
+    {
+        data[i] = (uint8)(0x80u + (length * 3u) + i);
+    }
+    EmuPut(&stockEmu, buffer, data, INTEROP_PDU_SIZE);
+    (void)EmuCallName(&stockEmu, "CyMesh_TransportSendData", 11u, buffer, length, 1u, akf, isOwnOrPeerDevKey, false,
+                      INTEROP_TTL, INTEROP_OWN_ADDRESS, dst, 0u, appKeyIndex);
+    (void)CyMesh_TransportSendData(data, length, 1u, akf, isOwnOrPeerDevKey, false, INTEROP_TTL, INTEROP_OWN_ADDRESS,
+                                   dst, 0u, appKeyIndex);
+    return SameAir();
+}
+
+
+/* Transport PDU from another node, sent by the stock node, to both nodes;
+ * true if both handled it the same */
+static bool TransportReceive(uint16 dst, bool akf, bool isOwnOrPeerDevKey, uint8 appKeyIndex)
+{
+    uint32 buffer = stockEmu.scratch[0];
+    uint8 data[CYMESH_APP_MAX_DATA_LEN];
+    uint8 pdu[INTEROP_PDU_SIZE];
+    uint8 length;
+    uint8 i;
+
+    Clear();
+    for(i = 0u; i < CYMESH_APP_MAX_DATA_LEN; i++)
+    {
+        data[i] = (uint8)(0x40u + i);
+    }
+    EmuPut(&stockEmu, buffer, data, sizeof(data));
+    (void)EmuCallName(&stockEmu, "CyMesh_TransportSendData", 11u, buffer, 7u, 1u, akf, isOwnOrPeerDevKey, false,
+                      INTEROP_TTL, INTEROP_SOURCE_ADDRESS, dst, 0u, appKeyIndex);
+    /* Keeps the SEQ of both nodes together */
+    (void)CyMesh_TransportSendData(data, 7u, 1u, akf, isOwnOrPeerDevKey, false, INTEROP_TTL, INTEROP_SOURCE_ADDRESS,
+                                   dst, 0u, appKeyIndex);
+    if((SameAir() == false) || (stock.air.count != 1u))
+    {
+        return false;
+    }
+
+    length = stock.air.length;
+    memcpy(pdu, stock.air.data, length);
+    NetworkReceive(pdu, length);
+    return SameDelivery() && SameAir();
+}
+
+
+static void CheckTransport(void)
+{
+    bool isSame = true;
+    uint8 length;
+
+    (void)EmuCallName(&stockEmu, "CyMesh_TransportStart", 1u,
+                      EmuStub(&stockEmu, HookApplicationCallback, "application callback"));
+    (void)CyMesh_TransportStart(ReplacementApplicationCallback);
+    Check("SEQ taken from seq_num alike",
+          EmuCallName(&stockEmu, "CyMesh_ReadSequenceNumber", 0u) == CyMesh_ReadSequenceNumber());
+
+    /* Not to INTEROP_SOURCE_ADDRESS, whose distance the replacement learnt */
+    for(length = CYMESH_APP_MIN_DATA_LEN; length <= CYMESH_APP_MAX_DATA_LEN; length++)
+    {
+        isSame = TransportSend(length, INTEROP_PEER_ADDRESS, true, false, 0u) && isSame;
+        isSame = TransportSend(length, INTEROP_GROUP_ADDRESS, true, false, 1u) && isSame;
+    }
+    Check("transport PDUs with the application keys identical", isSame);
+
+    isSame = true;
+    for(length = CYMESH_APP_MIN_DATA_LEN; length <= CYMESH_APP_MAX_DATA_LEN; length++)
+    {
+        isSame = TransportSend(length, INTEROP_PEER_ADDRESS, false, false, 0u) && isSame;
+        isSame = TransportSend(length, INTEROP_PEER_ADDRESS, false, true, 0u) && isSame;
+    }
+    Check("transport PDUs with the device keys identical", isSame);
+
+    Check("transport PDU that is too short refused by both",
+          TransportSend(CYMESH_APP_MIN_DATA_LEN - 1u, INTEROP_PEER_ADDRESS, true, false, 0u) &&
+          (stock.air.count == 0u));
+    Check("transport PDU that is too long refused by both",
+          TransportSend(CYMESH_APP_MAX_DATA_LEN + 1u, INTEROP_PEER_ADDRESS, true, false, 0u) &&
+          (stock.air.count == 0u));
+    Check("SEQ moved on alike",
+          EmuCallName(&stockEmu, "CyMesh_ReadSequenceNumber", 0u) == CyMesh_ReadSequenceNumber());
+    Check("seq_num saved ahead alike",
+          EmuRead(&stockEmu, stockEmu.config + ARM_CONFIG_SEQ_NUM, 4u) == cyMesh_ConfigInfoRam.seq_num);
+
+    Check("transport PDU with application key 0 delivered alike",
+          TransportReceive(INTEROP_OWN_ADDRESS, true, false, 0u) && (stock.delivered.count == 1u));
+    Check("transport PDU with application key 1 delivered alike",
+          TransportReceive(INTEROP_OWN_ADDRESS + 1u, true, false, 1u) && (stock.delivered.count == 1u));
+    Check("transport PDU to a group delivered alike",
+          TransportReceive(INTEROP_GROUP_ADDRESS, true, false, 0u) && (stock.delivered.count == 1u));
+
+    /* The stock layer decrypts these with the application key as well, so
+     * neither node delivers them */
+    Check("transport PDU with the peer device key dropped by both",
+          TransportReceive(INTEROP_OWN_ADDRESS, false, true, 0u) && (stock.delivered.count == 0u));
+    Check("transport PDU with the device key dropped by both",
+          TransportReceive(INTEROP_OWN_ADDRESS, false, false, 0u) && (stock.delivered.count == 0u));
+}
+
+
+/* CyMesh_TxMessageQueueInsert() and CyMesh_SchedulePendingTxMessagePackets()
+ * of both nodes, for a new message in queue entry 0 */
+static bool MessageQueueSend(uint32 opcode, uint8 payloadLength, bool isReliable)
+{
+    uint32 node = stockEmu.scratch[0];
+    CYMESH_TX_MESSAGE_NODE_T packet;
+    uint8 i;
+
+    memset(&packet, 0, sizeof(packet));
+    packet.opcode = opcode;
+    for(i = 0u; i < payloadLength; i++)
+    {
+        packet.payload[i] = (uint8)(0x70u + i);
+    }
+    packet.payloadLength = payloadLength;
+    packet.isReliable = isReliable;
+    packet.netKeyIndex = 0u;
+    packet.appKeyIndex = 1u;
+    packet.isAppKeyUsed = true;
+    packet.srcAddress = INTEROP_OWN_ADDRESS + 1u;
+    packet.dstAddress = INTEROP_PEER_ADDRESS;
+    packet.ttl = INTEROP_TTL;
+    packet.retryCount = 2u;
+
+    memset(EmuPtr(&stockEmu, node, ARM_TX_NODE_SIZE), 0, ARM_TX_NODE_SIZE);
+    EmuWrite(&stockEmu, node, packet.opcode, 4u);
+    EmuPut(&stockEmu, node + 4u, packet.payload, sizeof(packet.payload));
+    EmuWrite(&stockEmu, node + 14u, packet.payloadLength, 1u);
+    EmuWrite(&stockEmu, node + 15u, packet.isReliable, 1u);
+    EmuWrite(&stockEmu, node + 16u, packet.isEndBitSet, 1u);
+    EmuWrite(&stockEmu, node + 17u, packet.netKeyIndex, 1u);
+    EmuWrite(&stockEmu, node + 18u, packet.appKeyIndex, 1u);
+    EmuWrite(&stockEmu, node + 19u, packet.isAppKeyUsed, 1u);
+    EmuWrite(&stockEmu, node + 20u, packet.isOwnOrPeerDevKey, 1u);
+    EmuWrite(&stockEmu, node + 22u, packet.srcAddress, 2u);
+    EmuWrite(&stockEmu, node + 24u, packet.dstAddress, 2u);
+    EmuWrite(&stockEmu, node + 26u, packet.fut, 1u);
+    EmuWrite(&stockEmu, node + 27u, packet.ttl, 1u);
+    EmuWrite(&stockEmu, node + 28u, packet.retryCount, 1u);
+
+    Clear();
+    (void)EmuCallName(&stockEmu, "CyMesh_TxMessageQueueInsert", 3u, 0u, node, true);
+    (void)EmuCallName(&stockEmu, "CyMesh_SchedulePendingTxMessagePackets", 0u);
+    (void)CyMesh_TxMessageQueueInsert(0u, &packet, true);
+    (void)CyMesh_SchedulePendingTxMessagePackets();
+
+    /* A reliable message waits for its status */
+    (void)EmuCallName(&stockEmu, "CyMesh_TxMessageQueueFreeUp", 1u, 0u);
+    CyMesh_TxMessageQueueFreeUp(0u);
+    return SameAir() && (stock.air.count == 1u);
+}
+
+
+static void CheckMessageQueue(void)
+{
+    (void)EmuCallName(&stockEmu, "CyMesh_ResetTxMessageQueueCount", 0u);
+    (void)EmuCallName(&stockEmu, "CyMesh_ResetTransactionID", 0u);
+    CyMesh_ResetTxMessageQueueCount();
+    CyMesh_ResetTransactionID();
+
+    Check("access PDU with a 1 byte opcode identical", MessageQueueSend(0x04u, 3u, false));
+    Check("access PDU with a 2 byte opcode identical", MessageQueueSend(0x8202u, 2u, false));
+    Check("access PDU with a 3 byte opcode identical", MessageQueueSend(0xC10131u, 5u, false));
+    Check("reliable access PDU identical", MessageQueueSend(0x8203u, 1u, true));
+    Check("access PDU with the longest payload identical", MessageQueueSend(0x05u, CYMESH_APP_MAX_DATA_LEN - 2u, false));
+}
+
+
+int main(int argc, char * argv[])
+{
+    uint32 archiveSize;
+    uint8 * archive = LoadFile((argc > 1) ? argv[1] : INTEROP_LIBRARY, &archiveSize);
+
+    if((sizeof(cyMesh_ConfigInfoRam.appInfo) != ARM_CONFIG_APP_INFO_SIZE) ||
+       (sizeof(cyMesh_ConfigInfoRam.netInfo) != ARM_CONFIG_NET_INFO_SIZE))
+    {
+        printf("The key tables of the host differ from the library layout\n");
+        return 2;
+    }
+
+    AesInit();
+    Check("AES-128 model matches FIPS-197", AesSelfTest());
+
+    EmuInit(&stockEmu, "stock node");
+    EmuLoad(&stockEmu, archive, archiveSize, stockMembers, stockHooks);
+    EmuInit(&securityEmu, "CyMesh_Security");
+    EmuLoad(&securityEmu, archive, archiveSize, securityMembers, securityHooks);
+
+    SetUp();
+    CheckAesCcm();
+    CheckNetwork();
+    CheckTransport();
+    CheckMessageQueue();
+
+    if(failures != 0u)
+    {
+        printf("%u checks failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,807 @@
+/*******************************************************************************
+* Host test and benchmark of Firmware_Mesh/SM Files/CyMesh_Network.c.
+*
+* The network layer runs against a host model of the parts of SM_LIB_256K.a it
+* calls: the network PDU encryption and header obfuscation of CyMesh_Security
+* (same nonce and privacy block layout, on CyMesh_SecurityPVT.c) and a bearer
+* that keeps the last packet sent. The model counts the AES blocks. Flash
+* writes are plain copies.
+*
+* Checks that a relayed packet decrypts at the next hop with its TTL
+* decremented, that duplicates and own packets are dropped, that a forged
+* copy does not keep the real packet from being relayed, that replays are
+* dropped, also after a reset, that a source that wrapped its SEQ is accepted
+* again but a PDU far behind is not taken for a wrap, that a PDU a relay sent out of order is delivered and that a replay
+* for another node is still relayed, that a relay waits for its back-off and
+* is cancelled by the copies heard meanwhile, and that messages to a source
+* take the TTL of its distance. Then measures the receive, duplicate and relay
+* paths. From the repository root:
+*
+*   gcc -O2 -I Tools/network_bench -I "Firmware_Mesh/SM Files" -o network_bench \
+*       Tools/network_bench/network_bench.c "Firmware_Mesh/SM Files/CyMesh_Network.c" \
+*       "Firmware_Mesh/SM Files/CyMesh_NetworkCache.c" "Firmware_Mesh/SM Files/CyMesh_NetworkReplay.c" \
+*       "Firmware_Mesh/SM Files/CyMesh_NetworkFlood.c" "Firmware_Mesh/SM Files/CyMesh_NetworkHops.c" \
+*       "Firmware_Mesh/SM Files/CyMesh_SecurityPVT.c"
+*
+* The CyMesh_SecurityPVT.c options of Tools/aes_ccm_bench apply. Cycles are
+* only reported on x86 (TSC).
+*
+* Exits with 1 if a check fails.
+*******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <project.h>
+#include "CyMesh_Network.h"
+#include "CyMesh_Bearer.h"
+#include "CyMesh_BearerTx.h"
+#include "CyMesh_Security.h"
+#include "CyMesh_SecurityPVT.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define BENCH_CYCLES()      (__rdtsc())
+#else
+    #define BENCH_CYCLES()      (0ull)
+#endif
+
+#define BENCH_PACKETS           (20000u)
+#define BENCH_REPEAT            (5u)    /* The fastest of these runs is reported */
+#define BENCH_PDU_LENGTH        (25u)   /* Without the MIC; the longest PDU CyMesh_ProcessNetworkPacket() accepts */
+#define BENCH_MIC_LENGTH        (4u)
+#define BENCH_TTL               (5u)
+#define BENCH_IV_INDEX          (0x12345678u)
+
+#define BENCH_OWN_ADDRESS       (0x0010u)
+#define BENCH_SOURCE_ADDRESS    (0x0002u)
+#define BENCH_OTHER_ADDRESS     (0x0003u)
+
+#define AES_BLOCKS(length)      (((length) + 15u) / 16u)
+
+typedef enum
+{
+    BENCH_RECEIVE,              /* Unicast to this node */
+    BENCH_DUPLICATE,            /* Second copy of a relayed packet */
+    BENCH_RELAY,                /* Unicast to another node */
+
+    BENCH_PATH_COUNT
+} BENCH_PATH_T;
+
+/* Library symbols CyMesh_Network.c uses */
+CYMESH_DEVICE_CONFIG_T cyMesh_ConfigInfoRam;
+
+extern CYMESH_NET_MSG_CACHE_STRUCT net_msg_cache;
+extern CYMESH_NET_REPLAY_STRUCT net_replay_list;
+
+static CYMESH_CALLBACK_T bearerCallback;
+static uint8 bearerPacket[CYMESH_BEARER_ADV_MAX_LENGTH + 8u];
+static uint8 bearerLength;
+static uint32 bearerCount;
+static uint32 transportCount;
+static uint8 transportTtl;
+static uint32 aesBlocks;
+static uint32 flashWrites;
+static uint32 benchTime;
+
+uint8 cySimSflashDie[2] = { 0x17u, 0x2Cu };
+
+
+/*******************************************************************************
+* Host model of the library
+*******************************************************************************/
+uint8 CyEnterCriticalSection(void)
+{
+    return 0u;
+}
+
+
+void CyExitCriticalSection(uint8 savedIntrStatus)
+{
+    (void)savedIntrStatus;
+}
+
+
+cystatus CyBLE_Nvram_Write(const uint8 buffer[], const uint8 varFlash[], uint16 length)
+{
+    memcpy((uint8 *)varFlash, buffer, length);
+    flashWrites++;
+    return CYRET_SUCCESS;
+}
+
+
+uint32 CyMesh_TimerGetTimestamp(void)
+{
+    return benchTime;
+}
+
+
+/* Tools/network_bench/config_log_bench.c covers the configuration log */
+bool CyMesh_ConfigLogRestore(void)
+{
+    return false;
+}
+
+
+CYMESH_API_RETURN_T CyMesh_BearerStart(CYMESH_CALLBACK_T meshEventCallback)
+{
+    bearerCallback = meshEventCallback;
+    return CYMESH_ERROR_OK;
+}
+
+
+CYMESH_API_RETURN_T CyMesh_BearerSendData(const uint8 * data, uint8 length, CYMESH_BEARER_PACKET_TYPE_T packetType,
+                                          uint8 txCount, bool priority, bool isScanFollowed)
+{
+    (void)packetType;
+    (void)txCount;
+    (void)priority;
+    (void)isScanFollowed;
+
+    memcpy(bearerPacket, data, length);
+    bearerLength = length;
+    bearerCount++;
+    return CYMESH_ERROR_OK;
+}
+
+
+CYMESH_API_RETURN_T CyMesh_BearerTxSend(const uint8 * data, uint8 length, CYMESH_BEARER_PACKET_TYPE_T packetType,
+                                        CYMESH_BEARER_TX_CLASS_T txClass, uint8 txCount, bool isScanFollowed)
+{
+    (void)txClass;
+    return CyMesh_BearerSendData(data, length, packetType, txCount, false, isScanFollowed);
+}
+
+
+static bool IsValidMeshId(uint8 meshId)
+{
+    return (meshId < cyMesh_ConfigInfoRam.netInfo.numberOfNetworkKeys) &&
+           (((cyMesh_ConfigInfoRam.netInfo.isNetKeyValid >> meshId) & 1u) != 0u);
+}
+
+
+uint32 CyMesh_SecurityGetIVindex(uint8 meshId)
+{
+    return cyMesh_ConfigInfoRam.netInfo.netKeys[meshId].ivIndex;
+}
+
+
+CYMESH_API_RETURN_T CyMesh_SecurityGetNetworkId(uint8 meshId, uint8 * netId)
+{
+    if(IsValidMeshId(meshId) == false)
+    {
+        return CYMESH_ERROR_INVALID_MESH_ID;
+    }
+    memcpy(netId, cyMesh_ConfigInfoRam.netInfo.netKeys[meshId].networkId, 16u);
+    return CYMESH_ERROR_OK;
+}
+
+
+uint8 CyMesh_SecurityFindMeshId(const uint8 * nID, uint8 numberOfBits, uint8 * meshId)
+{
+    uint8 mask = (uint8)((1u << numberOfBits) - 1u);
+    uint8 count = 0u;
+    uint8 i;
+
+    for(i = 0; i < CYMESH_MAX_NETWORK_KEYS; i++)
+    {
+        if((IsValidMeshId(i) == true) &&
+           (((nID[0] ^ cyMesh_ConfigInfoRam.netInfo.netKeys[i].networkId[15]) & mask) == 0u))
+        {
+            meshId[count++] = i;
+        }
+    }
+    return count;
+}
+
+
+/* Nonce of CyMesh_SecurityEncryptNetworkData(): 3 zero bytes, FUT and TTL,
+ * the SEQ and SRC of netPacket and the IV index */
+static void NetworkNonce(uint8 meshId, const uint8 * netPacket, uint8 * nonce)
+{
+    uint32 ivIndex = cyMesh_ConfigInfoRam.netInfo.netKeys[meshId].ivIndex;
+
+    memset(nonce, 0, 3u);
+    nonce[3] = netPacket[0] & 0x7Fu;
+    nonce[4] = netPacket[1] & 0x1Fu;
+    memcpy(&nonce[5], &netPacket[2], 4u);
+    nonce[9] = (uint8)(ivIndex >> 24);
+    nonce[10] = (uint8)(ivIndex >> 16);
+    nonce[11] = (uint8)(ivIndex >> 8);
+    nonce[12] = (uint8)ivIndex;
+}
+
+
+CYMESH_API_RETURN_T CyMesh_SecurityEncryptNetworkData(uint8 meshId, uint8 * netPacket, uint8 length)
+{
+    uint8 nonce[13];
+
+    if(IsValidMeshId(meshId) == false)
+    {
+        return CYMESH_ERROR_INVALID_MESH_ID;
+    }
+
+    NetworkNonce(meshId, netPacket, nonce);
+    aesBlocks += 2u + (2u * AES_BLOCKS(length));
+    return CyMesh_SecurityAesCcmEncryption(cyMesh_ConfigInfoRam.netInfo.netKeys[meshId].encryptionKey, nonce,
+                                           &netPacket[6], length, NULL, 0, &netPacket[6],
+                                           &netPacket[6u + length], BENCH_MIC_LENGTH);
+}
+
+
+CYMESH_API_RETURN_T CyMesh_SecurityDecryptNetworkData(uint8 meshId, uint8 * inputPacket, uint8 length)
+{
+    uint8 nonce[13];
+    uint8 output[32];
+    uint8 payloadLength = length - BENCH_MIC_LENGTH;
+
+    if(IsValidMeshId(meshId) == false)
+    {
+        return CYMESH_ERROR_INVALID_MESH_ID;
+    }
+
+    NetworkNonce(meshId, inputPacket, nonce);
+    aesBlocks += 2u + (2u * AES_BLOCKS(payloadLength));
+    if(CyMesh_SecurityAesCcmDecryption(cyMesh_ConfigInfoRam.netInfo.netKeys[meshId].encryptionKey, nonce,
+                                       &inputPacket[6], payloadLength, NULL, 0, output,
+                                       &inputPacket[6u + payloadLength], BENCH_MIC_LENGTH) != CYMESH_ERROR_OK)
+    {
+        return CYMESH_ERROR_AES_CCM_DECRYPTION_FAILED;
+    }
+    memcpy(&inputPacket[6], output, payloadLength);
+    return CYMESH_ERROR_OK;
+}
+
+
+/* Privacy block: 5 zero bytes, the IV index and 7 bytes of ciphertext. Both
+ * directions XOR the first 6 bytes of its encryption into the header. */
+static CYMESH_API_RETURN_T ObfuscateClarify(uint8 meshId, uint8 * netPacket)
+{
+    uint32 ivIndex = cyMesh_ConfigInfoRam.netInfo.netKeys[meshId].ivIndex;
+    uint8 block[16] = { 0 };
+    uint8 i;
+
+    if(IsValidMeshId(meshId) == false)
+    {
+        return CYMESH_ERROR_INVALID_MESH_ID;
+    }
+
+    block[5] = (uint8)(ivIndex >> 24);
+    block[6] = (uint8)(ivIndex >> 16);
+    block[7] = (uint8)(ivIndex >> 8);
+    block[8] = (uint8)ivIndex;
+    memcpy(&block[9], &netPacket[6], 7u);
+    aesBlocks++;
+    (void)CyMesh_SecurityPVTAesEncrypt(block, cyMesh_ConfigInfoRam.netInfo.netKeys[meshId].privacyKey, block);
+
+    for(i = 0; i < 6u; i++)
+    {
+        netPacket[i] ^= block[i];
+    }
+    return CYMESH_ERROR_OK;
+}
+
+
+CYMESH_API_RETURN_T CyMesh_SecurityObfuscateNetHeader(uint8 meshId, uint8 * netPacket)
+{
+    return ObfuscateClarify(meshId, netPacket);
+}
+
+
+CYMESH_API_RETURN_T CyMesh_SecurityClarifyNetHeader(uint8 meshId, uint8 * netPacket)
+{
+    return ObfuscateClarify(meshId, netPacket);
+}
+
+
+static CYMESH_API_RETURN_T TransportCallback(uint32 event, void * eventParam)
+{
+    const CYMESH_NETWORK_PKT_T * packet = (const CYMESH_NETWORK_PKT_T *)eventParam;
+
+    (void)event;
+    transportCount++;
+    transportTtl = packet->data[1] & 0x3Fu;
+    return CYMESH_ERROR_OK;
+}
+
+
+/*******************************************************************************
+* Checks
+*******************************************************************************/
+static void SetUp(void)
+{
+    static const uint8 encryptionKey[16] =
+        { 0x09, 0x53, 0xFA, 0x93, 0xE7, 0xCA, 0xAC, 0x96, 0x38, 0xF5, 0x88, 0x20, 0x22, 0x0A, 0x39, 0x8E };
+    static const uint8 privacyKey[16] =
+        { 0x8B, 0x84, 0xEE, 0xDE, 0xC1, 0x00, 0x06, 0x7D, 0x67, 0x09, 0x71, 0xDD, 0x2A, 0xA7, 0x00, 0xCF };
+    CYMESH_NETWORK_KEYS_T * netKey = &cyMesh_ConfigInfoRam.netInfo.netKeys[0];
+    uint8 i;
+
+    memset(&cyMesh_ConfigInfoRam, 0, sizeof(cyMesh_ConfigInfoRam));
+    cyMesh_ConfigInfoRam.netInfo.numberOfNetworkKeys = 1u;
+    cyMesh_ConfigInfoRam.netInfo.isNetKeyValid = 1u;
+    memcpy(netKey->encryptionKey, encryptionKey, 16u);
+    memcpy(netKey->privacyKey, privacyKey, 16u);
+    netKey->networkId[15] = 0x68u;
+    netKey->ivIndex = BENCH_IV_INDEX;
+    cyMesh_ConfigInfoRam.bearerRole = CYMESH_ROLE_RELAY;
+    for(i = 0; i < CYMESH_NUMBER_OF_COMPONENTS; i++)
+    {
+        cyMesh_ConfigInfoRam.deviceInfo.components[i].componentAddress = BENCH_OWN_ADDRESS + i;
+    }
+
+    (void)CyMesh_NetworkStart(TransportCallback);
+}
+
+
+/* Network PDU from another node, as it goes on air. Returns its length. */
+static uint8 MakePacketTtl(uint8 * packet, uint32 seq, uint16 src, uint16 dst, uint8 ttl)
+{
+    uint8 pdu[BENCH_PDU_LENGTH] = { 0 };
+    uint8 i;
+
+    pdu[2] = (uint8)(seq >> 16);
+    pdu[3] = (uint8)(seq >> 8);
+    pdu[4] = (uint8)seq;
+    pdu[5] = (uint8)(src >> 8);
+    pdu[6] = (uint8)src;
+    pdu[7] = (uint8)(dst >> 8);
+    pdu[8] = (uint8)dst;
+    for(i = 9u; i < BENCH_PDU_LENGTH; i++)
+    {
+        pdu[i] = i;
+    }
+
+    (void)CyMesh_NetworkSendData(pdu, BENCH_PDU_LENGTH, 1u, false, false, ttl, 0u, 1u);
+    memcpy(packet, bearerPacket, bearerLength);
+    return bearerLength;
+}
+
+
+static uint8 MakePacket(uint8 * packet, uint32 seq, uint16 src, uint16 dst)
+{
+    return MakePacketTtl(packet, seq, src, dst, BENCH_TTL);
+}
+
+
+#if (CYMESH_ENABLE_TTL_LEARNING == 1)
+/* TTL of the last packet sent */
+static uint8 SentTtl(void)
+{
+    uint8 packet[CYMESH_BEARER_ADV_MAX_LENGTH + 8u];
+
+    memcpy(packet, bearerPacket, bearerLength);
+    (void)CyMesh_SecurityClarifyNetHeader(0u, &packet[1]);
+    return packet[1] & 0x3Fu;
+}
+#endif
+
+
+static void ReceiveAt(const uint8 * packet, uint8 length, int8 rssi)
+{
+    CYMESH_BEARER_RX_BUFFER_T rxBuffer;
+
+    memset(&rxBuffer, 0, sizeof(rxBuffer));
+    memcpy(rxBuffer.data, packet, length);
+    rxBuffer.length = length;
+    rxBuffer.rssi = rssi;
+    (void)bearerCallback(CYMESH_EVT_MESH_ADV, &rxBuffer);
+}
+
+
+static void Receive(const uint8 * packet, uint8 length)
+{
+    ReceiveAt(packet, length, 0);
+}
+
+
+#if (CYMESH_ENABLE_MANAGED_FLOODING == 1)
+/* SM timer ticks, which send the relays whose back-off ran out */
+static void Wait(uint32 ms)
+{
+    while(ms-- != 0u)
+    {
+        benchTime++;
+        CyMesh_NetworkFloodUpdate();
+    }
+}
+#endif
+
+
+static void WaitBackoff(void)
+{
+#if (CYMESH_ENABLE_MANAGED_FLOODING == 1)
+    Wait(CYMESH_NET_FLOOD_MAX_DELAY_MS + 1u);
+#endif
+}
+
+
+static int Check(const char * name, bool isPassed)
+{
+    printf("%-52s %s\n", name, (isPassed == true) ? "pass" : "FAIL");
+    return (isPassed == true) ? 0 : 1;
+}
+
+
+/* The replay list is written once the save period passes and reloaded by
+ * CyMesh_NetworkStart() */
+static int CheckReplayPersistence(void)
+{
+    uint8 packet[CYMESH_BEARER_ADV_MAX_LENGTH + 8u];
+    uint8 length;
+    uint32 writes;
+    uint32 i;
+    int failures = 0;
+
+    flashWrites = 0u;
+    for(i = 0; i <= CYMESH_NET_REPLAY_SAVE_PERIOD; i++)
+    {
+        CyMesh_NetworkReplayUpdate();
+    }
+    writes = flashWrites;
+    for(i = 0; i <= CYMESH_NET_REPLAY_SAVE_PERIOD; i++)
+    {
+        CyMesh_NetworkReplayUpdate();
+    }
+    failures += Check("replay list written once when changed", (writes == 1u) && (flashWrites == 1u));
+
+    SetUp();
+    length = MakePacket(packet, 4u, BENCH_SOURCE_ADDRESS, BENCH_OWN_ADDRESS);
+    transportCount = 0u;
+    Receive(packet, length);
+    failures += Check("replay dropped after a reset", transportCount == 0u);
+
+    length = MakePacket(packet, 5u, BENCH_SOURCE_ADDRESS, BENCH_OWN_ADDRESS);
+    Receive(packet, length);
+    failures += Check("next message accepted after a reset", transportCount == 1u);
+
+    return failures;
+}
+
+
+static int CheckReplayEviction(void)
+{
+    static CYMESH_NET_REPLAY_STRUCT replay;
+    bool isAccepted = true;
+    uint16 src;
+
+    CyMesh_NetworkReplayInit(&replay);
+    for(src = CYMESH_NET_REPLAY_LIST_SIZE + 1u; src > 0u; src--)
+    {
+        isAccepted = isAccepted && CyMesh_NetworkReplayAccept(&replay, src, 10u);
+    }
+
+    /* The first source was dropped for the last one */
+    return Check("least recently accepted source evicted",
+                 isAccepted && (replay.list.count == CYMESH_NET_REPLAY_LIST_SIZE) &&
+                 (CyMesh_NetworkReplayAccept(&replay, CYMESH_NET_REPLAY_LIST_SIZE + 1u, 10u) == true) &&
+                 (CyMesh_NetworkReplayAccept(&replay, 1u, 10u) == false) &&
+                 (CyMesh_NetworkReplayAccept(&replay, 2u, 10u) == false));
+}
+
+
+/* A source that wrapped its SEQ after CYMESH_TRAN_SEQ_MAX is heard again */
+static int CheckReplayWrap(void)
+{
+    uint8 packet[CYMESH_BEARER_ADV_MAX_LENGTH + 8u];
+    uint8 length;
+    int failures = 0;
+
+    SetUp();
+    length = MakePacket(packet, 0x1FFFFEu, BENCH_SOURCE_ADDRESS + 2u, BENCH_OWN_ADDRESS);
+    transportCount = 0u;
+    Receive(packet, length);
+    length = MakePacket(packet, 0x1FFFFFu, BENCH_SOURCE_ADDRESS + 2u, BENCH_OWN_ADDRESS);
+    Receive(packet, length);
+    length = MakePacket(packet, 0u, BENCH_SOURCE_ADDRESS + 2u, BENCH_OWN_ADDRESS);
+    Receive(packet, length);
+    length = MakePacket(packet, 1u, BENCH_SOURCE_ADDRESS + 2u, BENCH_OWN_ADDRESS);
+    Receive(packet, length);
+    failures += Check("source that wrapped its SEQ accepted", transportCount == 4u);
+
+    CyMesh_NetworkCacheInit(&net_msg_cache);
+    length = MakePacket(packet, 0u, BENCH_SOURCE_ADDRESS + 2u, BENCH_OWN_ADDRESS);
+    Receive(packet, length);
+    failures += Check("replay after the wrap dropped", transportCount == 4u);
+
+    /* Old PDUs, captured long before, are not a wrap */
+    length = MakePacket(packet, 0x150000u, BENCH_SOURCE_ADDRESS + 4u, BENCH_OWN_ADDRESS);
+    Receive(packet, length);
+    length = MakePacket(packet, 0x10u, BENCH_SOURCE_ADDRESS + 4u, BENCH_OWN_ADDRESS);
+    Receive(packet, length);
+    length = MakePacket(packet, 0x11u, BENCH_SOURCE_ADDRESS + 4u, BENCH_OWN_ADDRESS);
+    Receive(packet, length);
+    failures += Check("PDU far behind the stored SEQ dropped", transportCount == 5u);
+
+    length = MakePacket(packet, 0x1FFFF0u, BENCH_SOURCE_ADDRESS + 5u, BENCH_OWN_ADDRESS);
+    Receive(packet, length);
+    length = MakePacket(packet, 0x080000u, BENCH_SOURCE_ADDRESS + 5u, BENCH_OWN_ADDRESS);
+    Receive(packet, length);
+    failures += Check("mid-space SEQ not taken for a wrap", transportCount == 6u);
+
+    return failures;
+}
+
+
+/* A relay ahead sent the PDUs of a source out of order */
+static int CheckReplayReorder(void)
+{
+    uint8 packet[CYMESH_BEARER_ADV_MAX_LENGTH + 8u];
+    uint8 late[CYMESH_BEARER_ADV_MAX_LENGTH + 8u];
+    uint8 length;
+    uint8 lateLength;
+    uint32 sent;
+    int failures = 0;
+
+    SetUp();
+    transportCount = 0u;
+    lateLength = MakePacket(late, 20u, BENCH_SOURCE_ADDRESS + 3u, BENCH_OWN_ADDRESS);
+    length = MakePacket(packet, 21u, BENCH_SOURCE_ADDRESS + 3u, BENCH_OWN_ADDRESS);
+    Receive(packet, length);
+    Receive(late, lateLength);
+    failures += Check("PDU sent out of order by a relay delivered", transportCount == 2u);
+
+    CyMesh_NetworkCacheInit(&net_msg_cache);
+    Receive(late, lateLength);
+    failures += Check("replay of the late PDU dropped", transportCount == 2u);
+
+    /* The node is not the destination; the nodes behind it check the SEQ */
+    CyMesh_NetworkCacheInit(&net_msg_cache);
+    length = MakePacket(packet, 22u, BENCH_SOURCE_ADDRESS + 3u, BENCH_OTHER_ADDRESS);
+    Receive(packet, length);
+    WaitBackoff();
+    length = MakePacket(packet, 19u, BENCH_SOURCE_ADDRESS + 3u, BENCH_OTHER_ADDRESS);
+    sent = bearerCount;
+    Receive(packet, length);
+    WaitBackoff();
+    failures += Check("older SEQ for another node relayed", bearerCount == (sent + 1u));
+
+    return failures;
+}
+
+
+static int CheckFlooding(void)
+{
+    int failures = 0;
+#if (CYMESH_ENABLE_MANAGED_FLOODING == 1)
+    uint8 near[CYMESH_BEARER_ADV_MAX_LENGTH + 8u];
+    uint8 far[CYMESH_BEARER_ADV_MAX_LENGTH + 8u];
+    uint8 length;
+    uint32 sent;
+    uint8 i;
+
+    SetUp();
+
+    /* SEQs above those of the replay checks, which are stored. The near copy
+     * is heard 1 ms after the far one, so that both cannot be due at once. */
+    length = MakePacket(far, 0x100u, BENCH_SOURCE_ADDRESS, BENCH_OTHER_ADDRESS);
+    (void)MakePacket(near, 0x101u, BENCH_SOURCE_ADDRESS, BENCH_OTHER_ADDRESS);
+    sent = bearerCount;
+    ReceiveAt(far, length, CYMESH_NET_FLOOD_RSSI_FAR);
+    benchTime++;
+    ReceiveAt(near, length, CYMESH_NET_FLOOD_RSSI_NEAR);
+    failures += Check("relay held for its back-off", bearerCount == sent);
+    Wait(CYMESH_NET_FLOOD_BACKOFF_MS - 1u);
+    failures += Check("relay heard at low RSSI sent first",
+                      (CYMESH_NET_FLOOD_RSSI_MS == 0u) || (bearerCount == (sent + 1u)));
+    WaitBackoff();
+    failures += Check("relay heard at high RSSI sent after its back-off", bearerCount == (sent + 2u));
+
+    length = MakePacket(near, 0x102u, BENCH_SOURCE_ADDRESS, BENCH_OTHER_ADDRESS);
+    sent = bearerCount;
+    Receive(near, length);
+    WaitBackoff();
+    failures += Check("relay sent after its back-off", bearerCount == (sent + 1u));
+
+    length = MakePacket(near, 0x103u, BENCH_SOURCE_ADDRESS, BENCH_OTHER_ADDRESS);
+    sent = bearerCount;
+    for(i = 0u; i <= CYMESH_NET_FLOOD_SUPPRESS_COUNT; i++)
+    {
+        Receive(near, length);
+    }
+    WaitBackoff();
+    failures += Check("relay cancelled by the copies heard",
+                      (CYMESH_NET_FLOOD_SUPPRESS_COUNT == 0u) ? (bearerCount == (sent + 1u)) : (bearerCount == sent));
+#endif
+
+    return failures;
+}
+
+
+static int CheckTtlLearning(void)
+{
+    int failures = 0;
+#if (CYMESH_ENABLE_TTL_LEARNING == 1)
+    uint8 packet[CYMESH_BEARER_ADV_MAX_LENGTH + 8u];
+    uint8 length;
+
+    SetUp();
+    cyMesh_ConfigInfoRam.deviceInfo.deviceDefaultTtl = BENCH_TTL;
+    cyMesh_ConfigInfoRam.deviceInfo.components[0].model[0].modelDefaultTtl = 20u;
+
+    /* The first message to a destination keeps its TTL and tracks it. Its
+     * response comes from 3 hops away, and a copy 4 hops. SEQs above those
+     * of the replay checks, which are stored. */
+    (void)MakePacketTtl(packet, 1u, BENCH_OWN_ADDRESS, BENCH_SOURCE_ADDRESS, 20u);
+    failures += Check("TTL to a new destination kept", SentTtl() == 20u);
+    length = MakePacketTtl(packet, 0x200u, BENCH_SOURCE_ADDRESS, BENCH_OWN_ADDRESS, 20u - 2u);
+    Receive(packet, length);
+    length = MakePacketTtl(packet, 0x201u, BENCH_SOURCE_ADDRESS, BENCH_OWN_ADDRESS, 20u - 3u);
+    Receive(packet, length);
+    length = MakePacketTtl(packet, 0x202u, BENCH_OTHER_ADDRESS, BENCH_OWN_ADDRESS, 20u - 1u);
+    Receive(packet, length);
+
+    (void)MakePacketTtl(packet, 2u, BENCH_OWN_ADDRESS, BENCH_SOURCE_ADDRESS, 20u);
+    failures += Check("TTL to a destination heard is distance + margin",
+                      SentTtl() == (3u + CYMESH_NET_HOPS_TTL_MARGIN));
+    (void)MakePacketTtl(packet, 3u, BENCH_OWN_ADDRESS, BENCH_SOURCE_ADDRESS, 1u);
+    failures += Check("TTL 1 kept", SentTtl() == 1u);
+    (void)MakePacketTtl(packet, 4u, BENCH_OWN_ADDRESS, BENCH_OTHER_ADDRESS, 20u);
+    failures += Check("source not sent to before not learned", SentTtl() == 20u);
+
+    benchTime += CYMESH_NET_HOPS_LIFETIME_MS;
+    (void)MakePacketTtl(packet, 5u, BENCH_OWN_ADDRESS, BENCH_SOURCE_ADDRESS, 20u);
+    failures += Check("TTL kept once the distance expired", SentTtl() == 20u);
+#endif
+
+    return failures;
+}
+
+
+static int CheckNetwork(void)
+{
+    uint8 packet[CYMESH_BEARER_ADV_MAX_LENGTH + 8u];
+    uint8 forged[CYMESH_BEARER_ADV_MAX_LENGTH + 8u];
+    uint8 relayed[CYMESH_BEARER_ADV_MAX_LENGTH + 8u];
+    uint8 length;
+    uint32 sent;
+    int failures = 0;
+
+    SetUp();
+
+    length = MakePacket(packet, 1u, BENCH_SOURCE_ADDRESS, BENCH_OWN_ADDRESS);
+    Receive(packet, length);
+    failures += Check("unicast to this node delivered, not relayed", (transportCount == 1u) && (bearerCount == 1u));
+
+    length = MakePacket(packet, 2u, BENCH_SOURCE_ADDRESS, BENCH_OTHER_ADDRESS);
+    sent = bearerCount;
+    Receive(packet, length);
+    WaitBackoff();
+    failures += Check("unicast to another node relayed", bearerCount == (sent + 1u));
+
+    /* The next hop clarifies and decrypts the relayed copy */
+    memcpy(relayed, bearerPacket, bearerLength);
+    failures += Check("relayed packet clarifies and decrypts",
+                      (CyMesh_SecurityClarifyNetHeader(0u, &relayed[1]) == CYMESH_ERROR_OK) &&
+                      (CyMesh_SecurityDecryptNetworkData(0u, &relayed[1], bearerLength - 7u) == CYMESH_ERROR_OK) &&
+                      ((relayed[1] & 0x3Fu) == (BENCH_TTL - 1u)) && (relayed[8] == (uint8)BENCH_OTHER_ADDRESS) &&
+                      (relayed[BENCH_PDU_LENGTH - 1u] == (BENCH_PDU_LENGTH - 1u)));
+
+    Receive(packet, length);
+    WaitBackoff();
+    failures += Check("duplicate dropped", bearerCount == (sent + 1u));
+
+    length = MakePacket(packet, 3u, BENCH_OWN_ADDRESS + 1u, 0xFFFFu);
+    sent = bearerCount;
+    transportCount = 0u;
+    Receive(packet, length);
+    WaitBackoff();
+    failures += Check("own packet dropped", (bearerCount == sent) && (transportCount == 0u));
+
+    length = MakePacket(packet, 4u, BENCH_SOURCE_ADDRESS, 0xFFFFu);
+    memcpy(forged, packet, length);
+    forged[length - 1u] ^= 0x01u;
+    sent = bearerCount;
+    Receive(forged, length);
+    Receive(packet, length);
+    WaitBackoff();
+    failures += Check("forged copy does not block the real packet",
+                      (bearerCount == (sent + 1u)) && (transportCount == 1u) && (transportTtl == 0u));
+
+    length = MakePacket(packet, 2u, BENCH_SOURCE_ADDRESS, BENCH_OTHER_ADDRESS);
+    sent = bearerCount;
+    Receive(packet, length);
+    WaitBackoff();
+    failures += Check("older message still in the cache dropped", bearerCount == sent);
+
+    CyMesh_NetworkCacheInit(&net_msg_cache);
+    length = MakePacket(packet, 1u, BENCH_SOURCE_ADDRESS, BENCH_OWN_ADDRESS);
+    transportCount = 0u;
+    Receive(packet, length);
+    failures += Check("replay no longer in the cache dropped", transportCount == 0u);
+
+    failures += CheckReplayPersistence();
+    failures += CheckReplayEviction();
+    failures += CheckReplayWrap();
+    failures += CheckReplayReorder();
+    failures += CheckFlooding();
+    failures += CheckTtlLearning();
+
+    return failures;
+}
+
+
+/*******************************************************************************
+* Benchmark
+*******************************************************************************/
+static void Benchmark(void)
+{
+    static const char * const names[BENCH_PATH_COUNT] = { "receive", "duplicate", "relay" };
+    static uint8 packets[BENCH_PACKETS][CYMESH_BEARER_ADV_MAX_LENGTH + 8u];
+    unsigned long long cycles[BENCH_PATH_COUNT];
+    uint32 blocks[BENCH_PATH_COUNT];
+    uint8 length = 0u;
+    uint32 path;
+    uint32 run;
+    uint32 i;
+
+    for(path = 0; path < BENCH_PATH_COUNT; path++)
+    {
+        SetUp();
+        for(i = 0; i < BENCH_PACKETS; i++)
+        {
+            length = MakePacket(packets[i], i + 1u, BENCH_SOURCE_ADDRESS,
+                                (path == BENCH_RECEIVE) ? BENCH_OWN_ADDRESS : BENCH_OTHER_ADDRESS);
+        }
+
+        for(run = 0; run < BENCH_REPEAT; run++)
+        {
+            unsigned long long start;
+
+            CyMesh_NetworkCacheInit(&net_msg_cache);
+            CyMesh_NetworkReplayInit(&net_replay_list);
+            if(path == BENCH_DUPLICATE)
+            {
+                for(i = 0; i < BENCH_PACKETS; i++)
+                {
+                    Receive(packets[i], length);
+                }
+            }
+
+            aesBlocks = 0u;
+            start = BENCH_CYCLES();
+            for(i = 0; i < BENCH_PACKETS; i++)
+            {
+                /* Duplicates of recent packets, still in the cache */
+                Receive(packets[(path == BENCH_DUPLICATE) ? (BENCH_PACKETS - 1u - (i % 8u)) : i], length);
+            #if (CYMESH_ENABLE_MANAGED_FLOODING == 1)
+                /* The relay leaves the table on the SM timer */
+                benchTime += CYMESH_NET_FLOOD_MAX_DELAY_MS + 1u;
+                CyMesh_NetworkFloodUpdate();
+            #endif
+            }
+            start = BENCH_CYCLES() - start;
+
+            if((run == 0u) || (start < cycles[path]))
+            {
+                cycles[path] = start;
+            }
+            blocks[path] = aesBlocks;
+        }
+    }
+
+    printf("\ncore %s, key cache %d, %u byte network PDU\n",
+           (CYMESH_SECURITY_AES_CORE == CYMESH_SECURITY_AES_CORE_TTABLE) ? "T-table" : "compact",
+           (int)CYMESH_SECURITY_AES_KEY_CACHE_SIZE, (unsigned int)length);
+    printf("%-10s %16s %16s\n", "path", "AES blocks/pkt", "cycles/pkt");
+    for(path = 0; path < BENCH_PATH_COUNT; path++)
+    {
+        printf("%-10s %16.1f %16.0f\n", names[path], (double)blocks[path] / BENCH_PACKETS,
+               (double)cycles[path] / BENCH_PACKETS);
+    }
+}
+
+
+int main(void)
+{
+    int failures = CheckNetwork();
+
+    if(failures != 0)
+    {
+        printf("\n%d check(s) failed\n", failures);
+        return 1;
+    }
+
+    Benchmark();
+    return 0;
+}
+
+/* [] END OF FILE */
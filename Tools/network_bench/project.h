@@ -0,0 +1,112 @@
+/*******************************************************************************
+* Host replacement of the PSoC Creator generated project.h, with the types
+* CyMesh_Network.c and the SmartMesh headers need to build on a PC.
+*******************************************************************************/
+#if !defined(PROJECT_H)
+#define PROJECT_H
+
+#include <stdint.h>
+
+typedef uint8_t  uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef int8_t   int8;
+typedef int16_t  int16;
+typedef int32_t  int32;
+
+typedef struct
+{
+    uint8 bdAddr[6];
+    uint8 type;
+} CYBLE_GAP_BD_ADDR_T;
+
+/* Advertising reports of the BLE stack */
+typedef uint8 CYBLE_API_RESULT_T;
+typedef void (* CYBLE_CALLBACK_T)(uint32 eventCode, void * eventParam);
+
+typedef struct
+{
+    uint8 eventType;
+    uint8 peerAddrType;
+    uint8 * peerBdAddr;
+    uint8 dataLen;
+    uint8 * data;
+    int8 rssi;
+} CYBLE_GAPC_ADV_REPORT_T;
+
+#define CYBLE_EVT_GAPC_SCAN_PROGRESS_RESULT     (0x0007u)
+#define CYBLE_GAPC_NON_CONN_UNDIRECTED_ADV      (0x03u)
+
+/* GATT server, for the proxy bearer */
+typedef uint16 CYBLE_GATT_DB_ATTR_HANDLE_T;
+
+typedef struct
+{
+    uint8 bdHandle;
+    uint8 attId;
+} CYBLE_CONN_HANDLE_T;
+
+typedef struct
+{
+    uint8 * val;
+    uint16 len;
+    uint16 actualLen;
+} CYBLE_GATT_VALUE_T;
+
+typedef struct
+{
+    CYBLE_GATT_VALUE_T value;
+    CYBLE_GATT_DB_ATTR_HANDLE_T attrHandle;
+} CYBLE_GATT_HANDLE_VALUE_PAIR_T;
+
+typedef CYBLE_GATT_HANDLE_VALUE_PAIR_T CYBLE_GATTS_HANDLE_VALUE_NTF_T;
+
+typedef struct
+{
+    CYBLE_CONN_HANDLE_T connHandle;
+    CYBLE_GATT_HANDLE_VALUE_PAIR_T handleValPair;
+} CYBLE_GATTS_WRITE_REQ_PARAM_T;
+
+#define CYBLE_EVT_GATT_CONNECT_IND              (0x0040u)
+#define CYBLE_EVT_GATT_DISCONNECT_IND           (0x0041u)
+#define CYBLE_EVT_GATTS_WRITE_REQ               (0x0048u)
+#define CYBLE_EVT_GATTS_WRITE_CMD_REQ           (0x0049u)
+
+#define CYBLE_ERROR_OK                          (0x00u)
+#define CYBLE_ERROR_INVALID_OPERATION           (0x03u)
+#define CYBLE_ERROR_MEMORY_ALLOCATION_FAILED    (0x0Fu)
+
+#define CYBLE_GATT_DEFAULT_MTU                  (23u)
+#define CYBLE_STACK_STATE_FREE                  (0x00u)
+#define CYBLE_STACK_STATE_BUSY                  (0x01u)
+
+/* Defined by the bench */
+extern CYBLE_CONN_HANDLE_T cyBle_connHandle;
+
+uint8 CyBle_GattGetBusyStatus(void);
+CYBLE_API_RESULT_T CyBle_GattGetMtuSize(uint16 * mtu);
+CYBLE_API_RESULT_T CyBle_GattsWriteRsp(CYBLE_CONN_HANDLE_T connHandle);
+
+/* Die coordinates in the supervisory flash, defined by the bench */
+extern uint8 cySimSflashDie[2];
+
+#define CYREG_SFLASH_DIE_X      (&cySimSflashDie[0])
+#define CYREG_SFLASH_DIE_Y      (&cySimSflashDie[1])
+#define CY_GET_REG8(addr)       (*(const volatile uint8 *)(addr))
+
+uint8 CyEnterCriticalSection(void);
+void CyExitCriticalSection(uint8 savedIntrStatus);
+
+/* Flash copies are linked into .data so that the CyBLE_Nvram_Write() model can
+ * write them */
+#define CY_SECTION(name)        __attribute__((section(".data.cy_flash")))
+#define CY_ALIGN(align)         __attribute__((aligned(align)))
+#define CYDEV_FLS_ROW_SIZE      (128u)
+#define CYRET_SUCCESS           (0x00u)
+
+typedef uint32 cystatus;
+
+cystatus CyBLE_Nvram_Write(const uint8 buffer[], const uint8 varFlash[], uint16 length);
+
+#endif
+/* [] END OF FILE */
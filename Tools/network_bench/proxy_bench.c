@@ -0,0 +1,635 @@
+/*******************************************************************************
+* Benchmark of Firmware_Mesh/SM Files/CyMesh_BearerProxy.c.
+*
+* A GATT proxy node with one client is run 1 ms at a time, one main loop per
+* ms. The BLE stack is a stub: a notification or a write takes
+* ceil((length + ATT and L2CAP headers) / 27) LL packets, and a connection
+* event every SIM_CONN_INTERVAL_US carries up to a given number of them. The
+* stack holds a given number of notifications; past that
+* CyBle_GattGetBusyStatus() is busy and CyBle_GattsNotification() fails for
+* lack of memory.
+*
+* TX: network PDUs of 14 to 29 bytes reach the node at random, at the offered
+* rate, and the library bearer notifies each of them twice,
+* SIM_COPY_GAP_MS apart, as it does for the two transmissions the bearer TX
+* scheduler gives it. The library is modelled from CyMesh_BearerSendData():
+* up to 18 bytes in one notification, more in two, whatever the MTU, and the
+* result is not looked at. Each load is run with the notifications sent to
+* the stack directly (library), through the proxy bearer with a client that
+* does not aggregate (single), and with one that does (aggregate). The client
+* checks every PDU it gets; the PDUs per second are those it got once or
+* more, the latency runs from the arrival at the node.
+*
+* RX: the client has PDUs to write all the time. One per write, they go to
+* the RX buffer of the library, 4 entries emptied once per
+* CyBle_ProcessEvents(), which hands over all the writes of a connection
+* event. Aggregated, they are split by CyMesh_BearerProxyEvent() into the
+* ring of CyMesh_BearerRx.c, CYMESH_BEARER_RX_RING_SIZE entries emptied in
+* the same main loop.
+*
+* The bench fails if a PDU is corrupted, if the proxy bearer loses track of a
+* PDU, or if aggregates carry fewer PDUs than single PDUs. From the
+* repository root:
+*
+*   gcc -O2 -I Tools/network_bench -I "Firmware_Mesh/SM Files" -o proxy_bench \
+*       Tools/network_bench/proxy_bench.c "Firmware_Mesh/SM Files/CyMesh_BearerProxy.c" -lm && ./proxy_bench
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <project.h>
+#include "CyMesh_BearerProxy.h"
+#include "CyMesh_BearerRx.h"
+
+#define SIM_DURATION_MS         (60000u)
+#define SIM_DRAIN_MS            (2000u)     /* After the run, to empty the queues */
+#define SIM_SEED                (1u)
+#define SIM_MAX_PDUS            (65536u)
+
+#define SIM_CONN_INTERVAL_US    (15000u)
+#define SIM_LL_PAYLOAD          (27u)       /* No data length extension */
+#define SIM_HEADER_LENGTH       (7u)        /* L2CAP (4) + ATT (3) */
+#define SIM_COPIES              (2u)
+#define SIM_COPY_GAP_MS         (20u)
+
+#define SIM_PDU_MIN_LENGTH      (14u)
+#define SIM_PDU_LENGTHS         (16u)       /* 14 to 29 bytes */
+#define SIM_LIBRARY_SEGMENT     (18u)       /* CyMesh_BearerSendData() */
+#define SIM_LIBRARY_RX_ENTRIES  (4u)        /* RX buffer of CyMesh_Bearer.o */
+#define SIM_LINK_SLOTS          (16u)
+
+typedef enum
+{
+    SIM_MODE_LIBRARY,
+    SIM_MODE_SINGLE,
+    SIM_MODE_AGGREGATE,
+    SIM_MODE_COUNT
+} SIM_MODE_T;
+
+typedef struct
+{
+    uint16 mtu;
+    uint8 buffers;
+    uint8 llPerEvent;
+} SIM_LINK_T;
+
+static const SIM_LINK_T simLinks[] =
+{
+    {  23u, 1u, 4u },
+    {  23u, 4u, 4u },
+    {  71u, 1u, 4u },
+    {  71u, 4u, 4u },
+    {  71u, 4u, 8u },
+    { 158u, 6u, 8u },
+};
+
+#define SIM_LINK_COUNT          (sizeof(simLinks) / sizeof(simLinks[0]))
+
+static const uint16 simLoads[] = { 50u, 200u, 600u };
+
+#define SIM_LOAD_COUNT          (sizeof(simLoads) / sizeof(simLoads[0]))
+
+static const char * const simModeNames[SIM_MODE_COUNT] = { "library", "single", "aggregate" };
+
+/* Notifications held by the stub stack, oldest first */
+typedef struct
+{
+    uint8 data[CYMESH_BEARER_GATT_MAX_DATA_LENGTH + SIM_HEADER_LENGTH];
+    uint8 length;
+    uint8 llLeft;
+} SIM_NOTIFICATION_T;
+
+static const SIM_LINK_T * link;
+static SIM_NOTIFICATION_T linkQueue[SIM_LINK_SLOTS];
+static uint8 linkCount;
+static uint32 nowMs;
+
+CYBLE_CONN_HANDLE_T cyBle_connHandle;
+
+/* PDUs offered, and when each got to the node and to the client */
+static uint32 arrivalMs[SIM_MAX_PDUS];
+static uint32 latency[SIM_MAX_PDUS];
+static bool seen[SIM_MAX_PDUS];
+static uint32 delivered;
+static uint32 corrupted;
+static uint32 notifications;
+
+/* Client reassembly of the segments */
+static uint8 clientSegment[CYMESH_BEARER_ADV_MAX_LENGTH];
+static uint8 clientSegmentLength;
+
+/* RX: entries of the ring of CyMesh_BearerRx.c taken in the event */
+static uint8 rxRingCount;
+
+
+static uint8 PduLength(uint32 seq)
+{
+    return SIM_PDU_MIN_LENGTH + (uint8)(seq % SIM_PDU_LENGTHS);
+}
+
+
+/* PDU seq: its number, then a pattern of it */
+static uint8 PduBuild(uint32 seq, uint8 * pdu)
+{
+    uint8 length = PduLength(seq);
+    uint8 i;
+
+    memcpy(pdu, &seq, sizeof(seq));
+    for(i = sizeof(seq); i < length; i++)
+    {
+        pdu[i] = (uint8)((seq * 7u) + i);
+    }
+
+    return length;
+}
+
+
+/* Number of the PDU, or SIM_MAX_PDUS if it is corrupted */
+static uint32 PduCheck(const uint8 * pdu, uint8 length)
+{
+    uint8 expected[CYMESH_BEARER_ADV_MAX_LENGTH];
+    uint32 seq;
+
+    if(length < sizeof(seq))
+    {
+        return SIM_MAX_PDUS;
+    }
+    memcpy(&seq, pdu, sizeof(seq));
+    if((seq >= SIM_MAX_PDUS) || (PduBuild(seq, expected) != length) || (memcmp(expected, pdu, length) != 0))
+    {
+        return SIM_MAX_PDUS;
+    }
+
+    return seq;
+}
+
+
+static void ClientPdu(const uint8 * pdu, uint8 length)
+{
+    uint32 seq = PduCheck(pdu, length);
+
+    if(seq == SIM_MAX_PDUS)
+    {
+        corrupted++;
+    }
+    else if(seen[seq] == false)
+    {
+        seen[seq] = true;
+        latency[delivered++] = nowMs - arrivalMs[seq];
+    }
+    else
+    {
+        /* Copy */
+    }
+}
+
+
+/* The client gets a notification */
+static void ClientNotification(const uint8 * data, uint8 length)
+{
+    uint8 offset = 1u;
+
+    notifications++;
+    switch(data[0])
+    {
+        case CYMESH_BEARER_PROXY_SAR_COMPLETE | CYMESH_BEARER_PROXY_TYPE_NETWORK:
+            ClientPdu(&data[1], length - 1u);
+            break;
+
+        case CYMESH_BEARER_PROXY_SAR_FIRST | CYMESH_BEARER_PROXY_TYPE_NETWORK:
+            memcpy(clientSegment, &data[1], length - 1u);
+            clientSegmentLength = length - 1u;
+            break;
+
+        case CYMESH_BEARER_PROXY_SAR_LAST | CYMESH_BEARER_PROXY_TYPE_NETWORK:
+            memcpy(&clientSegment[clientSegmentLength], &data[1], length - 1u);
+            ClientPdu(clientSegment, clientSegmentLength + (length - 1u));
+            clientSegmentLength = 0u;
+            break;
+
+        case CYMESH_BEARER_PROXY_SAR_COMPLETE | CYMESH_BEARER_PROXY_TYPE_AGGREGATE:
+            while(offset < length)
+            {
+                ClientPdu(&data[offset + 1u], data[offset]);
+                offset += 1u + data[offset];
+            }
+            break;
+
+        default:
+            corrupted++;
+            break;
+    }
+}
+
+
+static uint8 LlPackets(uint8 length)
+{
+    return (uint8)((length + SIM_HEADER_LENGTH + SIM_LL_PAYLOAD - 1u) / SIM_LL_PAYLOAD);
+}
+
+
+/* Connection event: the LL packets of the held notifications go out */
+static void LinkEvent(void)
+{
+    uint8 budget = link->llPerEvent;
+
+    while((linkCount != 0u) && (budget != 0u))
+    {
+        SIM_NOTIFICATION_T * head = &linkQueue[0];
+        uint8 sent = (head->llLeft < budget) ? head->llLeft : budget;
+
+        head->llLeft -= sent;
+        budget -= sent;
+        if(head->llLeft == 0u)
+        {
+            ClientNotification(head->data, head->length);
+            linkCount--;
+            memmove(&linkQueue[0], &linkQueue[1], linkCount * sizeof(linkQueue[0]));
+        }
+    }
+}
+
+
+uint8 CyEnterCriticalSection(void)
+{
+    return 0u;
+}
+
+
+void CyExitCriticalSection(uint8 savedIntrStatus)
+{
+    (void)savedIntrStatus;
+}
+
+
+uint8 CyBle_GattGetBusyStatus(void)
+{
+    return (linkCount >= link->buffers) ? CYBLE_STACK_STATE_BUSY : CYBLE_STACK_STATE_FREE;
+}
+
+
+CYBLE_API_RESULT_T CyBle_GattGetMtuSize(uint16 * mtu)
+{
+    *mtu = link->mtu;
+    return CYBLE_ERROR_OK;
+}
+
+
+CYBLE_API_RESULT_T CyBle_GattsWriteRsp(CYBLE_CONN_HANDLE_T connHandle)
+{
+    (void)connHandle;
+    return CYBLE_ERROR_OK;
+}
+
+
+CYBLE_API_RESULT_T __real_CyBle_GattsNotification(CYBLE_CONN_HANDLE_T connHandle,
+                                                  CYBLE_GATTS_HANDLE_VALUE_NTF_T * ntfParam)
+{
+    SIM_NOTIFICATION_T * entry;
+
+    (void)connHandle;
+    if((ntfParam->value.len > (link->mtu - CYMESH_BEARER_PROXY_ATT_HEADER_LENGTH)) ||
+       (ntfParam->value.len > CYMESH_BEARER_GATT_MAX_DATA_LENGTH))
+    {
+        return CYBLE_ERROR_INVALID_OPERATION;
+    }
+    if(linkCount >= link->buffers)
+    {
+        return CYBLE_ERROR_MEMORY_ALLOCATION_FAILED;
+    }
+
+    entry = &linkQueue[linkCount++];
+    memcpy(entry->data, ntfParam->value.val, ntfParam->value.len);
+    entry->length = (uint8)ntfParam->value.len;
+    entry->llLeft = LlPackets(entry->length);
+
+    return CYBLE_ERROR_OK;
+}
+
+
+/* The ring of CyMesh_BearerRx.c */
+bool CyMesh_BearerRxInsert(const uint8 * pdu, uint8 length)
+{
+    if(rxRingCount >= CYMESH_BEARER_RX_RING_SIZE)
+    {
+        return false;
+    }
+    rxRingCount++;
+    if(PduCheck(pdu, length) == SIM_MAX_PDUS)
+    {
+        corrupted++;
+    }
+
+    return true;
+}
+
+
+/* CyMesh_BearerSendData() of the library for a network PDU, notifying the
+ * client through notify */
+static void LibrarySend(const uint8 * pdu, uint8 length, bool isWrapped)
+{
+    CYBLE_GATTS_HANDLE_VALUE_NTF_T notification;
+    uint8 packet[SIM_LIBRARY_SEGMENT + 1u];
+    uint8 first = (length > SIM_LIBRARY_SEGMENT) ? SIM_LIBRARY_SEGMENT : length;
+
+    notification.attrHandle = CYMESH_BEARER_PROXY_DATA_HANDLE;
+    notification.value.val = packet;
+
+    packet[0] = ((first == length) ? CYMESH_BEARER_PROXY_SAR_COMPLETE : CYMESH_BEARER_PROXY_SAR_FIRST) |
+                CYMESH_BEARER_PROXY_TYPE_NETWORK;
+    memcpy(&packet[1], pdu, first);
+    notification.value.len = first + 1u;
+    (void)(isWrapped ? __wrap_CyBle_GattsNotification(cyBle_connHandle, &notification)
+                     : __real_CyBle_GattsNotification(cyBle_connHandle, &notification));
+
+    if(first != length)
+    {
+        packet[0] = CYMESH_BEARER_PROXY_SAR_LAST | CYMESH_BEARER_PROXY_TYPE_NETWORK;
+        memcpy(&packet[1], &pdu[first], length - first);
+        notification.value.len = (length - first) + 1u;
+        (void)(isWrapped ? __wrap_CyBle_GattsNotification(cyBle_connHandle, &notification)
+                         : __real_CyBle_GattsNotification(cyBle_connHandle, &notification));
+    }
+}
+
+
+static void Connect(const SIM_LINK_T * simLink)
+{
+    link = simLink;
+    linkCount = 0u;
+    nowMs = 0u;
+    clientSegmentLength = 0u;
+    (void)CyMesh_BearerProxyEvent(CYBLE_EVT_GATT_CONNECT_IND, NULL);
+    memset(&cyMesh_BearerProxyStats, 0, sizeof(cyMesh_BearerProxyStats));
+}
+
+
+/* The client writes an empty aggregate, and gets the answer */
+static void Aggregate(void)
+{
+    uint8 header = CYMESH_BEARER_PROXY_SAR_COMPLETE | CYMESH_BEARER_PROXY_TYPE_AGGREGATE;
+    CYBLE_GATTS_WRITE_REQ_PARAM_T write;
+
+    write.handleValPair.attrHandle = CYMESH_BEARER_PROXY_DATA_HANDLE;
+    write.handleValPair.value.val = &header;
+    write.handleValPair.value.len = sizeof(header);
+    (void)CyMesh_BearerProxyEvent(CYBLE_EVT_GATTS_WRITE_CMD_REQ, &write);
+    CyMesh_BearerProxyUpdate();
+    LinkEvent();
+    notifications = 0u;
+}
+
+
+/* Time to the next PDU in us, exponentially distributed */
+static double NextArrival(uint16 load)
+{
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+    return -log(u) * 1000000.0 / load;
+}
+
+
+static int CompareTime(const void * a, const void * b)
+{
+    uint32 x = *(const uint32 *)a;
+    uint32 y = *(const uint32 *)b;
+
+    return (x > y) - (x < y);
+}
+
+
+/* TX at load PDUs/s; false if the proxy bearer lost track of a PDU */
+static bool TxRun(const SIM_LINK_T * simLink, uint16 load, SIM_MODE_T mode, double * rate, double * lost,
+                  double * p50)
+{
+    uint8 pdu[CYMESH_BEARER_ADV_MAX_LENGTH];
+    uint32 copyAt[SIM_MAX_PDUS];
+    uint32 offered = 0u;
+    uint32 copied = 0u;
+    uint32 deliveredInRun;
+    uint32 nextConnUs = 0u;
+    double nextArrivalUs;
+    const CYMESH_BEARER_PROXY_STATS_T * stats = &cyMesh_BearerProxyStats;
+
+    Connect(simLink);
+    if(mode == SIM_MODE_AGGREGATE)
+    {
+        Aggregate();
+    }
+    srand(SIM_SEED + load + simLink->mtu + simLink->buffers);
+    nextArrivalUs = NextArrival(load);
+    memset(seen, 0, sizeof(seen));
+    delivered = 0u;
+    notifications = 0u;
+
+    for(nowMs = 0u; nowMs < (SIM_DURATION_MS + SIM_DRAIN_MS); nowMs++)
+    {
+        /* Arrivals, each PDU notified a second time later */
+        while((nowMs < SIM_DURATION_MS) && (offered < SIM_MAX_PDUS) && (nextArrivalUs < ((nowMs + 1u) * 1000.0)))
+        {
+            arrivalMs[offered] = nowMs;
+            copyAt[offered] = nowMs + SIM_COPY_GAP_MS;
+            LibrarySend(pdu, PduBuild(offered, pdu), mode != SIM_MODE_LIBRARY);
+            offered++;
+            nextArrivalUs += NextArrival(load);
+        }
+        while((SIM_COPIES > 1u) && (copied < offered) && (copyAt[copied] <= nowMs))
+        {
+            LibrarySend(pdu, PduBuild(copied, pdu), mode != SIM_MODE_LIBRARY);
+            copied++;
+        }
+
+        /* CyBle_ProcessEvents() */
+        if((nowMs * 1000u) >= nextConnUs)
+        {
+            LinkEvent();
+            nextConnUs += SIM_CONN_INTERVAL_US;
+        }
+        if(mode != SIM_MODE_LIBRARY)
+        {
+            CyMesh_BearerProxyUpdate();
+        }
+    }
+
+    deliveredInRun = delivered;
+    *rate = deliveredInRun * 1000.0 / SIM_DURATION_MS;
+    *lost = (offered != 0u) ? (100.0 * (offered - deliveredInRun) / offered) : 0.0;
+    qsort(latency, deliveredInRun, sizeof(latency[0]), CompareTime);
+    *p50 = (deliveredInRun != 0u) ? latency[deliveredInRun / 2u] : 0.0;
+
+    if(mode == SIM_MODE_LIBRARY)
+    {
+        return true;
+    }
+
+    /* Every copy queued, dropped as a duplicate or lost to a full queue; every
+     * PDU queued sent once the queue is drained */
+    return ((stats->queued + stats->duplicate + stats->overflow) == (offered + copied)) &&
+           (stats->sent == stats->queued) && (stats->queued >= deliveredInRun);
+}
+
+
+/* RX: PDUs/s the client gets through, one per write or aggregated */
+static double RxRun(const SIM_LINK_T * simLink, bool isAggregated, double * lost)
+{
+    uint8 packet[CYMESH_BEARER_GATT_MAX_DATA_LENGTH];
+    uint8 payload = (uint8)(((simLink->mtu - CYMESH_BEARER_PROXY_ATT_HEADER_LENGTH) < CYMESH_BEARER_GATT_MAX_DATA_LENGTH)
+                            ? (simLink->mtu - CYMESH_BEARER_PROXY_ATT_HEADER_LENGTH)
+                            : CYMESH_BEARER_GATT_MAX_DATA_LENGTH);
+    CYBLE_GATTS_WRITE_REQ_PARAM_T write;
+    uint32 written = 0u;
+    uint32 received = 0u;
+    uint32 eventUs;
+
+    Connect(simLink);
+    write.handleValPair.attrHandle = CYMESH_BEARER_PROXY_DATA_HANDLE;
+    write.handleValPair.value.val = packet;
+
+    for(eventUs = 0u; eventUs < (SIM_DURATION_MS * 1000u); eventUs += SIM_CONN_INTERVAL_US)
+    {
+        uint8 budget = simLink->llPerEvent;
+
+        uint8 libraryCount = 0u;
+
+        rxRingCount = 0u;
+        while(budget != 0u)
+        {
+            uint8 length = 1u;
+            uint8 pdus = 0u;
+            uint8 cost;
+
+            if((isAggregated == true) && ((length + 1u + PduLength(written)) <= payload))
+            {
+                packet[0] = CYMESH_BEARER_PROXY_SAR_COMPLETE | CYMESH_BEARER_PROXY_TYPE_AGGREGATE;
+                while((length + 1u + PduLength(written)) <= payload)
+                {
+                    packet[length] = PduBuild(written++, &packet[length + 1u]);
+                    length += 1u + packet[length];
+                    pdus++;
+                }
+            }
+            else
+            {
+                /* One PDU, in two segments if it does not fit */
+                packet[0] = CYMESH_BEARER_PROXY_SAR_COMPLETE | CYMESH_BEARER_PROXY_TYPE_NETWORK;
+                length += PduBuild(written++, &packet[1]);
+                pdus++;
+            }
+
+            cost = (length <= payload) ? LlPackets(length)
+                                       : (LlPackets(CYMESH_BEARER_PROXY_SEGMENT_LENGTH + 1u) +
+                                          LlPackets((length - CYMESH_BEARER_PROXY_SEGMENT_LENGTH)));
+            if(cost > budget)
+            {
+                /* Written in the next event */
+                written -= pdus;
+                break;
+            }
+            budget -= cost;
+
+            /* All the writes of the event in one CyBle_ProcessEvents() */
+            write.handleValPair.value.len = length;
+            if(packet[0] == (CYMESH_BEARER_PROXY_SAR_COMPLETE | CYMESH_BEARER_PROXY_TYPE_AGGREGATE))
+            {
+                (void)CyMesh_BearerProxyEvent(CYBLE_EVT_GATTS_WRITE_CMD_REQ, &write);
+            }
+            else if(PduCheck(&packet[1], length - 1u) == SIM_MAX_PDUS)
+            {
+                corrupted++;
+            }
+            else
+            {
+                /* CyMesh_InsertProxyDataInBearerRx() */
+                libraryCount++;
+            }
+        }
+
+        received += rxRingCount + ((libraryCount < SIM_LIBRARY_RX_ENTRIES) ? libraryCount : SIM_LIBRARY_RX_ENTRIES);
+    }
+
+    *lost = (written != 0u) ? (100.0 * (written - received) / written) : 0.0;
+
+    return received * 1000.0 / SIM_DURATION_MS;
+}
+
+
+int main(void)
+{
+    bool isOk = true;
+    uint32 i;
+    uint32 j;
+    uint32 mode;
+
+    printf("%u s per run, connection interval %u us, PDUs of %u to %u bytes notified %u times, %u ms apart\n",
+           SIM_DURATION_MS / 1000u, SIM_CONN_INTERVAL_US, SIM_PDU_MIN_LENGTH,
+           SIM_PDU_MIN_LENGTH + SIM_PDU_LENGTHS - 1u, SIM_COPIES, SIM_COPY_GAP_MS);
+    printf("proxy queue %u, recent %u, notifications of at most %u bytes\n\n", CYMESH_BEARER_PROXY_QUEUE_SIZE,
+           CYMESH_BEARER_PROXY_RECENT_SIZE, CYMESH_BEARER_GATT_MAX_DATA_LENGTH);
+
+    printf("TX, node to client\n");
+    printf("%-4s %4s %5s %6s |", "mtu", "bufs", "ll/ev", "load/s");
+    for(mode = 0u; mode < SIM_MODE_COUNT; mode++)
+    {
+        printf(" %9s %6s %6s |", simModeNames[mode], "lost", "p50 ms");
+    }
+    printf("\n");
+
+    for(i = 0u; i < SIM_LINK_COUNT; i++)
+    {
+        for(j = 0u; j < SIM_LOAD_COUNT; j++)
+        {
+            double rate[SIM_MODE_COUNT];
+
+            printf("%-4u %4u %5u %6u |", simLinks[i].mtu, simLinks[i].buffers, simLinks[i].llPerEvent, simLoads[j]);
+            for(mode = 0u; mode < SIM_MODE_COUNT; mode++)
+            {
+                double lost;
+                double p50;
+
+                if(TxRun(&simLinks[i], simLoads[j], (SIM_MODE_T)mode, &rate[mode], &lost, &p50) == false)
+                {
+                    printf(" lost track of a PDU\n");
+                    isOk = false;
+                }
+                printf(" %9.1f %5.1f%% %6.0f |", rate[mode], lost, p50);
+            }
+            printf("\n");
+            if(rate[SIM_MODE_AGGREGATE] < rate[SIM_MODE_SINGLE])
+            {
+                isOk = false;
+            }
+        }
+    }
+
+    printf("\nRX, client to node, writes all the time\n");
+    printf("%-4s %5s | %9s %6s | %9s %6s\n", "mtu", "ll/ev", "single", "lost", "aggregate", "lost");
+    for(i = 0u; i < SIM_LINK_COUNT; i++)
+    {
+        double singleLost;
+        double aggregateLost;
+        double single;
+        double aggregate;
+
+        /* The stack buffers only hold notifications */
+        if((i != 0u) && (simLinks[i].mtu == simLinks[i - 1u].mtu) &&
+           (simLinks[i].llPerEvent == simLinks[i - 1u].llPerEvent))
+        {
+            continue;
+        }
+        single = RxRun(&simLinks[i], false, &singleLost);
+        aggregate = RxRun(&simLinks[i], true, &aggregateLost);
+        printf("%-4u %5u | %9.1f %5.1f%% | %9.1f %5.1f%%\n", simLinks[i].mtu, simLinks[i].llPerEvent, single,
+               singleLost, aggregate, aggregateLost);
+        if((aggregate < single) || (cyMesh_BearerProxyStats.malformed != 0u))
+        {
+            isOk = false;
+        }
+    }
+
+    printf("corrupted PDUs: %u\n", corrupted);
+
+    return ((isOk == true) && (corrupted == 0u)) ? 0 : 1;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,307 @@
+/*******************************************************************************
+* Benchmark of Firmware_Mesh/SM Files/CyMesh_MessageQueueIndex.c.
+*
+* Runs the TX message queue of CyMesh_MessageQueue.c at a given fill: for
+* each status, the entry of its TID is matched and freed, and a new message
+* takes a free entry with the next TID. The cycles of the match and of the
+* free entry lookup are measured with the TID index and with the walk of the
+* queue of the library, for queues of 10 (the library), 32 and 128 entries;
+* past 63 entries in use, TIDs repeat and are chained. As the host predicts
+* short walks well, the entries looked at per status, which the time on the
+* Cortex-M0 follows, are counted too. Each match is also checked to be an
+* entry of the TID. From the repository root:
+*
+*   gcc -O2 -I Tools/network_bench -I "Firmware_Mesh/SM Files" -o queue_bench \
+*       Tools/network_bench/queue_bench.c "Firmware_Mesh/SM Files/CyMesh_MessageQueueIndex.c" && ./queue_bench
+*
+* Cycles are only reported on x86 (TSC).
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <project.h>
+#include "CyMesh_MessageQueueIndex.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define BENCH_CYCLES()      (__rdtsc())
+#else
+    #define BENCH_CYCLES()      (0ull)
+#endif
+
+#define BENCH_STATUSES          (200000u)
+#define BENCH_REPEAT            (5u)    /* The fastest of these runs is reported */
+#define BENCH_SEED              (1u)
+#define BENCH_MAX_SIZE          (128u)
+#define BENCH_MIN_TID           (1u)    /* CYMESH_DEVICE_MIN_TRANSACTION_ID */
+#define BENCH_MAX_TID           (63u)   /* CYMESH_DEVICE_MAX_TRANSACTION_ID */
+
+typedef struct
+{
+    uint8 size;
+    uint8 percentFull;
+} BENCH_QUEUE_T;
+
+static const BENCH_QUEUE_T benchQueues[] =
+{
+    {  10u,  50u },
+    {  10u, 100u },
+    {  32u,  50u },
+    {  32u, 100u },
+    { 128u,  50u },
+    { 128u, 100u },
+};
+
+#define BENCH_QUEUE_COUNT       (sizeof(benchQueues) / sizeof(benchQueues[0]))
+
+/* The fields of CYMESH_TX_MESSAGE_NODE_T the library walks */
+typedef struct
+{
+    uint8 identifier;
+    bool isAvailable;
+} BENCH_NODE_T;
+
+static BENCH_NODE_T node[BENCH_MAX_SIZE];
+static uint8 indexNext[BENCH_MAX_SIZE];
+static uint8 indexReleased[BENCH_MAX_SIZE];
+static CYMESH_MESSAGE_Q_INDEX_STRUCT index =
+    CYMESH_MESSAGE_Q_INDEX_INIT(indexNext, indexReleased, BENCH_MAX_SIZE);
+
+/* Entries in use, in the order the statuses come */
+static uint8 used[BENCH_MAX_SIZE];
+static uint8 statusEntry[BENCH_STATUSES];
+
+static uint8 tid;
+static uint32 mismatches;
+
+/* Entries and index links looked at in the untimed run */
+static uint32 steps;
+
+
+static uint8 NextTid(void)
+{
+    tid = (tid >= BENCH_MAX_TID) ? BENCH_MIN_TID : (tid + 1u);
+
+    return tid;
+}
+
+
+/* CyMesh_GetTxQueueMatch() of the library */
+static uint8 LinearMatch(uint8 size, uint8 matchTid)
+{
+    uint8 i;
+
+    for(i = 0u; i < size; i++)
+    {
+        if((node[i].isAvailable == false) && (node[i].identifier == matchTid))
+        {
+            return i;
+        }
+    }
+
+    return CYMESH_MESSAGE_Q_INDEX_NONE;
+}
+
+
+/* Entries the walk or the index looks at to match matchTid and take a free
+ * entry; not timed */
+static uint32 CountSteps(uint8 size, uint8 matchTid, bool isIndexed)
+{
+    uint32 count = 0u;
+    uint8 i;
+
+    if(isIndexed == false)
+    {
+        for(i = 0u; (i < size) && ((node[i].isAvailable == true) || (node[i].identifier != matchTid)); i++)
+        {
+            count++;
+        }
+        for(i = 0u; (i < size) && (node[i].isAvailable == false); i++)
+        {
+            count++;
+        }
+
+        return count + 2u;
+    }
+
+    /* Head, chain up to the match, free entry on top of the stack, and the
+     * chain of the new TID the entry is appended to */
+    for(i = CyMesh_MessageQueueIndexFirst(&index, matchTid); node[i].identifier != matchTid;
+        i = CyMesh_MessageQueueIndexNext(&index, i))
+    {
+        count++;
+    }
+    for(i = CyMesh_MessageQueueIndexFirst(&index, (tid >= BENCH_MAX_TID) ? BENCH_MIN_TID : (tid + 1u));
+        i != CYMESH_MESSAGE_Q_INDEX_NONE; i = CyMesh_MessageQueueIndexNext(&index, i))
+    {
+        count++;
+    }
+
+    return count + 3u;
+}
+
+
+/* CyMesh_IsTxMessageQueueFree() of the library */
+static uint8 LinearFree(uint8 size)
+{
+    uint8 i;
+
+    for(i = 0u; i < size; i++)
+    {
+        if(node[i].isAvailable == true)
+        {
+            return i;
+        }
+    }
+
+    return CYMESH_MESSAGE_Q_INDEX_NONE;
+}
+
+
+static uint8 IndexMatch(uint8 matchTid)
+{
+    uint8 i;
+
+    for(i = CyMesh_MessageQueueIndexFirst(&index, matchTid); i != CYMESH_MESSAGE_Q_INDEX_NONE;
+        i = CyMesh_MessageQueueIndexNext(&index, i))
+    {
+        if(node[i].identifier == matchTid)
+        {
+            return i;
+        }
+    }
+
+    return CYMESH_MESSAGE_Q_INDEX_NONE;
+}
+
+
+static void Take(uint8 entry, bool isIndexed)
+{
+    node[entry].identifier = NextTid();
+    node[entry].isAvailable = false;
+    if(isIndexed == true)
+    {
+        (void)CyMesh_MessageQueueIndexTake(&index, entry, node[entry].identifier);
+    }
+}
+
+
+/* Fills the queue and draws the entry each status frees: one of the entries
+ * in use, which the new message then takes */
+static uint8 Fill(const BENCH_QUEUE_T * queue)
+{
+    uint8 count = (uint8)((queue->size * queue->percentFull) / 100u);
+    uint32 status;
+    uint8 i;
+
+    index.size = queue->size;
+    CyMesh_MessageQueueIndexReset(&index);
+    for(i = 0u; i < queue->size; i++)
+    {
+        node[i].isAvailable = true;
+    }
+
+    srand(BENCH_SEED + queue->size + queue->percentFull);
+    tid = 0u;
+    for(i = 0u; i < count; i++)
+    {
+        used[i] = CyMesh_MessageQueueIndexGetFree(&index);
+        Take(used[i], true);
+    }
+    for(status = 0u; status < BENCH_STATUSES; status++)
+    {
+        statusEntry[status] = (uint8)(rand() % count);
+    }
+
+    return count;
+}
+
+
+static double Run(const BENCH_QUEUE_T * queue, bool isIndexed, double * stepsPerStatus)
+{
+    unsigned long long best = ~0ull;
+    uint32 repeat;
+
+    /* The first run counts the steps, checks the matches and is not timed */
+    steps = 0u;
+    for(repeat = 0u; repeat <= BENCH_REPEAT; repeat++)
+    {
+        unsigned long long start;
+        unsigned long long cycles;
+        uint32 status;
+
+        (void)Fill(queue);
+        start = BENCH_CYCLES();
+        for(status = 0u; status < BENCH_STATUSES; status++)
+        {
+            uint8 * slot = &used[statusEntry[status]];
+            uint8 matchTid = node[*slot].identifier;
+            uint8 entry;
+
+            if(repeat == 0u)
+            {
+                steps += CountSteps(queue->size, matchTid, isIndexed);
+            }
+
+            if(isIndexed == true)
+            {
+                entry = IndexMatch(matchTid);
+                /* TIDs in use more than once are matched oldest first rather
+                 * than lowest entry first; both are entries of the TID */
+                if((repeat == 0u) &&
+                   ((entry == CYMESH_MESSAGE_Q_INDEX_NONE) || (node[entry].identifier != matchTid)))
+                {
+                    mismatches++;
+                }
+                (void)CyMesh_MessageQueueIndexRelease(&index, entry, matchTid);
+                node[entry].isAvailable = true;
+                *slot = CyMesh_MessageQueueIndexGetFree(&index);
+            }
+            else
+            {
+                entry = LinearMatch(queue->size, matchTid);
+                node[entry].isAvailable = true;
+                *slot = LinearFree(queue->size);
+            }
+            Take(*slot, isIndexed);
+        }
+        cycles = BENCH_CYCLES() - start;
+        if((repeat != 0u) && (cycles < best))
+        {
+            best = cycles;
+        }
+    }
+
+    *stepsPerStatus = (double)steps / BENCH_STATUSES;
+
+    return (double)best / BENCH_STATUSES;
+}
+
+
+int main(void)
+{
+    uint32 i;
+
+    printf("%u statuses, index of %u bytes + 2 bytes per entry\n", BENCH_STATUSES,
+           (unsigned int)CYMESH_MESSAGE_Q_INDEX_TID_COUNT);
+    printf("%-7s %6s %7s | %10s %10s | %10s %10s\n", "entries", "full", "in use", "walk steps", "index", "walk cyc",
+           "index");
+
+    for(i = 0u; i < BENCH_QUEUE_COUNT; i++)
+    {
+        double linearSteps;
+        double indexedSteps;
+        double linear;
+        double indexed;
+        uint8 count = Fill(&benchQueues[i]);
+
+        linear = Run(&benchQueues[i], false, &linearSteps);
+        indexed = Run(&benchQueues[i], true, &indexedSteps);
+        printf("%-7u %5u%% %7u | %10.1f %10.1f | %10.1f %10.1f\n", benchQueues[i].size, benchQueues[i].percentFull,
+               count, linearSteps, indexedSteps, linear, indexed);
+    }
+    printf("index matches of another TID: %u\n", mismatches);
+
+    return mismatches != 0u;
+}
+
+/* [] END OF FILE */
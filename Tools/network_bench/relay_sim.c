@@ -0,0 +1,382 @@
+/*******************************************************************************
+* Relay policy simulation of Firmware_Mesh/SM Files/CyMesh_NetworkFlood.c.
+*
+* Nodes are placed at random in a square and every node relays, as
+* CyMesh_ProcessNetworkPacket() does: a PDU that is not in the node's message
+* cache is added and queued with CyMesh_NetworkFloodAdd(), at the RSSI of a
+* log-distance path loss of -90 dBm at the edge of the range with a few dB of
+* fading. A copy that is in the cache goes to CyMesh_NetworkFloodHeard(). The
+* SM timer is modelled by a CyMesh_NetworkFloodTake() at the due ms, after
+* which the library bearer waits its random delay of up to 8 ms.
+*
+* An advertisement takes SIM_AIR_US. A receiver loses it if another
+* neighbour, or the receiver itself, transmits at an overlapping time. Floods
+* are run one at a time from random sources; the delivered ratio is the share
+* of the other nodes that received the PDU, tx/msg the transmissions of a
+* flood, the source included, and ms the time the last node received it.
+*
+* The policy is a build option. CYMESH_NET_FLOOD_BACKOFF_MS=0,
+* CYMESH_NET_FLOOD_SUPPRESS_COUNT=0 and CYMESH_NET_FLOOD_RSSI_MS=0 is plain
+* flooding: every node relays on the next tick. From the repository root:
+*
+*   for policy in "0 0 0" "20 0 0" "20 2 0" "20 3 0" "20 2 20" "20 3 20"; do
+*       set -- $policy
+*       gcc -O2 -DCYMESH_NET_FLOOD_BACKOFF_MS=$1 -DCYMESH_NET_FLOOD_SUPPRESS_COUNT=$2 \
+*           -DCYMESH_NET_FLOOD_RSSI_MS=$3 -I Tools/network_bench -I "Firmware_Mesh/SM Files" \
+*           -o relay_sim Tools/network_bench/relay_sim.c "Firmware_Mesh/SM Files/CyMesh_NetworkFlood.c" \
+*           "Firmware_Mesh/SM Files/CyMesh_NetworkCache.c" -lm &&
+*       ./relay_sim "$policy"
+*   done
+*
+* Any argument suppresses the table header.
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <project.h>
+#include "CyMesh_NetworkCache.h"
+#include "CyMesh_NetworkFlood.h"
+
+#define SIM_MAX_NODES           (500u)
+#define SIM_AREA                (100.0)     /* Side of the square */
+#define SIM_RANGE               (18.0)      /* Radio range, -90 dBm */
+#define SIM_RSSI_EDGE           (-90.0)
+#define SIM_PATH_LOSS           (20.0)      /* dB per decade of distance */
+#define SIM_FADING_DB           (4u)        /* Uniform, +-dB */
+#define SIM_TTL                 (10u)
+#define SIM_AIR_US              (400u)      /* One advertising event */
+#define SIM_PROCESS_US          (1500u)     /* Network layer, before the relay is queued */
+#define SIM_BEARER_DELAY_US     (250u)      /* Library bearer delay, 0 to 31 of these */
+#define SIM_FLOODS              (200u)
+#define SIM_SEED                (1u)
+#define SIM_MAX_EVENTS          (SIM_MAX_NODES * 4u)
+
+static const uint16 simNodeCounts[] = { 100u, 500u };
+
+#define SIM_NODE_COUNT_COUNT    (sizeof(simNodeCounts) / sizeof(simNodeCounts[0]))
+
+typedef enum
+{
+    SIM_TX_START,
+    SIM_TX_END,
+    SIM_TAKE
+} SIM_EVENT_TYPE_T;
+
+typedef struct
+{
+    uint32 time;
+    uint8 type;
+    uint16 node;
+    uint16 tx;
+} SIM_EVENT_T;
+
+typedef struct
+{
+    uint32 time;
+    uint16 node;
+    uint8 ttl;
+} SIM_TX_T;
+
+static uint16 nodes;
+static double nodeX[SIM_MAX_NODES];
+static double nodeY[SIM_MAX_NODES];
+static uint16 neighbours[SIM_MAX_NODES][SIM_MAX_NODES];
+static uint16 neighbourCount[SIM_MAX_NODES];
+static uint8 isNeighbour[SIM_MAX_NODES][SIM_MAX_NODES];
+static CYMESH_NET_MSG_CACHE_STRUCT caches[SIM_MAX_NODES];
+static CYMESH_NET_FLOOD_STRUCT floods[SIM_MAX_NODES];
+static uint8 isReceived[SIM_MAX_NODES];
+static uint32 lastReceivedUs;
+
+/* Transmissions of the current flood, in start order */
+static SIM_TX_T txs[SIM_MAX_NODES * 2u];
+static uint32 txCount;
+
+/* Events waiting for their time, a binary min-heap */
+static SIM_EVENT_T events[SIM_MAX_EVENTS];
+static uint32 eventCount;
+
+
+static uint32 Random(uint32 limit)
+{
+    return (uint32)rand() % limit;
+}
+
+
+static void Push(uint32 time, SIM_EVENT_TYPE_T type, uint16 node, uint16 tx)
+{
+    SIM_EVENT_T event = { time, (uint8)type, node, tx };
+    uint32 i = eventCount++;
+
+    if(eventCount > SIM_MAX_EVENTS)
+    {
+        fprintf(stderr, "event queue full\n");
+        exit(1);
+    }
+
+    while((i > 0u) && (events[(i - 1u) / 2u].time > event.time))
+    {
+        events[i] = events[(i - 1u) / 2u];
+        i = (i - 1u) / 2u;
+    }
+    events[i] = event;
+}
+
+
+static SIM_EVENT_T Pop(void)
+{
+    SIM_EVENT_T top = events[0];
+    SIM_EVENT_T last = events[--eventCount];
+    uint32 i = 0u;
+
+    for(;;)
+    {
+        uint32 child = (2u * i) + 1u;
+
+        if(child >= eventCount)
+        {
+            break;
+        }
+        if(((child + 1u) < eventCount) && (events[child + 1u].time < events[child].time))
+        {
+            child++;
+        }
+        if(events[child].time >= last.time)
+        {
+            break;
+        }
+        events[i] = events[child];
+        i = child;
+    }
+    events[i] = last;
+    return top;
+}
+
+
+static void PlaceNodes(uint16 count)
+{
+    uint16 i;
+    uint16 j;
+
+    nodes = count;
+    srand(SIM_SEED);
+    for(i = 0; i < nodes; i++)
+    {
+        nodeX[i] = SIM_AREA * Random(10000u) / 10000.0;
+        nodeY[i] = SIM_AREA * Random(10000u) / 10000.0;
+    }
+
+    for(i = 0; i < nodes; i++)
+    {
+        neighbourCount[i] = 0u;
+        for(j = 0; j < nodes; j++)
+        {
+            isNeighbour[i][j] = (uint8)((i != j) && (hypot(nodeX[i] - nodeX[j], nodeY[i] - nodeY[j]) <= SIM_RANGE));
+            if(isNeighbour[i][j] != 0u)
+            {
+                neighbours[i][neighbourCount[i]++] = j;
+            }
+        }
+    }
+}
+
+
+static int8 Rssi(uint16 from, uint16 to)
+{
+    double distance = hypot(nodeX[from] - nodeX[to], nodeY[from] - nodeY[to]);
+    double rssi = SIM_RSSI_EDGE + (SIM_PATH_LOSS * log10(SIM_RANGE / ((distance < 0.1) ? 0.1 : distance)));
+
+    rssi += (double)Random((2u * SIM_FADING_DB) + 1u) - SIM_FADING_DB;
+
+    return (int8)((rssi > -20.0) ? -20.0 : rssi);
+}
+
+
+/* A transmission of node is ready at time; the bearer adds its delay */
+static void Send(uint16 node, uint32 time, uint8 ttl)
+{
+    SIM_TX_T * tx = &txs[txCount];
+
+    tx->time = time + (Random(32u) * SIM_BEARER_DELAY_US);
+    tx->node = node;
+    tx->ttl = ttl;
+    Push(tx->time, SIM_TX_START, node, (uint16)txCount);
+    txCount++;
+}
+
+
+/* Another transmission that a receiver hears at the same time, or its own */
+static bool IsCollision(uint32 k, uint16 receiver)
+{
+    uint32 m;
+
+    for(m = 0u; m < txCount; m++)
+    {
+        const SIM_TX_T * tx = &txs[m];
+
+        if((m != k) && ((tx->time + SIM_AIR_US) > txs[k].time) && (tx->time < (txs[k].time + SIM_AIR_US)) &&
+           ((tx->node == receiver) || (isNeighbour[tx->node][receiver] != 0u)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+static void Receive(uint32 k, uint16 node, uint16 src, uint32 seq)
+{
+    uint32 readyUs = txs[k].time + SIM_AIR_US + SIM_PROCESS_US;
+    uint8 pdu = txs[k].ttl - 1u;
+    uint8 i;
+
+    if(CyMesh_NetworkCacheFind(&caches[node], src, seq) == true)
+    {
+        CyMesh_NetworkFloodHeard(&floods[node], src, seq);
+        return;
+    }
+    CyMesh_NetworkCacheAdd(&caches[node], src, seq);
+    isReceived[node] = 1u;
+    lastReceivedUs = txs[k].time + SIM_AIR_US;
+
+    if(txs[k].ttl < 2u)
+    {
+        return;
+    }
+
+    if(CyMesh_NetworkFloodAdd(&floods[node], src, seq, &pdu, 1u, Rssi(txs[k].node, node), readyUs / 1000u) == false)
+    {
+        Send(node, readyUs, pdu);
+        return;
+    }
+
+    /* The SM timer tick the relay is due at */
+    for(i = 0u; i < CYMESH_NET_FLOOD_SIZE; i++)
+    {
+        if((floods[node].entry[i].src == src) && (floods[node].entry[i].seq == seq))
+        {
+            Push(floods[node].entry[i].due * 1000u, SIM_TAKE, node, 0u);
+        }
+    }
+}
+
+
+/* Runs one flood; returns the nodes reached and adds its transmissions and
+ * duration */
+static uint32 Flood(uint16 source, uint32 seq, uint32 * transmissions, uint32 * durationUs)
+{
+    uint16 src = source + 1u;
+    uint32 reached = 0u;
+    uint16 i;
+
+    txCount = 0u;
+    eventCount = 0u;
+    memset(isReceived, 0, sizeof(isReceived));
+    lastReceivedUs = 0u;
+    CyMesh_NetworkCacheAdd(&caches[source], src, seq);
+    Send(source, 0u, SIM_TTL);
+
+    while(eventCount > 0u)
+    {
+        SIM_EVENT_T event = Pop();
+
+        if(event.type == SIM_TX_START)
+        {
+            Push(event.time + SIM_AIR_US, SIM_TX_END, event.node, event.tx);
+        }
+        else if(event.type == SIM_TX_END)
+        {
+            for(i = 0; i < neighbourCount[event.node]; i++)
+            {
+                uint16 node = neighbours[event.node][i];
+
+                if(IsCollision(event.tx, node) == false)
+                {
+                    Receive(event.tx, node, src, seq);
+                }
+            }
+        }
+        else
+        {
+            uint8 pdu[CYMESH_NET_FLOOD_PDU_SIZE];
+
+            /* Nothing is due if the relay was cancelled */
+            while(CyMesh_NetworkFloodTake(&floods[event.node], event.time / 1000u, pdu) != 0u)
+            {
+                Send(event.node, event.time, pdu[0]);
+            }
+        }
+    }
+
+    for(i = 0; i < nodes; i++)
+    {
+        reached += isReceived[i];
+    }
+    *transmissions += txCount;
+    *durationUs += lastReceivedUs;
+
+    return reached - isReceived[source];
+}
+
+
+static void Simulate(uint16 count, double * delivered, double * transmissions, double * duration)
+{
+    uint32 reached = 0u;
+    uint32 txTotal = 0u;
+    uint32 durationUs = 0u;
+    uint32 flood;
+    uint16 i;
+
+    PlaceNodes(count);
+    for(i = 0; i < nodes; i++)
+    {
+        CyMesh_NetworkCacheInit(&caches[i]);
+        CyMesh_NetworkFloodInit(&floods[i], ((uint32)i * 0x9E3779B1u) + SIM_SEED);
+    }
+
+    srand(SIM_SEED + count);
+    for(flood = 0u; flood < SIM_FLOODS; flood++)
+    {
+        reached += Flood((uint16)Random(nodes), flood + 1u, &txTotal, &durationUs);
+    }
+
+    *delivered = 100.0 * reached / ((double)SIM_FLOODS * (nodes - 1u));
+    *transmissions = (double)txTotal / SIM_FLOODS;
+    *duration = durationUs / (1000.0 * SIM_FLOODS);
+}
+
+
+int main(int argc, char * argv[])
+{
+    uint32 i;
+
+    if(argc < 2)
+    {
+        printf("back-off 0-B ms, cancelled after k copies, R ms more from %d to %d dBm; TTL %u, %u floods\n",
+               CYMESH_NET_FLOOD_RSSI_FAR, CYMESH_NET_FLOOD_RSSI_NEAR, SIM_TTL, SIM_FLOODS);
+        printf("%-10s", "B k R");
+        for(i = 0; i < SIM_NODE_COUNT_COUNT; i++)
+        {
+            printf(" | %3u nodes: delivered tx/msg     ms", simNodeCounts[i]);
+        }
+        printf("\n");
+    }
+
+    printf("%-10s", (argc < 2) ? "" : argv[1]);
+    for(i = 0; i < SIM_NODE_COUNT_COUNT; i++)
+    {
+        double delivered;
+        double transmissions;
+        double duration;
+
+        Simulate(simNodeCounts[i], &delivered, &transmissions, &duration);
+        printf(" | %19.1f%% %6.1f %6.1f", delivered, transmissions, duration);
+        fflush(stdout);
+    }
+    printf("\n");
+
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,186 @@
+/*******************************************************************************
+* Benchmark of Firmware_Mesh/SM Files/CyMesh_NetworkReplay.c.
+*
+* Fills the replay protection list with 100 and with 1000 random unicast
+* sources and measures CyMesh_NetworkReplayAccept() per packet for a message
+* from a random known source, for a replayed one, and, when the sources fill
+* the list, for a message from a new source, which drops the least recently
+* used one. A linear scan of the same entries is measured for comparison. The
+* list size is a build option; from the repository root:
+*
+*   for size in 100 1000; do
+*       gcc -O2 -DCYMESH_NET_REPLAY_LIST_SIZE=$size -I Tools/network_bench -I "Firmware_Mesh/SM Files" \
+*           -o replay_bench Tools/network_bench/replay_bench.c "Firmware_Mesh/SM Files/CyMesh_NetworkReplay.c" &&
+*       ./replay_bench
+*   done
+*
+* Cycles are only reported on x86 (TSC).
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <project.h>
+#include "CyMesh_NetworkReplay.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define BENCH_CYCLES()      (__rdtsc())
+#else
+    #define BENCH_CYCLES()      (0ull)
+#endif
+
+#define BENCH_PACKETS           (100000u)
+#define BENCH_REPEAT            (5u)    /* The fastest of these runs is reported */
+#define BENCH_SEED              (1u)
+#define BENCH_UNICAST_LIMIT     (0x8000u)
+
+typedef enum
+{
+    BENCH_ACCEPT,               /* Next SEQ of a known source */
+    BENCH_REPLAY,               /* Old SEQ of a known source */
+    BENCH_NEW_SOURCE,           /* Source not in the full list */
+    BENCH_LINEAR,               /* Linear scan for a known source */
+
+    BENCH_CASE_COUNT
+} BENCH_CASE_T;
+
+static const uint16 benchSources[] = { 100u, 1000u };
+
+#define BENCH_SOURCE_COUNT      (sizeof(benchSources) / sizeof(benchSources[0]))
+
+static CYMESH_NET_REPLAY_STRUCT replay;
+static uint16 sources[BENCH_UNICAST_LIMIT];
+static uint16 packetSources[BENCH_PACKETS];
+static uint32 packetSeq[BENCH_PACKETS];
+
+/* Unsorted copy of the list for the linear scan */
+static uint16 linearSrc[CYMESH_NET_REPLAY_LIST_SIZE];
+static uint32 linearSeq[CYMESH_NET_REPLAY_LIST_SIZE];
+
+
+static bool LinearAccept(uint16 count, uint16 src, uint32 seq)
+{
+    uint16 i;
+
+    for(i = 0; i < count; i++)
+    {
+        if(linearSrc[i] == src)
+        {
+            if(seq <= linearSeq[i])
+            {
+                return false;
+            }
+            linearSeq[i] = seq;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/* Shuffles the unicast addresses; the first count are the known sources */
+static void Fill(uint16 count)
+{
+    uint32 i;
+
+    for(i = 0; i < BENCH_UNICAST_LIMIT; i++)
+    {
+        sources[i] = (uint16)i;
+    }
+    for(i = BENCH_UNICAST_LIMIT - 1u; i > 1u; i--)
+    {
+        uint32 j = 1u + ((uint32)rand() % i);
+        uint16 swap = sources[i];
+
+        sources[i] = sources[j];
+        sources[j] = swap;
+    }
+
+    CyMesh_NetworkReplayInit(&replay);
+    for(i = 0; i < count; i++)
+    {
+        (void)CyMesh_NetworkReplayAccept(&replay, sources[i + 1u], 1u);
+        linearSrc[i] = sources[i + 1u];
+        linearSeq[i] = 1u;
+    }
+}
+
+
+static unsigned long long Run(BENCH_CASE_T benchCase, uint16 count, uint32 * accepted)
+{
+    unsigned long long best = 0ull;
+    uint32 run;
+    uint32 i;
+
+    for(run = 0; run < BENCH_REPEAT; run++)
+    {
+        unsigned long long cycles;
+
+        Fill(count);
+        for(i = 0; i < BENCH_PACKETS; i++)
+        {
+            packetSources[i] = (benchCase == BENCH_NEW_SOURCE) ? sources[count + 1u + (i % (BENCH_UNICAST_LIMIT - count - 1u))] :
+                                                                 sources[1u + ((uint32)rand() % count)];
+            packetSeq[i] = (benchCase == BENCH_REPLAY) ? 1u : (2u + i);
+        }
+
+        *accepted = 0u;
+        cycles = BENCH_CYCLES();
+        for(i = 0; i < BENCH_PACKETS; i++)
+        {
+            bool isAccepted = (benchCase == BENCH_LINEAR) ?
+                              LinearAccept(count, packetSources[i], packetSeq[i]) :
+                              CyMesh_NetworkReplayAccept(&replay, packetSources[i], packetSeq[i]);
+
+            *accepted += (isAccepted == true) ? 1u : 0u;
+        }
+        cycles = BENCH_CYCLES() - cycles;
+
+        if((run == 0u) || (cycles < best))
+        {
+            best = cycles;
+        }
+    }
+
+    return best;
+}
+
+
+int main(void)
+{
+    static const char * const names[BENCH_CASE_COUNT] = { "accept", "replay", "new source", "linear scan" };
+    uint32 source;
+    uint32 benchCase;
+
+    srand(BENCH_SEED);
+
+    printf("list size %u, %u bytes of RAM\n", (unsigned int)CYMESH_NET_REPLAY_LIST_SIZE,
+           (unsigned int)sizeof(replay));
+    printf("%-12s %8s %12s %10s\n", "case", "sources", "cycles/pkt", "accepted");
+    for(source = 0; source < BENCH_SOURCE_COUNT; source++)
+    {
+        if(benchSources[source] > CYMESH_NET_REPLAY_LIST_SIZE)
+        {
+            continue;
+        }
+
+        for(benchCase = 0; benchCase < BENCH_CASE_COUNT; benchCase++)
+        {
+            uint32 accepted;
+            unsigned long long cycles;
+
+            if((benchCase == BENCH_NEW_SOURCE) && (benchSources[source] != CYMESH_NET_REPLAY_LIST_SIZE))
+            {
+                continue;
+            }
+
+            cycles = Run((BENCH_CASE_T)benchCase, benchSources[source], &accepted);
+
+            printf("%-12s %8u %12.1f %9.0f%%\n", names[benchCase], benchSources[source],
+                   (double)cycles / BENCH_PACKETS, (100.0 * accepted) / BENCH_PACKETS);
+        }
+    }
+
+    return 0;
+}
+
+/* [] END OF FILE */
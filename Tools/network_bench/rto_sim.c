@@ -0,0 +1,199 @@
+/*******************************************************************************
+* Reliable message simulation of Firmware_Mesh/SM Files/CyMesh_MessageQueueRto.c.
+*
+* A client sends reliable messages one after the other to a server a number
+* of hops away, as CyMesh_SchedulePendingTxMessagePackets() does: the message
+* is sent, and sent again when no status came within the timeout, up to
+* cyMesh_retryCount transmissions. A status of any copy completes the
+* message, unless the last copy timed out first. The fixed rows wait
+* cyMesh_AppReliableMsgTimeout (5 s) for every copy, the adaptive rows the
+* timeout of CyMesh_TxRtoGet() and CyMesh_TxRtoBackoff(), with the samples
+* CyMesh_TxMessageQueueFreeUp() passes to CyMesh_TxRtoSample().
+*
+* Each hop of the message and of its status is lost with the given ratio and
+* takes a relay delay of SIM_HOP_DELAY_MIN_MS to SIM_HOP_DELAY_MAX_MS, plus,
+* on SIM_QUEUE_PERCENT of the hops, the wait of a busy bearer queue. Loss is
+* independent between hops, and collisions between the copies of a message
+* are not simulated.
+*
+* The completion time runs from the first transmission to the status. From
+* the repository root:
+*
+*   gcc -O2 -I Tools/network_bench -I "Firmware_Mesh/SM Files" -o rto_sim \
+*       Tools/network_bench/rto_sim.c "Firmware_Mesh/SM Files/CyMesh_MessageQueueRto.c" && ./rto_sim
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <project.h>
+#include "CyMesh_MessageQueueRto.h"
+
+#define SIM_MESSAGES            (5000u)
+#define SIM_TRANSMISSIONS       (3u)        /* CYMESH_TX_MESSAGE_Q_RETRY_COUNT */
+#define SIM_FIXED_TIMEOUT_MS    (5000u)     /* CYMESH_TX_MESSAGE_Q_DEFAULT_TIMEOUT */
+#define SIM_HOP_DELAY_MIN_MS    (5u)
+#define SIM_HOP_DELAY_MAX_MS    (40u)
+#define SIM_QUEUE_PERCENT       (10u)
+#define SIM_QUEUE_DELAY_MAX_MS  (300u)
+#define SIM_MESSAGE_PERIOD_MS   (1000u)     /* Time between two messages */
+#define SIM_SERVER              (0x0010u)
+#define SIM_SEED                (1u)
+#define SIM_NEVER               (0xFFFFFFFFu)
+
+typedef struct
+{
+    uint8 hops;
+    uint8 lossPercent;
+} SIM_PATH_T;
+
+static const SIM_PATH_T simPaths[] =
+{
+    {  2u,  2u },
+    {  2u, 10u },
+    { 10u,  2u },
+    { 10u,  5u },
+};
+
+#define SIM_PATH_COUNT          (sizeof(simPaths) / sizeof(simPaths[0]))
+
+static uint32 completion[SIM_MESSAGES];
+
+
+static uint32 Random(uint32 limit)
+{
+    return (uint32)rand() % limit;
+}
+
+
+/* Time the message or status takes over the path, SIM_NEVER if it is lost */
+static uint32 Traverse(const SIM_PATH_T * path)
+{
+    uint32 delay = 0u;
+    uint8 hop;
+
+    for(hop = 0u; hop < path->hops; hop++)
+    {
+        if(Random(100u) < path->lossPercent)
+        {
+            return SIM_NEVER;
+        }
+        delay += SIM_HOP_DELAY_MIN_MS + Random(SIM_HOP_DELAY_MAX_MS - SIM_HOP_DELAY_MIN_MS + 1u);
+        if(Random(100u) < SIM_QUEUE_PERCENT)
+        {
+            delay += Random(SIM_QUEUE_DELAY_MAX_MS + 1u);
+        }
+    }
+
+    return delay;
+}
+
+
+static int CompareTime(const void * a, const void * b)
+{
+    uint32 x = *(const uint32 *)a;
+    uint32 y = *(const uint32 *)b;
+
+    return (x > y) - (x < y);
+}
+
+
+static void Simulate(const SIM_PATH_T * path, bool isAdaptive)
+{
+    CYMESH_TX_RTO_STRUCT rto;
+    uint32 completed = 0u;
+    uint32 transmissions = 0u;
+    uint32 now = 0u;
+    uint32 message;
+
+    CyMesh_TxRtoInit(&rto, SIM_SEED);
+    srand(SIM_SEED + path->hops + path->lossPercent);
+
+    for(message = 0u; message < SIM_MESSAGES; message++)
+    {
+        uint32 sent = now;
+        uint32 timeout = SIM_FIXED_TIMEOUT_MS;
+        uint32 status = SIM_NEVER;
+        uint32 end;
+        uint8 copies = 0u;
+
+        if(isAdaptive == true)
+        {
+            timeout = CyMesh_TxRtoGet(&rto, SIM_SERVER, SIM_FIXED_TIMEOUT_MS, now);
+        }
+
+        for(;;)
+        {
+            uint32 there = Traverse(path);
+            uint32 back = (there == SIM_NEVER) ? SIM_NEVER : Traverse(path);
+
+            copies++;
+            if((back != SIM_NEVER) && ((sent + there + back) < status))
+            {
+                status = sent + there + back;
+            }
+
+            end = sent + timeout;
+            if((status <= end) || (copies == SIM_TRANSMISSIONS))
+            {
+                break;
+            }
+
+            sent = end;
+            if(isAdaptive == true)
+            {
+                timeout = CyMesh_TxRtoBackoff(&rto, SIM_SERVER, timeout);
+            }
+        }
+        transmissions += copies;
+
+        if(status <= end)
+        {
+            /* The status is timed from the last transmission before it */
+            if((isAdaptive == true) && (copies == 1u))
+            {
+                (void)CyMesh_TxRtoSample(&rto, SIM_SERVER, status - sent);
+            }
+            completion[completed++] = status - now;
+            end = status;
+        }
+
+        now = (end > (now + SIM_MESSAGE_PERIOD_MS)) ? end : (now + SIM_MESSAGE_PERIOD_MS);
+    }
+
+    qsort(completion, completed, sizeof(completion[0]), CompareTime);
+    printf(" | %7.2f%% %5.2f", 100.0 * completed / SIM_MESSAGES, (double)transmissions / SIM_MESSAGES);
+    if(completed == 0u)
+    {
+        printf(" %6s %6s %6s\n", "-", "-", "-");
+        return;
+    }
+    printf(" %6u %6u %6u\n", completion[completed / 2u], completion[(completed * 9u) / 10u],
+           completion[(completed * 99u) / 100u]);
+}
+
+
+int main(void)
+{
+    uint32 i;
+
+    printf("%u reliable messages, %u transmissions, hop delay %u-%u ms + %u%% queued up to %u ms\n",
+           SIM_MESSAGES, SIM_TRANSMISSIONS, SIM_HOP_DELAY_MIN_MS, SIM_HOP_DELAY_MAX_MS, SIM_QUEUE_PERCENT,
+           SIM_QUEUE_DELAY_MAX_MS);
+    printf("RTO %u-%u ms, back-off limit %u, jitter %u%%\n", CYMESH_TX_RTO_MIN_MS, CYMESH_TX_RTO_MAX_MS,
+           CYMESH_TX_RTO_BACKOFF_LIMIT, CYMESH_TX_RTO_JITTER_PERCENT);
+    printf("%-4s %-5s %-8s | %8s %5s %6s %6s %6s\n", "hops", "loss", "timeout", "done", "tx", "p50 ms", "p90 ms",
+           "p99 ms");
+
+    for(i = 0u; i < SIM_PATH_COUNT; i++)
+    {
+        printf("%-4u %4u%% %-8s", simPaths[i].hops, simPaths[i].lossPercent, "fixed");
+        Simulate(&simPaths[i], false);
+        printf("%-4u %4u%% %-8s", simPaths[i].hops, simPaths[i].lossPercent, "adaptive");
+        Simulate(&simPaths[i], true);
+    }
+
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,553 @@
+/*******************************************************************************
+* Segmentation simulation of Firmware_Mesh/SM Files/CyMesh_TransportSar.c.
+*
+* A source sends messages of 32, 64 and 128 bytes to a destination at the end
+* of a chain of relays, one message after the other. Each node hears its two
+* neighbours only. Every node relays a PDU the first time it hears it, as
+* CyMesh_ProcessNetworkPacket() does, after SIM_PROCESS_US, a random back-off
+* of up to CYMESH_NET_FLOOD_BACKOFF_MS + CYMESH_NET_FLOOD_RSSI_MS and the
+* random delay of the library bearer, and advertises at most once per
+* CYMESH_BEARER_TX_ADV_SLOT_MS from a queue of SIM_QUEUE_SIZE PDUs. An
+* advertisement takes SIM_AIR_US; a node loses it if it transmits itself, or
+* its other neighbour does, at an overlapping time, and the loss of the
+* scenario takes that share of the other receptions.
+*
+* The source and the destination run CyMesh_TransportSarUpdate() as the SM
+* timer does: one segment or block acknowledgement per ms while the queue has
+* room. The ACK timeout is CyMesh_TransportSendSegmented()'s for a TTL of the
+* chain length plus 3.
+*
+* The baseline sends the message as the application layer can today: in
+* 10 byte application messages (a 2 byte opcode in a 12 byte payload), each
+* acknowledged by a status message from the destination, one at a time, and
+* sent again after CYMESH_TX_MESSAGE_Q_DEFAULT_TIMEOUT without the status, up
+* to CYMESH_TX_MESSAGE_Q_RETRY_COUNT times, as the TX message queue does.
+*
+* The back-off lets a relay send the segments of a message out of order. The
+* ends check the SEQ of the PDUs for them with the replay protection list of
+* CyMesh_NetworkReplay.c, as CyMesh_ProcessNetworkPacket() does. The strict
+* rows check instead, at every node and before relaying, that the SEQ is above
+* the highest one heard from the source, as the network layer did before.
+*
+* Per message size: the messages delivered whole, the mean time from the
+* start of a message to its end at the source, the goodput (bytes delivered
+* per second of the run), the transmissions and airtime of all nodes per
+* message delivered, and the PDUs dropped as replays per message. The segment interval is a run time option, so it can be
+* swept. From the repository root:
+*
+*   gcc -O2 -I Tools/network_bench -I "Firmware_Mesh/SM Files" -o sar_sim \
+*       Tools/network_bench/sar_sim.c "Firmware_Mesh/SM Files/CyMesh_TransportSar.c" \
+*       "Firmware_Mesh/SM Files/CyMesh_NetworkReplay.c" &&
+*   ./sar_sim [segment interval ms]
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <project.h>
+#include "CyMesh_TransportSar.h"
+#include "CyMesh_NetworkFlood.h"
+#include "CyMesh_NetworkReplay.h"
+
+#define SIM_MESSAGES            (100u)      /* Per size and scheme */
+#define SIM_MAX_NODES           (8u)
+#define SIM_STEP_US             (100u)
+#define SIM_TICK_US             (1000u)     /* SM timer */
+#define SIM_AIR_US              (400u)      /* One advertising event */
+#define SIM_PROCESS_US          (1500u)     /* Network layer, before the relay is queued */
+#define SIM_FLOOD_DELAY_US      ((CYMESH_NET_FLOOD_BACKOFF_MS + CYMESH_NET_FLOOD_RSSI_MS) * 1000u)
+#define SIM_BEARER_DELAY_US     (250u)      /* Library bearer delay, 0 to 31 of these */
+#define SIM_ADV_SLOT_US         (5000u)     /* CYMESH_BEARER_TX_ADV_SLOT_MS */
+#define SIM_QUEUE_SIZE          (10u)
+#define SIM_TTL_MARGIN          (3u)
+#define SIM_BASE_DATA_LEN       (10u)
+#define SIM_BASE_RETRY_US       (5000000u)  /* CYMESH_TX_MESSAGE_Q_DEFAULT_TIMEOUT */
+#define SIM_BASE_RETRIES        (3u)        /* CYMESH_TX_MESSAGE_Q_RETRY_COUNT */
+#define SIM_MAX_PDUS            (4096u)     /* PDUs kept for the message caches */
+#define SIM_MAX_AIR             (64u)       /* Advertisements on air or just ended */
+#define SIM_SEED                (1u)
+
+typedef struct
+{
+    const char * name;
+    uint8 hops;                 /* Destination hops away from the source */
+    uint8 lossPercent;
+} SIM_SCENARIO_T;
+
+static const SIM_SCENARIO_T simScenarios[] =
+{
+    { "1 hop, 10% loss",  1u, 10u },
+    { "4 hops, 10% loss", 4u, 10u },
+    { "4 hops, 25% loss", 4u, 25u },
+};
+
+static const uint8 simSizes[] = { 32u, 64u, 128u };
+
+#define SIM_SCENARIO_COUNT      (sizeof(simScenarios) / sizeof(simScenarios[0]))
+#define SIM_SIZE_COUNT          (sizeof(simSizes) / sizeof(simSizes[0]))
+
+typedef enum
+{
+    SIM_SCHEME_BASELINE,
+    SIM_SCHEME_SEGMENTED,
+    SIM_SCHEME_STRICT,          /* Segmented, SEQ above the highest at every node */
+    SIM_SCHEME_COUNT
+} SIM_SCHEME_T;
+
+static const char * const simSchemeNames[SIM_SCHEME_COUNT] = { "baseline", "segmented", "strict" };
+
+typedef struct
+{
+    uint16 from;                /* Source node */
+    uint32 seq;
+    uint16 to;                  /* Destination node */
+    uint8 data[CYMESH_TRANSPORT_SAR_PDU_LEN];
+    uint8 length;
+} SIM_PDU_T;
+
+typedef struct
+{
+    uint32 pdu[SIM_QUEUE_SIZE];
+    uint32 release[SIM_QUEUE_SIZE];
+    uint8 head;
+    uint8 count;
+    uint32 nextAdv;             /* Bearer slot */
+    uint32 seen[SIM_MAX_PDUS];  /* Message cache, PDU number + 1 */
+    uint32 seq;                 /* Next SEQ of the node */
+    uint32 highSeq[2];          /* Strict: highest SEQ + 1 of each end */
+    CYMESH_NET_REPLAY_STRUCT replay;
+} SIM_NODE_T;
+
+typedef struct
+{
+    uint16 node;
+    uint32 pdu;
+    uint32 start;
+    bool isDone;
+} SIM_AIR_T;
+
+static SIM_PDU_T pdus[SIM_MAX_PDUS];
+static uint32 pduCount;
+static SIM_NODE_T simNodes[SIM_MAX_NODES];
+static uint16 nodes;
+static uint8 lossPercent;
+static SIM_AIR_T air[SIM_MAX_AIR];
+static uint32 airCount;
+static uint32 transmissions;
+static uint32 replays;
+static bool isStrict;
+
+/* The two ends */
+static CYMESH_TRANSPORT_SAR_STRUCT source;
+static CYMESH_TRANSPORT_SAR_STRUCT destination;
+static uint8 message[CYMESH_TRANSPORT_SAR_MAX_LEN];
+static uint8 messageLength;
+static bool isDelivered;
+
+/* Baseline: chunk being sent, its status, and the chunks received */
+static uint8 baseChunk;
+static bool isBaseAcked;
+static uint16 baseReceived;
+
+
+static uint32 Random(uint32 limit)
+{
+    return (uint32)rand() % limit;
+}
+
+
+/* Queues a new PDU at node, false if the queue is full */
+static bool Send(uint16 node, uint16 to, const uint8 * data, uint8 length, uint32 now)
+{
+    SIM_NODE_T * n = &simNodes[node];
+    SIM_PDU_T * pdu = &pdus[pduCount % SIM_MAX_PDUS];
+    uint8 i;
+
+    if(n->count == SIM_QUEUE_SIZE)
+    {
+        return false;
+    }
+    pdu->from = node;
+    pdu->seq = n->seq++;
+    pdu->to = to;
+    memcpy(pdu->data, data, length);
+    pdu->length = length;
+    n->seen[pduCount % SIM_MAX_PDUS] = pduCount + 1u;
+
+    i = (n->head + n->count) % SIM_QUEUE_SIZE;
+    n->pdu[i] = pduCount++;
+    n->release[i] = now + (SIM_BEARER_DELAY_US * Random(32u));
+    n->count++;
+
+    return true;
+}
+
+
+static bool IsFull(uint16 node)
+{
+    return simNodes[node].count == SIM_QUEUE_SIZE;
+}
+
+
+/* A PDU received by the end it is for */
+static void Deliver(uint16 node, const SIM_PDU_T * pdu, uint32 now)
+{
+    CYMESH_TRANSPORT_SAR_RX_T * rx;
+    bool isComplete;
+    uint8 status[2] = { 0x82u, 0u };
+
+    if(node == 0u)
+    {
+        if(pdu->data[0] == CYMESH_TRANSPORT_SAR_MARKER)
+        {
+            CyMesh_TransportSarTxAck(&source, pdu->data, pdu->length, now / 1000u);
+        }
+        else if(pdu->data[1] == baseChunk)
+        {
+            isBaseAcked = true;
+        }
+        return;
+    }
+
+    if(pdu->data[0] == CYMESH_TRANSPORT_SAR_MARKER)
+    {
+        rx = CyMesh_TransportSarRxSegment(&destination, 1u, pdu->data, pdu->length, now / 1000u, &isComplete);
+        if(rx != NULL)
+        {
+            rx->isAckWanted = true;
+            if((isComplete == true) && (rx->length == messageLength) &&
+               (memcmp(rx->data, message, messageLength) == 0))
+            {
+                isDelivered = true;
+            }
+        }
+        return;
+    }
+
+    /* Baseline: opcode, chunk number, data; the status answers every copy */
+    baseReceived |= (uint16)(1u << pdu->data[1]);
+    status[1] = pdu->data[1];
+    (void)Send(node, 0u, status, sizeof(status), now);
+}
+
+
+/* Ends the advertisements that are over: each neighbour that was not
+ * transmitting and heard no other neighbour at the same time receives it */
+static void Receive(uint32 now)
+{
+    uint32 i;
+    uint32 j;
+    int side;
+
+    for(i = 0u; i < airCount; i++)
+    {
+        SIM_AIR_T * a = &air[i];
+
+        if((a->isDone == true) || ((a->start + SIM_AIR_US) > now))
+        {
+            continue;
+        }
+        a->isDone = true;
+
+        for(side = -1; side <= 1; side += 2)
+        {
+            int receiver = (int)a->node + side;
+            bool isLost = (Random(100u) < lossPercent);
+            const SIM_PDU_T * pdu = &pdus[a->pdu % SIM_MAX_PDUS];
+
+            if((receiver < 0) || (receiver >= (int)nodes))
+            {
+                continue;
+            }
+            for(j = 0u; (j < airCount) && (isLost == false); j++)
+            {
+                if((j != i) && ((air[j].node == (uint16)receiver) || (air[j].node == (uint16)(receiver + side))) &&
+                   (air[j].start < (a->start + SIM_AIR_US)) && ((air[j].start + SIM_AIR_US) > a->start))
+                {
+                    isLost = true;
+                }
+            }
+            if((isLost == true) || (simNodes[receiver].seen[a->pdu % SIM_MAX_PDUS] == (a->pdu + 1u)))
+            {
+                continue;
+            }
+            simNodes[receiver].seen[a->pdu % SIM_MAX_PDUS] = a->pdu + 1u;
+
+            if(isStrict == true)
+            {
+                uint32 * highSeq = &simNodes[receiver].highSeq[(pdu->from == 0u) ? 0u : 1u];
+
+                if(pdu->seq < *highSeq)
+                {
+                    replays++;
+                    continue;
+                }
+                *highSeq = pdu->seq + 1u;
+            }
+            else if((receiver == pdu->to) &&
+                    (CyMesh_NetworkReplayAccept(&simNodes[receiver].replay, pdu->from + 1u, pdu->seq) == false))
+            {
+                replays++;
+                continue;
+            }
+            else
+            {
+                /* Relayed on the message cache alone */
+            }
+
+            if(receiver == pdu->to)
+            {
+                Deliver((uint16)receiver, pdu, now);
+            }
+            else if((receiver != 0) && (receiver != (int)(nodes - 1u)))
+            {
+                SIM_NODE_T * n = &simNodes[receiver];
+
+                if(n->count < SIM_QUEUE_SIZE)
+                {
+                    uint8 k = (n->head + n->count) % SIM_QUEUE_SIZE;
+
+                    n->pdu[k] = a->pdu;
+                    n->release[k] = now + SIM_PROCESS_US + Random(SIM_FLOOD_DELAY_US + 1u) +
+                                     (SIM_BEARER_DELAY_US * Random(32u));
+                    n->count++;
+                }
+            }
+            else
+            {
+                /* An end hears a PDU that is not for it */
+            }
+        }
+    }
+
+    /* Keep the advertisements that can still overlap one on air */
+    for(i = 0u, j = 0u; i < airCount; i++)
+    {
+        if((air[i].isDone == false) || ((air[i].start + (2u * SIM_AIR_US)) > now))
+        {
+            air[j++] = air[i];
+        }
+    }
+    airCount = j;
+}
+
+
+/* Starts the advertisements that are due */
+static void Advertise(uint32 now)
+{
+    uint16 i;
+
+    for(i = 0u; i < nodes; i++)
+    {
+        SIM_NODE_T * n = &simNodes[i];
+
+        uint8 next = n->head;
+        uint8 k;
+
+        /* Each PDU goes once its delay ran out, not in queue order */
+        for(k = 1u; k < n->count; k++)
+        {
+            uint8 slot = (n->head + k) % SIM_QUEUE_SIZE;
+
+            if(n->release[slot] < n->release[next])
+            {
+                next = slot;
+            }
+        }
+        if((n->count == 0u) || (n->release[next] > now) || (n->nextAdv > now) || (airCount == SIM_MAX_AIR))
+        {
+            continue;
+        }
+        air[airCount].node = i;
+        air[airCount].pdu = n->pdu[next];
+        air[airCount].start = now;
+        air[airCount].isDone = false;
+        airCount++;
+        transmissions++;
+
+        n->pdu[next] = n->pdu[n->head];
+        n->release[next] = n->release[n->head];
+        n->head = (n->head + 1u) % SIM_QUEUE_SIZE;
+        n->count--;
+        n->nextAdv = now + SIM_ADV_SLOT_US;
+    }
+}
+
+
+static void Step(uint32 now)
+{
+    Advertise(now);
+    Receive(now);
+}
+
+
+static void Reset(const SIM_SCENARIO_T * scenario)
+{
+    uint16 i;
+
+    nodes = scenario->hops + 1u;
+    lossPercent = scenario->lossPercent;
+    memset(simNodes, 0, sizeof(simNodes));
+    pduCount = 0u;
+    airCount = 0u;
+    transmissions = 0u;
+    replays = 0u;
+    for(i = 0u; i < SIM_MAX_NODES; i++)
+    {
+        CyMesh_NetworkReplayInit(&simNodes[i].replay);
+    }
+    CyMesh_TransportSarInit(&source);
+    CyMesh_TransportSarInit(&destination);
+    srand(SIM_SEED);
+}
+
+
+/* Runs a segmented message to the end; returns its duration in us */
+static uint32 RunSegmented(uint32 * now, uint16 interval, uint16 ackTimeout)
+{
+    uint32 start = *now;
+    uint8 pdu[CYMESH_TRANSPORT_SAR_PDU_LEN];
+    CYMESH_TRANSPORT_SAR_RX_T * rx;
+    uint8 length;
+
+    (void)CyMesh_TransportSarTxStart(&source, message, messageLength, interval, ackTimeout, *now / 1000u);
+
+    while((source.tx.state == CYMESH_TRANSPORT_SAR_TX_SENDING) || (source.tx.state == CYMESH_TRANSPORT_SAR_TX_WAITING))
+    {
+        if((*now % SIM_TICK_US) == 0u)
+        {
+            if(IsFull(0u) == false)
+            {
+                length = CyMesh_TransportSarTxNext(&source, *now / 1000u, pdu);
+                if(length != 0u)
+                {
+                    (void)Send(0u, nodes - 1u, pdu, length, *now);
+                }
+            }
+            if(IsFull(nodes - 1u) == false)
+            {
+                length = CyMesh_TransportSarRxAck(&destination, *now / 1000u, pdu, &rx);
+                if(length != 0u)
+                {
+                    (void)Send(nodes - 1u, 0u, pdu, length, *now);
+                }
+            }
+        }
+        Step(*now);
+        *now += SIM_STEP_US;
+    }
+
+    return *now - start;
+}
+
+
+/* Runs a message in application messages to the end; returns its duration
+ * in us */
+static uint32 RunBaseline(uint32 * now)
+{
+    uint32 start = *now;
+    uint8 chunks = (messageLength + SIM_BASE_DATA_LEN - 1u) / SIM_BASE_DATA_LEN;
+    uint8 pdu[CYMESH_TRANSPORT_SAR_PDU_LEN];
+    uint8 attempt;
+
+    baseReceived = 0u;
+    for(baseChunk = 0u; baseChunk < chunks; baseChunk++)
+    {
+        isBaseAcked = false;
+        for(attempt = 0u; (attempt <= SIM_BASE_RETRIES) && (isBaseAcked == false); attempt++)
+        {
+            uint32 sent = *now;
+
+            pdu[0] = 0x82u;
+            pdu[1] = baseChunk;
+            memcpy(&pdu[2], &message[baseChunk * SIM_BASE_DATA_LEN], SIM_BASE_DATA_LEN);
+            (void)Send(0u, nodes - 1u, pdu, SIM_BASE_DATA_LEN + 2u, *now);
+
+            while((isBaseAcked == false) && ((*now - sent) < SIM_BASE_RETRY_US))
+            {
+                Step(*now);
+                *now += SIM_STEP_US;
+            }
+        }
+        if(isBaseAcked == false)
+        {
+            break;
+        }
+    }
+
+    isDelivered = (baseReceived == (uint16)((1u << chunks) - 1u));
+
+    return *now - start;
+}
+
+
+static void Simulate(const SIM_SCENARIO_T * scenario, uint8 size, SIM_SCHEME_T scheme, uint16 interval)
+{
+    uint32 now = 0u;
+    uint32 duration = 0u;
+    uint32 delivered = 0u;
+    uint16 ackTimeout = CYMESH_TRANSPORT_SAR_ACK_TIMEOUT_MS +
+                        ((scenario->hops + SIM_TTL_MARGIN) * CYMESH_TRANSPORT_SAR_ACK_TIMEOUT_TTL_MS);
+    uint32 i;
+    uint32 j;
+
+    Reset(scenario);
+    isStrict = (scheme == SIM_SCHEME_STRICT);
+    for(i = 0u; i < SIM_MESSAGES; i++)
+    {
+        messageLength = size;
+        for(j = 0u; j < size; j++)
+        {
+            message[j] = (uint8)Random(256u);
+        }
+        isDelivered = false;
+        duration += (scheme != SIM_SCHEME_BASELINE) ? RunSegmented(&now, interval, ackTimeout) : RunBaseline(&now);
+        if(isDelivered == true)
+        {
+            delivered++;
+        }
+    }
+
+    printf("%-10s %4u | %5u/%-3u %9.0f %9.1f %9.1f %10.1f %8.2f\n",
+           simSchemeNames[scheme], size, delivered, SIM_MESSAGES,
+           (double)duration / SIM_MESSAGES / 1000.0,
+           1e6 * delivered * size / (double)now,
+           (delivered == 0u) ? 0.0 : ((double)transmissions / delivered),
+           (delivered == 0u) ? 0.0 : ((double)transmissions * SIM_AIR_US / 1000.0 / delivered),
+           (double)replays / SIM_MESSAGES);
+}
+
+
+int main(int argc, char * argv[])
+{
+    uint16 interval = CYMESH_TRANSPORT_SAR_SEGMENT_INTERVAL_MS;
+    uint32 i;
+    uint32 j;
+
+    if(argc > 1)
+    {
+        interval = (uint16)atoi(argv[1]);
+    }
+
+    printf("%u messages per size, %u ms between segments, %u byte segments, ACK after %u ms + %u ms per hop\n",
+           SIM_MESSAGES, interval, CYMESH_TRANSPORT_SAR_SEGMENT_LEN, CYMESH_TRANSPORT_SAR_ACK_TIMEOUT_MS,
+           CYMESH_TRANSPORT_SAR_ACK_TIMEOUT_TTL_MS);
+    for(i = 0u; i < SIM_SCENARIO_COUNT; i++)
+    {
+        printf("\n%s\n%-15s | %9s %9s %9s %9s %10s %8s\n", simScenarios[i].name, "scheme    bytes", "delivered",
+               "ms/msg", "bytes/s", "tx/msg", "air ms/msg", "rpl/msg");
+        for(j = 0u; j < SIM_SIZE_COUNT; j++)
+        {
+            SIM_SCHEME_T scheme;
+
+            for(scheme = SIM_SCHEME_BASELINE; scheme < SIM_SCHEME_COUNT; scheme++)
+            {
+                Simulate(&simScenarios[i], simSizes[j], scheme, interval);
+            }
+            fflush(stdout);
+        }
+    }
+
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,335 @@
+/*******************************************************************************
+* TTL learning simulation of Firmware_Mesh/SM Files/CyMesh_NetworkHops.c.
+*
+* Nodes are placed at random in an area and every node relays, as
+* CyMesh_ProcessNetworkPacket() does: a message that is not in the node's
+* cache is added, passed to CyMesh_NetworkHopsLearn() and sent again after a
+* random bearer delay with its TTL decremented. Nodes share the default TTLs
+* of Firmware_Mesh/Mesh.cydsn/Mesh_config.c: 10 for the device and 20 for the
+* models, which send the traffic. Radio collisions are not simulated.
+*
+* Each node talks to a few peers picked at random. The traffic is request and
+* response, a few per second across the network. The request goes out with
+* the TTL CyMesh_NetworkHopsTtl() gives for the model default; the
+* destination answers if it received it. The first row sends every message
+* with the default TTL, as without the table.
+* Transmissions per delivered message count the source and every relay.
+*
+* The margin is a build option, so build once per margin. From the
+* repository root:
+*
+*   for margin in 0 1 2 3; do
+*       gcc -O2 -DCYMESH_NET_HOPS_TTL_MARGIN=$margin -I Tools/network_bench -I "Firmware_Mesh/SM Files" \
+*           -o ttl_sim Tools/network_bench/ttl_sim.c "Firmware_Mesh/SM Files/CyMesh_NetworkHops.c" \
+*           "Firmware_Mesh/SM Files/CyMesh_NetworkCache.c" -lm &&
+*       ./ttl_sim $margin
+*   done
+*
+* Without an argument, the table header and the default TTL row come first.
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <project.h>
+#include "CyMesh_NetworkCache.h"
+#include "CyMesh_NetworkHops.h"
+
+#define SIM_MAX_NODES           (150u)
+#define SIM_RANGE               (18.0)      /* Radio range */
+#define SIM_DEVICE_TTL          (10u)
+#define SIM_MODEL_TTL           (20u)
+#define SIM_RELAY_DELAY_MIN_MS  (1u)        /* Bearer delay before a relay */
+#define SIM_RELAY_DELAY_MAX_MS  (10u)
+#define SIM_PEERS               (4u)        /* Nodes each node talks to */
+#define SIM_EXCHANGES           (3000u)
+#define SIM_EXCHANGE_PERIOD_MS  (200u)      /* Time between two requests */
+#define SIM_SEED                (1u)
+#define SIM_MAX_EVENTS          (SIM_MAX_NODES * SIM_MAX_NODES)
+
+typedef struct
+{
+    const char * name;
+    uint16 nodes;
+    double width;
+    double height;
+} SIM_TOPOLOGY_T;
+
+static const SIM_TOPOLOGY_T simTopologies[] =
+{
+    { "square",  100u, 100.0, 100.0 },
+    { "strip",   150u, 300.0,  40.0 },
+};
+
+#define SIM_TOPOLOGY_COUNT      (sizeof(simTopologies) / sizeof(simTopologies[0]))
+
+typedef struct
+{
+    uint32 time;
+    uint16 node;
+    uint8 ttl;
+} SIM_EVENT_T;
+
+static uint16 nodes;
+static double nodeX[SIM_MAX_NODES];
+static double nodeY[SIM_MAX_NODES];
+static uint16 neighbours[SIM_MAX_NODES][SIM_MAX_NODES];
+static uint16 neighbourCount[SIM_MAX_NODES];
+static uint16 peers[SIM_MAX_NODES][SIM_PEERS];
+static CYMESH_NET_MSG_CACHE_STRUCT caches[SIM_MAX_NODES];
+static CYMESH_NET_HOPS_STRUCT hopTables[SIM_MAX_NODES];
+
+/* Transmissions waiting for their time, a binary min-heap */
+static SIM_EVENT_T events[SIM_MAX_EVENTS];
+static uint32 eventCount;
+
+
+static uint32 Random(uint32 limit)
+{
+    return (uint32)rand() % limit;
+}
+
+
+static void Push(const SIM_EVENT_T * event)
+{
+    uint32 i = eventCount++;
+
+    while((i > 0u) && (events[(i - 1u) / 2u].time > event->time))
+    {
+        events[i] = events[(i - 1u) / 2u];
+        i = (i - 1u) / 2u;
+    }
+    events[i] = *event;
+}
+
+
+static SIM_EVENT_T Pop(void)
+{
+    SIM_EVENT_T top = events[0];
+    SIM_EVENT_T last = events[--eventCount];
+    uint32 i = 0u;
+
+    for(;;)
+    {
+        uint32 child = (2u * i) + 1u;
+
+        if(child >= eventCount)
+        {
+            break;
+        }
+        if(((child + 1u) < eventCount) && (events[child + 1u].time < events[child].time))
+        {
+            child++;
+        }
+        if(events[child].time >= last.time)
+        {
+            break;
+        }
+        events[i] = events[child];
+        i = child;
+    }
+    events[i] = last;
+    return top;
+}
+
+
+static void PlaceNodes(const SIM_TOPOLOGY_T * topology)
+{
+    uint16 i;
+    uint16 j;
+
+    nodes = topology->nodes;
+    srand(SIM_SEED);
+    for(i = 0; i < nodes; i++)
+    {
+        nodeX[i] = topology->width * Random(10000u) / 10000.0;
+        nodeY[i] = topology->height * Random(10000u) / 10000.0;
+    }
+
+    for(i = 0; i < nodes; i++)
+    {
+        for(j = 0; j < SIM_PEERS; j++)
+        {
+            peers[i][j] = (uint16)((i + 1u + Random(nodes - 1u)) % nodes);
+        }
+    }
+
+    for(i = 0; i < nodes; i++)
+    {
+        neighbourCount[i] = 0u;
+        for(j = 0; j < nodes; j++)
+        {
+            if((i != j) && (hypot(nodeX[i] - nodeX[j], nodeY[i] - nodeY[j]) <= SIM_RANGE))
+            {
+                neighbours[i][neighbourCount[i]++] = j;
+            }
+        }
+    }
+}
+
+
+/* As CyMesh_NetworkInitialTtl() of CyMesh_Network.c, the highest default */
+static uint8 InitialTtl(uint8 ttl)
+{
+    return (ttl <= SIM_MODEL_TTL) ? SIM_MODEL_TTL : 0u;
+}
+
+
+/* Floods a message; returns true if dst received it and adds the
+ * transmissions */
+static bool Flood(uint16 source, uint16 dst, uint32 seq, uint8 ttl, uint32 now, uint32 * transmissions)
+{
+    SIM_EVENT_T event = { 0u, source, ttl };
+    uint16 src = source + 1u;
+    bool isDelivered = false;
+    uint16 i;
+
+    CyMesh_NetworkCacheAdd(&caches[source], src, seq);
+    eventCount = 0u;
+    Push(&event);
+
+    while(eventCount > 0u)
+    {
+        event = Pop();
+        (*transmissions)++;
+
+        for(i = 0; i < neighbourCount[event.node]; i++)
+        {
+            uint16 node = neighbours[event.node][i];
+            SIM_EVENT_T relay = event;
+
+            if(CyMesh_NetworkCacheFind(&caches[node], src, seq) == true)
+            {
+                continue;
+            }
+            CyMesh_NetworkCacheAdd(&caches[node], src, seq);
+            CyMesh_NetworkHopsLearn(&hopTables[node], src, event.ttl, InitialTtl(event.ttl),
+                                    now + (event.time / 1000u));
+
+            if(node == dst)
+            {
+                isDelivered = true;
+                continue;
+            }
+            if(event.ttl < 2u)
+            {
+                continue;
+            }
+            relay.node = node;
+            relay.ttl = event.ttl - 1u;
+            relay.time = event.time + (1000u * (SIM_RELAY_DELAY_MIN_MS +
+                                                Random(SIM_RELAY_DELAY_MAX_MS - SIM_RELAY_DELAY_MIN_MS + 1u)));
+            Push(&relay);
+        }
+    }
+
+    return isDelivered;
+}
+
+
+/* Transmissions per delivered message, and the delivered ratio in percent */
+static void Simulate(const SIM_TOPOLOGY_T * topology, bool isLearning, double * transmissions, double * delivered)
+{
+    uint32 seq[SIM_MAX_NODES] = { 0 };
+    uint32 sent = 0u;
+    uint32 received = 0u;
+    uint32 txTotal = 0u;
+    uint32 exchange;
+    uint16 i;
+
+    PlaceNodes(topology);
+    for(i = 0; i < nodes; i++)
+    {
+        CyMesh_NetworkCacheInit(&caches[i]);
+        CyMesh_NetworkHopsInit(&hopTables[i]);
+    }
+
+    srand(SIM_SEED + nodes);
+    for(exchange = 0u; exchange < SIM_EXCHANGES; exchange++)
+    {
+        uint32 now = exchange * SIM_EXCHANGE_PERIOD_MS;
+        uint16 client = (uint16)Random(nodes);
+        uint16 server = peers[client][Random(SIM_PEERS)];
+        uint8 ttl = SIM_MODEL_TTL;
+
+        if(isLearning == true)
+        {
+            ttl = CyMesh_NetworkHopsTtl(&hopTables[client], server + 1u, SIM_MODEL_TTL, now);
+        }
+        sent++;
+        if(Flood(client, server, ++seq[client], ttl, now, &txTotal) == false)
+        {
+            continue;
+        }
+        received++;
+
+        ttl = SIM_MODEL_TTL;
+        if(isLearning == true)
+        {
+            ttl = CyMesh_NetworkHopsTtl(&hopTables[server], client + 1u, SIM_MODEL_TTL, now);
+        }
+        sent++;
+        if(Flood(server, client, ++seq[server], ttl, now, &txTotal) == true)
+        {
+            received++;
+        }
+    }
+
+    *transmissions = (received == 0u) ? 0.0 : ((double)txTotal / received);
+    *delivered = 100.0 * received / sent;
+}
+
+
+static void PrintRow(const char * label, bool isLearning)
+{
+    uint32 i;
+
+    printf("%-12s", label);
+    for(i = 0; i < SIM_TOPOLOGY_COUNT; i++)
+    {
+        double transmissions;
+        double delivered;
+
+        Simulate(&simTopologies[i], isLearning, &transmissions, &delivered);
+        printf(" | %14.1f %9.2f%%", transmissions, delivered);
+        fflush(stdout);
+    }
+    printf("\n");
+}
+
+
+int main(int argc, char * argv[])
+{
+    char label[16];
+    uint32 i;
+
+    if(argc < 2)
+    {
+        printf("%u request/response exchanges, model TTL %u, device TTL %u, %u entry hop table, %u ms lifetime\n",
+               SIM_EXCHANGES, SIM_MODEL_TTL, SIM_DEVICE_TTL, CYMESH_NET_HOPS_SIZE, CYMESH_NET_HOPS_LIFETIME_MS);
+        printf("%-12s", "");
+        for(i = 0; i < SIM_TOPOLOGY_COUNT; i++)
+        {
+            printf(" | %-6s %3u nodes %3.0fx%-3.0f", simTopologies[i].name, simTopologies[i].nodes,
+                   simTopologies[i].width, simTopologies[i].height);
+        }
+        printf("\n%-12s", "TTL margin");
+        for(i = 0; i < SIM_TOPOLOGY_COUNT; i++)
+        {
+            printf(" | %14s %10s", "tx/delivered", "delivered");
+        }
+        printf("\n");
+        PrintRow("default", false);
+    }
+
+    snprintf(label, sizeof(label), "%s", (argc < 2) ? "" : argv[1]);
+    if(argc < 2)
+    {
+        snprintf(label, sizeof(label), "%u", CYMESH_NET_HOPS_TTL_MARGIN);
+    }
+    PrintRow(label, true);
+
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+"""Estimate the average current of mesh nodes from their power residency.
+
+PowerIdle() counts the ILO ticks spent with the CPU active, in Sleep and in
+Deep-Sleep, and the ticks in which BLESS was in Deep-Sleep while the CPU
+slept. Collect two or more counter samples with stats_poll.py and run:
+
+    power_estimate.py stats.csv
+
+The estimate uses the residency between the first and the last sample of
+every node. The default currents are typical datasheet values of the
+CY8C4xx8-BL family at 3 V with a 24 MHz HFCLK; measure your board and pass
+its values with the options. Radio idle time while the CPU is active is not
+counted, so the radio part is an upper bound.
+"""
+
+import argparse
+import csv
+import sys
+
+RESIDENCY = ['power_active', 'power_sleep', 'power_deepsleep', 'power_radio_idle']
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('csv', nargs='?', help='output of stats_poll.py (default stdin)')
+    parser.add_argument('--active-ua', type=float, default=3000.0, help='CPU active')
+    parser.add_argument('--sleep-ua', type=float, default=1300.0, help='CPU Sleep')
+    parser.add_argument('--deepsleep-ua', type=float, default=1.3, help='Deep-Sleep')
+    parser.add_argument('--radio-ua', type=float, default=18700.0,
+                        help='BLESS active, assumed to be scanning')
+    args = parser.parse_args()
+
+    samples = {}
+    with (open(args.csv) if args.csv else sys.stdin) as stream:
+        for row in csv.DictReader(stream):
+            if row['counter'] in RESIDENCY:
+                node = samples.setdefault(row['node'], {})
+                node.setdefault(row['counter'], []).append(int(row['value']))
+
+    print('node,active_pct,sleep_pct,deepsleep_pct,radio_idle_pct,cpu_ua,radio_ua,total_ua')
+    for node, counters in sorted(samples.items()):
+        if any(len(counters.get(name, [])) < 2 for name in RESIDENCY):
+            continue
+        delta = dict((name, (counters[name][-1] - counters[name][0]) & 0xFFFFFFFF)
+                     for name in RESIDENCY)
+        total = delta['power_active'] + delta['power_sleep'] + delta['power_deepsleep']
+        if total == 0:
+            continue
+        active = delta['power_active'] / float(total)
+        sleep = delta['power_sleep'] / float(total)
+        deep = delta['power_deepsleep'] / float(total)
+        radio_idle = delta['power_radio_idle'] / float(total)
+        cpu_ua = active * args.active_ua + sleep * args.sleep_ua + deep * args.deepsleep_ua
+        radio_ua = (1.0 - radio_idle) * args.radio_ua
+        print('%s,%.1f,%.1f,%.1f,%.1f,%.0f,%.0f,%.0f' %
+              (node, 100 * active, 100 * sleep, 100 * deep, 100 * radio_idle,
+               cpu_ua, radio_ua, cpu_ua + radio_ua))
+
+
+if __name__ == '__main__':
+    main()
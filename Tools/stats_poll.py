@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""Poll the runtime counters of mesh nodes through a gateway node.
+
+The gateway is any mesh node built with CYMESH_DEBUG_ENABLED and connected to
+the host UART. Every period the tool sends UART_CMD_STATS for each node; the
+gateway dumps its own counters and polls the others with OPCODE_STATS_GET.
+Results are written as CSV with the rate of every counter since the last
+sample:
+
+    stty -F /dev/ttyACM0 115200 raw
+    stats_poll.py Mesh.elf /dev/ttyACM0 --nodes ffff 0012 0034 --period 30 > stats.csv
+
+"ffff" stands for the gateway itself. Nodes only answer a request sent to
+them, as each answer is one mesh message per counter; the totals of the whole
+mesh come from the telemetry sink instead (UART command 'T', telemetry.c).
+"""
+
+import argparse
+import io
+import os
+import sys
+import threading
+import time
+
+import log_decoder
+
+UART_CMD_STATS = b'S'
+
+# Keep in sync with STATS_COUNTER_T in Firmware_Mesh/Mesh.cydsn/stats.h
+COUNTER_NAMES = [
+    'adv_not_non_conn',
+    'beacon_bad_flags',
+    'beacon_bad_manufacturer',
+    'beacon_bad_length',
+    'beacon_from_mesh_device',
+    'beacon_wrong_beacon_id',
+    'keep_alive_added',
+    'keep_alive_refreshed',
+    'keep_alive_list_full',
+    'data_unknown_source',
+    'data_in_range',
+    'data_to_mesh',
+    'mesh_stack_on',
+    'mesh_rx_to_peripheral',
+    'mesh_rx_dropped',
+    'mesh_other_event',
+    'device_expired',
+    'bearer_tx_full',
+    'power_active',
+    'power_sleep',
+    'power_deepsleep',
+    'power_radio_idle',
+    'friend_poll',
+    'friend_cached',
+    'friend_delivered',
+    'friend_dropped',
+]
+
+
+class StatsSink(io.TextIOBase):
+    """Text sink for log_decoder.decode() that keeps the STATS lines."""
+
+    def __init__(self, on_stats):
+        self.buffer = ''
+        self.on_stats = on_stats
+
+    def write(self, text):
+        self.buffer += text
+        while '\n' in self.buffer:
+            line, self.buffer = self.buffer.split('\n', 1)
+            line = line.strip()
+            if line.startswith('STATS,'):
+                fields = line.split(',')
+                node = fields[1]
+                first = int(fields[2])
+                values = [int(v) for v in fields[3:]]
+                self.on_stats(node, first, values)
+        return len(text)
+
+
+def counter_name(index):
+    if index < len(COUNTER_NAMES):
+        return COUNTER_NAMES[index]
+    return 'counter_%d' % index
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('elf', help='ELF file of the gateway firmware')
+    parser.add_argument('device', help='serial device of the gateway')
+    parser.add_argument('--nodes', nargs='+', default=['ffff'],
+                        help='node IDs (hex) to poll, ffff for the gateway')
+    parser.add_argument('--period', type=float, default=30.0,
+                        help='seconds between polls')
+    parser.add_argument('--count', type=int, default=0,
+                        help='number of polls (0: forever)')
+    args = parser.parse_args()
+
+    elf = log_decoder.Elf32(args.elf)
+    last = {}
+    lock = threading.Lock()
+
+    print('time,node,counter,value,rate_per_min')
+
+    def on_stats(node, first, values):
+        now = time.time()
+        with lock:
+            for offset, value in enumerate(values):
+                key = (node, first + offset)
+                rate = ''
+                if key in last:
+                    then, previous = last[key]
+                    if now > then:
+                        rate = '%.2f' % ((value - previous) * 60.0 / (now - then))
+                last[key] = (now, value)
+                print('%.3f,%s,%s,%d,%s' % (now, node, counter_name(first + offset),
+                                            value, rate))
+            sys.stdout.flush()
+
+    fd = os.open(args.device, os.O_RDWR | os.O_NOCTTY)
+    reader = threading.Thread(target=log_decoder.decode,
+                              args=(elf, os.fdopen(os.dup(fd), 'rb', buffering=0),
+                                    StatsSink(on_stats)))
+    reader.daemon = True
+    reader.start()
+
+    polls = 0
+    while args.count == 0 or polls < args.count:
+        for node in args.nodes:
+            node_id = int(node, 16)
+            os.write(fd, log_decoder.encode_command(UART_CMD_STATS + bytes([node_id & 0xFF, node_id >> 8])))
+        polls += 1
+        time.sleep(args.period)
+
+
+if __name__ == '__main__':
+    main()
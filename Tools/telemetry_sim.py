@@ -0,0 +1,298 @@
+#!/usr/bin/env python3
+"""Compare the sink load of fleet telemetry with and without aggregation.
+
+Nodes are placed at random with a fixed mean number of radio neighbours and
+the node nearest to the centre is the sink. Both modes report the same
+fields every TELEMETRY_PERIOD_S:
+
+  flood      every node sends its own report with the default TTL and the
+             mesh relays it (one relay per node, as with the message cache)
+  aggregate  the protocol of Firmware_Mesh/Mesh.cydsn/telemetry.c: TTL 1
+             route announcements build a tree, nodes send their deltas
+             merged with their subtree to their parent
+
+The simulation runs in steps of one second and the sink counts what it
+receives after the routes had time to settle:
+
+    telemetry_sim.py --nodes 100 1000 --minutes 10
+
+"app" is the number of reports delivered to the sink application, "air" the
+number of transmissions the sink radio hears (including relayed copies) and
+"total" the transmissions of the whole mesh. For aggregation, "delivered"
+compares the sum reported to the sink with the sum of all counter increments,
+for flooding it is the share of nodes within DEFAULT_TTL hops of the sink.
+--loss drops packets on every link independently and only applies to the
+aggregate mode, whose reports are single hop and unacknowledged.
+"""
+
+import argparse
+import math
+import random
+from collections import deque
+
+# Keep in sync with telemetry.h / telemetry.c
+TELEMETRY_PERIOD_S = 30
+TELEMETRY_ROUTE_PERIOD_S = 10
+TELEMETRY_ROUTE_TIMEOUT_S = 3 * TELEMETRY_ROUTE_PERIOD_S
+TELEMETRY_MAX_DEPTH = 31
+TELEMETRY_VALUE_MAX = 0xFFFFFF
+TELEMETRY_NODES_MAX = 0xFF
+
+# (counter, merge) per TELEMETRY_FIELD_ID_T
+FIELDS = [
+    ('data_to_mesh', 'sum'),
+    ('mesh_rx_to_peripheral', 'sum'),
+    ('mesh_rx_dropped', 'sum'),
+    ('bearer_tx_full', 'sum'),
+    ('bearer_tx_full', 'max'),
+]
+
+# Counter increments per node and second
+COUNTER_RATES = {
+    'data_to_mesh': 0.2,
+    'mesh_rx_to_peripheral': 0.2,
+    'mesh_rx_dropped': 0.05,
+    'bearer_tx_full': 0.01,
+}
+
+DEFAULT_TTL = 20        # modelDefaultTtl set by DefineNodeinfo()
+MEAN_DEGREE = 10.0
+WARMUP_S = 4 * TELEMETRY_ROUTE_TIMEOUT_S
+
+
+def build_topology(count, rng):
+    """Random geometric graph with MEAN_DEGREE neighbours on average, reduced
+    to the component of the node nearest to the centre."""
+    side = math.sqrt(count)
+    radius = math.sqrt(MEAN_DEGREE / math.pi)
+    points = [(rng.uniform(0, side), rng.uniform(0, side)) for _ in range(count)]
+
+    cells = {}
+    for index, (x, y) in enumerate(points):
+        cells.setdefault((int(x / radius), int(y / radius)), []).append(index)
+
+    neighbours = [[] for _ in range(count)]
+    for index, (x, y) in enumerate(points):
+        cx, cy = int(x / radius), int(y / radius)
+        for dx in (-1, 0, 1):
+            for dy in (-1, 0, 1):
+                for other in cells.get((cx + dx, cy + dy), ()):
+                    if other != index and math.hypot(points[other][0] - x,
+                                                     points[other][1] - y) <= radius:
+                        neighbours[index].append(other)
+
+    sink = min(range(count), key=lambda i: math.hypot(points[i][0] - side / 2,
+                                                      points[i][1] - side / 2))
+    component = set(hops_from(neighbours, sink))
+    remap = {old: new for new, old in enumerate(sorted(component))}
+    graph = [[remap[n] for n in neighbours[old] if n in remap] for old in sorted(component)]
+    return graph, remap[sink]
+
+
+def hops_from(graph, start):
+    hops = {start: 0}
+    queue = deque([start])
+    while queue:
+        node = queue.popleft()
+        for other in graph[node]:
+            if other not in hops:
+                hops[other] = hops[node] + 1
+                queue.append(other)
+    return hops
+
+
+def merge(into, field, value, nodes):
+    if FIELDS[field][1] == 'max':
+        into[0] = max(into[0], value)
+    else:
+        into[0] += value
+    into[0] = min(into[0], TELEMETRY_VALUE_MAX)
+    into[1] = min(into[1] + nodes, TELEMETRY_NODES_MAX)
+
+
+class Node(object):
+    """State of one node, mirrors telemetry.c"""
+
+    def __init__(self, node_id, is_sink, boot, counters):
+        self.id = node_id
+        self.is_sink = is_sink
+        self.depth = 0 if is_sink else None
+        self.parent = None
+        self.hold_down = None
+        self.announce = is_sink
+        self.counters = counters
+        self.baseline = [counters[name] for name, _ in FIELDS]
+        self.pending = [[0, 0] for _ in FIELDS]
+        self.outgoing = []
+        self.last_report = boot
+        self.last_route = boot
+        self.last_parent = boot
+
+    def snapshot(self):
+        snapshot = []
+        for field, (name, _) in enumerate(FIELDS):
+            value = list(self.pending[field])
+            merge(value, field, self.counters[name] - self.baseline[field], 1)
+            self.baseline[field] = self.counters[name]
+            self.pending[field] = [0, 0]
+            snapshot.append(value)
+        return snapshot
+
+    def process(self, now):
+        """Returns the message sent in this step and the sink snapshot, if any"""
+        sink_snapshot = None
+
+        if not self.is_sink and self.depth is not None and \
+                now - self.last_parent >= TELEMETRY_ROUTE_TIMEOUT_S:
+            self.depth = None
+            self.hold_down = now
+        if self.hold_down is not None and now - self.hold_down >= TELEMETRY_ROUTE_TIMEOUT_S:
+            self.hold_down = None
+        if self.depth is not None and now - self.last_route >= TELEMETRY_ROUTE_PERIOD_S:
+            self.last_route = now
+            self.announce = True
+        if now - self.last_report >= TELEMETRY_PERIOD_S:
+            self.last_report = now
+            if self.is_sink:
+                sink_snapshot = self.snapshot()
+            elif self.depth is not None and not self.outgoing:
+                self.outgoing = [(field, value) for field, value in enumerate(self.snapshot())]
+
+        if self.announce:
+            self.announce = False
+            return ('route', self.id, self.depth), sink_snapshot
+        if self.outgoing and self.depth is not None:
+            field, value = self.outgoing.pop(0)
+            return ('report', self.parent, field, value[1], value[0]), sink_snapshot
+        return None, sink_snapshot
+
+    def receive(self, message, now):
+        if message[0] == 'route':
+            _, source, depth = message
+            if self.is_sink or self.hold_down is not None or depth >= TELEMETRY_MAX_DEPTH:
+                return
+            if self.depth is not None and source == self.parent:
+                self.depth = depth + 1
+                self.last_parent = now
+            elif self.depth is None or depth + 1 < self.depth:
+                if self.depth is None:
+                    self.announce = True
+                    self.last_route = now
+                self.parent = source
+                self.depth = depth + 1
+                self.last_parent = now
+        else:
+            _, destination, field, nodes, value = message
+            if destination == self.id:
+                merge(self.pending[field], field, value, nodes)
+
+
+def increment_counters(counters, rng, totals):
+    for name, rate in COUNTER_RATES.items():
+        if rng.random() < rate:
+            counters[name] += 1
+            totals[name] += 1
+
+
+def run_flood(graph, sink, minutes, rng):
+    """Every report is relayed by every node within DEFAULT_TTL - 1 hops of
+    its source; the message cache drops the other copies"""
+    count = len(graph)
+    relayers = []
+    for source in range(count):
+        hops = hops_from(graph, source)
+        relaying = set(n for n, h in hops.items() if h <= DEFAULT_TTL - 1)
+        heard = sum(1 for n in graph[sink] if n in relaying)
+        delivered = source == sink or hops.get(sink, DEFAULT_TTL + 1) <= DEFAULT_TTL
+        relayers.append((len(relaying), heard, delivered))
+
+    periods = minutes * 60.0 / TELEMETRY_PERIOD_S
+    fields = len(FIELDS)
+    app = sum(fields for source, (_, _, ok) in enumerate(relayers) if ok and source != sink)
+    air = sum(fields * heard for _, heard, _ in relayers)
+    total = sum(fields * relaying for relaying, _, _ in relayers)
+    minutes_factor = periods / minutes
+    return {
+        'app': app * minutes_factor,
+        'air': air * minutes_factor,
+        'total': total * minutes_factor,
+        'depth': max(hops_from(graph, sink).values()),
+        'delivered': sum(1 for _, _, ok in relayers if ok) / float(count),
+    }
+
+
+def run_aggregate(graph, sink, minutes, rng, loss):
+    count = len(graph)
+    totals = dict((name, 0) for name in COUNTER_RATES)
+    counters = [dict((name, 0) for name in COUNTER_RATES) for _ in range(count)]
+    nodes = [Node(i, i == sink, -rng.randrange(TELEMETRY_PERIOD_S), counters[i]) for i in range(count)]
+    sink_totals = [0] * len(FIELDS)
+    app = air = total = 0
+    end = WARMUP_S + minutes * 60
+    # Let the last increments travel up the tree, one period per hop
+    drain = end + (TELEMETRY_MAX_DEPTH + 2) * TELEMETRY_PERIOD_S
+
+    for now in range(drain):
+        measuring = WARMUP_S <= now < end
+        if measuring:
+            for node in nodes:
+                increment_counters(node.counters, rng, totals)
+
+        order = list(range(count))
+        rng.shuffle(order)
+        for index in order:
+            message, snapshot = nodes[index].process(now)
+            if snapshot is not None:
+                for field, (value, _) in enumerate(snapshot):
+                    sink_totals[field] += value
+            if message is None:
+                continue
+            if measuring:
+                total += 1
+            for other in graph[index]:
+                if loss and rng.random() < loss:
+                    continue
+                if other == sink and measuring:
+                    air += 1
+                    if message[0] == 'report' and message[1] == nodes[sink].id:
+                        app += 1
+                nodes[other].receive(message, now)
+
+    generated = sum(totals[FIELDS[field][0]] for field in range(len(FIELDS)) if FIELDS[field][1] == 'sum')
+    reported = sum(sink_totals[field] for field in range(len(FIELDS)) if FIELDS[field][1] == 'sum')
+    depths = [node.depth for node in nodes if node.depth is not None]
+    return {
+        'app': app / float(minutes),
+        'air': air / float(minutes),
+        'total': total / float(minutes),
+        'depth': max(depths),
+        'delivered': reported / float(generated) if generated else 1.0,
+        'routed': len(depths) / float(count),
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--nodes', type=int, nargs='+', default=[100, 1000])
+    parser.add_argument('--minutes', type=int, default=10, help='measurement window')
+    parser.add_argument('--loss', type=float, default=0.0, help='per link packet loss')
+    parser.add_argument('--seed', type=int, default=1)
+    args = parser.parse_args()
+
+    print('%6s %10s %10s %10s %12s %6s %10s' %
+          ('nodes', 'mode', 'app/min', 'air/min', 'total/min', 'depth', 'delivered'))
+    for count in args.nodes:
+        rng = random.Random(args.seed)
+        graph, sink = build_topology(count, rng)
+        for mode in ('flood', 'aggregate'):
+            if mode == 'flood':
+                result = run_flood(graph, sink, args.minutes, rng)
+            else:
+                result = run_aggregate(graph, sink, args.minutes, rng, args.loss)
+            print('%6d %10s %10.0f %10.0f %12.0f %6d %9.1f%%' %
+                  (len(graph), mode, result['app'], result['air'], result['total'],
+                   result['depth'], 100.0 * result['delivered']))
+
+
+if __name__ == '__main__':
+    main()
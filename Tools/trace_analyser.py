@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+"""Reassemble end-to-end latency traces from mesh node and peripheral logs.
+
+Build the mesh nodes with CYMESHTEST_TRACE_ENABLED and the peripherals with
+MESH_TRACE_ENABLED, capture one log per device (UART for the nodes, RTT/UART
+for the peripherals; decode node captures with log_decoder.py first) and run:
+
+    trace_analyser.py node_a.log node_b.log periph_1.log periph_2.log
+
+Every device prints "T,<device>,<trace ID>,<stage>,<timestamp>". Node
+timestamps are CyMesh_TimerGetTimestamp() milliseconds, peripheral timestamps
+are RTC1 ticks (32768 Hz, 24 bit). Spans inside one device are always exact.
+Spans between devices (air, mesh) need a common clock: prefix every captured
+line with the host receive time in seconds, e.g. "[1476886532.1234] T,...",
+as done by most serial capture tools.
+"""
+
+import argparse
+import re
+import sys
+from collections import defaultdict
+
+LINE_RE = re.compile(r'^(?:\[?(?P<host>\d+(?:\.\d+)?)\]?\s+)?.*?'
+                     r'T,(?P<dev>[0-9a-fA-F]{4}),(?P<id>[0-9a-fA-F]{2}),'
+                     r'(?P<stage>[A-Z_]+),(?P<ts>\d+)\s*$')
+
+RTC_HZ = 32768.0
+RTC_WRAP = 1 << 24
+MS_WRAP = 1 << 32
+
+# (name, start stage, end stage, stage that cancels the span) measured with
+# the device clock
+LOCAL_SPANS = [
+    ('peripheral round trip', 'P_TX', 'P_RX', None),
+    ('peripheral turnaround', 'P_RX', 'P_TX', None),
+    ('anchor ingress', 'A_RX', 'A_MTX', None),
+    ('anchor short-circuit', 'A_RX', 'A_BTX', 'A_MTX'),
+    ('anchor egress', 'A_MRX', 'A_BTX', None),
+]
+
+# (name, start stage, end stage) measured with the host capture clock
+REMOTE_SPANS = [
+    ('uplink air', 'P_TX', 'A_RX'),
+    ('mesh', 'A_MTX', 'A_MRX'),
+    ('downlink air', 'A_BTX', 'P_RX'),
+]
+
+REMOTE_WINDOW_S = 5.0
+
+
+class Event(object):
+    def __init__(self, host, dev, trace_id, stage, ts, seq):
+        self.host = host
+        self.dev = dev
+        self.trace_id = trace_id
+        self.stage = stage
+        self.ts = ts
+        self.seq = seq
+
+
+def device_delta_ms(stage, start, end):
+    if stage.startswith('P_'):
+        return ((end - start) % RTC_WRAP) * 1000.0 / RTC_HZ
+    return float((end - start) % MS_WRAP)
+
+
+def parse(paths):
+    events = []
+    seq = 0
+    for path in paths:
+        with open(path, 'r', errors='replace') as f:
+            for line in f:
+                m = LINE_RE.match(line.strip())
+                if not m:
+                    continue
+                host = float(m.group('host')) if m.group('host') else None
+                events.append(Event(host, m.group('dev').lower(),
+                                    int(m.group('id'), 16), m.group('stage'),
+                                    int(m.group('ts')), seq))
+                seq += 1
+    return events
+
+
+def local_spans(events):
+    spans = defaultdict(list)
+    by_dev = defaultdict(list)
+    for ev in events:
+        by_dev[ev.dev].append(ev)
+    for stream in by_dev.values():
+        stream.sort(key=lambda e: e.seq)
+        for name, start, end, cancel in LOCAL_SPANS:
+            open_ = {}
+            for ev in stream:
+                if ev.stage == start:
+                    open_[ev.trace_id] = ev
+                elif ev.stage == cancel:
+                    open_.pop(ev.trace_id, None)
+                elif ev.stage == end and ev.trace_id in open_:
+                    first = open_.pop(ev.trace_id)
+                    spans[name].append(device_delta_ms(start, first.ts, ev.ts))
+    return spans
+
+
+def remote_spans(events):
+    spans = defaultdict(list)
+    timed = sorted((e for e in events if e.host is not None), key=lambda e: e.host)
+    for name, start, end in REMOTE_SPANS:
+        open_ = defaultdict(list)
+        for ev in timed:
+            if ev.stage == start:
+                open_[ev.trace_id].append(ev)
+            elif ev.stage == end:
+                pending = [s for s in open_[ev.trace_id]
+                           if s.dev != ev.dev and ev.host - s.host <= REMOTE_WINDOW_S]
+                if pending:
+                    first = pending[-1]
+                    spans[name].append((ev.host - first.host) * 1000.0)
+                    open_[ev.trace_id].remove(first)
+    return spans
+
+
+def percentile(values, pct):
+    index = min(len(values) - 1, int(round(pct / 100.0 * (len(values) - 1))))
+    return values[index]
+
+
+def print_histogram(name, values):
+    values = sorted(values)
+    print('%s: n=%d min=%.1f p50=%.1f p90=%.1f p99=%.1f max=%.1f ms' %
+          (name, len(values), values[0], percentile(values, 50),
+           percentile(values, 90), percentile(values, 99), values[-1]))
+    buckets = defaultdict(int)
+    for v in values:
+        upper = 1
+        while upper < v:
+            upper *= 2
+        buckets[upper] += 1
+    peak = max(buckets.values())
+    for upper in sorted(buckets):
+        bar = '#' * max(1, buckets[upper] * 40 // peak)
+        print('  <= %6d ms %6d %s' % (upper, buckets[upper], bar))
+    print('')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('logs', nargs='+', help='captured device logs')
+    args = parser.parse_args()
+
+    events = parse(args.logs)
+    if not events:
+        sys.exit('No trace records found')
+
+    spans = local_spans(events)
+    spans.update(remote_spans(events))
+    for span in LOCAL_SPANS + REMOTE_SPANS:
+        name = span[0]
+        if spans.get(name):
+            print_histogram(name, spans[name])
+    if not any(e.host is not None for e in events):
+        print('No host timestamps found: air and mesh spans not computed.')
+
+
+if __name__ == '__main__':
+    main()